@@ -624,8 +624,10 @@ static bool BaseMap_Read(
         memcpy(pvBuffer, pStream->Base.Map.pbFile + (size_t)ByteOffset, dwBytesToRead);
     }
 
-    // Move the current file position
-    pStream->Base.Map.FilePos += dwBytesToRead;
+    // Move the current file position. Reads from an explicit offset leave it alone,
+    // so that they can run on several threads at once.
+    if(pByteOffset == NULL)
+        pStream->Base.Map.FilePos += dwBytesToRead;
     return true;
 }
 
@@ -1,12 +1,18 @@
 #include "DiabloUI/art.h"
 
+#include <algorithm>
+#include <array>
 #include <cstddef>
 #include <cstdint>
+#include <cstring>
 #include <memory>
+#include <string>
+#include <vector>
 
 #include "storm/storm.h"
 #include "utils/display.h"
 #include "utils/log.hpp"
+#include "utils/memory_stats.h"
 #include "utils/sdl_compat.h"
 
 namespace devilution {
@@ -96,40 +102,122 @@ Uint32 GetPcxSdlPixelFormat(unsigned bpp)
 	}
 }
 
-} // namespace
+/** Bytes of decoded pixels that PcxCache may keep */
+constexpr std::size_t PcxCacheBudget = 4 * 1024 * 1024;
 
-void LoadArt(const char *pszFile, Art *art, int frames, SDL_Color *pPalette)
+struct CachedPcx {
+	std::string path;
+	SDLSurfaceUniquePtr surface;
+	std::array<SDL_Color, NumPaletteColors> palette;
+};
+
+/**
+ * The last decoded PCX files, most recently used first.
+ *
+ * The menus load the same backgrounds again each time a screen is opened, this saves reading and decoding them.
+ */
+std::vector<CachedPcx> PcxCache;
+
+std::size_t CachedSize(const CachedPcx &entry)
 {
-	if (art == nullptr || art->surface != nullptr)
+	return static_cast<std::size_t>(entry.surface->pitch) * entry.surface->h;
+}
+
+void AddToPcxCache(const char *pszFile, const SDL_Surface &surface, const SDL_Color *palette)
+{
+	CachedPcx entry;
+	entry.path = pszFile;
+	entry.surface = SDLSurfaceUniquePtr { SDL_ConvertSurface(const_cast<SDL_Surface *>(&surface), surface.format, 0) };
+	if (entry.surface == nullptr || CachedSize(entry) > PcxCacheBudget)
 		return;
+	if (palette != nullptr)
+		memcpy(entry.palette.data(), palette, sizeof(entry.palette));
+
+	PcxCache.insert(PcxCache.begin(), std::move(entry));
+	std::size_t size = 0;
+	for (auto it = PcxCache.begin(); it != PcxCache.end(); ++it) {
+		size += CachedSize(*it);
+		if (size > PcxCacheBudget) {
+			PcxCache.erase(it, PcxCache.end());
+			break;
+		}
+	}
+}
 
-	art->frames = frames;
+/**
+ * @brief Copy the decoded file from PcxCache
+ * @return nullptr if the file isn't cached
+ */
+SDLSurfaceUniquePtr LoadCachedPcx(const char *pszFile, SDL_Color *pPalette)
+{
+	for (auto it = PcxCache.begin(); it != PcxCache.end(); ++it) {
+		if (it->path != pszFile)
+			continue;
+		SDLSurfaceUniquePtr surface { SDL_ConvertSurface(it->surface.get(), it->surface->format, 0) };
+		if (surface == nullptr)
+			return nullptr;
+		if (pPalette != nullptr)
+			memcpy(pPalette, it->palette.data(), sizeof(it->palette));
+		std::rotate(PcxCache.begin(), it, it + 1);
+		return surface;
+	}
+	return nullptr;
+}
+
+SDLSurfaceUniquePtr LoadPcx(const char *pszFile, SDL_Color *pPalette)
+{
+	SDLSurfaceUniquePtr artSurface = LoadCachedPcx(pszFile, pPalette);
+	if (artSurface != nullptr)
+		return artSurface;
 
 	HANDLE handle;
 	int width;
 	int height;
 	std::uint8_t bpp;
 	if (!SFileOpenFile(pszFile, &handle)) {
-		return;
+		return nullptr;
 	}
 
 	if (!LoadPcxMeta(handle, width, height, bpp)) {
 		Log("LoadArt(\"{}\"): LoadPcxMeta failed with code {}", pszFile, SErrGetLastError());
 		SFileCloseFileThreadSafe(handle);
-		return;
+		return nullptr;
 	}
 
-	SDLSurfaceUniquePtr artSurface { SDL_CreateRGBSurfaceWithFormat(SDL_SWSURFACE, width, height, bpp, GetPcxSdlPixelFormat(bpp)) };
+	// Always read the palette of 8-bit files, so the cached copy can serve callers that need it
+	SDL_Color palette[NumPaletteColors];
+	artSurface = SDLSurfaceUniquePtr { SDL_CreateRGBSurfaceWithFormat(SDL_SWSURFACE, width, height, bpp, GetPcxSdlPixelFormat(bpp)) };
 	if (!LoadPcxPixelsAndPalette(handle, width, height, bpp, static_cast<BYTE *>(artSurface->pixels),
-	        artSurface->pitch, pPalette)) {
+	        artSurface->pitch, palette)) {
 		Log("LoadArt(\"{}\"): LoadPcxPixelsAndPalette failed with code {}", pszFile, SErrGetLastError());
 		SFileCloseFileThreadSafe(handle);
-		return;
+		return nullptr;
 	}
 	SFileCloseFileThreadSafe(handle);
 
+	const bool hasPalette = bpp == 8;
+	if (pPalette != nullptr && hasPalette)
+		memcpy(pPalette, palette, sizeof(palette));
+	AddToPcxCache(pszFile, *artSurface, hasPalette ? palette : nullptr);
+	return artSurface;
+}
+
+} // namespace
+
+void LoadArt(const char *pszFile, Art *art, int frames, SDL_Color *pPalette)
+{
+	if (art == nullptr || art->surface != nullptr)
+		return;
+
+	MemoryTagScope memoryTag(MemoryTag::Art);
+	art->frames = frames;
+
+	SDLSurfaceUniquePtr artSurface = LoadPcx(pszFile, pPalette);
+	if (artSurface == nullptr)
+		return;
+
 	art->logical_width = artSurface->w;
-	art->frame_height = height / frames;
+	art->frame_height = artSurface->h / frames;
 
 	art->surface = ScaleSurfaceToOutput(std::move(artSurface));
 }
@@ -152,4 +240,9 @@ void LoadArt(Art *art, const std::uint8_t *artData, int w, int h, int frames)
 	art->frame_height = h / frames;
 }
 
+void ClearArtCache()
+{
+	PcxCache.clear();
+}
+
 } // namespace devilution
@@ -2,6 +2,7 @@
 
 #include <cstdint>
 
+#include "DiabloUI/ui_texture.h"
 #include "utils/sdl_ptrs.h"
 
 namespace devilution {
@@ -12,6 +13,10 @@ struct Art {
 	int logical_width;
 	int frame_height;
 	unsigned int palette_version;
+#if SDL_VERSION_ATLEAST(2, 0, 0)
+	/** Made from the surface when the menu is composited by the renderer */
+	UiTexture texture;
+#endif
 
 	Art()
 	{
@@ -35,11 +40,16 @@ struct Art {
 	void Unload()
 	{
 		surface = nullptr;
+#if SDL_VERSION_ATLEAST(2, 0, 0)
+		texture.Release();
+#endif
 	}
 };
 
 void LoadArt(const char *pszFile, Art *art, int frames = 1, SDL_Color *pPalette = NULL);
 void LoadMaskedArt(const char *pszFile, Art *art, int frames = 1, int mask = 250);
 void LoadArt(Art *art, const std::uint8_t *artData, int w, int h, int frames = 1);
+/** @brief Free the decoded files that LoadArt keeps for when they are loaded again */
+void ClearArtCache();
 
 } // namespace devilution
@@ -26,6 +26,13 @@ void DrawArt(Sint16 screenX, Sint16 screenY, Art *art, int nFrame, Uint16 srcW,
 	SDL_Rect dstRect = { screenX, screenY, srcRect.w, srcRect.h };
 	ScaleOutputRect(&dstRect);
 
+#if SDL_VERSION_ATLEAST(2, 0, 0)
+	if (IsUiTextureFrame()) {
+		DrawUiTexture(art->texture, art->surface.get(), /*applyUiPalette=*/true, &srcRect, dstRect);
+		return;
+	}
+#endif
+
 	if (art->surface->format->BitsPerPixel == 8 && art->palette_version != pal_surface_palette_version) {
 		if (SDLC_SetSurfaceColors(art->surface.get(), pal_surface->format->palette) <= -1)
 			ErrSdl();
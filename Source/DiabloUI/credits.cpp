@@ -8,6 +8,7 @@
 #include "DiabloUI/diabloui.h"
 #include "DiabloUI/fonts.h"
 #include "DiabloUI/support_lines.h"
+#include "DiabloUI/ttf_glyph_atlas.h"
 #include "control.h"
 #include "controls/menu_controls.h"
 #include "hwcursor.hpp"
@@ -58,7 +59,7 @@ SDL_Surface *RenderText(const char *text, SDL_Color color)
 {
 	if (text[0] == '\0')
 		return nullptr;
-	SDL_Surface *result = TTF_RenderText_Solid(font, text, color);
+	SDL_Surface *result = RenderTtfText_Solid(font, text, color);
 	if (result == nullptr)
 		Log("{}", TTF_GetError());
 	return result;
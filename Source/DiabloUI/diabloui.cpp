@@ -9,6 +9,7 @@
 #include "DiabloUI/fonts.h"
 #include "DiabloUI/scrollbar.h"
 #include "DiabloUI/text_draw.h"
+#include "DiabloUI/ui_texture.h"
 #include "controls/controller.h"
 #include "controls/menu_controls.h"
 #include "dx.h"
@@ -394,9 +395,9 @@ void UiHandleEvents(SDL_Event *event)
 	HandleControllerAddedOrRemovedEvent(*event);
 
 	if (event->type == SDL_WINDOWEVENT) {
-		if (event->window.event == SDL_WINDOWEVENT_SHOWN)
+		if (event->window.event == SDL_WINDOWEVENT_SHOWN || event->window.event == SDL_WINDOWEVENT_RESTORED || event->window.event == SDL_WINDOWEVENT_MAXIMIZED)
 			gbActive = true;
-		else if (event->window.event == SDL_WINDOWEVENT_HIDDEN)
+		else if (event->window.event == SDL_WINDOWEVENT_HIDDEN || event->window.event == SDL_WINDOWEVENT_MINIMIZED)
 			gbActive = false;
 		else if (event->window.event == SDL_WINDOWEVENT_SIZE_CHANGED)
 			ReinitializeHardwareCursor();
@@ -548,6 +549,7 @@ void UiDestroy()
 	UnloadTtfFont();
 	UnloadArtFonts();
 	UnloadUiGFX();
+	ClearArtCache();
 }
 
 bool UiValidPlayerName(const char *name)
@@ -656,6 +658,14 @@ void UiFadeIn()
 			SetFadeLevel(fadeValue);
 	}
 
+#if SDL_VERSION_ATLEAST(2, 0, 0)
+	SetUiTextureFadeLevel(fadeValue);
+	if (IsUiTextureFrame()) {
+		PresentUiTextureFrame();
+		return;
+	}
+#endif
+
 	if (DiabloUiSurface() == pal_surface)
 		BltFast(nullptr, nullptr);
 	RenderPresent();
@@ -679,6 +689,11 @@ void DrawSelector(const SDL_Rect &rect)
 
 void UiClearScreen()
 {
+#if SDL_VERSION_ATLEAST(2, 0, 0)
+	// The composited frame starts here, so that what the caller draws before UiPollAndRender is part of it
+	if (IsUiTextureFrame() || BeginUiTextureFrame())
+		return;
+#endif
 	if (gnScreenWidth > 640) // Background size
 		SDL_FillRect(DiabloUiSurface(), nullptr, 0x000000);
 }
@@ -686,11 +701,25 @@ void UiClearScreen()
 void UiPollAndRender()
 {
 	SDL_Event event;
+#if SDL_VERSION_ATLEAST(2, 0, 0)
+	// Once faded in, a menu only changes on input and on the steps of its animations, so sleep until either
+	if (fadeValue >= 256) {
+		constexpr Uint32 AnimationStep = 60; // See GetAnimationFrame
+		if (SDL_WaitEventTimeout(&event, AnimationStep - SDL_GetTicks() % AnimationStep) != 0) {
+			UiFocusNavigation(&event);
+			UiHandleEvents(&event);
+		}
+	}
+#endif
 	while (SDL_PollEvent(&event) != 0) {
 		UiFocusNavigation(&event);
 		UiHandleEvents(&event);
 	}
 	HandleMenuAction(GetMenuHeldUpDownAction());
+#if SDL_VERSION_ATLEAST(2, 0, 0)
+	if (!IsUiTextureFrame())
+		BeginUiTextureFrame();
+#endif
 	UiRenderItems(gUiItems);
 	DrawMouse();
 	UiFadeIn();
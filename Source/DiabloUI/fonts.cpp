@@ -1,5 +1,6 @@
 #include "DiabloUI/fonts.h"
 
+#include "DiabloUI/ttf_glyph_atlas.h"
 #include "diablo.h"
 #include "utils/file_util.h"
 #include "utils/paths.h"
@@ -80,6 +81,7 @@ void LoadTtfFont()
 
 void UnloadTtfFont()
 {
+	ClearTtfGlyphAtlas();
 	if (font != nullptr && TTF_WasInit() != 0)
 		TTF_CloseFont(font);
 	font = nullptr;
@@ -2,9 +2,13 @@
 
 #include "DiabloUI/diabloui.h"
 #include "DiabloUI/text.h"
+#include "options.h"
 #include "stores.h"
 #include "storm/storm.h"
 #include "utils/language.h"
+#if !defined(NONET) && !defined(DISABLE_ZERO_TIER)
+#include "dvlnet/zerotier_native.h"
+#endif
 
 namespace devilution {
 
@@ -103,6 +107,7 @@ void SelconnEsc()
 void SelconnFocus(int value)
 {
 	int players = MAX_PLRS;
+	selconn_Gateway[0] = '\0';
 	switch (vecConnItems[value]->m_value) {
 	case SELCONN_TCP:
 		strncpy(selconn_Description, _("All computers must be connected to a TCP-compatible network."), sizeof(selconn_Description) - 1);
@@ -111,6 +116,10 @@ void SelconnFocus(int value)
 	case SELCONN_ZT:
 		strncpy(selconn_Description, _("All computers must be connected to the internet."), sizeof(selconn_Description) - 1);
 		players = MAX_PLRS;
+#if !defined(NONET) && !defined(DISABLE_ZERO_TIER)
+		if (sgOptions.Network.bStartZeroTierOnLaunch)
+			strncpy(selconn_Gateway, net::zerotier_network_ready() ? _("ZeroTier is online") : _("ZeroTier is connecting"), sizeof(selconn_Gateway) - 1);
+#endif
 		break;
 	case SELCONN_LOOPBACK:
 		strncpy(selconn_Description, _("Play by yourself with no network exposure."), sizeof(selconn_Description) - 1);
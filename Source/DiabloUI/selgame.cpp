@@ -428,7 +428,9 @@ void selgame_Password_Select(int value)
 {
 	if (selgame_selectedGame != 0) {
 		strcpy(sgOptions.Network.szPreviousHost, selgame_Ip);
-		if (SNetJoinGame(selgame_Ip, selgame_Password, gdwPlayerId)) {
+		// Offered to the server in case we are the first to join it, otherwise the game's data replaces it
+		m_game_data->nDifficulty = DIFF_NORMAL;
+		if (SNetJoinGame(selgame_Ip, selgame_Password, (char *)m_game_data, sizeof(*m_game_data), gdwPlayerId)) {
 			if (!IsGameCompatible(m_game_data)) {
 				selgame_GameSelection_Select(1);
 				return;
@@ -82,7 +82,6 @@ void UiSelOkDialog(const char *title, const char *body, bool background)
 	selok_endMenu = false;
 	while (!selok_endMenu) {
 		UiClearScreen();
-		UiRenderItems(vecSelOkDialog);
 		UiPollAndRender();
 	}
 
@@ -71,7 +71,6 @@ bool UiSelHeroYesNoDialog(const char *title, const char *body)
 	selyesno_endMenu = false;
 	while (!selyesno_endMenu) {
 		UiClearScreen();
-		UiRenderItems(vecSelYesNoDialog);
 		UiPollAndRender();
 	}
 
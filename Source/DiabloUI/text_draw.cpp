@@ -61,6 +61,17 @@ void DrawTTF(const char *text, const SDL_Rect &rectIn, int flags,
 	SDL_Rect shadowRect = destRect;
 	++shadowRect.x;
 	++shadowRect.y;
+#if SDL_VERSION_ATLEAST(2, 0, 0)
+	if (IsUiTextureFrame()) {
+		shadowRect.w = shadowSurface->w;
+		shadowRect.h = shadowSurface->h;
+		destRect.w = textSurface->w;
+		destRect.h = textSurface->h;
+		DrawUiTexture(renderCache.shadowTexture, shadowSurface, /*applyUiPalette=*/false, nullptr, shadowRect);
+		DrawUiTexture(renderCache.textTexture, textSurface, /*applyUiPalette=*/false, nullptr, destRect);
+		return;
+	}
+#endif
 	if (SDL_BlitSurface(shadowSurface, nullptr, DiabloUiSurface(), &shadowRect) < 0)
 		ErrSdl();
 	if (SDL_BlitSurface(textSurface, nullptr, DiabloUiSurface(), &destRect) < 0)
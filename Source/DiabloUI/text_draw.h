@@ -2,6 +2,7 @@
 
 #include <SDL.h>
 
+#include "DiabloUI/ui_texture.h"
 #include "utils/sdl_ptrs.h"
 
 namespace devilution {
@@ -9,6 +10,10 @@ namespace devilution {
 struct TtfSurfaceCache {
 	SDLSurfaceUniquePtr text;
 	SDLSurfaceUniquePtr shadow;
+#if SDL_VERSION_ATLEAST(2, 0, 0)
+	UiTexture textTexture;
+	UiTexture shadowTexture;
+#endif
 };
 
 void DrawTTF(const char *text, const SDL_Rect &rect, int flags,
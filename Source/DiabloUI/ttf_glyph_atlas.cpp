@@ -0,0 +1,182 @@
+#include "DiabloUI/ttf_glyph_atlas.h"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+
+#include <SDL.h>
+
+#include "utils/log.hpp"
+#include "utils/sdl_compat.h"
+#include "utils/sdl_ptrs.h"
+
+namespace devilution {
+
+namespace {
+
+constexpr int AtlasColumns = 16;
+constexpr int AtlasRows = 16;
+
+struct TtfGlyph {
+	bool measured;
+	bool rendered;
+	/** Offset of the rendered glyph from the pen position */
+	int16_t offsetX;
+	/** Width of the rendered glyph, clipped to the cell */
+	int16_t width;
+	int16_t maxX;
+	int16_t advance;
+};
+
+/**
+ * All 256 Latin-1 glyphs of the font, rendered in 16x16 cells the first time they are used.
+ * Text is then laid out from the cached metrics and copied from the atlas without going through SDL_ttf.
+ */
+TTF_Font *AtlasFont;
+SDLSurfaceUniquePtr Atlas;
+int CellWidth;
+int CellHeight;
+std::array<TtfGlyph, 256> Glyphs;
+
+void PrepareAtlas(TTF_Font *font)
+{
+	if (AtlasFont == font)
+		return;
+
+	ClearTtfGlyphAtlas();
+	AtlasFont = font;
+	CellHeight = TTF_FontHeight(font);
+	// Wide enough for the glyphs of the fonts the UI uses, anything wider gets clipped
+	CellWidth = 2 * CellHeight;
+	Atlas = SDLSurfaceUniquePtr { SDL_CreateRGBSurface(SDL_SWSURFACE, CellWidth * AtlasColumns, CellHeight * AtlasRows, 8, 0, 0, 0, 0) };
+	if (Atlas == nullptr)
+		Log("{}", SDL_GetError());
+	else
+		SDL_FillRect(Atlas.get(), nullptr, 0);
+}
+
+TtfGlyph &GetGlyph(TTF_Font *font, uint8_t ch)
+{
+	TtfGlyph &glyph = Glyphs[ch];
+	if (glyph.measured)
+		return glyph;
+
+	int minX = 0;
+	int maxX = 0;
+	int minY;
+	int maxY;
+	int advance = 0;
+	if (TTF_GlyphMetrics(font, ch, &minX, &maxX, &minY, &maxY, &advance) < 0)
+		Log("{}", TTF_GetError());
+	glyph.offsetX = std::min(minX, 0);
+	glyph.maxX = maxX;
+	glyph.advance = advance;
+	glyph.measured = true;
+	return glyph;
+}
+
+TtfGlyph &GetRenderedGlyph(TTF_Font *font, uint8_t ch)
+{
+	TtfGlyph &glyph = GetGlyph(font, ch);
+	if (glyph.rendered || Atlas == nullptr)
+		return glyph;
+
+	glyph.rendered = true;
+	const char text[2] = { static_cast<char>(ch), '\0' };
+	SDLSurfaceUniquePtr rendered { ch != '\0' ? TTF_RenderText_Solid(font, text, SDL_Color { 255, 255, 255, 0 }) : nullptr };
+	if (rendered == nullptr)
+		return glyph;
+
+	// Solid rendering uses index 0 for the background and 1 for the glyph
+	const int width = std::min(rendered->w, CellWidth);
+	const int height = std::min(rendered->h, CellHeight);
+	auto *cell = static_cast<uint8_t *>(Atlas->pixels) + (ch / AtlasColumns) * CellHeight * Atlas->pitch + (ch % AtlasColumns) * CellWidth;
+	const auto *src = static_cast<const uint8_t *>(rendered->pixels);
+	for (int y = 0; y < height; y++, cell += Atlas->pitch, src += rendered->pitch)
+		memcpy(cell, src, width);
+	glyph.width = width;
+	return glyph;
+}
+
+} // namespace
+
+int GetTtfTextWidth(TTF_Font *font, const char *text, std::size_t length)
+{
+	PrepareAtlas(font);
+
+	int x = 0;
+	int width = 0;
+	for (std::size_t i = 0; i < length; i++) {
+		const TtfGlyph &glyph = GetGlyph(font, static_cast<uint8_t>(text[i]));
+		width = std::max({ width, x + glyph.advance, x + glyph.maxX });
+		x += glyph.advance;
+	}
+	return width;
+}
+
+void DrawTtfText(TTF_Font *font, const char *text, std::size_t length, SDL_Surface *dest, int x, int y)
+{
+	PrepareAtlas(font);
+	if (Atlas == nullptr)
+		return;
+
+	const int top = std::max(y, 0);
+	const int bottom = std::min(y + CellHeight, dest->h);
+	for (std::size_t i = 0; i < length; i++) {
+		const uint8_t ch = static_cast<uint8_t>(text[i]);
+		const TtfGlyph &glyph = GetRenderedGlyph(font, ch);
+		const int glyphX = x + glyph.offsetX;
+		const int left = std::max(glyphX, 0);
+		const int right = std::min(glyphX + glyph.width, dest->w);
+		x += glyph.advance;
+		if (left >= right)
+			continue;
+
+		const auto *src = static_cast<const uint8_t *>(Atlas->pixels) + ((ch / AtlasColumns) * CellHeight + top - y) * Atlas->pitch
+		    + (ch % AtlasColumns) * CellWidth + left - glyphX;
+		auto *dst = static_cast<uint8_t *>(dest->pixels) + top * dest->pitch + left;
+		for (int row = top; row < bottom; row++, src += Atlas->pitch, dst += dest->pitch) {
+			for (int col = 0; col < right - left; col++) {
+				if (src[col] != 0)
+					dst[col] = 1;
+			}
+		}
+	}
+}
+
+SDL_Surface *RenderTtfText_Solid(TTF_Font *font, const char *text, SDL_Color fg)
+{
+	const std::size_t length = strlen(text);
+	const int width = GetTtfTextWidth(font, text, length);
+	if (width == 0) {
+		TTF_SetError("Text has zero width");
+		return nullptr;
+	}
+
+	SDL_Surface *textbuf = SDL_CreateRGBSurface(SDL_SWSURFACE, width, TTF_FontHeight(font), 8, 0, 0, 0, 0);
+	if (textbuf == nullptr)
+		return nullptr;
+
+	SDL_Palette *palette = textbuf->format->palette;
+	palette->colors[0].r = 255 - fg.r;
+	palette->colors[0].g = 255 - fg.g;
+	palette->colors[0].b = 255 - fg.b;
+	palette->colors[1].r = fg.r;
+	palette->colors[1].g = fg.g;
+	palette->colors[1].b = fg.b;
+	SDLC_SetColorKey(textbuf, 0);
+	SDL_FillRect(textbuf, nullptr, 0);
+
+	DrawTtfText(font, text, length, textbuf, 0, 0);
+	return textbuf;
+}
+
+void ClearTtfGlyphAtlas()
+{
+	AtlasFont = nullptr;
+	Atlas = nullptr;
+	Glyphs = {};
+}
+
+} // namespace devilution
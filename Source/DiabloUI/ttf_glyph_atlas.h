@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstddef>
+
+#include <SDL_ttf.h>
+
+namespace devilution {
+
+/**
+ * @brief Measures Latin-1 text from the cached glyph metrics of the font.
+ * @return The width in pixels, like TTF_SizeText
+ */
+int GetTtfTextWidth(TTF_Font *font, const char *text, std::size_t length);
+
+/**
+ * @brief Draws Latin-1 text into an 8-bit surface from the glyph atlas of the font.
+ *
+ * The pixels covered by the glyphs are set to palette index 1, the rest is left as is.
+ */
+void DrawTtfText(TTF_Font *font, const char *text, std::size_t length, SDL_Surface *dest, int x, int y);
+
+/**
+ * @brief Renders a line of Latin-1 text from the glyph atlas of the font.
+ * @return A surface like the one TTF_RenderText_Solid creates
+ */
+SDL_Surface *RenderTtfText_Solid(TTF_Font *font, const char *text, SDL_Color fg);
+
+/**
+ * @brief Frees the glyph atlas, must be called before the font it was built from is closed.
+ */
+void ClearTtfGlyphAtlas();
+
+} // namespace devilution
@@ -10,6 +10,7 @@
 #include "utils/sdl2_backports.h"
 #endif
 
+#include "DiabloUI/ttf_glyph_atlas.h"
 #include "utils/sdl_compat.h"
 #include "utils/log.hpp"
 
@@ -38,7 +39,9 @@ SDL_Surface *RenderUTF8_Solid_Wrapped(TTF_Font *font, const char *text, SDL_Colo
 	char *str, **strLines;
 
 	/* Get the dimensions of the text surface */
-	if (TTF_SizeUTF8(font, text, &width, &height) < 0 || width == 0) {
+	width = GetTtfTextWidth(font, text, std::strlen(text));
+	height = TTF_FontHeight(font);
+	if (width == 0) {
 		TTF_SetError("Text has zero width");
 		return nullptr;
 	}
@@ -48,7 +51,7 @@ SDL_Surface *RenderUTF8_Solid_Wrapped(TTF_Font *font, const char *text, SDL_Colo
 	strLines = nullptr;
 	if (wrapLength > 0 && *text != '\0') {
 		const char *wrapDelims = " \t\r\n";
-		int w, h;
+		int w;
 		char *spot, *tok, *nextTok, *end;
 		char delim;
 		const std::size_t strLen = std::strlen(text);
@@ -100,7 +103,7 @@ SDL_Surface *RenderUTF8_Solid_Wrapped(TTF_Font *font, const char *text, SDL_Colo
 				delim = *spot;
 				*spot = '\0';
 
-				TTF_SizeUTF8(font, tok, &w, &h);
+				w = GetTtfTextWidth(font, tok, spot - tok);
 				if ((Uint32)w <= wrapLength) {
 					break;
 				}
@@ -120,7 +123,7 @@ SDL_Surface *RenderUTF8_Solid_Wrapped(TTF_Font *font, const char *text, SDL_Colo
 
 	if (strLines == nullptr) {
 		SDL_stack_free(str);
-		return TTF_RenderText_Solid(font, text, fg);
+		return RenderTtfText_Solid(font, text, fg);
 	}
 
 	/* Create the target surface */
@@ -141,6 +144,7 @@ SDL_Surface *RenderUTF8_Solid_Wrapped(TTF_Font *font, const char *text, SDL_Colo
 	palette->colors[1].g = fg.g;
 	palette->colors[1].b = fg.b;
 	SDLC_SetColorKey(textbuf, 0);
+	SDL_FillRect(textbuf, nullptr, 0);
 
 	// Reduced space between lines to roughly match Diablo.
 	const int lineskip = 0.7 * TTF_FontLineSkip(font);
@@ -151,32 +155,22 @@ SDL_Surface *RenderUTF8_Solid_Wrapped(TTF_Font *font, const char *text, SDL_Colo
 			dest.y += lineskip;
 			continue;
 		}
-		SDL_Surface *tmp = TTF_RenderText_Solid(font, text, fg);
-		if (tmp == nullptr) {
-			Log("{}", TTF_GetError());
-			SDL_FreeSurface(textbuf);
-			SDL_free(strLines);
-			SDL_stack_free(str);
-			return nullptr;
-		}
-
-		dest.w = static_cast<Uint16>(tmp->w);
-		dest.h = static_cast<Uint16>(tmp->h);
+		const std::size_t lineLength = std::strlen(text);
+		const int lineWidth = GetTtfTextWidth(font, text, lineLength);
 
 		switch (xAlign) {
 		case TextAlignment_END:
-			dest.x = textbuf->w - tmp->w;
+			dest.x = textbuf->w - lineWidth;
 			break;
 		case TextAlignment_CENTER:
-			dest.x = (textbuf->w - tmp->w) / 2;
+			dest.x = (textbuf->w - lineWidth) / 2;
 			break;
 		case TextAlignment_BEGIN:
 			dest.x = 0;
 			break;
 		}
-		SDL_BlitSurface(tmp, nullptr, textbuf, &dest);
+		DrawTtfText(font, text, lineLength, textbuf, dest.x, dest.y);
 		dest.y += lineskip;
-		SDL_FreeSurface(tmp);
 	}
 	SDL_free(strLines);
 	SDL_stack_free(str);
@@ -15,7 +15,7 @@ enum TextAlignment : uint8_t {
  * Renders UTF-8, wrapping lines to avoid exceeding wrapLength, and aligning
  * according to the `x_align` argument.
  *
- * This method is slow. Caching the result is recommended.
+ * The glyphs are copied from the atlas of the font, caching the result is still recommended.
  */
 SDL_Surface *RenderUTF8_Solid_Wrapped(
     TTF_Font *font, const char *text, SDL_Color fg, Uint32 wrapLength, const int x_align = TextAlignment_BEGIN);
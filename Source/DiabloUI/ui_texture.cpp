@@ -0,0 +1,162 @@
+#include "DiabloUI/ui_texture.h"
+
+#if SDL_VERSION_ATLEAST(2, 0, 0)
+
+#include <algorithm>
+#include <cstring>
+#include <utility>
+
+#include "dx.h"
+#include "options.h"
+#include "palette.h"
+#include "utils/display.h"
+#include "utils/log.hpp"
+#include "utils/sdl_ptrs.h"
+
+namespace devilution {
+
+namespace {
+
+/** Changed whenever the renderer is destroyed, textures of older generations are already freed */
+uint32_t RendererGeneration = 1;
+/** Changed whenever the colors of logical_palette change, so that 8-bit art is converted again */
+uint32_t UiPaletteVersion = 1;
+SDL_Color UiPalette[256];
+Uint8 FadeColorMod;
+bool InTextureFrame;
+
+void UpdateUiPalette()
+{
+	SDL_Color colors[256];
+	for (int i = 0; i < 256; i++) {
+		colors[i] = logical_palette[i];
+		colors[i].a = SDL_ALPHA_OPAQUE;
+	}
+	if (memcmp(colors, UiPalette, sizeof(colors)) == 0)
+		return;
+	memcpy(UiPalette, colors, sizeof(colors));
+	UiPaletteVersion++;
+}
+
+SDL_Texture *CreateTexture(SDL_Surface *surface, bool applyUiPalette)
+{
+	SDL_Surface *source = surface;
+	SDLSurfaceUniquePtr recolored;
+	if (applyUiPalette && surface->format->BitsPerPixel == 8) {
+		// Wrap the pixels in a surface of its own so that the palette the software path set on the art is kept
+		recolored = SDLSurfaceUniquePtr { SDL_CreateRGBSurfaceWithFormatFrom(surface->pixels, surface->w, surface->h, 8, surface->pitch, SDL_PIXELFORMAT_INDEX8) };
+		if (recolored == nullptr || SDL_SetPaletteColors(recolored->format->palette, UiPalette, 0, 256) < 0) {
+			Log("{}", SDL_GetError());
+			return nullptr;
+		}
+		Uint32 colorKey;
+		if (SDL_GetColorKey(surface, &colorKey) == 0)
+			SDL_SetColorKey(recolored.get(), SDL_TRUE, colorKey);
+		source = recolored.get();
+	}
+
+	// The color key becomes transparency when the surface is converted to a format with alpha
+	SDLSurfaceUniquePtr converted { SDL_ConvertSurfaceFormat(source, SDL_PIXELFORMAT_ARGB8888, 0) };
+	if (converted == nullptr) {
+		Log("{}", SDL_GetError());
+		return nullptr;
+	}
+	SDL_Texture *texture = SDL_CreateTextureFromSurface(renderer, converted.get());
+	if (texture == nullptr) {
+		Log("{}", SDL_GetError());
+		return nullptr;
+	}
+	SDL_SetTextureBlendMode(texture, SDL_BLENDMODE_BLEND);
+	return texture;
+}
+
+} // namespace
+
+UiTexture::UiTexture(UiTexture &&other) noexcept
+    : texture_(std::exchange(other.texture_, nullptr))
+    , rendererGeneration_(other.rendererGeneration_)
+    , paletteVersion_(other.paletteVersion_)
+{
+}
+
+UiTexture &UiTexture::operator=(UiTexture &&other) noexcept
+{
+	if (this != &other) {
+		Release();
+		texture_ = std::exchange(other.texture_, nullptr);
+		rendererGeneration_ = other.rendererGeneration_;
+		paletteVersion_ = other.paletteVersion_;
+	}
+	return *this;
+}
+
+void UiTexture::Release()
+{
+	if (texture_ != nullptr && rendererGeneration_ == RendererGeneration)
+		SDL_DestroyTexture(texture_);
+	texture_ = nullptr;
+}
+
+SDL_Texture *UiTexture::Get(SDL_Surface *surface, bool applyUiPalette)
+{
+	const bool usesPalette = applyUiPalette && surface->format->BitsPerPixel == 8;
+	if (texture_ != nullptr && rendererGeneration_ == RendererGeneration && (!usesPalette || paletteVersion_ == UiPaletteVersion))
+		return texture_;
+
+	Release();
+	texture_ = CreateTexture(surface, applyUiPalette);
+	rendererGeneration_ = RendererGeneration;
+	paletteVersion_ = UiPaletteVersion;
+	return texture_;
+}
+
+bool BeginUiTextureFrame()
+{
+	if (!sgOptions.Graphics.bHardwareUi || renderer == nullptr)
+		return false;
+
+	UpdateUiPalette();
+	if (SDL_SetRenderDrawColor(renderer, 0, 0, 0, 255) <= -1 || SDL_RenderClear(renderer) <= -1) {
+		Log("{}", SDL_GetError());
+		return false;
+	}
+	InTextureFrame = true;
+	return true;
+}
+
+bool IsUiTextureFrame()
+{
+	return InTextureFrame;
+}
+
+void DrawUiTexture(UiTexture &texture, SDL_Surface *surface, bool applyUiPalette, const SDL_Rect *srcRect, const SDL_Rect &dstRect)
+{
+	SDL_Texture *sdlTexture = texture.Get(surface, applyUiPalette);
+	if (sdlTexture == nullptr)
+		return;
+
+	SDL_SetTextureColorMod(sdlTexture, FadeColorMod, FadeColorMod, FadeColorMod);
+	if (SDL_RenderCopy(renderer, sdlTexture, srcRect, &dstRect) <= -1)
+		Log("{}", SDL_GetError());
+}
+
+void PresentUiTextureFrame()
+{
+	InTextureFrame = false;
+	RenderPresentTextures();
+}
+
+void SetUiTextureFadeLevel(int fadeValue)
+{
+	FadeColorMod = static_cast<Uint8>(std::min(fadeValue, 255));
+}
+
+void InvalidateUiTextures()
+{
+	InTextureFrame = false;
+	RendererGeneration++;
+}
+
+} // namespace devilution
+
+#endif
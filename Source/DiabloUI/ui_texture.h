@@ -0,0 +1,76 @@
+#pragma once
+
+#include <cstdint>
+
+#include <SDL.h>
+
+namespace devilution {
+
+#if SDL_VERSION_ATLEAST(2, 0, 0)
+
+/**
+ * @brief A renderer texture made from a UI surface the first time it is drawn.
+ *
+ * The renderer frees its textures when it is destroyed, so the ones made for an earlier renderer are dropped without destroying them again.
+ */
+class UiTexture {
+public:
+	UiTexture() = default;
+	UiTexture(UiTexture &&other) noexcept;
+	UiTexture &operator=(UiTexture &&other) noexcept;
+	UiTexture(const UiTexture &) = delete;
+	UiTexture &operator=(const UiTexture &) = delete;
+
+	~UiTexture()
+	{
+		Release();
+	}
+
+	void Release();
+
+	/**
+	 * @param surface The surface the texture is made from, must not change while the texture is kept
+	 * @param applyUiPalette Color 8-bit surfaces with the UI palette instead of their own
+	 */
+	SDL_Texture *Get(SDL_Surface *surface, bool applyUiPalette);
+
+private:
+	SDL_Texture *texture_ = nullptr;
+	uint32_t rendererGeneration_ = 0;
+	uint32_t paletteVersion_ = 0;
+};
+
+/**
+ * @brief Starts a menu frame that is composited by the renderer instead of drawn into the output surface.
+ * @return false if the option is off or there is no renderer, the frame is then drawn as usual
+ */
+bool BeginUiTextureFrame();
+
+/**
+ * @brief Whether the UI is currently drawn with the renderer.
+ */
+bool IsUiTextureFrame();
+
+/**
+ * @brief Copies a surface to the current frame through its texture.
+ */
+void DrawUiTexture(UiTexture &texture, SDL_Surface *surface, bool applyUiPalette, const SDL_Rect *srcRect, const SDL_Rect &dstRect);
+
+/**
+ * @brief Presents the composited frame and ends it.
+ */
+void PresentUiTextureFrame();
+
+/**
+ * @brief Sets how far the menu has faded in, from 0 (black) to 256, the textures are tinted instead of recolored.
+ */
+void SetUiTextureFadeLevel(int fadeValue);
+
+/**
+ * @brief Forgets all textures, must be called before the renderer is destroyed.
+ */
+void InvalidateUiTextures();
+
+#endif
+
+} // namespace devilution
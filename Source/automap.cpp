@@ -6,6 +6,8 @@
 #include "automap.h"
 
 #include <algorithm>
+#include <cstring>
+#include <vector>
 
 #include <fmt/format.h>
 
@@ -17,6 +19,7 @@
 #include "player.h"
 #include "setmaps.h"
 #include "utils/language.h"
+#include "utils/sdl_geometry.h"
 #include "utils/ui_fwd.h"
 
 namespace devilution {
@@ -417,6 +420,246 @@ void DrawAutomapText(const CelOutputBuffer &out)
 	}
 }
 
+/**
+ * @brief The explored part of the map, rendered once at the current zoom level.
+ *
+ * Cells are laid out by `u = x - y` and `v = x + y` in the same order DrawAutomapCells draws
+ * them, so overlapping lines end up the same. When cells are explored (or the dungeon changes
+ * under them) only the area they cover is redrawn. The drawn pixels are kept as runs per row so
+ * each frame only copies those.
+ */
+struct AutomapLayerCache {
+	struct Span {
+		uint16_t x;
+		uint16_t length;
+	};
+
+	CelOutputBuffer buffer;
+	std::vector<std::vector<Span>> spans;
+	bool valid = false;
+	int scale;
+	/** Which of `u`/`v` parities sits on the even columns, only relevant when the line lengths don't halve evenly */
+	int parity;
+	bool view[DMAXX][DMAXY];
+	uint8_t tiles[DMAXX][DMAXY];
+};
+
+AutomapLayerCache AutomapLayer;
+
+/** Largest layer that is kept, at the zoom levels beyond it the visible cells are drawn every frame */
+constexpr size_t MaxAutomapLayerSize = 4 * 1024 * 1024;
+
+constexpr int LayerMinU = -DMAXY;
+constexpr int LayerMaxU = DMAXX;
+constexpr int LayerMinV = -2;
+constexpr int LayerMaxV = DMAXX + DMAXY - 2;
+
+/**
+ * @brief Returns the position of the cell at `u`/`v` relative to one of the same parity as `AutomapLayer.parity`.
+ */
+Point GetLayerOffset(int u, int v)
+{
+	const int du = u - (LayerMinU - AutomapLayer.parity);
+	const int dv = v - (LayerMinV - AutomapLayer.parity);
+
+	Point offset;
+	offset.x = (du % 2) == 0 ? du / 2 * AmLine64 : (du + 1) / 2 * AmLine64 - AmLine32;
+	offset.y = (dv % 2) == 0 ? dv / 2 * AmLine32 : (dv - 1) / 2 * AmLine32 + AmLine16;
+	return offset;
+}
+
+/**
+ * @brief Returns the center of the given map cell in the layer buffer.
+ */
+Point GetLayerPosition(Point map)
+{
+	Point position = GetLayerOffset(map.x - map.y, map.x + map.y);
+	position.x += AmLine64;
+	position.y += AmLine32;
+	return position;
+}
+
+/**
+ * @brief Returns the area a cell drawn at the given center may touch (with some slack).
+ */
+SDL_Rect GetCellBounds(Point center)
+{
+	return MakeSdlRect(center.x - AmLine64, center.y - AmLine32, 2 * AmLine64 + 1, 2 * AmLine32 + 1);
+}
+
+bool RectsIntersect(const SDL_Rect &a, const SDL_Rect &b)
+{
+	return a.x < b.x + b.w && b.x < a.x + a.w && a.y < b.y + b.h && b.y < a.y + a.h;
+}
+
+/**
+ * @brief Redraws every cell touching the given area of the layer and rebuilds the runs of its rows.
+ */
+void RedrawAutomapLayer(SDL_Rect rect)
+{
+	CelOutputBuffer &layer = AutomapLayer.buffer;
+
+	const int left = std::max<int>(rect.x, 0);
+	const int top = std::max<int>(rect.y, 0);
+	const int right = std::min<int>(rect.x + rect.w, layer.w());
+	const int bottom = std::min<int>(rect.y + rect.h, layer.h());
+	if (left >= right || top >= bottom)
+		return;
+	rect = MakeSdlRect(left, top, right - left, bottom - top);
+
+	for (int y = top; y < bottom; y++)
+		memset(layer.at(left, y), 0, right - left);
+
+	const CelOutputBuffer area = layer.subregion(rect.x, rect.y, rect.w, rect.h);
+	for (int v = LayerMinV; v <= LayerMaxV; v++) {
+		for (int x = -1; x < DMAXX; x++) {
+			const Point map { x, v - x };
+			if (map.y < -1 || map.y >= DMAXY)
+				continue;
+			const Point center = GetLayerPosition(map);
+			if (!RectsIntersect(GetCellBounds(center), rect))
+				continue;
+			uint16_t mapType = GetAutomapType(map, true);
+			if (mapType != 0)
+				DrawAutomapTile(area, { center.x - rect.x, center.y - rect.y }, mapType);
+		}
+	}
+
+	for (int y = top; y < bottom; y++) {
+		std::vector<AutomapLayerCache::Span> &rowSpans = AutomapLayer.spans[y];
+		rowSpans.clear();
+		const uint8_t *row = layer.at(0, y);
+		for (int x = 0; x < layer.w();) {
+			if (row[x] == 0) {
+				x++;
+				continue;
+			}
+			const int start = x;
+			while (x < layer.w() && row[x] != 0)
+				x++;
+			rowSpans.push_back({ static_cast<uint16_t>(start), static_cast<uint16_t>(x - start) });
+		}
+	}
+}
+
+/**
+ * @brief Brings the layer up to date with the explored cells, the dungeon and the zoom level.
+ * @return false if the layer would exceed MaxAutomapLayerSize at this zoom level, it is freed then
+ */
+bool UpdateAutomapLayer(int parity)
+{
+	// With line lengths that halve evenly the cell positions don't depend on the parity
+	if (AmLine64 == 2 * AmLine32 && AmLine32 == 2 * AmLine16)
+		parity = 0;
+
+	if (!AutomapLayer.valid || AutomapLayer.scale != AutoMapScale || AutomapLayer.parity != parity) {
+		AutomapLayer.parity = parity;
+		const Point end = GetLayerOffset(LayerMaxU, LayerMaxV);
+		const int width = end.x + 2 * AmLine64 + 1;
+		const int height = end.y + 2 * AmLine32 + 1;
+		if (static_cast<size_t>(width) * height > MaxAutomapLayerSize) {
+			AutomapLayer.buffer.Free();
+			AutomapLayer.spans.clear();
+			AutomapLayer.valid = false;
+			return false;
+		}
+		if (AutomapLayer.buffer.surface == nullptr || AutomapLayer.buffer.w() != width || AutomapLayer.buffer.h() != height) {
+			AutomapLayer.buffer.Free();
+			AutomapLayer.buffer = CelOutputBuffer::Alloc(width, height);
+		}
+		AutomapLayer.spans.assign(height, {});
+		AutomapLayer.scale = AutoMapScale;
+		AutomapLayer.valid = true;
+		memcpy(AutomapLayer.view, AutomapView, sizeof(AutomapView));
+		memcpy(AutomapLayer.tiles, dungeon, sizeof(dungeon));
+		RedrawAutomapLayer(MakeSdlRect(0, 0, width, height));
+		return true;
+	}
+
+	if (memcmp(AutomapLayer.view, AutomapView, sizeof(AutomapView)) == 0 && memcmp(AutomapLayer.tiles, dungeon, sizeof(dungeon)) == 0)
+		return true;
+
+	int left = AutomapLayer.buffer.w();
+	int top = AutomapLayer.buffer.h();
+	int right = 0;
+	int bottom = 0;
+	const auto addCell = [&](Point map) {
+		const SDL_Rect bounds = GetCellBounds(GetLayerPosition(map));
+		left = std::min<int>(left, bounds.x);
+		top = std::min<int>(top, bounds.y);
+		right = std::max<int>(right, bounds.x + bounds.w);
+		bottom = std::max<int>(bottom, bounds.y + bounds.h);
+	};
+	for (int x = 0; x < DMAXX; x++) {
+		for (int y = 0; y < DMAXY; y++) {
+			if (AutomapLayer.view[x][y] == AutomapView[x][y] && AutomapLayer.tiles[x][y] == dungeon[x][y])
+				continue;
+			AutomapLayer.view[x][y] = AutomapView[x][y];
+			AutomapLayer.tiles[x][y] = dungeon[x][y];
+			// The cell's shape also depends on its neighbours (see GetAutomapType)
+			addCell({ x, y });
+			addCell({ x + 1, y });
+			addCell({ x, y + 1 });
+			if (x == 0)
+				addCell({ -1, y });
+			if (y == 0)
+				addCell({ x, -1 });
+		}
+	}
+
+	RedrawAutomapLayer(MakeSdlRect(left, top, right - left, bottom - top));
+	return true;
+}
+
+/**
+ * @brief Copies the drawn pixels of the layer to the screen, with the layer's `origin` at the given screen position.
+ */
+void DrawAutomapLayer(const CelOutputBuffer &out, Point origin)
+{
+	const int firstRow = std::max(0, -origin.y);
+	const int lastRow = std::min(AutomapLayer.buffer.h(), out.h() - origin.y);
+	for (int y = firstRow; y < lastRow; y++) {
+		const uint8_t *src = AutomapLayer.buffer.at(0, y);
+		uint8_t *dst = out.at(0, origin.y + y);
+		for (const AutomapLayerCache::Span &span : AutomapLayer.spans[y]) {
+			const int start = std::max(0, origin.x + span.x);
+			const int end = std::min(out.w(), origin.x + span.x + span.length);
+			if (start < end)
+				memcpy(dst + start, src + start - origin.x, end - start);
+		}
+	}
+}
+
+/**
+ * @brief Draws the visible cells directly, for the zoom levels that have no layer.
+ * @param screen Position of the top left cell
+ * @param map The top left cell
+ * @param cells Number of cells in a row of the view
+ */
+void DrawAutomapCells(const CelOutputBuffer &out, Point screen, Point map, int cells)
+{
+	for (int i = 0; i <= cells + 1; i++) {
+		Point tile1 = screen;
+		for (int j = 0; j < cells; j++) {
+			uint16_t mapType = GetAutomapType({ map.x + j, map.y - j }, true);
+			if (mapType != 0)
+				DrawAutomapTile(out, tile1, mapType);
+			tile1.x += AmLine64;
+		}
+		map.y++;
+
+		Point tile2 { screen.x - AmLine32, screen.y + AmLine16 };
+		for (int j = 0; j <= cells; j++) {
+			uint16_t mapType = GetAutomapType({ map.x + j, map.y - j }, true);
+			if (mapType != 0)
+				DrawAutomapTile(out, tile2, mapType);
+			tile2.x += AmLine64;
+		}
+		map.x++;
+		screen.y += AmLine32;
+	}
+}
+
 std::unique_ptr<uint16_t[]> LoadAutomapData(size_t &tileCount)
 {
 	switch (leveltype) {
@@ -470,6 +713,7 @@ void InitAutomap()
 	tileTypes = nullptr;
 
 	memset(AutomapView, 0, sizeof(AutomapView));
+	AutomapLayer.valid = false;
 
 	for (auto &column : dFlags)
 		for (auto &dFlag : column)
@@ -593,27 +837,13 @@ void DrawAutomap(const CelOutputBuffer &out)
 		}
 	}
 
-	Point map = { Automap.x - cells, Automap.y - 1 };
-
-	for (int i = 0; i <= cells + 1; i++) {
-		Point tile1 = screen;
-		for (int j = 0; j < cells; j++) {
-			uint16_t mapType = GetAutomapType({ map.x + j, map.y - j }, true);
-			if (mapType != 0)
-				DrawAutomapTile(out, tile1, mapType);
-			tile1.x += AmLine64;
-		}
-		map.y++;
-
-		Point tile2 { screen.x - AmLine32, screen.y + AmLine16 };
-		for (int j = 0; j <= cells; j++) {
-			uint16_t mapType = GetAutomapType({ map.x + j, map.y - j }, true);
-			if (mapType != 0)
-				DrawAutomapTile(out, tile2, mapType);
-			tile2.x += AmLine64;
-		}
-		map.x++;
-		screen.y += AmLine32;
+	// The top left cell of the view is drawn at `screen`
+	const Point map = { Automap.x - cells, Automap.y - 1 };
+	if (UpdateAutomapLayer((map.x - map.y) & 1)) {
+		const Point cell = GetLayerPosition(map);
+		DrawAutomapLayer(out, { screen.x - cell.x, screen.y - cell.y });
+	} else {
+		DrawAutomapCells(out, screen, map, cells);
 	}
 
 	for (int playerId = 0; playerId < MAX_PLRS; playerId++) {
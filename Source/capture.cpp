@@ -3,27 +3,73 @@
  *
  * Implementation of the screenshot function.
  */
+#include "capture.h"
+
+#include <deque>
 #include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <SDL.h>
 
 #include "DiabloUI/diabloui.h"
+#include "appfat.h"
 #include "dx.h"
 #include "palette.h"
 #include "storm/storm.h"
 #include "utils/file_util.h"
 #include "utils/paths.h"
+#include "utils/thread.h"
 #include "utils/ui_fwd.h"
 #include "utils/log.hpp"
 
 namespace devilution {
 
+namespace {
+
+/**
+ * @brief A copy of a frame waiting to be written. The buffers are reused for later captures.
+ */
+struct CapturedFrame {
+	std::string path;
+	/** Already opened by CaptureFile for screenshots, opened by the capture thread for frame dumps */
+	std::unique_ptr<std::ofstream> out;
+	/** Frame dumps only report failures */
+	bool quiet;
+	int width;
+	int height;
+	std::vector<BYTE> pixels;
+	SDL_Color palette[256];
+	std::vector<BYTE> encoded;
+};
+
+/** Frame dumps drop frames while this many are waiting to be written */
+constexpr size_t MaxPendingFrames = 8;
+
+/** Created together with the thread by the first capture */
+SDL_mutex *CaptureMutex;
+SDL_cond *FrameQueued;
+SDL_Thread *CaptureThread;
+SDL_threadID CaptureThreadId;
+bool CaptureQuit;
+std::deque<std::unique_ptr<CapturedFrame>> PendingFrames;
+std::vector<std::unique_ptr<CapturedFrame>> FreeFrames;
+
+bool FrameDumpActive;
+/** Kept between dumps, so starting another one doesn't check the names of the earlier frames again */
+int FrameDumpIndex;
+int DroppedFrames;
+
+} // namespace
+
 /**
  * @brief Write the PCX-file header
  * @param width Image width
  * @param height Image height
- * @param out File stream to write to
- * @return True on success
+ * @param out Buffer to append to
  */
-static bool CaptureHdr(short width, short height, std::ofstream *out)
+static void CaptureHdr(short width, short height, std::vector<BYTE> &out)
 {
 	PCXHeader buffer;
 
@@ -39,30 +85,23 @@ static bool CaptureHdr(short width, short height, std::ofstream *out)
 	buffer.NPlanes = 1;
 	buffer.BytesPerLine = SDL_SwapLE16(width);
 
-	out->write(reinterpret_cast<const char *>(&buffer), sizeof(buffer));
-	return !out->fail();
+	const BYTE *data = reinterpret_cast<const BYTE *>(&buffer);
+	out.insert(out.end(), data, data + sizeof(buffer));
 }
 
 /**
- * @brief Write the current in-game palette to the PCX file
- * @param palette Current palette
- * @param out File stream for the PCX file.
- * @return True if successful, else false
+ * @brief Write the in-game palette to the PCX file
+ * @param palette Palette at the time of the capture
+ * @param out Buffer to append to
  */
-static bool CapturePal(SDL_Color *palette, std::ofstream *out)
+static void CapturePal(const SDL_Color *palette, std::vector<BYTE> &out)
 {
-	BYTE pcxPalette[1 + 256 * 3];
-	int i;
-
-	pcxPalette[0] = 12;
-	for (i = 0; i < 256; i++) {
-		pcxPalette[1 + 3 * i + 0] = palette[i].r;
-		pcxPalette[1 + 3 * i + 1] = palette[i].g;
-		pcxPalette[1 + 3 * i + 2] = palette[i].b;
+	out.push_back(12);
+	for (int i = 0; i < 256; i++) {
+		out.push_back(palette[i].r);
+		out.push_back(palette[i].g);
+		out.push_back(palette[i].b);
 	}
-
-	out->write(reinterpret_cast<const char *>(pcxPalette), sizeof(pcxPalette));
-	return !out->fail();
 }
 
 /**
@@ -73,7 +112,7 @@ static bool CapturePal(SDL_Color *palette, std::ofstream *out)
 
  * @return Output buffer
  */
-static BYTE *CaptureEnc(BYTE *src, BYTE *dst, int width)
+static BYTE *CaptureEnc(const BYTE *src, BYTE *dst, int width)
 {
 	int rleLength;
 
@@ -109,22 +148,21 @@ static BYTE *CaptureEnc(BYTE *src, BYTE *dst, int width)
 
 /**
  * @brief Write the pixel data to the PCX file
- * @param buf Buffer
- * @return True if successful, else false
+ * @param frame Captured frame
+ * @param out Buffer to append to
  */
-static bool CapturePix(const CelOutputBuffer &buf, std::ofstream *out)
+static void CapturePix(const CapturedFrame &frame, std::vector<BYTE> &out)
 {
-	int width = buf.w();
-	std::unique_ptr<BYTE[]> pBuffer { new BYTE[2 * width] };
-	BYTE *pixels = buf.begin();
-	for (int height = buf.h(); height > 0; height--) {
-		const BYTE *pBufferEnd = CaptureEnc(pixels, pBuffer.get(), width);
-		pixels += buf.pitch();
-		out->write(reinterpret_cast<const char *>(pBuffer.get()), pBufferEnd - pBuffer.get());
-		if (out->fail())
-			return false;
+	const size_t start = out.size();
+	// Every pixel takes at most two bytes
+	out.resize(start + 2 * frame.width * frame.height);
+	BYTE *dst = &out[start];
+	const BYTE *pixels = frame.pixels.data();
+	for (int height = frame.height; height > 0; height--) {
+		dst = CaptureEnc(pixels, dst, frame.width);
+		pixels += frame.width;
 	}
-	return true;
+	out.resize(dst - out.data());
 }
 
 /**
@@ -143,6 +181,121 @@ static std::ofstream *CaptureFile(std::string *dstPath)
 	return nullptr;
 }
 
+static std::string FrameDumpPath(int index)
+{
+	char filename[sizeof("frame00000.PCX") / sizeof(char)];
+	snprintf(filename, sizeof(filename) / sizeof(char), "frame%05d.PCX", index % 100000);
+	return paths::PrefPath() + filename;
+}
+
+/**
+ * @brief Encode the frame and write it out, runs on the capture thread.
+ */
+static void WriteFrame(CapturedFrame &frame)
+{
+	frame.encoded.clear();
+	CaptureHdr(frame.width, frame.height, frame.encoded);
+	CapturePix(frame, frame.encoded);
+	CapturePal(frame.palette, frame.encoded);
+
+	if (frame.out == nullptr)
+		frame.out = std::make_unique<std::ofstream>(frame.path, std::ios::binary | std::ios::trunc);
+	frame.out->write(reinterpret_cast<const char *>(frame.encoded.data()), frame.encoded.size());
+	frame.out->close();
+	const bool success = !frame.out->fail();
+	frame.out = nullptr;
+
+	if (!success) {
+		Log("Failed to save screenshot at {}", frame.path);
+		RemoveFile(frame.path.c_str());
+	} else if (!frame.quiet) {
+		Log("Screenshot saved at {}", frame.path);
+	}
+}
+
+static unsigned int CaptureHandler(void * /*data*/)
+{
+	SDL_LockMutex(CaptureMutex);
+	// Frames that are still queued when quitting are written before the thread ends
+	while (!CaptureQuit || !PendingFrames.empty()) {
+		if (PendingFrames.empty()) {
+			SDL_CondWait(FrameQueued, CaptureMutex);
+			continue;
+		}
+
+		std::unique_ptr<CapturedFrame> frame = std::move(PendingFrames.front());
+		PendingFrames.pop_front();
+		SDL_UnlockMutex(CaptureMutex);
+
+		WriteFrame(*frame);
+
+		SDL_LockMutex(CaptureMutex);
+		FreeFrames.push_back(std::move(frame));
+	}
+	SDL_UnlockMutex(CaptureMutex);
+
+	return 0;
+}
+
+/**
+ * @brief Copy the frame and palette into a pooled buffer and hand it to the capture thread.
+ * @param out File opened for the frame, it is closed and removed if the frame is dropped
+ * @param dropIfBusy Drop the frame instead if too many are waiting to be written
+ * @return False if the frame was dropped
+ */
+static bool QueueFrame(const CelOutputBuffer &buf, const SDL_Color *palette, std::string path, std::unique_ptr<std::ofstream> out, bool dropIfBusy)
+{
+	const auto dropFrame = [&]() {
+		if (out != nullptr) {
+			out = nullptr;
+			RemoveFile(path.c_str());
+		}
+		return false;
+	};
+
+	if (CaptureThread == nullptr) {
+		if (CaptureQuit)
+			return dropFrame();
+		CaptureMutex = SDL_CreateMutex();
+		FrameQueued = SDL_CreateCond();
+		if (CaptureMutex == nullptr || FrameQueued == nullptr)
+			ErrSdl();
+		CaptureThread = CreateThread(CaptureHandler, &CaptureThreadId);
+	}
+
+	std::unique_ptr<CapturedFrame> frame;
+	SDL_LockMutex(CaptureMutex);
+	if (dropIfBusy && PendingFrames.size() >= MaxPendingFrames) {
+		SDL_UnlockMutex(CaptureMutex);
+		return dropFrame();
+	}
+	if (!FreeFrames.empty()) {
+		frame = std::move(FreeFrames.back());
+		FreeFrames.pop_back();
+	}
+	SDL_UnlockMutex(CaptureMutex);
+	if (frame == nullptr)
+		frame = std::make_unique<CapturedFrame>();
+
+	frame->path = std::move(path);
+	frame->out = std::move(out);
+	frame->quiet = dropIfBusy;
+	frame->width = buf.w();
+	frame->height = buf.h();
+	// CaptureEnc peeks one pixel past the end of a row
+	frame->pixels.resize(buf.w() * buf.h() + 1);
+	for (int y = 0; y < buf.h(); y++)
+		memcpy(&frame->pixels[y * buf.w()], buf.at(0, y), buf.w());
+	memcpy(frame->palette, palette, sizeof(frame->palette));
+
+	SDL_LockMutex(CaptureMutex);
+	PendingFrames.push_back(std::move(frame));
+	SDL_CondSignal(FrameQueued);
+	SDL_UnlockMutex(CaptureMutex);
+
+	return true;
+}
+
 /**
  * @brief Make a red version of the given palette and apply it to the screen.
  */
@@ -165,40 +318,74 @@ void CaptureScreen()
 {
 	SDL_Color palette[256];
 	std::string fileName;
-	bool success;
 
-	std::ofstream *outStream = CaptureFile(&fileName);
+	std::unique_ptr<std::ofstream> outStream { CaptureFile(&fileName) };
 	if (outStream == nullptr)
 		return;
 	DrawAndBlit();
 	PaletteGetEntries(256, palette);
-	RedPalette();
 
+	// Encoding and writing happen on the capture thread
 	lock_buf(2);
-	const CelOutputBuffer &buf = GlobalBackBuffer();
-	success = CaptureHdr(buf.w(), buf.h(), outStream);
-	if (success) {
-		success = CapturePix(buf, outStream);
-	}
-	if (success) {
-		success = CapturePal(palette, outStream);
-	}
+	QueueFrame(GlobalBackBuffer(), palette, fileName, std::move(outStream), false);
 	unlock_buf(2);
-	outStream->close();
 
-	if (!success) {
-		Log("Failed to save screenshot at {}", fileName);
-		RemoveFile(fileName.c_str());
-	} else {
-		Log("Screenshot saved at {}", fileName);
-	}
+	RedPalette();
 	SDL_Delay(300);
 	for (int i = 0; i < 256; i++) {
 		system_palette[i] = palette[i];
 	}
 	palette_update();
 	force_redraw = 255;
-	delete outStream;
+}
+
+void ToggleFrameDump()
+{
+	FrameDumpActive = !FrameDumpActive;
+	if (!FrameDumpActive) {
+		Log("Frame dump stopped, {} frames dropped", DroppedFrames);
+		return;
+	}
+
+	while (FrameDumpIndex < 100000 && FileExists(FrameDumpPath(FrameDumpIndex).c_str()))
+		FrameDumpIndex++;
+	DroppedFrames = 0;
+	Log("Frame dump started at {}", FrameDumpPath(FrameDumpIndex));
+}
+
+void CaptureFrameDump(const CelOutputBuffer &out)
+{
+	if (!FrameDumpActive)
+		return;
+
+	SDL_Color palette[256];
+	PaletteGetEntries(256, palette);
+	if (QueueFrame(out, palette, FrameDumpPath(FrameDumpIndex), nullptr, true))
+		FrameDumpIndex++;
+	else
+		DroppedFrames++;
+}
+
+void ShutdownCapture()
+{
+	FrameDumpActive = false;
+	if (CaptureThread == nullptr) {
+		CaptureQuit = true;
+		return;
+	}
+
+	SDL_LockMutex(CaptureMutex);
+	CaptureQuit = true;
+	SDL_CondSignal(FrameQueued);
+	SDL_UnlockMutex(CaptureMutex);
+	SDL_WaitThread(CaptureThread, nullptr);
+	CaptureThread = nullptr;
+
+	FreeFrames.clear();
+	SDL_DestroyCond(FrameQueued);
+	SDL_DestroyMutex(CaptureMutex);
+	FrameQueued = nullptr;
+	CaptureMutex = nullptr;
 }
 
 } // namespace devilution
@@ -5,8 +5,25 @@
  */
 #pragma once
 
+#include "engine.h"
+
 namespace devilution {
 
 void CaptureScreen();
 
+/**
+ * @brief Start or stop writing every drawn frame to frame?????.PCX files.
+ */
+void ToggleFrameDump();
+
+/**
+ * @brief Queue the given frame to be written if frame dumping is on.
+ *
+ * Frames are dropped while the capture thread is behind.
+ */
+void CaptureFrameDump(const CelOutputBuffer &out);
+
+/** @brief Write out the captures that are still queued and stop the capture thread. */
+void ShutdownCapture();
+
 }
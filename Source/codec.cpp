@@ -4,6 +4,9 @@
  * Implementation of save game encryption algorithm.
  */
 
+#include "codec.h"
+
+#include <algorithm>
 #include <cstdint>
 
 #include "appfat.h"
@@ -22,6 +25,23 @@ struct CodecSignature {
 
 #define BLOCKSIZE 64
 
+static_assert(sizeof(CodecSignature) == CodecEncoder::SignatureSize, "CodecEncoder::SignatureSize doesn't match the signature");
+static_assert(BLOCKSIZE == CodecEncoder::BlockSize, "CodecEncoder::BlockSize doesn't match the block size");
+
+/**
+ * @brief XORs a block with the digest repeated over its length
+ *
+ * Works on whole digest lengths at a time instead of a modulo per byte, so the compiler can vectorize it.
+ */
+static void CodecXorBlock(char *block, const char digest[SHA1HashSize])
+{
+	for (int offset = 0; offset < BLOCKSIZE; offset += SHA1HashSize) {
+		const int len = std::min(SHA1HashSize, BLOCKSIZE - offset);
+		for (int j = 0; j < len; j++)
+			block[offset + j] ^= digest[j];
+	}
+}
+
 static void CodecInitKey(const char *pszPassword)
 {
 	char key[136]; // last 64 bytes are the SHA1
@@ -70,9 +90,7 @@ std::size_t codec_decode(byte *pbSrcDst, std::size_t size, const char *pszPasswo
 	for (i = size; i != 0; pbSrcDst += BLOCKSIZE, i -= BLOCKSIZE) {
 		memcpy(buf, pbSrcDst, BLOCKSIZE);
 		SHA1Result(0, dst);
-		for (int j = 0; j < BLOCKSIZE; j++) {
-			buf[j] ^= dst[j % SHA1HashSize];
-		}
+		CodecXorBlock(buf, dst);
 		SHA1Calculate(0, buf, nullptr);
 		memset(dst, 0, sizeof(dst));
 		memcpy(pbSrcDst, buf, BLOCKSIZE);
@@ -98,6 +116,25 @@ error:
 	return 0;
 }
 
+bool codec_decode_first_block(byte *pbBlock, std::size_t size, const char *pszPassword)
+{
+	if (size < BLOCKSIZE + sizeof(CodecSignature) || (size - sizeof(CodecSignature)) % BLOCKSIZE != 0)
+		return false;
+
+	char buf[BLOCKSIZE];
+	char dst[SHA1HashSize];
+
+	CodecInitKey(pszPassword);
+	memcpy(buf, pbBlock, BLOCKSIZE);
+	SHA1Result(0, dst);
+	CodecXorBlock(buf, dst);
+	memcpy(pbBlock, buf, BLOCKSIZE);
+	memset(buf, 0, sizeof(buf));
+	memset(dst, 0, sizeof(dst));
+	SHA1Clear();
+	return true;
+}
+
 std::size_t codec_get_encoded_len(std::size_t dwSrcBytes)
 {
 	if (dwSrcBytes % BLOCKSIZE != 0)
@@ -105,20 +142,23 @@ std::size_t codec_get_encoded_len(std::size_t dwSrcBytes)
 	return dwSrcBytes + sizeof(CodecSignature);
 }
 
-void codec_encode(byte *pbSrcDst, std::size_t size, std::size_t size_64, const char *pszPassword)
+CodecEncoder::CodecEncoder(const char *pszPassword)
+{
+	CodecInitKey(pszPassword);
+}
+
+CodecEncoder::~CodecEncoder()
+{
+	SHA1Clear();
+}
+
+std::size_t CodecEncoder::Encode(byte *pbSrcDst, std::size_t size)
 {
 	char buf[128];
-	char tmp[SHA1HashSize];
 	char dst[SHA1HashSize];
 	DWORD chunk;
-	uint16_t last_chunk;
-	CodecSignature *sig;
+	std::size_t encoded = 0;
 
-	if (size_64 != codec_get_encoded_len(size))
-		app_fatal("Invalid encode parameters");
-	CodecInitKey(pszPassword);
-
-	last_chunk = 0;
 	while (size != 0) {
 		chunk = size < BLOCKSIZE ? size : BLOCKSIZE;
 		memcpy(buf, pbSrcDst, chunk);
@@ -126,23 +166,40 @@ void codec_encode(byte *pbSrcDst, std::size_t size, std::size_t size_64, const c
 			memset(buf + chunk, 0, BLOCKSIZE - chunk);
 		SHA1Result(0, dst);
 		SHA1Calculate(0, buf, nullptr);
-		for (int j = 0; j < BLOCKSIZE; j++) {
-			buf[j] ^= dst[j % SHA1HashSize];
-		}
+		CodecXorBlock(buf, dst);
 		memset(dst, 0, sizeof(dst));
 		memcpy(pbSrcDst, buf, BLOCKSIZE);
-		last_chunk = chunk;
+		lastChunkSize_ = chunk;
 		pbSrcDst += BLOCKSIZE;
+		encoded += BLOCKSIZE;
 		size -= chunk;
 	}
 	memset(buf, 0, sizeof(buf));
+
+	return encoded;
+}
+
+void CodecEncoder::Finish(byte *pbDst)
+{
+	char tmp[SHA1HashSize];
+	CodecSignature *sig;
+
 	SHA1Result(0, tmp);
-	sig = (CodecSignature *)pbSrcDst;
+	sig = (CodecSignature *)pbDst;
 	sig->error = 0;
 	sig->unused = 0;
 	sig->checksum = *(DWORD *)&tmp[0];
-	sig->last_chunk_size = last_chunk;
-	SHA1Clear();
+	sig->last_chunk_size = lastChunkSize_;
+}
+
+void codec_encode(byte *pbSrcDst, std::size_t size, std::size_t size_64, const char *pszPassword)
+{
+	if (size_64 != codec_get_encoded_len(size))
+		app_fatal("Invalid encode parameters");
+
+	CodecEncoder encoder(pszPassword);
+	const std::size_t encoded = encoder.Encode(pbSrcDst, size);
+	encoder.Finish(pbSrcDst + encoded);
 }
 
 } // namespace devilution
@@ -5,11 +5,50 @@
  */
 #pragma once
 
+#include <cstdint>
+
 #include "utils/stdcompat/cstddef.hpp"
 
 namespace devilution {
 
+/**
+ * @brief codec_encode for data that is produced a piece at a time.
+ *
+ * Uses the same SHA-1 contexts as codec_encode and codec_decode, so only one of them can be in use at a time.
+ */
+class CodecEncoder {
+public:
+	static constexpr std::size_t BlockSize = 64;
+	static constexpr std::size_t SignatureSize = 8;
+
+	explicit CodecEncoder(const char *pszPassword);
+	~CodecEncoder();
+
+	CodecEncoder(const CodecEncoder &) = delete;
+	CodecEncoder &operator=(const CodecEncoder &) = delete;
+
+	/**
+	 * @brief Encode the next piece of data in place.
+	 *
+	 * All pieces but the last must be a multiple of BlockSize long. The last one is padded to BlockSize, the buffer needs room for that.
+	 * @return Size of the encoded piece
+	 */
+	std::size_t Encode(byte *pbSrcDst, std::size_t size);
+
+	/** @brief Write the SignatureSize bytes that end the encoded data. */
+	void Finish(byte *pbDst);
+
+private:
+	uint8_t lastChunkSize_ = 0;
+};
+
 std::size_t codec_decode(byte *pbSrcDst, std::size_t size, const char *pszPassword);
+/**
+ * @brief Decode only the first CodecEncoder::BlockSize bytes of encoded data in place, without verifying its checksum.
+ * @param size Size of all of the encoded data
+ * @return false if the size isn't a valid encoded size
+ */
+bool codec_decode_first_block(byte *pbBlock, std::size_t size, const char *pszPassword);
 std::size_t codec_get_encoded_len(std::size_t dwSrcBytes);
 void codec_encode(byte *pbSrcDst, std::size_t size, std::size_t size_64, const char *pszPassword);
 
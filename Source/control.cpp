@@ -7,6 +7,7 @@
 
 #include <array>
 #include <cstddef>
+#include <vector>
 
 #include <fmt/format.h>
 
@@ -15,6 +16,7 @@
 #include "controls/keymapper.hpp"
 #include "cursor.h"
 #include "engine/render/cel_render.hpp"
+#include "engine/render/common_impl.h"
 #include "error.h"
 #include "gamemenu.h"
 #include "init.h"
@@ -45,6 +47,35 @@ std::optional<CelSprite> pSBkBtnCel;
 std::optional<CelSprite> pSBkIconCels;
 std::optional<CelSprite> pSpellBkCel;
 std::optional<CelSprite> pSpellCels;
+
+/**
+ * @brief A side panel rendered into its own buffer and only redrawn when the values it shows change
+ */
+struct CachedPanel {
+	CelOutputBuffer buffer;
+	std::vector<int> state;
+
+	/**
+	 * @brief Remembers the values the panel is about to show
+	 * @return true if they differ from the ones already rendered into the buffer
+	 */
+	bool Update(std::vector<int> &&newState)
+	{
+		if (!state.empty() && state == newState)
+			return false;
+		state = std::move(newState);
+		return true;
+	}
+
+	void Free()
+	{
+		buffer.Free();
+		state.clear();
+	}
+};
+
+CachedPanel chrPanelCache;
+CachedPanel spellBookCache;
 } // namespace
 
 BYTE sgbNextTalkSave;
@@ -674,6 +705,8 @@ void InitControlPan()
 	pBtmBuff = CelOutputBuffer::Alloc(PANEL_WIDTH, (PANEL_HEIGHT + 16) * (gbIsMultiplayer ? 2 : 1));
 	pManaBuff = CelOutputBuffer::Alloc(88, 88);
 	pLifeBuff = CelOutputBuffer::Alloc(88, 88);
+	chrPanelCache.buffer = CelOutputBuffer::Alloc(SPANEL_WIDTH, SPANEL_HEIGHT);
+	spellBookCache.buffer = CelOutputBuffer::Alloc(SPANEL_WIDTH, SPANEL_HEIGHT);
 
 	pChrPanel = LoadCel("Data\\Char.CEL", SPANEL_WIDTH);
 	if (!gbIsHellfire)
@@ -1083,6 +1116,8 @@ void FreeControlPan()
 	pBtmBuff.Free();
 	pManaBuff.Free();
 	pLifeBuff.Free();
+	chrPanelCache.Free();
+	spellBookCache.Free();
 	pChrPanel = std::nullopt;
 	pSpellCels = std::nullopt;
 	pPanelButtons = std::nullopt;
@@ -1181,7 +1216,7 @@ void DrawInfoBox(const CelOutputBuffer &out)
 		PrintInfo(out);
 }
 
-void DrawChr(const CelOutputBuffer &out)
+static void DrawChrPanel(const CelOutputBuffer &out)
 {
 	uint32_t style = UIS_SILVER;
 	char chrstr[64];
@@ -1349,11 +1384,6 @@ void DrawChr(const CelOutputBuffer &out)
 	sprintf(chrstr, "%i", myPlayer._pVitality);
 	DrawString(out, chrstr, { 143, 239, 30, 0 }, style | UIS_CENTER);
 
-	if (myPlayer._pStatPts > 0) {
-		if (CalcStatDiff(myPlayer) < myPlayer._pStatPts) {
-			myPlayer._pStatPts = CalcStatDiff(myPlayer);
-		}
-	}
 	if (myPlayer._pStatPts > 0) {
 		sprintf(chrstr, "%i", myPlayer._pStatPts);
 		DrawString(out, chrstr, { 95, 266, 31, 0 }, UIS_RED | UIS_CENTER);
@@ -1388,6 +1418,60 @@ void DrawChr(const CelOutputBuffer &out)
 	DrawString(out, chrstr, { 143, 332, 31, 0 }, style | UIS_CENTER);
 }
 
+void DrawChr(const CelOutputBuffer &out)
+{
+	auto &myPlayer = plr[myplr];
+
+	if (myPlayer._pStatPts > 0) {
+		if (CalcStatDiff(myPlayer) < myPlayer._pStatPts) {
+			myPlayer._pStatPts = CalcStatDiff(myPlayer);
+		}
+	}
+
+	std::vector<int> state {
+		myplr,
+		static_cast<int>(myPlayer._pClass),
+		myPlayer._pLevel,
+		myPlayer._pExperience,
+		myPlayer._pNextExper,
+		myPlayer._pGold,
+		myPlayer._pIAC,
+		myPlayer._pIBonusAC,
+		myPlayer._pIBonusToHit,
+		myPlayer._pIBonusDam,
+		myPlayer._pIBonusDamMod,
+		myPlayer._pIMinDam,
+		myPlayer._pIMaxDam,
+		myPlayer._pDamageMod,
+		myPlayer.InvBody[INVLOC_HAND_LEFT]._itype,
+		myPlayer._pMagResist,
+		myPlayer._pFireResist,
+		myPlayer._pLghtResist,
+		myPlayer._pBaseStr,
+		myPlayer._pBaseMag,
+		myPlayer._pBaseDex,
+		myPlayer._pBaseVit,
+		myPlayer._pStrength,
+		myPlayer._pMagic,
+		myPlayer._pDexterity,
+		myPlayer._pVitality,
+		myPlayer._pStatPts,
+		myPlayer._pMaxHPBase,
+		myPlayer._pMaxHP,
+		myPlayer._pHitPoints,
+		myPlayer._pMaxManaBase,
+		myPlayer._pMaxMana,
+		myPlayer._pMana,
+	};
+	for (bool buttonPressed : chrbtn)
+		state.push_back(buttonPressed ? 1 : 0);
+
+	if (chrPanelCache.Update(std::move(state)))
+		DrawChrPanel(chrPanelCache.buffer);
+
+	out.BlitFrom(chrPanelCache.buffer, { 0, 0, SPANEL_WIDTH, SPANEL_HEIGHT }, { 0, 0 });
+}
+
 void CheckLvlBtn()
 {
 	if (!lvlbtndown && MouseX >= 40 + PANEL_LEFT && MouseX <= 81 + PANEL_LEFT && MouseY >= -39 + PANEL_TOP && MouseY <= -17 + PANEL_TOP)
@@ -1557,20 +1641,24 @@ void DrawDurIcon(const CelOutputBuffer &out)
 
 void RedBack(const CelOutputBuffer &out)
 {
-	uint8_t *dst = out.begin();
 	uint8_t *tbl = &pLightTbl[4608];
-	for (int h = gnViewportHeight; h != 0; h--, dst += out.pitch() - gnScreenWidth) {
-		for (int w = gnScreenWidth; w != 0; w--) {
-			if (leveltype != DTYPE_HELL || *dst >= 32)
-				*dst = tbl[*dst];
-			dst++;
-		}
+
+	// Hell keeps its first 32 colors (the lava cycle), so fold that into the table
+	std::array<uint8_t, 256> hellTbl;
+	if (leveltype == DTYPE_HELL) {
+		for (int i = 0; i < 256; i++)
+			hellTbl[i] = i >= 32 ? tbl[i] : static_cast<uint8_t>(i);
+		tbl = hellTbl.data();
 	}
+
+	uint8_t *dst = out.begin();
+	for (int h = gnViewportHeight; h != 0; h--, dst += out.pitch())
+		RemapBytes(dst, dst, gnScreenWidth, tbl);
 }
 
 static void PrintSBookStr(const CelOutputBuffer &out, Point position, const char *text)
 {
-	DrawString(out, text, { RIGHT_PANEL_X + SPLICONLENGTH + position.x, position.y, 222, 0 }, UIS_SILVER);
+	DrawString(out, text, { SPLICONLENGTH + position.x, position.y, 222, 0 }, UIS_SILVER);
 }
 
 spell_type GetSBookTrans(spell_id ii, bool townok)
@@ -1600,14 +1688,17 @@ spell_type GetSBookTrans(spell_id ii, bool townok)
 	return st;
 }
 
-void DrawSpellBook(const CelOutputBuffer &out)
+/**
+ * @brief Renders the spell book with its left edge at the given x coordinate of the buffer
+ */
+static void DrawSpellBookPanel(const CelOutputBuffer &out, int panelX)
 {
-	CelDrawTo(out, { RIGHT_PANEL_X, 351 }, *pSpellBkCel, 1);
+	CelDrawTo(out, { panelX, 351 }, *pSpellBkCel, 1);
 	if (gbIsHellfire && sbooktab < 5) {
-		CelDrawTo(out, { RIGHT_PANEL_X + 61 * sbooktab + 7, 348 }, *pSBkBtnCel, sbooktab + 1);
+		CelDrawTo(out, { panelX + 61 * sbooktab + 7, 348 }, *pSBkBtnCel, sbooktab + 1);
 	} else {
 		// BUGFIX: rendering of page 3 and page 4 buttons are both off-by-one pixel (fixed).
-		int sx = RIGHT_PANEL_X + 76 * sbooktab + 7;
+		int sx = panelX + 76 * sbooktab + 7;
 		if (sbooktab == 2 || sbooktab == 3) {
 			sx++;
 		}
@@ -1622,13 +1713,13 @@ void DrawSpellBook(const CelOutputBuffer &out)
 		if (sn != SPL_INVALID && (spl & GetSpellBitmask(sn)) != 0) {
 			spell_type st = GetSBookTrans(sn, true);
 			SetSpellTrans(st);
-			const Point spellCellPosition { RIGHT_PANEL_X + 11, yp };
+			const Point spellCellPosition { panelX + 11, yp };
 			DrawSpellCel(out, spellCellPosition, *pSBkIconCels, SpellITbl[sn]);
 			if (sn == myPlayer._pRSpell && st == myPlayer._pRSplType) {
 				SetSpellTrans(RSPLTYPE_SKILL);
 				DrawSpellCel(out, spellCellPosition, *pSBkIconCels, SPLICONLAST);
 			}
-			PrintSBookStr(out, { 10, yp - 23 }, _(spelldata[sn].sNameText));
+			PrintSBookStr(out, { panelX + 10, yp - 23 }, _(spelldata[sn].sNameText));
 			switch (GetSBookTrans(sn, false)) {
 			case RSPLTYPE_SKILL:
 				strcpy(tempstr, _("Skill"));
@@ -1650,7 +1741,7 @@ void DrawSpellBook(const CelOutputBuffer &out)
 				if (sn == SPL_BONESPIRIT) {
 					strcpy(tempstr, fmt::format(_(/* TRANSLATORS: Dam refers to damage. UI constrains, keep short please.*/ "Mana: {:d}  Dam: 1/3 tgt hp"), mana).c_str());
 				}
-				PrintSBookStr(out, { 10, yp - 1 }, tempstr);
+				PrintSBookStr(out, { panelX + 10, yp - 1 }, tempstr);
 				int lvl = myPlayer._pSplLvl[sn] + myPlayer._pISplLvlAdd;
 				if (lvl < 0) {
 					lvl = 0;
@@ -1662,12 +1753,50 @@ void DrawSpellBook(const CelOutputBuffer &out)
 				}
 			} break;
 			}
-			PrintSBookStr(out, { 10, yp - 12 }, tempstr);
+			PrintSBookStr(out, { panelX + 10, yp - 12 }, tempstr);
 		}
 		yp += 43;
 	}
 }
 
+void DrawSpellBook(const CelOutputBuffer &out)
+{
+	auto &myPlayer = plr[myplr];
+	uint64_t spl = myPlayer._pMemSpells | myPlayer._pISpells | myPlayer._pAblSpells;
+
+	std::vector<int> state {
+		myplr,
+		sbooktab,
+		myPlayer._pRSpell,
+		myPlayer._pRSplType,
+		myPlayer.InvBody[INVLOC_HAND_LEFT]._iCharges,
+	};
+	for (int i = 1; i < 8; i++) {
+		spell_id sn = SpellPages[sbooktab][i - 1];
+		if (sn == SPL_INVALID || (spl & GetSpellBitmask(sn)) == 0) {
+			state.push_back(SPL_INVALID);
+			continue;
+		}
+		int min;
+		int max;
+		GetDamageAmt(sn, &min, &max);
+		state.insert(state.end(), {
+		                              sn,
+		                              GetSBookTrans(sn, true),
+		                              GetSBookTrans(sn, false),
+		                              GetManaAmount(myplr, sn),
+		                              min,
+		                              max,
+		                              myPlayer._pSplLvl[sn] + myPlayer._pISplLvlAdd,
+		                          });
+	}
+
+	if (spellBookCache.Update(std::move(state)))
+		DrawSpellBookPanel(spellBookCache.buffer, 0);
+
+	out.BlitFrom(spellBookCache.buffer, { 0, 0, SPANEL_WIDTH, SPANEL_HEIGHT }, { RIGHT_PANEL_X, 0 });
+}
+
 void CheckSBook()
 {
 	if (MouseX >= RIGHT_PANEL + 11 && MouseX < RIGHT_PANEL + 48 && MouseY >= 18 && MouseY < 314) {
@@ -2,7 +2,7 @@
 
 #include <algorithm>
 #include <cstdint>
-#include <list>
+#include <vector>
 
 #include "automap.h"
 #include "control.h"
@@ -238,42 +238,47 @@ void FindRangedTarget()
 
 void FindMeleeTarget()
 {
-	bool visited[MAXDUNX][MAXDUNY] = { {} };
-	int maxSteps = 25; // Max steps for FindPath is 25
-	int rotations = 0;
-	bool canTalk = false;
-
 	struct SearchNode {
 		int x, y;
 		int steps;
 	};
-	std::list<SearchNode> queue;
+
+	// Tiles count as visited when they carry the id of the current search, so the grid never needs clearing
+	static uint32_t visited[MAXDUNX][MAXDUNY];
+	static uint32_t searchId = 0;
+	static std::vector<SearchNode> queue;
+
+	int maxSteps = 25; // Max steps for FindPath is 25
+	int rotations = 0;
+	bool canTalk = false;
+
+	searchId++;
+	queue.clear();
 
 	{
 		const int startX = plr[myplr].position.future.x;
 		const int startY = plr[myplr].position.future.y;
-		visited[startX][startY] = true;
+		visited[startX][startY] = searchId;
 		queue.push_back({ startX, startY, 0 });
 	}
 
-	while (!queue.empty()) {
-		SearchNode node = queue.front();
-		queue.pop_front();
+	for (size_t head = 0; head < queue.size(); head++) {
+		const SearchNode node = queue[head];
 
 		for (int i = 0; i < 8; i++) {
 			const int dx = node.x + pathxdir[i];
 			const int dy = node.y + pathydir[i];
 
-			if (visited[dx][dy])
+			if (visited[dx][dy] == searchId)
 				continue; // already visisted
 
 			if (node.steps > maxSteps) {
-				visited[dx][dy] = true;
+				visited[dx][dy] = searchId;
 				continue;
 			}
 
 			if (!PosOkPlayer(myplr, { dx, dy })) {
-				visited[dx][dy] = true;
+				visited[dx][dy] = searchId;
 
 				if (dMonster[dx][dy] != 0) {
 					const int mi = dMonster[dx][dy] > 0 ? dMonster[dx][dy] - 1 : -(dMonster[dx][dy] + 1);
@@ -300,7 +305,7 @@ void FindMeleeTarget()
 
 			if (path_solid_pieces(&pPath, dx, dy)) {
 				queue.push_back({ dx, dy, node.steps + 1 });
-				visited[dx][dy] = true;
+				visited[dx][dy] = searchId;
 			}
 		}
 	}
@@ -433,7 +438,10 @@ void FindTrigger()
 			}
 		}
 	}
+}
 
+void UpdateTriggerInfo()
+{
 	if (pcursmonst != -1 || pcursplr != -1 || cursmx == -1 || cursmy == -1)
 		return; // Prefer monster/player info text
 
@@ -442,6 +450,89 @@ void FindTrigger()
 	CheckRportal();
 }
 
+/**
+ * @brief Targets picked by the last search, kept until the next game tick
+ *
+ * Monsters, items and players only move during game logic, so between ticks the
+ * search would find the same targets on every frame. The key covers the player
+ * state that can change from input alone (e.g. switching spells).
+ */
+struct TargetCache {
+	bool valid = false;
+	int level;
+	bool isSetLevel;
+	Point position;
+	int direction;
+	int weaponType;
+	int spell;
+	bool friendlyMode;
+
+	int monster;
+	int player;
+	int item;
+	int object;
+	int missile;
+	int trigger;
+	int quest;
+	int x;
+	int y;
+};
+
+TargetCache targetCache;
+
+bool IsTargetCacheValid()
+{
+	const auto &myPlayer = plr[myplr];
+
+	return targetCache.valid
+	    && targetCache.level == currlevel
+	    && targetCache.isSetLevel == setlevel
+	    && targetCache.position == myPlayer.position.future
+	    && targetCache.direction == myPlayer._pdir
+	    && targetCache.weaponType == myPlayer._pwtype
+	    && targetCache.spell == myPlayer._pRSpell
+	    && targetCache.friendlyMode == gbFriendlyMode;
+}
+
+void FindTargets()
+{
+	if (IsTargetCacheValid()) {
+		pcursmonst = targetCache.monster;
+		pcursplr = targetCache.player;
+		pcursitem = targetCache.item;
+		pcursobj = targetCache.object;
+		pcursmissile = targetCache.missile;
+		pcurstrig = targetCache.trigger;
+		pcursquest = targetCache.quest;
+		cursmx = targetCache.x;
+		cursmy = targetCache.y;
+		return;
+	}
+
+	FindActor();
+	FindItemOrObject();
+	FindTrigger();
+
+	const auto &myPlayer = plr[myplr];
+	targetCache.valid = true;
+	targetCache.level = currlevel;
+	targetCache.isSetLevel = setlevel;
+	targetCache.position = myPlayer.position.future;
+	targetCache.direction = myPlayer._pdir;
+	targetCache.weaponType = myPlayer._pwtype;
+	targetCache.spell = myPlayer._pRSpell;
+	targetCache.friendlyMode = gbFriendlyMode;
+	targetCache.monster = pcursmonst;
+	targetCache.player = pcursplr;
+	targetCache.item = pcursitem;
+	targetCache.object = pcursobj;
+	targetCache.missile = pcursmissile;
+	targetCache.trigger = pcurstrig;
+	targetCache.quest = pcursquest;
+	targetCache.x = cursmx;
+	targetCache.y = cursmy;
+}
+
 void Interact()
 {
 	if (leveltype == DTYPE_TOWN && pcursmonst != -1) {
@@ -1345,9 +1436,8 @@ void plrctrls_after_check_curs_move()
 		if (!invflag) {
 			*infostr = '\0';
 			ClearPanel();
-			FindActor();
-			FindItemOrObject();
-			FindTrigger();
+			FindTargets();
+			UpdateTriggerInfo();
 		}
 	}
 }
@@ -1360,6 +1450,7 @@ void plrctrls_every_frame()
 
 void plrctrls_after_game_logic()
 {
+	targetCache.valid = false;
 	Movement(myplr);
 }
 
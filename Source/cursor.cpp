@@ -211,6 +211,66 @@ void InitLevelCursor()
 	ClearCursor();
 }
 
+namespace {
+
+/**
+ * @brief A cell around the cursor where a monster can be selected.
+ *
+ * Large monsters are drawn over the cells in front of them, so those are probed too; the last
+ * matching probe wins.
+ */
+struct MonsterProbe {
+	int dx;
+	int dy;
+	/** 0: always, 1: only when flipflag isn't set, 2: only when it is */
+	int flip;
+	/** Bit of MonsterData::mSelFlag the monster needs to be selectable from this cell */
+	int selFlag;
+};
+
+constexpr MonsterProbe MonsterProbes[] = {
+	{ 2, 1, 1, 4 },
+	{ 1, 2, 2, 4 },
+	{ 2, 2, 0, 4 },
+	{ 1, 0, 1, 2 },
+	{ 0, 1, 2, 2 },
+	{ 0, 0, 0, 1 },
+	{ 1, 1, 0, 2 },
+};
+
+struct HoveredMonster {
+	int monster = -1;
+	Point monsterPosition;
+	/** The last match of the monster hovered in the previous frame */
+	int previousMonster = -1;
+	Point previousMonsterPosition;
+};
+
+HoveredMonster FindHoveredMonster(int mx, int my, bool flipflag, int previousMonster)
+{
+	HoveredMonster hovered;
+	for (const auto &probe : MonsterProbes) {
+		if ((probe.flip == 1 && flipflag) || (probe.flip == 2 && !flipflag))
+			continue;
+		int x = mx + probe.dx;
+		int y = my + probe.dy;
+		if (x >= MAXDUNX || y >= MAXDUNY || dMonster[x][y] == 0 || (dFlags[x][y] & BFLAG_LIT) == 0)
+			continue;
+		int mi = dMonster[x][y] > 0 ? dMonster[x][y] - 1 : -(dMonster[x][y] + 1);
+		if (monster[mi]._mhitpoints >> 6 <= 0 || (monster[mi].MData->mSelFlag & probe.selFlag) == 0)
+			continue;
+		hovered.monster = mi;
+		hovered.monsterPosition = { x, y };
+		if (mi == previousMonster) {
+			hovered.previousMonster = mi;
+			hovered.previousMonsterPosition = { x, y };
+		}
+	}
+	return hovered;
+}
+
+} // namespace
+
 void CheckTown()
 {
 	int i, mx;
@@ -268,7 +328,7 @@ void CheckRportal()
 
 void CheckCursMove()
 {
-	int i, sx, sy, fx, fy, mx, my, tx, ty, px, py, xx, yy, mi, columns, rows, xo, yo;
+	int i, sx, sy, fx, fy, mx, my, tx, ty, px, py, xx, yy;
 	int8_t bv;
 	bool flipflag, flipx, flipy;
 
@@ -303,13 +363,12 @@ void CheckCursMove()
 	}
 
 	// Adjust by player offset and tile grid alignment
-	CalcTileOffset(&xo, &yo);
 	const auto &myPlayer = plr[myplr];
 	Point offset = ScrollInfo.offset;
 	if (myPlayer.IsWalking())
 		offset = GetOffsetForWalking(myPlayer.AnimInfo, myPlayer._pdir, true);
-	sx -= offset.x - xo;
-	sy -= offset.y - yo;
+	sx -= offset.x - cursorPixelShiftX;
+	sy -= offset.y - cursorPixelShiftY;
 
 	// Predict the next frame when walking to avoid input jitter
 	fx = myPlayer.position.offset2.x / 256;
@@ -321,28 +380,9 @@ void CheckCursMove()
 		sy -= fy;
 	}
 
-	// Convert to tile grid
-	mx = ViewX;
-	my = ViewY;
-
-	TilesInView(&columns, &rows);
-	int lrow = rows - RowsCoveredByPanel();
-
-	// Center player tile on screen
-	ShiftGrid(&mx, &my, -columns / 2, -lrow / 2);
-
-	// Align grid
-	if ((columns & 1) == 0 && (lrow & 1) == 0) {
-		sy += TILE_HEIGHT / 2;
-	} else if (columns & 1 && lrow & 1) {
-		sx -= TILE_WIDTH / 2;
-	} else if (columns & 1 && (lrow & 1) == 0) {
-		my++;
-	}
-
-	if (!zoomflag) {
-		sy -= TILE_HEIGHT / 4;
-	}
+	// Convert to tile grid, centered on the player and aligned by CalcViewportGeometry
+	mx = ViewX + cursorTileShiftX;
+	my = ViewY + cursorTileShiftY;
 
 	tx = sx / TILE_WIDTH;
 	ty = sy / TILE_HEIGHT;
@@ -417,62 +457,13 @@ void CheckCursMove()
 	}
 
 	if (leveltype != DTYPE_TOWN) {
+		// Both the monster hovered last frame and any other monster are looked for in one pass
+		HoveredMonster hovered = FindHoveredMonster(mx, my, flipflag, pcurstemp);
 		if (pcurstemp != -1) {
-			if (!flipflag && mx + 2 < MAXDUNX && my + 1 < MAXDUNY && dMonster[mx + 2][my + 1] != 0 && dFlags[mx + 2][my + 1] & BFLAG_LIT) {
-				mi = dMonster[mx + 2][my + 1] > 0 ? dMonster[mx + 2][my + 1] - 1 : -(dMonster[mx + 2][my + 1] + 1);
-				if (mi == pcurstemp && monster[mi]._mhitpoints >> 6 > 0 && monster[mi].MData->mSelFlag & 4) {
-					cursmx = mx + 2; /// BUGFIX: 'mx + 2' (fixed)
-					cursmy = my + 1; /// BUGFIX: 'my + 1' (fixed)
-					pcursmonst = mi;
-				}
-			}
-			if (flipflag && mx + 1 < MAXDUNX && my + 2 < MAXDUNY && dMonster[mx + 1][my + 2] != 0 && dFlags[mx + 1][my + 2] & BFLAG_LIT) {
-				mi = dMonster[mx + 1][my + 2] > 0 ? dMonster[mx + 1][my + 2] - 1 : -(dMonster[mx + 1][my + 2] + 1);
-				if (mi == pcurstemp && monster[mi]._mhitpoints >> 6 > 0 && monster[mi].MData->mSelFlag & 4) {
-					cursmx = mx + 1;
-					cursmy = my + 2;
-					pcursmonst = mi;
-				}
-			}
-			if (mx + 2 < MAXDUNX && my + 2 < MAXDUNY && dMonster[mx + 2][my + 2] != 0 && dFlags[mx + 2][my + 2] & BFLAG_LIT) {
-				mi = dMonster[mx + 2][my + 2] > 0 ? dMonster[mx + 2][my + 2] - 1 : -(dMonster[mx + 2][my + 2] + 1);
-				if (mi == pcurstemp && monster[mi]._mhitpoints >> 6 > 0 && monster[mi].MData->mSelFlag & 4) {
-					cursmx = mx + 2;
-					cursmy = my + 2;
-					pcursmonst = mi;
-				}
-			}
-			if (mx + 1 < MAXDUNX && !flipflag && dMonster[mx + 1][my] != 0 && dFlags[mx + 1][my] & BFLAG_LIT) {
-				mi = dMonster[mx + 1][my] > 0 ? dMonster[mx + 1][my] - 1 : -(dMonster[mx + 1][my] + 1);
-				if (mi == pcurstemp && monster[mi]._mhitpoints >> 6 > 0 && monster[mi].MData->mSelFlag & 2) {
-					cursmx = mx + 1;
-					cursmy = my;
-					pcursmonst = mi;
-				}
-			}
-			if (my + 1 < MAXDUNY && flipflag && dMonster[mx][my + 1] != 0 && dFlags[mx][my + 1] & BFLAG_LIT) {
-				mi = dMonster[mx][my + 1] > 0 ? dMonster[mx][my + 1] - 1 : -(dMonster[mx][my + 1] + 1);
-				if (mi == pcurstemp && monster[mi]._mhitpoints >> 6 > 0 && monster[mi].MData->mSelFlag & 2) {
-					cursmx = mx;
-					cursmy = my + 1;
-					pcursmonst = mi;
-				}
-			}
-			if (dMonster[mx][my] != 0 && dFlags[mx][my] & BFLAG_LIT) {
-				mi = dMonster[mx][my] > 0 ? dMonster[mx][my] - 1 : -(dMonster[mx][my] + 1);
-				if (mi == pcurstemp && monster[mi]._mhitpoints >> 6 > 0 && monster[mi].MData->mSelFlag & 1) {
-					cursmx = mx;
-					cursmy = my;
-					pcursmonst = mi;
-				}
-			}
-			if (mx + 1 < MAXDUNX && my + 1 < MAXDUNY && dMonster[mx + 1][my + 1] != 0 && dFlags[mx + 1][my + 1] & BFLAG_LIT) {
-				mi = dMonster[mx + 1][my + 1] > 0 ? dMonster[mx + 1][my + 1] - 1 : -(dMonster[mx + 1][my + 1] + 1);
-				if (mi == pcurstemp && monster[mi]._mhitpoints >> 6 > 0 && monster[mi].MData->mSelFlag & 2) {
-					cursmx = mx + 1;
-					cursmy = my + 1;
-					pcursmonst = mi;
-				}
+			if (hovered.previousMonster != -1) {
+				cursmx = hovered.previousMonsterPosition.x;
+				cursmy = hovered.previousMonsterPosition.y;
+				pcursmonst = hovered.previousMonster;
 			}
 			if (pcursmonst != -1 && monster[pcursmonst]._mFlags & MFLAG_HIDDEN) {
 				pcursmonst = -1;
@@ -486,61 +477,10 @@ void CheckCursMove()
 				return;
 			}
 		}
-		if (!flipflag && mx + 2 < MAXDUNX && my + 1 < MAXDUNY && dMonster[mx + 2][my + 1] != 0 && dFlags[mx + 2][my + 1] & BFLAG_LIT) {
-			mi = dMonster[mx + 2][my + 1] > 0 ? dMonster[mx + 2][my + 1] - 1 : -(dMonster[mx + 2][my + 1] + 1);
-			if (monster[mi]._mhitpoints >> 6 > 0 && monster[mi].MData->mSelFlag & 4) {
-				cursmx = mx + 2;
-				cursmy = my + 1;
-				pcursmonst = mi;
-			}
-		}
-		if (flipflag && mx + 1 < MAXDUNX && my + 2 < MAXDUNY && dMonster[mx + 1][my + 2] != 0 && dFlags[mx + 1][my + 2] & BFLAG_LIT) {
-			mi = dMonster[mx + 1][my + 2] > 0 ? dMonster[mx + 1][my + 2] - 1 : -(dMonster[mx + 1][my + 2] + 1);
-			if (monster[mi]._mhitpoints >> 6 > 0 && monster[mi].MData->mSelFlag & 4) {
-				cursmx = mx + 1;
-				cursmy = my + 2;
-				pcursmonst = mi;
-			}
-		}
-		if (mx + 2 < MAXDUNX && my + 2 < MAXDUNY && dMonster[mx + 2][my + 2] != 0 && dFlags[mx + 2][my + 2] & BFLAG_LIT) {
-			mi = dMonster[mx + 2][my + 2] > 0 ? dMonster[mx + 2][my + 2] - 1 : -(dMonster[mx + 2][my + 2] + 1);
-			if (monster[mi]._mhitpoints >> 6 > 0 && monster[mi].MData->mSelFlag & 4) {
-				cursmx = mx + 2;
-				cursmy = my + 2;
-				pcursmonst = mi;
-			}
-		}
-		if (!flipflag && mx + 1 < MAXDUNX && dMonster[mx + 1][my] != 0 && dFlags[mx + 1][my] & BFLAG_LIT) {
-			mi = dMonster[mx + 1][my] > 0 ? dMonster[mx + 1][my] - 1 : -(dMonster[mx + 1][my] + 1);
-			if (monster[mi]._mhitpoints >> 6 > 0 && monster[mi].MData->mSelFlag & 2) {
-				cursmx = mx + 1;
-				cursmy = my;
-				pcursmonst = mi;
-			}
-		}
-		if (flipflag && my + 1 < MAXDUNY && dMonster[mx][my + 1] != 0 && dFlags[mx][my + 1] & BFLAG_LIT) {
-			mi = dMonster[mx][my + 1] > 0 ? dMonster[mx][my + 1] - 1 : -(dMonster[mx][my + 1] + 1);
-			if (monster[mi]._mhitpoints >> 6 > 0 && monster[mi].MData->mSelFlag & 2) {
-				cursmx = mx;
-				cursmy = my + 1;
-				pcursmonst = mi;
-			}
-		}
-		if (dMonster[mx][my] != 0 && dFlags[mx][my] & BFLAG_LIT) {
-			mi = dMonster[mx][my] > 0 ? dMonster[mx][my] - 1 : -(dMonster[mx][my] + 1);
-			if (monster[mi]._mhitpoints >> 6 > 0 && monster[mi].MData->mSelFlag & 1) {
-				cursmx = mx;
-				cursmy = my;
-				pcursmonst = mi;
-			}
-		}
-		if (mx + 1 < MAXDUNX && my + 1 < MAXDUNY && dMonster[mx + 1][my + 1] != 0 && dFlags[mx + 1][my + 1] & BFLAG_LIT) {
-			mi = dMonster[mx + 1][my + 1] > 0 ? dMonster[mx + 1][my + 1] - 1 : -(dMonster[mx + 1][my + 1] + 1);
-			if (monster[mi]._mhitpoints >> 6 > 0 && monster[mi].MData->mSelFlag & 2) {
-				cursmx = mx + 1;
-				cursmy = my + 1;
-				pcursmonst = mi;
-			}
+		if (hovered.monster != -1) {
+			cursmx = hovered.monsterPosition.x;
+			cursmy = hovered.monsterPosition.y;
+			pcursmonst = hovered.monster;
 		}
 		if (pcursmonst != -1 && monster[pcursmonst]._mFlags & MFLAG_HIDDEN) {
 			pcursmonst = -1;
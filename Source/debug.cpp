@@ -232,6 +232,52 @@ void NextDebugMonster()
 	sprintf(dstr, "Current debug monster = %i", dbgmon);
 	NetSendCmdString(1 << myplr, dstr);
 }
+
+/**
+ * @brief FNV-1a step, folds one value into the running hash
+ */
+static void HashDebugState(uint32_t &hash, uint32_t value)
+{
+	for (int i = 0; i < 4; i++) {
+		hash ^= (value >> (i * 8)) & 0xFF;
+		hash *= 16777619;
+	}
+}
+
+/**
+ * @brief Prints hashes of the monsters and floor items of the current level, for players to compare by hand
+ *
+ * This is a manual diagnostic only. The hashes are not exchanged in TPktHdr and a mismatch triggers no resync:
+ * monsters are not simulated in lockstep, so the hashes of two clients on the same level can legitimately differ.
+ */
+void PrintDebugStateHash()
+{
+	char dstr[128];
+
+	uint32_t monsterHash = 2166136261;
+	for (int i = 0; i < nummonsters; i++) {
+		const auto &monst = monster[monstactive[i]];
+		HashDebugState(monsterHash, monstactive[i]);
+		HashDebugState(monsterHash, monst.position.tile.x);
+		HashDebugState(monsterHash, monst.position.tile.y);
+		HashDebugState(monsterHash, monst._mhitpoints);
+		HashDebugState(monsterHash, monst._mmode);
+	}
+
+	uint32_t itemHash = 2166136261;
+	for (int i = 0; i < numitems; i++) {
+		const auto &item = items[itemactive[i]];
+		HashDebugState(itemHash, item.position.x);
+		HashDebugState(itemHash, item.position.y);
+		HashDebugState(itemHash, item.IDidx);
+		HashDebugState(itemHash, item._iSeed);
+	}
+
+	sprintf(dstr, "Lvl %i : Monsters = %i, %08X", currlevel, nummonsters, monsterHash);
+	NetSendCmdString(1 << myplr, dstr);
+	sprintf(dstr, "  Items = %i, %08X : Rng = %08X", numitems, itemHash, GetLCGEngineState());
+	NetSendCmdString(1 << myplr, dstr);
+}
 #endif
 
 } // namespace devilution
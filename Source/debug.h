@@ -24,5 +24,6 @@ void PrintDebugPlayer(bool bNextPlayer);
 void PrintDebugQuest();
 void GetDebugMonster();
 void NextDebugMonster();
+void PrintDebugStateHash();
 
 } // namespace devilution
@@ -4,6 +4,8 @@
  * Implementation of the main game initialization functions.
  */
 #include <array>
+#include <string>
+#include <utility>
 
 #include <fmt/format.h>
 
@@ -25,11 +27,16 @@
 #include "drlg_l4.h"
 #include "dx.h"
 #include "encrypt.h"
+#include "engine/render/cl2_render.hpp"
+#include "engine/render/dun_render.hpp"
+#include "engine/render/outline_cache.hpp"
 #include "error.h"
+#include "flowfield.h"
 #include "gamemenu.h"
 #include "gmenu.h"
 #include "help.h"
 #include "init.h"
+#include "levelcache.h"
 #include "lighting.h"
 #include "loadsave.h"
 #include "mainmenu.h"
@@ -44,6 +51,7 @@
 #include "plrmsg.h"
 #include "qol/common.h"
 #include "qol/itemlabels.h"
+#include "replay.h"
 #include "restrict.h"
 #include "setmaps.h"
 #include "stores.h"
@@ -54,14 +62,23 @@
 #include "track.h"
 #include "trigs.h"
 #include "utils/console.h"
+#include "utils/file_prefetch.h"
 #include "utils/language.h"
+#include "utils/level_arena.h"
+#include "utils/log.hpp"
+#include "utils/memory_stats.h"
 #include "utils/paths.h"
+#include "utils/profiler.h"
+#include "utils/simd.h"
 #include "utils/language.h"
 #include "controls/keymapper.hpp"
 
 #ifndef NOSOUND
 #include "sound.h"
 #endif
+#if !defined(NONET) && !defined(DISABLE_ZERO_TIER)
+#include "dvlnet/zerotier_native.h"
+#endif
 #ifdef GPERF_HEAP_FIRST_GAME_ITERATION
 #include <gperftools/heap-profiler.h>
 #endif
@@ -192,6 +209,7 @@ void initKeymapActions();
 	printInConsole("    %-20s %-30s\n", /* TRANSLATORS: Commandline Option */ "-f", _("Display frames per second"));
 	printInConsole("    %-20s %-30s\n", /* TRANSLATORS: Commandline Option */ "-x", _("Run in windowed mode"));
 	printInConsole("    %-20s %-30s\n", /* TRANSLATORS: Commandline Option */ "--verbose", _("Enable verbose logging"));
+	printInConsole("    %-20s %-30s\n", /* TRANSLATORS: Commandline Option */ "--record", _("Record the first level of a new game"));
 	printInConsole("    %-20s %-30s\n", /* TRANSLATORS: Commandline Option */ "--spawn", _("Force spawn mode even if diabdat.mpq is found"));
 	printInConsole("%s", _(/* TRANSLATORS: Commandline Option */ "\nHellfire options:\n"));
 	printInConsole("    %-20s %-30s\n", /* TRANSLATORS: Commandline Option */ "--diablo", _("Force diablo mode even if hellfire.mpq is found"));
@@ -248,6 +266,8 @@ static void diablo_parse_flags(int argc, char **argv)
 			gbNestArt = true;
 		} else if (strcasecmp("--vanilla", argv[i]) == 0) {
 			gbVanilla = true;
+		} else if (strcasecmp("--record", argv[i]) == 0) {
+			ReplaySetRecordPath(argv[++i]);
 		} else if (strcasecmp("--verbose", argv[i]) == 0) {
 			SDL_LogSetAllPriority(SDL_LOG_PRIORITY_VERBOSE);
 #ifdef _DEBUG
@@ -290,10 +310,30 @@ static void diablo_parse_flags(int argc, char **argv)
 	}
 }
 
+namespace {
+
+/** Graphics of the town, which are kept while the player is in the dungeon since it is the level that is entered the most */
+struct TownGfx {
+	bool isHellfire;
+	std::unique_ptr<byte[]> cels;
+	std::unique_ptr<MegaTile[]> megaTiles;
+	std::optional<CelSprite> specialCels;
+};
+
+std::optional<TownGfx> ResidentTownGfx;
+/** Specifies whether the loaded level graphics are those of the town */
+bool TownGfxLoaded;
+
+} // namespace
+
 void FreeGameMem()
 {
 	music_stop();
 
+	if (TownGfxLoaded && pDungeonCels != nullptr)
+		ResidentTownGfx = TownGfx { gbIsHellfire, std::move(pDungeonCels), std::move(pMegaTiles), std::move(pSpecialCels) };
+	TownGfxLoaded = false;
+
 	pDungeonCels = nullptr;
 	pMegaTiles = nullptr;
 	pLevelPieces = nullptr;
@@ -302,6 +342,7 @@ void FreeGameMem()
 	FreeMissiles();
 	FreeMonsters();
 	FreeObjectGFX();
+	FreeLevelMemory();
 	FreeMonsterSnd();
 	FreeTownerGFX();
 }
@@ -328,6 +369,8 @@ static void start_game(interface_mode uMsg)
 
 static void free_game()
 {
+	ReplayRecordEnd();
+
 	FreeQol();
 	FreeControlPan();
 	FreeInvGFX();
@@ -343,6 +386,9 @@ static void free_game()
 	FreeDebugGFX();
 #endif
 	FreeGameMem();
+	ClearMonsterSheetCache();
+	ResidentTownGfx = std::nullopt;
+	FreeTownerCels();
 }
 
 // Controller support: Actions to run after updating the cursor state.
@@ -507,6 +553,8 @@ static void SaveOptions()
 	setIniInt("Audio", "Channels", sgOptions.Audio.nChannels);
 	setIniInt("Audio", "Buffer Size", sgOptions.Audio.nBufferSize);
 	setIniInt("Audio", "Resampling Quality", sgOptions.Audio.nResamplingQuality);
+	setIniInt("Audio", "Sound Effect Cache Size", sgOptions.Audio.nSfxCacheSize);
+	setIniInt("Audio", "Resample On Load", sgOptions.Audio.bResampleOnLoad);
 	setIniInt("Graphics", "Width", sgOptions.Graphics.nWidth);
 	setIniInt("Graphics", "Height", sgOptions.Graphics.nHeight);
 #ifndef __vita__
@@ -518,15 +566,24 @@ static void SaveOptions()
 	setIniInt("Graphics", "Fit to Screen", sgOptions.Graphics.bFitToScreen);
 	setIniValue("Graphics", "Scaling Quality", sgOptions.Graphics.szScaleQuality);
 	setIniInt("Graphics", "Integer Scaling", sgOptions.Graphics.bIntegerScaling);
+	setIniInt("Graphics", "Sharp Scaling", sgOptions.Graphics.bSharpScaling);
+	setIniInt("Graphics", "Adaptive Scaling", sgOptions.Graphics.bAdaptiveScaling);
 	setIniInt("Graphics", "Vertical Sync", sgOptions.Graphics.bVSync);
 	setIniInt("Graphics", "Blended Transparency", sgOptions.Graphics.bBlendedTransparancy);
 	setIniInt("Graphics", "Gamma Correction", sgOptions.Graphics.nGammaCorrection);
 	setIniInt("Graphics", "Color Cycling", sgOptions.Graphics.bColorCycling);
 #ifndef USE_SDL1
 	setIniInt("Graphics", "Hardware Cursor", sgOptions.Graphics.bHardwareCursor);
+	setIniInt("Graphics", "Hardware UI", sgOptions.Graphics.bHardwareUi);
+	setIniInt("Graphics", "Paletted Present", sgOptions.Graphics.bPalettedPresent);
 #endif
 	setIniInt("Graphics", "FPS Limiter", sgOptions.Graphics.bFPSLimit);
 	setIniInt("Graphics", "Show FPS", sgOptions.Graphics.bShowFPS);
+	setIniInt("Graphics", "Tile Cache Size", sgOptions.Graphics.nTileCacheSize);
+	setIniInt("Graphics", "Lit Sprite Cache Size", sgOptions.Graphics.nLitSpriteCacheSize);
+	setIniInt("Graphics", "Monster Sprite Cache Size", sgOptions.Graphics.nMonsterSpriteCacheSize);
+	setIniInt("Graphics", "Incremental Redraw", sgOptions.Graphics.bIncrementalRedraw);
+	setIniInt("Graphics", "Render Threads", sgOptions.Graphics.nRenderThreads);
 
 	setIniInt("Game", "Speed", sgOptions.Gameplay.nTickRate);
 	setIniInt("Game", "Run in Town", sgOptions.Gameplay.bRunInTown);
@@ -548,10 +605,18 @@ static void SaveOptions()
 	setIniInt("Game", "Randomize Quests", sgOptions.Gameplay.bRandomizeQuests);
 	setIniInt("Game", "Show Monster Type", sgOptions.Gameplay.bShowMonsterType);
 	setIniInt("Game", "Disable Crippling Shrines", sgOptions.Gameplay.bDisableCripplingShrines);
+	setIniInt("Game", "Shared Monster Pathing", sgOptions.Gameplay.bSharedMonsterPathing);
+	setIniInt("Game", "Idle Monsters Sleep", sgOptions.Gameplay.bIdleMonstersSleep);
+	setIniInt("Game", "Compression Level", sgOptions.Gameplay.nCompressionLevel);
 
 	setIniValue("Network", "Bind Address", sgOptions.Network.szBindAddress);
 	setIniInt("Network", "Port", sgOptions.Network.nPort);
 	setIniValue("Network", "Previous Host", sgOptions.Network.szPreviousHost);
+	setIniInt("Network", "Batch Packets", sgOptions.Network.bBatchPackets);
+	setIniInt("Network", "Compress Packets", sgOptions.Network.bCompressPackets);
+	setIniInt("Network", "Split Packets By Level", sgOptions.Network.bSplitPacketsByLevel);
+	setIniInt("Network", "Show Stats", sgOptions.Network.bShowNetStats);
+	setIniInt("Network", "Start ZeroTier On Launch", sgOptions.Network.bStartZeroTierOnLaunch);
 
 	for (size_t i = 0; i < sizeof(spszMsgTbl) / sizeof(spszMsgTbl[0]); i++)
 		setIniValue("NetMsg", spszMsgNameTbl[i], sgOptions.Chat.szHotKeyMsgs[i]);
@@ -589,6 +654,8 @@ static void LoadOptions()
 	sgOptions.Audio.nChannels = getIniInt("Audio", "Channels", DEFAULT_AUDIO_CHANNELS);
 	sgOptions.Audio.nBufferSize = getIniInt("Audio", "Buffer Size", DEFAULT_AUDIO_BUFFER_SIZE);
 	sgOptions.Audio.nResamplingQuality = getIniInt("Audio", "Resampling Quality", DEFAULT_AUDIO_RESAMPLING_QUALITY);
+	sgOptions.Audio.nSfxCacheSize = getIniInt("Audio", "Sound Effect Cache Size", 16384);
+	sgOptions.Audio.bResampleOnLoad = getIniBool("Audio", "Resample On Load", true);
 
 	sgOptions.Graphics.nWidth = getIniInt("Graphics", "Width", DEFAULT_WIDTH);
 	sgOptions.Graphics.nHeight = getIniInt("Graphics", "Height", DEFAULT_HEIGHT);
@@ -605,17 +672,26 @@ static void LoadOptions()
 	sgOptions.Graphics.bFitToScreen = getIniBool("Graphics", "Fit to Screen", true);
 	getIniValue("Graphics", "Scaling Quality", sgOptions.Graphics.szScaleQuality, sizeof(sgOptions.Graphics.szScaleQuality), "2");
 	sgOptions.Graphics.bIntegerScaling = getIniBool("Graphics", "Integer Scaling", false);
+	sgOptions.Graphics.bSharpScaling = getIniBool("Graphics", "Sharp Scaling", false);
+	sgOptions.Graphics.bAdaptiveScaling = getIniBool("Graphics", "Adaptive Scaling", false);
 	sgOptions.Graphics.bVSync = getIniBool("Graphics", "Vertical Sync", true);
 	sgOptions.Graphics.bBlendedTransparancy = getIniBool("Graphics", "Blended Transparency", true);
 	sgOptions.Graphics.nGammaCorrection = getIniInt("Graphics", "Gamma Correction", 100);
 	sgOptions.Graphics.bColorCycling = getIniBool("Graphics", "Color Cycling", true);
 #ifndef USE_SDL1
 	sgOptions.Graphics.bHardwareCursor = getIniBool("Graphics", "Hardware Cursor", false);
+	sgOptions.Graphics.bHardwareUi = getIniBool("Graphics", "Hardware UI", false);
+	sgOptions.Graphics.bPalettedPresent = getIniBool("Graphics", "Paletted Present", true);
 #else
 	sgOptions.Graphics.bHardwareCursor = false;
 #endif
 	sgOptions.Graphics.bFPSLimit = getIniBool("Graphics", "FPS Limiter", true);
 	sgOptions.Graphics.bShowFPS = getIniInt("Graphics", "Show FPS", false);
+	sgOptions.Graphics.nTileCacheSize = getIniInt("Graphics", "Tile Cache Size", 2048);
+	sgOptions.Graphics.nLitSpriteCacheSize = getIniInt("Graphics", "Lit Sprite Cache Size", 1024);
+	sgOptions.Graphics.nMonsterSpriteCacheSize = getIniInt("Graphics", "Monster Sprite Cache Size", 24576);
+	sgOptions.Graphics.bIncrementalRedraw = getIniBool("Graphics", "Incremental Redraw", false);
+	sgOptions.Graphics.nRenderThreads = getIniInt("Graphics", "Render Threads", 1);
 
 	sgOptions.Gameplay.nTickRate = getIniInt("Game", "Speed", 20);
 	sgOptions.Gameplay.bRunInTown = getIniBool("Game", "Run in Town", false);
@@ -637,10 +713,19 @@ static void LoadOptions()
 	sgOptions.Gameplay.bRandomizeQuests = getIniBool("Game", "Randomize Quests", true);
 	sgOptions.Gameplay.bShowMonsterType = getIniBool("Game", "Show Monster Type", false);
 	sgOptions.Gameplay.bDisableCripplingShrines = getIniBool("Game", "Disable Crippling Shrines", false);
+	sgOptions.Gameplay.bSharedMonsterPathing = getIniBool("Game", "Shared Monster Pathing", false);
+	sgOptions.Gameplay.bIdleMonstersSleep = getIniBool("Game", "Idle Monsters Sleep", false);
+	sgOptions.Gameplay.nCompressionLevel = getIniInt("Game", "Compression Level", 3);
+	PkwareSetCompressionLevel(sgOptions.Gameplay.nCompressionLevel);
 
 	getIniValue("Network", "Bind Address", sgOptions.Network.szBindAddress, sizeof(sgOptions.Network.szBindAddress), "0.0.0.0");
 	sgOptions.Network.nPort = getIniInt("Network", "Port", 6112);
 	getIniValue("Network", "Previous Host", sgOptions.Network.szPreviousHost, sizeof(sgOptions.Network.szPreviousHost), "");
+	sgOptions.Network.bBatchPackets = getIniBool("Network", "Batch Packets", false);
+	sgOptions.Network.bCompressPackets = getIniBool("Network", "Compress Packets", false);
+	sgOptions.Network.bSplitPacketsByLevel = getIniBool("Network", "Split Packets By Level", false);
+	sgOptions.Network.bShowNetStats = getIniBool("Network", "Show Stats", false);
+	sgOptions.Network.bStartZeroTierOnLaunch = getIniBool("Network", "Start ZeroTier On Launch", false);
 
 	for (size_t i = 0; i < sizeof(spszMsgTbl) / sizeof(spszMsgTbl[0]); i++)
 		getIniValue("NetMsg", spszMsgNameTbl[i], sgOptions.Chat.szHotKeyMsgs[i], MAX_SEND_STR_LEN, "");
@@ -682,17 +767,67 @@ static void SetApplicationVersions()
 	strncpy(gszVersionNumber, fmt::format(_("version {:s}"), PROJECT_VERSION).c_str(), sizeof(gszVersionNumber) / sizeof(char));
 }
 
+namespace {
+
+/**
+ * @brief Logs how long each stage of a long running task, like starting up or loading a level, took
+ */
+class StageTimer {
+public:
+	explicit StageTimer(std::string task)
+	    : task_(std::move(task))
+	{
+	}
+
+	void EndStage(const char *name)
+	{
+		const uint32_t now = SDL_GetTicks();
+		LogVerbose("{}: {} took {} ms", task_, name, now - stageStart_);
+		stageStart_ = now;
+	}
+
+	void End()
+	{
+		LogVerbose("{} took {} ms", task_, SDL_GetTicks() - start_);
+	}
+
+private:
+	std::string task_;
+	uint32_t start_ = SDL_GetTicks();
+	uint32_t stageStart_ = start_;
+};
+
+} // namespace
+
 static void diablo_init()
 {
+	StageTimer timer("Starting up");
+	LogVerbose("Render kernels: {}", SimdName());
+
+#ifdef MEMORY_STATS
+	TrackStaticMemory(MemoryTag::DungeonGrids, sizeof(dungeon) + sizeof(pdungeon) + sizeof(dflags) + sizeof(dPiece) + sizeof(dPieceMicros)
+	        + sizeof(dTransVal) + sizeof(dLight) + sizeof(dPreLight) + sizeof(dFlags) + sizeof(dPlayer) + sizeof(dMonster) + sizeof(dDead)
+	        + sizeof(dObject) + sizeof(dItem) + sizeof(dMissile) + sizeof(dSpecial));
+	TrackStaticMemory(MemoryTag::MonsterArrays, sizeof(monster) + sizeof(Monsters) + sizeof(monstactive) + sizeof(monstkills));
+#endif
+
 	if (sgOptions.Graphics.bShowFPS)
 		EnableFrameCount();
 
+#if !defined(NONET) && !defined(DISABLE_ZERO_TIER)
+	// The node comes online on ZeroTier's own threads while the rest of the game starts up
+	if (sgOptions.Network.bStartZeroTierOnLaunch)
+		net::zerotier_network_start();
+#endif
+
 	init_create_window();
 	was_window_init = true;
+	timer.EndStage("window");
 
 	SFileEnableDirectAccess(true);
 	init_archives();
 	was_archives_init = true;
+	timer.EndStage("archives");
 
 	if (forceSpawn)
 		gbIsSpawn = true;
@@ -701,7 +836,11 @@ static void diablo_init()
 
 	gbIsHellfireSaveGame = gbIsHellfire;
 
+	// Read the item graphics on the prefetch thread while the rest starts up
+	PrefetchItemGFX();
+
 	LanguageInitialize();
+	timer.EndStage("language");
 
 	SetApplicationVersions();
 
@@ -715,6 +854,7 @@ static void diablo_init()
 	UiInitialize();
 	UiSetSpawned(gbIsSpawn);
 	was_ui_init = true;
+	timer.EndStage("menu graphics");
 
 	ReadOnlyTest();
 
@@ -728,9 +868,12 @@ static void diablo_init()
 #endif
 
 	ui_sound_init();
+	timer.EndStage("sound");
 
 	// Item graphics are loaded early, they already get touched during hero selection.
 	InitItemGFX();
+	timer.EndStage("item graphics");
+	timer.End();
 }
 
 static void diablo_splash()
@@ -1076,8 +1219,12 @@ static bool PressSysKey(int wParam)
 
 static void ReleaseKey(int vkey)
 {
-	if (vkey == DVL_VK_SNAPSHOT)
-		CaptureScreen();
+	if (vkey == DVL_VK_SNAPSHOT) {
+		if ((GetAsyncKeyState(DVL_VK_SHIFT) & 0x8000) != 0)
+			ToggleFrameDump();
+		else
+			CaptureScreen();
+	}
 	if (vkey == DVL_VK_MENU || vkey == DVL_VK_LMENU || vkey == DVL_VK_RMENU)
 		AltPressed(false);
 	if (vkey == DVL_VK_CONTROL || vkey == DVL_VK_LCONTROL || vkey == DVL_VK_RCONTROL)
@@ -1354,6 +1501,10 @@ static void PressChar(int32_t vkey)
 			ToggleLighting();
 		}
 		return;
+	case 'H':
+	case 'h':
+		PrintDebugStateHash();
+		return;
 	case 'M':
 		NextDebugMonster();
 		return;
@@ -1384,6 +1535,26 @@ static void PressChar(int32_t vkey)
 			GiveGoldCheat();
 		}
 		return;
+	case 'x':
+		SetProfilerEnabled(!IsProfilerEnabled());
+		return;
+	case 'X': {
+		std::string path = paths::PrefPath() + "profile.csv";
+		if (ProfilerWriteCsv(path) && ProfilerWriteChromeTrace(paths::PrefPath() + "profile.json"))
+			snprintf(tempstr, sizeof(tempstr), "Profile saved to %s", path.c_str());
+		else
+			strcpy(tempstr, "Failed to save profile");
+		NetSendCmdString(1 << myplr, tempstr);
+	}
+		return;
+#ifdef MEMORY_STATS
+	case 'y':
+		SetMemoryOverlayEnabled(!IsMemoryOverlayEnabled());
+		return;
+	case 'Y':
+		LogMemoryStats();
+		return;
+#endif
 #endif
 	}
 }
@@ -1523,66 +1694,104 @@ void GM_Game(uint32_t uMsg, int32_t wParam, int32_t lParam)
 	MainWndProc(uMsg);
 }
 
-void LoadLvlGFX()
-{
-	assert(pDungeonCels == nullptr);
-	constexpr int SpecialCelWidth = 64;
+namespace {
 
-	switch (leveltype) {
+struct LvlGfxFiles {
+	const char *cels;
+	const char *megaTiles;
+	const char *levelPieces;
+	const char *specialCels;
+};
+
+LvlGfxFiles GetLvlGfxFiles(dungeon_type type, int level)
+{
+	switch (type) {
 	case DTYPE_TOWN:
-		if (gbIsHellfire) {
-			pDungeonCels = LoadFileInMem("NLevels\\TownData\\Town.CEL");
-			pMegaTiles = LoadFileInMem<MegaTile>("NLevels\\TownData\\Town.TIL");
-			pLevelPieces = LoadFileInMem<uint16_t>("NLevels\\TownData\\Town.MIN");
-		} else {
-			pDungeonCels = LoadFileInMem("Levels\\TownData\\Town.CEL");
-			pMegaTiles = LoadFileInMem<MegaTile>("Levels\\TownData\\Town.TIL");
-			pLevelPieces = LoadFileInMem<uint16_t>("Levels\\TownData\\Town.MIN");
-		}
-		pSpecialCels = LoadCel("Levels\\TownData\\TownS.CEL", SpecialCelWidth);
-		break;
+		if (gbIsHellfire)
+			return { "NLevels\\TownData\\Town.CEL", "NLevels\\TownData\\Town.TIL", "NLevels\\TownData\\Town.MIN", "Levels\\TownData\\TownS.CEL" };
+		return { "Levels\\TownData\\Town.CEL", "Levels\\TownData\\Town.TIL", "Levels\\TownData\\Town.MIN", "Levels\\TownData\\TownS.CEL" };
 	case DTYPE_CATHEDRAL:
-		if (currlevel < 21) {
-			pDungeonCels = LoadFileInMem("Levels\\L1Data\\L1.CEL");
-			pMegaTiles = LoadFileInMem<MegaTile>("Levels\\L1Data\\L1.TIL");
-			pLevelPieces = LoadFileInMem<uint16_t>("Levels\\L1Data\\L1.MIN");
-			pSpecialCels = LoadCel("Levels\\L1Data\\L1S.CEL", SpecialCelWidth);
-		} else {
-			pDungeonCels = LoadFileInMem("NLevels\\L5Data\\L5.CEL");
-			pMegaTiles = LoadFileInMem<MegaTile>("NLevels\\L5Data\\L5.TIL");
-			pLevelPieces = LoadFileInMem<uint16_t>("NLevels\\L5Data\\L5.MIN");
-			pSpecialCels = LoadCel("NLevels\\L5Data\\L5S.CEL", SpecialCelWidth);
-		}
-		break;
+		if (level < 21)
+			return { "Levels\\L1Data\\L1.CEL", "Levels\\L1Data\\L1.TIL", "Levels\\L1Data\\L1.MIN", "Levels\\L1Data\\L1S.CEL" };
+		return { "NLevels\\L5Data\\L5.CEL", "NLevels\\L5Data\\L5.TIL", "NLevels\\L5Data\\L5.MIN", "NLevels\\L5Data\\L5S.CEL" };
 	case DTYPE_CATACOMBS:
-		pDungeonCels = LoadFileInMem("Levels\\L2Data\\L2.CEL");
-		pMegaTiles = LoadFileInMem<MegaTile>("Levels\\L2Data\\L2.TIL");
-		pLevelPieces = LoadFileInMem<uint16_t>("Levels\\L2Data\\L2.MIN");
-		pSpecialCels = LoadCel("Levels\\L2Data\\L2S.CEL", SpecialCelWidth);
-		break;
+		return { "Levels\\L2Data\\L2.CEL", "Levels\\L2Data\\L2.TIL", "Levels\\L2Data\\L2.MIN", "Levels\\L2Data\\L2S.CEL" };
 	case DTYPE_CAVES:
-		if (currlevel < 17) {
-			pDungeonCels = LoadFileInMem("Levels\\L3Data\\L3.CEL");
-			pMegaTiles = LoadFileInMem<MegaTile>("Levels\\L3Data\\L3.TIL");
-			pLevelPieces = LoadFileInMem<uint16_t>("Levels\\L3Data\\L3.MIN");
-		} else {
-			pDungeonCels = LoadFileInMem("NLevels\\L6Data\\L6.CEL");
-			pMegaTiles = LoadFileInMem<MegaTile>("NLevels\\L6Data\\L6.TIL");
-			pLevelPieces = LoadFileInMem<uint16_t>("NLevels\\L6Data\\L6.MIN");
-		}
-		pSpecialCels = LoadCel("Levels\\L1Data\\L1S.CEL", SpecialCelWidth);
-		break;
+		if (level < 17)
+			return { "Levels\\L3Data\\L3.CEL", "Levels\\L3Data\\L3.TIL", "Levels\\L3Data\\L3.MIN", "Levels\\L1Data\\L1S.CEL" };
+		return { "NLevels\\L6Data\\L6.CEL", "NLevels\\L6Data\\L6.TIL", "NLevels\\L6Data\\L6.MIN", "Levels\\L1Data\\L1S.CEL" };
 	case DTYPE_HELL:
-		pDungeonCels = LoadFileInMem("Levels\\L4Data\\L4.CEL");
-		pMegaTiles = LoadFileInMem<MegaTile>("Levels\\L4Data\\L4.TIL");
-		pLevelPieces = LoadFileInMem<uint16_t>("Levels\\L4Data\\L4.MIN");
-		pSpecialCels = LoadCel("Levels\\L2Data\\L2S.CEL", SpecialCelWidth);
-		break;
+		return { "Levels\\L4Data\\L4.CEL", "Levels\\L4Data\\L4.TIL", "Levels\\L4Data\\L4.MIN", "Levels\\L2Data\\L2S.CEL" };
 	default:
 		app_fatal("LoadLvlGFX");
 	}
 }
 
+constexpr int SpecialCelWidth = 64;
+
+} // namespace
+
+/**
+ * @brief Load the tiles of the current level, the cels are only queued as they aren't needed to generate the level
+ */
+void LoadLvlGFX()
+{
+	assert(pDungeonCels == nullptr);
+
+	MemoryTagScope memoryTag(MemoryTag::Tileset);
+	InvalidateTileCache();
+	InvalidateLitSpriteCache();
+	InvalidateOutlineCache();
+
+	const LvlGfxFiles files = GetLvlGfxFiles(leveltype, currlevel);
+	TownGfxLoaded = leveltype == DTYPE_TOWN;
+	if (TownGfxLoaded && ResidentTownGfx && ResidentTownGfx->isHellfire == gbIsHellfire) {
+		pDungeonCels = std::move(ResidentTownGfx->cels);
+		pMegaTiles = std::move(ResidentTownGfx->megaTiles);
+		pSpecialCels = std::move(ResidentTownGfx->specialCels);
+		ResidentTownGfx = std::nullopt;
+	} else {
+		PrefetchFile(files.cels);
+		PrefetchFile(files.specialCels);
+		pMegaTiles = LoadFileInMem<MegaTile>(files.megaTiles);
+	}
+	LoadLevelPieces(files.levelPieces);
+}
+
+/**
+ * @brief Load the cels of the current level, which were read in the background while the level was generated
+ */
+void LoadLvlCels()
+{
+	// Kept from the last visit to the town
+	if (pDungeonCels != nullptr)
+		return;
+
+	MemoryTagScope memoryTag(MemoryTag::Tileset);
+	const LvlGfxFiles files = GetLvlGfxFiles(leveltype, currlevel);
+	pDungeonCels = LoadFileInMem(files.cels);
+	pSpecialCels = LoadCel(files.specialCels, SpecialCelWidth);
+}
+
+void PrefetchLvlGFX(int level)
+{
+	if (level < 0 || level >= NUMLEVELS || level == currlevel)
+		return;
+
+	const dungeon_type type = level == 0 ? DTYPE_TOWN : gnLevelTypeTbl[level];
+	if (type == DTYPE_NONE)
+		return;
+	if (type == DTYPE_TOWN && ResidentTownGfx)
+		return;
+
+	const LvlGfxFiles files = GetLvlGfxFiles(type, level);
+	PrefetchFile(files.cels);
+	PrefetchFile(files.megaTiles);
+	PrefetchFile(files.levelPieces);
+	PrefetchFile(files.specialCels);
+	PrefetchQuestDungeons(level);
+}
+
 void LoadAllGFX()
 {
 	IncProgress();
@@ -1593,6 +1802,20 @@ void LoadAllGFX()
 	IncProgress();
 }
 
+/**
+ * @brief Generate the layout of the current level, or copy it if it was generated before
+ * @param lvldir method of entry
+ */
+static void CreateDungeon(void (*createDungeon)(uint32_t rseed, lvl_entry entry), lvl_entry lvldir)
+{
+	const uint32_t seed = glSeedTbl[currlevel];
+	if (RestoreGeneratedLevel(seed, lvldir))
+		return;
+	BeginGeneratedLevel();
+	createDungeon(seed, lvldir);
+	StoreGeneratedLevel(seed, lvldir);
+}
+
 /**
  * @param lvldir method of entry
  */
@@ -1605,7 +1828,7 @@ void CreateLevel(lvl_entry lvldir)
 		LoadRndLvlPal(DTYPE_TOWN);
 		break;
 	case DTYPE_CATHEDRAL:
-		CreateL5Dungeon(glSeedTbl[currlevel], lvldir);
+		CreateDungeon(CreateL5Dungeon, lvldir);
 		InitL1Triggers();
 		Freeupstairs();
 		if (currlevel < 21) {
@@ -1615,13 +1838,13 @@ void CreateLevel(lvl_entry lvldir)
 		}
 		break;
 	case DTYPE_CATACOMBS:
-		CreateL2Dungeon(glSeedTbl[currlevel], lvldir);
+		CreateDungeon(CreateL2Dungeon, lvldir);
 		InitL2Triggers();
 		Freeupstairs();
 		LoadRndLvlPal(DTYPE_CATACOMBS);
 		break;
 	case DTYPE_CAVES:
-		CreateL3Dungeon(glSeedTbl[currlevel], lvldir);
+		CreateDungeon(CreateL3Dungeon, lvldir);
 		InitL3Triggers();
 		Freeupstairs();
 		if (currlevel < 17) {
@@ -1631,7 +1854,7 @@ void CreateLevel(lvl_entry lvldir)
 		}
 		break;
 	case DTYPE_HELL:
-		CreateL4Dungeon(glSeedTbl[currlevel], lvldir);
+		CreateDungeon(CreateL4Dungeon, lvldir);
 		InitL4Triggers();
 		Freeupstairs();
 		LoadRndLvlPal(DTYPE_HELL);
@@ -1661,10 +1884,14 @@ static void UpdateMonsterLights()
 
 void LoadGameLevel(bool firstflag, lvl_entry lvldir)
 {
+	ProfileScope profileScope("LoadGameLevel");
+
 	if (setseed != 0)
 		glSeedTbl[currlevel] = setseed;
 
+	StageTimer timer(fmt::format("Loading level {}", currlevel));
 	music_stop();
+	InvalidateFlowFields();
 	if (pcurs > CURSOR_HAND && pcurs < CURSOR_FIRSTITEM) {
 		NewCursor(CURSOR_HAND);
 	}
@@ -1673,6 +1900,7 @@ void LoadGameLevel(bool firstflag, lvl_entry lvldir)
 	MakeLightTable();
 	LoadLvlGFX();
 	IncProgress();
+	timer.EndStage("tiles");
 
 	if (firstflag) {
 		InitInv();
@@ -1706,6 +1934,7 @@ void LoadGameLevel(bool firstflag, lvl_entry lvldir)
 		IncProgress();
 		FillSolidBlockTbls();
 		SetRndSeed(glSeedTbl[currlevel]);
+		timer.EndStage("generation");
 
 		if (leveltype != DTYPE_TOWN) {
 			GetLevelMTypes();
@@ -1720,6 +1949,7 @@ void LoadGameLevel(bool firstflag, lvl_entry lvldir)
 		}
 
 		IncProgress();
+		timer.EndStage("monster and object graphics");
 
 		if (lvldir == ENTRY_RTNLVL)
 			GetReturnLvlPos();
@@ -1740,6 +1970,7 @@ void LoadGameLevel(bool firstflag, lvl_entry lvldir)
 		PlayDungMsgs();
 		InitMultiView();
 		IncProgress();
+		timer.EndStage("player graphics");
 
 		bool visited = false;
 		int players = gbIsMultiplayer ? MAX_PLRS : 1;
@@ -1783,10 +2014,7 @@ void LoadGameLevel(bool firstflag, lvl_entry lvldir)
 				IncProgress();
 			}
 		} else {
-			for (int i = 0; i < MAXDUNX; i++) {
-				for (int j = 0; j < MAXDUNY; j++)
-					dFlags[i][j] |= BFLAG_LIT;
-			}
+			SetDungeonFlags({ { 0, 0 }, { MAXDUNX, MAXDUNY } }, BFLAG_LIT);
 
 			InitTowners();
 			InitItems();
@@ -1804,6 +2032,7 @@ void LoadGameLevel(bool firstflag, lvl_entry lvldir)
 			ResyncQuests();
 		else
 			ResyncMPQuests();
+		timer.EndStage("population");
 	} else {
 		LoadSetMap();
 		IncProgress();
@@ -1844,6 +2073,7 @@ void LoadGameLevel(bool firstflag, lvl_entry lvldir)
 
 		InitMissiles();
 		IncProgress();
+		timer.EndStage("set level");
 	}
 
 	SyncPortals();
@@ -1862,7 +2092,9 @@ void LoadGameLevel(bool firstflag, lvl_entry lvldir)
 		}
 	}
 
+	LoadLvlCels();
 	SetDungeonMicros();
+	timer.EndStage("cels");
 
 	InitLightMax();
 	IncProgress();
@@ -1895,15 +2127,19 @@ void LoadGameLevel(bool firstflag, lvl_entry lvldir)
 	while (!IncProgress())
 		;
 
+	// Whatever was read ahead for another level is no longer needed
+	ClearPrefetchedFiles();
+	PrefetchMonsterSnd();
+	PrefetchHeroSnd();
+
 	if (!gbIsSpawn && setlevel && setlvlnum == SL_SKELKING && quests[Q_SKELKING]._qactive == QUEST_ACTIVE)
 		PlaySFX(USFX_SKING1);
+
+	timer.End();
 }
 
-static void game_logic()
+void ProcessGameLogic()
 {
-	if (!ProcessInput()) {
-		return;
-	}
 	if (gbProcessPlayers) {
 		ProcessPlayers();
 	}
@@ -1919,6 +2155,17 @@ static void game_logic()
 		ProcessItems();
 		ProcessMissiles();
 	}
+}
+
+static void game_logic()
+{
+	ProfileScope profileScope("GameLogic");
+
+	if (!ProcessInput()) {
+		return;
+	}
+	ReplayRecordTick();
+	ProcessGameLogic();
 
 #ifdef _DEBUG
 	if (debug_mode_key_inverted_v && (GetAsyncKeyState(DVL_VK_SHIFT) & 0x8000) != 0) {
@@ -1936,12 +2183,23 @@ static void game_logic()
 	plrctrls_after_game_logic();
 }
 
+/** Set while waiting for a turn that is late, before the network timeout is shown */
+static bool sgbTurnLate;
+static uint32_t sgdwTurnLateStart;
+
 static void timeout_cursor(bool bTimeout)
 {
 	if (bTimeout) {
+		if (!sgbTurnLate) {
+			sgbTurnLate = true;
+			sgdwTurnLateStart = SDL_GetTicks();
+			multi_net_ping();
+		}
+		// Short stalls are common on uneven connections, keep drawing the game normally through them
+		if (sgnTimeoutCurs == CURSOR_NONE && SDL_GetTicks() - sgdwTurnLateStart < multi_timeout_grace())
+			return;
 		if (sgnTimeoutCurs == CURSOR_NONE && sgbMouseDown == CLICK_NONE) {
 			sgnTimeoutCurs = pcurs;
-			multi_net_ping();
 			ClearPanel();
 			AddPanelString(_("-- Network timeout --"));
 			AddPanelString(_("-- Waiting for players --"));
@@ -1949,7 +2207,11 @@ static void timeout_cursor(bool bTimeout)
 			force_redraw = 255;
 		}
 		scrollrt_draw_game_screen();
-	} else if (sgnTimeoutCurs != CURSOR_NONE) {
+		return;
+	}
+
+	sgbTurnLate = false;
+	if (sgnTimeoutCurs != CURSOR_NONE) {
 		NewCursor(sgnTimeoutCurs);
 		sgnTimeoutCurs = CURSOR_NONE;
 		ClearPanel();
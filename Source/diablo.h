@@ -62,7 +62,11 @@ bool PressEscKey();
 void DisableInputWndProc(uint32_t uMsg, int32_t wParam, int32_t lParam);
 void GM_Game(uint32_t uMsg, int32_t wParam, int32_t lParam);
 void LoadGameLevel(bool firstflag, lvl_entry lvldir);
+/** @brief Start reading the tileset of a level in the background, in case the player heads there next. */
+void PrefetchLvlGFX(int level);
 void game_loop(bool bStartup);
+/** @brief Advance players, monsters, objects, missiles and lighting by one game tick. */
+void ProcessGameLogic();
 void diablo_color_cyc_logic();
 
 /* rdata */
@@ -44,7 +44,7 @@ bool VR3;
 std::unique_ptr<uint16_t[]> L5pSetPiece;
 
 /** Contains shadows for 2x2 blocks of base tile IDs in the Cathedral. */
-const ShadowStruct SPATS[37] = {
+constexpr ShadowStruct SPATS[37] = {
 	// clang-format off
 	// strig, s1, s2, s3, nv1, nv2, nv3
 	{      7, 13,  0, 13, 144,   0, 142 },
@@ -87,6 +87,11 @@ const ShadowStruct SPATS[37] = {
 	// clang-format on
 };
 
+/** Tiles that cast a shadow on the pillar of the wall to their left. */
+constexpr std::array<bool, 256> CastsPillarShadow = MakeTileSet({ 29, 32, 35, 37, 38, 39 });
+/** Maps walls ending in a pillar to the same wall with the pillar in shadow, 0 for other tiles. */
+constexpr std::array<uint8_t, 256> ShadedPillar = MakeTileMap({ { 139, 141 }, { 149, 153 }, { 148, 154 } });
+
 // BUGFIX: This array should contain an additional 0 (207 elements).
 /** Maps tile IDs to their corresponding base tile ID. */
 const BYTE BSTYPES[] = {
@@ -852,90 +857,13 @@ void drlg_l1_crypt_lavafloor()
 
 static void DRLG_L1Shadows()
 {
-	int x, y, i;
-	BYTE sd[2][2];
-	BYTE tnv3;
-	bool patflag;
-
-	for (y = 1; y < DMAXY; y++) {
-		for (x = 1; x < DMAXX; x++) {
-			sd[0][0] = BSTYPES[dungeon[x][y]];
-			sd[1][0] = BSTYPES[dungeon[x - 1][y]];
-			sd[0][1] = BSTYPES[dungeon[x][y - 1]];
-			sd[1][1] = BSTYPES[dungeon[x - 1][y - 1]];
-
-			for (i = 0; i < 37; i++) {
-				if (SPATS[i].strig == sd[0][0]) {
-					patflag = true;
-					if (SPATS[i].s1 && SPATS[i].s1 != sd[1][1])
-						patflag = false;
-					if (SPATS[i].s2 && SPATS[i].s2 != sd[0][1])
-						patflag = false;
-					if (SPATS[i].s3 && SPATS[i].s3 != sd[1][0])
-						patflag = false;
-					if (patflag) {
-						if (SPATS[i].nv1 && !L5dflags[x - 1][y - 1])
-							dungeon[x - 1][y - 1] = SPATS[i].nv1;
-						if (SPATS[i].nv2 && !L5dflags[x][y - 1])
-							dungeon[x][y - 1] = SPATS[i].nv2;
-						if (SPATS[i].nv3 && !L5dflags[x - 1][y])
-							dungeon[x - 1][y] = SPATS[i].nv3;
-					}
-				}
-			}
-		}
-	}
+	constexpr ShadowPatterns<37> Patterns { SPATS };
+	Patterns.Apply(BSTYPES, [](int x, int y) { return L5dflags[x][y] == 0; });
 
-	for (y = 1; y < DMAXY; y++) {
-		for (x = 1; x < DMAXX; x++) {
-			if (dungeon[x - 1][y] == 139 && !L5dflags[x - 1][y]) {
-				tnv3 = 139;
-				if (dungeon[x][y] == 29)
-					tnv3 = 141;
-				if (dungeon[x][y] == 32)
-					tnv3 = 141;
-				if (dungeon[x][y] == 35)
-					tnv3 = 141;
-				if (dungeon[x][y] == 37)
-					tnv3 = 141;
-				if (dungeon[x][y] == 38)
-					tnv3 = 141;
-				if (dungeon[x][y] == 39)
-					tnv3 = 141;
-				dungeon[x - 1][y] = tnv3;
-			}
-			if (dungeon[x - 1][y] == 149 && !L5dflags[x - 1][y]) {
-				tnv3 = 149;
-				if (dungeon[x][y] == 29)
-					tnv3 = 153;
-				if (dungeon[x][y] == 32)
-					tnv3 = 153;
-				if (dungeon[x][y] == 35)
-					tnv3 = 153;
-				if (dungeon[x][y] == 37)
-					tnv3 = 153;
-				if (dungeon[x][y] == 38)
-					tnv3 = 153;
-				if (dungeon[x][y] == 39)
-					tnv3 = 153;
-				dungeon[x - 1][y] = tnv3;
-			}
-			if (dungeon[x - 1][y] == 148 && !L5dflags[x - 1][y]) {
-				tnv3 = 148;
-				if (dungeon[x][y] == 29)
-					tnv3 = 154;
-				if (dungeon[x][y] == 32)
-					tnv3 = 154;
-				if (dungeon[x][y] == 35)
-					tnv3 = 154;
-				if (dungeon[x][y] == 37)
-					tnv3 = 154;
-				if (dungeon[x][y] == 38)
-					tnv3 = 154;
-				if (dungeon[x][y] == 39)
-					tnv3 = 154;
-				dungeon[x - 1][y] = tnv3;
-			}
+	for (int y = 1; y < DMAXY; y++) {
+		for (int x = 1; x < DMAXX; x++) {
+			if (CastsPillarShadow[dungeon[x][y]] && ShadedPillar[dungeon[x - 1][y]] != 0 && L5dflags[x - 1][y] == 0)
+				dungeon[x - 1][y] = ShadedPillar[dungeon[x - 1][y]];
 		}
 	}
 }
@@ -947,6 +875,7 @@ static int DRLG_PlaceMiniSet(const BYTE *miniset, int tmin, int tmax, int cx, in
 
 	sw = miniset[0];
 	sh = miniset[1];
+	const MinisetMatcher matcher(miniset, L5dflags);
 
 	if (tmax - tmin == 0)
 		numt = 1;
@@ -989,17 +918,8 @@ static int DRLG_PlaceMiniSet(const BYTE *miniset, int tmin, int tmax, int cx, in
 				break;
 			}
 
-			ii = 2;
-
-			for (yy = 0; yy < sh && abort; yy++) {
-				for (xx = 0; xx < sw && abort; xx++) {
-					if (miniset[ii] && dungeon[xx + sx][sy + yy] != miniset[ii])
-						abort = false;
-					if (L5dflags[xx + sx][sy + yy])
-						abort = false;
-					ii++;
-				}
-			}
+			if (abort && !matcher.Matches(sx, sy))
+				abort = false;
 
 			if (!abort) {
 				if (++sx == DMAXX - sw) {
@@ -1931,22 +1851,11 @@ void drlg_l1_crypt_rndset(const BYTE *miniset, int rndper)
 {
 	int sw = miniset[0];
 	int sh = miniset[1];
+	const MinisetMatcher matcher(miniset, dflags);
 
 	for (int sy = 0; sy < DMAXY - sh; sy++) {
 		for (int sx = 0; sx < DMAXX - sw; sx++) {
-			bool found = true;
-			int ii = 2;
-			for (int yy = 0; yy < sh && found; yy++) {
-				for (int xx = 0; xx < sw && found; xx++) {
-					if (miniset[ii] != 0 && dungeon[xx + sx][yy + sy] != miniset[ii]) {
-						found = false;
-					}
-					if (dflags[xx + sx][yy + sy] != 0) {
-						found = false;
-					}
-					ii++;
-				}
-			}
+			bool found = matcher.Matches(sx, sy);
 			int kk = sw * sh + 2;
 			if (miniset[kk] >= 84 && miniset[kk] <= 100 && found) {
 				// BUGFIX: accesses to dungeon can go out of bounds (fixed)
@@ -2322,68 +2231,6 @@ void drlg_l1_set_corner_room(int rx1, int ry1)
 	}
 }
 
-static void DRLG_L5FTVR(int i, int j, int x, int y, int d)
-{
-	if (dTransVal[x][y] || dungeon[i][j] != 13) {
-		if (d == 1) {
-			dTransVal[x][y] = TransVal;
-			dTransVal[x][y + 1] = TransVal;
-		}
-		if (d == 2) {
-			dTransVal[x + 1][y] = TransVal;
-			dTransVal[x + 1][y + 1] = TransVal;
-		}
-		if (d == 3) {
-			dTransVal[x][y] = TransVal;
-			dTransVal[x + 1][y] = TransVal;
-		}
-		if (d == 4) {
-			dTransVal[x][y + 1] = TransVal;
-			dTransVal[x + 1][y + 1] = TransVal;
-		}
-		if (d == 5)
-			dTransVal[x + 1][y + 1] = TransVal;
-		if (d == 6)
-			dTransVal[x][y + 1] = TransVal;
-		if (d == 7)
-			dTransVal[x + 1][y] = TransVal;
-		if (d == 8)
-			dTransVal[x][y] = TransVal;
-		return;
-	}
-
-	dTransVal[x][y] = TransVal;
-	dTransVal[x + 1][y] = TransVal;
-	dTransVal[x][y + 1] = TransVal;
-	dTransVal[x + 1][y + 1] = TransVal;
-	DRLG_L5FTVR(i + 1, j, x + 2, y, 1);
-	DRLG_L5FTVR(i - 1, j, x - 2, y, 2);
-	DRLG_L5FTVR(i, j + 1, x, y + 2, 3);
-	DRLG_L5FTVR(i, j - 1, x, y - 2, 4);
-	DRLG_L5FTVR(i - 1, j - 1, x - 2, y - 2, 5);
-	DRLG_L5FTVR(i + 1, j - 1, x + 2, y - 2, 6);
-	DRLG_L5FTVR(i - 1, j + 1, x - 2, y + 2, 7);
-	DRLG_L5FTVR(i + 1, j + 1, x + 2, y + 2, 8);
-}
-
-static void DRLG_L5FloodTVal()
-{
-	int yy = 16;
-
-	for (int j = 0; j < DMAXY; j++) {
-		int xx = 16;
-
-		for (int i = 0; i < DMAXX; i++) {
-			if (dungeon[i][j] == 13 && !dTransVal[xx][yy]) {
-				DRLG_L5FTVR(i, j, xx, yy, 0);
-				TransVal++;
-			}
-			xx += 2;
-		}
-		yy += 2;
-	}
-}
-
 static void DRLG_L5TransFix()
 {
 	int yy = 16;
@@ -2463,12 +2310,17 @@ static void DRLG_L5CornerFix()
 {
 	for (int j = 1; j < DMAXY - 1; j++) {
 		for (int i = 1; i < DMAXX - 1; i++) {
-			if (!(L5dflags[i][j] & DLRG_PROTECTED) && dungeon[i][j] == 17 && dungeon[i - 1][j] == 13 && dungeon[i][j - 1] == 1) {
-				dungeon[i][j] = 16;
-				L5dflags[i][j - 1] &= DLRG_PROTECTED;
-			}
-			if (dungeon[i][j] == 202 && dungeon[i + 1][j] == 13 && dungeon[i][j + 1] == 1) {
-				dungeon[i][j] = 8;
+			switch (dungeon[i][j]) {
+			case 17:
+				if ((L5dflags[i][j] & DLRG_PROTECTED) == 0 && dungeon[i - 1][j] == 13 && dungeon[i][j - 1] == 1) {
+					dungeon[i][j] = 16;
+					L5dflags[i][j - 1] &= DLRG_PROTECTED;
+				}
+				break;
+			case 202:
+				if (dungeon[i + 1][j] == 13 && dungeon[i][j + 1] == 1)
+					dungeon[i][j] = 8;
+				break;
 			}
 		}
 	}
@@ -2505,7 +2357,7 @@ static void DRLG_L5(lvl_entry entry)
 		L5tileFix();
 		L5AddWall();
 		L5ClearFlags();
-		DRLG_L5FloodTVal();
+		FloodTransparencyValues(13);
 
 		doneflag = true;
 
@@ -34,7 +34,7 @@ int Room_Max = 10;
 int Room_Min = 4;
 const int Dir_Xadd[5] = { 0, 0, 1, 0, -1 };
 const int Dir_Yadd[5] = { 0, -1, 0, 1, 0 };
-const ShadowStruct SPATSL2[2] = { { 6, 3, 0, 3, 48, 0, 50 }, { 9, 3, 0, 3, 48, 0, 50 } };
+constexpr ShadowStruct SPATSL2[2] = { { 6, 3, 0, 3, 48, 0, 50 }, { 9, 3, 0, 3, 48, 0, 50 } };
 //short word_48489A = 0;
 
 const BYTE BTYPESL2[161] = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 0, 0, 0, 0, 0, 0, 0, 17, 18, 1, 1, 2, 2, 1, 1, 1, 1, 1, 1, 2, 2, 2, 2, 2, 0, 0, 0, 0, 8, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 0, 0, 2, 2, 2, 0, 0, 0, 1, 0, 0, 0, 0, 0, 0, 0, 0, 3, 3, 3, 3, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 3, 3, 3, 0, 3, 0, 3, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 };
@@ -1617,6 +1617,7 @@ static bool DRLG_L2PlaceMiniSet(const BYTE *miniset, int tmin, int tmax, int cx,
 
 	sw = miniset[0];
 	sh = miniset[1];
+	const MinisetMatcher matcher(miniset, dflags);
 
 	if (tmax - tmin == 0) {
 		numt = 1;
@@ -1643,17 +1644,8 @@ static bool DRLG_L2PlaceMiniSet(const BYTE *miniset, int tmin, int tmax, int cx,
 				sy = GenerateRnd(DMAXY - sh);
 				found = false;
 			}
-			ii = 2;
-			for (yy = 0; yy < sh && found; yy++) {
-				for (xx = 0; xx < sw && found; xx++) {
-					if (miniset[ii] != 0 && dungeon[xx + sx][yy + sy] != miniset[ii]) {
-						found = false;
-					}
-					if (dflags[xx + sx][yy + sy] != 0) {
-						found = false;
-					}
-					ii++;
-				}
+			if (found && !matcher.Matches(sx, sy)) {
+				found = false;
 			}
 			if (!found) {
 				sx++;
@@ -1698,29 +1690,21 @@ static bool DRLG_L2PlaceMiniSet(const BYTE *miniset, int tmin, int tmax, int cx,
 
 static void DRLG_L2PlaceRndSet(const BYTE *miniset, int rndper)
 {
-	int sx, sy, sw, sh, xx, yy, ii, kk;
+	int sx, sy, sw, sh, xx, yy, kk;
 	bool found;
 
 	sw = miniset[0];
 	sh = miniset[1];
+	const MinisetMatcher matcher(miniset, dflags);
 
 	for (sy = 0; sy < DMAXY - sh; sy++) {
 		for (sx = 0; sx < DMAXX - sw; sx++) {
 			found = true;
-			ii = 2;
 			if (sx >= nSx1 && sx <= nSx2 && sy >= nSy1 && sy <= nSy2) {
 				found = false;
 			}
-			for (yy = 0; yy < sh && found; yy++) {
-				for (xx = 0; xx < sw && found; xx++) {
-					if (miniset[ii] != 0 && dungeon[xx + sx][yy + sy] != miniset[ii]) {
-						found = false;
-					}
-					if (dflags[xx + sx][yy + sy] != 0) {
-						found = false;
-					}
-					ii++;
-				}
+			if (found && !matcher.Matches(sx, sy)) {
+				found = false;
 			}
 			kk = sw * sh + 2;
 			if (found) {
@@ -1787,43 +1771,8 @@ static void DRLG_L2Subs()
 
 static void DRLG_L2Shadows()
 {
-	int x, y, i;
-	bool patflag;
-	BYTE sd[2][2];
-
-	for (y = 1; y < DMAXY; y++) {
-		for (x = 1; x < DMAXX; x++) {
-			sd[0][0] = BSTYPESL2[dungeon[x][y]];
-			sd[1][0] = BSTYPESL2[dungeon[x - 1][y]];
-			sd[0][1] = BSTYPESL2[dungeon[x][y - 1]];
-			sd[1][1] = BSTYPESL2[dungeon[x - 1][y - 1]];
-			for (i = 0; i < 2; i++) {
-				if (SPATSL2[i].strig == sd[0][0]) {
-					patflag = true;
-					if (SPATSL2[i].s1 != 0 && SPATSL2[i].s1 != sd[1][1]) {
-						patflag = false;
-					}
-					if (SPATSL2[i].s2 != 0 && SPATSL2[i].s2 != sd[0][1]) {
-						patflag = false;
-					}
-					if (SPATSL2[i].s3 != 0 && SPATSL2[i].s3 != sd[1][0]) {
-						patflag = false;
-					}
-					if (patflag) {
-						if (SPATSL2[i].nv1 != 0) {
-							dungeon[x - 1][y - 1] = SPATSL2[i].nv1;
-						}
-						if (SPATSL2[i].nv2 != 0) {
-							dungeon[x][y - 1] = SPATSL2[i].nv2;
-						}
-						if (SPATSL2[i].nv3 != 0) {
-							dungeon[x - 1][y] = SPATSL2[i].nv3;
-						}
-					}
-				}
-			}
-		}
-	}
+	constexpr ShadowPatterns<2> Patterns { SPATSL2 };
+	Patterns.Apply(BSTYPESL2, [](int /*x*/, int /*y*/) { return true; });
 }
 
 void InitDungeon()
@@ -2320,24 +2269,27 @@ static void DoPatternCheck(int i, int j)
 
 static void L2TileFix()
 {
-	int i, j;
-
-	for (j = 0; j < DMAXY; j++) {
-		for (i = 0; i < DMAXX; i++) {
-			if (dungeon[i][j] == 1 && dungeon[i][j + 1] == 3) {
-				dungeon[i][j + 1] = 1;
-			}
-			if (dungeon[i][j] == 3 && dungeon[i][j + 1] == 1) {
-				dungeon[i][j + 1] = 3;
-			}
-			if (dungeon[i][j] == 3 && dungeon[i + 1][j] == 7) {
-				dungeon[i + 1][j] = 3;
-			}
-			if (dungeon[i][j] == 2 && dungeon[i + 1][j] == 3) {
-				dungeon[i + 1][j] = 2;
-			}
-			if (dungeon[i][j] == 11 && dungeon[i + 1][j] == 14) {
-				dungeon[i + 1][j] = 16;
+	for (int j = 0; j < DMAXY; j++) {
+		for (int i = 0; i < DMAXX; i++) {
+			switch (dungeon[i][j]) {
+			case 1:
+				if (dungeon[i][j + 1] == 3)
+					dungeon[i][j + 1] = 1;
+				break;
+			case 2:
+				if (dungeon[i + 1][j] == 3)
+					dungeon[i + 1][j] = 2;
+				break;
+			case 3:
+				if (dungeon[i][j + 1] == 1)
+					dungeon[i][j + 1] = 3;
+				if (dungeon[i + 1][j] == 7)
+					dungeon[i + 1][j] = 3;
+				break;
+			case 11:
+				if (dungeon[i + 1][j] == 14)
+					dungeon[i + 1][j] = 16;
+				break;
 			}
 		}
 	}
@@ -2803,71 +2755,6 @@ static void DRLG_L2Pass3()
 	DRLG_LPass3(12 - 1);
 }
 
-static void DRLG_L2FTVR(int i, int j, int x, int y, int d)
-{
-	if (dTransVal[x][y] != 0 || dungeon[i][j] != 3) {
-		if (d == 1) {
-			dTransVal[x][y] = TransVal;
-			dTransVal[x][y + 1] = TransVal;
-		}
-		if (d == 2) {
-			dTransVal[x + 1][y] = TransVal;
-			dTransVal[x + 1][y + 1] = TransVal;
-		}
-		if (d == 3) {
-			dTransVal[x][y] = TransVal;
-			dTransVal[x + 1][y] = TransVal;
-		}
-		if (d == 4) {
-			dTransVal[x][y + 1] = TransVal;
-			dTransVal[x + 1][y + 1] = TransVal;
-		}
-		if (d == 5) {
-			dTransVal[x + 1][y + 1] = TransVal;
-		}
-		if (d == 6) {
-			dTransVal[x][y + 1] = TransVal;
-		}
-		if (d == 7) {
-			dTransVal[x + 1][y] = TransVal;
-		}
-		if (d == 8) {
-			dTransVal[x][y] = TransVal;
-		}
-	} else {
-		dTransVal[x][y] = TransVal;
-		dTransVal[x + 1][y] = TransVal;
-		dTransVal[x][y + 1] = TransVal;
-		dTransVal[x + 1][y + 1] = TransVal;
-		DRLG_L2FTVR(i + 1, j, x + 2, y, 1);
-		DRLG_L2FTVR(i - 1, j, x - 2, y, 2);
-		DRLG_L2FTVR(i, j + 1, x, y + 2, 3);
-		DRLG_L2FTVR(i, j - 1, x, y - 2, 4);
-		DRLG_L2FTVR(i - 1, j - 1, x - 2, y - 2, 5);
-		DRLG_L2FTVR(i + 1, j - 1, x + 2, y - 2, 6);
-		DRLG_L2FTVR(i - 1, j + 1, x - 2, y + 2, 7);
-		DRLG_L2FTVR(i + 1, j + 1, x + 2, y + 2, 8);
-	}
-}
-
-static void DRLG_L2FloodTVal()
-{
-	int i, j, xx, yy;
-
-	yy = 16;
-	for (j = 0; j < DMAXY; j++) {
-		xx = 16;
-		for (i = 0; i < DMAXX; i++) {
-			if (dungeon[i][j] == 3 && dTransVal[xx][yy] == 0) {
-				DRLG_L2FTVR(i, j, xx, yy, 0);
-				TransVal++;
-			}
-			xx += 2;
-		}
-		yy += 2;
-	}
-}
-
 static void DRLG_L2TransFix()
 {
 	int i, j, xx, yy;
@@ -2905,27 +2792,29 @@ static void DRLG_L2TransFix()
 
 static void L2DirtFix()
 {
-	int i, j;
-
-	for (j = 0; j < DMAXY; j++) {
-		for (i = 0; i < DMAXX; i++) {
-			if (dungeon[i][j] == 13 && dungeon[i + 1][j] != 11) {
-				dungeon[i][j] = 146;
-			}
-			if (dungeon[i][j] == 11 && dungeon[i + 1][j] != 11) {
-				dungeon[i][j] = 144;
-			}
-			if (dungeon[i][j] == 15 && dungeon[i + 1][j] != 11) {
-				dungeon[i][j] = 148;
-			}
-			if (dungeon[i][j] == 10 && dungeon[i][j + 1] != 10) {
-				dungeon[i][j] = 143;
-			}
-			if (dungeon[i][j] == 13 && dungeon[i][j + 1] != 10) {
-				dungeon[i][j] = 146;
-			}
-			if (dungeon[i][j] == 14 && dungeon[i][j + 1] != 15) {
-				dungeon[i][j] = 147;
+	for (int j = 0; j < DMAXY; j++) {
+		for (int i = 0; i < DMAXX; i++) {
+			switch (dungeon[i][j]) {
+			case 10:
+				if (dungeon[i][j + 1] != 10)
+					dungeon[i][j] = 143;
+				break;
+			case 11:
+				if (dungeon[i + 1][j] != 11)
+					dungeon[i][j] = 144;
+				break;
+			case 13:
+				if (dungeon[i + 1][j] != 11 || dungeon[i][j + 1] != 10)
+					dungeon[i][j] = 146;
+				break;
+			case 14:
+				if (dungeon[i][j + 1] != 15)
+					dungeon[i][j] = 147;
+				break;
+			case 15:
+				if (dungeon[i + 1][j] != 11)
+					dungeon[i][j] = 148;
+				break;
 			}
 		}
 	}
@@ -3031,7 +2920,7 @@ static void DRLG_L2(lvl_entry entry)
 		if (setloadflag) {
 			DRLG_L2SetRoom(nSx1, nSy1);
 		}
-		DRLG_L2FloodTVal();
+		FloodTransparencyValues(3);
 		DRLG_L2TransFix();
 		if (entry == ENTRY_MAIN) {
 			doneflag = DRLG_L2PlaceMiniSet(USTAIRS, 1, 1, -1, -1, true, 0);
@@ -1426,106 +1426,96 @@ static void DRLG_L3River()
 	}
 }
 
-static bool DRLG_L3Spawn(int x, int y, int *totarea);
-
-static bool DRLG_L3SpawnEdge(int x, int y, int *totarea)
-{
-	BYTE i;
-	static BYTE spawntable[15] = { 0x00, 0x0A, 0x43, 0x05, 0x2c, 0x06, 0x09, 0x00, 0x00, 0x1c, 0x83, 0x06, 0x09, 0x0A, 0x05 };
-
-	if (*totarea > 40) {
-		return true;
-	}
-	if (x < 0 || y < 0 || x >= DMAXX || y >= DMAXY) {
-		return true;
-	}
-	if ((dungeon[x][y] & 0x80) != 0) {
-		return false;
-	}
-	if (dungeon[x][y] > 15) {
-		return true;
-	}
-
-	i = dungeon[x][y];
-	dungeon[x][y] |= 0x80;
-	*totarea += 1;
-
-	if (spawntable[i] & 8 && DRLG_L3SpawnEdge(x, y - 1, totarea)) {
-		return true;
-	}
-	if (spawntable[i] & 4 && DRLG_L3SpawnEdge(x, y + 1, totarea)) {
-		return true;
-	}
-	if (spawntable[i] & 2 && DRLG_L3SpawnEdge(x + 1, y, totarea)) {
-		return true;
-	}
-	if (spawntable[i] & 1 && DRLG_L3SpawnEdge(x - 1, y, totarea)) {
-		return true;
-	}
-	if (spawntable[i] & 0x80 && DRLG_L3Spawn(x, y - 1, totarea)) {
-		return true;
-	}
-	if (spawntable[i] & 0x40 && DRLG_L3Spawn(x, y + 1, totarea)) {
-		return true;
-	}
-	if (spawntable[i] & 0x20 && DRLG_L3Spawn(x + 1, y, totarea)) {
-		return true;
-	}
-	if (spawntable[i] & 0x10 && DRLG_L3Spawn(x - 1, y, totarea)) {
-		return true;
-	}
-
-	return false;
-}
-
+/**
+ * @brief Flood fills the dirt and wall tiles connected to the given one
+ *
+ * Tiles are visited depth first in the order of the recursive fill of the original game, since
+ * the marked tiles decide which lava pools are placed.
+ * @return True if the fill grew larger than 40 tiles or reached the edge of the map
+ */
 static bool DRLG_L3Spawn(int x, int y, int *totarea)
 {
-	BYTE i;
-	static BYTE spawntable[15] = { 0x00, 0x0A, 0x03, 0x05, 0x0C, 0x06, 0x09, 0x00, 0x00, 0x0C, 0x03, 0x06, 0x09, 0x0A, 0x05 };
-
-	if (*totarea > 40) {
-		return true;
-	}
-	if (x < 0 || y < 0 || x >= DMAXX || y >= DMAXY) {
-		return true;
-	}
-	if ((dungeon[x][y] & 0x80) != 0) {
-		return false;
-	}
-	if (dungeon[x][y] > 15) {
+	struct SpawnStep {
+		BYTE bit;
+		int8_t dx;
+		int8_t dy;
+		/** Continue along an edge rather than spawning a new fill */
+		bool edge;
+	};
+	/** Bits 0-3 continue along an edge, bits 4-7 spawn a new fill */
+	static const SpawnStep wallsteps[8] = {
+		{ 0x08, 0, -1, true },
+		{ 0x04, 0, 1, true },
+		{ 0x02, 1, 0, true },
+		{ 0x01, -1, 0, true },
+		{ 0x80, 0, -1, false },
+		{ 0x40, 0, 1, false },
+		{ 0x20, 1, 0, false },
+		{ 0x10, -1, 0, false },
+	};
+	/** Dirt spawns a new fill in every direction */
+	static const SpawnStep dirtsteps[4] = {
+		{ 0x20, 1, 0, false },
+		{ 0x10, -1, 0, false },
+		{ 0x40, 0, 1, false },
+		{ 0x80, 0, -1, false },
+	};
+	static const BYTE edgetable[15] = { 0x00, 0x0A, 0x43, 0x05, 0x2c, 0x06, 0x09, 0x00, 0x00, 0x1c, 0x83, 0x06, 0x09, 0x0A, 0x05 };
+	static const BYTE spawntable[15] = { 0x00, 0x0A, 0x03, 0x05, 0x0C, 0x06, 0x09, 0x00, 0x00, 0x0C, 0x03, 0x06, 0x09, 0x0A, 0x05 };
+
+	struct Frame {
+		int x;
+		int y;
+		const SpawnStep *steps;
+		int stepCount;
+		BYTE directions;
+		int next;
+	};
+	// Every frame adds to totarea and the fill stops above 40, so it never gets deeper than this
+	Frame stack[41];
+	int depth = 0;
+
+	enum class Visit {
+		Stop,
+		Skip,
+		Pushed,
+	};
+	auto visit = [&](int tx, int ty, bool edge) {
+		if (*totarea > 40)
+			return Visit::Stop;
+		if (tx < 0 || ty < 0 || tx >= DMAXX || ty >= DMAXY)
+			return Visit::Stop;
+		if ((dungeon[tx][ty] & 0x80) != 0)
+			return Visit::Skip;
+		if (dungeon[tx][ty] > 15)
+			return Visit::Stop;
+
+		const BYTE tile = dungeon[tx][ty];
+		dungeon[tx][ty] |= 0x80;
+		*totarea += 1;
+
+		assert(depth < 41);
+		Frame &frame = stack[depth++];
+		frame = { tx, ty, wallsteps, 8, edge ? edgetable[tile] : spawntable[tile], 0 };
+		if (!edge && tile == 8) {
+			frame.steps = dirtsteps;
+			frame.stepCount = 4;
+			frame.directions = 0xF0;
+		}
+		return Visit::Pushed;
+	};
+
+	if (visit(x, y, false) == Visit::Stop)
 		return true;
-	}
-
-	i = dungeon[x][y];
-	dungeon[x][y] |= 0x80;
-	*totarea += 1;
-
-	if (i != 8) {
-		if (spawntable[i] & 8 && DRLG_L3SpawnEdge(x, y - 1, totarea)) {
-			return true;
-		}
-		if (spawntable[i] & 4 && DRLG_L3SpawnEdge(x, y + 1, totarea)) {
-			return true;
-		}
-		if (spawntable[i] & 2 && DRLG_L3SpawnEdge(x + 1, y, totarea)) {
-			return true;
-		}
-		if (spawntable[i] & 1 && DRLG_L3SpawnEdge(x - 1, y, totarea)) {
-			return true;
-		}
-	} else {
-		if (DRLG_L3Spawn(x + 1, y, totarea)) {
-			return true;
-		}
-		if (DRLG_L3Spawn(x - 1, y, totarea)) {
-			return true;
-		}
-		if (DRLG_L3Spawn(x, y + 1, totarea)) {
-			return true;
-		}
-		if (DRLG_L3Spawn(x, y - 1, totarea)) {
+	while (depth > 0) {
+		Frame &frame = stack[depth - 1];
+		if (frame.next == frame.stepCount) {
+			depth--;
+			continue;
+		}
+		const SpawnStep &step = frame.steps[frame.next++];
+		if ((frame.directions & step.bit) != 0 && visit(frame.x + step.dx, frame.y + step.dy, step.edge) == Visit::Stop)
 			return true;
-		}
 	}
 
 	return false;
@@ -1622,6 +1612,7 @@ static bool DRLG_L3PlaceMiniSet(const BYTE *miniset, int tmin, int tmax, int cx,
 
 	sw = miniset[0];
 	sh = miniset[1];
+	const MinisetMatcher matcher(miniset, dflags);
 
 	if (tmax - tmin == 0) {
 		numt = 1;
@@ -1647,17 +1638,8 @@ static bool DRLG_L3PlaceMiniSet(const BYTE *miniset, int tmin, int tmax, int cx,
 				sy = GenerateRnd(DMAXY - sh);
 				found = false;
 			}
-			ii = 2;
-			for (yy = 0; yy < sh && found; yy++) {
-				for (xx = 0; xx < sw && found; xx++) {
-					if (miniset[ii] != 0 && dungeon[xx + sx][yy + sy] != miniset[ii]) {
-						found = false;
-					}
-					if (dflags[xx + sx][yy + sy] != 0) {
-						found = false;
-					}
-					ii++;
-				}
+			if (found && !matcher.Matches(sx, sy)) {
+				found = false;
 			}
 			if (!found) {
 				sx++;
@@ -1698,27 +1680,16 @@ static bool DRLG_L3PlaceMiniSet(const BYTE *miniset, int tmin, int tmax, int cx,
 
 static void DRLG_L3PlaceRndSet(const BYTE *miniset, int rndper)
 {
-	int sx, sy, sw, sh, xx, yy, ii, kk;
+	int sx, sy, sw, sh, xx, yy, kk;
 	bool found;
 
 	sw = miniset[0];
 	sh = miniset[1];
+	const MinisetMatcher matcher(miniset, dflags);
 
 	for (sy = 0; sy < DMAXX - sh; sy++) {
 		for (sx = 0; sx < DMAXY - sw; sx++) {
-			found = true;
-			ii = 2;
-			for (yy = 0; yy < sh && found; yy++) {
-				for (xx = 0; xx < sw && found; xx++) {
-					if (miniset[ii] != 0 && dungeon[xx + sx][yy + sy] != miniset[ii]) {
-						found = false;
-					}
-					if (dflags[xx + sx][yy + sy] != 0) {
-						found = false;
-					}
-					ii++;
-				}
-			}
+			found = matcher.Matches(sx, sy);
 			kk = sw * sh + 2;
 			if (miniset[kk] >= 84 && miniset[kk] <= 100 && found) {
 				// BUGFIX: accesses to dungeon can go out of bounds (fixed)
@@ -1752,29 +1723,18 @@ static void DRLG_L3PlaceRndSet(const BYTE *miniset, int rndper)
 
 bool drlg_l3_hive_rnd_piece(const BYTE *miniset, int rndper)
 {
-	int sx, sy, sw, sh, xx, yy, ii, kk;
+	int sx, sy, sw, sh, xx, yy, kk;
 	bool found;
 	bool placed;
 
 	placed = false;
 	sw = miniset[0];
 	sh = miniset[1];
+	const MinisetMatcher matcher(miniset, dflags);
 
 	for (sy = 0; sy < DMAXX - sh; sy++) {
 		for (sx = 0; sx < DMAXY - sw; sx++) {
-			found = true;
-			ii = 2;
-			for (yy = 0; yy < sh && found; yy++) {
-				for (xx = 0; xx < sw && found; xx++) {
-					if (miniset[ii] != 0 && dungeon[xx + sx][yy + sy] != miniset[ii]) {
-						found = false;
-					}
-					if (dflags[xx + sx][yy + sy] != 0) {
-						found = false;
-					}
-					ii++;
-				}
-			}
+			found = matcher.Matches(sx, sy);
 			kk = sw * sh + 2;
 			if (miniset[kk] >= 84 && miniset[kk] <= 100 && found) {
 				// BUGFIX: accesses to dungeon can go out of bounds
@@ -2285,18 +2245,34 @@ static void FixL3HallofHeroes()
 	}
 }
 
+/**
+ * @brief Clears the 4-connected area of lockout around the tile and counts its tiles
+ *
+ * Neighbours are taken from the flat array like the recursive fill of the original game did, so
+ * stepping past the top of a column continues at the bottom of the previous one.
+ */
 static void DRLG_L3LockRec(int x, int y)
 {
-	if (!lockout[x][y]) {
-		return;
+	static FloodFillStack<DMAXX * DMAXY> stack;
+	bool *tiles = &lockout[0][0];
+
+	auto visit = [&](int index) {
+		if (index < 0 || index >= DMAXX * DMAXY || !tiles[index])
+			return;
+		tiles[index] = false;
+		lockoutcnt++;
+		stack.Push(index / DMAXY, index % DMAXY);
+	};
+
+	visit(x * DMAXY + y);
+	while (!stack.Empty()) {
+		const Point tile = stack.Pop();
+		const int index = tile.x * DMAXY + tile.y;
+		visit(index - 1);
+		visit(index + 1);
+		visit(index - DMAXY);
+		visit(index + DMAXY);
 	}
-
-	lockout[x][y] = false;
-	lockoutcnt++;
-	DRLG_L3LockRec(x, y - 1);
-	DRLG_L3LockRec(x, y + 1);
-	DRLG_L3LockRec(x - 1, y);
-	DRLG_L3LockRec(x + 1, y);
 }
 
 bool DRLG_L3Lockout()
@@ -152,33 +152,16 @@ const BYTE L4BTYPES[140] = {
 
 static void DRLG_L4Shadows()
 {
-	int x, y;
-	bool okflag;
-
-	for (y = 1; y < DMAXY; y++) {
-		for (x = 1; x < DMAXY; x++) {
-			okflag = false;
-			if (dungeon[x][y] == 3) {
-				okflag = true;
-			}
-			if (dungeon[x][y] == 4) {
-				okflag = true;
-			}
-			if (dungeon[x][y] == 8) {
-				okflag = true;
-			}
-			if (dungeon[x][y] == 15) {
-				okflag = true;
-			}
-			if (!okflag) {
+	constexpr std::array<bool, 256> CastsShadow = MakeTileSet({ 3, 4, 8, 15 });
+
+	for (int y = 1; y < DMAXY; y++) {
+		for (int x = 1; x < DMAXX; x++) {
+			if (!CastsShadow[dungeon[x][y]])
 				continue;
-			}
-			if (dungeon[x - 1][y] == 6) {
+			if (dungeon[x - 1][y] == 6)
 				dungeon[x - 1][y] = 47;
-			}
-			if (dungeon[x - 1][y - 1] == 6) {
+			if (dungeon[x - 1][y - 1] == 6)
 				dungeon[x - 1][y - 1] = 48;
-			}
 		}
 	}
 }
@@ -1297,6 +1280,8 @@ static bool DRLG_L4PlaceMiniSet(const BYTE *miniset, int tmin, int tmax, int cx,
 	}
 
 	for (i = 0; i < numt; i++) {
+		// Placing a miniset flags its tiles, so every copy needs a new matcher
+		const MinisetMatcher matcher(miniset, dflags);
 		sx = GenerateRnd(DMAXX - sw);
 		sy = GenerateRnd(DMAXY - sh);
 		found = false;
@@ -1315,17 +1300,8 @@ static bool DRLG_L4PlaceMiniSet(const BYTE *miniset, int tmin, int tmax, int cx,
 				sy = GenerateRnd(DMAXY - sh);
 				found = false;
 			}
-			ii = 2;
-			for (yy = 0; yy < sh && found; yy++) {
-				for (xx = 0; xx < sw && found; xx++) {
-					if (miniset[ii] != 0 && dungeon[xx + sx][yy + sy] != miniset[ii]) {
-						found = false;
-					}
-					if (dflags[xx + sx][yy + sy] != 0) {
-						found = false;
-					}
-					ii++;
-				}
+			if (found && !matcher.Matches(sx, sy)) {
+				found = false;
 			}
 			if (!found) {
 				sx++;
@@ -1368,80 +1344,6 @@ static bool DRLG_L4PlaceMiniSet(const BYTE *miniset, int tmin, int tmax, int cx,
 	return true;
 }
 
-#if defined(__3DS__)
-#pragma GCC push_options
-#pragma GCC optimize("O0")
-#endif
-
-static void DRLG_L4FTVR(int i, int j, int x, int y, int d)
-{
-	if (dTransVal[x][y] != 0 || dungeon[i][j] != 6) {
-		if (d == 1) {
-			dTransVal[x][y] = TransVal;
-			dTransVal[x][y + 1] = TransVal;
-		}
-		if (d == 2) {
-			dTransVal[x + 1][y] = TransVal;
-			dTransVal[x + 1][y + 1] = TransVal;
-		}
-		if (d == 3) {
-			dTransVal[x][y] = TransVal;
-			dTransVal[x + 1][y] = TransVal;
-		}
-		if (d == 4) {
-			dTransVal[x][y + 1] = TransVal;
-			dTransVal[x + 1][y + 1] = TransVal;
-		}
-		if (d == 5) {
-			dTransVal[x + 1][y + 1] = TransVal;
-		}
-		if (d == 6) {
-			dTransVal[x][y + 1] = TransVal;
-		}
-		if (d == 7) {
-			dTransVal[x + 1][y] = TransVal;
-		}
-		if (d == 8) {
-			dTransVal[x][y] = TransVal;
-		}
-	} else {
-		dTransVal[x][y] = TransVal;
-		dTransVal[x + 1][y] = TransVal;
-		dTransVal[x][y + 1] = TransVal;
-		dTransVal[x + 1][y + 1] = TransVal;
-		DRLG_L4FTVR(i + 1, j, x + 2, y, 1);
-		DRLG_L4FTVR(i - 1, j, x - 2, y, 2);
-		DRLG_L4FTVR(i, j + 1, x, y + 2, 3);
-		DRLG_L4FTVR(i, j - 1, x, y - 2, 4);
-		DRLG_L4FTVR(i - 1, j - 1, x - 2, y - 2, 5);
-		DRLG_L4FTVR(i + 1, j - 1, x + 2, y - 2, 6);
-		DRLG_L4FTVR(i - 1, j + 1, x - 2, y + 2, 7);
-		DRLG_L4FTVR(i + 1, j + 1, x + 2, y + 2, 8);
-	}
-}
-
-static void DRLG_L4FloodTVal()
-{
-	int i, j, xx, yy;
-
-	yy = 16;
-	for (j = 0; j < DMAXY; j++) {
-		xx = 16;
-		for (i = 0; i < DMAXX; i++) {
-			if (dungeon[i][j] == 6 && dTransVal[xx][yy] == 0) {
-				DRLG_L4FTVR(i, j, xx, yy, 0);
-				TransVal++;
-			}
-			xx += 2;
-		}
-		yy += 2;
-	}
-}
-
-#if defined(__3DS__)
-#pragma GCC pop_options
-#endif
-
 bool IsDURWall(char d)
 {
 	if (d == 25) {
@@ -1587,7 +1489,7 @@ static void DRLG_L4(lvl_entry entry)
 			}
 		}
 		L4AddWall();
-		DRLG_L4FloodTVal();
+		FloodTransparencyValues(6);
 		DRLG_L4TransFix();
 		if (setloadflag) {
 			DRLG_L4SetSPRoom(SP4x1, SP4y1);
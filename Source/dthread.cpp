@@ -4,54 +4,146 @@
  * Implementation of functions for updating game state from network commands.
  */
 
+#include <atomic>
+#include <memory>
+
 #include "nthread.h"
 #include "storm/storm.h"
+#include "utils/profiler.h"
 #include "utils/thread.h"
 
 namespace devilution {
 
-static CCritSect sgMemCrit;
+namespace {
+
+struct DeltaPacket {
+	uint8_t pnum;
+	/** Value of PlayerGeneration[pnum] when the packet was queued */
+	uint32_t generation;
+	_cmd_id cmd;
+	uint32_t size;
+	std::unique_ptr<byte[]> data;
+};
+
+/**
+ * Bounded single producer single consumer ring of the deltas waiting to be sent.
+ * The game thread only advances DeltaQueueTail and dthread only advances DeltaQueueHead.
+ */
+constexpr uint32_t DeltaQueueSize = 256;
+DeltaPacket DeltaQueue[DeltaQueueSize];
+std::atomic<uint32_t> DeltaQueueHead;
+std::atomic<uint32_t> DeltaQueueTail;
+
+/** Incremented when a player leaves, so that the deltas queued for them are dropped */
+std::atomic<uint32_t> PlayerGeneration[MAX_PLRS];
+
+/** Signaled with the mutex of sghWorkToDoEvent held when dthread takes a delta out of a full queue */
+SDL_cond *DeltaQueueSpace;
+
+} // namespace
+
 SDL_threadID glpDThreadId;
-TMegaPkt *sgpInfoHead; /* may not be right struct */
-bool dthread_running;
+std::atomic<bool> dthread_running;
 event_emul *sghWorkToDoEvent;
 
 /* rdata */
 static SDL_Thread *sghThread = nullptr;
 
+static bool DeltaQueueEmpty()
+{
+	return DeltaQueueHead.load(std::memory_order_relaxed) == DeltaQueueTail.load(std::memory_order_acquire);
+}
+
+static bool DeltaQueueFull(uint32_t tail)
+{
+	return tail - DeltaQueueHead.load(std::memory_order_acquire) == DeltaQueueSize;
+}
+
+static bool PopDelta(DeltaPacket &pkt)
+{
+	const uint32_t head = DeltaQueueHead.load(std::memory_order_relaxed);
+	const uint32_t tail = DeltaQueueTail.load(std::memory_order_acquire);
+	if (head == tail)
+		return false;
+	pkt = std::move(DeltaQueue[head % DeltaQueueSize]);
+	DeltaQueueHead.store(head + 1, std::memory_order_release);
+	// The game thread only waits on a full queue, so only taking from one needs to wake it
+	if (tail - head == DeltaQueueSize && DeltaQueueSpace != nullptr) {
+		SDL_LockMutex(sghWorkToDoEvent->mutex);
+		SDL_CondSignal(DeltaQueueSpace);
+		SDL_UnlockMutex(sghWorkToDoEvent->mutex);
+	}
+	return true;
+}
+
+/**
+ * @brief Sleeps until dthread has made room in the queue.
+ *
+ * Checked while holding the mutex PopDelta signals with, so the wake up can't be missed.
+ * @return false if the thread was stopped while the queue was still full
+ */
+static bool WaitForDeltaQueueSpace(uint32_t tail)
+{
+	SDL_LockMutex(sghWorkToDoEvent->mutex);
+	while (dthread_running && DeltaQueueFull(tail)) {
+		if (SDL_CondWait(DeltaQueueSpace, sghWorkToDoEvent->mutex) <= -1)
+			app_fatal("dthread5:\n%s", SDL_GetError());
+	}
+	const bool full = DeltaQueueFull(tail);
+	SDL_UnlockMutex(sghWorkToDoEvent->mutex);
+	return !full;
+}
+
+static void PushDelta(DeltaPacket pkt)
+{
+	const uint32_t tail = DeltaQueueTail.load(std::memory_order_relaxed);
+	if (DeltaQueueFull(tail) && !WaitForDeltaQueueSpace(tail))
+		return;
+	DeltaQueue[tail % DeltaQueueSize] = std::move(pkt);
+	DeltaQueueTail.store(tail + 1, std::memory_order_release);
+	ProfilerSetCounter(ProfileCounter::DeltaQueue, tail + 1 - DeltaQueueHead.load(std::memory_order_relaxed));
+}
+
+/**
+ * @brief Sleeps until a delta is queued or the thread is stopped.
+ *
+ * The queue is checked while holding the event's mutex, which SetEvent also takes,
+ * so a wake up can't get lost between the check and the wait.
+ */
+static void WaitForDelta()
+{
+	SDL_LockMutex(sghWorkToDoEvent->mutex);
+	while (dthread_running && DeltaQueueEmpty()) {
+		if (SDL_CondWait(sghWorkToDoEvent->cond, sghWorkToDoEvent->mutex) <= -1)
+			app_fatal("dthread4:\n%s", SDL_GetError());
+	}
+	SDL_UnlockMutex(sghWorkToDoEvent->mutex);
+}
+
 static unsigned int dthread_handler(void *data)
 {
-	const char *error_buf;
-	TMegaPkt *pkt;
+	DeltaPacket pkt;
 	DWORD dwMilliseconds;
 
 	while (dthread_running) {
-		if (sgpInfoHead == nullptr && WaitForEvent(sghWorkToDoEvent) == -1) {
-			error_buf = SDL_GetError();
-			app_fatal("dthread4:\n%s", error_buf);
+		if (!PopDelta(pkt)) {
+			WaitForDelta();
+			continue;
 		}
 
-		sgMemCrit.Enter();
-		pkt = sgpInfoHead;
-		if (sgpInfoHead != nullptr)
-			sgpInfoHead = sgpInfoHead->pNext;
-		else
-			ResetEvent(sghWorkToDoEvent);
-		sgMemCrit.Leave();
-
-		if (pkt != nullptr) {
-			if (pkt->dwSpaceLeft != MAX_PLRS)
-				multi_send_zero_packet(pkt->dwSpaceLeft, static_cast<_cmd_id>(pkt->data[0]), &pkt->data[8], *(DWORD *)&pkt->data[4]);
+		if (pkt.generation == PlayerGeneration[pkt.pnum]) {
+			ProfileScope profileScope("DeltaSend");
+			multi_send_zero_packet(pkt.pnum, pkt.cmd, pkt.data.get(), pkt.size);
+		}
 
-			dwMilliseconds = 1000 * *(DWORD *)&pkt->data[4] / gdwDeltaBytesSec;
-			if (dwMilliseconds >= 1)
-				dwMilliseconds = 1;
+		dwMilliseconds = 1000 * pkt.size / gdwDeltaBytesSec;
+		if (dwMilliseconds >= 1)
+			dwMilliseconds = 1;
 
-			std::free(pkt);
+		pkt.data = nullptr;
 
-			if (dwMilliseconds != 0)
-				SDL_Delay(dwMilliseconds);
-		}
+		if (dwMilliseconds != 0)
+			SDL_Delay(dwMilliseconds);
 	}
 
 	return 0;
@@ -59,40 +151,25 @@ static unsigned int dthread_handler(void *data)
 
 void dthread_remove_player(uint8_t pnum)
 {
-	TMegaPkt *pkt;
-
-	sgMemCrit.Enter();
-	for (pkt = sgpInfoHead; pkt != nullptr; pkt = pkt->pNext) {
-		if (pkt->dwSpaceLeft == pnum)
-			pkt->dwSpaceLeft = MAX_PLRS;
-	}
-	sgMemCrit.Leave();
+	PlayerGeneration[pnum]++;
 }
 
 void dthread_send_delta(int pnum, _cmd_id cmd, byte *pbSrc, int dwLen)
 {
-	TMegaPkt *pkt;
-	TMegaPkt *p;
-
 	if (!gbIsMultiplayer) {
 		return;
 	}
 
-	pkt = static_cast<TMegaPkt *>(std::malloc(dwLen + 20));
-	pkt->pNext = nullptr;
-	pkt->dwSpaceLeft = pnum;
-	pkt->data[0] = static_cast<byte>(cmd);
-	*(DWORD *)&pkt->data[4] = dwLen;
-	memcpy(&pkt->data[8], pbSrc, dwLen);
-	sgMemCrit.Enter();
-	p = (TMegaPkt *)&sgpInfoHead;
-	while (p->pNext != nullptr) {
-		p = p->pNext;
-	}
-	p->pNext = pkt;
+	DeltaPacket pkt;
+	pkt.pnum = pnum;
+	pkt.generation = PlayerGeneration[pnum];
+	pkt.cmd = cmd;
+	pkt.size = dwLen;
+	pkt.data = std::make_unique<byte[]>(dwLen);
+	memcpy(pkt.data.get(), pbSrc, dwLen);
+	PushDelta(std::move(pkt));
 
 	SetEvent(sghWorkToDoEvent);
-	sgMemCrit.Leave();
 }
 
 void dthread_start()
@@ -104,7 +181,8 @@ void dthread_start()
 	}
 
 	sghWorkToDoEvent = StartEvent();
-	if (sghWorkToDoEvent == nullptr) {
+	DeltaQueueSpace = SDL_CreateCond();
+	if (sghWorkToDoEvent == nullptr || DeltaQueueSpace == nullptr) {
 		error_buf = SDL_GetError();
 		app_fatal("dthread:1\n%s", error_buf);
 	}
@@ -120,8 +198,6 @@ void dthread_start()
 
 void dthread_cleanup()
 {
-	TMegaPkt *tmp;
-
 	if (sghWorkToDoEvent == nullptr) {
 		return;
 	}
@@ -134,11 +210,11 @@ void dthread_cleanup()
 	}
 	EndEvent(sghWorkToDoEvent);
 	sghWorkToDoEvent = nullptr;
+	SDL_DestroyCond(DeltaQueueSpace);
+	DeltaQueueSpace = nullptr;
 
-	while (sgpInfoHead != nullptr) {
-		tmp = sgpInfoHead->pNext;
-		std::free(sgpInfoHead);
-		sgpInfoHead = tmp;
+	DeltaPacket pkt;
+	while (PopDelta(pkt)) {
 	}
 }
 
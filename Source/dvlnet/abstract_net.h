@@ -45,6 +45,10 @@ public:
 	virtual bool SNetDropPlayer(int playerid, DWORD flags) = 0;
 	virtual bool SNetGetOwnerTurnsWaiting(DWORD *turns) = 0;
 	virtual bool SNetGetTurnsInTransit(DWORD *turns) = 0;
+	virtual bool SNetGetNetStats(NetStats *stats)
+	{
+		return false;
+	}
 	virtual void setup_gameinfo(buffer_t info) = 0;
 	virtual ~abstract_net() = default;
 
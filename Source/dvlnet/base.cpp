@@ -1,9 +1,13 @@
 #include "dvlnet/base.h"
 
+#include <SDL.h>
 #include <algorithm>
+#include <cstdlib>
 #include <cstring>
 #include <memory>
 
+#include "encrypt.h"
+
 namespace devilution {
 namespace net {
 
@@ -53,6 +57,117 @@ void base::handle_accept(packet &pkt)
 	}
 }
 
+bool base::batching_enabled()
+{
+	if (game_init_info.size() != sizeof(GameData))
+		return false;
+	GameData gameData;
+	std::memcpy(&gameData, game_init_info.data(), sizeof(gameData));
+	return gameData.bBatchPackets != 0;
+}
+
+bool base::compression_enabled()
+{
+	if (game_init_info.size() != sizeof(GameData))
+		return false;
+	GameData gameData;
+	std::memcpy(&gameData, game_init_info.data(), sizeof(gameData));
+	return gameData.bCompressPackets != 0;
+}
+
+void base::queue_batched(packet_type type, plr_t dest, const unsigned char *data, std::size_t size)
+{
+	constexpr std::size_t MaxBatchSize = 0x4000;
+	if (!batch_buffer.empty() && (dest != batch_dest || batch_buffer.size() + 3 + size > MaxBatchSize))
+		flush_batch();
+	batch_dest = dest;
+	batch_buffer.push_back(type);
+	batch_buffer.push_back(size & 0xFF);
+	batch_buffer.push_back(size >> 8);
+	batch_buffer.insert(batch_buffer.end(), data, data + size);
+}
+
+void base::flush_batch()
+{
+	if (batch_buffer.empty())
+		return;
+	// Batches smaller than this rarely shrink enough to pay for the size prefix
+	constexpr std::size_t MinCompressedSize = 64;
+	std::unique_ptr<packet> pkt;
+	if (compression_enabled() && batch_buffer.size() >= MinCompressedSize) {
+		compress_buffer.resize(2 + PkwareCompressBound(batch_buffer.size()));
+		compress_buffer[0] = batch_buffer.size() & 0xFF;
+		compress_buffer[1] = batch_buffer.size() >> 8;
+		const uint32_t size = PkwareCompress(reinterpret_cast<const byte *>(batch_buffer.data()), batch_buffer.size(),
+		    reinterpret_cast<byte *>(&compress_buffer[2]));
+		if (2 + size < batch_buffer.size()) {
+			pkt = pktfty->make_packet<PT_COMPRESSED_BATCH>(plr_self, batch_dest,
+			    buffer_t(compress_buffer.begin(), compress_buffer.begin() + 2 + size));
+		}
+	}
+	if (pkt == nullptr)
+		pkt = pktfty->make_packet<PT_BATCH>(plr_self, batch_dest, std::move(batch_buffer));
+	batch_buffer.clear();
+	send_counted(*pkt);
+}
+
+void base::send_counted(packet &pkt)
+{
+	bytes_sent += pkt.data().size();
+	send(pkt);
+}
+
+void base::record_turn(plr_t src)
+{
+	peer_stats_t &stats = peer_stats[src];
+	const uint32_t now = SDL_GetTicks();
+	if (stats.last_turn_ticks != 0) {
+		// Moving averages over roughly the last 8 turns
+		const int interval = now - stats.last_turn_ticks;
+		const int deviation = std::abs(interval - static_cast<int>(stats.turn_interval_ms));
+		stats.turn_interval_ms = (stats.turn_interval_ms * 7 + interval) / 8;
+		stats.turn_jitter_ms = (stats.turn_jitter_ms * 7 + deviation) / 8;
+	}
+	stats.last_turn_ticks = now;
+}
+
+void base::recv_batch(plr_t src, const buffer_t &batch)
+{
+	std::size_t offset = 0;
+	while (batch.size() - offset >= 3) {
+		const auto type = static_cast<packet_type>(batch[offset]);
+		const std::size_t size = batch[offset + 1] | (batch[offset + 2] << 8);
+		offset += 3;
+		if (batch.size() - offset < size)
+			throw packet_exception();
+		const unsigned char *data = &batch[offset];
+		offset += size;
+		if (type == PT_MESSAGE) {
+			message_queue.emplace_back(src, buffer_t(data, data + size));
+		} else if (type == PT_TURN && size == sizeof(turn_t)) {
+			turn_t turn;
+			std::memcpy(&turn, data, sizeof(turn));
+			turn_queue[src].push_back(turn);
+			record_turn(src);
+		} else {
+			throw packet_exception();
+		}
+	}
+}
+
+buffer_t base::decompress_batch(const buffer_t &compressed)
+{
+	if (compressed.size() < 2)
+		throw packet_exception();
+	const std::size_t size = compressed[0] | (compressed[1] << 8);
+	buffer_t batch(size);
+	if (PkwareDecompress(reinterpret_cast<const byte *>(&compressed[2]), compressed.size() - 2,
+	        reinterpret_cast<byte *>(batch.data()), size)
+	    != size)
+		throw packet_exception();
+	return batch;
+}
+
 void base::clear_msg(plr_t plr)
 {
 	message_queue.erase(std::remove_if(message_queue.begin(),
@@ -67,6 +182,11 @@ void base::recv_local(packet &pkt)
 {
 	if (pkt.src() < MAX_PLRS) {
 		connected_table[pkt.src()] = true;
+		// SNetDropPlayer passes its own packet through here, it was counted as sent
+		if (pkt.src() != plr_self) {
+			peer_stats[pkt.src()].last_packet_ticks = SDL_GetTicks();
+			peer_stats[pkt.src()].bytes_received += pkt.data().size();
+		}
 	}
 	switch (pkt.type()) {
 	case PT_MESSAGE:
@@ -74,6 +194,16 @@ void base::recv_local(packet &pkt)
 		break;
 	case PT_TURN:
 		turn_queue[pkt.src()].push_back(pkt.turn());
+		if (pkt.src() < MAX_PLRS)
+			record_turn(pkt.src());
+		break;
+	case PT_BATCH:
+		if (pkt.src() < MAX_PLRS)
+			recv_batch(pkt.src(), pkt.message());
+		break;
+	case PT_COMPRESSED_BATCH:
+		if (pkt.src() < MAX_PLRS)
+			recv_batch(pkt.src(), decompress_batch(pkt.message()));
 		break;
 	case PT_JOIN_ACCEPT:
 		handle_accept(pkt);
@@ -95,6 +225,7 @@ void base::recv_local(packet &pkt)
 				disconnect_net(pkt.newplr());
 				clear_msg(pkt.newplr());
 				turn_queue[pkt.newplr()].clear();
+				peer_stats[pkt.newplr()] = {};
 			}
 		} else {
 			ABORT(); // we were dropped by the owner?!?
@@ -108,10 +239,11 @@ void base::recv_local(packet &pkt)
 
 bool base::SNetReceiveMessage(int *sender, char **data, int *size)
 {
+	flush_batch();
 	poll();
 	if (message_queue.empty())
 		return false;
-	message_last = message_queue.front();
+	message_last = std::move(message_queue.front());
 	message_queue.pop_front();
 	*sender = message_last.sender;
 	*size = message_last.payload.size();
@@ -134,14 +266,19 @@ bool base::SNetSendMessage(int playerID, void *data, unsigned int size)
 	else
 		dest = playerID;
 	if (dest != plr_self) {
-		auto pkt = pktfty->make_packet<PT_MESSAGE>(plr_self, dest, message);
-		send(*pkt);
+		if (batching_enabled()) {
+			queue_batched(PT_MESSAGE, dest, rawMessage, size);
+		} else {
+			auto pkt = pktfty->make_packet<PT_MESSAGE>(plr_self, dest, message);
+			send_counted(*pkt);
+		}
 	}
 	return true;
 }
 
 bool base::SNetReceiveTurns(char **data, unsigned int *size, DWORD *status)
 {
+	flush_batch();
 	poll();
 	bool allTurnsArrived = true;
 	for (auto i = 0; i < MAX_PLRS; ++i) {
@@ -181,9 +318,15 @@ bool base::SNetSendTurn(char *data, unsigned int size)
 		ABORT();
 	turn_t turn;
 	std::memcpy(&turn, data, sizeof(turn));
-	auto pkt = pktfty->make_packet<PT_TURN>(plr_self, PLR_BROADCAST, turn);
-	send(*pkt);
-	turn_queue[plr_self].push_back(pkt->turn());
+	if (batching_enabled()) {
+		// The turn closes the tick, so it is sent right away along with the tick's messages
+		queue_batched(PT_TURN, PLR_BROADCAST, reinterpret_cast<const unsigned char *>(&turn), sizeof(turn));
+		flush_batch();
+	} else {
+		auto pkt = pktfty->make_packet<PT_TURN>(plr_self, PLR_BROADCAST, turn);
+		send_counted(*pkt);
+	}
+	turn_queue[plr_self].push_back(turn);
 	return true;
 }
 
@@ -224,19 +367,21 @@ bool base::SNetRegisterEventHandler(event_type evtype, SEVTHANDLER func)
 
 bool base::SNetLeaveGame(int type)
 {
+	flush_batch();
 	auto pkt = pktfty->make_packet<PT_DISCONNECT>(plr_self, PLR_BROADCAST,
 	    plr_self, type);
-	send(*pkt);
+	send_counted(*pkt);
 	return true;
 }
 
 bool base::SNetDropPlayer(int playerid, DWORD flags)
 {
+	flush_batch();
 	auto pkt = pktfty->make_packet<PT_DISCONNECT>(plr_self,
 	    PLR_BROADCAST,
 	    (plr_t)playerid,
 	    (leaveinfo_t)flags);
-	send(*pkt);
+	send_counted(*pkt);
 	recv_local(*pkt);
 	return true;
 }
@@ -263,5 +408,24 @@ bool base::SNetGetTurnsInTransit(DWORD *turns)
 	return true;
 }
 
+bool base::SNetGetNetStats(NetStats *stats)
+{
+	const uint32_t now = SDL_GetTicks();
+	for (int i = 0; i < MAX_PLRS; i++) {
+		const peer_stats_t &peer = peer_stats[i];
+		NetPeerStats &out = stats->peers[i];
+		out.connected = connected_table[i] && i != plr_self;
+		out.turnsQueued = turn_queue[i].size();
+		out.msSinceLastPacket = peer.last_packet_ticks != 0 ? now - peer.last_packet_ticks : 0;
+		out.turnIntervalMs = peer.turn_interval_ms;
+		out.turnJitterMs = peer.turn_jitter_ms;
+		out.bytesReceived = peer.bytes_received;
+	}
+	stats->turnsInTransit = plr_self < MAX_PLRS ? turn_queue[plr_self].size() : 0;
+	stats->sendQueueDepth = send_queue_depth();
+	stats->bytesSent = bytes_sent;
+	return true;
+}
+
 } // namespace net
 } // namespace devilution
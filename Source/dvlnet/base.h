@@ -31,6 +31,7 @@ public:
 	virtual bool SNetDropPlayer(int playerid, DWORD flags);
 	virtual bool SNetGetOwnerTurnsWaiting(DWORD *turns);
 	virtual bool SNetGetTurnsInTransit(DWORD *turns);
+	virtual bool SNetGetNetStats(NetStats *stats);
 
 	virtual void poll() = 0;
 	virtual void send(packet &pkt) = 0;
@@ -56,7 +57,7 @@ protected:
 		}
 		message_t(int s, buffer_t p)
 		    : sender(s)
-		    , payload(p)
+		    , payload(std::move(p))
 		{
 		}
 	};
@@ -75,10 +76,44 @@ protected:
 	void handle_accept(packet &pkt);
 	void recv_local(packet &pkt);
 	void run_event_handler(_SNETEVENT &ev);
+	/** @brief Send the packets that are waiting to be combined into a PT_BATCH. */
+	void flush_batch();
+	/** @brief Send a game packet and count it in the statistics. */
+	void send_counted(packet &pkt);
+	/** @brief Number of frames that have been sent but not written to the network yet. */
+	virtual uint32_t send_queue_depth()
+	{
+		return 0;
+	}
 
 private:
+	/**
+	 * Messages and turns that will be sent together as a single PT_BATCH,
+	 * each stored as its packet type, 16-bit little endian size and payload.
+	 */
+	buffer_t batch_buffer;
+	plr_t batch_dest = PLR_BROADCAST;
+	/** Output of the compressor, kept between batches */
+	buffer_t compress_buffer;
+
+	struct peer_stats_t {
+		uint32_t last_packet_ticks = 0;
+		uint32_t last_turn_ticks = 0;
+		uint32_t turn_interval_ms = 0;
+		uint32_t turn_jitter_ms = 0;
+		uint64_t bytes_received = 0;
+	};
+	std::array<peer_stats_t, MAX_PLRS> peer_stats;
+	uint64_t bytes_sent = 0;
+
 	plr_t get_owner();
 	void clear_msg(plr_t plr);
+	bool batching_enabled();
+	bool compression_enabled();
+	void queue_batched(packet_type type, plr_t dest, const unsigned char *data, std::size_t size);
+	void recv_batch(plr_t src, const buffer_t &batch);
+	buffer_t decompress_batch(const buffer_t &compressed);
+	void record_turn(plr_t src);
 };
 
 } // namespace net
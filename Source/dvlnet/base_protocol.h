@@ -30,6 +30,12 @@ public:
 
 	virtual ~base_protocol() = default;
 
+protected:
+	virtual uint32_t send_queue_depth()
+	{
+		return static_cast<uint32_t>(proto.send_queue_depth());
+	}
+
 private:
 	P proto;
 	typedef typename P::endpoint endpoint;
@@ -64,10 +70,9 @@ template <class P>
 bool base_protocol<P>::wait_network()
 {
 	// wait for ZeroTier for 5 seconds
-	for (auto i = 0; i < 500; ++i) {
-		if (proto.network_online())
-			break;
-		SDL_Delay(10);
+	const uint32_t start = SDL_GetTicks();
+	while (!proto.network_online() && SDL_GetTicks() - start < 5000) {
+		proto.wait_event(10);
 	}
 	return proto.network_online();
 }
@@ -82,15 +87,20 @@ void base_protocol<P>::disconnect_net(plr_t plr)
 template <class P>
 bool base_protocol<P>::wait_firstpeer()
 {
-	// wait for peer for 5 seconds
-	for (auto i = 0; i < 500; ++i) {
+	// wait for peer for 5 seconds, waking up as soon as anything arrives
+	const uint32_t start = SDL_GetTicks();
+	uint32_t lastRequest = start - 10;
+	while (SDL_GetTicks() - start < 5000) {
 		if (game_list.count(gamename)) {
 			firstpeer = game_list[gamename];
 			break;
 		}
-		send_info_request();
+		if (SDL_GetTicks() - lastRequest >= 10) {
+			send_info_request();
+			lastRequest = SDL_GetTicks();
+		}
 		recv();
-		SDL_Delay(10);
+		proto.wait_event(10);
 	}
 	return (bool)firstpeer;
 }
@@ -111,11 +121,12 @@ void base_protocol<P>::wait_join()
 	auto pkt = pktfty->make_packet<PT_JOIN_REQUEST>(PLR_BROADCAST,
 	    PLR_MASTER, cookie_self, game_init_info);
 	proto.send(firstpeer, pkt->data());
-	for (auto i = 0; i < 500; ++i) {
+	const uint32_t start = SDL_GetTicks();
+	while (SDL_GetTicks() - start < 5000) {
 		recv();
 		if (plr_self != PLR_BROADCAST)
 			break; // join successful
-		SDL_Delay(10);
+		proto.wait_event(10);
 	}
 }
 
@@ -38,6 +38,7 @@ public:
 	virtual bool SNetDropPlayer(int playerid, DWORD flags);
 	virtual bool SNetGetOwnerTurnsWaiting(DWORD *turns);
 	virtual bool SNetGetTurnsInTransit(DWORD *turns);
+	virtual bool SNetGetNetStats(NetStats *stats);
 	virtual void setup_gameinfo(buffer_t info);
 	virtual std::string make_default_gamename();
 
@@ -71,7 +72,6 @@ int cdwrap<T>::create(std::string addrstr, std::string passwd)
 template <class T>
 int cdwrap<T>::join(std::string addrstr, std::string passwd)
 {
-	game_init_info = buffer_t();
 	reset();
 	return dvlnet_wrap->join(addrstr, passwd);
 }
@@ -158,6 +158,12 @@ bool cdwrap<T>::SNetGetTurnsInTransit(DWORD *turns)
 	return dvlnet_wrap->SNetGetTurnsInTransit(turns);
 }
 
+template <class T>
+bool cdwrap<T>::SNetGetNetStats(NetStats *stats)
+{
+	return dvlnet_wrap->SNetGetNetStats(stats);
+}
+
 template <class T>
 std::string cdwrap<T>::make_default_gamename()
 {
@@ -17,20 +17,26 @@ buffer_t frame_queue::read(framesize_t s)
 	if (current_size < s)
 		throw frame_queue_exception();
 	buffer_t ret;
-	while (s > 0 && s >= buffer_deque.front().size()) {
-		s -= buffer_deque.front().size();
-		current_size -= buffer_deque.front().size();
-		ret.insert(ret.end(),
-		    buffer_deque.front().begin(),
-		    buffer_deque.front().end());
+	// A frame that arrived in a buffer of its own can be handed over as is
+	if (front_offset == 0 && buffer_deque.front().size() == s) {
+		ret = std::move(buffer_deque.front());
 		buffer_deque.pop_front();
+		current_size -= s;
+		return ret;
+	}
+	ret.reserve(s);
+	while (s > 0 && s >= buffer_deque.front().size() - front_offset) {
+		const buffer_t &front = buffer_deque.front();
+		s -= front.size() - front_offset;
+		current_size -= front.size() - front_offset;
+		ret.insert(ret.end(), front.begin() + front_offset, front.end());
+		buffer_deque.pop_front();
+		front_offset = 0;
 	}
 	if (s > 0) {
-		ret.insert(ret.end(),
-		    buffer_deque.front().begin(),
-		    buffer_deque.front().begin() + s);
-		buffer_deque.front().erase(buffer_deque.front().begin(),
-		    buffer_deque.front().begin() + s);
+		const buffer_t &front = buffer_deque.front();
+		ret.insert(ret.end(), front.begin() + front_offset, front.begin() + front_offset + s);
+		front_offset += s;
 		current_size -= s;
 	}
 	return ret;
@@ -67,15 +73,22 @@ buffer_t frame_queue::read_packet()
 	return ret;
 }
 
-buffer_t frame_queue::make_frame(buffer_t packetbuf)
+buffer_t frame_queue::make_frame(const buffer_t &packetbuf)
 {
 	buffer_t ret;
+	make_frame(packetbuf, ret);
+	return ret;
+}
+
+void frame_queue::make_frame(const buffer_t &packetbuf, buffer_t &frame)
+{
 	if (packetbuf.size() > max_frame_size)
 		ABORT();
 	framesize_t size = packetbuf.size();
-	ret.insert(ret.end(), packet_out::begin(size), packet_out::end(size));
-	ret.insert(ret.end(), packetbuf.begin(), packetbuf.end());
-	return ret;
+	frame.clear();
+	frame.reserve(sizeof(framesize_t) + packetbuf.size());
+	frame.insert(frame.end(), packet_out::begin(size), packet_out::end(size));
+	frame.insert(frame.end(), packetbuf.begin(), packetbuf.end());
 }
 
 } // namespace net
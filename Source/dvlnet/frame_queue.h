@@ -27,6 +27,8 @@ public:
 private:
 	framesize_t current_size = 0;
 	std::deque<buffer_t> buffer_deque;
+	/** Number of bytes of the front buffer that have already been read */
+	std::size_t front_offset = 0;
 	framesize_t nextsize = 0;
 
 	framesize_t size();
@@ -37,7 +39,9 @@ public:
 	buffer_t read_packet();
 	void write(buffer_t buf);
 
-	static buffer_t make_frame(buffer_t packetbuf);
+	static buffer_t make_frame(const buffer_t &packetbuf);
+	/** @brief Same as above, but reuses the memory of `frame` */
+	static void make_frame(const buffer_t &packetbuf, buffer_t &frame);
 };
 
 } // namespace net
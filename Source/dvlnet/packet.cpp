@@ -1,10 +1,27 @@
 #include "dvlnet/packet.h"
 
+#ifndef NONET
+#include <mutex>
+#endif
+
 namespace devilution {
 namespace net {
 
 #ifndef NONET
 static constexpr bool DisableEncryption = false;
+
+namespace {
+
+/**
+ * The key derived for the last password. Reconnecting or hosting again with the same password
+ * reuses it instead of running Argon2id again.
+ */
+std::mutex DerivedKeyMutex;
+bool DerivedKeyValid = false;
+std::string DerivedKeyPassword;
+key_t DerivedKey;
+
+} // namespace
 #endif
 
 const char *packet_type_to_string(uint8_t packetType)
@@ -14,6 +31,10 @@ const char *packet_type_to_string(uint8_t packetType)
 		return "PT_MESSAGE";
 	case PT_TURN:
 		return "PT_TURN";
+	case PT_BATCH:
+		return "PT_BATCH";
+	case PT_COMPRESSED_BATCH:
+		return "PT_COMPRESSED_BATCH";
 	case PT_JOIN_REQUEST:
 		return "PT_JOIN_REQUEST";
 	case PT_JOIN_ACCEPT:
@@ -96,7 +117,7 @@ const buffer_t &packet::message()
 {
 	if (!have_decrypted)
 		ABORT();
-	CheckPacketTypeOneOf({ PT_MESSAGE }, m_type);
+	CheckPacketTypeOneOf({ PT_MESSAGE, PT_BATCH, PT_COMPRESSED_BATCH }, m_type);
 	return m_message;
 }
 
@@ -164,11 +185,13 @@ void packet_in::decrypt()
 		    - crypto_secretbox_NONCEBYTES
 		    - crypto_secretbox_MACBYTES);
 		decrypted_buffer.resize(pktlen);
-		if (crypto_secretbox_open_easy(decrypted_buffer.data(),
+		if (crypto_secretbox_open_detached(decrypted_buffer.data(),
+		        encrypted_buffer.data()
+		            + crypto_secretbox_NONCEBYTES
+		            + crypto_secretbox_MACBYTES,
 		        encrypted_buffer.data()
 		            + crypto_secretbox_NONCEBYTES,
-		        encrypted_buffer.size()
-		            - crypto_secretbox_NONCEBYTES,
+		        pktlen,
 		        encrypted_buffer.data(),
 		        key.data()))
 			throw packet_exception();
@@ -192,20 +215,28 @@ void packet_out::encrypt()
 	if (have_encrypted)
 		return;
 
+	// The cleartext is serialized behind room for the nonce and MAC,
+	// so that it can be encrypted in place without moving it around.
+	// This gives the same layout as crypto_secretbox_easy.
+	std::size_t headerSize = 0;
+#ifndef NONET
+	if (!DisableEncryption)
+		headerSize = crypto_secretbox_NONCEBYTES + crypto_secretbox_MACBYTES;
+#endif
+	encrypted_buffer.reserve(headerSize + sizeof(packet_type) + 2 * sizeof(plr_t)
+	    + sizeof(cookie_t) + sizeof(turn_t) + m_message.size() + m_info.size());
+	encrypted_buffer.resize(headerSize);
+
 	process_data();
 
 #ifndef NONET
 	if (!DisableEncryption) {
-		auto lenCleartext = encrypted_buffer.size();
-		encrypted_buffer.insert(encrypted_buffer.begin(),
-		    crypto_secretbox_NONCEBYTES, 0);
-		encrypted_buffer.insert(encrypted_buffer.end(),
-		    crypto_secretbox_MACBYTES, 0);
+		auto lenCleartext = encrypted_buffer.size() - headerSize;
 		randombytes_buf(encrypted_buffer.data(), crypto_secretbox_NONCEBYTES);
-		if (crypto_secretbox_easy(encrypted_buffer.data()
-		            + crypto_secretbox_NONCEBYTES,
+		if (crypto_secretbox_detached(encrypted_buffer.data() + headerSize,
 		        encrypted_buffer.data()
 		            + crypto_secretbox_NONCEBYTES,
+		        encrypted_buffer.data() + headerSize,
 		        lenCleartext,
 		        encrypted_buffer.data(),
 		        key.data()))
@@ -222,6 +253,11 @@ packet_factory::packet_factory(std::string pw)
 		ABORT();
 	pw.resize(std::min<std::size_t>(pw.size(), crypto_pwhash_argon2id_PASSWD_MAX));
 	pw.resize(std::max<std::size_t>(pw.size(), crypto_pwhash_argon2id_PASSWD_MIN), 0);
+	std::lock_guard<std::mutex> lock(DerivedKeyMutex);
+	if (DerivedKeyValid && DerivedKeyPassword == pw) {
+		key = DerivedKey;
+		return;
+	}
 	std::string salt("W9bE9dQgVaeybwr2");
 	salt.resize(crypto_pwhash_argon2id_SALTBYTES, 0);
 	if (crypto_pwhash(key.data(), crypto_secretbox_KEYBYTES,
@@ -231,6 +267,9 @@ packet_factory::packet_factory(std::string pw)
 	        2 * crypto_pwhash_argon2id_MEMLIMIT_MIN,
 	        crypto_pwhash_ALG_ARGON2ID13))
 		ABORT();
+	DerivedKey = key;
+	DerivedKeyPassword = std::move(pw);
+	DerivedKeyValid = true;
 #endif
 }
 
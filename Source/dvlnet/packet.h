@@ -17,14 +17,16 @@ namespace net {
 
 enum packet_type : uint8_t {
 	// clang-format off
-	PT_MESSAGE      = 0x01,
-	PT_TURN         = 0x02,
-	PT_JOIN_REQUEST = 0x11,
-	PT_JOIN_ACCEPT  = 0x12,
-	PT_CONNECT      = 0x13,
-	PT_DISCONNECT   = 0x14,
-	PT_INFO_REQUEST = 0x21,
-	PT_INFO_REPLY   = 0x22,
+	PT_MESSAGE          = 0x01,
+	PT_TURN             = 0x02,
+	PT_BATCH            = 0x03,
+	PT_COMPRESSED_BATCH = 0x04,
+	PT_JOIN_REQUEST     = 0x11,
+	PT_JOIN_ACCEPT      = 0x12,
+	PT_CONNECT          = 0x13,
+	PT_DISCONNECT       = 0x14,
+	PT_INFO_REQUEST     = 0x21,
+	PT_INFO_REPLY       = 0x22,
 	// clang-format on
 };
 
@@ -93,6 +95,7 @@ public:
 	packet_type type();
 	plr_t src();
 	plr_t dest();
+	/** @brief Payload of a PT_MESSAGE, or the packed messages and turns of a PT_BATCH or PT_COMPRESSED_BATCH */
 	const buffer_t &message();
 	turn_t turn();
 	cookie_t cookie();
@@ -116,6 +119,10 @@ public:
 	template <class T>
 	void process_element(T &x);
 	void decrypt();
+
+private:
+	/** Number of bytes of decrypted_buffer that have already been parsed */
+	std::size_t decrypted_offset = 0;
 };
 
 class packet_out : public packet_proc<packet_out> {
@@ -144,6 +151,8 @@ void packet_proc<P>::process_data()
 	self.process_element(m_dest);
 	switch (m_type) {
 	case PT_MESSAGE:
+	case PT_BATCH:
+	case PT_COMPRESSED_BATCH:
 		self.process_element(m_message);
 		break;
 	case PT_TURN:
@@ -176,18 +185,17 @@ void packet_proc<P>::process_data()
 
 inline void packet_in::process_element(buffer_t &x)
 {
-	x.insert(x.begin(), decrypted_buffer.begin(), decrypted_buffer.end());
-	decrypted_buffer.resize(0);
+	x.assign(decrypted_buffer.begin() + decrypted_offset, decrypted_buffer.end());
+	decrypted_offset = decrypted_buffer.size();
 }
 
 template <class T>
 void packet_in::process_element(T &x)
 {
-	if (decrypted_buffer.size() < sizeof(T))
+	if (decrypted_buffer.size() - decrypted_offset < sizeof(T))
 		throw packet_exception();
-	std::memcpy(&x, decrypted_buffer.data(), sizeof(T));
-	decrypted_buffer.erase(decrypted_buffer.begin(),
-	    decrypted_buffer.begin() + sizeof(T));
+	std::memcpy(&x, decrypted_buffer.data() + decrypted_offset, sizeof(T));
+	decrypted_offset += sizeof(T);
 }
 
 template <>
@@ -225,6 +233,33 @@ inline void packet_out::create<PT_MESSAGE>(plr_t s, plr_t d, buffer_t m)
 	m_message = std::move(m);
 }
 
+template <>
+inline void packet_out::create<PT_BATCH>(plr_t s, plr_t d, buffer_t m)
+{
+	if (have_encrypted || have_decrypted)
+		ABORT();
+	have_decrypted = true;
+	m_type = PT_BATCH;
+	m_src = s;
+	m_dest = d;
+	m_message = std::move(m);
+}
+
+/**
+ * @param m Size of the batch as 16-bit little-endian, followed by the batch compressed with PkwareCompress
+ */
+template <>
+inline void packet_out::create<PT_COMPRESSED_BATCH>(plr_t s, plr_t d, buffer_t m)
+{
+	if (have_encrypted || have_decrypted)
+		ABORT();
+	have_decrypted = true;
+	m_type = PT_COMPRESSED_BATCH;
+	m_src = s;
+	m_dest = d;
+	m_message = std::move(m);
+}
+
 template <>
 inline void packet_out::create<PT_TURN>(plr_t s, plr_t d, turn_t u)
 {
@@ -86,12 +86,49 @@ bool protocol_zt::network_online()
 	return true;
 }
 
+void protocol_zt::wait_event(uint32_t timeoutMs)
+{
+	if (fd_udp == -1) {
+		zerotier_wait_network_ready(timeoutMs);
+		return;
+	}
+
+	fd_set readfds;
+	FD_ZERO(&readfds);
+	FD_SET(fd_udp, &readfds);
+	int maxfd = fd_udp;
+	if (fd_tcp != -1) {
+		FD_SET(fd_tcp, &readfds);
+		maxfd = std::max(maxfd, fd_tcp);
+	}
+	for (auto &peer : peer_list) {
+		if (peer.second.fd != -1) {
+			FD_SET(peer.second.fd, &readfds);
+			maxfd = std::max(maxfd, peer.second.fd);
+		}
+	}
+
+	struct timeval timeout {
+	};
+	timeout.tv_sec = timeoutMs / 1000;
+	timeout.tv_usec = (timeoutMs % 1000) * 1000;
+	lwip_select(maxfd + 1, &readfds, nullptr, nullptr, &timeout);
+}
+
 bool protocol_zt::send(const endpoint &peer, const buffer_t &data)
 {
 	peer_list[peer].send_queue.push_back(frame_queue::make_frame(data));
 	return true;
 }
 
+std::size_t protocol_zt::send_queue_depth() const
+{
+	std::size_t depth = 0;
+	for (const auto &peer : peer_list)
+		depth += peer.second.send_queue.size();
+	return depth;
+}
+
 bool protocol_zt::send_oob(const endpoint &peer, const buffer_t &data)
 {
 	struct sockaddr_in6 in6 {
@@ -73,6 +73,11 @@ public:
 	bool recv(endpoint &peer, buffer_t &data);
 	bool get_disconnected(endpoint &peer);
 	bool network_online();
+	/**
+	 * @brief Block until the network comes up or one of the sockets has data, at most for the given time
+	 */
+	void wait_event(uint32_t timeoutMs);
+	std::size_t send_queue_depth() const;
 	static std::string make_default_gamename();
 
 private:
@@ -0,0 +1,196 @@
+/**
+ * @file relay_server_main.cpp
+ *
+ * Standalone server that relays TCP games without running a game client.
+ *
+ * Usage: devilutionx_server [--bind <address>] [--port <first port>] [--games <count>]
+ *                           [--threads <count>] [--password <password>] [--stats <seconds>] [--json]
+ *
+ * Every game is a tcp_server listening on its own port, starting at the given one.
+ * Clients join a game by connecting to its port, exactly as they would to a player hosting it.
+ *
+ * Nobody hosts these games, so the first player to join a game provides its settings and seed.
+ *
+ * The counters of every active game are printed every `--stats` seconds, as one JSON object
+ * per line with `--json` so they can be collected by a log shipper.
+ */
+#define SDL_MAIN_HANDLED
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <asio/executor_work_guard.hpp>
+
+#include "dvlnet/tcp_server.h"
+
+using namespace devilution::net;
+
+namespace {
+
+std::atomic<bool> Running { true };
+
+void HandleSignal(int /*signal*/)
+{
+	Running = false;
+}
+
+struct ServerOptions {
+	std::string bindAddress = "0.0.0.0";
+	unsigned short port = 6112;
+	unsigned games = 1;
+	unsigned threads = std::max(std::thread::hardware_concurrency(), 1U);
+	std::string password;
+	unsigned statsInterval = 60;
+	bool jsonStats = false;
+};
+
+enum class ParseResult {
+	Run,
+	Help,
+	Error,
+};
+
+void PrintUsage(FILE *out, const char *name)
+{
+	fprintf(out, "Usage: %s [--bind <address>] [--port <first port>] [--games <count>] [--threads <count>] [--password <password>] [--stats <seconds>] [--json]\n", name);
+}
+
+ParseResult ParseOptions(int argc, char **argv, ServerOptions &options)
+{
+	for (int i = 1; i < argc; i++) {
+		const bool hasValue = i + 1 < argc;
+		if (strcmp(argv[i], "--help") == 0 || strcmp(argv[i], "-h") == 0) {
+			PrintUsage(stdout, argv[0]);
+			return ParseResult::Help;
+		} else if (strcmp(argv[i], "--bind") == 0 && hasValue) {
+			options.bindAddress = argv[++i];
+		} else if (strcmp(argv[i], "--port") == 0 && hasValue) {
+			options.port = static_cast<unsigned short>(std::atoi(argv[++i]));
+		} else if (strcmp(argv[i], "--games") == 0 && hasValue) {
+			options.games = std::max(std::atoi(argv[++i]), 1);
+		} else if (strcmp(argv[i], "--threads") == 0 && hasValue) {
+			options.threads = std::max(std::atoi(argv[++i]), 1);
+		} else if (strcmp(argv[i], "--password") == 0 && hasValue) {
+			options.password = argv[++i];
+		} else if (strcmp(argv[i], "--stats") == 0 && hasValue) {
+			options.statsInterval = std::max(std::atoi(argv[++i]), 0);
+		} else if (strcmp(argv[i], "--json") == 0) {
+			options.jsonStats = true;
+		} else {
+			fprintf(stderr, "Unknown option or missing value: %s\n", argv[i]);
+			PrintUsage(stderr, argv[0]);
+			return ParseResult::Error;
+		}
+	}
+	return ParseResult::Run;
+}
+
+void PrintStats(const std::vector<std::unique_ptr<tcp_server>> &servers, const ServerOptions &options)
+{
+	const long long now = std::chrono::duration_cast<std::chrono::seconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+	for (std::size_t i = 0; i < servers.size(); i++) {
+		const tcp_server::stats_t &stats = servers[i]->stats();
+		const uint32_t clients = stats.clients;
+		const uint64_t packets = stats.packets_sent;
+		if (clients == 0 && packets == 0)
+			continue;
+		const uint64_t sendTime = stats.send_time_us;
+		const double sendLatency = packets != 0 ? static_cast<double>(sendTime) / packets : 0.0;
+		const double relayLatency = packets != 0 ? static_cast<double>(stats.relay_time_us.load()) / packets : 0.0;
+		const unsigned port = static_cast<unsigned>(options.port + i);
+		if (options.jsonStats) {
+			printf("{\"time\":%lld,\"port\":%u,\"clients\":%u,\"packets_sent\":%llu,\"bytes_sent\":%llu,"
+			       "\"packets_received\":%llu,\"bytes_received\":%llu,\"send_latency_us\":%.1f,\"relay_latency_us\":%.1f,\"disconnects\":%u,\"timeouts\":%u}\n",
+			    now, port, clients,
+			    static_cast<unsigned long long>(packets),
+			    static_cast<unsigned long long>(stats.bytes_sent.load()),
+			    static_cast<unsigned long long>(stats.packets_received.load()),
+			    static_cast<unsigned long long>(stats.bytes_received.load()),
+			    sendLatency, relayLatency, stats.disconnects.load(), stats.timeouts.load());
+		} else {
+			printf("port %u: %u clients, %llu packets, %llu bytes sent, %llu bytes received, %.1f us average send latency, %.1f us average relay latency, %u disconnects\n",
+			    port, clients,
+			    static_cast<unsigned long long>(packets),
+			    static_cast<unsigned long long>(stats.bytes_sent.load()),
+			    static_cast<unsigned long long>(stats.bytes_received.load()),
+			    sendLatency, relayLatency, stats.disconnects.load());
+		}
+	}
+	fflush(stdout);
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+	ServerOptions options;
+	switch (ParseOptions(argc, argv, options)) {
+	case ParseResult::Run:
+		break;
+	case ParseResult::Help:
+		return EXIT_SUCCESS;
+	case ParseResult::Error:
+		return EXIT_FAILURE;
+	}
+
+	// A game only ever runs on the io_context it was created with, and every io_context
+	// is run by a single thread, so the handlers of one game never run concurrently.
+	const unsigned contextCount = std::min(options.threads, options.games);
+	std::vector<std::unique_ptr<asio::io_context>> contexts;
+	std::vector<asio::executor_work_guard<asio::io_context::executor_type>> workGuards;
+	for (unsigned i = 0; i < contextCount; i++) {
+		contexts.push_back(std::make_unique<asio::io_context>(1));
+		workGuards.push_back(asio::make_work_guard(*contexts.back()));
+	}
+
+	std::vector<std::unique_ptr<tcp_server>> servers;
+	try {
+		for (unsigned i = 0; i < options.games; i++) {
+			asio::io_context &ioc = *contexts[i % contextCount];
+			servers.push_back(std::make_unique<tcp_server>(ioc, options.bindAddress, options.port + i, options.password));
+		}
+	} catch (std::exception &e) {
+		fprintf(stderr, "Unable to start the server: %s\n", e.what());
+		return EXIT_FAILURE;
+	}
+	printf("Relaying %u games on ports %u-%u using %u threads\n", options.games,
+	    options.port, options.port + options.games - 1, contextCount);
+	fflush(stdout);
+
+	std::vector<std::thread> threads;
+	for (auto &ioc : contexts) {
+		threads.emplace_back([&ioc]() {
+			ioc->run();
+		});
+	}
+
+	std::signal(SIGINT, HandleSignal);
+	std::signal(SIGTERM, HandleSignal);
+	auto lastStats = std::chrono::steady_clock::now();
+	while (Running) {
+		std::this_thread::sleep_for(std::chrono::milliseconds(250));
+		const auto now = std::chrono::steady_clock::now();
+		if (options.statsInterval != 0 && now - lastStats >= std::chrono::seconds(options.statsInterval)) {
+			PrintStats(servers, options);
+			lastStats = now;
+		}
+	}
+
+	for (auto &ioc : contexts)
+		ioc->stop();
+	for (auto &thread : threads)
+		thread.join();
+	PrintStats(servers, options);
+	servers.clear();
+
+	return EXIT_SUCCESS;
+}
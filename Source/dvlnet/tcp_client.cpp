@@ -88,9 +88,8 @@ void tcp_client::handle_recv(const asio::error_code &error, size_t bytesRead)
 	if (bytesRead == 0) {
 		throw std::runtime_error(_("error: read 0 bytes from server"));
 	}
-	recv_buffer.resize(bytesRead);
-	recv_queue.write(std::move(recv_buffer));
-	recv_buffer.resize(frame_queue::max_frame_size);
+	// Copy out only what was read, so the receive buffer doesn't have to be reallocated at its full size
+	recv_queue.write(buffer_t(recv_buffer.begin(), recv_buffer.begin() + bytesRead));
 	while (recv_queue.packet_ready()) {
 		auto pkt = pktfty->make_packet(recv_queue.read_packet());
 		recv_local(*pkt);
@@ -112,14 +111,28 @@ void tcp_client::handle_send(const asio::error_code &error, size_t bytesSent)
 
 void tcp_client::send(packet &pkt)
 {
-	const auto *frame = new buffer_t(frame_queue::make_frame(pkt.data()));
+	buffer_t *frame;
+	if (free_frames.empty()) {
+		frame = new buffer_t();
+	} else {
+		frame = free_frames.back().release();
+		free_frames.pop_back();
+	}
+	frame_queue::make_frame(pkt.data(), *frame);
 	auto buf = asio::buffer(*frame);
+	frames_in_flight++;
 	asio::async_write(sock, buf, [this, frame](const asio::error_code &error, size_t bytesSent) {
+		frames_in_flight--;
 		handle_send(error, bytesSent);
-		delete frame;
+		free_frames.emplace_back(frame);
 	});
 }
 
+uint32_t tcp_client::send_queue_depth()
+{
+	return frames_in_flight;
+}
+
 bool tcp_client::SNetLeaveGame(int type)
 {
 	auto ret = base::SNetLeaveGame(type);
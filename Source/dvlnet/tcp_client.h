@@ -37,10 +37,14 @@ private:
 	asio::ip::tcp::resolver resolver = asio::ip::tcp::resolver(ioc);
 	asio::ip::tcp::socket sock = asio::ip::tcp::socket(ioc);
 	std::unique_ptr<tcp_server> local_server; // must be declared *after* ioc
+	uint32_t frames_in_flight = 0;
+	/** Frames whose writes have completed, kept to be reused by the next sends */
+	std::vector<std::unique_ptr<buffer_t>> free_frames;
 
 	void handle_recv(const asio::error_code &error, size_t bytes_read);
 	void start_recv();
 	void handle_send(const asio::error_code &error, size_t bytes_sent);
+	virtual uint32_t send_queue_depth();
 };
 
 } // namespace net
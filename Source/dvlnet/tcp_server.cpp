@@ -37,6 +37,11 @@ std::string tcp_server::localhost_self()
 	return addr.to_string();
 }
 
+const tcp_server::stats_t &tcp_server::stats() const
+{
+	return stats_;
+}
+
 tcp_server::scc tcp_server::make_connection()
 {
 	return std::make_shared<client_connection>(ioc);
@@ -73,17 +78,18 @@ void tcp_server::handle_recv(const scc &con, const asio::error_code &ec,
 		drop_connection(con);
 		return;
 	}
-	con->recv_buffer.resize(bytesRead);
-	con->recv_queue.write(std::move(con->recv_buffer));
-	con->recv_buffer.resize(frame_queue::max_frame_size);
+	const auto received = std::chrono::steady_clock::now();
+	stats_.bytes_received += bytesRead;
+	con->recv_queue.write(buffer_t(con->recv_buffer.begin(), con->recv_buffer.begin() + bytesRead));
 	while (con->recv_queue.packet_ready()) {
 		try {
 			auto pkt = pktfty.make_packet(con->recv_queue.read_packet());
+			stats_.packets_received++;
 			if (con->plr == PLR_BROADCAST) {
 				handle_recv_newplr(con, *pkt);
 			} else {
 				con->timeout = timeout_active;
-				handle_recv_packet(*pkt);
+				handle_recv_packet(*pkt, received);
 			}
 		} catch (dvlnet_exception &e) {
 			Log("Network error: {}", e.what());
@@ -106,45 +112,93 @@ void tcp_server::handle_recv_newplr(const scc &con, packet &pkt)
 	auto newplr = next_free();
 	if (newplr == PLR_BROADCAST)
 		throw server_exception();
+	// The first player to join provides the game data, everyone joining after them receives it.
+	// With a relay server there is no host that set it up when creating the game.
 	if (empty())
 		game_init_info = pkt.info();
 	auto reply = pktfty.make_packet<PT_JOIN_ACCEPT>(PLR_MASTER, PLR_BROADCAST,
 	    pkt.cookie(), newplr,
 	    game_init_info);
-	start_send(con, *reply);
+	start_send(con, make_frame(*reply));
 	con->plr = newplr;
 	connections[newplr] = con;
+	stats_.clients++;
 	con->timeout = timeout_active;
 	send_connect(con);
 }
 
-void tcp_server::handle_recv_packet(packet &pkt)
+void tcp_server::handle_recv_packet(packet &pkt, std::chrono::steady_clock::time_point received)
 {
-	send_packet(pkt);
+	send_packet(pkt, received);
 }
 
 void tcp_server::send_packet(packet &pkt)
+{
+	send_packet(pkt, std::chrono::steady_clock::now());
+}
+
+void tcp_server::send_packet(packet &pkt, std::chrono::steady_clock::time_point received)
 {
 	if (pkt.dest() == PLR_BROADCAST) {
-		for (auto i = 0; i < MAX_PLRS; ++i)
-			if (i != pkt.src() && connections[i])
-				start_send(connections[i], pkt);
+		// Frame the packet once and let every connection send the same buffer
+		frame_ptr frame;
+		for (auto i = 0; i < MAX_PLRS; ++i) {
+			if (i != pkt.src() && connections[i]) {
+				if (!frame)
+					frame = make_frame(pkt);
+				start_send(connections[i], frame, received);
+			}
+		}
 	} else {
 		if (pkt.dest() >= MAX_PLRS)
 			throw server_exception();
 		if ((pkt.dest() != pkt.src()) && connections[pkt.dest()])
-			start_send(connections[pkt.dest()], pkt);
+			start_send(connections[pkt.dest()], make_frame(pkt), received);
 	}
 }
 
-void tcp_server::start_send(const scc &con, packet &pkt)
+tcp_server::frame_ptr tcp_server::make_frame(packet &pkt)
+{
+	return std::make_shared<const buffer_t>(frame_queue::make_frame(pkt.data()));
+}
+
+void tcp_server::start_send(const scc &con, const frame_ptr &frame)
+{
+	start_send(con, frame, std::chrono::steady_clock::now());
+}
+
+void tcp_server::start_send(const scc &con, const frame_ptr &frame, std::chrono::steady_clock::time_point received)
 {
-	const auto *frame = new buffer_t(frame_queue::make_frame(pkt.data()));
-	auto buf = asio::buffer(*frame);
-	asio::async_write(con->socket, buf,
-	    [this, con, frame](const asio::error_code &ec, size_t bytesSent) {
+	con->send_queue.push_back({ frame, received, std::chrono::steady_clock::now() });
+	if (con->sending.empty())
+		start_write(con);
+}
+
+void tcp_server::start_write(const scc &con)
+{
+	// Everything queued while the previous write was in progress goes out in a single write
+	con->sending.swap(con->send_queue);
+	std::vector<asio::const_buffer> bufs;
+	bufs.reserve(con->sending.size());
+	for (const queued_frame &entry : con->sending)
+		bufs.push_back(asio::buffer(*entry.frame));
+	asio::async_write(con->socket, bufs,
+	    [this, con](const asio::error_code &ec, size_t bytesSent) {
+		    if (!ec) {
+			    const auto now = std::chrono::steady_clock::now();
+			    for (const queued_frame &entry : con->sending) {
+				    stats_.send_time_us += std::chrono::duration_cast<std::chrono::microseconds>(now - entry.queued).count();
+				    stats_.relay_time_us += std::chrono::duration_cast<std::chrono::microseconds>(now - entry.received).count();
+			    }
+			    stats_.packets_sent += con->sending.size();
+			    stats_.bytes_sent += bytesSent;
+		    }
+		    con->sending.clear();
 		    handle_send(con, ec, bytesSent);
-		    delete frame;
+		    if (ec)
+			    con->send_queue.clear();
+		    else if (!con->send_queue.empty())
+			    start_write(con);
 	    });
 }
 
@@ -197,6 +251,8 @@ void tcp_server::handle_timeout(const scc &con, const asio::error_code &ec)
 	if (con->timeout < 0)
 		con->timeout = 0;
 	if (!con->timeout) {
+		if (con->plr != PLR_BROADCAST && connections[con->plr] == con)
+			stats_.timeouts++;
 		drop_connection(con);
 		return;
 	}
@@ -208,6 +264,10 @@ void tcp_server::drop_connection(const scc &con)
 	if (con->plr != PLR_BROADCAST) {
 		auto pkt = pktfty.make_packet<PT_DISCONNECT>(PLR_MASTER, PLR_BROADCAST,
 		    con->plr, LEAVE_DROP);
+		if (connections[con->plr] == con) {
+			stats_.clients--;
+			stats_.disconnects++;
+		}
 		connections[con->plr] = nullptr;
 		send_packet(*pkt);
 		// TODO: investigate if it is really ok for the server to
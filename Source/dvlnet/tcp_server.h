@@ -3,6 +3,10 @@
 #include <string>
 #include <memory>
 #include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <vector>
 #include <asio/ts/buffer.hpp>
 #include <asio/ts/internet.hpp>
 #include <asio/ts/io_context.hpp>
@@ -25,9 +29,27 @@ public:
 
 class tcp_server {
 public:
+	/** Relay counters, updated on the io_context thread and safe to read from any thread */
+	struct stats_t {
+		std::atomic<uint32_t> clients { 0 };
+		std::atomic<uint64_t> packets_sent { 0 };
+		std::atomic<uint64_t> bytes_sent { 0 };
+		std::atomic<uint64_t> packets_received { 0 };
+		std::atomic<uint64_t> bytes_received { 0 };
+		/** Total time between queueing a packet and the socket accepting it */
+		std::atomic<uint64_t> send_time_us { 0 };
+		/** Total time between reading a packet from its sender and the socket of a recipient accepting it */
+		std::atomic<uint64_t> relay_time_us { 0 };
+		/** Players that left the game, for any reason */
+		std::atomic<uint32_t> disconnects { 0 };
+		/** Players dropped for not sending anything in time, also counted in disconnects */
+		std::atomic<uint32_t> timeouts { 0 };
+	};
+
 	tcp_server(asio::io_context &ioc, const std::string &bindaddr,
 	    unsigned short port, std::string pw);
 	std::string localhost_self();
+	const stats_t &stats() const;
 	void close();
 	virtual ~tcp_server();
 
@@ -35,6 +57,16 @@ private:
 	static constexpr int timeout_connect = 30;
 	static constexpr int timeout_active = 60;
 
+	/** A framed packet, shared by the sends of all connections that it goes to */
+	typedef std::shared_ptr<const buffer_t> frame_ptr;
+
+	struct queued_frame {
+		frame_ptr frame;
+		/** When the packet was read from its sender, or created if the server sends it */
+		std::chrono::steady_clock::time_point received;
+		std::chrono::steady_clock::time_point queued;
+	};
+
 	struct client_connection {
 		frame_queue recv_queue;
 		buffer_t recv_buffer = buffer_t(frame_queue::max_frame_size);
@@ -42,6 +74,10 @@ private:
 		asio::ip::tcp::socket socket;
 		asio::steady_timer timer;
 		int timeout;
+		/** Frames waiting for the write in progress, they are sent together once it completes */
+		std::vector<queued_frame> send_queue;
+		/** Frames of the write in progress */
+		std::vector<queued_frame> sending;
 		client_connection(asio::io_context &ioc)
 		    : socket(ioc)
 		    , timer(ioc)
@@ -56,6 +92,7 @@ private:
 	std::unique_ptr<asio::ip::tcp::acceptor> acceptor;
 	std::array<scc, MAX_PLRS> connections;
 	buffer_t game_init_info;
+	stats_t stats_;
 
 	scc make_connection();
 	plr_t next_free();
@@ -65,10 +102,14 @@ private:
 	void start_recv(const scc &con);
 	void handle_recv(const scc &con, const asio::error_code &ec, size_t bytes_read);
 	void handle_recv_newplr(const scc &con, packet &pkt);
-	void handle_recv_packet(packet &pkt);
+	void handle_recv_packet(packet &pkt, std::chrono::steady_clock::time_point received);
 	void send_connect(const scc &con);
 	void send_packet(packet &pkt);
-	void start_send(const scc &con, packet &pkt);
+	void send_packet(packet &pkt, std::chrono::steady_clock::time_point received);
+	static frame_ptr make_frame(packet &pkt);
+	void start_send(const scc &con, const frame_ptr &frame);
+	void start_send(const scc &con, const frame_ptr &frame, std::chrono::steady_clock::time_point received);
+	void start_write(const scc &con);
 	void handle_send(const scc &con, const asio::error_code &ec, size_t bytes_sent);
 	void start_timeout(const scc &con);
 	void handle_timeout(const scc &con, const asio::error_code &ec);
@@ -2,6 +2,9 @@
 
 #include <SDL.h>
 #include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
 
 #ifdef USE_SDL1
 #include "utils/sdl2_to_1_2_backports.h"
@@ -28,6 +31,16 @@ static std::atomic_bool zt_node_online(false);
 static std::atomic_bool zt_started(false);
 static std::atomic_bool zt_joined(false);
 
+/** Signalled from the ZeroTier thread whenever the node or network state changes */
+static std::mutex zt_state_mutex;
+static std::condition_variable zt_state_changed;
+
+static void NotifyStateChanged()
+{
+	std::lock_guard<std::mutex> lock(zt_state_mutex);
+	zt_state_changed.notify_all();
+}
+
 static void Callback(struct zts_callback_msg *msg)
 {
 	//printf("callback %i\n", msg->eventCode);
@@ -38,13 +51,16 @@ static void Callback(struct zts_callback_msg *msg)
 			zts_join(ZtNetwork);
 			zt_joined = true;
 		}
+		NotifyStateChanged();
 	} else if (msg->eventCode == ZTS_EVENT_NODE_OFFLINE) {
 		Log("ZeroTier: ZTS_EVENT_NODE_OFFLINE");
 		zt_node_online = false;
+		NotifyStateChanged();
 	} else if (msg->eventCode == ZTS_EVENT_NETWORK_READY_IP6) {
 		Log("ZeroTier: ZTS_EVENT_NETWORK_READY_IP6, networkId={:x}", (unsigned long long)msg->network->nwid);
 		zt_ip6setup();
 		zt_network_ready = true;
+		NotifyStateChanged();
 	} else if (msg->eventCode == ZTS_EVENT_ADDR_ADDED_IP6) {
 		print_ip6_addr(&(msg->addr->addr));
 	}
@@ -55,6 +71,12 @@ bool zerotier_network_ready()
 	return zt_network_ready && zt_node_online;
 }
 
+bool zerotier_wait_network_ready(uint32_t timeoutMs)
+{
+	std::unique_lock<std::mutex> lock(zt_state_mutex);
+	return zt_state_changed.wait_for(lock, std::chrono::milliseconds(timeoutMs), zerotier_network_ready);
+}
+
 void zerotier_network_stop()
 {
 	zts_stop();
@@ -62,7 +84,7 @@ void zerotier_network_stop()
 
 void zerotier_network_start()
 {
-	if (zt_started)
+	if (zt_started.exchange(true))
 		return;
 	std::string ztpath = paths::PrefPath() + "zerotier";
 	zts_start(ztpath.c_str(), (void (*)(void *))Callback, 0);
@@ -1,9 +1,16 @@
 #pragma once
 
+#include <cstdint>
+
 namespace devilution {
 namespace net {
 
 bool zerotier_network_ready();
+/**
+ * @brief Block until the ZeroTier network is ready or the timeout runs out, woken by the ZeroTier callback
+ * @return zerotier_network_ready()
+ */
+bool zerotier_wait_network_ready(uint32_t timeoutMs);
 void zerotier_network_start();
 void zerotier_network_stop();
 
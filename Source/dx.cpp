@@ -7,11 +7,19 @@
 
 #include <SDL.h>
 
+#include <algorithm>
+#include <array>
+#include <thread>
+
+#include "DiabloUI/ui_texture.h"
 #include "engine.h"
 #include "options.h"
+#include "scrollrt.h"
 #include "storm/storm.h"
 #include "utils/display.h"
 #include "utils/log.hpp"
+#include "utils/profiler.h"
+#include "utils/thread_pool.h"
 
 #ifdef __3DS__
 #include <3ds.h>
@@ -26,6 +34,8 @@ int locktbl[256];
 static CCritSect sgMemCrit;
 
 int refreshDelay;
+/** Number of frames that reached the limiter after their deadline had already passed */
+static uint32_t missedFrameDeadlines;
 SDL_Renderer *renderer;
 SDL_Texture *texture;
 
@@ -60,6 +70,234 @@ bool CanRenderDirectlyToOutputSurface()
 #endif
 }
 
+#ifndef USE_SDL1
+/** Whether the next frame is converted from `pal_surface` straight into the renderer texture */
+bool PresentFromPalSurface;
+
+/** Whether frames were presented without being blitted to the output surface */
+bool OutputSurfaceStale;
+
+/** `palette` mapped to the pixel format of the renderer texture */
+std::array<Uint32, 256> TexturePalette;
+unsigned int TexturePaletteVersion = 0;
+
+/** Part of `pal_surface` blitted since it was last converted to the renderer texture, empty if `w` is 0 */
+SDL_Rect PalSurfaceDirtyRect;
+
+/** Whether the renderer texture holds the last conversion of `pal_surface`, so only the dirty part needs converting */
+bool TextureHoldsPalSurface;
+
+void MarkPalSurfaceDirty(const SDL_Rect *rect)
+{
+	const SDL_Rect whole { 0, 0, pal_surface->w, pal_surface->h };
+	if (rect == nullptr || PalSurfaceDirtyRect.w == 0) {
+		PalSurfaceDirtyRect = rect != nullptr ? *rect : whole;
+	} else {
+		SDL_UnionRect(&PalSurfaceDirtyRect, rect, &PalSurfaceDirtyRect);
+	}
+	SDL_IntersectRect(&PalSurfaceDirtyRect, &whole, &PalSurfaceDirtyRect);
+}
+
+bool CanPresentFromPalSurface()
+{
+	return renderer != nullptr && sgOptions.Graphics.bPalettedPresent && renderer_texture_surface != nullptr
+	    && renderer_texture_surface->format->BytesPerPixel == 4
+	    && renderer_texture_surface->w == pal_surface->w && renderer_texture_surface->h == pal_surface->h;
+}
+
+/**
+ * @brief Bring the output surface up to date before something else is drawn on top of it.
+ */
+void RestoreOutputSurface()
+{
+	PresentFromPalSurface = false;
+	if (!OutputSurfaceStale)
+		return;
+	OutputSurfaceStale = false;
+	if (SDL_BlitSurface(pal_surface, nullptr, GetOutputSurface(), nullptr) < 0)
+		ErrSdl();
+}
+
+/**
+ * @brief Look up every pixel of `pal_surface` in the palette while writing it to the renderer texture.
+ *
+ * This replaces blitting to the 32-bit output surface and then copying that to the texture,
+ * so a frame only reads the 8-bit indices once and writes the texture once.
+ * The renderers themselves stay 8-bit: there is no 32-bit CelOutputBuffer and lighting is still done
+ * with the palette light tables.
+ */
+void ConvertPalSurfaceToTexture()
+{
+	if (TexturePaletteVersion != pal_surface_palette_version) {
+		const SDL_PixelFormat *format = renderer_texture_surface->format;
+		for (int i = 0; i < 256; i++) {
+			const SDL_Color &color = palette->colors[i];
+			TexturePalette[i] = SDL_MapRGB(format, color.r, color.g, color.b);
+		}
+		TexturePaletteVersion = pal_surface_palette_version;
+		TextureHoldsPalSurface = false;
+	}
+
+	// Pixels outside of the locked rectangle keep the previous frame.
+	SDL_Rect rect = PalSurfaceDirtyRect;
+	if (!TextureHoldsPalSurface)
+		rect = { 0, 0, pal_surface->w, pal_surface->h };
+	PalSurfaceDirtyRect = {};
+	if (rect.w <= 0 || rect.h <= 0)
+		return;
+
+	void *pixels;
+	int pitch;
+	if (SDL_LockTexture(texture, &rect, &pixels, &pitch) < 0)
+		ErrSdl();
+	const auto *srcBegin = static_cast<const Uint8 *>(pal_surface->pixels) + rect.y * pal_surface->pitch + rect.x;
+	const auto convertRows = [&](int first, int last) {
+		const Uint8 *src = srcBegin + first * pal_surface->pitch;
+		auto *dst = static_cast<Uint8 *>(pixels) + first * pitch;
+		for (int y = first; y < last; y++) {
+			auto *dstRow = reinterpret_cast<Uint32 *>(dst);
+			for (int x = 0; x < rect.w; x++)
+				dstRow[x] = TexturePalette[src[x]];
+			src += pal_surface->pitch;
+			dst += pitch;
+		}
+	};
+
+	// The renderer itself must stay on this thread, but the locked pixels can be written from any.
+	constexpr int MinRowsPerJob = 64;
+	ThreadPool *pool = GetRenderThreadPool();
+	const int jobs = pool != nullptr ? std::min<int>(pool->Concurrency(), rect.h / MinRowsPerJob) : 1;
+	if (jobs > 1) {
+		pool->ParallelFor(jobs, [&](unsigned job) {
+			convertRows(rect.h * job / jobs, rect.h * (job + 1) / jobs);
+		});
+	} else {
+		convertRows(0, rect.h);
+	}
+	SDL_UnlockTexture(texture);
+	TextureHoldsPalSurface = true;
+}
+
+#if SDL_VERSION_ATLEAST(2, 0, 12)
+/** `texture` scaled up by a whole factor, see `GraphicsOptions::bSharpScaling` */
+SDL_Texture *SharpTexture;
+
+/** Average time between presented frames in microseconds, see `GraphicsOptions::bAdaptiveScaling` */
+Uint64 AverageFrameTime;
+/** Whether the sharp scaling pass is skipped because frames fell behind the display */
+bool SharpScalingSuspended;
+/** Frames in a row that kept up with the display while sharp scaling was suspended */
+int FramesKeepingUp;
+
+/**
+ * @brief The scale mode SDL picks for new textures from `GraphicsOptions::szScaleQuality`.
+ */
+SDL_ScaleMode ConfiguredScaleMode()
+{
+	const char *quality = sgOptions.Graphics.szScaleQuality;
+	int mode;
+	if (SDL_strcasecmp(quality, "nearest") == 0)
+		mode = SDL_ScaleModeNearest;
+	else if (SDL_strcasecmp(quality, "linear") == 0)
+		mode = SDL_ScaleModeLinear;
+	else if (SDL_strcasecmp(quality, "best") == 0)
+		mode = SDL_ScaleModeBest;
+	else
+		mode = SDL_atoi(quality);
+	return static_cast<SDL_ScaleMode>(clamp<int>(mode, SDL_ScaleModeNearest, SDL_ScaleModeBest));
+}
+
+/**
+ * @brief Suspend sharp scaling while frames take longer than the display refresh.
+ *
+ * It is resumed once frames have kept up with the display for 5 seconds, so a device that can
+ * only keep up without it doesn't switch back and forth.
+ */
+void UpdateAdaptiveScaling()
+{
+	static Uint64 lastPresent;
+	const Uint64 now = SDL_GetPerformanceCounter();
+	Uint64 frameTime = refreshDelay;
+	if (lastPresent != 0)
+		frameTime = (now - lastPresent) * 1000000 / SDL_GetPerformanceFrequency();
+	lastPresent = now;
+	// Loading screens and pauses aren't rendering cost, so they mustn't dominate the average
+	AverageFrameTime = (AverageFrameTime * 15 + std::min<Uint64>(frameTime, 4 * refreshDelay)) / 16;
+
+	if (!SharpScalingSuspended) {
+		SharpScalingSuspended = AverageFrameTime > static_cast<Uint64>(refreshDelay) * 5 / 4;
+		FramesKeepingUp = 0;
+	} else if (AverageFrameTime <= static_cast<Uint64>(refreshDelay) * 11 / 10) {
+		if (++FramesKeepingUp >= 5000000 / refreshDelay)
+			SharpScalingSuspended = false;
+	} else {
+		FramesKeepingUp = 0;
+	}
+}
+#endif
+
+/**
+ * @brief The texture to stretch over the window.
+ *
+ * With sharp scaling, `texture` is first scaled up by the largest whole factor that fits the window,
+ * without filtering, so the scale quality filter only smooths the remaining fraction.
+ */
+SDL_Texture *PrepareScaledTexture()
+{
+#if SDL_VERSION_ATLEAST(2, 0, 12)
+	// The nearest neighbour mode of the sharp pass stays on the texture, restore the configured filter without it
+	if (!sgOptions.Graphics.bSharpScaling || sgOptions.Graphics.bIntegerScaling || !SDL_RenderTargetSupported(renderer)) {
+		SDL_SetTextureScaleMode(texture, ConfiguredScaleMode());
+		return texture;
+	}
+
+	if (sgOptions.Graphics.bAdaptiveScaling) {
+		UpdateAdaptiveScaling();
+		if (SharpScalingSuspended) {
+			SDL_SetTextureScaleMode(texture, ConfiguredScaleMode());
+			return texture;
+		}
+	}
+
+	int outputWidth;
+	int outputHeight;
+	int width;
+	int height;
+	if (SDL_GetRendererOutputSize(renderer, &outputWidth, &outputHeight) < 0
+	    || SDL_QueryTexture(texture, nullptr, nullptr, &width, &height) < 0) {
+		ErrSdl();
+	}
+	const int factor = std::min(outputWidth / width, outputHeight / height);
+	if (factor <= 1) {
+		SDL_SetTextureScaleMode(texture, ConfiguredScaleMode());
+		return texture;
+	}
+
+	int sharpWidth = 0;
+	int sharpHeight = 0;
+	if (SharpTexture != nullptr)
+		SDL_QueryTexture(SharpTexture, nullptr, nullptr, &sharpWidth, &sharpHeight);
+	if (sharpWidth != width * factor || sharpHeight != height * factor) {
+		SDL_DestroyTexture(SharpTexture);
+		SharpTexture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGB888, SDL_TEXTUREACCESS_TARGET, width * factor, height * factor);
+		if (SharpTexture == nullptr)
+			ErrSdl();
+		SDL_SetTextureScaleMode(SharpTexture, ConfiguredScaleMode());
+	}
+
+	SDL_SetTextureScaleMode(texture, SDL_ScaleModeNearest);
+	if (SDL_SetRenderTarget(renderer, SharpTexture) < 0
+	    || SDL_RenderCopy(renderer, texture, nullptr, nullptr) < 0
+	    || SDL_SetRenderTarget(renderer, nullptr) < 0) {
+		ErrSdl();
+	}
+	return SharpTexture;
+#else
+	return texture;
+#endif
+}
+#endif
+
 } // namespace
 
 static void dx_create_back_buffer()
@@ -187,6 +425,14 @@ void dx_cleanup()
 	SDL_FreeSurface(renderer_texture_surface);
 #ifndef USE_SDL1
 	SDL_DestroyTexture(texture);
+	PresentFromPalSurface = false;
+	OutputSurfaceStale = false;
+	InvalidateScreenTexture();
+	InvalidateUiTextures();
+#if SDL_VERSION_ATLEAST(2, 0, 12)
+	SDL_DestroyTexture(SharpTexture);
+	SharpTexture = nullptr;
+#endif
 	SDL_DestroyRenderer(renderer);
 #endif
 	SDL_DestroyWindow(ghMainWnd);
@@ -227,6 +473,15 @@ void BltFast(SDL_Rect *src_rect, SDL_Rect *dst_rect)
 {
 	if (RenderDirectlyToOutputSurface)
 		return;
+#ifndef USE_SDL1
+	// `pal_surface` is converted when presenting, only the part covered by the rectangles is.
+	if (CanPresentFromPalSurface()) {
+		MarkPalSurfaceDirty(dst_rect);
+		PresentFromPalSurface = true;
+		OutputSurfaceStale = true;
+		return;
+	}
+#endif
 	Blit(pal_surface, src_rect, dst_rect);
 }
 
@@ -234,6 +489,7 @@ void Blit(SDL_Surface *src, SDL_Rect *src_rect, SDL_Rect *dst_rect)
 {
 	SDL_Surface *dst = GetOutputSurface();
 #ifndef USE_SDL1
+	RestoreOutputSurface();
 	if (SDL_BlitSurface(src, src_rect, dst, dst_rect) < 0)
 		ErrSdl();
 	return;
@@ -288,23 +544,45 @@ void Blit(SDL_Surface *src, SDL_Rect *src_rect, SDL_Rect *dst_rect)
 
 /**
  * @brief Limit FPS to avoid high CPU load, use when v-sync isn't available
+ *
+ * Frames are paced against deadlines on the high-resolution counter. SDL_Delay only sleeps in whole
+ * milliseconds, a frame that ends a little early or late is made up for by the next deadline, so the
+ * frame rate is exact on average.
  */
 void LimitFrameRate()
 {
 	if (!sgOptions.Graphics.bFPSLimit)
 		return;
-	static uint32_t frameDeadline;
-	uint32_t tc = SDL_GetTicks() * 1000;
-	uint32_t v = 0;
-	if (frameDeadline > tc) {
-		v = tc % refreshDelay;
-		SDL_Delay(v / 1000 + 1); // ceil
+	static Uint64 frameDeadline;
+	const Uint64 frequency = SDL_GetPerformanceFrequency();
+	const Uint64 frameDuration = frequency * refreshDelay / 1000000;
+	const Uint64 now = SDL_GetPerformanceCounter();
+	if (now >= frameDeadline) {
+		// Running late, pace the following frames from now instead of trying to catch up
+		if (frameDeadline != 0)
+			missedFrameDeadlines++;
+		frameDeadline = now + frameDuration;
+		return;
 	}
-	frameDeadline = tc + v + refreshDelay;
+	// SDL_Delay can oversleep by up to a scheduler tick, so it stops a millisecond early and the rest is waited out
+	// on the performance counter. Yielding while waiting leaves the core to the other threads.
+	const Uint64 remainingMs = (frameDeadline - now) * 1000 / frequency;
+	if (remainingMs > 1)
+		SDL_Delay(static_cast<Uint32>(remainingMs - 1));
+	while (SDL_GetPerformanceCounter() < frameDeadline)
+		std::this_thread::yield();
+	frameDeadline += frameDuration;
+}
+
+uint32_t GetMissedFrameDeadlines()
+{
+	return missedFrameDeadlines;
 }
 
 void RenderPresent()
 {
+	ProfileScope profileScope(ProfilePhase::RenderPresent);
+
 	SDL_Surface *surface = GetOutputSurface();
 
 	if (!gbActive) {
@@ -314,10 +592,18 @@ void RenderPresent()
 
 #ifndef USE_SDL1
 	if (renderer != nullptr) {
-		if (SDL_UpdateTexture(texture, nullptr, surface->pixels, surface->pitch) <= -1) { //pitch is 2560
-			ErrSdl();
+		if (PresentFromPalSurface) {
+			PresentFromPalSurface = false;
+			ConvertPalSurfaceToTexture();
+		} else {
+			TextureHoldsPalSurface = false;
+			if (SDL_UpdateTexture(texture, nullptr, surface->pixels, surface->pitch) <= -1) { //pitch is 2560
+				ErrSdl();
+			}
 		}
 
+		SDL_Texture *scaledTexture = PrepareScaledTexture();
+
 		// Clear buffer to avoid artifacts in case the window was resized
 		if (SDL_SetRenderDrawColor(renderer, 0, 0, 0, 255) <= -1) { // TODO only do this if window was resized
 			ErrSdl();
@@ -326,7 +612,7 @@ void RenderPresent()
 		if (SDL_RenderClear(renderer) <= -1) {
 			ErrSdl();
 		}
-		if (SDL_RenderCopy(renderer, texture, nullptr, nullptr) <= -1) {
+		if (SDL_RenderCopy(renderer, scaledTexture, nullptr, nullptr) <= -1) {
 			ErrSdl();
 		}
 		SDL_RenderPresent(renderer);
@@ -350,6 +636,24 @@ void RenderPresent()
 #endif
 }
 
+#ifndef USE_SDL1
+void InvalidateScreenTexture()
+{
+	TextureHoldsPalSurface = false;
+	PalSurfaceDirtyRect = {};
+}
+
+void RenderPresentTextures()
+{
+	ProfileScope profileScope(ProfilePhase::RenderPresent);
+
+	if (gbActive)
+		SDL_RenderPresent(renderer);
+	if (!gbActive || !sgOptions.Graphics.bVSync)
+		LimitFrameRate();
+}
+#endif
+
 void PaletteGetEntries(DWORD dwNumEntries, SDL_Color *lpEntries)
 {
 	for (DWORD i = 0; i < dwNumEntries; i++) {
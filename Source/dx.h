@@ -23,6 +23,20 @@ void InitPalette();
 void BltFast(SDL_Rect *src_rect, SDL_Rect *dst_rect);
 void Blit(SDL_Surface *src, SDL_Rect *src_rect, SDL_Rect *dst_rect);
 void RenderPresent();
+#ifndef USE_SDL1
+/**
+ * @brief Presents what was drawn with the renderer, without the output surface.
+ */
+void RenderPresentTextures();
+/**
+ * @brief Must be called when the screen texture was replaced or written to outside of RenderPresent().
+ */
+void InvalidateScreenTexture();
+#endif
+/**
+ * @brief Total number of frames the frame limiter found already past their deadline.
+ */
+uint32_t GetMissedFrameDeadlines();
 void PaletteGetEntries(DWORD dwNumEntries, SDL_Color *lpEntries);
 
 } // namespace devilution
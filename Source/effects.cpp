@@ -4,8 +4,10 @@
  * Implementation of functions for loading and playing sounds.
  */
 #include "init.h"
+#include "options.h"
 #include "player.h"
 #include "sound.h"
+#include "utils/file_prefetch.h"
 
 namespace devilution {
 namespace {
@@ -1066,6 +1068,114 @@ TSFX sgSFX[] = {
 	// clang-format on
 };
 
+namespace {
+
+constexpr size_t NumSFX = sizeof(sgSFX) / sizeof(TSFX);
+
+/** When each effect was last played, in calls of LoadCachedSnd */
+uint32_t SfxLastUsed[NumSFX];
+/** When each sound of the level's monster types was last played */
+uint32_t MonsterSndLastUsed[MAX_LVLMTYPES][4][2];
+uint32_t SfxUseCount;
+/** Bytes used by the loaded effects and monster sounds, excluding streams */
+size_t SfxCacheSize;
+
+void FreeCachedSnd(std::unique_ptr<TSnd> &snd)
+{
+	SfxCacheSize -= snd->DSB.GetDataSize();
+	snd = nullptr;
+}
+
+/** @brief Free the least recently played sounds until the cache fits its budget */
+void TrimSFXCache(const std::unique_ptr<TSnd> *keep)
+{
+	const size_t budget = static_cast<size_t>(sgOptions.Audio.nSfxCacheSize) * 1024;
+	while (budget != 0 && SfxCacheSize > budget) {
+		std::unique_ptr<TSnd> *oldest = nullptr;
+		uint32_t oldestUse = 0;
+		auto consider = [&](std::unique_ptr<TSnd> &snd, uint32_t lastUsed) {
+			if (&snd == keep || snd == nullptr || snd->isPlaying())
+				return;
+			if (oldest == nullptr || lastUsed < oldestUse) {
+				oldest = &snd;
+				oldestUse = lastUsed;
+			}
+		};
+		for (size_t i = 0; i < NumSFX; i++) {
+			if ((sgSFX[i].bFlags & sfx_STREAM) == 0)
+				consider(sgSFX[i].pSnd, SfxLastUsed[i]);
+		}
+		for (int i = 0; i < nummtypes; i++) {
+			for (int mode = 0; mode < 4; mode++) {
+				for (int j = 0; j < 2; j++)
+					consider(Monsters[i].Snds[mode][j], MonsterSndLastUsed[i][mode][j]);
+			}
+		}
+		if (oldest == nullptr)
+			return;
+		FreeCachedSnd(*oldest);
+	}
+}
+
+/** @brief Load a non-streamed sound into the cache if it isn't loaded yet */
+TSnd *LoadCachedSnd(std::unique_ptr<TSnd> &snd, uint32_t &lastUsed, const char *path)
+{
+	lastUsed = ++SfxUseCount;
+	if (snd == nullptr) {
+		snd = sound_file_load(path);
+		SfxCacheSize += snd->DSB.GetDataSize();
+		TrimSFXCache(&snd);
+	}
+	return snd.get();
+}
+
+/** @brief Get a non-streamed effect, loading it if it isn't loaded yet */
+TSnd *GetSFXSnd(TSFX &sfx)
+{
+	return LoadCachedSnd(sfx.pSnd, SfxLastUsed[&sfx - sgSFX], sfx.pszName);
+}
+
+/** @return false if the monster type has no sound for the mode */
+bool GetMonsterSndPath(const CMonster &monsterType, int mode, int index, char *path)
+{
+	const MonsterData &data = monsterdata[monsterType.mtype];
+	if (MonstSndChar[mode] == 's' && !data.snd_special)
+		return false;
+	sprintf(path, data.sndfile, MonstSndChar[mode], index + 1);
+	return true;
+}
+
+/** @return The effects played by the heroes of this game */
+BYTE GetHeroSfxMask()
+{
+	BYTE mask = sfx_MISC;
+	if (gbIsMultiplayer) {
+		mask |= sfx_WARRIOR;
+		if (!gbIsSpawn)
+			mask |= (sfx_ROGUE | sfx_SORCERER);
+		if (gbIsHellfire)
+			mask |= sfx_MONK;
+		return mask;
+	}
+
+	switch (plr[myplr]._pClass) {
+	case HeroClass::Warrior:
+	case HeroClass::Barbarian:
+		return mask | sfx_WARRIOR;
+	case HeroClass::Rogue:
+	case HeroClass::Bard:
+		return mask | sfx_ROGUE;
+	case HeroClass::Sorcerer:
+		return mask | sfx_SORCERER;
+	case HeroClass::Monk:
+		return mask | sfx_MONK;
+	default:
+		app_fatal("effects:1");
+	}
+}
+
+} // namespace
+
 bool effect_is_playing(int nSFX)
 {
 	TSFX *sfx = &sgSFX[nSFX];
@@ -1109,32 +1219,47 @@ static void stream_update()
 	}
 }
 
-void InitMonsterSND(int monst)
+void PrefetchMonsterSnd()
 {
 	char path[MAX_PATH];
-	int mtype, i, j;
 
 	if (!gbSndInited) {
 		return;
 	}
 
-	mtype = Monsters[monst].mtype;
-	for (i = 0; i < 4; i++) {
-		if (MonstSndChar[i] != 's' || monsterdata[mtype].snd_special) {
-			for (j = 0; j < 2; j++) {
-				sprintf(path, monsterdata[mtype].sndfile, MonstSndChar[i], j + 1);
-				Monsters[monst].Snds[i][j] = sound_file_load(path);
+	for (int i = 0; i < nummtypes; i++) {
+		for (int mode = 0; mode < 4; mode++) {
+			for (int j = 0; j < 2; j++) {
+				if (GetMonsterSndPath(Monsters[i], mode, j, path))
+					PrefetchFile(path);
 			}
 		}
 	}
 }
 
+void PrefetchHeroSnd()
+{
+	if (!gbSndInited) {
+		return;
+	}
+
+	const BYTE mask = GetHeroSfxMask();
+	for (auto &sfx : sgSFX) {
+		if (sfx.pSnd != nullptr || (sfx.bFlags & sfx_STREAM) != 0 || (sfx.bFlags & mask) == 0)
+			continue;
+		if (!gbIsHellfire && (sfx.bFlags & sfx_HELLFIRE) != 0)
+			continue;
+		PrefetchFile(sfx.pszName);
+	}
+}
+
 void FreeMonsterSnd()
 {
 	for (int i = 0; i < nummtypes; i++) {
 		for (int j = 0; j < 4; ++j) {
 			for (int k = 0; k < 2; ++k) {
-				Monsters[i].Snds[j][k] = nullptr;
+				if (Monsters[i].Snds[j][k] != nullptr)
+					FreeCachedSnd(Monsters[i].Snds[j][k]);
 			}
 		}
 	}
@@ -1189,11 +1314,7 @@ static void PlaySFX_priv(TSFX *pSFX, bool loc, int x, int y)
 		return;
 	}
 
-	if (pSFX->pSnd == nullptr)
-		pSFX->pSnd = sound_file_load(pSFX->pszName);
-
-	if (pSFX->pSnd != nullptr)
-		snd_play_snd(pSFX->pSnd.get(), lVolume, lPan);
+	snd_play_snd(GetSFXSnd(*pSFX), lVolume, lPan);
 }
 
 void PlayEffect(int i, int mode)
@@ -1210,15 +1331,19 @@ void PlayEffect(int i, int mode)
 	}
 
 	mi = monster[i]._mMTidx;
-	TSnd *snd = Monsters[mi].Snds[mode][sndIdx].get();
-	if (snd == nullptr || snd->isPlaying()) {
+	std::unique_ptr<TSnd> &snd = Monsters[mi].Snds[mode][sndIdx];
+	if (snd != nullptr && snd->isPlaying()) {
 		return;
 	}
 
 	if (!calc_snd_position(monster[i].position.tile.x, monster[i].position.tile.y, &lVolume, &lPan))
 		return;
 
-	snd_play_snd(snd, lVolume, lPan);
+	char path[MAX_PATH];
+	if (snd == nullptr && !GetMonsterSndPath(Monsters[mi], mode, sndIdx, path))
+		return;
+
+	snd_play_snd(LoadCachedSnd(snd, MonsterSndLastUsed[mi][mode][sndIdx], path), lVolume, lPan);
 }
 
 static _sfx_id RndSFX(_sfx_id psfx)
@@ -1298,8 +1423,11 @@ void effects_cleanup_sfx()
 {
 	sound_stop();
 
-	for (auto &sfx : sgSFX)
+	for (auto &sfx : sgSFX) {
+		if (sfx.pSnd != nullptr && (sfx.bFlags & sfx_STREAM) == 0)
+			FreeCachedSnd(sfx.pSnd);
 		sfx.pSnd = nullptr;
+	}
 }
 
 static void priv_sound_init(BYTE bLoadMask)
@@ -1327,41 +1455,10 @@ static void priv_sound_init(BYTE bLoadMask)
 			continue;
 		}
 
-		sgSFX[i].pSnd = sound_file_load(sgSFX[i].pszName);
+		GetSFXSnd(sgSFX[i]);
 	}
 }
 
-void sound_init()
-{
-	BYTE mask = sfx_MISC;
-	if (gbIsMultiplayer) {
-		mask |= sfx_WARRIOR;
-		if (!gbIsSpawn)
-			mask |= (sfx_ROGUE | sfx_SORCERER);
-		if (gbIsHellfire)
-			mask |= sfx_MONK;
-	} else {
-		auto &myPlayer = plr[myplr];
-		if (myPlayer._pClass == HeroClass::Warrior) {
-			mask |= sfx_WARRIOR;
-		} else if (myPlayer._pClass == HeroClass::Rogue) {
-			mask |= sfx_ROGUE;
-		} else if (myPlayer._pClass == HeroClass::Sorcerer) {
-			mask |= sfx_SORCERER;
-		} else if (myPlayer._pClass == HeroClass::Monk) {
-			mask |= sfx_MONK;
-		} else if (myPlayer._pClass == HeroClass::Bard) {
-			mask |= sfx_ROGUE;
-		} else if (myPlayer._pClass == HeroClass::Barbarian) {
-			mask |= sfx_WARRIOR;
-		} else {
-			app_fatal("effects:1");
-		}
-	}
-
-	priv_sound_init(mask);
-}
-
 void ui_sound_init()
 {
 	priv_sound_init(sfx_UI);
@@ -1374,9 +1471,10 @@ void effects_play_sound(const char *snd_file)
 	}
 
 	for (uint32_t i = 0; i < sizeof(sgSFX) / sizeof(TSFX); i++) {
-		if (strcasecmp(sgSFX[i].pszName, snd_file) == 0 && sgSFX[i].pSnd != nullptr) {
-			if (!sgSFX[i].pSnd->isPlaying())
-				snd_play_snd(sgSFX[i].pSnd.get(), 0, 0);
+		if (strcasecmp(sgSFX[i].pszName, snd_file) == 0 && (sgSFX[i].bFlags & sfx_STREAM) == 0) {
+			TSnd *snd = GetSFXSnd(sgSFX[i]);
+			if (!snd->isPlaying())
+				snd_play_snd(snd, 0, 0);
 
 			return;
 		}
@@ -1385,9 +1483,10 @@ void effects_play_sound(const char *snd_file)
 
 int GetSFXLength(int nSFX)
 {
+	if ((sgSFX[nSFX].bFlags & sfx_STREAM) == 0)
+		return GetSFXSnd(sgSFX[nSFX])->DSB.GetLength();
 	if (sgSFX[nSFX].pSnd == nullptr)
-		sgSFX[nSFX].pSnd = sound_file_load(sgSFX[nSFX].pszName,
-		    /*stream=*/AllowStreaming && (sgSFX[nSFX].bFlags & sfx_STREAM) != 0);
+		sgSFX[nSFX].pSnd = sound_file_load(sgSFX[nSFX].pszName, /*stream=*/AllowStreaming);
 	return sgSFX[nSFX].pSnd->DSB.GetLength();
 }
 
@@ -1174,7 +1174,14 @@ extern _sfx_id sfxdnum;
 
 bool effect_is_playing(int nSFX);
 void stream_stop();
-void InitMonsterSND(int monst);
+/**
+ * @brief Read the sounds of the level's monsters in the background, they are loaded when first played
+ */
+void PrefetchMonsterSnd();
+/**
+ * @brief Read the effects of the game's hero classes in the background, they are loaded when first played
+ */
+void PrefetchHeroSnd();
 void FreeMonsterSnd();
 void PlayEffect(int i, int mode);
 void PlaySFX(_sfx_id psfx);
@@ -1182,7 +1189,6 @@ void PlaySfxLoc(_sfx_id psfx, int x, int y, bool randomizeByCategory = true);
 void sound_stop();
 void sound_update();
 void effects_cleanup_sfx();
-void sound_init();
 void ui_sound_init();
 void effects_play_sound(const char *snd_file);
 
@@ -10,7 +10,8 @@ _sfx_id sfxdnum;
 // clang-format off
 bool effect_is_playing(int nSFX) { return false; }
 void stream_stop() { }
-void InitMonsterSND(int monst) { }
+void PrefetchMonsterSnd() { }
+void PrefetchHeroSnd() { }
 void FreeMonsterSnd() { }
 void PlayEffect(int i, int mode) { }
 void PlaySFX(_sfx_id psfx) { }
@@ -18,7 +19,6 @@ void PlaySfxLoc(_sfx_id psfx, int x, int y, bool randomizeByCategory) { }
 void sound_stop() { }
 void sound_update() { }
 void effects_cleanup_sfx() { }
-void sound_init() { }
 void ui_sound_init() { }
 void effects_play_sound(const char *snd_file) { }
 // clang-format off
@@ -3,7 +3,9 @@
  *
  * Implementation of functions for compression and decompressing MPQ data.
  */
+#include <algorithm>
 #include <memory>
+#include <vector>
 #include <SDL.h>
 
 #include "encrypt.h"
@@ -69,6 +71,32 @@ void InitHash()
 	}
 }
 
+namespace {
+
+unsigned CompressionDictionarySize = CMP_IMPLODE_DICT_SIZE3;
+
+/** Work buffers of implode and explode, kept for the next call on the same thread */
+thread_local std::unique_ptr<char[]> ImplodeWorkBuffer;
+thread_local std::unique_ptr<char[]> ExplodeWorkBuffer;
+/** Holds the output of the in place functions before it is copied back */
+thread_local std::vector<byte> ScratchBuffer;
+
+char *GetWorkBuffer(std::unique_ptr<char[]> &buffer, std::size_t size)
+{
+	if (buffer == nullptr)
+		buffer.reset(new char[size]);
+	return buffer.get();
+}
+
+byte *GetScratchBuffer(std::size_t size)
+{
+	if (ScratchBuffer.size() < size)
+		ScratchBuffer.resize(size);
+	return ScratchBuffer.data();
+}
+
+} // namespace
+
 static unsigned int PkwareBufferRead(char *buf, unsigned int *size, void *param)
 {
 	TDataInfo *pInfo = (TDataInfo *)param;
@@ -90,54 +118,72 @@ static void PkwareBufferWrite(char *buf, unsigned int *size, void *param)
 {
 	TDataInfo *pInfo = (TDataInfo *)param;
 
-	memcpy(pInfo->destData + pInfo->destOffset, buf, *size);
-	pInfo->destOffset += *size;
+	const uint32_t dSize = std::min<uint32_t>(*size, pInfo->destSize - pInfo->destOffset);
+	memcpy(pInfo->destData + pInfo->destOffset, buf, dSize);
+	pInfo->destOffset += dSize;
 }
 
-uint32_t PkwareCompress(byte *srcData, uint32_t size)
+void PkwareSetCompressionLevel(int level)
 {
-	std::unique_ptr<char[]> ptr { new char[CMP_BUFFER_SIZE] };
-
-	unsigned destSize = 2 * size;
-	if (destSize < 2 * 4096)
-		destSize = 2 * 4096;
+	constexpr unsigned DictionarySizes[] = { CMP_IMPLODE_DICT_SIZE1, CMP_IMPLODE_DICT_SIZE2, CMP_IMPLODE_DICT_SIZE3 };
+	CompressionDictionarySize = DictionarySizes[std::min(std::max(level, 1), 3) - 1];
+}
 
-	std::unique_ptr<byte[]> destData { new byte[destSize] };
+uint32_t PkwareCompressBound(uint32_t size)
+{
+	return std::max<uint32_t>(2 * size, 2 * 4096);
+}
 
+uint32_t PkwareCompress(const byte *srcData, uint32_t size, byte *destData)
+{
 	TDataInfo param;
-	param.srcData = srcData;
+	param.srcData = const_cast<byte *>(srcData);
 	param.srcOffset = 0;
-	param.destData = destData.get();
+	param.destData = destData;
 	param.destOffset = 0;
 	param.size = size;
+	param.destSize = PkwareCompressBound(size);
 
 	unsigned type = 0;
-	unsigned dsize = 4096;
-	implode(PkwareBufferRead, PkwareBufferWrite, ptr.get(), &param, &type, &dsize);
+	unsigned dsize = CompressionDictionarySize;
+	implode(PkwareBufferRead, PkwareBufferWrite, GetWorkBuffer(ImplodeWorkBuffer, CMP_BUFFER_SIZE), &param, &type, &dsize);
+
+	return param.destOffset;
+}
 
-	if (param.destOffset < size) {
-		memcpy(srcData, destData.get(), param.destOffset);
-		size = param.destOffset;
+uint32_t PkwareCompress(byte *srcData, uint32_t size)
+{
+	byte *destData = GetScratchBuffer(PkwareCompressBound(size));
+	const uint32_t destSize = PkwareCompress(srcData, size, destData);
+
+	if (destSize < size) {
+		memcpy(srcData, destData, destSize);
+		size = destSize;
 	}
 
 	return size;
 }
 
-void PkwareDecompress(byte *inBuff, int recvSize, int maxBytes)
+uint32_t PkwareDecompress(const byte *inBuff, int recvSize, byte *outBuff, uint32_t maxBytes)
 {
 	TDataInfo info;
-
-	std::unique_ptr<char[]> ptr { new char[CMP_BUFFER_SIZE] };
-	std::unique_ptr<byte[]> outBuff { new byte[maxBytes] };
-
-	info.srcData = inBuff;
+	info.srcData = const_cast<byte *>(inBuff);
 	info.srcOffset = 0;
-	info.destData = outBuff.get();
+	info.destData = outBuff;
 	info.destOffset = 0;
 	info.size = recvSize;
+	info.destSize = maxBytes;
 
-	explode(PkwareBufferRead, PkwareBufferWrite, ptr.get(), &info);
-	memcpy(inBuff, outBuff.get(), info.destOffset);
+	explode(PkwareBufferRead, PkwareBufferWrite, GetWorkBuffer(ExplodeWorkBuffer, EXP_BUFFER_SIZE), &info);
+
+	return info.destOffset;
+}
+
+void PkwareDecompress(byte *inBuff, int recvSize, int maxBytes)
+{
+	byte *outBuff = GetScratchBuffer(maxBytes);
+	const uint32_t outSize = PkwareDecompress(inBuff, recvSize, outBuff, maxBytes);
+	memcpy(inBuff, outBuff, outSize);
 }
 
 } // namespace devilution
@@ -17,13 +17,37 @@ struct TDataInfo {
 	byte *destData;
 	uint32_t destOffset;
 	uint32_t size;
+	/** Room in destData, anything past it is dropped */
+	uint32_t destSize;
 };
 
 void Decrypt(uint32_t *castBlock, uint32_t size, uint32_t key);
 void Encrypt(uint32_t *castBlock, uint32_t size, uint32_t key);
 uint32_t Hash(const char *s, int type);
 void InitHash();
+/**
+ * @brief Sets the dictionary size that implode uses, any size can be exploded
+ * @param level 1 (fastest) to 3 (smallest output)
+ */
+void PkwareSetCompressionLevel(int level);
+/** @brief The room PkwareCompress needs to compress this many bytes into a separate buffer */
+uint32_t PkwareCompressBound(uint32_t size);
+/**
+ * @brief Compresses into a separate buffer
+ * @param destData Must hold at least PkwareCompressBound(size) bytes
+ * @return The compressed size, which can be bigger than the input
+ */
+uint32_t PkwareCompress(const byte *srcData, uint32_t size, byte *destData);
+/**
+ * @brief Compresses in place, unless that would make the data bigger
+ * @return The new size of the data
+ */
 uint32_t PkwareCompress(byte *srcData, uint32_t size);
+/**
+ * @brief Decompresses into a separate buffer, output past maxBytes is dropped
+ * @return The decompressed size
+ */
+uint32_t PkwareDecompress(const byte *inBuff, int recvSize, byte *outBuff, uint32_t maxBytes);
 void PkwareDecompress(byte *inBuff, int recvSize, int maxBytes);
 
 } // namespace devilution
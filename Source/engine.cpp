@@ -18,6 +18,9 @@
 #include "movie.h"
 #include "options.h"
 #include "storm/storm.h"
+#include "utils/file_prefetch.h"
+#include "utils/profiler.h"
+#include "utils/thread_pool.h"
 
 namespace devilution {
 
@@ -82,11 +85,13 @@ void CelOutputBuffer::BlitFromSkipColorIndexZero(const CelOutputBuffer &src, SDL
 
 CelSprite LoadCel(const char *pszName, int width)
 {
+	MemoryTagScope memoryTag(MemoryTag::Cels);
 	return CelSprite(LoadFileInMem(pszName), width);
 }
 
 CelSprite LoadCel(const char *pszName, const int *widths)
 {
+	MemoryTagScope memoryTag(MemoryTag::Cels);
 	return CelSprite(LoadFileInMem(pszName), widths);
 }
 
@@ -136,11 +141,8 @@ static void DrawHalfTransparentBlendedRectTo(const CelOutputBuffer &out, int sx,
 	BYTE *pix = out.at(sx, sy);
 
 	for (int row = 0; row < height; row++) {
-		for (int col = 0; col < width; col++) {
-			*pix = paletteTransparencyLookup[0][*pix];
-			pix++;
-		}
-		pix += out.pitch() - width;
+		RemapBytes(pix, pix, width, paletteTransparencyLookup[0]);
+		pix += out.pitch();
 	}
 }
 
@@ -312,6 +314,8 @@ size_t GetFileSize(const char *pszName)
 
 void LoadFileData(const char *pszName, byte *buffer, size_t fileLen)
 {
+	ProfileScope profileScope("LoadFile");
+
 	HANDLE file;
 	if (!SFileOpenFile(pszName, &file)) {
 		if (!gbQuietMode)
@@ -322,10 +326,55 @@ void LoadFileData(const char *pszName, byte *buffer, size_t fileLen)
 	if (fileLen == 0)
 		app_fatal("Zero length SFILE:\n%s", pszName);
 
+	size_t prefetchedSize;
+	std::unique_ptr<byte[]> prefetched = TakePrefetchedFile(pszName, &prefetchedSize);
+	if (prefetched != nullptr && prefetchedSize == fileLen) {
+		memcpy(buffer, prefetched.get(), fileLen);
+		SFileCloseFileThreadSafe(file);
+		return;
+	}
+
 	SFileReadFileThreadSafe(file, buffer, fileLen);
 	SFileCloseFileThreadSafe(file);
 }
 
+std::unique_ptr<byte[]> LoadFileBytes(const char *pszName, size_t *fileLen)
+{
+	ProfileScope profileScope("LoadFile");
+
+	std::unique_ptr<byte[]> prefetched = TakePrefetchedFile(pszName, fileLen);
+	if (prefetched != nullptr) {
+		AdoptAllocation(prefetched.get());
+		return prefetched;
+	}
+
+	*fileLen = 0;
+	HANDLE file;
+	if (!SFileOpenFile(pszName, &file)) {
+		if (!gbQuietMode)
+			app_fatal("LoadFileBytes - SFileOpenFile failed for file:\n%s", pszName);
+		return std::unique_ptr<byte[]> { new byte[0] };
+	}
+
+	*fileLen = SFileGetFileSize(file);
+	if (*fileLen == 0)
+		app_fatal("Zero length SFILE:\n%s", pszName);
+
+	std::unique_ptr<byte[]> buffer { new byte[*fileLen] };
+	SFileReadFileThreadSafe(file, buffer.get(), *fileLen);
+	SFileCloseFileThreadSafe(file);
+	return buffer;
+}
+
+void ParallelLoad(unsigned count, const std::function<void(unsigned)> &job)
+{
+	// Loading is mostly waiting for the disk and decompressing, a few threads are enough to keep it busy
+	constexpr int MaxLoaderThreads = 4;
+	static ThreadPool pool(std::max(std::min(SDL_GetCPUCount(), MaxLoaderThreads) - 1, 0));
+
+	pool.ParallelFor(count, job);
+}
+
 /**
  * @brief Fade to black and play a video
  * @param pszMovie file path of movie
@@ -16,8 +16,10 @@
 #include <array>
 #include <cstdint>
 #include <cstdlib>
+#include <functional>
 #include <memory>
 #include <tuple>
+#include <type_traits>
 #include <utility>
 
 // We include `cinttypes` here so that it is included before `inttypes.h`
@@ -35,6 +37,7 @@
 
 #include "appfat.h"
 #include "miniwin/miniwin.h"
+#include "utils/memory_stats.h"
 #include "utils/stdcompat/cstddef.hpp"
 #include "utils/stdcompat/abs.h"
 
@@ -591,6 +594,13 @@ int32_t GenerateRnd(int32_t v);
 
 size_t GetFileSize(const char *pszName);
 void LoadFileData(const char *pszName, byte *buffer, size_t bufferSize);
+/**
+ * @brief Read a whole file, opening it only once
+ *
+ * A prefetched file is handed over as it is instead of being copied into a new buffer.
+ * @param fileLen Size of the file
+ */
+std::unique_ptr<byte[]> LoadFileBytes(const char *pszName, size_t *fileLen);
 
 template <typename T>
 void LoadFileInMem(const char *path, T *data, std::size_t count = 0)
@@ -616,6 +626,15 @@ void LoadFileInMem(const char *path, std::array<T, N> &data)
 template <typename T = byte>
 std::unique_ptr<T[]> LoadFileInMem(const char *path, size_t *elements = nullptr)
 {
+	if constexpr (std::is_same<T, byte>::value) {
+		MemoryTagScope memoryTag(MemoryTag::Files);
+		size_t fileLen;
+		std::unique_ptr<byte[]> buf = LoadFileBytes(path, &fileLen);
+		if (elements != nullptr)
+			*elements = fileLen;
+		return buf;
+	}
+
 	const size_t fileLen = GetFileSize(path);
 
 	if ((fileLen % sizeof(T)) != 0)
@@ -624,6 +643,7 @@ std::unique_ptr<T[]> LoadFileInMem(const char *path, size_t *elements = nullptr)
 	if (elements != nullptr)
 		*elements = fileLen / sizeof(T);
 
+	MemoryTagScope memoryTag(MemoryTag::Files);
 	std::unique_ptr<T[]> buf { new T[fileLen / sizeof(T)] };
 
 	LoadFileData(path, reinterpret_cast<byte *>(buf.get()), fileLen);
@@ -631,6 +651,13 @@ std::unique_ptr<T[]> LoadFileInMem(const char *path, size_t *elements = nullptr)
 	return buf;
 }
 
+/**
+ * @brief Calls job(i) for every i in [0, count) spread over the loader threads and waits for all of them.
+ *
+ * Meant for reading and converting independent files while a level loads.
+ */
+void ParallelLoad(unsigned count, const std::function<void(unsigned)> &job);
+
 void PlayInGameMovie(const char *pszMovie);
 
 } // namespace devilution
@@ -5,6 +5,9 @@
  */
 
 #include "animationinfo.h"
+
+#include <algorithm>
+
 #include "appfat.h"
 #include "nthread.h"
 #include "utils/log.hpp"
@@ -26,8 +29,15 @@ int AnimationInfo::GetFrameToUseForRendering() const
 	assert(TicksSinceSequenceStarted >= 0);
 
 	// we don't use the processed game ticks alone but also the fraction of the next game tick (if a rendering happens between game ticks). This helps to smooth the animations.
-	float totalTicksForCurrentAnimationSequence = gfProgressToNextGameTick + (float)TicksSinceSequenceStarted;
+	const int progressStep = TicksSinceSequenceStarted * ProgressSteps + static_cast<int>(gfProgressToNextGameTick * ProgressSteps);
+	if (progressStep < RenderingFramesCount)
+		return RenderingFrames[progressStep];
+
+	return CalculateDistributedFrame(gfProgressToNextGameTick + (float)TicksSinceSequenceStarted, true);
+}
 
+int AnimationInfo::CalculateDistributedFrame(float totalTicksForCurrentAnimationSequence, bool logInvalidFrames) const
+{
 	// 1 added for rounding reasons. float to int cast always truncate.
 	int absoluteAnimationFrame = 1 + (int)(totalTicksForCurrentAnimationSequence * TickModifier);
 	if (SkippedFramesFromPreviousAnimation > 0) {
@@ -39,14 +49,15 @@ int AnimationInfo::GetFrameToUseForRendering() const
 		}
 	} else if (absoluteAnimationFrame > RelevantFramesForDistributing) {
 		// this can happen if we are at the last frame and the next game tick is due (gfProgressToNextGameTick >= 1.0f)
-		if (absoluteAnimationFrame > (RelevantFramesForDistributing + 1)) {
+		if (logInvalidFrames && absoluteAnimationFrame > (RelevantFramesForDistributing + 1)) {
 			// we should never have +2 frames even if next game tick is due
 			Log("GetFrameToUseForRendering: Calculated an invalid Animation Frame (Calculated {} MaxFrame {})", absoluteAnimationFrame, RelevantFramesForDistributing);
 		}
 		return RelevantFramesForDistributing;
 	}
 	if (absoluteAnimationFrame <= 0) {
-		Log("GetFrameToUseForRendering: Calculated an invalid Animation Frame (Calculated {})", absoluteAnimationFrame);
+		if (logInvalidFrames)
+			Log("GetFrameToUseForRendering: Calculated an invalid Animation Frame (Calculated {})", absoluteAnimationFrame);
 		return 1;
 	}
 	return absoluteAnimationFrame;
@@ -87,6 +98,7 @@ void AnimationInfo::SetNewAnimation(CelSprite *pCelSprite, int numberOfFrames, i
 	TicksSinceSequenceStarted = 0;
 	RelevantFramesForDistributing = 0;
 	TickModifier = 0.0f;
+	RenderingFramesCount = 0;
 
 	if (numSkippedFrames != 0 || flags != AnimationDistributionFlags::None) {
 		// Animation Frames that will be adjusted for the skipped Frames/game ticks
@@ -151,6 +163,14 @@ void AnimationInfo::SetNewAnimation(CelSprite *pCelSprite, int numberOfFrames, i
 
 		RelevantFramesForDistributing = relevantAnimationFramesForDistributing;
 		TickModifier = tickModifier;
+
+		// The distributed Frames are shown for at most this many game ticks, everything after that is calculated while rendering
+		int ticksToPrecalculate = std::min(relevantAnimationFramesForDistributing * ticksPerFrame + 1, MaxPrecalculatedTicks);
+		RenderingFramesCount = ticksToPrecalculate * ProgressSteps;
+		for (int progressStep = 0; progressStep < RenderingFramesCount; progressStep++) {
+			float progressToNextGameTick = (float)(progressStep % ProgressSteps) / ProgressSteps;
+			RenderingFrames[progressStep] = CalculateDistributedFrame(progressToNextGameTick + (float)(progressStep / ProgressSteps), false);
+		}
 	}
 }
 
@@ -165,6 +185,7 @@ void AnimationInfo::ChangeAnimationData(CelSprite *pCelSprite, int numberOfFrame
 		TicksSinceSequenceStarted = 0;
 		RelevantFramesForDistributing = 0;
 		TickModifier = 0.0f;
+		RenderingFramesCount = 0;
 	}
 	this->pCelSprite = pCelSprite;
 	DelayLen = delayLen;
@@ -93,6 +93,22 @@ public:
 	void ProcessAnimation();
 
 private:
+	/**
+	 * @brief Number of steps a game tick is divided into for the precalculated rendering Frames
+	 */
+	static constexpr int ProgressSteps = 10;
+	/**
+	 * @brief Number of game ticks after the start of the sequence that rendering Frames are precalculated for
+	 */
+	static constexpr int MaxPrecalculatedTicks = 12;
+
+	/**
+	 * @brief Calculates the Frame to use for rendering while the skipped Frames are distributed
+	 * @param totalTicksForCurrentAnimationSequence Game ticks since the sequence started, including the fraction of the next one
+	 * @param logInvalidFrames Whether Frames outside of the distributed range are logged
+	 */
+	int CalculateDistributedFrame(float totalTicksForCurrentAnimationSequence, bool logInvalidFrames) const;
+
 	/**
 	 * @brief Specifies how many animations-fractions are displayed between two game ticks. this can be > 0, if animations are skipped or < 0 if the same animation is shown in multiple times (delay specified).
 	 */
@@ -109,6 +125,15 @@ private:
 	 * @brief Animation Frames that wasn't shown from previous Animation
 	 */
 	int SkippedFramesFromPreviousAnimation;
+	/**
+	 * @brief Frames to render while the skipped Frames are distributed, by progress step since the sequence started.
+	 * SetNewAnimation calculates them in the game logic, so rendering only looks them up.
+	 */
+	uint8_t RenderingFrames[MaxPrecalculatedTicks * ProgressSteps];
+	/**
+	 * @brief Number of valid entries in RenderingFrames
+	 */
+	int RenderingFramesCount;
 };
 
 } // namespace devilution
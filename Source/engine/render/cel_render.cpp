@@ -9,6 +9,7 @@
 #include <cstring>
 
 #include "engine/render/common_impl.h"
+#include "engine/render/outline_cache.hpp"
 #include "options.h"
 #include "palette.h"
 #include "scrollrt.h"
@@ -192,335 +193,29 @@ constexpr auto RenderLineMemcpy = [](std::uint8_t *dst, const std::uint8_t *src,
 	std::memcpy(dst, src, w);
 };
 
-template <bool SkipColorIndexZero, bool North, bool West, bool South, bool East>
-void RenderOutlineForPixels( // NOLINT(readability-function-cognitive-complexity)
-    std::uint8_t *dst, int dstPitch, int width, const std::uint8_t *src, std::uint8_t color)
-{
-	if (SkipColorIndexZero) {
-		for (; width-- > 0; ++src, ++dst) {
-			if (*src == 0)
-				continue;
-			if (North)
-				dst[-dstPitch] = color;
-			if (West)
-				dst[-1] = color;
-			if (East)
-				dst[1] = color;
-			if (South)
-				dst[dstPitch] = color;
-		}
-	} else {
-		if (North)
-			std::memset(dst - dstPitch, color, width);
-
-		if (West && East)
-			std::memset(dst - 1, color, width + 2);
-		else if (West)
-			std::memset(dst - 1, color, width);
-		else if (East)
-			std::memset(dst + 1, color, width);
-
-		if (South)
-			std::memset(dst + dstPitch, color, width);
-	}
-}
-
-template <bool SkipColorIndexZero, bool North, bool West, bool South, bool East>
-void RenderOutlineForPixel(std::uint8_t *dst, int dstPitch, std::uint8_t srcColor, std::uint8_t color)
-{
-	if (SkipColorIndexZero && srcColor == 0)
-		return;
-	if (North)
-		dst[-dstPitch] = color;
-	if (West)
-		dst[-1] = color;
-	if (East)
-		dst[1] = color;
-	if (South)
-		dst[dstPitch] = color;
-}
-
-template <bool SkipColorIndexZero, bool North, bool West, bool South, bool East>
-std::uint8_t *RenderCelOutlinePixelsCheckFirstColumn(
-    std::uint8_t *dst, int dstPitch, int dstX,
-    const std::uint8_t *src, std::uint8_t width, std::uint8_t color)
-{
-	if (dstX == -1) {
-		RenderOutlineForPixel<SkipColorIndexZero, /*North=*/false, /*West=*/false, /*South=*/false, East>(
-		    dst++, dstPitch, *src++, color);
-		--width;
-	}
-	if (width > 0) {
-		RenderOutlineForPixel<SkipColorIndexZero, North, /*West=*/false, South, East>(dst++, dstPitch, *src++, color);
-		--width;
-	}
-	if (width > 0) {
-		RenderOutlineForPixels<SkipColorIndexZero, North, West, South, East>(dst, dstPitch, width, src, color);
-		dst += width;
-	}
-	return dst;
-}
-
-template <bool SkipColorIndexZero, bool North, bool West, bool South, bool East>
-std::uint8_t *RenderCelOutlinePixelsCheckLastColumn(
-    std::uint8_t *dst, int dstPitch, int dstX, int dstW,
-    const std::uint8_t *src, std::uint8_t width, std::uint8_t color)
-{
-	const bool lastPixel = dstX < dstW && width >= 1;
-	const bool oobPixel = dstX + width > dstW;
-	const int numSpecialPixels = (lastPixel ? 1 : 0) + (oobPixel ? 1 : 0);
-	if (width > numSpecialPixels) {
-		width -= numSpecialPixels;
-		RenderOutlineForPixels<SkipColorIndexZero, North, West, South, East>(dst, dstPitch, width, src, color);
-		src += width;
-		dst += width;
-	}
-	if (lastPixel)
-		RenderOutlineForPixel<SkipColorIndexZero, North, West, South, /*East=*/false>(dst++, dstPitch, *src++, color);
-	if (oobPixel)
-		RenderOutlineForPixel<SkipColorIndexZero, /*North=*/false, West, /*South=*/false, /*East=*/false>(dst++, dstPitch, *src++, color);
-	return dst;
-}
-
-template <bool SkipColorIndexZero, bool North, bool West, bool South, bool East, bool CheckFirstColumn, bool CheckLastColumn>
-std::uint8_t *RenderCelOutlinePixels(
-    std::uint8_t *dst, int dstPitch, int dstX, int dstW,
-    const std::uint8_t *src, std::uint8_t width, std::uint8_t color)
-{
-	if (CheckFirstColumn && dstX <= 0) {
-		return RenderCelOutlinePixelsCheckFirstColumn<SkipColorIndexZero, North, West, South, East>(
-		    dst, dstPitch, dstX, src, width, color);
-	}
-	if (CheckLastColumn && dstX + width >= dstW) {
-		return RenderCelOutlinePixelsCheckLastColumn<SkipColorIndexZero, North, West, South, East>(
-		    dst, dstPitch, dstX, dstW, src, width, color);
-	}
-	RenderOutlineForPixels<SkipColorIndexZero, North, West, South, East>(dst, dstPitch, width, src, color);
-	return dst + width;
-}
-
-template <bool SkipColorIndexZero, bool North, bool West, bool South, bool East,
-    bool ClipWidth = false, bool CheckFirstColumn = false, bool CheckLastColumn = false>
-const byte *RenderCelOutlineRowClipped( // NOLINT(readability-function-cognitive-complexity,misc-no-recursion)
-    const CelOutputBuffer &out, Point position, const byte *src, int srcWidth,
-    ClipX clipX, std::uint8_t color)
-{
-	std::int_fast16_t remainingWidth = clipX.width;
-	std::uint8_t v;
-
-	auto *dst = &out[position];
-	const auto dstPitch = out.pitch();
-	const auto dstW = out.w();
-
-	if (ClipWidth) {
-		auto remainingLeftClip = clipX.left;
-		while (remainingLeftClip > 0) {
-			v = static_cast<std::uint8_t>(*src++);
-			if (!IsCelTransparent(v)) {
-				if (v > remainingLeftClip) {
-					RenderCelOutlinePixels<SkipColorIndexZero, North, West, South, East, CheckFirstColumn, CheckLastColumn>(
-					    dst, dstPitch, position.x, dstW, reinterpret_cast<const std::uint8_t *>(src), v - remainingLeftClip, color);
-				}
-				src += v;
-			} else {
-				v = GetCelTransparentWidth(v);
-			}
-			remainingLeftClip -= v;
-		}
-		dst -= static_cast<int>(remainingLeftClip);
-		position.x -= static_cast<int>(remainingLeftClip);
-		remainingWidth += remainingLeftClip;
-	}
-
-	while (remainingWidth > 0) {
-		v = static_cast<std::uint8_t>(*src++);
-		if (!IsCelTransparent(v)) {
-			dst = RenderCelOutlinePixels<SkipColorIndexZero, North, West, South, East, CheckFirstColumn, CheckLastColumn>(
-			    dst, dstPitch, position.x, dstW, reinterpret_cast<const std::uint8_t *>(src),
-			    std::min(remainingWidth, static_cast<std::int_fast16_t>(v)), color);
-			src += v;
-		} else {
-			v = GetCelTransparentWidth(v);
-			dst += v;
-		}
-		remainingWidth -= v;
-		position.x += v;
-	}
-
-	src = SkipRestOfCelLine(src, clipX.right + remainingWidth);
-
-	return src;
-}
-
-template <bool SkipColorIndexZero>
-void RenderCelOutlineClippedY(const CelOutputBuffer &out, Point position, const byte *src, std::size_t srcSize, // NOLINT(readability-function-cognitive-complexity)
-    std::size_t srcWidth, std::uint8_t color)
-{
-	const auto *srcEnd = src + srcSize;
-
-	// Skip the bottom clipped lines.
-	const auto dstHeight = out.h();
-	while (position.y > dstHeight && src != srcEnd) {
-		src = SkipRestOfCelLine(src, static_cast<std::int_fast16_t>(srcWidth));
-		--position.y;
-	}
-	if (src == srcEnd)
-		return;
-
-	const ClipX clipX = { 0, 0, static_cast<decltype(ClipX {}.width)>(srcWidth) };
-
-	if (position.y == dstHeight) {
-		// After-bottom line - can only draw north.
-		src = RenderCelOutlineRowClipped<SkipColorIndexZero, /*North=*/true, /*West=*/false, /*South=*/false, /*East=*/false>(
-		    out, position, src, srcWidth, clipX, color);
-		--position.y;
-	}
-	if (src == srcEnd)
-		return;
-
-	if (position.y + 1 == dstHeight) {
-		// Bottom line - cannot draw south.
-		src = RenderCelOutlineRowClipped<SkipColorIndexZero, /*North=*/true, /*West=*/true, /*South=*/false, /*East=*/true>(
-		    out, position, src, srcWidth, clipX, color);
-		--position.y;
-	}
-
-	while (position.y > 0 && src != srcEnd) {
-		src = RenderCelOutlineRowClipped<SkipColorIndexZero, /*North=*/true, /*West=*/true, /*South=*/true, /*East=*/true>(
-		    out, position, src, srcWidth, clipX, color);
-		--position.y;
-	}
-	if (src == srcEnd)
-		return;
-
-	if (position.y == 0) {
-		src = RenderCelOutlineRowClipped<SkipColorIndexZero, /*North=*/false, /*West=*/true, /*South=*/true, /*East=*/true>(
-		    out, position, src, srcWidth, clipX, color);
-		--position.y;
-	}
-	if (src == srcEnd)
-		return;
-
-	if (position.y == -1) {
-		// Special case: the top of the sprite is 1px below the last line, render just the outline above.
-		RenderCelOutlineRowClipped<SkipColorIndexZero, /*North=*/false, /*West=*/false, /*South=*/true, /*East=*/false>(
-		    out, position, src, srcWidth, clipX, color);
-	}
-}
-
-template <bool SkipColorIndexZero>
-void RenderCelOutlineClippedXY(const CelOutputBuffer &out, Point position, const byte *src, std::size_t srcSize, // NOLINT(readability-function-cognitive-complexity)
-    std::size_t srcWidth, std::uint8_t color)
+/**
+ * @brief Marks the opaque pixels of a CEL frame for its outline
+ */
+void AddCelOpaquePixels(OutlineMaskBuilder &builder, const byte *src, std::size_t srcSize, bool skipColorIndexZero)
 {
 	const auto *srcEnd = src + srcSize;
-
-	// Skip the bottom clipped lines.
-	const auto dstHeight = out.h();
-	while (position.y > dstHeight && src != srcEnd) {
-		src = SkipRestOfCelLine(src, static_cast<std::int_fast16_t>(srcWidth));
-		--position.y;
-	}
-	if (src == srcEnd)
-		return;
-
-	ClipX clipX = CalculateClipX(position.x, srcWidth, out);
-	if (clipX.width < 0)
-		return;
-	if (clipX.left > 0) {
-		--clipX.left, ++clipX.width;
-	} else if (clipX.right > 0) {
-		--clipX.right, ++clipX.width;
-	}
-	position.x += static_cast<int>(clipX.left);
-
-	if (position.y == dstHeight) {
-		// After-bottom line - can only draw north.
-		src = RenderCelOutlineRowClipped<SkipColorIndexZero, /*North=*/true, /*West=*/false, /*South=*/false, /*East=*/false,
-		    /*ClipWidth=*/true>(
-		    out, position, src, srcWidth, clipX, color);
-		--position.y;
-	}
-	if (src == srcEnd)
-		return;
-
-	if (position.y + 1 == dstHeight) {
-		// Bottom line - cannot draw south.
-		if (position.x <= 0) {
-			src = RenderCelOutlineRowClipped<SkipColorIndexZero, /*North=*/true, /*West=*/true, /*South=*/false, /*East=*/true,
-			    /*ClipWidth=*/true, /*CheckFirstColumn=*/true, /*CheckLastColumn=*/false>(
-			    out, position, src, srcWidth, clipX, color);
-		} else if (position.x + clipX.width >= out.w()) {
-			src = RenderCelOutlineRowClipped<SkipColorIndexZero, /*North=*/true, /*West=*/true, /*South=*/false, /*East=*/true,
-			    /*ClipWidth=*/true, /*CheckFirstColumn=*/false, /*CheckLastColumn=*/true>(
-			    out, position, src, srcWidth, clipX, color);
-		} else {
-			src = RenderCelOutlineRowClipped<SkipColorIndexZero, /*North=*/true, /*West=*/true, /*South=*/false, /*East=*/true,
-			    /*ClipWidth=*/true>(
-			    out, position, src, srcWidth, clipX, color);
-		}
-		--position.y;
-	}
-
-	if (position.x <= 0) {
-		while (position.y > 0 && src != srcEnd) {
-			src = RenderCelOutlineRowClipped<SkipColorIndexZero, /*North=*/true, /*West=*/true, /*South=*/true, /*East=*/true,
-			    /*ClipWidth=*/true, /*CheckFirstColumn=*/true, /*CheckLastColumn=*/false>(
-			    out, position, src, srcWidth, clipX, color);
-			--position.y;
-		}
-	} else if (position.x + clipX.width >= out.w()) {
-		while (position.y > 0 && src != srcEnd) {
-			src = RenderCelOutlineRowClipped<SkipColorIndexZero, /*North=*/true, /*West=*/true, /*South=*/true, /*East=*/true,
-			    /*ClipWidth=*/true, /*CheckFirstColumn=*/false, /*CheckLastColumn=*/true>(
-			    out, position, src, srcWidth, clipX, color);
-			--position.y;
-		}
-	} else {
-		while (position.y > 0 && src != srcEnd) {
-			src = RenderCelOutlineRowClipped<SkipColorIndexZero, /*North=*/true, /*West=*/true, /*South=*/true, /*East=*/true,
-			    /*ClipWidth=*/true>(
-			    out, position, src, srcWidth, clipX, color);
-			--position.y;
+	std::size_t offset = 0;
+	while (src < srcEnd) {
+		auto v = static_cast<std::uint8_t>(*src++);
+		if (IsCelTransparent(v)) {
+			offset += GetCelTransparentWidth(v);
+			continue;
 		}
-	}
-	if (src == srcEnd)
-		return;
-
-	if (position.y == 0) {
-		if (position.x <= 0) {
-			src = RenderCelOutlineRowClipped<SkipColorIndexZero, /*North=*/false, /*West=*/true, /*South=*/true, /*East=*/true,
-			    /*ClipWidth=*/true, /*CheckFirstColumn=*/true, /*CheckLastColumn=*/false>(
-			    out, position, src, srcWidth, clipX, color);
-		} else if (position.x + clipX.width >= out.w()) {
-			src = RenderCelOutlineRowClipped<SkipColorIndexZero, /*North=*/false, /*West=*/true, /*South=*/true, /*East=*/true,
-			    /*ClipWidth=*/true, /*CheckFirstColumn=*/false, /*CheckLastColumn=*/true>(
-			    out, position, src, srcWidth, clipX, color);
+		if (!skipColorIndexZero) {
+			builder.AddOpaque(offset, v, /*fill=*/true);
 		} else {
-			src = RenderCelOutlineRowClipped<SkipColorIndexZero, /*North=*/false, /*West=*/true, /*South=*/true, /*East=*/true,
-			    /*ClipWidth=*/true>(
-			    out, position, src, srcWidth, clipX, color);
+			for (int i = 0; i < v; i++) {
+				if (src[i] != byte { 0 })
+					builder.AddOpaque(offset + i, 1, /*fill=*/false);
+			}
 		}
-		--position.y;
-	}
-	if (src == srcEnd)
-		return;
-
-	if (position.y == -1) {
-		// Special case: the top of the sprite is 1px below the last line, render just the outline above.
-		RenderCelOutlineRowClipped<SkipColorIndexZero, /*North=*/false, /*West=*/false, /*South=*/true, /*East=*/false,
-		    /*ClipWidth=*/true>(
-		    out, position, src, srcWidth, clipX, color);
-	}
-}
-
-template <bool SkipColorIndexZero>
-void RenderCelOutline(const CelOutputBuffer &out, Point position, const byte *src, std::size_t srcSize,
-    std::size_t srcWidth, std::uint8_t color)
-{
-	if (position.x > 0 && position.x + static_cast<int>(srcWidth) < static_cast<int>(out.w())) {
-		RenderCelOutlineClippedY<SkipColorIndexZero>(out, position, src, srcSize, srcWidth, color);
-	} else {
-		RenderCelOutlineClippedXY<SkipColorIndexZero>(out, position, src, srcSize, srcWidth, color);
+		src += v;
+		offset += v;
 	}
 }
 
@@ -537,30 +232,85 @@ void CelBlitSafeTo(const CelOutputBuffer &out, Point position, const byte *pRLEB
 	RenderCel(out, position, pRLEBytes, nDataSize, nWidth, RenderLineMemcpy, NullLineEndFn);
 }
 
+/** Color transform of sprites drawn at full light, chosen at compile time so it costs nothing. */
+struct Unlit {
+	DVL_ALWAYS_INLINE std::uint8_t operator()(std::uint8_t color) const
+	{
+		return color;
+	}
+};
+
+/** Color transform through a light table. */
+struct Lit {
+	const std::uint8_t *tbl;
+
+	DVL_ALWAYS_INLINE std::uint8_t operator()(std::uint8_t color) const
+	{
+		return tbl[color];
+	}
+};
+
 /**
- * @brief Same as CelBlitLightSafeTo but with stippled transparency applied
- * @param out Target buffer
- * @param position Target buffer coordinate
- * @param pRLEBytes CEL pixel stream (run-length encoded)
- * @param nDataSize Size of CEL in bytes
+ * @brief Draws every other pixel of a CEL
+ * @tparam PitchIsEven Whether the stipple pattern flips from one line to the next
  */
-void CelBlitLightTransSafeTo(const CelOutputBuffer &out, Point position, const byte *pRLEBytes, int nDataSize, int nWidth)
+template <bool PitchIsEven, typename Light>
+void RenderCelStippled(const CelOutputBuffer &out, Point position, const byte *pRLEBytes, int nDataSize, int nWidth, Light light)
 {
-	assert(pRLEBytes != nullptr);
-	const std::uint8_t *tbl = &pLightTbl[light_table_index * 256];
 	bool shift = (reinterpret_cast<uintptr_t>(&out[position]) % 2 == 1);
-	const bool pitchIsEven = (out.pitch() % 2 == 0);
 	RenderCel(
 	    out, position, pRLEBytes, nDataSize, nWidth,
-	    [tbl, &shift](std::uint8_t *dst, const std::uint8_t *src, std::size_t width) {
+	    [light, &shift](std::uint8_t *dst, const std::uint8_t *src, std::size_t width) {
 		    if (reinterpret_cast<uintptr_t>(dst) % 2 == (shift ? 1 : 0)) {
 			    ++dst, ++src, --width;
 		    }
 		    for (const auto *dstEnd = dst + width; dst < dstEnd; dst += 2, src += 2) {
-			    *dst = tbl[*src];
+			    *dst = light(*src);
+		    }
+	    },
+	    [&shift]() {
+		    if (PitchIsEven)
+			    shift = !shift;
+	    });
+}
+
+/** Blends a CEL with what is already in the buffer. */
+template <typename Light>
+void RenderCelBlended(const CelOutputBuffer &out, Point position, const byte *pRLEBytes, int nDataSize, int nWidth, Light light)
+{
+	RenderCel(
+	    out, position, pRLEBytes, nDataSize, nWidth, [light](std::uint8_t *dst, const uint8_t *src, std::size_t w) {
+		    while (w-- > 0) {
+			    *dst = paletteTransparencyLookup[*dst][light(*src++)];
+			    ++dst;
 		    }
 	    },
-	    [pitchIsEven, &shift]() { if (pitchIsEven) shift = !shift; });
+	    NullLineEndFn);
+}
+
+/**
+ * @brief Same as CelBlitLightSafeTo but with stippled transparency applied
+ * @param out Target buffer
+ * @param position Target buffer coordinate
+ * @param pRLEBytes CEL pixel stream (run-length encoded)
+ * @param nDataSize Size of CEL in bytes
+ */
+void CelBlitLightTransSafeTo(const CelOutputBuffer &out, Point position, const byte *pRLEBytes, int nDataSize, int nWidth)
+{
+	assert(pRLEBytes != nullptr);
+	const bool pitchIsEven = (out.pitch() % 2 == 0);
+	if (light_table_index == 0) {
+		if (pitchIsEven)
+			RenderCelStippled<true>(out, position, pRLEBytes, nDataSize, nWidth, Unlit {});
+		else
+			RenderCelStippled<false>(out, position, pRLEBytes, nDataSize, nWidth, Unlit {});
+		return;
+	}
+	const Lit light { &pLightTbl[light_table_index * 256] };
+	if (pitchIsEven)
+		RenderCelStippled<true>(out, position, pRLEBytes, nDataSize, nWidth, light);
+	else
+		RenderCelStippled<false>(out, position, pRLEBytes, nDataSize, nWidth, light);
 }
 
 /**
@@ -574,17 +324,13 @@ void CelBlitLightTransSafeTo(const CelOutputBuffer &out, Point position, const b
 void CelBlitLightBlendedSafeTo(const CelOutputBuffer &out, Point position, const byte *pRLEBytes, int nDataSize, int nWidth, uint8_t *tbl)
 {
 	assert(pRLEBytes != nullptr);
+	if (tbl == nullptr && light_table_index == 0) {
+		RenderCelBlended(out, position, pRLEBytes, nDataSize, nWidth, Unlit {});
+		return;
+	}
 	if (tbl == nullptr)
 		tbl = &pLightTbl[light_table_index * 256];
-
-	RenderCel(
-	    out, position, pRLEBytes, nDataSize, nWidth, [tbl](std::uint8_t *dst, const uint8_t *src, std::size_t w) {
-		    while (w-- > 0) {
-			    *dst = paletteTransparencyLookup[*dst][tbl[*src++]];
-			    ++dst;
-		    }
-	    },
-	    NullLineEndFn);
+	RenderCelBlended(out, position, pRLEBytes, nDataSize, nWidth, Lit { tbl });
 }
 
 /**
@@ -699,10 +445,11 @@ void CelBlitOutlineTo(const CelOutputBuffer &out, uint8_t col, Point position, c
 {
 	int nDataSize;
 	const byte *src = CelGetFrameClipped(cel.Data(), frame, &nDataSize);
-	if (skipColorIndexZero)
-		RenderCelOutline<true>(out, position, src, nDataSize, cel.Width(frame), col);
-	else
-		RenderCelOutline<false>(out, position, src, nDataSize, cel.Width(frame), col);
+	const OutlineKey key { src, static_cast<std::size_t>(nDataSize), cel.Width(frame), skipColorIndexZero };
+	const OutlineMask &mask = GetOutline(key, [&](OutlineMaskBuilder &builder) {
+		AddCelOpaquePixels(builder, src, nDataSize, skipColorIndexZero);
+	});
+	DrawOutline(out, position, mask, col);
 }
 
 std::pair<int, int> MeasureSolidHorizontalBounds(const CelSprite &cel, int frame)
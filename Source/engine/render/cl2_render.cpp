@@ -6,8 +6,17 @@
 #include "cl2_render.hpp"
 
 #include <algorithm>
+#include <atomic>
+#include <list>
+#include <memory>
+#include <unordered_map>
+#include <utility>
+#include <vector>
 
 #include "engine/render/common_impl.h"
+#include "engine/render/outline_cache.hpp"
+#include "lighting.h"
+#include "options.h"
 #include "scrollrt.h"
 #include "utils/attributes.h"
 
@@ -89,26 +98,107 @@ DVL_ALWAYS_INLINE DVL_ATTRIBUTE_HOT const byte *SkipRestOfCl2Line(
 	return src;
 }
 
+/** Entries from an older generation are stale, see `InvalidateLitSpriteCache`. */
+std::atomic<std::uint32_t> LitSpriteCacheGeneration { 1 };
+
+/** Where the bottom clipping loop of the CL2 renderers stands after one of its steps. */
+struct Cl2SkipState {
+	/** Offset of the next control byte */
+	std::uint32_t srcOffset;
+	/** Lines skipped so far */
+	std::uint16_t lines;
+	/** Pixels of the next line covered by the last run */
+	std::uint16_t xOffset;
+};
+
+/**
+ * @brief The steps of skipping the lines of CL2 frames, for frames drawn clipped at the bottom of the buffer.
+ *
+ * Transparent runs cross line boundaries, so a line can only be found by decoding every line below it.
+ * Sprites partly below the viewport did that on every frame; with the steps recorded once, the first
+ * visible line is found with a binary search.
+ */
+class Cl2SkipIndex {
+public:
+	const std::vector<Cl2SkipState> &Get(const byte *src, std::size_t size, std::size_t width)
+	{
+		if (generation_ != LitSpriteCacheGeneration) {
+			frames_.clear();
+			generation_ = LitSpriteCacheGeneration;
+		}
+
+		const Key key { src, size };
+		auto it = frames_.find(key);
+		if (it != frames_.end())
+			return it->second;
+
+		if (frames_.size() >= MaxFrames)
+			frames_.clear();
+		std::vector<Cl2SkipState> &states = frames_[key];
+		const byte *const begin = src;
+		const byte *const end = src + size;
+		std::uint16_t lines = 0;
+		SkipSize skipSize = { 0, 0 };
+		while (src != end) {
+			src = SkipRestOfCl2Line(src, static_cast<std::int_fast16_t>(width),
+			    static_cast<std::int_fast16_t>(width - skipSize.xOffset), skipSize);
+			lines += static_cast<std::uint16_t>(skipSize.wholeLines);
+			states.push_back({ static_cast<std::uint32_t>(src - begin), lines, static_cast<std::uint16_t>(skipSize.xOffset) });
+		}
+		return states;
+	}
+
+private:
+	static constexpr std::size_t MaxFrames = 1024;
+
+	using Key = std::pair<const byte *, std::size_t>;
+	struct KeyHash {
+		std::size_t operator()(const Key &key) const
+		{
+			return std::hash<const void *>()(key.first) ^ key.second;
+		}
+	};
+
+	std::unordered_map<Key, std::vector<Cl2SkipState>, KeyHash> frames_;
+	std::uint32_t generation_ = 0;
+};
+
+/** Each render thread keeps its own index, like the lit sprites. */
+thread_local Cl2SkipIndex Cl2SkipSteps;
+
+/**
+ * @brief Skips the lines of a CL2 frame that are below the buffer
+ * @param layout The frame as loaded, `src` can be a lit copy of it with the same runs
+ * @return How many pixels of the first visible line were covered by the last skipped run
+ */
+DVL_ALWAYS_INLINE std::int_fast16_t SkipClippedCl2Lines(const CelOutputBuffer &out, Point &position, const byte *&src, const byte *srcEnd, std::size_t srcWidth, const byte *layout)
+{
+	const int clippedLines = position.y - out.h() + 1;
+	if (clippedLines <= 0 || src == srcEnd)
+		return 0;
+
+	// Same steps as skipping with SkipRestOfCl2Line until enough lines are skipped or the data ends.
+	const std::vector<Cl2SkipState> &states = Cl2SkipSteps.Get(layout, srcEnd - src, srcWidth);
+	auto state = std::lower_bound(states.begin(), states.end(), clippedLines, [](const Cl2SkipState &s, int lines) {
+		return s.lines < lines;
+	});
+	if (state == states.end())
+		--state;
+	src += state->srcOffset;
+	position.y -= state->lines;
+	return state->xOffset;
+}
+
 /** Renders a CL2 sprite with only vertical clipping to the output buffer. */
 template <typename RenderPixels, typename RenderFill>
 DVL_ALWAYS_INLINE DVL_ATTRIBUTE_HOT void RenderCl2ClipY(
-    const CelOutputBuffer &out, Point position, const byte *src, std::size_t srcSize, std::size_t srcWidth,
+    const CelOutputBuffer &out, Point position, const byte *src, std::size_t srcSize, std::size_t srcWidth, const byte *layout,
     const RenderPixels &renderPixels, const RenderFill &renderFill)
 {
 	const auto *srcEnd = src + srcSize;
 
 	// Skip the bottom clipped lines.
-	std::int_fast16_t xOffset = 0;
-	{
-		const auto dstHeight = out.h();
-		SkipSize skipSize = { 0, 0 };
-		while (position.y >= dstHeight && src != srcEnd) {
-			src = SkipRestOfCl2Line(src, static_cast<std::int_fast16_t>(srcWidth),
-			    static_cast<std::int_fast16_t>(srcWidth - skipSize.xOffset), skipSize);
-			position.y -= static_cast<int>(skipSize.wholeLines);
-		}
-		xOffset = skipSize.xOffset;
-	}
+	std::int_fast16_t xOffset = SkipClippedCl2Lines(out, position, src, srcEnd, srcWidth, layout);
 
 	auto *dst = &out[position];
 	const auto *dstBegin = out.begin();
@@ -145,23 +235,13 @@ DVL_ALWAYS_INLINE DVL_ATTRIBUTE_HOT void RenderCl2ClipY(
 /** Renders a CEL with both horizontal and vertical clipping to the output buffer. */
 template <typename RenderPixels, typename RenderFill>
 DVL_ALWAYS_INLINE DVL_ATTRIBUTE_HOT void RenderCl2ClipXY( // NOLINT(readability-function-cognitive-complexity)
-    const CelOutputBuffer &out, Point position, const byte *src, std::size_t srcSize, std::size_t srcWidth, ClipX clipX,
+    const CelOutputBuffer &out, Point position, const byte *src, std::size_t srcSize, std::size_t srcWidth, const byte *layout, ClipX clipX,
     const RenderPixels &renderPixels, const RenderFill &renderFill)
 {
 	const auto *srcEnd = src + srcSize;
 
 	// Skip the bottom clipped lines.
-	std::int_fast16_t xOffset = 0;
-	{
-		const auto dstHeight = out.h();
-		SkipSize skipSize = { 0, 0 };
-		while (position.y >= dstHeight && src != srcEnd) {
-			src = SkipRestOfCl2Line(src, static_cast<std::int_fast16_t>(srcWidth),
-			    static_cast<std::int_fast16_t>(srcWidth - skipSize.xOffset), skipSize);
-			position.y -= static_cast<int>(skipSize.wholeLines);
-		}
-		xOffset = skipSize.xOffset;
-	}
+	std::int_fast16_t xOffset = SkipClippedCl2Lines(out, position, src, srcEnd, srcWidth, layout);
 
 	position.x += static_cast<int>(clipX.left);
 
@@ -248,16 +328,16 @@ DVL_ALWAYS_INLINE DVL_ATTRIBUTE_HOT void RenderCl2ClipXY( // NOLINT(readability-
 
 template <typename RenderPixels, typename RenderFill>
 DVL_ALWAYS_INLINE DVL_ATTRIBUTE_HOT void RenderCl2(
-    const CelOutputBuffer &out, Point position, const byte *src, std::size_t srcSize, std::size_t srcWidth,
+    const CelOutputBuffer &out, Point position, const byte *src, std::size_t srcSize, std::size_t srcWidth, const byte *layout,
     const RenderPixels &renderPixels, const RenderFill &renderFill)
 {
 	const ClipX clipX = CalculateClipX(position.x, srcWidth, out);
 	if (clipX.width <= 0)
 		return;
 	if (static_cast<std::size_t>(clipX.width) == srcWidth) {
-		RenderCl2ClipY(out, position, src, srcSize, srcWidth, renderPixels, renderFill);
+		RenderCl2ClipY(out, position, src, srcSize, srcWidth, layout, renderPixels, renderFill);
 	} else {
-		RenderCl2ClipXY(out, position, src, srcSize, srcWidth, clipX, renderPixels, renderFill);
+		RenderCl2ClipXY(out, position, src, srcSize, srcWidth, layout, clipX, renderPixels, renderFill);
 	}
 }
 
@@ -269,11 +349,12 @@ DVL_ALWAYS_INLINE DVL_ATTRIBUTE_HOT void RenderCl2(
  * @param pRLEBytes CL2 pixel stream (run-length encoded)
  * @param nDataSize Size of CL2 in bytes
  * @param nWidth Width of sprite
+ * @param layout Frame with the same runs as `pRLEBytes` that the line skipping steps are recorded for
  */
-void Cl2BlitSafe(const CelOutputBuffer &out, int sx, int sy, const byte *pRLEBytes, int nDataSize, int nWidth)
+void Cl2BlitSafe(const CelOutputBuffer &out, int sx, int sy, const byte *pRLEBytes, int nDataSize, int nWidth, const byte *layout = nullptr)
 {
 	RenderCl2(
-	    out, { sx, sy }, pRLEBytes, nDataSize, nWidth,
+	    out, { sx, sy }, pRLEBytes, nDataSize, nWidth, layout != nullptr ? layout : pRLEBytes,
 #ifndef DEBUG_RENDER_COLOR
 	    [](std::uint8_t *dst, const std::uint8_t *src, std::size_t w) {
 		    std::memcpy(dst, src, w);
@@ -305,7 +386,7 @@ void Cl2BlitSafe(const CelOutputBuffer &out, int sx, int sy, const byte *pRLEByt
 void Cl2BlitLightSafe(const CelOutputBuffer &out, int sx, int sy, const byte *pRLEBytes, int nDataSize, int nWidth, uint8_t *pTable)
 {
 	RenderCl2(
-	    out, { sx, sy }, pRLEBytes, nDataSize, nWidth,
+	    out, { sx, sy }, pRLEBytes, nDataSize, nWidth, pRLEBytes,
 #ifndef DEBUG_RENDER_COLOR
 	    [pTable](std::uint8_t *dst, const std::uint8_t *src, std::size_t w) {
 		    while (w-- > 0)
@@ -325,405 +406,187 @@ void Cl2BlitLightSafe(const CelOutputBuffer &out, int sx, int sy, const byte *pR
 	);
 }
 
-template <bool North, bool West, bool South, bool East>
-void RenderOutlineForPixel(std::uint8_t *dst, int dstPitch, std::uint8_t color)
-{
-	if (North)
-		dst[-dstPitch] = color;
-	if (West)
-		dst[-1] = color;
-	if (East)
-		dst[1] = color;
-	if (South)
-		dst[dstPitch] = color;
-}
-
-template <bool North, bool West, bool South, bool East>
-void RenderOutlineForPixels(std::uint8_t *dst, int dstPitch, int width, std::uint8_t color)
-{
-	if (North)
-		std::memset(dst - dstPitch, color, width);
-
-	if (West && East)
-		std::memset(dst - 1, color, width + 2);
-	else if (West)
-		std::memset(dst - 1, color, width);
-	else if (East)
-		std::memset(dst + 1, color, width);
-
-	if (South)
-		std::memset(dst + dstPitch, color, width);
-}
-
-template <bool North, bool West, bool South, bool East>
-void RenderOutlineForPixel(std::uint8_t *dst, int dstPitch, std::uint8_t srcColor, std::uint8_t color)
+/**
+ * @brief Copy a CL2 pixel stream with all its colors passed through the light table.
+ */
+void LightCl2Frame(const byte *src, std::size_t size, const uint8_t *pTable, byte *dst)
 {
-	if (srcColor == 0)
-		return;
-	RenderOutlineForPixel<North, West, South, East>(dst, dstPitch, color);
+	const byte *end = src + size;
+	while (src != end) {
+		auto v = static_cast<std::uint8_t>(*src++);
+		*dst++ = static_cast<byte>(v);
+		if (!IsCl2Opaque(v))
+			continue;
+		std::size_t count = IsCl2OpaqueFill(v) ? 1 : GetCl2OpaquePixelsWidth(v);
+		while (count-- > 0)
+			*dst++ = static_cast<byte>(pTable[static_cast<std::uint8_t>(*src++)]);
+	}
 }
 
-template <bool North, bool West, bool South, bool East>
-void RenderOutlineForPixels(std::uint8_t *dst, int dstPitch, int width, const std::uint8_t *src, std::uint8_t color)
-{
-	while (width-- > 0)
-		RenderOutlineForPixel<North, West, South, East>(dst++, dstPitch, *src++, color);
-}
+struct LitFrameKey {
+	const byte *frame;
+	const uint8_t *table;
+	std::size_t size;
 
-template <bool Fill, bool North, bool West, bool South, bool East>
-std::uint8_t *RenderCl2OutlinePixelsCheckFirstColumn(
-    std::uint8_t *dst, int dstPitch, int dstX,
-    const std::uint8_t *src, std::uint8_t width, std::uint8_t color)
-{
-	if (dstX == -1) {
-		if (Fill) {
-			RenderOutlineForPixel</*North=*/false, /*West=*/false, /*South=*/false, East>(
-			    dst++, dstPitch, color);
-		} else {
-			RenderOutlineForPixel</*North=*/false, /*West=*/false, /*South=*/false, East>(
-			    dst++, dstPitch, *src++, color);
-		}
-		--width;
-	}
-	if (width > 0) {
-		if (Fill) {
-			RenderOutlineForPixel<North, /*West=*/false, South, East>(dst++, dstPitch, color);
-		} else {
-			RenderOutlineForPixel<North, /*West=*/false, South, East>(dst++, dstPitch, *src++, color);
-		}
-		--width;
-	}
-	if (width > 0) {
-		if (Fill) {
-			RenderOutlineForPixels<North, West, South, East>(dst, dstPitch, width, color);
-		} else {
-			RenderOutlineForPixels<North, West, South, East>(dst, dstPitch, width, src, color);
-		}
-		dst += width;
+	bool operator==(const LitFrameKey &other) const
+	{
+		return frame == other.frame && table == other.table && size == other.size;
 	}
-	return dst;
-}
+};
 
-template <bool Fill, bool North, bool West, bool South, bool East>
-std::uint8_t *RenderCl2OutlinePixelsCheckLastColumn(
-    std::uint8_t *dst, int dstPitch, int dstX, int dstW,
-    const std::uint8_t *src, std::uint8_t width, std::uint8_t color)
-{
-	const bool lastPixel = dstX < dstW && width >= 1;
-	const bool oobPixel = dstX + width > dstW;
-	const int numSpecialPixels = (lastPixel ? 1 : 0) + (oobPixel ? 1 : 0);
-	if (width > numSpecialPixels) {
-		width -= numSpecialPixels;
-		if (Fill) {
-			RenderOutlineForPixels<North, West, South, East>(dst, dstPitch, width, color);
-		} else {
-			RenderOutlineForPixels<North, West, South, East>(dst, dstPitch, width, src, color);
-			src += width;
-		}
-		dst += width;
-	}
-	if (lastPixel) {
-		if (Fill) {
-			RenderOutlineForPixel<North, West, South, /*East=*/false>(dst++, dstPitch, color);
-		} else {
-			RenderOutlineForPixel<North, West, South, /*East=*/false>(dst++, dstPitch, *src++, color);
-		}
-	}
-	if (oobPixel) {
-		if (Fill) {
-			RenderOutlineForPixel</*North=*/false, West, /*South=*/false, /*East=*/false>(dst++, dstPitch, color);
-		} else {
-			RenderOutlineForPixel</*North=*/false, West, /*South=*/false, /*East=*/false>(dst++, dstPitch, *src++, color);
-		}
+struct LitFrameKeyHash {
+	std::size_t operator()(const LitFrameKey &key) const
+	{
+		return std::hash<const void *>()(key.frame) ^ (std::hash<const void *>()(key.table) * 31);
 	}
-	return dst;
-}
+};
 
-template <bool Fill, bool North, bool West, bool South, bool East, bool CheckFirstColumn, bool CheckLastColumn>
-std::uint8_t *RenderCl2OutlinePixels(
-    std::uint8_t *dst, int dstPitch, int dstX, int dstW,
-    const std::uint8_t *src, std::uint8_t width, std::uint8_t color)
-{
-	if (Fill && *src == 0)
-		return dst + width;
+struct LitFrame {
+	LitFrameKey key;
+	std::unique_ptr<byte[]> data;
+	/** Color cycle generation the frame was lit in, 0 if none of its colors are cycled. */
+	std::uint32_t cycleGeneration;
+};
 
-	if (CheckFirstColumn && dstX <= 0) {
-		return RenderCl2OutlinePixelsCheckFirstColumn<Fill, North, West, South, East>(
-		    dst, dstPitch, dstX, src, width, color);
-	}
-	if (CheckLastColumn && dstX + width >= dstW) {
-		return RenderCl2OutlinePixelsCheckLastColumn<Fill, North, West, South, East>(
-		    dst, dstPitch, dstX, dstW, src, width, color);
-	}
-	if (Fill) {
-		RenderOutlineForPixels<North, West, South, East>(dst, dstPitch, width, color);
-	} else {
-		RenderOutlineForPixels<North, West, South, East>(dst, dstPitch, width, src, color);
-	}
-	return dst + width;
-}
+/** Frames showing cycled colors from an older generation must be lit again, see `InvalidateCycledLitSprites`. */
+std::atomic<std::uint32_t> LitSpriteCycleGeneration { 1 };
 
-template <bool North, bool West, bool South, bool East,
-    bool ClipWidth = false, bool CheckFirstColumn = false, bool CheckLastColumn = false>
-const byte *RenderCl2OutlineRowClipped( // NOLINT(readability-function-cognitive-complexity)
-    const CelOutputBuffer &out, Point position, const byte *src, std::size_t srcWidth,
-    ClipX clipX, std::uint8_t color, SkipSize &skipSize)
+/**
+ * @brief Whether any pixel of the CL2 frame has a color that lighting_color_cycling rotates
+ */
+bool HasCycledColors(const byte *src, std::size_t size)
 {
-	std::int_fast16_t remainingWidth = clipX.width;
-	std::uint8_t v;
+	const byte *end = src + size;
+	while (src != end) {
+		auto v = static_cast<std::uint8_t>(*src++);
+		if (!IsCl2Opaque(v))
+			continue;
+		std::size_t count = IsCl2OpaqueFill(v) ? 1 : GetCl2OpaquePixelsWidth(v);
+		for (; count > 0; count--) {
+			if (IsLightCycledColor(static_cast<std::uint8_t>(*src++)))
+				return true;
+		}
+	}
+	return false;
+}
 
-	auto *dst = &out[position];
-	const auto dstPitch = out.pitch();
+std::atomic<std::uint32_t> LitSpriteCacheHits;
+std::atomic<std::uint32_t> LitSpriteCacheMisses;
+std::atomic<std::uint32_t> LitSpriteCacheEvictions;
 
-	const auto renderPixels = [&](bool fill, std::uint8_t w) {
-		if (fill) {
-			dst = RenderCl2OutlinePixels</*Fill=*/true, North, West, South, East, CheckFirstColumn, CheckLastColumn>(
-			    dst, dstPitch, position.x, out.w(), reinterpret_cast<const std::uint8_t *>(src), w, color);
-			++src;
-		} else {
-			dst = RenderCl2OutlinePixels</*Fill=*/false, North, West, South, East, CheckFirstColumn, CheckLastColumn>(
-			    dst, dstPitch, position.x, out.w(), reinterpret_cast<const std::uint8_t *>(src), w, color);
-			src += v;
+/**
+ * @brief Least recently used CL2 frames with a light table already applied, sized by `sgOptions.Graphics.nLitSpriteCacheSize`.
+ */
+class LitSpriteCache {
+public:
+	/**
+	 * @return The lit pixel stream, nullptr if the frame doesn't fit or the cache is disabled
+	 */
+	const byte *Get(const byte *frame, std::size_t size, const uint8_t *pTable)
+	{
+#ifdef DEBUG_RENDER_COLOR
+		return nullptr;
+#endif
+		const std::size_t capacity = static_cast<std::size_t>(sgOptions.Graphics.nLitSpriteCacheSize) * 1024;
+		if (size > capacity / 8)
+			return nullptr;
+
+		if (generation_ != LitSpriteCacheGeneration) {
+			frames_.clear();
+			index_.clear();
+			size_ = 0;
+			generation_ = LitSpriteCacheGeneration;
 		}
-	};
 
-	if (ClipWidth) {
-		auto remainingLeftClip = clipX.left - skipSize.xOffset;
-		if (skipSize.xOffset > clipX.left) {
-			position.x += static_cast<int>(skipSize.xOffset - clipX.left);
-			dst += skipSize.xOffset - clipX.left;
-		}
-		while (remainingLeftClip > 0) {
-			v = static_cast<std::uint8_t>(*src++);
-			if (IsCl2Opaque(v)) {
-				const bool fill = IsCl2OpaqueFill(v);
-				v = fill ? GetCl2OpaqueFillWidth(v) : GetCl2OpaquePixelsWidth(v);
-				if (v > remainingLeftClip) {
-					const std::uint8_t overshoot = v - remainingLeftClip;
-					renderPixels(fill, overshoot);
-					position.x += overshoot;
-				} else {
-					src += fill ? 1 : v;
-				}
-			} else {
-				if (v > remainingLeftClip) {
-					const std::uint8_t overshoot = v - remainingLeftClip;
-					dst += overshoot;
-					position.x += overshoot;
-				}
+		const LitFrameKey key { frame, pTable, size };
+		auto it = index_.find(key);
+		if (it != index_.end()) {
+			frames_.splice(frames_.begin(), frames_, it->second);
+			LitFrame &lit = frames_.front();
+			const std::uint32_t cycleGeneration = LitSpriteCycleGeneration;
+			if (lit.cycleGeneration != 0 && lit.cycleGeneration != cycleGeneration) {
+				LightCl2Frame(frame, size, pTable, lit.data.get());
+				lit.cycleGeneration = cycleGeneration;
 			}
-			remainingLeftClip -= v;
+			LitSpriteCacheHits.fetch_add(1, std::memory_order_relaxed);
+			return lit.data.get();
 		}
-		remainingWidth += remainingLeftClip;
-	} else {
-		position.x += static_cast<int>(skipSize.xOffset);
-		dst += skipSize.xOffset;
-		remainingWidth -= skipSize.xOffset;
-	}
-
-	while (remainingWidth > 0) {
-		v = static_cast<std::uint8_t>(*src++);
-		if (IsCl2Opaque(v)) {
-			const bool fill = IsCl2OpaqueFill(v);
-			v = fill ? GetCl2OpaqueFillWidth(v) : GetCl2OpaquePixelsWidth(v);
-			renderPixels(fill, ClipWidth ? std::min(remainingWidth, static_cast<std::int_fast16_t>(v)) : v);
-		} else {
-			dst += v;
+		LitSpriteCacheMisses.fetch_add(1, std::memory_order_relaxed);
+
+		while (size_ + size > capacity) {
+			const LitFrame &oldest = frames_.back();
+			size_ -= oldest.key.size;
+			index_.erase(oldest.key);
+			frames_.pop_back();
+			LitSpriteCacheEvictions.fetch_add(1, std::memory_order_relaxed);
 		}
-		remainingWidth -= v;
-		position.x += v;
-	}
 
-	if (ClipWidth) {
-		remainingWidth += clipX.right;
-		if (remainingWidth > 0) {
-			src = SkipRestOfCl2Line(src, static_cast<std::int_fast16_t>(srcWidth),
-			    remainingWidth, skipSize);
-			if (skipSize.wholeLines > 1)
-				dst -= dstPitch * (skipSize.wholeLines - 1);
-			remainingWidth = -skipSize.xOffset;
-		}
-	}
-	if (remainingWidth < 0) {
-		skipSize = GetSkipSize(-remainingWidth, static_cast<std::int_fast16_t>(srcWidth));
-		++skipSize.wholeLines;
-	} else {
-		skipSize.xOffset = 0;
-		skipSize.wholeLines = 1;
-	}
+		const std::uint32_t cycleGeneration = LightTablesCycle() && HasCycledColors(frame, size) ? LitSpriteCycleGeneration.load() : 0;
+		frames_.push_front({ key, std::make_unique<byte[]>(size), cycleGeneration });
+		LightCl2Frame(frame, size, pTable, frames_.front().data.get());
+		index_[key] = frames_.begin();
+		size_ += size;
+		return frames_.front().data.get();
+	}
+
+private:
+	/** Most recently used first */
+	std::list<LitFrame> frames_;
+	std::unordered_map<LitFrameKey, std::list<LitFrame>::iterator, LitFrameKeyHash> index_;
+	/** Total size of the cached pixel streams */
+	std::size_t size_ = 0;
+	std::uint32_t generation_ = 0;
+};
 
-	return src;
-}
+/** Each render thread keeps its own frames, like the tile cache. */
+thread_local LitSpriteCache LitSprites;
 
-void RenderCl2OutlineClippedY(const CelOutputBuffer &out, Point position, const byte *src, std::size_t srcSize, // NOLINT(readability-function-cognitive-complexity)
-    std::size_t srcWidth, std::uint8_t color)
+void Cl2BlitLightCached(const CelOutputBuffer &out, int sx, int sy, const byte *pRLEBytes, int nDataSize, int nWidth, uint8_t *pTable)
 {
-	const auto *srcEnd = src + srcSize;
-
-	// Skip the bottom clipped lines.
-	const auto dstHeight = out.h();
-	SkipSize skipSize = { 0, 0 };
-	while (position.y >= dstHeight && src != srcEnd) {
-		src = SkipRestOfCl2Line(src, static_cast<std::int_fast16_t>(srcWidth),
-		    static_cast<std::int_fast16_t>(srcWidth - skipSize.xOffset), skipSize);
-		position.y -= static_cast<int>(skipSize.wholeLines);
-	}
-	if (src == srcEnd)
-		return;
-
-	const ClipX clipX = { 0, 0, static_cast<decltype(ClipX {}.width)>(srcWidth) };
-
-	if (position.y == dstHeight) {
-		// After-bottom line - can only draw north.
-		src = RenderCl2OutlineRowClipped</*North=*/true, /*West=*/false, /*South=*/false, /*East=*/false>(
-		    out, position, src, srcWidth, clipX, color, skipSize);
-		position.y -= static_cast<int>(skipSize.wholeLines);
-	}
-	if (src == srcEnd)
-		return;
-
-	if (position.y + 1 == dstHeight) {
-		// Bottom line - cannot draw south.
-		src = RenderCl2OutlineRowClipped</*North=*/true, /*West=*/true, /*South=*/false, /*East=*/true>(
-		    out, position, src, srcWidth, clipX, color, skipSize);
-		position.y -= static_cast<int>(skipSize.wholeLines);
-	}
-
-	while (position.y > 0 && src != srcEnd) {
-		src = RenderCl2OutlineRowClipped</*North=*/true, /*West=*/true, /*South=*/true, /*East=*/true>(
-		    out, position, src, srcWidth, clipX, color, skipSize);
-		position.y -= static_cast<int>(skipSize.wholeLines);
-	}
-	if (src == srcEnd)
-		return;
-
-	if (position.y == 0) {
-		src = RenderCl2OutlineRowClipped</*North=*/false, /*West=*/true, /*South=*/true, /*East=*/true>(
-		    out, position, src, srcWidth, clipX, color, skipSize);
-		position.y -= static_cast<int>(skipSize.wholeLines);
-	}
-	if (src == srcEnd)
-		return;
+	const byte *lit = LitSprites.Get(pRLEBytes, nDataSize, pTable);
+	if (lit != nullptr)
+		Cl2BlitSafe(out, sx, sy, lit, nDataSize, nWidth, pRLEBytes);
+	else
+		Cl2BlitLightSafe(out, sx, sy, pRLEBytes, nDataSize, nWidth, pTable);
+}
 
-	if (position.y == -1) {
-		// Special case: the top of the sprite is 1px below the last line, render just the outline above.
-		RenderCl2OutlineRowClipped</*North=*/false, /*West=*/false, /*South=*/true, /*East=*/false>(
-		    out, position, src, srcWidth, clipX, color, skipSize);
-	}
+/**
+ * @brief Whether a frame drawn at (sx, sy) misses the buffer entirely, its lines go up from `sy`
+ *
+ * Checked before looking up or building a lit copy of the frame, which would otherwise be done for
+ * sprites standing just outside the view.
+ */
+bool IsCl2OutsideBuffer(const CelOutputBuffer &out, int sx, int sy, int width)
+{
+	return sy < 0 || sx >= out.w() || sx + width <= 0;
 }
 
-void RenderCl2OutlineClippedXY(const CelOutputBuffer &out, Point position, const byte *src, std::size_t srcSize, // NOLINT(readability-function-cognitive-complexity)
-    std::size_t srcWidth, std::uint8_t color)
+/**
+ * @brief Marks the opaque pixels of a CL2 frame for its outline, pixels with color index 0 don't count
+ */
+void AddCl2OpaquePixels(OutlineMaskBuilder &builder, const byte *src, std::size_t srcSize)
 {
 	const auto *srcEnd = src + srcSize;
-
-	// Skip the bottom clipped lines.
-	const auto dstHeight = out.h();
-	SkipSize skipSize = { 0, 0 };
-	while (position.y >= dstHeight && src != srcEnd) {
-		src = SkipRestOfCl2Line(src, static_cast<std::int_fast16_t>(srcWidth),
-		    static_cast<std::int_fast16_t>(srcWidth - skipSize.xOffset), skipSize);
-		position.y -= static_cast<int>(skipSize.wholeLines);
-	}
-	if (src == srcEnd)
-		return;
-
-	ClipX clipX = CalculateClipX(position.x, srcWidth, out);
-	if (clipX.width < 0)
-		return;
-	if (clipX.left > 0) {
-		--clipX.left, ++clipX.width;
-	} else if (clipX.right > 0) {
-		--clipX.right, ++clipX.width;
-	}
-	position.x += static_cast<int>(clipX.left);
-
-	if (position.y == dstHeight) {
-		// After-bottom line - can only draw north.
-		src = RenderCl2OutlineRowClipped</*North=*/true, /*West=*/false, /*South=*/false, /*East=*/false,
-		    /*ClipWidth=*/true>(out, position, src, srcWidth, clipX, color, skipSize);
-		position.y -= static_cast<int>(skipSize.wholeLines);
-	}
-	if (src == srcEnd)
-		return;
-
-	if (position.y + 1 == dstHeight) {
-		// Bottom line - cannot draw south.
-		if (position.x <= 0) {
-			src = RenderCl2OutlineRowClipped</*North=*/true, /*West=*/true, /*South=*/false, /*East=*/true,
-			    /*ClipWidth=*/true, /*CheckFirstColumn=*/true, /*CheckLastColumn=*/false>(
-			    out, position, src, srcWidth, clipX, color, skipSize);
-		} else if (position.x + clipX.width >= out.w()) {
-			src = RenderCl2OutlineRowClipped</*North=*/true, /*West=*/true, /*South=*/false, /*East=*/true,
-			    /*ClipWidth=*/true, /*CheckFirstColumn=*/false, /*CheckLastColumn=*/true>(
-			    out, position, src, srcWidth, clipX, color, skipSize);
-		} else {
-			src = RenderCl2OutlineRowClipped</*North=*/true, /*West=*/true, /*South=*/false, /*East=*/true,
-			    /*ClipWidth=*/true>(
-			    out, position, src, srcWidth, clipX, color, skipSize);
-		}
-		position.y -= static_cast<int>(skipSize.wholeLines);
-	}
-
-	if (position.x <= 0) {
-		while (position.y > 0 && src != srcEnd) {
-			src = RenderCl2OutlineRowClipped</*North=*/true, /*West=*/true, /*South=*/true, /*East=*/true,
-			    /*ClipWidth=*/true, /*CheckFirstColumn=*/true, /*CheckLastColumn=*/false>(
-			    out, position, src, srcWidth, clipX, color, skipSize);
-			position.y -= static_cast<int>(skipSize.wholeLines);
-		}
-	} else if (position.x + clipX.width >= out.w()) {
-		while (position.y > 0 && src != srcEnd) {
-			src = RenderCl2OutlineRowClipped</*North=*/true, /*West=*/true, /*South=*/true, /*East=*/true,
-			    /*ClipWidth=*/true, /*CheckFirstColumn=*/false, /*CheckLastColumn=*/true>(
-			    out, position, src, srcWidth, clipX, color, skipSize);
-			position.y -= static_cast<int>(skipSize.wholeLines);
-		}
-	} else {
-		while (position.y > 0 && src != srcEnd) {
-			src = RenderCl2OutlineRowClipped</*North=*/true, /*West=*/true, /*South=*/true, /*East=*/true,
-			    /*ClipWidth=*/true>(
-			    out, position, src, srcWidth, clipX, color, skipSize);
-			position.y -= static_cast<int>(skipSize.wholeLines);
-		}
-	}
-	if (src == srcEnd)
-		return;
-
-	if (position.y == 0) {
-		if (position.x <= 0) {
-			src = RenderCl2OutlineRowClipped</*North=*/false, /*West=*/true, /*South=*/true, /*East=*/true,
-			    /*ClipWidth=*/true, /*CheckFirstColumn=*/true, /*CheckLastColumn=*/false>(
-			    out, position, src, srcWidth, clipX, color, skipSize);
-		} else if (position.x + clipX.width >= out.w()) {
-			src = RenderCl2OutlineRowClipped</*North=*/false, /*West=*/true, /*South=*/true, /*East=*/true,
-			    /*ClipWidth=*/true, /*CheckFirstColumn=*/false, /*CheckLastColumn=*/true>(
-			    out, position, src, srcWidth, clipX, color, skipSize);
+	std::size_t offset = 0;
+	while (src < srcEnd) {
+		auto v = static_cast<std::uint8_t>(*src++);
+		if (!IsCl2Opaque(v)) {
+			offset += v;
+		} else if (IsCl2OpaqueFill(v)) {
+			v = GetCl2OpaqueFillWidth(v);
+			if (*src != byte { 0 })
+				builder.AddOpaque(offset, v, /*fill=*/true);
+			++src;
+			offset += v;
 		} else {
-			src = RenderCl2OutlineRowClipped</*North=*/false, /*West=*/true, /*South=*/true, /*East=*/true,
-			    /*ClipWidth=*/true>(
-			    out, position, src, srcWidth, clipX, color, skipSize);
+			v = GetCl2OpaquePixelsWidth(v);
+			for (int i = 0; i < v; i++) {
+				if (src[i] != byte { 0 })
+					builder.AddOpaque(offset + i, 1, /*fill=*/false);
+			}
+			src += v;
+			offset += v;
 		}
-		position.y -= static_cast<int>(skipSize.wholeLines);
-	}
-	if (src == srcEnd)
-		return;
-
-	if (position.y == -1) {
-		// Special case: the top of the sprite is 1px below the last line, render just the outline above.
-		RenderCl2OutlineRowClipped</*North=*/false, /*West=*/false, /*South=*/true, /*East=*/false,
-		    /*ClipWidth=*/true>(
-		    out, position, src, srcWidth, clipX, color, skipSize);
-	}
-}
-
-void RenderCl2Outline(const CelOutputBuffer &out, Point position, const byte *src, std::size_t srcSize,
-    std::size_t srcWidth, std::uint8_t color)
-{
-	if (position.x > 0 && position.x + static_cast<int>(srcWidth) < static_cast<int>(out.w())) {
-		RenderCl2OutlineClippedY(out, position, src, srcSize, srcWidth, color);
-	} else {
-		RenderCl2OutlineClippedXY(out, position, src, srcSize, srcWidth, color);
 	}
 }
 
@@ -733,39 +596,56 @@ void Cl2ApplyTrans(byte *p, const std::array<uint8_t, 256> &ttbl, int nCel)
 {
 	assert(p != nullptr);
 
+	bool isIdentity = true;
+	for (int i = 0; i < 256 && isIdentity; i++)
+		isIdentity = ttbl[i] == i;
+	if (isIdentity)
+		return;
+
+	const std::uint8_t *tbl = ttbl.data();
 	for (int i = 1; i <= nCel; i++) {
 		constexpr int FrameHeaderSize = 10;
 		int nDataSize;
-		byte *dst = CelGetFrame(p, i, &nDataSize) + FrameHeaderSize;
-		nDataSize -= FrameHeaderSize;
-		while (nDataSize > 0) {
-			auto v = static_cast<std::uint8_t>(*dst++);
-			nDataSize--;
-			assert(nDataSize >= 0);
+		byte *frame = CelGetFrame(p, i, &nDataSize);
+		auto *dst = reinterpret_cast<std::uint8_t *>(frame + FrameHeaderSize);
+		const auto *dstEnd = reinterpret_cast<std::uint8_t *>(frame + nDataSize);
+		// Only the payload of the opaque runs is remapped, one bounds check per run.
+		while (dst < dstEnd) {
+			const std::uint8_t v = *dst++;
 			if (!IsCl2Opaque(v))
 				continue;
-			if (IsCl2OpaqueFill(v)) {
-				nDataSize--;
-				assert(nDataSize >= 0);
-				*dst = static_cast<byte>(ttbl[static_cast<std::uint8_t>(*dst)]);
-				dst++;
-			} else {
-				v = GetCl2OpaquePixelsWidth(v);
-				nDataSize -= v;
-				assert(nDataSize >= 0);
-				while (v-- > 0) {
-					*dst = static_cast<byte>(ttbl[static_cast<std::uint8_t>(*dst)]);
-					dst++;
-				}
-			}
+			const std::size_t width = IsCl2OpaqueFill(v) ? 1 : GetCl2OpaquePixelsWidth(v);
+			assert(dst + width <= dstEnd);
+			for (std::uint8_t *runEnd = dst + width; dst != runEnd; dst++)
+				*dst = tbl[*dst];
 		}
 	}
 }
 
+void InvalidateLitSpriteCache()
+{
+	LitSpriteCacheGeneration++;
+}
+
+void InvalidateCycledLitSprites()
+{
+	// Skip 0, it marks frames without cycled colors
+	if (++LitSpriteCycleGeneration == 0)
+		LitSpriteCycleGeneration++;
+}
+
+LitSpriteCacheStats GetLitSpriteCacheStats()
+{
+	return { LitSpriteCacheHits, LitSpriteCacheMisses, LitSpriteCacheEvictions };
+}
+
 void Cl2Draw(const CelOutputBuffer &out, int sx, int sy, const CelSprite &cel, int frame)
 {
 	assert(frame > 0);
 
+	if (IsCl2OutsideBuffer(out, sx, sy, cel.Width(frame)))
+		return;
+
 	int nDataSize;
 	const byte *pRLEBytes = CelGetFrameClipped(cel.Data(), frame, &nDataSize);
 
@@ -779,27 +659,37 @@ void Cl2DrawOutline(const CelOutputBuffer &out, uint8_t col, int sx, int sy, con
 	int nDataSize;
 	const byte *pRLEBytes = CelGetFrameClipped(cel.Data(), frame, &nDataSize);
 
-	RenderCl2Outline(out, { sx, sy }, pRLEBytes, nDataSize, cel.Width(frame), col);
+	const OutlineKey key { pRLEBytes, static_cast<std::size_t>(nDataSize), cel.Width(frame), /*skipColorIndexZero=*/true };
+	const OutlineMask &mask = GetOutline(key, [&](OutlineMaskBuilder &builder) {
+		AddCl2OpaquePixels(builder, pRLEBytes, nDataSize);
+	});
+	DrawOutline(out, { sx, sy }, mask, col);
 }
 
 void Cl2DrawLightTbl(const CelOutputBuffer &out, int sx, int sy, const CelSprite &cel, int frame, char light)
 {
 	assert(frame > 0);
 
+	if (IsCl2OutsideBuffer(out, sx, sy, cel.Width(frame)))
+		return;
+
 	int nDataSize;
 	const byte *pRLEBytes = CelGetFrameClipped(cel.Data(), frame, &nDataSize);
-	Cl2BlitLightSafe(out, sx, sy, pRLEBytes, nDataSize, cel.Width(frame), GetLightTable(light));
+	Cl2BlitLightCached(out, sx, sy, pRLEBytes, nDataSize, cel.Width(frame), GetLightTable(light));
 }
 
 void Cl2DrawLight(const CelOutputBuffer &out, int sx, int sy, const CelSprite &cel, int frame)
 {
 	assert(frame > 0);
 
+	if (IsCl2OutsideBuffer(out, sx, sy, cel.Width(frame)))
+		return;
+
 	int nDataSize;
 	const byte *pRLEBytes = CelGetFrameClipped(cel.Data(), frame, &nDataSize);
 
 	if (light_table_index != 0)
-		Cl2BlitLightSafe(out, sx, sy, pRLEBytes, nDataSize, cel.Width(frame), &pLightTbl[light_table_index * 256]);
+		Cl2BlitLightCached(out, sx, sy, pRLEBytes, nDataSize, cel.Width(frame), &pLightTbl[light_table_index * 256]);
 	else
 		Cl2BlitSafe(out, sx, sy, pRLEBytes, nDataSize, cel.Width(frame));
 }
@@ -62,4 +62,27 @@ void Cl2DrawLightTbl(const CelOutputBuffer &out, int sx, int sy, const CelSprite
  */
 void Cl2DrawLight(const CelOutputBuffer &out, int sx, int sy, const CelSprite &cel, int frame);
 
+/**
+ * @brief Drop all the lit frames cached by Cl2DrawLight and Cl2DrawLightTbl
+ *
+ * Must be called when the light tables change or sprite data may be freed and loaded again.
+ */
+void InvalidateLitSpriteCache();
+
+/**
+ * @brief Light the cached frames that show colors rotated by lighting_color_cycling again when they are next drawn
+ */
+void InvalidateCycledLitSprites();
+
+struct LitSpriteCacheStats {
+	std::uint32_t hits;
+	std::uint32_t misses;
+	std::uint32_t evictions;
+};
+
+/**
+ * @brief Totals of all render threads since startup
+ */
+LitSpriteCacheStats GetLitSpriteCacheStats();
+
 } // namespace devilution
@@ -7,6 +7,7 @@
 
 #include <cstdint>
 #include <cstddef>
+#include <cstring>
 
 #include "engine.h"
 #include "lighting.h"
@@ -38,4 +39,26 @@ inline ClipX CalculateClipX(std::int_fast16_t x, std::size_t w, const CelOutputB
 	return clip;
 }
 
+/**
+ * @brief Maps `n` bytes of `src` through `tbl` into `dst` (which may be `src`).
+ *
+ * A 256-entry byte table has no cheap SIMD form (byte shuffles only index 16 entries and
+ * gathers load 32-bit lanes), so the lookups are unrolled over 8-byte words instead: one load
+ * and one store per word with independent lookups in between.
+ */
+inline void RemapBytes(std::uint8_t *dst, const std::uint8_t *src, std::size_t n, const std::uint8_t *tbl)
+{
+	std::size_t i = 0;
+	for (; i + 8 <= n; i += 8) {
+		std::uint64_t word;
+		std::memcpy(&word, src + i, 8);
+		std::uint64_t mapped = 0;
+		for (int shift = 0; shift < 64; shift += 8)
+			mapped |= static_cast<std::uint64_t>(tbl[(word >> shift) & 0xFF]) << shift;
+		std::memcpy(dst + i, &mapped, 8);
+	}
+	for (; i < n; i++)
+		dst[i] = tbl[src[i]];
+}
+
 } // namespace devilution
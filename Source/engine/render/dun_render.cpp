@@ -6,12 +6,18 @@
 #include "engine/render/dun_render.hpp"
 
 #include <algorithm>
+#include <array>
 #include <climits>
 #include <cstdint>
+#include <vector>
 
+#include <SDL_endian.h>
+
+#include "engine/render/common_impl.h"
 #include "lighting.h"
 #include "options.h"
 #include "utils/attributes.h"
+#include "utils/simd.h"
 
 namespace devilution {
 
@@ -488,6 +494,80 @@ DVL_ALWAYS_INLINE DVL_ATTRIBUTE_HOT void ForEachSetBit(std::uint32_t mask, const
 	}
 }
 
+/**
+ * @brief Calls `setRun(i, n)` for every run of set bits and `unsetRun(i, n)` for every run of unset bits
+ * in the first `width` bits of the mask (from the most significant bit).
+ *
+ * All the bits of the mask after the first `width` must be unset.
+ */
+template <typename SetRunF, typename UnsetRunF>
+DVL_ALWAYS_INLINE DVL_ATTRIBUTE_HOT void ForEachBitRun(std::uint32_t mask, std::uint_fast8_t width, const SetRunF &setRun, const UnsetRunF &unsetRun)
+{
+	std::uint_fast8_t i = 0;
+	while (mask != 0) {
+		const int zeros = CountLeadingZeros(mask);
+		if (zeros != 0) {
+			unsetRun(i, zeros);
+			i += zeros, mask <<= zeros;
+		}
+		if (mask == 0xFFFFFFFF) {
+			setRun(i, width - i);
+			return;
+		}
+		const int ones = CountLeadingZeros(~mask);
+		setRun(i, ones);
+		i += ones, mask <<= ones;
+	}
+	if (i < width)
+		unsetRun(i, width - i);
+}
+
+#if SDL_BYTEORDER == SDL_LIL_ENDIAN && (defined(DVL_SIMD_SSE2) || defined(DVL_SIMD_NEON))
+#define DVL_DUN_RENDER_SIMD
+#endif
+
+#ifdef DVL_DUN_RENDER_SIMD
+/**
+ * @brief Maps every byte of a mask to 8 bytes, one per bit (most significant bit first): 0xFF if the bit is set, 0 otherwise.
+ *
+ * The byte for the most significant bit is the lowest byte of the value,
+ * i.e. the value is meant to be used as a little-endian 8-pixel mask.
+ */
+constexpr std::array<std::uint64_t, 256> ExpandedMaskBits = []() {
+	std::array<std::uint64_t, 256> result {};
+	for (unsigned b = 0; b < 256; ++b) {
+		for (unsigned bit = 0; bit < 8; ++bit) {
+			if ((b & (0x80U >> bit)) != 0)
+				result[b] |= std::uint64_t { 0xFF } << (bit * 8);
+		}
+	}
+	return result;
+}();
+
+/**
+ * @brief Copies the `src` pixels for which the mask bit is set into `dst`, 32 pixels at a time.
+ * @param dst 32-pixel destination line
+ * @param src 32-pixel source line
+ * @param mask Mask with one bit per pixel, most significant bit first
+ */
+DVL_ALWAYS_INLINE DVL_ATTRIBUTE_HOT void RenderLineMaskedSimd(std::uint8_t *dst, const std::uint8_t *src, std::uint32_t mask)
+{
+	for (unsigned half = 0; half < 2; ++half, dst += 16, src += 16, mask <<= 16) {
+		const std::uint64_t lo = ExpandedMaskBits[(mask >> 24) & 0xFF];
+		const std::uint64_t hi = ExpandedMaskBits[(mask >> 16) & 0xFF];
+#ifdef DVL_SIMD_NEON
+		const uint8x16_t m = vreinterpretq_u8_u64(vcombine_u64(vcreate_u64(lo), vcreate_u64(hi)));
+		vst1q_u8(dst, vbslq_u8(m, vld1q_u8(src), vld1q_u8(dst)));
+#else
+		const __m128i m = _mm_set_epi64x(static_cast<std::int64_t>(hi), static_cast<std::int64_t>(lo));
+		const __m128i d = _mm_loadu_si128(reinterpret_cast<const __m128i *>(dst));
+		const __m128i s = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src));
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(dst), _mm_or_si128(_mm_and_si128(m, s), _mm_andnot_si128(m, d)));
+#endif
+	}
+}
+#endif // DVL_DUN_RENDER_SIMD
+
 enum class TransparencyType {
 	Solid,
 	Blended,
@@ -513,9 +593,7 @@ DVL_ALWAYS_INLINE DVL_ATTRIBUTE_HOT void RenderLineOpaque(std::uint8_t *dst, con
 #endif
 	} else { // Partially lit
 #ifndef DEBUG_RENDER_COLOR
-		for (size_t i = 0; i < n; i++) {
-			dst[i] = tbl[src[i]];
-		}
+		RemapBytes(dst, src, n, tbl);
 #else
 		memset(dst, tbl[DBGCOLOR], n);
 #endif
@@ -526,27 +604,34 @@ template <LightType Light>
 DVL_ALWAYS_INLINE DVL_ATTRIBUTE_HOT void RenderLineBlended(std::uint8_t *dst, const std::uint8_t *src, std::uint_fast8_t n, const std::uint8_t *tbl, std::uint32_t mask)
 {
 #ifndef DEBUG_RENDER_COLOR
+	// Opaque runs are rendered as a whole, blended runs without testing the mask for every pixel.
 	if (Light == LightType::FullyDark) {
-		for (size_t i = 0; i < n; i++, mask <<= 1) {
-			if ((mask & 0x80000000) != 0)
-				dst[i] = 0;
-			else
-				dst[i] = paletteTransparencyLookup[0][dst[i]];
-		}
+		ForEachBitRun(
+		    mask, n,
+		    [=](std::uint_fast8_t i, std::uint_fast8_t len) { memset(dst + i, 0, len); },
+		    [=](std::uint_fast8_t i, std::uint_fast8_t len) {
+			    for (const auto end = i + len; i < end; ++i)
+				    dst[i] = paletteTransparencyLookup[0][dst[i]];
+		    });
 	} else if (Light == LightType::FullyLit) {
-		for (size_t i = 0; i < n; i++, mask <<= 1) {
-			if ((mask & 0x80000000) != 0)
-				dst[i] = src[i];
-			else
-				dst[i] = paletteTransparencyLookup[dst[i]][src[i]];
-		}
+		ForEachBitRun(
+		    mask, n,
+		    [=](std::uint_fast8_t i, std::uint_fast8_t len) { memcpy(dst + i, src + i, len); },
+		    [=](std::uint_fast8_t i, std::uint_fast8_t len) {
+			    for (const auto end = i + len; i < end; ++i)
+				    dst[i] = paletteTransparencyLookup[dst[i]][src[i]];
+		    });
 	} else { // Partially lit
-		for (size_t i = 0; i < n; i++, mask <<= 1) {
-			if ((mask & 0x80000000) != 0)
-				dst[i] = tbl[src[i]];
-			else
-				dst[i] = paletteTransparencyLookup[dst[i]][tbl[src[i]]];
-		}
+		ForEachBitRun(
+		    mask, n,
+		    [=](std::uint_fast8_t i, std::uint_fast8_t len) {
+			    for (const auto end = i + len; i < end; ++i)
+				    dst[i] = tbl[src[i]];
+		    },
+		    [=](std::uint_fast8_t i, std::uint_fast8_t len) {
+			    for (const auto end = i + len; i < end; ++i)
+				    dst[i] = paletteTransparencyLookup[dst[i]][tbl[src[i]]];
+		    });
 	}
 #else
 	for (size_t i = 0; i < n; i++, mask <<= 1) {
@@ -561,6 +646,23 @@ DVL_ALWAYS_INLINE DVL_ATTRIBUTE_HOT void RenderLineBlended(std::uint8_t *dst, co
 template <LightType Light>
 DVL_ALWAYS_INLINE DVL_ATTRIBUTE_HOT void RenderLineStippled(std::uint8_t *dst, const std::uint8_t *src, std::uint_fast8_t n, const std::uint8_t *tbl, std::uint32_t mask)
 {
+#if defined(DVL_DUN_RENDER_SIMD) && !defined(DEBUG_RENDER_COLOR)
+	// Full-width lines are the common case (squares and the upper part of trapezoids).
+	if (n == Width) {
+		if (Light == LightType::FullyDark) {
+			constexpr std::uint8_t Black[Width] {};
+			RenderLineMaskedSimd(dst, Black, mask);
+		} else if (Light == LightType::FullyLit) {
+			RenderLineMaskedSimd(dst, src, mask);
+		} else { // Partially lit
+			std::uint8_t lit[Width];
+			for (std::uint_fast8_t i = 0; i < Width; ++i)
+				lit[i] = tbl[src[i]];
+			RenderLineMaskedSimd(dst, lit, mask);
+		}
+		return;
+	}
+#endif
 	if (Light == LightType::FullyDark) {
 		ForEachSetBit(mask, [=](int i) { dst[i] = 0; });
 	} else if (Light == LightType::FullyLit) {
@@ -1283,6 +1385,123 @@ const std::uint32_t *GetMask(TileType tile)
 	return &SolidMask[TILE_HEIGHT - 1];
 }
 
+/** A level piece micro that has been decoded and lit for the tile cache. */
+struct CachedTile {
+	/** Tile cache generation the entry was decoded in, 0 if the entry is unused. */
+	std::uint32_t generation;
+	/** Frame (with the tile type bits) and light table index of the entry. */
+	std::uint32_t key;
+	/** Color cycle generation the entry was lit in, 0 if none of its colors are cycled. */
+	std::uint32_t cycleGeneration;
+	/** Opaque pixels of each row (bottom row first), the leftmost pixel in the most significant bit. */
+	std::uint32_t rowMasks[TILE_HEIGHT];
+	/** Lit pixels of each row (bottom row first). */
+	std::uint8_t pixels[TILE_HEIGHT][Width];
+};
+
+/** Direct-mapped cache of decoded micros, one per render thread, together sized by `sgOptions.Graphics.nTileCacheSize`. */
+thread_local std::vector<CachedTile> TileCache;
+
+/** Entries from an older generation are stale, see `InvalidateTileCache`. */
+std::uint32_t TileCacheGeneration = 1;
+
+/** Number of threads that each have a tile cache, see `SetTileRenderThreads`. */
+unsigned TileRenderThreads = 1;
+
+/** Times `TileCacheGeneration` wrapped around, every thread clears its own cache when it sees a new value. */
+std::uint32_t TileCacheWraps = 0;
+thread_local std::uint32_t TileCacheWrapsSeen = 0;
+
+/** Entries showing cycled colors from an older generation are stale, see `InvalidateCycledTiles`. */
+std::uint32_t TileCycleGeneration = 1;
+
+/** Maps the colors cycled by lighting_color_cycling to 1 and every other color to 0. */
+const std::array<std::uint8_t, 256> CycledColorProbe = [] {
+	std::array<std::uint8_t, 256> probe {};
+	for (int i = 0; i < 256; i++)
+		probe[i] = IsLightCycledColor(i) ? 1 : 0;
+	return probe;
+}();
+
+/**
+ * @brief Returns the current micro decoded and lit with the current light table.
+ * @return nullptr if the micro is not worth caching or the cache is disabled
+ */
+const CachedTile *GetCachedTile(TileType tile, const std::uint8_t *src, const std::uint8_t *tbl)
+{
+#ifdef DEBUG_RENDER_COLOR
+	return nullptr;
+#endif
+	// Fully lit squares are a plain copy already.
+	if (tile == TileType::Square && light_table_index == 0)
+		return nullptr;
+
+	const std::size_t capacity = static_cast<std::size_t>(sgOptions.Graphics.nTileCacheSize) * 1024 / sizeof(CachedTile) / TileRenderThreads;
+	if (capacity == 0)
+		return nullptr;
+	if (TileCache.size() != capacity || TileCacheWrapsSeen != TileCacheWraps) {
+		TileCache.assign(capacity, CachedTile {});
+		TileCacheWrapsSeen = TileCacheWraps;
+	}
+
+	const std::uint32_t key = ((level_cel_block & 0x7FFF) << 8) | (light_table_index & 0xFF);
+	CachedTile &entry = TileCache[(key * 2654435761U) % capacity];
+	if (entry.generation == TileCacheGeneration && entry.key == key
+	    && (entry.cycleGeneration == 0 || entry.cycleGeneration == TileCycleGeneration))
+		return &entry;
+
+	// Decode the micro twice, over a black and over a white background.
+	// The pixels that end up different are the transparent ones.
+	std::uint8_t background[TILE_HEIGHT][Width];
+	memset(entry.pixels, 0, sizeof(entry.pixels));
+	memset(background, 0xFF, sizeof(background));
+	const Clip clip { 0, 0, 0, 0, Width, GetTileHeight(tile) };
+	const auto *mask = &SolidMask[TILE_HEIGHT - 1];
+	// A negative pitch stores the rows bottom to top.
+	constexpr int Pitch = -Width;
+	if (light_table_index == 0) {
+		RenderTileType<TransparencyType::Solid, LightType::FullyLit>(tile, &entry.pixels[0][0], Pitch, src, mask, tbl, clip);
+		RenderTileType<TransparencyType::Solid, LightType::FullyLit>(tile, &background[0][0], Pitch, src, mask, tbl, clip);
+	} else {
+		RenderTileType<TransparencyType::Solid, LightType::PartiallyLit>(tile, &entry.pixels[0][0], Pitch, src, mask, tbl, clip);
+		RenderTileType<TransparencyType::Solid, LightType::PartiallyLit>(tile, &background[0][0], Pitch, src, mask, tbl, clip);
+	}
+	for (auto row = 0; row < TILE_HEIGHT; ++row) {
+		std::uint32_t rowMask = 0;
+		for (auto i = 0; i < Width; ++i)
+			rowMask = (rowMask << 1) | (entry.pixels[row][i] == background[row][i] ? 1 : 0);
+		entry.rowMasks[row] = rowMask;
+	}
+
+	// Fully lit micros are copied without the light table, so only the others can show cycled colors.
+	entry.cycleGeneration = 0;
+	if (light_table_index != 0 && LightTablesCycle()) {
+		memset(background, 0, sizeof(background));
+		RenderTileType<TransparencyType::Solid, LightType::PartiallyLit>(tile, &background[0][0], Pitch, src, mask, CycledColorProbe.data(), clip);
+		const auto *probed = &background[0][0];
+		if (std::any_of(probed, probed + sizeof(background), [](std::uint8_t pixel) { return pixel != 0; }))
+			entry.cycleGeneration = TileCycleGeneration;
+	}
+
+	entry.generation = TileCacheGeneration;
+	entry.key = key;
+	return &entry;
+}
+
+DVL_ATTRIBUTE_HOT void RenderCachedTile(const CachedTile &cached, std::uint8_t *dst, int dstPitch, Clip clip)
+{
+	const std::uint32_t firstNOnes = std::uint32_t(-1) << ((sizeof(std::uint32_t) * CHAR_BIT) - clip.width);
+	const auto rowEnd = clip.bottom + clip.height;
+	for (auto row = clip.bottom; row < rowEnd; ++row, dst -= dstPitch) {
+		const std::uint8_t *src = &cached.pixels[row][clip.left];
+		const std::uint32_t mask = (cached.rowMasks[row] << clip.left) & firstNOnes;
+		ForEachBitRun(
+		    mask, static_cast<std::uint_fast8_t>(clip.width),
+		    [=](std::uint_fast8_t i, std::uint_fast8_t len) { memcpy(dst + i, src + i, len); },
+		    [](std::uint_fast8_t, std::uint_fast8_t) {});
+	}
+}
+
 // Blit with left and vertical clipping.
 void RenderBlackTileClipLeftAndVertical(std::uint8_t *dst, int dstPitch, int sx, DiamondClipY clipY)
 {
@@ -1405,6 +1624,8 @@ void RenderTile(const CelOutputBuffer &out, int x, int y)
 	if (mask == &SolidMask[TILE_HEIGHT - 1]) {
 		if (light_table_index == lightmax) {
 			RenderTileType<TransparencyType::Solid, LightType::FullyDark>(tile, dst, dstPitch, src, mask, tbl, clip);
+		} else if (const CachedTile *cached = GetCachedTile(tile, src, tbl); cached != nullptr) {
+			RenderCachedTile(*cached, dst, dstPitch, clip);
 		} else if (light_table_index == 0) {
 			RenderTileType<TransparencyType::Solid, LightType::FullyLit>(tile, dst, dstPitch, src, mask, tbl, clip);
 		} else {
@@ -1432,6 +1653,28 @@ void RenderTile(const CelOutputBuffer &out, int x, int y)
 	}
 }
 
+void InvalidateTileCache()
+{
+	if (++TileCacheGeneration == 0) {
+		// Entries of the old generations could match the reused ones, the cache of every render thread is cleared before its next use
+		TileCacheWraps++;
+		TileCacheGeneration = 1;
+	}
+}
+
+void SetTileRenderThreads(unsigned threads)
+{
+	TileRenderThreads = std::max(threads, 1U);
+}
+
+void InvalidateCycledTiles()
+{
+	if (++TileCycleGeneration == 0) {
+		TileCycleGeneration = 1;
+		InvalidateTileCache();
+	}
+}
+
 void world_draw_black_tile(const CelOutputBuffer &out, int sx, int sy)
 {
 #ifdef DEBUG_RENDER_OFFSET_X
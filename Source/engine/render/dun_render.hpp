@@ -17,6 +17,25 @@ namespace devilution {
  */
 void RenderTile(const CelOutputBuffer &out, int x, int y);
 
+/**
+ * @brief Drop all the decoded micros of the tile cache
+ *
+ * Must be called when the level CEL data or the light tables change.
+ */
+void InvalidateTileCache();
+
+/**
+ * @brief Drop the decoded micros that show colors rotated by lighting_color_cycling
+ */
+void InvalidateCycledTiles();
+
+/**
+ * @brief Set how many threads render tiles, the tile cache budget is split between their caches
+ *
+ * Must not be called while tiles are being rendered.
+ */
+void SetTileRenderThreads(unsigned threads);
+
 /**
  * @brief Render a black 64x31 tile ◆
  * @param out Target buffer
@@ -0,0 +1,168 @@
+/**
+ * @file outline_cache.cpp
+ *
+ * Outlines of sprite frames, precomputed once and drawn as runs of pixels.
+ */
+#include "engine/render/outline_cache.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <functional>
+#include <list>
+#include <unordered_map>
+#include <utility>
+
+namespace devilution {
+
+namespace {
+
+enum : std::uint8_t {
+	Transparent,
+	Opaque,
+	Filled,
+};
+
+/** Enough for every animation of a few hovered sprites. */
+constexpr std::size_t MaxCachedOutlines = 256;
+
+struct OutlineKeyHash {
+	std::size_t operator()(const OutlineKey &key) const
+	{
+		return std::hash<const void *>()(key.src) ^ (key.srcSize * 31) ^ (key.skipColorIndexZero ? 1 : 0);
+	}
+};
+
+struct CachedOutline {
+	OutlineKey key;
+	OutlineMask mask;
+};
+
+/** Entries from an older generation are stale, see `InvalidateOutlineCache`. */
+std::atomic<std::uint32_t> OutlineCacheGeneration { 1 };
+
+/**
+ * @brief Least recently used outlines
+ */
+class OutlineCache {
+public:
+	const OutlineMask *Find(const OutlineKey &key)
+	{
+		if (generation_ != OutlineCacheGeneration) {
+			outlines_.clear();
+			index_.clear();
+			generation_ = OutlineCacheGeneration;
+		}
+
+		auto it = index_.find(key);
+		if (it == index_.end())
+			return nullptr;
+		outlines_.splice(outlines_.begin(), outlines_, it->second);
+		return &outlines_.front().mask;
+	}
+
+	const OutlineMask &Add(const OutlineKey &key, OutlineMask mask)
+	{
+		if (outlines_.size() >= MaxCachedOutlines) {
+			index_.erase(outlines_.back().key);
+			outlines_.pop_back();
+		}
+
+		outlines_.push_front({ key, std::move(mask) });
+		index_[key] = outlines_.begin();
+		return outlines_.front().mask;
+	}
+
+private:
+	/** Most recently used first */
+	std::list<CachedOutline> outlines_;
+	std::unordered_map<OutlineKey, std::list<CachedOutline>::iterator, OutlineKeyHash> index_;
+	std::uint32_t generation_ = 0;
+};
+
+/** Outlines are drawn by the render threads, each keeps its own like the tile cache. */
+thread_local OutlineCache Outlines;
+
+} // namespace
+
+void OutlineMaskBuilder::AddOpaque(std::size_t offset, int count, bool fill)
+{
+	if (count <= 0)
+		return;
+	if (pixels_.size() < offset + count) {
+		const std::size_t lines = (offset + count + width_ - 1) / width_;
+		pixels_.resize(lines * width_, Transparent);
+	}
+	std::fill_n(pixels_.begin() + offset, count, fill ? Filled : Opaque);
+}
+
+OutlineMask OutlineMaskBuilder::Build() const
+{
+	const int lines = static_cast<int>(pixels_.size()) / width_;
+	// The outline reaches one pixel past the frame on every side
+	const int maskWidth = width_ + 2;
+	const int maskHeight = lines + 2;
+	std::vector<bool> outline(static_cast<std::size_t>(maskWidth) * maskHeight);
+	for (int line = 0; line < lines; line++) {
+		for (int x = 0; x < width_; x++) {
+			const std::uint8_t pixel = pixels_[line * width_ + x];
+			if (pixel == Transparent)
+				continue;
+			const int i = (line + 1) * maskWidth + x + 1;
+			if (pixel == Filled)
+				outline[i] = true;
+			outline[i - maskWidth] = true;
+			outline[i - 1] = true;
+			outline[i + 1] = true;
+			outline[i + maskWidth] = true;
+		}
+	}
+
+	OutlineMask mask;
+	for (int line = 0; line < maskHeight; line++) {
+		const int rowStart = line * maskWidth;
+		for (int x = 0; x < maskWidth;) {
+			if (!outline[rowStart + x]) {
+				x++;
+				continue;
+			}
+			int end = x + 1;
+			while (end < maskWidth && outline[rowStart + end])
+				end++;
+			// Lines go up the screen, the bottom line of the frame is drawn at position.y
+			mask.push_back({ static_cast<std::int16_t>(x - 1), static_cast<std::int16_t>(1 - line), static_cast<std::int16_t>(end - x) });
+			x = end;
+		}
+	}
+	return mask;
+}
+
+const OutlineMask *FindOutline(const OutlineKey &key)
+{
+	return Outlines.Find(key);
+}
+
+const OutlineMask &AddOutline(const OutlineKey &key, OutlineMask mask)
+{
+	return Outlines.Add(key, std::move(mask));
+}
+
+void DrawOutline(const CelOutputBuffer &out, Point position, const OutlineMask &mask, std::uint8_t color)
+{
+	for (const OutlineRun &run : mask) {
+		const int y = position.y + run.y;
+		if (y < 0 || y >= out.h())
+			continue;
+		const int begin = std::max(position.x + run.x, 0);
+		const int end = std::min(position.x + run.x + run.width, out.w());
+		if (begin < end)
+			std::memset(&out[{ begin, y }], color, end - begin);
+	}
+}
+
+void InvalidateOutlineCache()
+{
+	OutlineCacheGeneration++;
+}
+
+} // namespace devilution
@@ -0,0 +1,110 @@
+/**
+ * @file outline_cache.hpp
+ *
+ * Outlines of sprite frames, precomputed once and drawn as runs of pixels.
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "engine.h"
+
+namespace devilution {
+
+/**
+ * @brief A horizontal run of outline pixels, relative to the bottom left corner of the frame
+ */
+struct OutlineRun {
+	std::int16_t x;
+	std::int16_t y;
+	std::int16_t width;
+};
+
+using OutlineMask = std::vector<OutlineRun>;
+
+/**
+ * @brief Collects the opaque pixels of a frame while its pixel stream is decoded
+ */
+class OutlineMaskBuilder {
+public:
+	explicit OutlineMaskBuilder(int width)
+	    : width_(width)
+	{
+	}
+
+	/**
+	 * @brief Mark pixels as opaque
+	 * @param offset Position of the first pixel in the pixel stream, lines are stored from the bottom up
+	 * @param count Number of pixels, may continue on the following lines
+	 * @param fill The outline covers the pixels themselves as well, like the renderers do for solid runs
+	 */
+	void AddOpaque(std::size_t offset, int count, bool fill);
+
+	/**
+	 * @brief Every pixel next to an opaque pixel, as drawn by the CEL and CL2 outline renderers
+	 */
+	OutlineMask Build() const;
+
+private:
+	int width_;
+	/** One entry per pixel, bottom line first */
+	std::vector<std::uint8_t> pixels_;
+};
+
+struct OutlineKey {
+	const byte *src;
+	std::size_t srcSize;
+	int srcWidth;
+	bool skipColorIndexZero;
+
+	bool operator==(const OutlineKey &other) const
+	{
+		return src == other.src && srcSize == other.srcSize && srcWidth == other.srcWidth && skipColorIndexZero == other.skipColorIndexZero;
+	}
+};
+
+/**
+ * @brief Returns the cached outline of a frame, nullptr if it hasn't been built yet
+ */
+const OutlineMask *FindOutline(const OutlineKey &key);
+
+/**
+ * @brief Stores the outline of a frame, evicting the least recently used one when the cache is full
+ */
+const OutlineMask &AddOutline(const OutlineKey &key, OutlineMask mask);
+
+/**
+ * @brief Returns the outline of a frame, decoding the frame only the first time
+ * @param decode Called with an OutlineMaskBuilder for the frame on a cache miss
+ */
+template <typename Decode>
+const OutlineMask &GetOutline(const OutlineKey &key, const Decode &decode)
+{
+	const OutlineMask *mask = FindOutline(key);
+	if (mask != nullptr)
+		return *mask;
+
+	OutlineMaskBuilder builder(key.srcWidth);
+	decode(builder);
+	return AddOutline(key, builder.Build());
+}
+
+/**
+ * @brief Draw an outline, clipped to the buffer
+ * @param out Target buffer
+ * @param position Target buffer coordinate of the bottom left corner of the frame
+ * @param mask Outline of the frame
+ * @param color Color index from current palette
+ */
+void DrawOutline(const CelOutputBuffer &out, Point position, const OutlineMask &mask, std::uint8_t color);
+
+/**
+ * @brief Drop all cached outlines
+ *
+ * Must be called when sprite data may be freed and loaded again.
+ */
+void InvalidateOutlineCache();
+
+} // namespace devilution
@@ -5,6 +5,10 @@
  */
 
 #include "text_render.hpp"
+
+#include <array>
+#include <string>
+
 #include "DiabloUI/ui_item.h"
 #include "cel_render.hpp"
 #include "engine.h"
@@ -19,7 +23,7 @@ namespace {
  * small, medium and large sized fonts; which corresponds to smaltext.cel,
  * medtexts.cel and bigtgold.cel respectively.
  */
-const uint8_t FontIndex[256] = {
+constexpr uint8_t FontIndex[256] = {
 	// clang-format off
 	'\0', 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01,
 	0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01,
@@ -41,7 +45,7 @@ const uint8_t FontIndex[256] = {
 };
 
 /** Maps from font index to cel frame number. */
-const uint8_t FontFrame[3][128] = {
+constexpr uint8_t FontFrame[3][128] = {
 	{
 	    // clang-format off
 	     0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
@@ -84,7 +88,7 @@ const uint8_t FontFrame[3][128] = {
  * Maps from cel frame number to character width. Note, the character width
  * may be distinct from the frame width, which is the same for every cel frame.
  */
-const uint8_t FontKern[3][68] = {
+constexpr uint8_t FontKern[3][68] = {
 	{
 	    // clang-format off
 		 8, 10,  7,  9,  8,  7,  6,  8,  8,  3,
@@ -118,6 +122,73 @@ const uint8_t FontKern[3][68] = {
 	}
 };
 
+using CharWidthTable = std::array<std::array<uint8_t, 256>, 3>;
+
+constexpr CharWidthTable BuildCharWidths()
+{
+	CharWidthTable widths {};
+	for (int size = 0; size < 3; size++) {
+		for (int c = 0; c < 256; c++)
+			widths[size][c] = FontKern[size][FontFrame[size][FontIndex[c]]];
+	}
+	return widths;
+}
+
+/** Maps from character code to character width, combining FontIndex, FontFrame and FontKern. */
+constexpr CharWidthTable CharWidth = BuildCharWidths();
+
+/** A string as WordWrapGameString returned it, callers wrap the same text every frame while it is shown. */
+struct WrappedText {
+	std::string original;
+	std::string wrapped;
+	size_t width;
+	GameFontTables size;
+	int spacing;
+};
+
+constexpr size_t WrappedTextCacheSize = 16;
+std::array<WrappedText, WrappedTextCacheSize> WrappedTextCache;
+/** The next entry of the cache to replace */
+size_t WrappedTextCacheNext;
+
+void WordWrap(char *text, size_t textLength, size_t width, GameFontTables size, int spacing)
+{
+	size_t lineStart = 0;
+	size_t lineWidth = 0;
+	for (unsigned i = 0; i < textLength; i++) {
+		if (text[i] == '\n') { // Existing line break, scan next line
+			lineStart = i + 1;
+			lineWidth = 0;
+			continue;
+		}
+
+		lineWidth += CharWidth[size][static_cast<uint8_t>(text[i])] + spacing;
+
+		if (lineWidth - spacing <= width) {
+			continue; // String is still within the limit, continue to the next line
+		}
+
+		size_t j; // Backtrack to the previous space
+		for (j = i; j >= lineStart; j--) {
+			if (text[j] == ' ') {
+				break;
+			}
+		}
+
+		if (j == lineStart) { // Single word longer than width
+			if (i == textLength)
+				break;
+			j = i;
+		}
+
+		// Break line and continue to next line
+		i = j;
+		text[i] = '\n';
+		lineStart = i + 1;
+		lineWidth = 0;
+	}
+}
+
 enum text_color : uint8_t {
 	ColorWhite,
 	ColorBlue,
@@ -205,8 +276,7 @@ int GetLineWidth(const char *text, GameFontTables size, int spacing, int *charac
 		if (text[i] == '\n')
 			break;
 
-		uint8_t frame = FontFrame[size][FontIndex[static_cast<uint8_t>(text[i])]];
-		lineWidth += FontKern[size][frame] + spacing;
+		lineWidth += CharWidth[size][static_cast<uint8_t>(text[i])] + spacing;
 	}
 
 	if (charactersInLine != nullptr)
@@ -229,41 +299,24 @@ int AdjustSpacingToFitHorizontally(int &lineWidth, int maxSpacing, int character
 void WordWrapGameString(char *text, size_t width, GameFontTables size, int spacing)
 {
 	const size_t textLength = strlen(text);
-	size_t lineStart = 0;
-	size_t lineWidth = 0;
-	for (unsigned i = 0; i < textLength; i++) {
-		if (text[i] == '\n') { // Existing line break, scan next line
-			lineStart = i + 1;
-			lineWidth = 0;
-			continue;
-		}
-
-		uint8_t frame = FontFrame[size][FontIndex[static_cast<uint8_t>(text[i])]];
-		lineWidth += FontKern[size][frame] + spacing;
-
-		if (lineWidth - spacing <= width) {
-			continue; // String is still within the limit, continue to the next line
-		}
-
-		size_t j; // Backtrack to the previous space
-		for (j = i; j >= lineStart; j--) {
-			if (text[j] == ' ') {
-				break;
-			}
-		}
 
-		if (j == lineStart) { // Single word longer than width
-			if (i == textLength)
-				break;
-			j = i;
+	// Wrapping only replaces spaces with line breaks, so the result has the same length
+	for (const WrappedText &entry : WrappedTextCache) {
+		if (entry.width == width && entry.size == size && entry.spacing == spacing
+		    && entry.original.size() == textLength && entry.original.compare(0, textLength, text, textLength) == 0) {
+			memcpy(text, entry.wrapped.data(), textLength);
+			return;
 		}
-
-		// Break line and continue to next line
-		i = j;
-		text[i] = '\n';
-		lineStart = i + 1;
-		lineWidth = 0;
 	}
+
+	WrappedText &entry = WrappedTextCache[WrappedTextCacheNext];
+	WrappedTextCacheNext = (WrappedTextCacheNext + 1) % WrappedTextCacheSize;
+	entry.original.assign(text, textLength);
+	WordWrap(text, textLength, width, size, spacing);
+	entry.wrapped.assign(text, textLength);
+	entry.width = width;
+	entry.size = size;
+	entry.spacing = spacing;
 }
 
 /**
@@ -317,7 +370,7 @@ int DrawString(const CelOutputBuffer &out, const char *text, const SDL_Rect &rec
 	unsigned i = 0;
 	for (; i < textLength; i++) {
 		uint8_t frame = FontFrame[size][FontIndex[static_cast<uint8_t>(text[i])]];
-		int symbolWidth = FontKern[size][frame];
+		int symbolWidth = CharWidth[size][static_cast<uint8_t>(text[i])];
 		if (text[i] == '\n' || sx + symbolWidth > rightMargin) {
 			if (sy + lineHeight >= bottomMargin)
 				break;
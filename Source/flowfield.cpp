@@ -0,0 +1,196 @@
+/**
+ * @file flowfield.cpp
+ *
+ * Implementation of the distance maps shared by monsters walking towards the same target.
+ */
+#include "flowfield.h"
+
+#include <algorithm>
+#include <array>
+#include <functional>
+#include <vector>
+
+#include "gendung.h"
+#include "multi.h"
+#include "objects.h"
+#include "path.h"
+#include "player.h"
+
+namespace devilution {
+
+namespace {
+
+/** Every tile reachable in MAX_PATH_LENGTH steps fits within this distance from the goal. */
+constexpr int FieldRadius = MAX_PATH_LENGTH - 1;
+constexpr int FieldSize = 2 * FieldRadius + 1;
+constexpr uint16_t Unreached = UINT16_MAX;
+/** One map per player for both monsters that can and can't open doors */
+constexpr int MaxFields = 2 * MAX_PLRS;
+
+/** Fixed expansion order, so the maps are the same on all clients */
+constexpr Direction FieldDirections[8] = { DIR_S, DIR_SW, DIR_W, DIR_NW, DIR_N, DIR_NE, DIR_E, DIR_SE };
+
+struct FlowField {
+	bool valid;
+	bool canOpenDoors;
+	Point goal;
+	uint32_t lastUsed;
+	/** Walking cost to the goal, using the same weights as FindPath */
+	uint16_t cost[FieldSize][FieldSize];
+};
+
+std::array<FlowField, MaxFields> Fields;
+uint32_t UseCounter;
+
+/** @brief Whether a step in the given direction changes both coordinates */
+bool IsDiagonal(Direction direction)
+{
+	const Point offset = Point { 0, 0 } + direction;
+	return offset.x != 0 && offset.y != 0;
+}
+
+bool IsDoor(_object_id type)
+{
+	return type == OBJ_L1LDOOR || type == OBJ_L1RDOOR
+	    || type == OBJ_L2LDOOR || type == OBJ_L2RDOOR
+	    || type == OBJ_L3LDOOR || type == OBJ_L3RDOOR;
+}
+
+/**
+ * @brief The part of PosOkMonst/PosOkMonst3 that doesn't depend on the monster or other actors.
+ */
+bool IsWalkable(Point position, bool canOpenDoors)
+{
+	if (position.x < 0 || position.y < 0 || position.x >= MAXDUNX || position.y >= MAXDUNY)
+		return false;
+
+	bool isDoor = false;
+	const int objectId = dObject[position.x][position.y];
+	if (objectId != 0) {
+		const ObjectStruct &obj = object[objectId > 0 ? objectId - 1 : -(objectId + 1)];
+		isDoor = canOpenDoors && IsDoor(obj._otype);
+		if (obj._oSolidFlag && !isDoor)
+			return false;
+	}
+
+	return isDoor || !SolidLoc(position);
+}
+
+/**
+ * @brief Same corner check as path_solid_pieces.
+ */
+bool CanStep(Point from, Point to)
+{
+	return !SolidLoc({ from.x, to.y }) && !SolidLoc({ to.x, from.y });
+}
+
+bool IsInField(const FlowField &field, Point position)
+{
+	return std::abs(position.x - field.goal.x) <= FieldRadius && std::abs(position.y - field.goal.y) <= FieldRadius;
+}
+
+uint16_t &FieldCost(FlowField &field, Point position)
+{
+	return field.cost[position.x - field.goal.x + FieldRadius][position.y - field.goal.y + FieldRadius];
+}
+
+void BuildField(FlowField &field)
+{
+	for (auto &column : field.cost)
+		std::fill(std::begin(column), std::end(column), Unreached);
+
+	// Queue entries are the cost in the upper bits and the tile in the lower bits,
+	// which makes the expansion order deterministic.
+	constexpr int TileBits = 12;
+	static_assert(FieldSize * FieldSize <= (1 << TileBits), "Tile indices must fit in the queue entries");
+	std::vector<uint32_t> queue;
+	const auto push = [&](Point position, uint16_t cost) {
+		FieldCost(field, position) = cost;
+		const int x = position.x - field.goal.x + FieldRadius;
+		const int y = position.y - field.goal.y + FieldRadius;
+		queue.push_back((cost << TileBits) | (x * FieldSize + y));
+		std::push_heap(queue.begin(), queue.end(), std::greater<>());
+	};
+
+	push(field.goal, 0);
+	while (!queue.empty()) {
+		std::pop_heap(queue.begin(), queue.end(), std::greater<>());
+		const uint32_t entry = queue.back();
+		queue.pop_back();
+
+		const int tile = entry & ((1 << TileBits) - 1);
+		const Point position = field.goal + Point { tile / FieldSize - FieldRadius, tile % FieldSize - FieldRadius };
+		const uint16_t cost = entry >> TileBits;
+		if (cost != FieldCost(field, position))
+			continue; // Stale entry
+
+		for (Direction direction : FieldDirections) {
+			const Point next = position + direction;
+			if (!IsInField(field, next) || !IsWalkable(next, field.canOpenDoors))
+				continue;
+			const bool diagonal = IsDiagonal(direction);
+			if (diagonal && !CanStep(position, next))
+				continue;
+			const uint16_t nextCost = cost + (diagonal ? 3 : 2);
+			if (nextCost < FieldCost(field, next))
+				push(next, nextCost);
+		}
+	}
+}
+
+FlowField &GetField(Point goal, bool canOpenDoors)
+{
+	UseCounter++;
+
+	FlowField *result = &Fields[0];
+	for (FlowField &field : Fields) {
+		if (field.valid && field.goal == goal && field.canOpenDoors == canOpenDoors) {
+			field.lastUsed = UseCounter;
+			return field;
+		}
+		if (!field.valid || (result->valid && field.lastUsed < result->lastUsed))
+			result = &field;
+	}
+
+	result->valid = true;
+	result->goal = goal;
+	result->canOpenDoors = canOpenDoors;
+	result->lastUsed = UseCounter;
+	BuildField(*result);
+	return *result;
+}
+
+} // namespace
+
+bool GetFlowFieldStep(Point position, Point goal, bool canOpenDoors, Direction &direction)
+{
+	FlowField &field = GetField(goal, canOpenDoors);
+	if (!IsInField(field, position))
+		return false;
+
+	uint16_t bestCost = FieldCost(field, position);
+	bool found = false;
+	for (Direction candidate : FieldDirections) {
+		const Point next = position + candidate;
+		if (!IsInField(field, next))
+			continue;
+		const uint16_t cost = FieldCost(field, next);
+		if (cost >= bestCost)
+			continue;
+		if (IsDiagonal(candidate) && !CanStep(position, next))
+			continue;
+		bestCost = cost;
+		direction = candidate;
+		found = true;
+	}
+
+	return found;
+}
+
+void InvalidateFlowFields()
+{
+	for (FlowField &field : Fields)
+		field.valid = false;
+}
+
+} // namespace devilution
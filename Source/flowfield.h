@@ -0,0 +1,31 @@
+/**
+ * @file flowfield.h
+ *
+ * Interface of the distance maps shared by monsters walking towards the same target.
+ */
+#pragma once
+
+#include "engine.h"
+
+namespace devilution {
+
+/**
+ * @brief Find the step towards goal using a distance map shared by all callers with the same goal.
+ *
+ * The map only takes the dungeon and objects into account, not other monsters or players.
+ * It is built the first time a goal is requested and reused until the goal moves or the map changes.
+ *
+ * @param position Where the step starts
+ * @param goal Tile being walked to
+ * @param canOpenDoors Whether doors count as walkable
+ * @param direction Receives the direction of the step
+ * @return false if goal can't be reached in MAX_PATH_LENGTH steps or position is already the closest tile
+ */
+bool GetFlowFieldStep(Point position, Point goal, bool canOpenDoors, Direction &direction);
+
+/**
+ * @brief Drop all distance maps, call whenever the walkable area of the level changes.
+ */
+void InvalidateFlowFields();
+
+} // namespace devilution
@@ -4,11 +4,181 @@
  * Implementation of general dungeon generation code.
  */
 
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
 #include "init.h"
 #include "options.h"
 
 namespace devilution {
 
+namespace {
+
+/**
+ * @brief Apply a bit operation to a column of dFlags, eight tiles at a time.
+ * @param op Called with the pattern of the requested flags repeated in every byte of a word
+ */
+template <typename Op>
+void UpdateFlagsColumn(int x, int y, int height, uint8_t flags, Op op)
+{
+	constexpr uint64_t EveryByte = 0x0101010101010101ULL;
+	const uint64_t pattern = flags * EveryByte;
+
+	int8_t *tile = &dFlags[x][y];
+	int8_t *const end = tile + height;
+	for (; end - tile >= 8; tile += 8) {
+		uint64_t word;
+		memcpy(&word, tile, sizeof(word));
+		word = op(word, pattern);
+		memcpy(tile, &word, sizeof(word));
+	}
+	for (; tile != end; tile++) {
+		*tile = static_cast<int8_t>(op(static_cast<uint8_t>(*tile), flags));
+	}
+}
+
+/**
+ * @brief Apply a bit operation to all columns of the area, clipped to the map.
+ */
+template <typename Op>
+void UpdateFlags(Rectangle area, uint8_t flags, Op op)
+{
+	const int x1 = std::max(area.position.x, 0);
+	const int y1 = std::max(area.position.y, 0);
+	const int x2 = std::min(area.position.x + area.size.width, MAXDUNX);
+	const int y2 = std::min(area.position.y + area.size.height, MAXDUNY);
+	if (y1 >= y2)
+		return;
+
+	if (y1 == 0 && y2 == MAXDUNY && x2 - x1 > 1) {
+		// Full columns lie back to back
+		UpdateFlagsColumn(x1, 0, (x2 - x1) * MAXDUNY, flags, op);
+		return;
+	}
+
+	for (int x = x1; x < x2; x++) {
+		UpdateFlagsColumn(x, y1, y2 - y1, flags, op);
+	}
+}
+
+/** A SOL file that was read before, they are tiny and shared by all levels of a tileset */
+struct SolidBlockFile {
+	const char *path;
+	bool hellfire;
+	std::unique_ptr<uint8_t[]> data;
+	size_t tileCount;
+};
+
+std::vector<SolidBlockFile> SolidBlockFiles;
+
+/** Number of pieces in pLevelPieces, the entries of LevelPieceMicros after them are variants */
+size_t LevelPieceCount;
+
+const char *GetLevelSOLPath()
+{
+	switch (leveltype) {
+	case DTYPE_TOWN:
+		if (gbIsHellfire)
+			return "NLevels\\TownData\\Town.SOL";
+		return "Levels\\TownData\\Town.SOL";
+	case DTYPE_CATHEDRAL:
+		if (currlevel < 17)
+			return "Levels\\L1Data\\L1.SOL";
+		return "NLevels\\L5Data\\L5.SOL";
+	case DTYPE_CATACOMBS:
+		return "Levels\\L2Data\\L2.SOL";
+	case DTYPE_CAVES:
+		if (currlevel < 17)
+			return "Levels\\L3Data\\L3.SOL";
+		return "NLevels\\L6Data\\L6.SOL";
+	case DTYPE_HELL:
+		return "Levels\\L4Data\\L4.SOL";
+	default:
+		app_fatal("FillSolidBlockTbls");
+	}
+}
+
+const SolidBlockFile &LoadLevelSOLData()
+{
+	const char *path = GetLevelSOLPath();
+	for (const SolidBlockFile &file : SolidBlockFiles) {
+		if (file.hellfire == gbIsHellfire && strcmp(file.path, path) == 0)
+			return file;
+	}
+
+	SolidBlockFile file { path, gbIsHellfire, nullptr, 0 };
+	file.data = LoadFileInMem<uint8_t>(path, &file.tileCount);
+	SolidBlockFiles.push_back(std::move(file));
+	return SolidBlockFiles.back();
+}
+
+/** Every transparency value tile is the top left corner of a 2x2 block of dTransVal */
+FloodFillStack<(MAXDUNX / 2) * (MAXDUNY / 2)> TransFloodStack;
+
+void SetTransparencyBlock(int x, int y)
+{
+	dTransVal[x][y] = TransVal;
+	dTransVal[x + 1][y] = TransVal;
+	dTransVal[x][y + 1] = TransVal;
+	dTransVal[x + 1][y + 1] = TransVal;
+}
+
+/**
+ * @brief Set the transparency value of the area around the floor tile
+ *
+ * Every reached block is marked before it is pushed, so the result does not depend on the order
+ * the blocks are visited in and matches the recursive fill this replaces.
+ */
+void FillTransparencyValues(int i, int j, uint8_t floorID)
+{
+	struct Step {
+		int8_t dx;
+		int8_t dy;
+		/** Corners of a blocked neighbour that face the area: bit 0 top left, 1 top right, 2 bottom left, 3 bottom right */
+		uint8_t corners;
+	};
+	constexpr Step Steps[] = {
+		{ 1, 0, 0b0101 },
+		{ -1, 0, 0b1010 },
+		{ 0, 1, 0b0011 },
+		{ 0, -1, 0b1100 },
+		{ -1, -1, 0b1000 },
+		{ 1, -1, 0b0100 },
+		{ -1, 1, 0b0010 },
+		{ 1, 1, 0b0001 },
+	};
+
+	SetTransparencyBlock(16 + 2 * i, 16 + 2 * j);
+	TransFloodStack.Push(i, j);
+	while (!TransFloodStack.Empty()) {
+		const Point tile = TransFloodStack.Pop();
+		for (const Step &step : Steps) {
+			const int ni = tile.x + step.dx;
+			const int nj = tile.y + step.dy;
+			const int x = 16 + 2 * ni;
+			const int y = 16 + 2 * nj;
+			if (x < 0 || y < 0 || x + 1 >= MAXDUNX || y + 1 >= MAXDUNY)
+				continue;
+			if (dTransVal[x][y] == 0 && dungeon[ni][nj] == floorID) {
+				SetTransparencyBlock(x, y);
+				TransFloodStack.Push(ni, nj);
+				continue;
+			}
+			if ((step.corners & 0b0001) != 0)
+				dTransVal[x][y] = TransVal;
+			if ((step.corners & 0b0010) != 0)
+				dTransVal[x + 1][y] = TransVal;
+			if ((step.corners & 0b0100) != 0)
+				dTransVal[x][y + 1] = TransVal;
+			if ((step.corners & 0b1000) != 0)
+				dTransVal[x + 1][y + 1] = TransVal;
+		}
+	}
+}
+
+} // namespace
+
 /** Contains the tile IDs of the map. */
 uint8_t dungeon[DMAXX][DMAXY];
 /** Contains a backup of the tile IDs of the map. */
@@ -73,8 +243,8 @@ char TransVal;
 bool TransList[256];
 /** Contains the piece IDs of each tile on the map. */
 int dPiece[MAXDUNX][MAXDUNY];
-/** Specifies the dungeon piece information for a given coordinate and block number. */
-MICROS dpiece_defs_map_2[MAXDUNX][MAXDUNY];
+std::vector<MICROS> LevelPieceMicros(1);
+uint16_t dPieceMicros[MAXDUNX][MAXDUNY];
 /** Specifies the transparency at each coordinate of the map. */
 int8_t dTransVal[MAXDUNX][MAXDUNY];
 char dLight[MAXDUNX][MAXDUNY];
@@ -110,37 +280,12 @@ char dSpecial[MAXDUNX][MAXDUNY];
 int themeCount;
 THEME_LOC themeLoc[MAXTHEMES];
 
-std::unique_ptr<uint8_t[]> LoadLevelSOLData(size_t &tileCount)
-{
-	switch (leveltype) {
-	case DTYPE_TOWN:
-		if (gbIsHellfire)
-			return LoadFileInMem<uint8_t>("NLevels\\TownData\\Town.SOL", &tileCount);
-		return LoadFileInMem<uint8_t>("Levels\\TownData\\Town.SOL", &tileCount);
-	case DTYPE_CATHEDRAL:
-		if (currlevel < 17)
-			return LoadFileInMem<uint8_t>("Levels\\L1Data\\L1.SOL", &tileCount);
-		return LoadFileInMem<uint8_t>("NLevels\\L5Data\\L5.SOL", &tileCount);
-	case DTYPE_CATACOMBS:
-		return LoadFileInMem<uint8_t>("Levels\\L2Data\\L2.SOL", &tileCount);
-	case DTYPE_CAVES:
-		if (currlevel < 17)
-			return LoadFileInMem<uint8_t>("Levels\\L3Data\\L3.SOL", &tileCount);
-		return LoadFileInMem<uint8_t>("NLevels\\L6Data\\L6.SOL", &tileCount);
-	case DTYPE_HELL:
-		return LoadFileInMem<uint8_t>("Levels\\L4Data\\L4.SOL", &tileCount);
-	default:
-		app_fatal("FillSolidBlockTbls");
-	}
-}
-
 void FillSolidBlockTbls()
 {
-	size_t tileCount;
-	auto pSBFile = LoadLevelSOLData(tileCount);
+	const SolidBlockFile &file = LoadLevelSOLData();
 
-	for (unsigned i = 0; i < tileCount; i++) {
-		uint8_t bv = pSBFile[i];
+	for (unsigned i = 0; i < file.tileCount; i++) {
+		uint8_t bv = file.data[i];
 		nSolidTable[i + 1] = (bv & 0x01) != 0;
 		nBlockTable[i + 1] = (bv & 0x02) != 0;
 		nMissileTable[i + 1] = (bv & 0x04) != 0;
@@ -150,34 +295,51 @@ void FillSolidBlockTbls()
 	}
 }
 
+void LoadLevelPieces(const char *path)
+{
+	size_t count;
+	pLevelPieces = LoadFileInMem<uint16_t>(path, &count);
+
+	const int blocks = leveltype == DTYPE_TOWN || leveltype == DTYPE_HELL ? 16 : 10;
+	LevelPieceCount = count / blocks;
+	LevelPieceMicros.assign(LevelPieceCount + 1, MICROS {});
+	for (size_t lv = 0; lv < LevelPieceCount; lv++) {
+		const uint16_t *pieces = &pLevelPieces[blocks * lv];
+		MICROS &micros = LevelPieceMicros[lv + 1];
+		for (int i = 0; i < blocks; i++)
+			micros.mt[i] = SDL_SwapLE16(pieces[blocks - 2 + (i & 1) - (i & 0xE)]);
+	}
+}
+
 void SetDungeonMicros()
 {
 	MicroTileLen = 10;
-	int blocks = 10;
-
-	if (leveltype == DTYPE_TOWN) {
+	if (leveltype == DTYPE_TOWN)
 		MicroTileLen = 16;
-		blocks = 16;
-	} else if (leveltype == DTYPE_HELL) {
+	else if (leveltype == DTYPE_HELL)
 		MicroTileLen = 12;
-		blocks = 16;
-	}
 
 	for (int y = 0; y < MAXDUNY; y++) {
-		for (int x = 0; x < MAXDUNX; x++) {
-			int lv = dPiece[x][y];
-			MICROS &micros = dpiece_defs_map_2[x][y];
-			if (lv != 0) {
-				lv--;
-				uint16_t *pieces = &pLevelPieces[blocks * lv];
-				for (int i = 0; i < blocks; i++)
-					micros.mt[i] = SDL_SwapLE16(pieces[blocks - 2 + (i & 1) - (i & 0xE)]);
-			} else {
-				for (int i = 0; i < blocks; i++)
-					micros.mt[i] = 0;
-			}
-		}
+		for (int x = 0; x < MAXDUNX; x++)
+			SetTileMicros(x, y);
+	}
+}
+
+void SetTileMicros(int x, int y)
+{
+	const int lv = dPiece[x][y];
+	assert(lv >= 0 && static_cast<size_t>(lv) <= LevelPieceCount);
+	dPieceMicros[x][y] = lv;
+}
+
+uint16_t AddTileMicros(const MICROS &micros)
+{
+	for (size_t i = LevelPieceCount + 1; i < LevelPieceMicros.size(); i++) {
+		if (memcmp(&LevelPieceMicros[i], &micros, sizeof(micros)) == 0)
+			return static_cast<uint16_t>(i);
 	}
+	LevelPieceMicros.push_back(micros);
+	return static_cast<uint16_t>(LevelPieceMicros.size() - 1);
 }
 
 void DRLG_InitTrans()
@@ -561,4 +723,76 @@ void InitLevels()
 	setlevel = false;
 }
 
+void SetDungeonFlags(Rectangle area, uint8_t flags)
+{
+	UpdateFlags(area, flags, [](uint64_t word, uint64_t pattern) { return word | pattern; });
+}
+
+void ClearDungeonFlags(Rectangle area, uint8_t flags)
+{
+	UpdateFlags(area, flags, [](uint64_t word, uint64_t pattern) { return word & ~pattern; });
+}
+
+void FloodTransparencyValues(uint8_t floorID)
+{
+	int yy = 16;
+	for (int j = 0; j < DMAXY; j++) {
+		int xx = 16;
+		for (int i = 0; i < DMAXX; i++) {
+			if (dungeon[i][j] == floorID && dTransVal[xx][yy] == 0) {
+				FillTransparencyValues(i, j, floorID);
+				TransVal++;
+			}
+			xx += 2;
+		}
+		yy += 2;
+	}
+}
+
+MinisetMatcher::MinisetMatcher(const uint8_t *miniset, const char (&flags)[DMAXX][DMAXY])
+{
+	Compile(miniset, flags);
+}
+
+MinisetMatcher::MinisetMatcher(const uint8_t *miniset, const uint8_t (&flags)[DMAXX][DMAXY])
+{
+	Compile(miniset, flags);
+}
+
+template <typename T>
+void MinisetMatcher::Compile(const uint8_t *miniset, const T (&flags)[DMAXX][DMAXY])
+{
+	width_ = miniset[0];
+	height_ = miniset[1];
+
+	int tileCounts[256] = {};
+	for (auto &column : dungeon) {
+		for (uint8_t tile : column)
+			tileCounts[tile]++;
+	}
+
+	const uint8_t *tiles = &miniset[2];
+	for (int yy = 0; yy < height_; yy++) {
+		for (int xx = 0; xx < width_; xx++) {
+			const uint8_t tile = *tiles++;
+			if (tile != 0)
+				conditions_.push_back({ static_cast<uint8_t>(xx), static_cast<uint8_t>(yy), tile });
+		}
+	}
+	// The search order doesn't change the result, so reject most positions with the first comparison
+	std::stable_sort(conditions_.begin(), conditions_.end(), [&tileCounts](const Condition &a, const Condition &b) {
+		return tileCounts[a.tile] < tileCounts[b.tile];
+	});
+
+	for (int x = 0; x <= DMAXX; x++)
+		flagSums_[x][0] = 0;
+	for (int y = 0; y <= DMAXY; y++)
+		flagSums_[0][y] = 0;
+	for (int x = 0; x < DMAXX; x++) {
+		for (int y = 0; y < DMAXY; y++) {
+			flagSums_[x + 1][y + 1] = flagSums_[x][y + 1] + flagSums_[x + 1][y] - flagSums_[x][y] + (flags[x][y] != 0 ? 1 : 0);
+		}
+	}
+}
+
 } // namespace devilution
@@ -5,8 +5,12 @@
  */
 #pragma once
 
+#include <array>
 #include <cstdint>
+#include <initializer_list>
 #include <memory>
+#include <utility>
+#include <vector>
 
 #include "engine.h"
 #include "scrollrt.h"
@@ -176,7 +180,13 @@ extern int MicroTileLen;
 extern char TransVal;
 extern bool TransList[256];
 extern int dPiece[MAXDUNX][MAXDUNY];
-extern MICROS dpiece_defs_map_2[MAXDUNX][MAXDUNY];
+/**
+ * The micro tiles of the level pieces in drawing order, expanded from pLevelPieces. Entry 0 is
+ * empty, entry n is piece n followed by the variants added with AddTileMicros.
+ */
+extern std::vector<MICROS> LevelPieceMicros;
+/** Specifies the index in LevelPieceMicros of the micro tiles drawn at each coordinate of the map. */
+extern uint16_t dPieceMicros[MAXDUNX][MAXDUNY];
 extern int8_t dTransVal[MAXDUNX][MAXDUNY];
 extern char dLight[MAXDUNX][MAXDUNY];
 extern char dPreLight[MAXDUNX][MAXDUNY];
@@ -192,7 +202,20 @@ extern int themeCount;
 extern THEME_LOC themeLoc[MAXTHEMES];
 
 void FillSolidBlockTbls();
+/**
+ * @brief Load pLevelPieces for the current level type and expand the micro tiles of every piece
+ */
+void LoadLevelPieces(const char *path);
 void SetDungeonMicros();
+/**
+ * @brief Update dPieceMicros of one tile after its dPiece changed
+ */
+void SetTileMicros(int x, int y);
+/**
+ * @brief Find or add a variant of the level pieces, for tiles drawn differently than their piece
+ * @return Index in LevelPieceMicros
+ */
+uint16_t AddTileMicros(const MICROS &micros);
 void DRLG_InitTrans();
 void DRLG_MRectTrans(int x1, int y1, int x2, int y2);
 void DRLG_RectTrans(int x1, int y1, int x2, int y2);
@@ -206,5 +229,195 @@ void DRLG_PlaceThemeRooms(int minSize, int maxSize, int floor, int freq, bool rn
 void DRLG_HoldThemeRooms();
 bool SkipThemeRoom(int x, int y);
 void InitLevels();
+/**
+ * @brief Set the given BFLAG_* bits on every tile of the area, the area is clipped to the map.
+ */
+void SetDungeonFlags(Rectangle area, uint8_t flags);
+/**
+ * @brief Clear the given BFLAG_* bits on every tile of the area, the area is clipped to the map.
+ */
+void ClearDungeonFlags(Rectangle area, uint8_t flags);
+/**
+ * @brief Give every 8-connected area of the floor tile its own TransVal, walls take the value of the area they face
+ *
+ * Areas are numbered in the order their first tile appears in `dungeon`, row by row.
+ */
+void FloodTransparencyValues(uint8_t floorID);
+
+/**
+ * @brief Build a lookup table of the tile IDs in the list, for the rules of the tile fixing passes
+ */
+constexpr std::array<bool, 256> MakeTileSet(std::initializer_list<uint8_t> tiles)
+{
+	std::array<bool, 256> set {};
+	for (uint8_t tile : tiles)
+		set[tile] = true;
+	return set;
+}
+
+/**
+ * @brief Build a lookup table from pairs of tile IDs and their replacement, other tiles map to 0
+ */
+constexpr std::array<uint8_t, 256> MakeTileMap(std::initializer_list<std::pair<uint8_t, uint8_t>> replacements)
+{
+	std::array<uint8_t, 256> map {};
+	for (const auto &replacement : replacements)
+		map[replacement.first] = replacement.second;
+	return map;
+}
+
+/**
+ * @brief Shadow patterns grouped by the base tile type that triggers them
+ *
+ * Built at compile time from the pattern table of a tileset, so placing the shadows only tests the
+ * patterns of the type under each tile. Patterns keep their order within a group.
+ */
+template <std::size_t PatternCount>
+class ShadowPatterns {
+public:
+	constexpr explicit ShadowPatterns(const ShadowStruct (&patterns)[PatternCount])
+	{
+		uint8_t count = 0;
+		for (int type = 0; type < 256; type++) {
+			first_[type] = count;
+			for (const ShadowStruct &pattern : patterns) {
+				if (pattern.strig == type)
+					patterns_[count++] = pattern;
+			}
+		}
+		first_[256] = count;
+	}
+
+	/**
+	 * @brief Place the shadows on every 2x2 block of `dungeon`
+	 * @param types Maps tile IDs to their base tile type
+	 * @param canReplace Tiles where this returns false keep their ID
+	 */
+	template <typename CanReplace>
+	void Apply(const uint8_t *types, CanReplace canReplace) const
+	{
+		for (int y = 1; y < DMAXY; y++) {
+			for (int x = 1; x < DMAXX; x++) {
+				const uint8_t trigger = types[dungeon[x][y]];
+				const uint8_t left = types[dungeon[x - 1][y]];
+				const uint8_t top = types[dungeon[x][y - 1]];
+				const uint8_t topLeft = types[dungeon[x - 1][y - 1]];
+
+				for (int i = first_[trigger]; i < first_[trigger + 1]; i++) {
+					const ShadowStruct &pattern = patterns_[i];
+					if (pattern.s1 != 0 && pattern.s1 != topLeft)
+						continue;
+					if (pattern.s2 != 0 && pattern.s2 != top)
+						continue;
+					if (pattern.s3 != 0 && pattern.s3 != left)
+						continue;
+					if (pattern.nv1 != 0 && canReplace(x - 1, y - 1))
+						dungeon[x - 1][y - 1] = pattern.nv1;
+					if (pattern.nv2 != 0 && canReplace(x, y - 1))
+						dungeon[x][y - 1] = pattern.nv2;
+					if (pattern.nv3 != 0 && canReplace(x - 1, y))
+						dungeon[x - 1][y] = pattern.nv3;
+				}
+			}
+		}
+	}
+
+private:
+	static_assert(PatternCount < 256, "group offsets are stored in a byte");
+
+	ShadowStruct patterns_[PatternCount] {};
+	/** Patterns triggered by type t are patterns_[first_[t]] to patterns_[first_[t + 1] - 1] */
+	uint8_t first_[257] {};
+};
+
+/**
+ * @brief Preallocated work list for the flood fills of the level generators
+ *
+ * The fills keep their pending tiles here rather than recursing once per tile, which could
+ * overflow the small thread stacks of some consoles. Tiles must be marked when pushed so none
+ * is pushed twice.
+ */
+template <int Capacity>
+class FloodFillStack {
+public:
+	bool Empty() const
+	{
+		return size_ == 0;
+	}
+
+	void Push(int x, int y)
+	{
+		assert(size_ < Capacity);
+		tiles_[size_++] = { static_cast<int16_t>(x), static_cast<int16_t>(y) };
+	}
+
+	Point Pop()
+	{
+		const Tile &tile = tiles_[--size_];
+		return { tile.x, tile.y };
+	}
+
+private:
+	struct Tile {
+		int16_t x;
+		int16_t y;
+	};
+
+	std::array<Tile, Capacity> tiles_;
+	int size_ = 0;
+};
+
+/**
+ * @brief The tiles of a miniset prepared for testing many positions of `dungeon`
+ *
+ * Gives the same result as comparing every tile of the miniset with `dungeon` and checking
+ * that no flag is set under it, but tests the tile that is least common in the level first
+ * and looks the flags up in a summed-area table.
+ */
+class MinisetMatcher {
+public:
+	/**
+	 * @param miniset Width and height followed by the tiles to search for (0 matches any tile)
+	 * @param flags The positions where any of these are set under the miniset never match, must not change while matching
+	 */
+	MinisetMatcher(const uint8_t *miniset, const char (&flags)[DMAXX][DMAXY]);
+	MinisetMatcher(const uint8_t *miniset, const uint8_t (&flags)[DMAXX][DMAXY]);
+
+	/**
+	 * @brief Whether the miniset can be placed with its top left corner at the given position of `dungeon`
+	 */
+	bool Matches(int sx, int sy) const
+	{
+		if (FlaggedTiles(sx, sy) != 0)
+			return false;
+		for (const Condition &condition : conditions_) {
+			if (dungeon[sx + condition.x][sy + condition.y] != condition.tile)
+				return false;
+		}
+		return true;
+	}
+
+private:
+	struct Condition {
+		uint8_t x;
+		uint8_t y;
+		uint8_t tile;
+	};
+
+	template <typename T>
+	void Compile(const uint8_t *miniset, const T (&flags)[DMAXX][DMAXY]);
+
+	int FlaggedTiles(int sx, int sy) const
+	{
+		return flagSums_[sx + width_][sy + height_] - flagSums_[sx][sy + height_] - flagSums_[sx + width_][sy] + flagSums_[sx][sy];
+	}
+
+	int width_;
+	int height_;
+	/** Least common tile first */
+	std::vector<Condition> conditions_;
+	/** Number of tiles with flags in [0, x) × [0, y) */
+	uint16_t flagSums_[DMAXX + 1][DMAXY + 1];
+};
 
 } // namespace devilution
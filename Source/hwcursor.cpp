@@ -1,6 +1,7 @@
 #include "hwcursor.hpp"
 
 #include <cstdint>
+#include <map>
 #include <tuple>
 
 #if SDL_VERSION_ATLEAST(2, 0, 0)
@@ -14,6 +15,8 @@
 #include "appfat.h"
 #include "cursor.h"
 #include "engine.h"
+#include "items.h"
+#include "player.h"
 #include "utils/display.h"
 #include "utils/sdl_ptrs.h"
 
@@ -24,6 +27,22 @@ CursorInfo CurrentCursorInfo;
 #if SDL_VERSION_ATLEAST(2, 0, 0)
 SDLCursorUniquePtr CurrentCursor;
 
+/** Sprite ID, outline color and stat flag of the held item (0 and true for other sprites) */
+using GameCursorKey = std::tuple<int, std::uint8_t, bool>;
+
+/**
+ * @brief Game cursors converted for the current palette and scale
+ *
+ * Picking items up and putting them down switches between a handful of cursors, so the converted
+ * cursors are kept instead of redrawing and scaling the sprite each time.
+ */
+std::map<GameCursorKey, SDLCursorUniquePtr> GameCursors;
+/** `pal_surface_palette_version` the cursors in GameCursors were converted with */
+unsigned int GameCursorsPaletteVersion;
+
+/** Upper limit for GameCursors, the cache is emptied when it is reached. */
+constexpr size_t MaxGameCursors = 64;
+
 enum class HotpointPosition {
 	TopLeft,
 	Center,
@@ -40,7 +59,7 @@ Point GetHotpointPosition(const SDL_Surface &surface, HotpointPosition position)
 	app_fatal("Unhandled enum value");
 }
 
-bool SetHardwareCursor(SDL_Surface *surface, HotpointPosition hotpointPosition)
+SDLCursorUniquePtr CreateHardwareCursor(SDL_Surface *surface, HotpointPosition hotpointPosition)
 {
 	float scaleX;
 	float scaleY;
@@ -63,6 +82,12 @@ bool SetHardwareCursor(SDL_Surface *surface, HotpointPosition hotpointPosition)
 		const Point hotpoint = GetHotpointPosition(*scaledSurface, hotpointPosition);
 		newCursor = SDLCursorUniquePtr { SDL_CreateColorCursor(scaledSurface.get(), hotpoint.x, hotpoint.y) };
 	}
+	return newCursor;
+}
+
+bool SetHardwareCursor(SDL_Surface *surface, HotpointPosition hotpointPosition)
+{
+	SDLCursorUniquePtr newCursor = CreateHardwareCursor(surface, hotpointPosition);
 	if (newCursor == nullptr)
 		return false;
 	SDL_SetCursor(newCursor.get());
@@ -70,8 +95,29 @@ bool SetHardwareCursor(SDL_Surface *surface, HotpointPosition hotpointPosition)
 	return true;
 }
 
+GameCursorKey GetGameCursorKey(int pcurs)
+{
+	if (!IsItemSprite(pcurs))
+		return GameCursorKey { pcurs, 0, true };
+	const auto &heldItem = plr[myplr].HoldItem;
+	return GameCursorKey { pcurs, GetOutlineColor(heldItem, true), heldItem._iStatFlag };
+}
+
 bool SetHardwareCursorFromSprite(int pcurs)
 {
+	// Gamma, fades and palette changes all go through palette_update, which bumps the version
+	if (GameCursorsPaletteVersion != pal_surface_palette_version) {
+		GameCursors.clear();
+		GameCursorsPaletteVersion = pal_surface_palette_version;
+	}
+
+	const GameCursorKey key = GetGameCursorKey(pcurs);
+	auto cached = GameCursors.find(key);
+	if (cached != GameCursors.end()) {
+		SDL_SetCursor(cached->second.get());
+		return true;
+	}
+
 	const bool isItem = IsItemSprite(pcurs);
 	const int outlineWidth = isItem ? 1 : 0;
 
@@ -89,9 +135,16 @@ bool SetHardwareCursorFromSprite(int pcurs)
 	SDL_SetColorKey(out.surface, 1, TransparentColor);
 	CelDrawCursor(out, { outlineWidth, size.height - outlineWidth }, pcurs);
 
-	const bool result = SetHardwareCursor(out.surface, isItem ? HotpointPosition::Center : HotpointPosition::TopLeft);
+	SDLCursorUniquePtr newCursor = CreateHardwareCursor(out.surface, isItem ? HotpointPosition::Center : HotpointPosition::TopLeft);
 	out.Free();
-	return result;
+	if (newCursor == nullptr)
+		return false;
+
+	SDL_SetCursor(newCursor.get());
+	if (GameCursors.size() >= MaxGameCursors)
+		GameCursors.clear();
+	GameCursors[key] = std::move(newCursor);
+	return true;
 }
 #endif
 
@@ -123,4 +176,13 @@ void SetHardwareCursor(CursorInfo cursorInfo)
 #endif
 }
 
+void ReinitializeHardwareCursor()
+{
+#if SDL_VERSION_ATLEAST(2, 0, 0)
+	// Called when the palette or the scale changed, which invalidates every converted cursor.
+	GameCursors.clear();
+#endif
+	SetHardwareCursor(GetCurrentCursorInfo());
+}
+
 } // namespace devilution
@@ -106,9 +106,9 @@ inline bool IsHardwareCursor()
 
 void SetHardwareCursor(CursorInfo cursorInfo);
 
-inline void ReinitializeHardwareCursor()
-{
-	SetHardwareCursor(GetCurrentCursorInfo());
-}
+/**
+ * @brief Recreate the current cursor and drop the cached ones, after a palette or scale change
+ */
+void ReinitializeHardwareCursor();
 
 } // namespace devilution
@@ -4,17 +4,23 @@
  * Implementation of routines for initializing the environment, disable screen saver, load MPQ.
  */
 #include <SDL.h>
+#include <algorithm>
 #include <config.h>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "DiabloUI/diabloui.h"
+#include "capture.h"
 #include "dx.h"
 #include "pfile.h"
 #include "storm/storm.h"
+#include "utils/file_prefetch.h"
+#include "utils/file_util.h"
 #include "utils/language.h"
 #include "utils/log.hpp"
 #include "utils/paths.h"
+#include "utils/thread_pool.h"
 #include "utils/ui_fwd.h"
 
 #ifdef __vita__
@@ -53,26 +59,85 @@ HANDLE devilutionx_mpq;
 
 namespace {
 
-HANDLE init_test_access(const std::vector<std::string> &paths, const char *mpq_name)
-{
+/** Set while every archive that was opened is memory mapped */
+bool AllArchivesMapped;
+
+/**
+ * @brief An archive looked up in the search paths, possibly on a worker thread.
+ */
+struct ArchiveProbe {
+	const char *mpqName;
 	HANDLE archive;
-	std::string mpq_abspath;
+	/** The search path the archive was opened from */
+	const std::string *path;
+	bool mapped;
+};
+
+/**
+ * @brief Opens the archive from the first search path that has it, without touching global state.
+ *
+ * Only paths where the file exists are opened, a failed StormLib open is much slower than a stat.
+ */
+ArchiveProbe ProbeArchive(const std::vector<std::string> &paths, const char *mpqName)
+{
+	ArchiveProbe probe { mpqName, nullptr, nullptr, false };
+	std::string mpqAbsPath;
 	for (const auto &path : paths) {
-		mpq_abspath = path + mpq_name;
-		if (SFileOpenArchive(mpq_abspath.c_str(), 0, MPQ_OPEN_READ_ONLY, &archive)) {
-			LogVerbose("  Found: {} in {}", mpq_name, path);
-			SFileSetBasePath(path.c_str());
-			return archive;
-		}
-		if (SErrGetLastError() != STORM_ERROR_FILE_NOT_FOUND) {
-			LogError("Open error {}: {}", SErrGetLastError(), mpq_abspath);
+		mpqAbsPath = path + mpqName;
+		if (!FileExists(mpqAbsPath.c_str()))
+			continue;
+		// Fall back to regular file reads on platforms where the archive can't be mapped
+		probe.mapped = SFileOpenArchive(mpqAbsPath.c_str(), 0, MPQ_OPEN_READ_ONLY | BASE_PROVIDER_MAP, &probe.archive);
+		if (probe.mapped || SFileOpenArchive(mpqAbsPath.c_str(), 0, MPQ_OPEN_READ_ONLY, &probe.archive)) {
+			probe.path = &path;
+			return probe;
 		}
+		probe.archive = nullptr;
+		LogError("Open error {}: {}", SErrGetLastError(), mpqAbsPath);
+	}
+
+	return probe;
+}
+
+/**
+ * @brief Takes over an opened archive on the main thread, in the order the archives are searched.
+ */
+HANDLE UseArchive(const ArchiveProbe &probe)
+{
+	if (probe.archive == nullptr) {
+		LogVerbose("Missing: {}", probe.mpqName);
+		return nullptr;
 	}
-	if (SErrGetLastError() == STORM_ERROR_FILE_NOT_FOUND) {
-		LogVerbose("Missing: {}", mpq_name);
+
+	if (!probe.mapped)
+		AllArchivesMapped = false;
+	LogVerbose("  Found: {} in {}{}", probe.mpqName, *probe.path, probe.mapped ? " (mapped)" : "");
+	SFileSetBasePath(probe.path->c_str());
+	return probe.archive;
+}
+
+HANDLE init_test_access(const std::vector<std::string> &paths, const char *mpq_name)
+{
+	return UseArchive(ProbeArchive(paths, mpq_name));
+}
+
+/**
+ * @brief Opens the given archives at the same time, then takes them over in the listed order.
+ */
+void init_test_access(const std::vector<std::string> &paths, const std::vector<std::pair<const char *, HANDLE *>> &archives)
+{
+	std::vector<ArchiveProbe> probes(archives.size());
+	const auto probe = [&](unsigned i) { probes[i] = ProbeArchive(paths, archives[i].first); };
+	if (archives.size() > 1) {
+		ThreadPool pool(std::min<unsigned>(archives.size() - 1, std::max(SDL_GetCPUCount(), 1)));
+		pool.ParallelFor(archives.size(), probe);
+	} else {
+		for (unsigned i = 0; i < archives.size(); i++)
+			probe(i);
 	}
 
-	return nullptr;
+	for (std::size_t i = 0; i < archives.size(); i++)
+		*archives[i].second = UseArchive(probes[i]);
 }
 
 } // namespace
@@ -82,6 +147,11 @@ void init_cleanup()
 	if (gbIsMultiplayer && gbRunGame) {
 		pfile_write_hero(/*write_game_data=*/false, /*clear_tables=*/true);
 	}
+	pfile_finish_background_save();
+
+	ShutdownFilePrefetch();
+	ShutdownCapture();
+	SFileEnableLockFreeReads(false);
 
 	if (spawn_mpq != nullptr) {
 		SFileCloseArchive(spawn_mpq);
@@ -131,6 +201,7 @@ void init_cleanup()
 		SFileCloseArchive(patch_rt_mpq);
 		patch_rt_mpq = nullptr;
 	}
+	SFileClearArchiveIndex();
 
 	NetClose();
 }
@@ -174,6 +245,8 @@ void init_archives()
 		LogVerbose("MPQ search paths:{}", message);
 	}
 
+	AllArchivesMapped = true;
+
 	diabdat_mpq = init_test_access(paths, "DIABDAT.MPQ");
 	if (diabdat_mpq == nullptr) {
 		// DIABDAT.MPQ is uppercase on the original CD and the GOG version.
@@ -190,31 +263,40 @@ void init_archives()
 		InsertCDDlg();
 	SFileCloseFileThreadSafe(fh);
 
+	// patch_sh.mpq is only looked for without patch_rt.mpq, so both are opened before the others
 	patch_rt_mpq = init_test_access(paths, "patch_rt.mpq");
-	if (patch_rt_mpq == nullptr)
+	if (patch_rt_mpq == nullptr) {
 		patch_rt_mpq = init_test_access(paths, "patch_sh.mpq");
+	}
+
+	// The remaining archives don't depend on each other. The base path ends up at the last one
+	// found, as if they had been opened one after the other.
+	init_test_access(paths, {
+	                            { "hellfire.mpq", &hellfire_mpq },
+	                            { "hfmonk.mpq", &hfmonk_mpq },
+	                            { "hfbard.mpq", &hfbard_mpq },
+	                            { "hfbarb.mpq", &hfbarb_mpq },
+	                            { "hfmusic.mpq", &hfmusic_mpq },
+	                            { "hfvoice.mpq", &hfvoice_mpq },
+	                            { "hfopt1.mpq", &hfopt1_mpq },
+	                            { "hfopt2.mpq", &hfopt2_mpq },
+	                            { "devilutionx.mpq", &devilutionx_mpq },
+	                        });
 
-	hellfire_mpq = init_test_access(paths, "hellfire.mpq");
 	if (hellfire_mpq != nullptr)
 		gbIsHellfire = true;
-	hfmonk_mpq = init_test_access(paths, "hfmonk.mpq");
-	hfbard_mpq = init_test_access(paths, "hfbard.mpq");
 	if (hfbard_mpq != nullptr)
 		gbBard = true;
-	hfbarb_mpq = init_test_access(paths, "hfbarb.mpq");
 	if (hfbarb_mpq != nullptr)
 		gbBarbarian = true;
-	hfmusic_mpq = init_test_access(paths, "hfmusic.mpq");
-	hfvoice_mpq = init_test_access(paths, "hfvoice.mpq");
-	hfopt1_mpq = init_test_access(paths, "hfopt1.mpq");
-	hfopt2_mpq = init_test_access(paths, "hfopt2.mpq");
 
 	if (gbIsHellfire && (hfmonk_mpq == nullptr || hfmusic_mpq == nullptr || hfvoice_mpq == nullptr)) {
 		UiErrorOkDialog(_("Some Hellfire MPQs are missing"), _("Not all Hellfire MPQs were found.\nPlease copy all the hf*.mpq files."));
 		app_fatal(nullptr);
 	}
 
-	devilutionx_mpq = init_test_access(paths, "devilutionx.mpq");
+	SFileClearArchiveIndex();
+	SFileEnableLockFreeReads(AllArchivesMapped);
 }
 
 void init_create_window()
@@ -17,6 +17,7 @@
 #include "palette.h"
 #include "pfile.h"
 #include "plrmsg.h"
+#include "replay.h"
 #include "utils/sdl_geometry.h"
 #include "utils/stdcompat/optional.hpp"
 
@@ -230,11 +231,13 @@ void ShowProgress(interface_mode uMsg)
 
 	PaletteFadeIn(8);
 	IncProgress();
-	sound_init();
 	IncProgress();
 
 	auto &myPlayer = plr[myplr];
 
+	if (uMsg != WM_DIABNEWGAME)
+		ReplayRecordEnd();
+
 	switch (uMsg) {
 	case WM_DIABLOADGAME:
 		IncProgress();
@@ -249,7 +252,9 @@ void ShowProgress(interface_mode uMsg)
 		FreeGameMem();
 		IncProgress();
 		pfile_remove_temp_files();
+		ResetLevelFormats();
 		IncProgress();
+		ReplayRecordBegin();
 		LoadGameLevel(true, ENTRY_MAIN);
 		IncProgress();
 		break;
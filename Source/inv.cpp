@@ -616,6 +616,51 @@ bool AutoEquipEnabled(const PlayerStruct &player, const ItemStruct &item)
 	return true;
 }
 
+namespace {
+
+/**
+ * @brief Gets the cells of the player's inventory grid that hold an item, one bit per cell in InvGrid order.
+ */
+uint64_t GetInventoryOccupancy(const PlayerStruct &player)
+{
+	uint64_t occupancy = 0;
+	for (int i = 0; i < NUM_INV_GRID_ELEM; i++) {
+		if (player.InvGrid[i] != 0)
+			occupancy |= uint64_t { 1 } << i;
+	}
+	return occupancy;
+}
+
+/**
+ * @brief Gets the cells an item of the given size covers when placed in the top left cell of the inventory grid.
+ */
+uint64_t GetItemShapeMask(Size itemSize)
+{
+	uint64_t rowMask = (uint64_t { 1 } << itemSize.width) - 1;
+	uint64_t shape = 0;
+	for (int y = 0; y < itemSize.height; y++)
+		shape |= rowMask << (10 * y);
+	return shape;
+}
+
+bool ItemFitsInSlot(uint64_t occupancy, uint64_t itemShape, Size itemSize, int slotIndex)
+{
+	if (slotIndex % 10 + itemSize.width > 10 || slotIndex / 10 + itemSize.height > NUM_INV_GRID_ELEM / 10)
+		return false;
+	return (occupancy & (itemShape << slotIndex)) == 0;
+}
+
+void PlaceHoldItemInSlot(PlayerStruct &player, int slotIndex, Size itemSize)
+{
+	player.InvList[player._pNumInv] = player.HoldItem;
+	player._pNumInv++;
+
+	AddItemToInvGrid(player, slotIndex, player._pNumInv, itemSize);
+	player.CalcScrolls();
+}
+
+} // namespace
+
 /**
  * @brief Checks whether the given item can be placed on the specified player's inventory.
  * If 'persistItem' is 'True', the item is also placed in the inventory.
@@ -626,15 +671,26 @@ bool AutoEquipEnabled(const PlayerStruct &player, const ItemStruct &item)
 bool AutoPlaceItemInInventory(PlayerStruct &player, const ItemStruct &item, bool persistItem)
 {
 	Size itemSize = GetInventorySize(item);
+	// The grid is read once, every candidate slot is then a shift and a mask
+	const uint64_t occupancy = GetInventoryOccupancy(player);
+	const uint64_t itemShape = GetItemShapeMask(itemSize);
+
+	auto tryPlace = [&](int slotIndex) {
+		if (!ItemFitsInSlot(occupancy, itemShape, itemSize, slotIndex))
+			return false;
+		if (persistItem)
+			PlaceHoldItemInSlot(player, slotIndex, itemSize);
+		return true;
+	};
 
 	if (itemSize.height == 1) {
 		for (int i = 30; i <= 39; i++) {
-			if (AutoPlaceItemInInventorySlot(player, i, item, persistItem))
+			if (tryPlace(i))
 				return true;
 		}
 		for (int x = 9; x >= 0; x--) {
 			for (int y = 2; y >= 0; y--) {
-				if (AutoPlaceItemInInventorySlot(player, 10 * y + x, item, persistItem))
+				if (tryPlace(10 * y + x))
 					return true;
 			}
 		}
@@ -644,14 +700,14 @@ bool AutoPlaceItemInInventory(PlayerStruct &player, const ItemStruct &item, bool
 	if (itemSize.height == 2) {
 		for (int x = 10 - itemSize.width; x >= 0; x -= itemSize.width) {
 			for (int y = 0; y < 3; y++) {
-				if (AutoPlaceItemInInventorySlot(player, 10 * y + x, item, persistItem))
+				if (tryPlace(10 * y + x))
 					return true;
 			}
 		}
 		if (itemSize.width == 2) {
 			for (int x = 7; x >= 0; x -= 2) {
 				for (int y = 0; y < 3; y++) {
-					if (AutoPlaceItemInInventorySlot(player, 10 * y + x, item, persistItem))
+					if (tryPlace(10 * y + x))
 						return true;
 				}
 			}
@@ -661,7 +717,7 @@ bool AutoPlaceItemInInventory(PlayerStruct &player, const ItemStruct &item, bool
 
 	if (itemSize == Size { 1, 3 }) {
 		for (int i = 0; i < 20; i++) {
-			if (AutoPlaceItemInInventorySlot(player, i, item, persistItem))
+			if (tryPlace(i))
 				return true;
 		}
 		return false;
@@ -669,12 +725,12 @@ bool AutoPlaceItemInInventory(PlayerStruct &player, const ItemStruct &item, bool
 
 	if (itemSize == Size { 2, 3 }) {
 		for (int i = 0; i < 9; i++) {
-			if (AutoPlaceItemInInventorySlot(player, i, item, persistItem))
+			if (tryPlace(i))
 				return true;
 		}
 
 		for (int i = 10; i < 19; i++) {
-			if (AutoPlaceItemInInventorySlot(player, i, item, persistItem))
+			if (tryPlace(i))
 				return true;
 		}
 		return false;
@@ -693,30 +749,12 @@ bool AutoPlaceItemInInventory(PlayerStruct &player, const ItemStruct &item, bool
  */
 bool AutoPlaceItemInInventorySlot(PlayerStruct &player, int slotIndex, const ItemStruct &item, bool persistItem)
 {
-	int yy = (slotIndex > 0) ? (10 * (slotIndex / 10)) : 0;
-
 	Size itemSize = GetInventorySize(item);
-	for (int j = 0; j < itemSize.height; j++) {
-		if (yy >= NUM_INV_GRID_ELEM) {
-			return false;
-		}
-		int xx = (slotIndex > 0) ? (slotIndex % 10) : 0;
-		for (int i = 0; i < itemSize.width; i++) {
-			if (xx >= 10 || player.InvGrid[xx + yy] != 0) {
-				return false;
-			}
-			xx++;
-		}
-		yy += 10;
-	}
-
-	if (persistItem) {
-		player.InvList[player._pNumInv] = player.HoldItem;
-		player._pNumInv++;
+	if (!ItemFitsInSlot(GetInventoryOccupancy(player), GetItemShapeMask(itemSize), itemSize, slotIndex))
+		return false;
 
-		AddItemToInvGrid(player, slotIndex, player._pNumInv, itemSize);
-		player.CalcScrolls();
-	}
+	if (persistItem)
+		PlaceHoldItemInSlot(player, slotIndex, itemSize);
 
 	return true;
 }
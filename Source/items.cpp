@@ -4,9 +4,14 @@
  * Implementation of item functionality.
  */
 #include <algorithm>
+#include <array>
 #include <climits>
 #include <cstdint>
 #include <bitset>
+#include <map>
+#include <numeric>
+#include <tuple>
+#include <vector>
 
 #include <fmt/format.h>
 
@@ -20,6 +25,7 @@
 #include "missiles.h"
 #include "options.h"
 #include "stores.h"
+#include "utils/file_prefetch.h"
 #include "utils/language.h"
 #include "utils/math.h"
 
@@ -27,6 +33,48 @@ namespace devilution {
 namespace {
 std::optional<CelSprite> itemanims[ITEMTYPES];
 
+/**
+ * @brief Candidate lists of an item or affix generator, keyed by the generator's arguments.
+ *
+ * The lists only depend on those arguments and the game mode, so each one is built once by the
+ * generator's own loop instead of scanning AllItemsList or the affix tables for every spawned item.
+ * The draws from a list consume the same random numbers as before.
+ */
+class ItemCandidateCache {
+public:
+	using Key = std::tuple<int, int, int, int>;
+
+	template <typename BuildFn>
+	const std::vector<int> &Get(Key key, BuildFn build)
+	{
+		const std::array<bool, 4> gameMode { gbIsHellfire, gbIsSpawn, gbIsMultiplayer, sgOptions.Gameplay.bTestBard };
+		if (gameMode != gameMode_) {
+			lists_.clear();
+			gameMode_ = gameMode;
+		}
+
+		auto it = lists_.find(key);
+		if (it == lists_.end()) {
+			std::vector<int> list;
+			build(list);
+			it = lists_.emplace(key, std::move(list)).first;
+		}
+		return it->second;
+	}
+
+private:
+	std::array<bool, 4> gameMode_ {};
+	std::map<Key, std::vector<int>> lists_;
+};
+
+int RndCandidate(const std::vector<int> &candidates)
+{
+	return candidates[GenerateRnd(static_cast<int32_t>(candidates.size()))];
+}
+
+ItemCandidateCache prefixCandidates;
+ItemCandidateCache suffixCandidates;
+
 } // namespace
 
 enum anim_armor_id : uint8_t {
@@ -48,6 +96,7 @@ bool itemhold[3][3];
 CornerStoneStruct CornerStone;
 bool UniqueItemFlags[128];
 int numitems;
+bool ItemAnimationPending;
 int gnNumGetRecords;
 
 /* data */
@@ -416,15 +465,33 @@ int items_get_currlevel()
 	return lvl;
 }
 
-void InitItemGFX()
+/**
+ * @brief Calls fn with the index and file name of every item drop animation of the game
+ */
+template <typename F>
+static void ForEachItemGFXFile(F &&fn)
 {
 	char arglist[64];
 
 	int itemTypes = gbIsHellfire ? ITEMTYPES : 35;
 	for (int i = 0; i < itemTypes; i++) {
 		sprintf(arglist, "Items\\%s.CEL", ItemDropNames[i]);
-		itemanims[i] = LoadCel(arglist, ItemAnimWidth);
+		fn(i, arglist);
 	}
+}
+
+void PrefetchItemGFX()
+{
+	ForEachItemGFXFile([](int /*i*/, const char *path) {
+		PrefetchFile(path);
+	});
+}
+
+void InitItemGFX()
+{
+	ForEachItemGFXFile([](int i, const char *path) {
+		itemanims[i] = LoadCel(path, ItemAnimWidth);
+	});
 	memset(UniqueItemFlags, 0, sizeof(UniqueItemFlags));
 }
 
@@ -515,6 +582,7 @@ void InitItems()
 	golditem = items[0];
 	golditem._iStatFlag = true;
 	numitems = 0;
+	ItemAnimationPending = true;
 
 	for (i = 0; i < MAXITEMS; i++) {
 		items[i]._itype = ITYPE_NONE;
@@ -549,6 +617,94 @@ void InitItems()
 	uitemflag = false;
 }
 
+namespace {
+
+bool IsSameItem(const ItemStatContribution &stats, const ItemStruct &item)
+{
+	return stats.isValid
+	    && stats.seed == item._iSeed
+	    && stats.createInfo == item._iCreateInfo
+	    && stats.idx == item.IDidx
+	    && stats.type == item._itype
+	    && stats.identified == item._iIdentified
+	    && stats.statFlag == item._iStatFlag;
+}
+
+void CalcItemStats(ItemStatContribution &stats, const ItemStruct &item)
+{
+	stats = {};
+	stats.isValid = true;
+	stats.seed = item._iSeed;
+	stats.createInfo = item._iCreateInfo;
+	stats.idx = item.IDidx;
+	stats.type = item._itype;
+	stats.identified = item._iIdentified;
+	stats.statFlag = item._iStatFlag;
+
+	if (item.isEmpty() || !item._iStatFlag)
+		return;
+
+	stats.minDam = item._iMinDam;
+	stats.maxDam = item._iMaxDam;
+	stats.ac = item._iAC;
+
+	if (item._iSpell != SPL_NULL) {
+		stats.spells = GetSpellBitmask(item._iSpell);
+	}
+
+	if (item._iMagical == ITEM_QUALITY_NORMAL || item._iIdentified) {
+		stats.bonusDam = item._iPLDam;
+		stats.bonusToHit = item._iPLToHit;
+		if (item._iPLAC) {
+			int tmpac = item._iAC;
+			tmpac *= item._iPLAC;
+			tmpac /= 100;
+			if (tmpac == 0)
+				tmpac = math::Sign(item._iPLAC);
+			stats.bonusAC = tmpac;
+		}
+		stats.flags = item._iFlags;
+		stats.damAcFlags = item._iDamAcFlags;
+		stats.strength = item._iPLStr;
+		stats.magic = item._iPLMag;
+		stats.dexterity = item._iPLDex;
+		stats.vitality = item._iPLVit;
+		stats.fireResist = item._iPLFR;
+		stats.lightningResist = item._iPLLR;
+		stats.magicResist = item._iPLMR;
+		stats.damageMod = item._iPLDamMod;
+		stats.getHit = item._iPLGetHit;
+		stats.lightRadius = item._iPLLight;
+		stats.hitPoints = item._iPLHP;
+		stats.mana = item._iPLMana;
+		stats.spellLevelAdd = item._iSplLvlAdd;
+		stats.enhancedAC = item._iPLEnAc;
+		stats.fireMinDam = item._iFMinDam;
+		stats.fireMaxDam = item._iFMaxDam;
+		stats.lightningMinDam = item._iLMinDam;
+		stats.lightningMaxDam = item._iLMaxDam;
+	}
+}
+
+} // namespace
+
+/**
+ * @brief Makes CalcPlrItemVals evaluate an equipped item again.
+ *
+ * Swapping, identifying or breaking an item is noticed by itself, this is only needed when the stats
+ * of an equipped item are changed in place (shrines, oils, durability loss of the item's bonus).
+ */
+void InvalidateItemStats(PlayerStruct &player, int bodyLocation)
+{
+	player.InvBodyStats[bodyLocation].isValid = false;
+}
+
+void InvalidateItemStats(PlayerStruct &player)
+{
+	for (auto &stats : player.InvBodyStats)
+		stats.isValid = false;
+}
+
 void CalcPlrItemVals(int playerId, bool Loadgfx)
 {
 	auto &player = plr[playerId];
@@ -558,7 +714,6 @@ void CalcPlrItemVals(int playerId, bool Loadgfx)
 	int tac = 0;  // accuracy
 
 	int g;
-	int i;
 
 	int bdam = 0;   // bonus damage
 	int btohit = 0; // bonus chance to hit
@@ -595,51 +750,38 @@ void CalcPlrItemVals(int playerId, bool Loadgfx)
 	int lmin = 0; // minimum lightning damage
 	int lmax = 0; // maximum lightning damage
 
-	for (i = 0; i < NUM_INVLOC; i++) {
-		ItemStruct *itm = &player.InvBody[i];
-		if (!itm->isEmpty() && itm->_iStatFlag) {
-
-			mind += itm->_iMinDam;
-			maxd += itm->_iMaxDam;
-			tac += itm->_iAC;
-
-			if (itm->_iSpell != SPL_NULL) {
-				spl |= GetSpellBitmask(itm->_iSpell);
-			}
-
-			if (itm->_iMagical == ITEM_QUALITY_NORMAL || itm->_iIdentified) {
-				bdam += itm->_iPLDam;
-				btohit += itm->_iPLToHit;
-				if (itm->_iPLAC) {
-					int tmpac = itm->_iAC;
-					tmpac *= itm->_iPLAC;
-					tmpac /= 100;
-					if (tmpac == 0)
-						tmpac = math::Sign(itm->_iPLAC);
-					bac += tmpac;
-				}
-				iflgs |= itm->_iFlags;
-				pDamAcFlags |= itm->_iDamAcFlags;
-				sadd += itm->_iPLStr;
-				madd += itm->_iPLMag;
-				dadd += itm->_iPLDex;
-				vadd += itm->_iPLVit;
-				fr += itm->_iPLFR;
-				lr += itm->_iPLLR;
-				mr += itm->_iPLMR;
-				dmod += itm->_iPLDamMod;
-				ghit += itm->_iPLGetHit;
-				lrad += itm->_iPLLight;
-				ihp += itm->_iPLHP;
-				imana += itm->_iPLMana;
-				spllvladd += itm->_iSplLvlAdd;
-				enac += itm->_iPLEnAc;
-				fmin += itm->_iFMinDam;
-				fmax += itm->_iFMaxDam;
-				lmin += itm->_iLMinDam;
-				lmax += itm->_iLMaxDam;
-			}
-		}
+	for (int i = 0; i < NUM_INVLOC; i++) {
+		ItemStatContribution &stats = player.InvBodyStats[i];
+		if (!IsSameItem(stats, player.InvBody[i]))
+			CalcItemStats(stats, player.InvBody[i]);
+
+		mind += stats.minDam;
+		maxd += stats.maxDam;
+		tac += stats.ac;
+		spl |= stats.spells;
+		bdam += stats.bonusDam;
+		btohit += stats.bonusToHit;
+		bac += stats.bonusAC;
+		iflgs |= stats.flags;
+		pDamAcFlags |= stats.damAcFlags;
+		sadd += stats.strength;
+		madd += stats.magic;
+		dadd += stats.dexterity;
+		vadd += stats.vitality;
+		fr += stats.fireResist;
+		lr += stats.lightningResist;
+		mr += stats.magicResist;
+		dmod += stats.damageMod;
+		ghit += stats.getHit;
+		lrad += stats.lightRadius;
+		ihp += stats.hitPoints;
+		imana += stats.mana;
+		spllvladd += stats.spellLevelAdd;
+		enac += stats.enhancedAC;
+		fmin += stats.fireMinDam;
+		fmax += stats.fireMaxDam;
+		lmin += stats.lightningMinDam;
+		lmax += stats.lightningMaxDam;
 	}
 
 	if (mind == 0 && maxd == 0) {
@@ -889,16 +1031,19 @@ void CalcPlrItemVals(int playerId, bool Loadgfx)
 	}
 
 	if (player._pgfxnum != g && Loadgfx) {
-		player._pgfxnum = g;
-		ResetPlayerGFX(player);
+		ChangePlayerGFX(player, g);
 		SetPlrAnims(player);
 		if (player._pmode == PM_STAND) {
-			LoadPlrGFX(player, player_graphic::Stand);
+			if (player.AnimationData[static_cast<size_t>(player_graphic::Stand)].RawData == nullptr)
+				LoadPlrGFX(player, player_graphic::Stand);
 			player.AnimInfo.ChangeAnimationData(&*player.AnimationData[static_cast<size_t>(player_graphic::Stand)].CelSpritesForDirections[player._pdir], player._pNFrames, 3);
 		} else {
-			LoadPlrGFX(player, player_graphic::Walk);
+			if (player.AnimationData[static_cast<size_t>(player_graphic::Walk)].RawData == nullptr)
+				LoadPlrGFX(player, player_graphic::Walk);
 			player.AnimInfo.ChangeAnimationData(&*player.AnimationData[static_cast<size_t>(player_graphic::Walk)].CelSpritesForDirections[player._pdir], player._pWFrames, 0);
 		}
+		// The other sheets are loaded as they get used, have them in memory by then
+		PrefetchPlayerGFX(player);
 	} else {
 		player._pgfxnum = g;
 	}
@@ -1158,6 +1303,7 @@ void CreatePlrItems(int playerId)
 	for (auto &item : player.InvBody) {
 		item._itype = ITYPE_NONE;
 	}
+	InvalidateItemStats(player);
 
 	// converting this to a for loop creates a `rep stosd` instruction,
 	// so this probably actually was a memset
@@ -1383,41 +1529,38 @@ int AllocateItem()
 	return inum;
 }
 
-static void GetSuperItemSpace(Point position, int8_t inum)
+std::optional<Point> FindItemSpaceAround(Point position, int firstRadius)
 {
-	Point positionToCheck = position;
-	if (GetItemSpace(positionToCheck, inum))
-		return;
-	for (int k = 2; k < 50; k++) {
+	for (int k = firstRadius; k < 50; k++) {
 		for (int j = -k; j <= k; j++) {
-			for (int i = -k; i <= k; i++) {
-				Point offset = { i, j };
-				positionToCheck = position + offset;
-				if (!ItemSpaceOk(positionToCheck))
-					continue;
-				items[inum].position = positionToCheck;
-				dItem[positionToCheck.x][positionToCheck.y] = inum + 1;
-				return;
+			// Every cell inside the previous square was already found to be taken, so only its border is left
+			const int step = (k == firstRadius || j == -k || j == k) ? 1 : 2 * k;
+			for (int i = -k; i <= k; i += step) {
+				Point positionToCheck = position + Point { i, j };
+				if (ItemSpaceOk(positionToCheck))
+					return positionToCheck;
 			}
 		}
 	}
+
+	return {};
 }
 
-Point GetSuperItemLoc(Point position)
+static void GetSuperItemSpace(Point position, int8_t inum)
 {
-	for (int k = 1; k < 50; k++) {
-		for (int j = -k; j <= k; j++) {
-			for (int i = -k; i <= k; i++) {
-				Point offset = { i, j };
-				Point positionToCheck = position + offset;
-				if (ItemSpaceOk(positionToCheck)) {
-					return positionToCheck;
-				}
-			}
-		}
-	}
+	if (GetItemSpace(position, inum))
+		return;
+	// GetItemSpace found the 3x3 square around the position taken
+	std::optional<Point> positionToCheck = FindItemSpaceAround(position, 2);
+	if (!positionToCheck)
+		return;
+	items[inum].position = *positionToCheck;
+	dItem[positionToCheck->x][positionToCheck->y] = inum + 1;
+}
 
-	return { 0, 0 }; // TODO handle no space for dropping items
+Point GetSuperItemLoc(Point position)
+{
+	return FindItemSpaceAround(position, 1).value_or(Point { 0, 0 }); // TODO handle no space for dropping items
 }
 
 void CalcItemValue(int i)
@@ -2103,7 +2246,6 @@ static void SaveItemSuffix(int i, int sufidx)
 
 void GetItemPower(int i, int minlvl, int maxlvl, affix_item_type flgs, bool onlygood)
 {
-	int l[256];
 	char istr[128];
 	goodorevil goe;
 
@@ -2121,25 +2263,23 @@ void GetItemPower(int i, int minlvl, int maxlvl, affix_item_type flgs, bool only
 	if (!onlygood && GenerateRnd(3) != 0)
 		onlygood = true;
 	if (pre == 0) {
-		int nt = 0;
-		for (int j = 0; PL_Prefix[j].PLPower != IPL_INVALID; j++) {
-			if (!IsPrefixValidForItemType(j, flgs))
-				continue;
-			if (PL_Prefix[j].PLMinLvl < minlvl || PL_Prefix[j].PLMinLvl > maxlvl)
-				continue;
-			if (onlygood && !PL_Prefix[j].PLOk)
-				continue;
-			if (flgs == PLT_STAFF && PL_Prefix[j].PLPower == IPL_CHARGES)
-				continue;
-			l[nt] = j;
-			nt++;
-			if (PL_Prefix[j].PLDouble) {
-				l[nt] = j;
-				nt++;
+		const std::vector<int> &l = prefixCandidates.Get({ flgs, minlvl, maxlvl, onlygood ? 1 : 0 }, [&](std::vector<int> &list) {
+			for (int j = 0; PL_Prefix[j].PLPower != IPL_INVALID; j++) {
+				if (!IsPrefixValidForItemType(j, flgs))
+					continue;
+				if (PL_Prefix[j].PLMinLvl < minlvl || PL_Prefix[j].PLMinLvl > maxlvl)
+					continue;
+				if (onlygood && !PL_Prefix[j].PLOk)
+					continue;
+				if (flgs == PLT_STAFF && PL_Prefix[j].PLPower == IPL_CHARGES)
+					continue;
+				list.push_back(j);
+				if (PL_Prefix[j].PLDouble)
+					list.push_back(j);
 			}
-		}
-		if (nt != 0) {
-			preidx = l[GenerateRnd(nt)];
+		});
+		if (!l.empty()) {
+			preidx = RndCandidate(l);
 			sprintf(istr, "%s %s", _(PL_Prefix[preidx].PLName), items[i]._iIName);
 			strcpy(items[i]._iIName, istr);
 			items[i]._iMagical = ITEM_QUALITY_MAGIC;
@@ -2156,18 +2296,18 @@ void GetItemPower(int i, int minlvl, int maxlvl, affix_item_type flgs, bool only
 		}
 	}
 	if (post != 0) {
-		int nl = 0;
-		for (int j = 0; PL_Suffix[j].PLPower != IPL_INVALID; j++) {
-			if (IsSuffixValidForItemType(j, flgs)
-			    && PL_Suffix[j].PLMinLvl >= minlvl && PL_Suffix[j].PLMinLvl <= maxlvl
-			    && !((goe == GOE_GOOD && PL_Suffix[j].PLGOE == GOE_EVIL) || (goe == GOE_EVIL && PL_Suffix[j].PLGOE == GOE_GOOD))
-			    && (!onlygood || PL_Suffix[j].PLOk)) {
-				l[nl] = j;
-				nl++;
+		const std::vector<int> &l = suffixCandidates.Get({ flgs, minlvl, maxlvl, (onlygood ? 1 : 0) | (goe << 1) }, [&](std::vector<int> &list) {
+			for (int j = 0; PL_Suffix[j].PLPower != IPL_INVALID; j++) {
+				if (IsSuffixValidForItemType(j, flgs)
+				    && PL_Suffix[j].PLMinLvl >= minlvl && PL_Suffix[j].PLMinLvl <= maxlvl
+				    && !((goe == GOE_GOOD && PL_Suffix[j].PLGOE == GOE_EVIL) || (goe == GOE_EVIL && PL_Suffix[j].PLGOE == GOE_GOOD))
+				    && (!onlygood || PL_Suffix[j].PLOk)) {
+					list.push_back(j);
+				}
 			}
-		}
-		if (nl != 0) {
-			sufidx = l[GenerateRnd(nl)];
+		});
+		if (!l.empty()) {
+			sufidx = RndCandidate(l);
 			strcpy(istr, fmt::format(_("{:s} of {:s}"), items[i]._iIName, _(PL_Suffix[sufidx].PLName)).c_str());
 			strcpy(items[i]._iIName, istr);
 			items[i]._iMagical = ITEM_QUALITY_MAGIC;
@@ -2243,8 +2383,7 @@ void SetupItem(int i)
 
 int RndItem(int m)
 {
-	int i, ri, r;
-	int ril[512];
+	static ItemCandidateCache cache;
 
 	if ((monster[m].MData->mTreasure & 0x8000) != 0)
 		return -((monster[m].MData->mTreasure & 0xFFF) + 1);
@@ -2258,125 +2397,125 @@ int RndItem(int m)
 	if (GenerateRnd(100) > 25)
 		return IDI_GOLD + 1;
 
-	ri = 0;
-	for (i = 0; AllItemsList[i].iLoc != ILOC_INVALID; i++) {
-		if (!IsItemAvailable(i))
-			continue;
+	const int mLevel = monster[m].mLevel;
+	const std::vector<int> &candidates = cache.Get({ mLevel, 0, 0, 0 }, [mLevel](std::vector<int> &list) {
+		int ril[512];
+		int ri = 0;
+		for (int i = 0; AllItemsList[i].iLoc != ILOC_INVALID; i++) {
+			if (!IsItemAvailable(i))
+				continue;
 
-		if (AllItemsList[i].iRnd == IDROP_DOUBLE && monster[m].mLevel >= AllItemsList[i].iMinMLvl
-		    && ri < 512) {
-			ril[ri] = i;
-			ri++;
-		}
-		if (AllItemsList[i].iRnd != IDROP_NEVER && monster[m].mLevel >= AllItemsList[i].iMinMLvl
-		    && ri < 512) {
-			ril[ri] = i;
-			ri++;
+			if (AllItemsList[i].iRnd == IDROP_DOUBLE && mLevel >= AllItemsList[i].iMinMLvl
+			    && ri < 512) {
+				ril[ri] = i;
+				ri++;
+			}
+			if (AllItemsList[i].iRnd != IDROP_NEVER && mLevel >= AllItemsList[i].iMinMLvl
+			    && ri < 512) {
+				ril[ri] = i;
+				ri++;
+			}
+			if (AllItemsList[i].iSpell == SPL_RESURRECT && !gbIsMultiplayer)
+				ri--;
+			if (AllItemsList[i].iSpell == SPL_HEALOTHER && !gbIsMultiplayer)
+				ri--;
 		}
-		if (AllItemsList[i].iSpell == SPL_RESURRECT && !gbIsMultiplayer)
-			ri--;
-		if (AllItemsList[i].iSpell == SPL_HEALOTHER && !gbIsMultiplayer)
-			ri--;
-	}
+		list.assign(ril, ril + std::max(ri, 0));
+	});
 
-	r = GenerateRnd(ri);
-	return ril[r] + 1;
+	return RndCandidate(candidates) + 1;
 }
 
 int RndUItem(int m)
 {
-	int ril[512];
-	bool okflag;
+	static ItemCandidateCache cache;
 
 	if (m != -1 && (monster[m].MData->mTreasure & 0x8000) != 0 && !gbIsMultiplayer)
 		return -((monster[m].MData->mTreasure & 0xFFF) + 1);
 
-	int curlv = items_get_currlevel();
-	int ri = 0;
-	for (int i = 0; AllItemsList[i].iLoc != ILOC_INVALID; i++) {
-		if (!IsItemAvailable(i))
-			continue;
+	const int lvl = m != -1 ? monster[m].mLevel : 2 * items_get_currlevel();
+	const std::vector<int> &candidates = cache.Get({ lvl, 0, 0, 0 }, [lvl](std::vector<int> &list) {
+		for (int i = 0; AllItemsList[i].iLoc != ILOC_INVALID; i++) {
+			if (!IsItemAvailable(i))
+				continue;
 
-		okflag = true;
-		if (AllItemsList[i].iRnd == IDROP_NEVER)
-			okflag = false;
-		if (m != -1) {
-			if (monster[m].mLevel < AllItemsList[i].iMinMLvl)
+			bool okflag = true;
+			if (AllItemsList[i].iRnd == IDROP_NEVER)
 				okflag = false;
-		} else {
-			if (2 * curlv < AllItemsList[i].iMinMLvl)
+			if (lvl < AllItemsList[i].iMinMLvl)
 				okflag = false;
+			if (AllItemsList[i].itype == ITYPE_MISC)
+				okflag = false;
+			if (AllItemsList[i].itype == ITYPE_GOLD)
+				okflag = false;
+			if (AllItemsList[i].iMiscId == IMISC_BOOK)
+				okflag = true;
+			if (AllItemsList[i].iSpell == SPL_RESURRECT && !gbIsMultiplayer)
+				okflag = false;
+			if (AllItemsList[i].iSpell == SPL_HEALOTHER && !gbIsMultiplayer)
+				okflag = false;
+			if (okflag && list.size() < 512)
+				list.push_back(i);
 		}
-		if (AllItemsList[i].itype == ITYPE_MISC)
-			okflag = false;
-		if (AllItemsList[i].itype == ITYPE_GOLD)
-			okflag = false;
-		if (AllItemsList[i].iMiscId == IMISC_BOOK)
-			okflag = true;
-		if (AllItemsList[i].iSpell == SPL_RESURRECT && !gbIsMultiplayer)
-			okflag = false;
-		if (AllItemsList[i].iSpell == SPL_HEALOTHER && !gbIsMultiplayer)
-			okflag = false;
-		if (okflag && ri < 512) {
-			ril[ri] = i;
-			ri++;
-		}
-	}
+	});
 
-	return ril[GenerateRnd(ri)];
+	return RndCandidate(candidates);
 }
 
 int RndAllItems()
 {
-	int ril[512];
+	static ItemCandidateCache cache;
 
 	if (GenerateRnd(100) > 25)
 		return 0;
 
-	int curlv = items_get_currlevel();
-	int ri = 0;
-	for (int i = 0; AllItemsList[i].iLoc != ILOC_INVALID; i++) {
-		if (!IsItemAvailable(i))
-			continue;
+	const int curlv = items_get_currlevel();
+	const std::vector<int> &candidates = cache.Get({ curlv, 0, 0, 0 }, [curlv](std::vector<int> &list) {
+		int ril[512];
+		int ri = 0;
+		for (int i = 0; AllItemsList[i].iLoc != ILOC_INVALID; i++) {
+			if (!IsItemAvailable(i))
+				continue;
 
-		if (AllItemsList[i].iRnd != IDROP_NEVER && 2 * curlv >= AllItemsList[i].iMinMLvl && ri < 512) {
-			ril[ri] = i;
-			ri++;
+			if (AllItemsList[i].iRnd != IDROP_NEVER && 2 * curlv >= AllItemsList[i].iMinMLvl && ri < 512) {
+				ril[ri] = i;
+				ri++;
+			}
+			if (AllItemsList[i].iSpell == SPL_RESURRECT && !gbIsMultiplayer)
+				ri--;
+			if (AllItemsList[i].iSpell == SPL_HEALOTHER && !gbIsMultiplayer)
+				ri--;
 		}
-		if (AllItemsList[i].iSpell == SPL_RESURRECT && !gbIsMultiplayer)
-			ri--;
-		if (AllItemsList[i].iSpell == SPL_HEALOTHER && !gbIsMultiplayer)
-			ri--;
-	}
+		list.assign(ril, ril + std::max(ri, 0));
+	});
 
-	return ril[GenerateRnd(ri)];
+	return RndCandidate(candidates);
 }
 
 int RndTypeItems(int itype, int imid, int lvl)
 {
-	int ril[512];
+	static ItemCandidateCache cache;
 
-	int ri = 0;
-	for (int i = 0; AllItemsList[i].iLoc != ILOC_INVALID; i++) {
-		if (!IsItemAvailable(i))
-			continue;
+	const std::vector<int> &candidates = cache.Get({ itype, imid, lvl, 0 }, [=](std::vector<int> &list) {
+		for (int i = 0; AllItemsList[i].iLoc != ILOC_INVALID; i++) {
+			if (!IsItemAvailable(i))
+				continue;
 
-		bool okflag = true;
-		if (AllItemsList[i].iRnd == IDROP_NEVER)
-			okflag = false;
-		if (lvl * 2 < AllItemsList[i].iMinMLvl)
-			okflag = false;
-		if (AllItemsList[i].itype != itype)
-			okflag = false;
-		if (imid != -1 && AllItemsList[i].iMiscId != imid)
-			okflag = false;
-		if (okflag && ri < 512) {
-			ril[ri] = i;
-			ri++;
+			bool okflag = true;
+			if (AllItemsList[i].iRnd == IDROP_NEVER)
+				okflag = false;
+			if (lvl * 2 < AllItemsList[i].iMinMLvl)
+				okflag = false;
+			if (AllItemsList[i].itype != itype)
+				okflag = false;
+			if (imid != -1 && AllItemsList[i].iMiscId != imid)
+				okflag = false;
+			if (okflag && list.size() < 512)
+				list.push_back(i);
 		}
-	}
+	});
 
-	return ril[GenerateRnd(ri)];
+	return RndCandidate(candidates);
 }
 
 _unique_items CheckUnique(int i, int lvl, int uper, bool recreate)
@@ -2664,38 +2803,58 @@ void CreateTypeItem(Point position, bool onlygood, int itype, int imisc, bool se
 	SetupBaseItem(position, idx, onlygood, sendmsg, delta);
 }
 
-void RecreateItem(int ii, int idx, uint16_t icreateinfo, int iseed, int ivalue, bool isHellfire)
-{
-	bool _gbIsHellfire = gbIsHellfire;
-	gbIsHellfire = isHellfire;
+namespace {
 
-	if (idx == IDI_GOLD) {
-		SetPlrHandItem(&items[ii], IDI_GOLD);
-		items[ii]._iSeed = iseed;
-		items[ii]._iCreateInfo = icreateinfo;
-		items[ii]._ivalue = ivalue;
-		SetPlrHandGoldCurs(&items[ii]);
-		gbIsHellfire = _gbIsHellfire;
-		return;
-	}
+/** An item rebuilt by RecreateItem and the RNG state the generator left behind */
+struct RecreatedItem {
+	ItemStruct item;
+	uint32_t rngState;
+};
 
-	if (icreateinfo == 0) {
-		SetPlrHandItem(&items[ii], idx);
-		SetPlrHandSeed(&items[ii], iseed);
-		gbIsHellfire = _gbIsHellfire;
-		return;
+/**
+ * @brief Items rebuilt by RecreateItem, keyed by index, creation info, seed and Hellfire flag.
+ *
+ * Only items rebuilt into a cleared slot are kept, as the generators leave the fields they don't set
+ * untouched.
+ */
+std::map<std::tuple<int, uint16_t, int, bool>, RecreatedItem> recreatedItems;
+std::array<bool, 3> recreatedItemsGameMode;
+constexpr size_t MaxRecreatedItems = 4096;
+
+bool IsClearedItem(const ItemStruct &item)
+{
+	const auto *bytes = reinterpret_cast<const uint8_t *>(&item);
+	return std::all_of(bytes, bytes + sizeof(item), [](uint8_t b) { return b == 0; });
+}
+
+/**
+ * @brief Checks whether the generator's result only depends on the arguments of RecreateItem and the game mode.
+ */
+bool CanReuseRecreatedItem(int idx, uint16_t icreateinfo)
+{
+	if ((icreateinfo & CF_UNIQUE) == 0 && (icreateinfo & CF_TOWN) != 0) {
+		// Adria's fixed items don't reseed the RNG, so the state they leave behind isn't known
+		if ((icreateinfo & (CF_SMITH | CF_SMITHPREMIUM | CF_BOY)) == 0 && (idx == IDI_MANA || idx == IDI_FULLMANA || idx == IDI_PORTAL))
+			return false;
+		// Pepin's elixirs depend on the player's stats
+		return (icreateinfo & (CF_SMITH | CF_SMITHPREMIUM | CF_BOY | CF_WITCH)) != 0;
 	}
+	if ((icreateinfo & CF_UNIQUE) == 0 && (icreateinfo & CF_USEFUL) == CF_USEFUL)
+		return true;
+	// Otherwise CheckUnique skips the uniques that already dropped in single player
+	return (icreateinfo & CF_UNIQUE) != 0 || gbIsMultiplayer;
+}
 
+void RecreateGeneratedItem(int ii, int idx, uint16_t icreateinfo, int iseed)
+{
 	if ((icreateinfo & CF_UNIQUE) == 0) {
 		if ((icreateinfo & CF_TOWN) != 0) {
 			RecreateTownItem(ii, idx, icreateinfo, iseed);
-			gbIsHellfire = _gbIsHellfire;
 			return;
 		}
 
 		if ((icreateinfo & CF_USEFUL) == CF_USEFUL) {
 			SetupAllUseful(ii, iseed, icreateinfo & CF_LEVEL);
-			gbIsHellfire = _gbIsHellfire;
 			return;
 		}
 	}
@@ -2713,6 +2872,70 @@ void RecreateItem(int ii, int idx, uint16_t icreateinfo, int iseed, int ivalue,
 	bool pregen = (icreateinfo & CF_PREGEN) != 0;
 
 	SetupAllItems(ii, idx, iseed, level, uper, onlygood, recreate, pregen);
+}
+
+/**
+ * @brief Puts a kept item in the slot, with the side effects its generator would have had.
+ */
+void ReuseRecreatedItem(int ii, uint16_t icreateinfo, const RecreatedItem &recreated)
+{
+	items[ii] = recreated.item;
+	SetRndSeed(static_cast<int32_t>(recreated.rngState));
+	if (items[ii]._iMagical == ITEM_QUALITY_UNIQUE)
+		UniqueItemFlags[items[ii]._iUid] = true;
+	// The dungeon generators finish with SetupItem, which depends on how the level is entered
+	if ((icreateinfo & CF_UNIQUE) != 0 || (icreateinfo & CF_TOWN) == 0)
+		SetupItem(ii);
+}
+
+} // namespace
+
+void RecreateItem(int ii, int idx, uint16_t icreateinfo, int iseed, int ivalue, bool isHellfire)
+{
+	bool _gbIsHellfire = gbIsHellfire;
+	gbIsHellfire = isHellfire;
+
+	if (idx == IDI_GOLD) {
+		SetPlrHandItem(&items[ii], IDI_GOLD);
+		items[ii]._iSeed = iseed;
+		items[ii]._iCreateInfo = icreateinfo;
+		items[ii]._ivalue = ivalue;
+		SetPlrHandGoldCurs(&items[ii]);
+		gbIsHellfire = _gbIsHellfire;
+		return;
+	}
+
+	if (icreateinfo == 0) {
+		SetPlrHandItem(&items[ii], idx);
+		SetPlrHandSeed(&items[ii], iseed);
+		gbIsHellfire = _gbIsHellfire;
+		return;
+	}
+
+	const std::array<bool, 3> gameMode { gbIsSpawn, gbIsMultiplayer, sgOptions.Gameplay.bTestBard };
+	if (gameMode != recreatedItemsGameMode) {
+		recreatedItems.clear();
+		recreatedItemsGameMode = gameMode;
+	}
+
+	const auto key = std::make_tuple(idx, icreateinfo, iseed, isHellfire);
+	const bool reusable = CanReuseRecreatedItem(idx, icreateinfo) && IsClearedItem(items[ii]);
+	if (reusable) {
+		auto it = recreatedItems.find(key);
+		if (it != recreatedItems.end()) {
+			ReuseRecreatedItem(ii, icreateinfo, it->second);
+			gbIsHellfire = _gbIsHellfire;
+			return;
+		}
+	}
+
+	RecreateGeneratedItem(ii, idx, icreateinfo, iseed);
+
+	if (reusable) {
+		if (recreatedItems.size() >= MaxRecreatedItems)
+			recreatedItems.clear();
+		recreatedItems.emplace(key, RecreatedItem { items[ii], GetLCGEngineState() });
+	}
 	gbIsHellfire = _gbIsHellfire;
 }
 
@@ -2961,10 +3184,20 @@ void ItemDoppel()
 
 void ProcessItems()
 {
+	// Items also start animating when they are copied into place, so a new item means another look
+	static int lastNumItems;
+	if (!ItemAnimationPending && numitems == lastNumItems) {
+		ItemDoppel();
+		return;
+	}
+	lastNumItems = numitems;
+
+	bool animating = false;
 	for (int i = 0; i < numitems; i++) {
 		int ii = itemactive[i];
 		if (!items[ii]._iAnimFlag)
 			continue;
+		animating = true;
 		items[ii].AnimInfo.ProcessAnimation();
 		if (items[ii]._iCurs == ICURS_MAGIC_ROCK) {
 			if (items[ii]._iSelFlag == 1 && items[ii].AnimInfo.CurrentFrame == 11)
@@ -2982,6 +3215,7 @@ void ProcessItems()
 			}
 		}
 	}
+	ItemAnimationPending = animating;
 	ItemDoppel();
 }
 
@@ -3226,6 +3460,8 @@ void DoOil(int pnum, int cii)
 	auto &player = plr[pnum];
 	if (!OilItem(&player.InvBody[cii], player))
 		return;
+	if (cii < NUM_INVLOC)
+		InvalidateItemStats(player, cii);
 	CalcPlrInv(pnum, true);
 	if (pnum == myplr) {
 		NewCursor(CURSOR_HAND);
@@ -4124,11 +4360,8 @@ bool SmithItemOk(int i)
 }
 
 template <bool (*Ok)(int), bool ConsiderDropRate = false>
-int RndVendorItem(int minlvl, int maxlvl)
+void GetVendorItemCandidates(int minlvl, int maxlvl, std::vector<int> &list)
 {
-	int ril[512];
-
-	int ri = 0;
 	for (int i = 1; AllItemsList[i].iLoc != ILOC_INVALID; i++) {
 		if (!IsItemAvailable(i))
 			continue;
@@ -4139,21 +4372,36 @@ int RndVendorItem(int minlvl, int maxlvl)
 		if (AllItemsList[i].iMinMLvl < minlvl || AllItemsList[i].iMinMLvl > maxlvl)
 			continue;
 
-		ril[ri] = i;
-		ri++;
-		if (ri == 512)
+		list.push_back(i);
+		if (list.size() == 512)
 			break;
 
 		if (!ConsiderDropRate || AllItemsList[i].iRnd != IDROP_DOUBLE)
 			continue;
 
-		ril[ri] = i;
-		ri++;
-		if (ri == 512)
+		list.push_back(i);
+		if (list.size() == 512)
 			break;
 	}
+}
 
-	return ril[GenerateRnd(ri)] + 1;
+/**
+ * @tparam Ok Filter of the vendor, only depending on the game mode unless Cached is false
+ */
+template <bool (*Ok)(int), bool ConsiderDropRate = false, bool Cached = true>
+int RndVendorItem(int minlvl, int maxlvl)
+{
+	if (!Cached) {
+		std::vector<int> candidates;
+		GetVendorItemCandidates<Ok, ConsiderDropRate>(minlvl, maxlvl, candidates);
+		return RndCandidate(candidates) + 1;
+	}
+
+	static ItemCandidateCache cache;
+	const std::vector<int> &candidates = cache.Get({ minlvl, maxlvl, 0, 0 }, [=](std::vector<int> &list) {
+		GetVendorItemCandidates<Ok, ConsiderDropRate>(minlvl, maxlvl, list);
+	});
+	return RndCandidate(candidates) + 1;
 }
 
 int RndSmithItem(int lvl)
@@ -4167,11 +4415,29 @@ void SortVendor(ItemStruct *items)
 	while (!items[count].isEmpty())
 		count++;
 
-	auto cmp = [](const ItemStruct &a, const ItemStruct &b) {
-		return a.IDidx < b.IDidx;
-	};
-
-	std::sort(items, items + count, cmp);
+	// Sort indices and then move every item once, rather than swapping whole items while sorting
+	std::array<uint8_t, std::max(SMITH_ITEMS, WITCH_ITEMS)> order;
+	assert(count <= static_cast<int>(order.size()));
+	std::iota(order.begin(), order.begin() + count, 0);
+	std::stable_sort(order.begin(), order.begin() + count, [items](uint8_t a, uint8_t b) {
+		return items[a].IDidx < items[b].IDidx;
+	});
+
+	// Apply the permutation one cycle at a time
+	for (int i = 0; i < count; i++) {
+		if (order[i] == i)
+			continue;
+		ItemStruct item = std::move(items[i]);
+		int j = i;
+		while (order[j] != i) {
+			int next = order[j];
+			items[j] = std::move(items[next]);
+			order[j] = j;
+			j = next;
+		}
+		items[j] = std::move(item);
+		order[j] = j;
+	}
 }
 
 void SpawnSmith(int lvl)
@@ -4640,7 +4906,8 @@ bool HealerItemOk(int i)
 
 int RndHealerItem(int lvl)
 {
-	return RndVendorItem<HealerItemOk>(0, lvl);
+	// The elixirs on offer depend on the player's stats
+	return RndVendorItem<HealerItemOk, false, false>(0, lvl);
 }
 
 void SpawnHealer(int lvl)
@@ -4972,6 +5239,7 @@ void ItemStruct::SetNewAnimation(bool showAnimation)
 	_iRequest = false;
 	if (showAnimation) {
 		_iAnimFlag = true;
+		ItemAnimationPending = true;
 		_iSelFlag = 0;
 	} else {
 		AnimInfo.CurrentFrame = AnimInfo.NumberOfFrames;
@@ -379,6 +379,53 @@ struct ItemStruct {
 	void SetNewAnimation(bool showAnimation);
 };
 
+/**
+ * @brief The stats an equipped item adds to the player, summed up by CalcPlrItemVals.
+ *
+ * Kept per body slot so only the slots whose item changed are evaluated again.
+ */
+struct ItemStatContribution {
+	/** Cleared by InvalidateItemStats when an equipped item is changed in place */
+	bool isValid;
+	/** The item these stats were taken from */
+	int32_t seed;
+	uint16_t createInfo;
+	_item_indexes idx;
+	item_type type;
+	bool identified;
+	bool statFlag;
+
+	int minDam;
+	int maxDam;
+	int ac;
+	uint64_t spells;
+	int bonusDam;
+	int bonusToHit;
+	int bonusAC;
+	uint32_t flags;
+	uint32_t damAcFlags;
+	int strength;
+	int magic;
+	int dexterity;
+	int vitality;
+	int fireResist;
+	int lightningResist;
+	int magicResist;
+	int damageMod;
+	int getHit;
+	int lightRadius;
+	int hitPoints;
+	int mana;
+	int spellLevelAdd;
+	int enhancedAC;
+	int fireMinDam;
+	int fireMaxDam;
+	int lightningMinDam;
+	int lightningMaxDam;
+};
+
+struct PlayerStruct;
+
 struct ItemGetRecordStruct {
 	int32_t nSeed;
 	uint16_t wCI;
@@ -399,12 +446,18 @@ extern ItemStruct items[MAXITEMS + 1];
 extern CornerStoneStruct CornerStone;
 extern bool UniqueItemFlags[128];
 extern int numitems;
+/** Set when an item may have started its drop animation, ProcessItems only looks for animating items while it's set */
+extern bool ItemAnimationPending;
 
 BYTE GetOutlineColor(const ItemStruct &item, bool checkReq);
 bool IsItemAvailable(int i);
 bool IsUniqueAvailable(int i);
+/** @brief Queue the item graphics on the prefetch thread, ahead of InitItemGFX */
+void PrefetchItemGFX();
 void InitItemGFX();
 void InitItems();
+void InvalidateItemStats(PlayerStruct &player, int bodyLocation);
+void InvalidateItemStats(PlayerStruct &player);
 void CalcPlrItemVals(int p, bool Loadgfx);
 void CalcPlrStaff(int p);
 void CalcPlrInv(int p, bool Loadgfx);
@@ -416,6 +469,13 @@ void SetPlrHandGoldCurs(ItemStruct *h);
 void CreatePlrItems(int playerId);
 bool ItemSpaceOk(Point position);
 int AllocateItem();
+/**
+ * @brief Finds the first cell an item can be dropped on in the smallest square around the position that has one.
+ * @param position Center of the squares
+ * @param firstRadius Radius of the first square searched, all cells of smaller squares have to be taken
+ * @return The first free cell in reading order of the square, or nothing when there is none within 49 cells
+ */
+std::optional<Point> FindItemSpaceAround(Point position, int firstRadius);
 Point GetSuperItemLoc(Point position);
 void GetItemAttrs(int i, int idata, int lvl);
 void SaveItemPower(int i, item_effect_type power, int param1, int param2, int minval, int maxval, int multval);
@@ -0,0 +1,293 @@
+/**
+ * @file levelcache.cpp
+ *
+ * Implementation of the cache of generated dungeon layouts.
+ *
+ * Generating a level only depends on its seed and the state of the game that is part of the key,
+ * so the layout of a level that is entered again can be copied instead of generated.
+ */
+#include "levelcache.h"
+
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+#include "drlg_l1.h"
+#include "drlg_l4.h"
+#include "init.h"
+#include "items.h"
+#include "lighting.h"
+#include "multi.h"
+#include "quests.h"
+#include "utils/log.hpp"
+#include "utils/stdcompat/optional.hpp"
+
+namespace devilution {
+
+namespace {
+
+struct GeneratedLevelKey {
+	uint32_t seed;
+	uint8_t level;
+	dungeon_type levelType;
+	lvl_entry entry;
+	bool isHellfire;
+	bool isSpawn;
+	bool isMultiplayer;
+	bool lightflag;
+	/** Hash of the quest states, which decide the set pieces of a level */
+	uint32_t quests;
+
+	bool operator==(const GeneratedLevelKey &other) const
+	{
+		return seed == other.seed && level == other.level && levelType == other.levelType && entry == other.entry
+		    && isHellfire == other.isHellfire && isSpawn == other.isSpawn && isMultiplayer == other.isMultiplayer && lightflag == other.lightflag
+		    && quests == other.quests;
+	}
+};
+
+/**
+ * @brief Everything the level generation writes that the rest of the level loading reads
+ */
+struct GeneratedLevel {
+	GeneratedLevelKey key;
+
+	uint8_t dungeon[DMAXX][DMAXY];
+	uint8_t pdungeon[DMAXX][DMAXY];
+	char dflags[DMAXX][DMAXY];
+	int dPiece[MAXDUNX][MAXDUNY];
+	int8_t dTransVal[MAXDUNX][MAXDUNY];
+	char dLight[MAXDUNX][MAXDUNY];
+	int8_t dFlags[MAXDUNX][MAXDUNY];
+	char dSpecial[MAXDUNX][MAXDUNY];
+	bool transList[256];
+	char transVal;
+	int themeCount;
+	THEME_LOC themeLoc[MAXTHEMES];
+	int setpcX;
+	int setpcY;
+	int setpcW;
+	int setpcH;
+	bool setloadflag;
+	int dminx;
+	int dminy;
+	int dmaxx;
+	int dmaxy;
+	int viewX;
+	int viewY;
+	int lvlViewX;
+	int lvlViewY;
+	/** The generation leaves the RNG in a state that the level loading continues with */
+	uint32_t rngState;
+
+	/** Cathedral and crypt */
+	int uberRow;
+	int uberCol;
+	/** Hell */
+	int diabquads[8];
+
+	/** Positions that are only written by some layouts */
+	std::optional<Point> poisonWaterPosition;
+	std::optional<Point> betrayerPosition;
+	std::optional<Point> cornerStonePosition;
+
+	/** FNV-1a of the layout, to catch entries that don't match what was stored */
+	uint32_t hash;
+};
+
+/** Least recently used entries first */
+std::vector<std::unique_ptr<GeneratedLevel>> GeneratedLevels;
+constexpr std::size_t MaxGeneratedLevels = 8;
+
+Point PoisonWaterPositionBefore;
+Point BetrayerPositionBefore;
+Point CornerStonePositionBefore;
+
+void AddToHash(uint32_t &hash, const void *data, std::size_t size)
+{
+	const auto *bytes = static_cast<const uint8_t *>(data);
+	for (std::size_t i = 0; i < size; i++)
+		hash = (hash ^ bytes[i]) * 16777619U;
+}
+
+uint32_t HashLayout(const GeneratedLevel &level)
+{
+	uint32_t hash = 2166136261U;
+	AddToHash(hash, level.dungeon, sizeof(level.dungeon));
+	AddToHash(hash, level.dPiece, sizeof(level.dPiece));
+	AddToHash(hash, level.dTransVal, sizeof(level.dTransVal));
+	AddToHash(hash, level.dFlags, sizeof(level.dFlags));
+	return hash;
+}
+
+GeneratedLevelKey GetKey(uint32_t seed, lvl_entry entry)
+{
+	GeneratedLevelKey key;
+	key.seed = seed;
+	key.level = currlevel;
+	key.levelType = leveltype;
+	key.entry = entry;
+	key.isHellfire = gbIsHellfire;
+	key.isSpawn = gbIsSpawn;
+	key.isMultiplayer = gbIsMultiplayer;
+	key.lightflag = lightflag;
+	key.quests = 2166136261U;
+	for (const auto &quest : quests) {
+		AddToHash(key.quests, &quest._qlevel, sizeof(quest._qlevel));
+		AddToHash(key.quests, &quest._qactive, sizeof(quest._qactive));
+	}
+	return key;
+}
+
+std::optional<Point> GetWrittenPosition(Point before, Point after)
+{
+	if (before == after)
+		return {};
+	return after;
+}
+
+} // namespace
+
+bool RestoreGeneratedLevel(uint32_t seed, lvl_entry entry)
+{
+	// The lighting isn't reset before generating the level of a loaded game
+	if (entry == ENTRY_LOAD)
+		return false;
+
+	const GeneratedLevelKey key = GetKey(seed, entry);
+	auto it = std::find_if(GeneratedLevels.begin(), GeneratedLevels.end(), [&key](const std::unique_ptr<GeneratedLevel> &level) {
+		return level->key == key;
+	});
+	if (it == GeneratedLevels.end())
+		return false;
+
+	const GeneratedLevel &level = **it;
+	if (HashLayout(level) != level.hash) {
+		LogError("Cached layout of level {} is damaged, generating it again", currlevel);
+		GeneratedLevels.erase(it);
+		return false;
+	}
+
+	// Mirror DRLG_Init_Globals
+	memset(dPlayer, 0, sizeof(dPlayer));
+	memset(dMonster, 0, sizeof(dMonster));
+	memset(dDead, 0, sizeof(dDead));
+	memset(dObject, 0, sizeof(dObject));
+	memset(dItem, 0, sizeof(dItem));
+	memset(dMissile, 0, sizeof(dMissile));
+
+	memcpy(dungeon, level.dungeon, sizeof(dungeon));
+	memcpy(pdungeon, level.pdungeon, sizeof(pdungeon));
+	memcpy(dflags, level.dflags, sizeof(dflags));
+	memcpy(dPiece, level.dPiece, sizeof(dPiece));
+	memcpy(dTransVal, level.dTransVal, sizeof(dTransVal));
+	memcpy(dLight, level.dLight, sizeof(dLight));
+	memcpy(dFlags, level.dFlags, sizeof(dFlags));
+	memcpy(dSpecial, level.dSpecial, sizeof(dSpecial));
+	memcpy(TransList, level.transList, sizeof(TransList));
+	TransVal = level.transVal;
+	themeCount = level.themeCount;
+	std::copy(std::begin(level.themeLoc), std::end(level.themeLoc), themeLoc);
+	setpc_x = level.setpcX;
+	setpc_y = level.setpcY;
+	setpc_w = level.setpcW;
+	setpc_h = level.setpcH;
+	setloadflag = level.setloadflag;
+	dminx = level.dminx;
+	dminy = level.dminy;
+	dmaxx = level.dmaxx;
+	dmaxy = level.dmaxy;
+	ViewX = level.viewX;
+	ViewY = level.viewY;
+	LvlViewX = level.lvlViewX;
+	LvlViewY = level.lvlViewY;
+	SetRndSeed(static_cast<int32_t>(level.rngState));
+
+	if (leveltype == DTYPE_CATHEDRAL) {
+		// Mirror the start of CreateL5Dungeon
+		UberRow = level.uberRow;
+		UberCol = level.uberCol;
+		IsUberRoomOpened = false;
+		UberLeverRow = 0;
+		UberLeverCol = 0;
+		IsUberLeverActivated = false;
+		UberDiabloMonsterIndex = 0;
+	}
+	if (leveltype == DTYPE_HELL) {
+		int *quads[] = { &diabquad1x, &diabquad1y, &diabquad2x, &diabquad2y, &diabquad3x, &diabquad3y, &diabquad4x, &diabquad4y };
+		for (int i = 0; i < 8; i++)
+			*quads[i] = level.diabquads[i];
+	}
+	if (level.poisonWaterPosition)
+		quests[Q_PWATER].position = *level.poisonWaterPosition;
+	if (level.betrayerPosition)
+		quests[Q_BETRAYER].position = *level.betrayerPosition;
+	if (level.cornerStonePosition)
+		CornerStone.position = *level.cornerStonePosition;
+
+	std::rotate(it, it + 1, GeneratedLevels.end());
+	return true;
+}
+
+void BeginGeneratedLevel()
+{
+	PoisonWaterPositionBefore = quests[Q_PWATER].position;
+	BetrayerPositionBefore = quests[Q_BETRAYER].position;
+	CornerStonePositionBefore = CornerStone.position;
+}
+
+void StoreGeneratedLevel(uint32_t seed, lvl_entry entry)
+{
+	if (entry == ENTRY_LOAD)
+		return;
+
+	if (GeneratedLevels.size() >= MaxGeneratedLevels)
+		GeneratedLevels.erase(GeneratedLevels.begin());
+
+	auto level = std::make_unique<GeneratedLevel>();
+	level->key = GetKey(seed, entry);
+	memcpy(level->dungeon, dungeon, sizeof(dungeon));
+	memcpy(level->pdungeon, pdungeon, sizeof(pdungeon));
+	memcpy(level->dflags, dflags, sizeof(dflags));
+	memcpy(level->dPiece, dPiece, sizeof(dPiece));
+	memcpy(level->dTransVal, dTransVal, sizeof(dTransVal));
+	memcpy(level->dLight, dLight, sizeof(dLight));
+	memcpy(level->dFlags, dFlags, sizeof(dFlags));
+	memcpy(level->dSpecial, dSpecial, sizeof(dSpecial));
+	memcpy(level->transList, TransList, sizeof(TransList));
+	level->transVal = TransVal;
+	level->themeCount = themeCount;
+	std::copy(std::begin(themeLoc), std::end(themeLoc), level->themeLoc);
+	level->setpcX = setpc_x;
+	level->setpcY = setpc_y;
+	level->setpcW = setpc_w;
+	level->setpcH = setpc_h;
+	level->setloadflag = setloadflag;
+	level->dminx = dminx;
+	level->dminy = dminy;
+	level->dmaxx = dmaxx;
+	level->dmaxy = dmaxy;
+	level->viewX = ViewX;
+	level->viewY = ViewY;
+	level->lvlViewX = LvlViewX;
+	level->lvlViewY = LvlViewY;
+	level->rngState = GetLCGEngineState();
+	level->uberRow = UberRow;
+	level->uberCol = UberCol;
+	const int quads[] = { diabquad1x, diabquad1y, diabquad2x, diabquad2y, diabquad3x, diabquad3y, diabquad4x, diabquad4y };
+	std::copy(std::begin(quads), std::end(quads), level->diabquads);
+	level->poisonWaterPosition = GetWrittenPosition(PoisonWaterPositionBefore, quests[Q_PWATER].position);
+	level->betrayerPosition = GetWrittenPosition(BetrayerPositionBefore, quests[Q_BETRAYER].position);
+	level->cornerStonePosition = GetWrittenPosition(CornerStonePositionBefore, CornerStone.position);
+	level->hash = HashLayout(*level);
+
+	GeneratedLevels.push_back(std::move(level));
+}
+
+void ClearGeneratedLevels()
+{
+	GeneratedLevels.clear();
+}
+
+} // namespace devilution
@@ -0,0 +1,40 @@
+/**
+ * @file levelcache.h
+ *
+ * Interface of the cache of generated dungeon layouts.
+ */
+#pragma once
+
+#include <cstdint>
+
+#include "gendung.h"
+
+namespace devilution {
+
+/**
+ * @brief Restore the layout that was generated earlier for the current level
+ *
+ * Layouts are keyed by everything the level generation depends on: the seed, the level and its type,
+ * the entry, the game mode and the state of the quests.
+ * @return false if the layout is not cached, it must be generated between BeginGeneratedLevel() and StoreGeneratedLevel()
+ */
+bool RestoreGeneratedLevel(uint32_t seed, lvl_entry entry);
+
+/**
+ * @brief Note the state that the level generation only sometimes writes, call right before generating a level
+ */
+void BeginGeneratedLevel();
+
+/**
+ * @brief Remember the layout that was just generated for the current level
+ * @param seed Seed the layout was generated from
+ * @param entry Entry the layout was generated for
+ */
+void StoreGeneratedLevel(uint32_t seed, lvl_entry entry);
+
+/**
+ * @brief Forget all cached layouts, call when the state they were generated from is reset for a new game
+ */
+void ClearGeneratedLevels();
+
+} // namespace devilution
@@ -5,9 +5,18 @@
  */
 #include "lighting.h"
 
+#include <algorithm>
+#include <bitset>
+#include <vector>
+
 #include "automap.h"
 #include "diablo.h"
+#include "engine/render/cl2_render.hpp"
+#include "engine/render/dun_render.hpp"
+#include "options.h"
 #include "player.h"
+#include "scrollrt.h"
+#include "utils/profiler.h"
 
 namespace devilution {
 
@@ -609,62 +618,151 @@ void DoLighting(Point position, int nRadius, int Lnum)
 	}
 }
 
-void DoUnLight(int nXPos, int nYPos, int nRadius)
-{
-	nRadius++;
+namespace {
 
-	int min_x = nXPos - nRadius;
-	int max_x = nXPos + nRadius;
-	int min_y = nYPos - nRadius;
-	int max_y = nYPos + nRadius;
+/** @brief The tiles a light can affect, all bounds are inclusive. */
+struct LightArea {
+	int minX;
+	int minY;
+	int maxX;
+	int maxY;
 
-	min_x = std::max(min_x, 0);
-	max_x = std::max(max_x, MAXDUNX);
-	min_y = std::max(min_y, 0);
-	max_y = std::max(max_y, MAXDUNY);
+	bool Overlaps(const LightArea &other) const
+	{
+		return minX <= other.maxX && other.minX <= maxX && minY <= other.maxY && other.minY <= maxY;
+	}
+};
 
-	for (int y = min_y; y < max_y; y++) {
-		for (int x = min_x; x < max_x; x++) {
-			if (x >= 0 && x < MAXDUNX && y >= 0 && y < MAXDUNY)
-				dLight[x][y] = dPreLight[x][y];
-		}
+LightArea GetLightArea(Point position, int nRadius)
+{
+	// The light tables reach one tile past the radius and DoLighting starts one tile earlier for
+	// negative offsets. On Hellfire levels every light dims its whole 15 tile window.
+	const int reach = currlevel >= 17 ? 15 : std::min(nRadius + 2, 15);
+
+	return {
+		std::max(position.x - reach, 0),
+		std::max(position.y - reach, 0),
+		std::min(position.x + reach, MAXDUNX - 1),
+		std::min(position.y + reach, MAXDUNY - 1),
+	};
+}
+
+LightArea DoUnLight(Point position, int nRadius)
+{
+	const LightArea area = GetLightArea(position, nRadius);
+
+	for (int x = area.minX; x <= area.maxX; x++) {
+		memcpy(&dLight[x][area.minY], &dPreLight[x][area.minY], area.maxY - area.minY + 1);
 	}
+
+	return area;
 }
 
+} // namespace
+
 void DoUnVision(Point position, int nRadius)
 {
 	nRadius++;
 	nRadius++; // increasing the radius even further here prevents leaving stray vision tiles behind and doesn't seem to affect monster AI - applying new vision happens in the same tick
-	int y1 = position.y - nRadius;
-	int y2 = position.y + nRadius;
-	int x1 = position.x - nRadius;
-	int x2 = position.x + nRadius;
 
-	if (y1 < 0) {
-		y1 = 0;
-	}
-	if (y2 > MAXDUNY) {
-		y2 = MAXDUNY;
-	}
-	if (x1 < 0) {
-		x1 = 0;
-	}
-	if (x2 > MAXDUNX) {
-		x2 = MAXDUNX;
-	}
+	ClearDungeonFlags({ position - Point { nRadius, nRadius }, { 2 * nRadius, 2 * nRadius } }, BFLAG_VISIBLE | BFLAG_LIT);
+}
+
+namespace {
+
+/**
+ * @brief A step of the vision rays, in the order of a depth first walk over all rays of one radius.
+ *
+ * Rays that start with the same tiles share nodes, so each shared tile is only checked once.
+ */
+struct VisionNode {
+	/** Offset from the origin in the quadrant where both coordinates count up */
+	int8_t x;
+	int8_t y;
+	/** Number of rays passing through this tile */
+	uint8_t rays;
+	/** Index of the first node after the rays continuing from this one, where to go on if this tile blocks */
+	uint16_t skip;
+};
 
-	for (int i = x1; i < x2; i++) {
-		for (int j = y1; j < y2; j++) {
-			dFlags[i][j] &= ~(BFLAG_VISIBLE | BFLAG_LIT);
+constexpr int MaxVisionRadius = 15;
+
+using VisionRays = std::vector<VisionNode>;
+
+/**
+ * @brief Merge the vCrawlTable rows for a radius into a tree and lay it out depth first.
+ */
+VisionRays BuildVisionRays(int radius)
+{
+	struct TreeNode {
+		int8_t x;
+		int8_t y;
+		uint8_t rays;
+		std::vector<int> children;
+	};
+	std::vector<TreeNode> tree(1);
+
+	for (int j = 0; j < 23; j++) {
+		int node = 0;
+		for (int k = 0; k < 2 * (radius - RadiusAdj[j]); k += 2) {
+			const auto x = static_cast<int8_t>(vCrawlTable[j][k]);
+			const auto y = static_cast<int8_t>(vCrawlTable[j][k + 1]);
+			auto child = std::find_if(tree[node].children.begin(), tree[node].children.end(), [&](int c) { return tree[c].x == x && tree[c].y == y; });
+			if (child != tree[node].children.end()) {
+				node = *child;
+			} else {
+				tree.push_back({ x, y, 0, {} });
+				tree[node].children.push_back(tree.size() - 1);
+				node = tree.size() - 1;
+			}
+			tree[node].rays++;
 		}
 	}
+
+	VisionRays rays;
+	const auto layOut = [&](const auto &self, int node) -> void {
+		for (int child : tree[node].children) {
+			const size_t index = rays.size();
+			rays.push_back({ tree[child].x, tree[child].y, tree[child].rays, 0 });
+			self(self, child);
+			rays[index].skip = static_cast<uint16_t>(rays.size());
+		}
+	};
+	layOut(layOut, 0);
+
+	return rays;
 }
 
-void DoVision(Point position, int nRadius, bool doautomap, bool visible)
+const VisionRays &GetVisionRays(int radius)
+{
+	static const std::array<VisionRays, MaxVisionRadius + 1> Rays = [] {
+		std::array<VisionRays, MaxVisionRadius + 1> rays;
+		for (int i = 0; i <= MaxVisionRadius; i++)
+			rays[i] = BuildVisionRays(i);
+		return rays;
+	}();
+
+	return Rays[radius];
+}
+
+bool IsTileInMap(int x, int y)
+{
+	return x >= 0 && x < MAXDUNX && y >= 0 && y < MAXDUNY;
+}
+
+/**
+ * @brief Apply a vision source to the tiles it sees
+ * @param transSeen If set, also receives the transparency zones the source marks in TransList
+ */
+void TraceVision(Point position, int nRadius, bool doautomap, bool visible, std::bitset<256> *transSeen)
 {
-	bool nBlockerFlag;
-	int nCrawlX, nCrawlY, nLineLen, nTrans;
-	int j, k, v, x1adj, x2adj, y1adj, y2adj;
+	/** Direction of each quadrant, followed by the offsets of the two tiles that let a diagonal step see around a corner */
+	constexpr int8_t Quadrants[4][6] = {
+		{ 1, 1, -1, 0, 0, -1 },
+		{ -1, -1, 0, 1, 1, 0 },
+		{ 1, -1, -1, 0, 0, 1 },
+		{ -1, 1, 0, -1, 1, 0 },
+	};
 
 	if (position.x >= 0 && position.x<= MAXDUNX && position.y >= 0 && position.y <= MAXDUNY) {
 		if (doautomap) {
@@ -679,79 +777,123 @@ void DoVision(Point position, int nRadius, bool doautomap, bool visible)
 		dFlags[position.x][position.y] |= BFLAG_VISIBLE;
 	}
 
-	for (v = 0; v < 4; v++) {
-		for (j = 0; j < 23; j++) {
-			nBlockerFlag = false;
-			nLineLen = 2 * (nRadius - RadiusAdj[j]);
-			for (k = 0; k < nLineLen && !nBlockerFlag; k += 2) {
-				x1adj = 0;
-				x2adj = 0;
-				y1adj = 0;
-				y2adj = 0;
-				switch (v) {
-				case 0:
-					nCrawlX = position.x + vCrawlTable[j][k];
-					nCrawlY = position.y + vCrawlTable[j][k + 1];
-					if (vCrawlTable[j][k] > 0 && vCrawlTable[j][k + 1] > 0) {
-						x1adj = -1;
-						y2adj = -1;
-					}
-					break;
-				case 1:
-					nCrawlX = position.x - vCrawlTable[j][k];
-					nCrawlY = position.y - vCrawlTable[j][k + 1];
-					if (vCrawlTable[j][k] > 0 && vCrawlTable[j][k + 1] > 0) {
-						y1adj = 1;
-						x2adj = 1;
-					}
-					break;
-				case 2:
-					nCrawlX = position.x + vCrawlTable[j][k];
-					nCrawlY = position.y - vCrawlTable[j][k + 1];
-					if (vCrawlTable[j][k] > 0 && vCrawlTable[j][k + 1] > 0) {
-						x1adj = -1;
-						y2adj = 1;
-					}
-					break;
-				case 3:
-					nCrawlX = position.x - vCrawlTable[j][k];
-					nCrawlY = position.y + vCrawlTable[j][k + 1];
-					if (vCrawlTable[j][k] > 0 && vCrawlTable[j][k + 1] > 0) {
-						y1adj = -1;
-						x2adj = 1;
+	// vCrawlTable only holds rays for up to this radius
+	const VisionRays &rays = GetVisionRays(clamp(nRadius, 0, MaxVisionRadius));
+
+	for (const auto &quadrant : Quadrants) {
+		size_t i = 0;
+		while (i < rays.size()) {
+			const VisionNode &node = rays[i];
+			const int x = position.x + quadrant[0] * node.x;
+			const int y = position.y + quadrant[1] * node.y;
+			if (!IsTileInMap(x, y)) {
+				i++;
+				continue;
+			}
+
+			const bool blocker = nBlockTable[dPiece[x][y]];
+			bool seen;
+			if (node.x > 0 && node.y > 0) {
+				const int x1 = x + quadrant[2];
+				const int y1 = y + quadrant[3];
+				const int x2 = x + quadrant[4];
+				const int y2 = y + quadrant[5];
+				seen = (IsTileInMap(x1, y1) && !nBlockTable[dPiece[x1][y1]]) || (IsTileInMap(x2, y2) && !nBlockTable[dPiece[x2][y2]]);
+			} else {
+				seen = !blocker;
+			}
+			if (seen) {
+				if (doautomap) {
+					// Every ray after the first finds the tile explored
+					if (dFlags[x][y] != 0 || node.rays > 1) {
+						SetAutomapView({ x, y });
 					}
-					break;
+					dFlags[x][y] |= BFLAG_EXPLORED;
 				}
-				if (nCrawlX >= 0 && nCrawlX < MAXDUNX && nCrawlY >= 0 && nCrawlY < MAXDUNY) {
-					nBlockerFlag = nBlockTable[dPiece[nCrawlX][nCrawlY]];
-					if ((x1adj + nCrawlX >= 0 && x1adj + nCrawlX < MAXDUNX && y1adj + nCrawlY >= 0 && y1adj + nCrawlY < MAXDUNY
-					        && !nBlockTable[dPiece[x1adj + nCrawlX][y1adj + nCrawlY]])
-					    || (x2adj + nCrawlX >= 0 && x2adj + nCrawlX < MAXDUNX && y2adj + nCrawlY >= 0 && y2adj + nCrawlY < MAXDUNY
-					        && !nBlockTable[dPiece[x2adj + nCrawlX][y2adj + nCrawlY]])) {
-						if (doautomap) {
-							if (dFlags[nCrawlX][nCrawlY] != 0) {
-								SetAutomapView({ nCrawlX, nCrawlY });
-							}
-							dFlags[nCrawlX][nCrawlY] |= BFLAG_EXPLORED;
-						}
-						if (visible) {
-							dFlags[nCrawlX][nCrawlY] |= BFLAG_LIT;
-						}
-						dFlags[nCrawlX][nCrawlY] |= BFLAG_VISIBLE;
-						if (!nBlockerFlag) {
-							nTrans = dTransVal[nCrawlX][nCrawlY];
-							if (nTrans != 0) {
-								TransList[nTrans] = true;
-							}
-						}
+				if (visible) {
+					dFlags[x][y] |= BFLAG_LIT;
+				}
+				dFlags[x][y] |= BFLAG_VISIBLE;
+				if (!blocker) {
+					int nTrans = dTransVal[x][y];
+					if (nTrans != 0) {
+						TransList[nTrans] = true;
+						if (transSeen != nullptr)
+							transSeen->set(static_cast<uint8_t>(nTrans));
 					}
 				}
 			}
+
+			i = blocker ? node.skip : i + 1;
 		}
 	}
 }
 
-void MakeLightTable()
+/** @brief The tiles DoUnVision clears for a vision source */
+LightArea GetUnVisionArea(Point position, int nRadius)
+{
+	nRadius += 2;
+	return { position.x - nRadius, position.y - nRadius, position.x + nRadius - 1, position.y + nRadius - 1 };
+}
+
+/** @brief The tiles TraceVision can mark for a vision source */
+LightArea GetVisionArea(Point position, int nRadius)
+{
+	nRadius = clamp(nRadius, 0, MaxVisionRadius);
+	return { position.x - nRadius, position.y - nRadius, position.x + nRadius, position.y + nRadius };
+}
+
+/**
+ * @brief What ProcessVisionList needs to apply a source of VisionList again without tracing it
+ *
+ * The flags a source sets on the map stay until DoUnVision clears an area, so only the sources that
+ * moved or are touched by a cleared area have to be traced again. The rest only add their part of TransList.
+ */
+struct TracedVision {
+	/** _lid of the traced source, 0 if the entry doesn't hold one */
+	int id;
+	std::bitset<256> transparent;
+};
+
+/** Cached tracing of each entry of VisionList */
+TracedVision TracedVisions[MAXVISION];
+
+} // namespace
+
+void DoVision(Point position, int nRadius, bool doautomap, bool visible)
+{
+	TraceVision(position, nRadius, doautomap, visible, nullptr);
+}
+
+namespace {
+
+/** @brief The light tables as built for one kind of level, see MakeLightTable. */
+struct LightTables {
+	bool built;
+	std::array<uint8_t, LIGHTSIZE> colors;
+	uint8_t radius[16][128];
+};
+
+/** Built light tables for regular, Hell and Hellfire levels */
+LightTables CachedLightTables[3];
+
+void BuildLightBlock()
+{
+	for (int j = 0; j < 8; j++) {
+		for (int i = 0; i < 8; i++) {
+			for (int k = 0; k < 16; k++) {
+				for (int l = 0; l < 16; l++) {
+					double fs = (BYTE)sqrt((double)(8 * l - j) * (8 * l - j) + (8 * k - i) * (8 * k - i));
+					fs += fs < 0 ? -0.5 : 0.5;
+
+					lightblock[j * 8 + i][k][l] = fs;
+				}
+			}
+		}
+	}
+}
+
+void BuildLightTables()
 {
 	uint8_t *tbl = pLightTbl.data();
 	int shade = 0;
@@ -923,18 +1065,33 @@ void MakeLightTable()
 			}
 		}
 	}
-	for (int j = 0; j < 8; j++) {
-		for (int i = 0; i < 8; i++) {
-			for (int k = 0; k < 16; k++) {
-				for (int l = 0; l < 16; l++) {
-					double fs = (BYTE)sqrt((double)(8 * l - j) * (8 * l - j) + (8 * k - i) * (8 * k - i));
-					fs += fs < 0 ? -0.5 : 0.5;
+}
 
-					lightblock[j * 8 + i][k][l] = fs;
-				}
-			}
-		}
+} // namespace
+
+void MakeLightTable()
+{
+	// The tables only depend on the kind of level and the TRN files, so each kind is built
+	// once instead of on every level change, which also saves reading the TRN files again.
+	static bool lightBlockBuilt;
+	if (!lightBlockBuilt) {
+		BuildLightBlock();
+		lightBlockBuilt = true;
+	}
+
+	LightTables &cached = CachedLightTables[currlevel >= 17 ? 2 : (leveltype == DTYPE_HELL ? 1 : 0)];
+	if (cached.built) {
+		pLightTbl = cached.colors;
+		memcpy(lightradius, cached.radius, sizeof(lightradius));
+	} else {
+		BuildLightTables();
+		cached.colors = pLightTbl;
+		memcpy(cached.radius, lightradius, sizeof(cached.radius));
+		cached.built = true;
 	}
+
+	InvalidateTileCache();
+	InvalidateLitSpriteCache();
 }
 
 #ifdef _DEBUG
@@ -988,7 +1145,10 @@ int AddLight(Point position, int r)
 		LightList[lid]._lradius = r;
 		LightList[lid].position.offset = { 0, 0 };
 		LightList[lid]._ldel = false;
-		LightList[lid]._lunflag = false;
+		// Treat it as moved so ProcessLightList lights it
+		LightList[lid]._lunflag = true;
+		LightList[lid].position.old = position;
+		LightList[lid].oldRadious = r;
 		dolighting = true;
 	}
 
@@ -1005,15 +1165,26 @@ void AddUnLight(int i)
 	dolighting = true;
 }
 
+/**
+ * @brief Remember where a light was last drawn, so ProcessLightList can clear it before drawing the light again.
+ */
+static void RememberLitArea(int i)
+{
+	// Keep the first position if the light changes several times before ProcessLightList
+	if (!LightList[i]._lunflag) {
+		LightList[i]._lunflag = true;
+		LightList[i].position.old = LightList[i].position.tile;
+		LightList[i].oldRadious = LightList[i]._lradius;
+	}
+}
+
 void ChangeLightRadius(int i, int r)
 {
 	if (lightflag || i == NO_LIGHT) {
 		return;
 	}
 
-	LightList[i]._lunflag = true;
-	LightList[i].position.old = LightList[i].position.tile;
-	LightList[i].oldRadious = LightList[i]._lradius;
+	RememberLitArea(i);
 	LightList[i]._lradius = r;
 	dolighting = true;
 }
@@ -1024,9 +1195,7 @@ void ChangeLightXY(int i, Point position)
 		return;
 	}
 
-	LightList[i]._lunflag = true;
-	LightList[i].position.old = LightList[i].position.tile;
-	LightList[i].oldRadious = LightList[i]._lradius;
+	RememberLitArea(i);
 	LightList[i].position.tile = position;
 	dolighting = true;
 }
@@ -1037,9 +1206,7 @@ void ChangeLightOff(int i, Point position)
 		return;
 	}
 
-	LightList[i]._lunflag = true;
-	LightList[i].position.old = LightList[i].position.tile;
-	LightList[i].oldRadious = LightList[i]._lradius;
+	RememberLitArea(i);
 	LightList[i].position.offset = position;
 	dolighting = true;
 }
@@ -1050,9 +1217,7 @@ void ChangeLight(int i, Point position, int r)
 		return;
 	}
 
-	LightList[i]._lunflag = true;
-	LightList[i].position.old = LightList[i].position.tile;
-	LightList[i].oldRadious = LightList[i]._lradius;
+	RememberLitArea(i);
 	LightList[i].position.tile = position;
 	LightList[i]._lradius = r;
 	dolighting = true;
@@ -1060,26 +1225,41 @@ void ChangeLight(int i, Point position, int r)
 
 void ProcessLightList()
 {
+	ProfileScope profileScope(ProfilePhase::ProcessLightList);
+
 	if (lightflag) {
 		return;
 	}
 
 	if (dolighting) {
+		// Reset the areas of moved and removed lights, then relight only the lights touching them.
+		// Everywhere else dLight already holds the result of the unchanged lights.
+		LightArea unlit[MAXLIGHTS * 2];
+		int numUnlit = 0;
+		bool moved[MAXLIGHTS] = {};
 		for (int i = 0; i < numlights; i++) {
 			int j = lightactive[i];
 			if (LightList[j]._ldel) {
-				DoUnLight(LightList[j].position.tile.x, LightList[j].position.tile.y, LightList[j]._lradius);
+				unlit[numUnlit++] = DoUnLight(LightList[j].position.tile, LightList[j]._lradius);
 			}
 			if (LightList[j]._lunflag) {
-				DoUnLight(LightList[j].position.old.x, LightList[j].position.old.y, LightList[j].oldRadious);
+				unlit[numUnlit++] = DoUnLight(LightList[j].position.old, LightList[j].oldRadious);
 				LightList[j]._lunflag = false;
+				moved[j] = true;
 			}
 		}
 		for (int i = 0; i < numlights; i++) {
 			int j = lightactive[i];
-			if (!LightList[j]._ldel) {
-				DoLighting(LightList[j].position.tile, LightList[j]._lradius, j);
+			if (LightList[j]._ldel) {
+				continue;
+			}
+			if (!moved[j]) {
+				const LightArea area = GetLightArea(LightList[j].position.tile, LightList[j]._lradius);
+				if (std::none_of(unlit, unlit + numUnlit, [&area](const LightArea &other) { return area.Overlaps(other); })) {
+					continue;
+				}
 			}
+			DoLighting(LightList[j].position.tile, LightList[j]._lradius, j);
 		}
 		int i = 0;
 		while (i < numlights) {
@@ -1108,6 +1288,9 @@ void InitVision()
 	dovision = false;
 	visionid = 1;
 
+	for (TracedVision &traced : TracedVisions)
+		traced.id = 0;
+
 	for (int i = 0; i < TransVal; i++) {
 		TransList[i] = false;
 	}
@@ -1160,27 +1343,46 @@ void ChangeVisionXY(int id, Point position)
 
 void ProcessVisionList()
 {
+	ProfileScope profileScope(ProfilePhase::ProcessVisionList);
+
 	if (dovision) {
+		LightArea unseen[MAXVISION * 2];
+		int numUnseen = 0;
+		bool moved[MAXVISION] = {};
 		for (int i = 0; i < numvision; i++) {
 			if (VisionList[i]._ldel) {
 				DoUnVision(VisionList[i].position.tile, VisionList[i]._lradius);
+				unseen[numUnseen++] = GetUnVisionArea(VisionList[i].position.tile, VisionList[i]._lradius);
 			}
 			if (VisionList[i]._lunflag) {
 				DoUnVision(VisionList[i].position.old, VisionList[i].oldRadious);
+				unseen[numUnseen++] = GetUnVisionArea(VisionList[i].position.old, VisionList[i].oldRadious);
 				VisionList[i]._lunflag = false;
+				moved[i] = true;
 			}
 		}
 		for (int i = 0; i < TransVal; i++) {
 			TransList[i] = false;
 		}
 		for (int i = 0; i < numvision; i++) {
-			if (!VisionList[i]._ldel) {
-				DoVision(
-				    VisionList[i].position.tile,
-				    VisionList[i]._lradius,
-				    VisionList[i]._lflags,
-				    VisionList[i]._lflags);
+			const LightListStruct &vision = VisionList[i];
+			if (vision._ldel)
+				continue;
+			TracedVision &traced = TracedVisions[i];
+			// Sources of the local player also reveal the automap, which depends on what was seen before, always trace those
+			if (!moved[i] && !vision._lflags && traced.id == vision._lid) {
+				const LightArea area = GetVisionArea(vision.position.tile, vision._lradius);
+				if (std::none_of(unseen, unseen + numUnseen, [&area](const LightArea &other) { return area.Overlaps(other); })) {
+					for (size_t j = 0; j < traced.transparent.size(); j++) {
+						if (traced.transparent.test(j))
+							TransList[j] = true;
+					}
+					continue;
+				}
 			}
+			traced.id = vision._lid;
+			traced.transparent.reset();
+			TraceVision(vision.position.tile, vision._lradius, vision._lflags, vision._lflags, &traced.transparent);
 		}
 		bool delflag;
 		do {
@@ -1190,6 +1392,7 @@ void ProcessVisionList()
 					numvision--;
 					if (numvision > 0 && i != numvision) {
 						VisionList[i] = VisionList[numvision];
+						TracedVisions[i] = TracedVisions[numvision];
 					}
 					delflag = true;
 				}
@@ -1218,6 +1421,15 @@ void lighting_color_cycling()
 		*tbl = col;
 		tbl += 225;
 	}
+	// Only what was drawn with the rotated colors has to be lit again
+	InvalidateCycledTiles();
+	InvalidateCycledLitSprites();
+	InvalidateViewportCache();
+}
+
+bool LightTablesCycle()
+{
+	return leveltype == DTYPE_HELL && sgOptions.Graphics.bColorCycling;
 }
 
 } // namespace devilution
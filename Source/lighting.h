@@ -72,6 +72,19 @@ void ChangeVisionXY(int id, Point position);
 void ProcessVisionList();
 void lighting_color_cycling();
 
+/**
+ * @brief Whether lighting_color_cycling rotates the light table entries of the current level
+ */
+bool LightTablesCycle();
+
+/**
+ * @brief Whether lighting_color_cycling rotates the light table entries of this color
+ */
+constexpr bool IsLightCycledColor(uint8_t color)
+{
+	return color >= 1 && color <= 31;
+}
+
 /* rdata */
 
 extern const char CrawlTable[2749];
@@ -7,6 +7,8 @@
 
 #include <SDL.h>
 #include <climits>
+#include <string>
+#include <vector>
 
 #include "automap.h"
 #include "codec.h"
@@ -23,6 +25,7 @@
 #include "pfile.h"
 #include "stores.h"
 #include "utils/language.h"
+#include "utils/stdcompat/optional.hpp"
 
 namespace devilution {
 
@@ -82,6 +85,30 @@ class LoadHelper {
 		return value;
 	}
 
+	template <class Stored, class T, size_t Width, size_t Height, class Swap>
+	void nextGrid(T (&grid)[Width][Height], Swap swap)
+	{
+		const size_t size = sizeof(Stored) * Width * Height;
+		if (!isValid(size)) {
+			for (size_t j = 0; j < Height; j++) {
+				for (size_t i = 0; i < Width; i++)
+					grid[i][j] = static_cast<T>(swap(next<Stored>()));
+			}
+			return;
+		}
+
+		const byte *src = &m_buffer[m_cur];
+		for (size_t j = 0; j < Height; j++) {
+			for (size_t i = 0; i < Width; i++) {
+				Stored value;
+				memcpy(&value, src, sizeof(value));
+				grid[i][j] = static_cast<T>(swap(value));
+				src += sizeof(value);
+			}
+		}
+		m_cur += size;
+	}
+
 public:
 	LoadHelper(const char *szFileName)
 	{
@@ -120,6 +147,23 @@ public:
 		return SwapBE(next<T>());
 	}
 
+	/**
+	 * @brief Reads a grid that was saved row by row, checking the bounds once for the whole grid
+	 * @tparam Stored Type of the values in the file
+	 */
+	template <class Stored, class T, size_t Width, size_t Height>
+	void nextGridLE(T (&grid)[Width][Height])
+	{
+		nextGrid<Stored>(grid, [](Stored value) { return SwapLE(value); });
+	}
+
+	/** @copydoc nextGridLE */
+	template <class Stored, class T, size_t Width, size_t Height>
+	void nextGridBE(T (&grid)[Width][Height])
+	{
+		nextGrid<Stored>(grid, [](Stored value) { return SwapBE(value); });
+	}
+
 	bool nextBool8()
 	{
 		return next<uint8_t>() != 0;
@@ -131,29 +175,45 @@ public:
 	}
 };
 
+/**
+ * @brief Encodes and compresses a save file a sector at a time while it is written.
+ *
+ * Level snapshots are kept as they are written instead, see pfile_write_level_snapshot.
+ */
 class SaveHelper {
-	const char *m_szFileName;
-	std::unique_ptr<byte[]> m_buffer;
+	std::string m_name;
+	MpqFileWriter m_writer;
+	std::optional<CodecEncoder> m_encoder;
+	bool m_isSnapshot;
+	std::vector<byte> m_snapshot;
+	/** The sector being filled, with room for the signature after the last one */
+	byte m_sector[MpqSectorSize + CodecEncoder::SignatureSize];
+	uint32_t m_sectorLen = 0;
 	uint32_t m_cur = 0;
 	uint32_t m_capacity;
 
 public:
-	SaveHelper(const char *szFileName, size_t bufferLen)
-	    : m_szFileName(szFileName)
-	    , m_buffer(new byte[codec_get_encoded_len(bufferLen)])
+	SaveHelper(const char *szFileName, size_t bufferLen, bool isSnapshot = false)
+	    : m_name(szFileName)
+	    , m_writer(szFileName)
+	    , m_isSnapshot(isSnapshot)
 	    , m_capacity(bufferLen)
 	{
+		if (m_isSnapshot)
+			m_snapshot.reserve(bufferLen);
+		else
+			m_encoder.emplace(pfile_get_password());
 	}
 
 	bool isValid(uint32_t len = 1)
 	{
-		return m_buffer != nullptr
-		    && m_capacity >= (m_cur + len);
+		return m_capacity >= (m_cur + len);
 	}
 
 	void skip(uint32_t len)
 	{
-		m_cur += len;
+		for (; len > 0; len--)
+			writeLE<uint8_t>(0);
 	}
 
 	void writeBytes(const void *bytes, size_t len)
@@ -161,8 +221,24 @@ public:
 		if (!isValid(len))
 			return;
 
-		memcpy(&m_buffer[m_cur], bytes, len);
 		m_cur += len;
+		const auto *src = static_cast<const byte *>(bytes);
+		if (m_isSnapshot) {
+			m_snapshot.insert(m_snapshot.end(), src, src + len);
+			return;
+		}
+		while (len != 0) {
+			const size_t chunk = std::min<size_t>(len, MpqSectorSize - m_sectorLen);
+			memcpy(&m_sector[m_sectorLen], src, chunk);
+			m_sectorLen += chunk;
+			src += chunk;
+			len -= chunk;
+			if (m_sectorLen == MpqSectorSize) {
+				m_encoder->Encode(m_sector, MpqSectorSize);
+				m_writer.Write(m_sector, MpqSectorSize);
+				m_sectorLen = 0;
+			}
+		}
 	}
 
 	template <class T>
@@ -181,13 +257,87 @@ public:
 
 	~SaveHelper()
 	{
-		const auto encoded_len = codec_get_encoded_len(m_cur);
-		const char *const password = pfile_get_password();
-		codec_encode(m_buffer.get(), m_cur, encoded_len, password);
-		mpqapi_write_file(m_szFileName, m_buffer.get(), encoded_len);
+		if (m_isSnapshot) {
+			m_snapshot.shrink_to_fit();
+			pfile_write_level_snapshot(m_name.c_str(), std::move(m_snapshot));
+			return;
+		}
+
+		const size_t encodedLen = m_encoder->Encode(m_sector, m_sectorLen);
+		m_encoder->Finish(&m_sector[encodedLen]);
+		m_writer.Write(m_sector, encodedLen + CodecEncoder::SignatureSize);
+		m_writer.Finish();
 	}
 };
 
+constexpr int NumSetLevels = SL_VILEBETRAYER + 1;
+
+/**
+ * Whether the file of each level is in the Hellfire format.
+ *
+ * After loading a save of the other game, levels are only converted once they are entered and saved again.
+ * Until then their format is kept in the "levelformat" file of the save, and the save has a header that
+ * older builds reject (see SaveGameData).
+ */
+bool LevelIsHellfire[NUMLEVELS];
+bool SetLevelIsHellfire[NumSetLevels];
+
+bool &CurrentLevelIsHellfire()
+{
+	if (setlevel)
+		return SetLevelIsHellfire[setlvlnum];
+	return LevelIsHellfire[currlevel];
+}
+
+void SetLevelFormats(bool isHellfire)
+{
+	for (bool &levelIsHellfire : LevelIsHellfire)
+		levelIsHellfire = isHellfire;
+	for (bool &levelIsHellfire : SetLevelIsHellfire)
+		levelIsHellfire = isHellfire;
+}
+
+bool HasUnconvertedLevels()
+{
+	for (bool levelIsHellfire : LevelIsHellfire) {
+		if (levelIsHellfire != gbIsHellfire)
+			return true;
+	}
+	for (bool levelIsHellfire : SetLevelIsHellfire) {
+		if (levelIsHellfire != gbIsHellfire)
+			return true;
+	}
+	return false;
+}
+
+void LoadLevelFormats()
+{
+	SetLevelFormats(gbIsHellfireSaveGame);
+
+	LoadHelper file("levelformat");
+	if (!file.isValid())
+		return;
+
+	for (bool &levelIsHellfire : LevelIsHellfire)
+		levelIsHellfire = file.nextBool8();
+	for (bool &levelIsHellfire : SetLevelIsHellfire)
+		levelIsHellfire = file.nextBool8();
+}
+
+void SaveLevelFormats()
+{
+	if (!HasUnconvertedLevels()) {
+		mpqapi_remove_hash_entry("levelformat");
+		return;
+	}
+
+	SaveHelper file("levelformat", NUMLEVELS + NumSetLevels);
+	for (bool levelIsHellfire : LevelIsHellfire)
+		file.writeLE<uint8_t>(levelIsHellfire ? 1 : 0);
+	for (bool levelIsHellfire : SetLevelIsHellfire)
+		file.writeLE<uint8_t>(levelIsHellfire ? 1 : 0);
+}
+
 } // namespace
 
 void RemoveInvalidItem(ItemStruct *pItem)
@@ -216,6 +366,8 @@ static void LoadItemData(LoadHelper *file, ItemStruct *pItem)
 	pItem->position.x = file->nextLE<int32_t>();
 	pItem->position.y = file->nextLE<int32_t>();
 	pItem->_iAnimFlag = file->nextBool32();
+	if (pItem->_iAnimFlag)
+		ItemAnimationPending = true;
 	file->skip(4); // Skip pointer _iAnimData
 	pItem->AnimInfo = {};
 	pItem->AnimInfo.NumberOfFrames = file->nextLE<int32_t>();
@@ -516,6 +668,7 @@ static void LoadPlayer(LoadHelper *file, int p)
 	player.pDifficulty = static_cast<_difficulty>(file->nextLE<uint32_t>());
 	player.pDamAcFlags = file->nextLE<uint32_t>();
 	file->skip(20); // Available bytes
+	InvalidateItemStats(player);
 	CalcPlrItemVals(p, false);
 
 	// Omit pointer _pNData
@@ -651,6 +804,7 @@ static void LoadMissile(LoadHelper *file, int i)
 	pMissile->position.start.y = file->nextLE<int32_t>();
 	pMissile->position.traveled.x = file->nextLE<int32_t>();
 	pMissile->position.traveled.y = file->nextLE<int32_t>();
+	pMissile->position.lastStep = { 0, 0 };
 	pMissile->_mimfnum = file->nextLE<int32_t>();
 	pMissile->_mispllvl = file->nextLE<int32_t>();
 	pMissile->_miDelFlag = file->nextBool32();
@@ -907,15 +1061,15 @@ _item_indexes RemapItemIdxToSpawn(_item_indexes i)
 bool IsHeaderValid(uint32_t magicNumber)
 {
 	gbIsHellfireSaveGame = false;
-	if (magicNumber == LoadLE32("SHAR")) {
+	if (magicNumber == LoadLE32("SHAR") || magicNumber == LoadLE32("SHAM")) {
 		return true;
 	}
-	if (magicNumber == LoadLE32("SHLF")) {
+	if (magicNumber == LoadLE32("SHLF") || magicNumber == LoadLE32("SHLM")) {
 		gbIsHellfireSaveGame = true;
 		return true;
-	} else if (!gbIsSpawn && magicNumber == LoadLE32("RETL")) {
+	} else if (!gbIsSpawn && (magicNumber == LoadLE32("RETL") || magicNumber == LoadLE32("RETM"))) {
 		return true;
-	} else if (!gbIsSpawn && magicNumber == LoadLE32("HELF")) {
+	} else if (!gbIsSpawn && (magicNumber == LoadLE32("HELF") || magicNumber == LoadLE32("HELM"))) {
 		gbIsHellfireSaveGame = true;
 		return true;
 	}
@@ -989,21 +1143,44 @@ void LoadHotkeys()
 	plr[myplr]._pRSplType = static_cast<spell_type>(file.nextLE<int8_t>());
 }
 
-void SaveHotkeys()
+HeroSaveData::HeroSaveData(const PlayerStruct &player)
+    : _pRSpell(player._pRSpell)
+    , _pRSplType(player._pRSplType)
 {
-	const size_t nHotkeyTypes = sizeof(plr[myplr]._pSplHotKey) / sizeof(plr[myplr]._pSplHotKey[0]);
-	const size_t nHotkeySpells = sizeof(plr[myplr]._pSplTHotKey) / sizeof(plr[myplr]._pSplTHotKey[0]);
+	std::copy(std::begin(player._pSplHotKey), std::end(player._pSplHotKey), _pSplHotKey);
+	std::copy(std::begin(player._pSplTHotKey), std::end(player._pSplTHotKey), _pSplTHotKey);
+	std::copy(std::begin(player.InvBody), std::end(player.InvBody), InvBody);
+	std::copy(std::begin(player.InvList), std::end(player.InvList), InvList);
+	std::copy(std::begin(player.SpdList), std::end(player.SpdList), SpdList);
+}
+
+/** @tparam Hero Either PlayerStruct or HeroSaveData */
+template <typename Hero>
+static void SaveHotkeysOf(const Hero &hero)
+{
+	const size_t nHotkeyTypes = sizeof(hero._pSplHotKey) / sizeof(hero._pSplHotKey[0]);
+	const size_t nHotkeySpells = sizeof(hero._pSplTHotKey) / sizeof(hero._pSplTHotKey[0]);
 
 	SaveHelper file("hotkeys", (nHotkeyTypes * 4) + nHotkeySpells + 4 + 1);
 
-	for (auto &spellId : plr[myplr]._pSplHotKey) {
+	for (auto &spellId : hero._pSplHotKey) {
 		file.writeLE<int32_t>(spellId);
 	}
-	for (auto &spellType : plr[myplr]._pSplTHotKey) {
+	for (auto &spellType : hero._pSplTHotKey) {
 		file.writeLE<uint8_t>(spellType);
 	}
-	file.writeLE<int32_t>(plr[myplr]._pRSpell);
-	file.writeLE<uint8_t>(plr[myplr]._pRSplType);
+	file.writeLE<int32_t>(hero._pRSpell);
+	file.writeLE<uint8_t>(hero._pRSplType);
+}
+
+void SaveHotkeys()
+{
+	SaveHotkeysOf(plr[myplr]);
+}
+
+void SaveHotkeys(const HeroSaveData &hero)
+{
+	SaveHotkeysOf(hero);
 }
 
 static void LoadMatchingItems(LoadHelper *file, const int n, ItemStruct *pItem)
@@ -1117,8 +1294,11 @@ void LoadGame(bool firstflag)
 	for (int i = 0; i < MAXPORTAL; i++)
 		LoadPortal(&file, i);
 
+	LoadLevelFormats();
 	if (gbIsHellfireSaveGame != gbIsHellfire) {
-		ConvertLevels();
+		// Without the "levelformat" file a vanilla save has to have every level in the same format
+		if (gbVanilla)
+			ConvertLevels();
 		RemoveEmptyInventory(myplr);
 	}
 
@@ -1141,6 +1321,7 @@ void LoadGame(bool firstflag)
 			monsterId = file.nextBE<int32_t>();
 		for (int i = 0; i < nummonsters; i++)
 			LoadMonster(&file, monstactive[i]);
+		InvalidateMonsterTargets();
 		for (int &missileId : missileactive)
 			missileId = file.nextLE<int8_t>();
 		for (int &missileId : missileavail)
@@ -1155,6 +1336,7 @@ void LoadGame(bool firstflag)
 			LoadObject(&file, objectactive[i]);
 		for (int i = 0; i < nobjects; i++)
 			SyncObjectAnim(objectactive[i]);
+		InvalidateObjectTickList();
 
 		numlights = file.nextBE<int32_t>();
 
@@ -1179,52 +1361,19 @@ void LoadGame(bool firstflag)
 	for (bool &UniqueItemFlag : UniqueItemFlags)
 		UniqueItemFlag = file.nextBool8();
 
-	for (int j = 0; j < MAXDUNY; j++) {
-		for (int i = 0; i < MAXDUNX; i++)
-			dLight[i][j] = file.nextLE<int8_t>();
-	}
-	for (int j = 0; j < MAXDUNY; j++) {
-		for (int i = 0; i < MAXDUNX; i++)
-			dFlags[i][j] = file.nextLE<int8_t>();
-	}
-	for (int j = 0; j < MAXDUNY; j++) {
-		for (int i = 0; i < MAXDUNX; i++)
-			dPlayer[i][j] = file.nextLE<int8_t>();
-	}
-	for (int j = 0; j < MAXDUNY; j++) {
-		for (int i = 0; i < MAXDUNX; i++)
-			dItem[i][j] = file.nextLE<int8_t>();
-	}
+	file.nextGridLE<int8_t>(dLight);
+	file.nextGridLE<int8_t>(dFlags);
+	file.nextGridLE<int8_t>(dPlayer);
+	file.nextGridLE<int8_t>(dItem);
 
 	if (leveltype != DTYPE_TOWN) {
-		for (int j = 0; j < MAXDUNY; j++) {
-			for (int i = 0; i < MAXDUNX; i++)
-				dMonster[i][j] = file.nextBE<int32_t>();
-		}
-		for (int j = 0; j < MAXDUNY; j++) {
-			for (int i = 0; i < MAXDUNX; i++)
-				dDead[i][j] = file.nextLE<int8_t>();
-		}
-		for (int j = 0; j < MAXDUNY; j++) {
-			for (int i = 0; i < MAXDUNX; i++)
-				dObject[i][j] = file.nextLE<int8_t>();
-		}
-		for (int j = 0; j < MAXDUNY; j++) {
-			for (int i = 0; i < MAXDUNX; i++)
-				dLight[i][j] = file.nextLE<int8_t>();
-		}
-		for (int j = 0; j < MAXDUNY; j++) {
-			for (int i = 0; i < MAXDUNX; i++)
-				dPreLight[i][j] = file.nextLE<int8_t>();
-		}
-		for (int j = 0; j < DMAXY; j++) {
-			for (int i = 0; i < DMAXX; i++)
-				AutomapView[i][j] = file.nextBool8();
-		}
-		for (int j = 0; j < MAXDUNY; j++) {
-			for (int i = 0; i < MAXDUNX; i++)
-				dMissile[i][j] = file.nextLE<int8_t>();
-		}
+		file.nextGridBE<int32_t>(dMonster);
+		file.nextGridLE<int8_t>(dDead);
+		file.nextGridLE<int8_t>(dObject);
+		file.nextGridLE<int8_t>(dLight);
+		file.nextGridLE<int8_t>(dPreLight);
+		file.nextGridLE<uint8_t>(AutomapView);
+		file.nextGridLE<int8_t>(dMissile);
 	}
 
 	numpremium = file.nextBE<int32_t>();
@@ -1258,7 +1407,7 @@ void LoadGame(bool firstflag)
 	gbIsHellfireSaveGame = gbIsHellfire;
 }
 
-static void SaveItem(SaveHelper *file, ItemStruct *pItem)
+static void SaveItem(SaveHelper *file, const ItemStruct *pItem)
 {
 	auto idx = pItem->IDidx;
 	if (!gbIsHellfire)
@@ -1351,7 +1500,7 @@ static void SaveItem(SaveHelper *file, ItemStruct *pItem)
 		file->writeLE<uint32_t>(pItem->_iDamAcFlags);
 }
 
-static void SaveItems(SaveHelper *file, ItemStruct *pItem, const int n)
+static void SaveItems(SaveHelper *file, const ItemStruct *pItem, const int n)
 {
 	for (int i = 0; i < n; i++) {
 		SaveItem(file, &pItem[i]);
@@ -1834,16 +1983,28 @@ static void SavePortal(SaveHelper *file, int i)
 const int DiabloItemSaveSize = 368;
 const int HellfireItemSaveSize = 372;
 
-void SaveHeroItems(PlayerStruct &player)
+/** @tparam Hero Either PlayerStruct or HeroSaveData */
+template <typename Hero>
+static void SaveHeroItemsOf(const Hero &hero)
 {
 	size_t items = NUM_INVLOC + NUM_INV_GRID_ELEM + MAXBELTITEMS;
 	SaveHelper file("heroitems", items * (gbIsHellfire ? HellfireItemSaveSize : DiabloItemSaveSize) + sizeof(uint8_t));
 
 	file.writeLE<uint8_t>(gbIsHellfire);
 
-	SaveItems(&file, player.InvBody, NUM_INVLOC);
-	SaveItems(&file, player.InvList, NUM_INV_GRID_ELEM);
-	SaveItems(&file, player.SpdList, MAXBELTITEMS);
+	SaveItems(&file, hero.InvBody, NUM_INVLOC);
+	SaveItems(&file, hero.InvList, NUM_INV_GRID_ELEM);
+	SaveItems(&file, hero.SpdList, MAXBELTITEMS);
+}
+
+void SaveHeroItems(PlayerStruct &player)
+{
+	SaveHeroItemsOf(player);
+}
+
+void SaveHeroItems(const HeroSaveData &hero)
+{
+	SaveHeroItemsOf(hero);
 }
 
 // 256 kilobytes + 3 bytes (demo leftover) for file magic (262147)
@@ -1852,16 +2013,21 @@ void SaveHeroItems(PlayerStruct &player)
 
 void SaveGameData()
 {
+	SaveLevelFormats();
+
 	SaveHelper file("game", FILEBUFF);
 
+	// A save that still has levels in the format of the other game gets its own header.
+	// Builds that don't know the "levelformat" file then refuse it instead of misreading those levels.
+	const bool mixedLevelFormats = HasUnconvertedLevels();
 	if (gbIsSpawn && !gbIsHellfire)
-		file.writeLE<uint32_t>(LoadLE32("SHAR"));
+		file.writeLE<uint32_t>(LoadLE32(mixedLevelFormats ? "SHAM" : "SHAR"));
 	else if (gbIsSpawn && gbIsHellfire)
-		file.writeLE<uint32_t>(LoadLE32("SHLF"));
+		file.writeLE<uint32_t>(LoadLE32(mixedLevelFormats ? "SHLM" : "SHLF"));
 	else if (!gbIsSpawn && gbIsHellfire)
-		file.writeLE<uint32_t>(LoadLE32("HELF"));
+		file.writeLE<uint32_t>(LoadLE32(mixedLevelFormats ? "HELM" : "HELF"));
 	else if (!gbIsSpawn && !gbIsHellfire)
-		file.writeLE<uint32_t>(LoadLE32("RETL"));
+		file.writeLE<uint32_t>(LoadLE32(mixedLevelFormats ? "RETM" : "RETL"));
 	else
 		app_fatal("%s", _("Invalid game state"));
 
@@ -2010,8 +2176,6 @@ void SaveGame()
 
 void SaveLevel()
 {
-	PFileScopedArchiveWriter scoped_writer;
-
 	DoUnVision(plr[myplr].position.tile, plr[myplr]._pLightRad); // fix for vision staying on the level
 
 	if (currlevel == 0)
@@ -2019,7 +2183,7 @@ void SaveLevel()
 
 	char szName[MAX_PATH];
 	GetTempLevelNames(szName);
-	SaveHelper file(szName, FILEBUFF);
+	SaveHelper file(szName, FILEBUFF, /*isSnapshot=*/true);
 
 	if (leveltype != DTYPE_TOWN) {
 		for (int j = 0; j < MAXDUNY; j++) {
@@ -2093,6 +2257,12 @@ void SaveLevel()
 		plr[myplr]._pLvlVisited[currlevel] = true;
 	else
 		plr[myplr]._pSLvlVisited[setlvlnum] = true;
+	CurrentLevelIsHellfire() = gbIsHellfire;
+}
+
+void ResetLevelFormats()
+{
+	SetLevelFormats(gbIsHellfire);
 }
 
 void LoadLevel()
@@ -2103,11 +2273,11 @@ void LoadLevel()
 	if (!file.isValid())
 		app_fatal("%s", _("Unable to open save file archive"));
 
+	const bool saveGameIsHellfire = gbIsHellfireSaveGame;
+	gbIsHellfireSaveGame = CurrentLevelIsHellfire();
+
 	if (leveltype != DTYPE_TOWN) {
-		for (int j = 0; j < MAXDUNY; j++) {
-			for (int i = 0; i < MAXDUNX; i++)
-				dDead[i][j] = file.nextLE<int8_t>();
-		}
+		file.nextGridLE<int8_t>(dDead);
 		SetDead();
 	}
 
@@ -2120,12 +2290,14 @@ void LoadLevel()
 			monsterId = file.nextBE<int32_t>();
 		for (int i = 0; i < nummonsters; i++)
 			LoadMonster(&file, monstactive[i]);
+		InvalidateMonsterTargets();
 		for (int &objectId : objectactive)
 			objectId = file.nextLE<int8_t>();
 		for (int &objectId : objectavail)
 			objectId = file.nextLE<int8_t>();
 		for (int i = 0; i < nobjects; i++)
 			LoadObject(&file, objectactive[i]);
+		InvalidateObjectTickList();
 		if (!gbSkipSync) {
 			for (int i = 0; i < nobjects; i++)
 				SyncObjectAnim(objectactive[i]);
@@ -2139,36 +2311,15 @@ void LoadLevel()
 	for (int i = 0; i < numitems; i++)
 		LoadItem(&file, itemactive[i]);
 
-	for (int j = 0; j < MAXDUNY; j++) {
-		for (int i = 0; i < MAXDUNX; i++)
-			dFlags[i][j] = file.nextLE<int8_t>();
-	}
-	for (int j = 0; j < MAXDUNY; j++) {
-		for (int i = 0; i < MAXDUNX; i++)
-			dItem[i][j] = file.nextLE<int8_t>();
-	}
+	file.nextGridLE<int8_t>(dFlags);
+	file.nextGridLE<int8_t>(dItem);
 
 	if (leveltype != DTYPE_TOWN) {
-		for (int j = 0; j < MAXDUNY; j++) {
-			for (int i = 0; i < MAXDUNX; i++)
-				dMonster[i][j] = file.nextBE<int32_t>();
-		}
-		for (int j = 0; j < MAXDUNY; j++) {
-			for (int i = 0; i < MAXDUNX; i++)
-				dObject[i][j] = file.nextLE<int8_t>();
-		}
-		for (int j = 0; j < MAXDUNY; j++) {
-			for (int i = 0; i < MAXDUNX; i++)
-				dLight[i][j] = file.nextLE<int8_t>();
-		}
-		for (int j = 0; j < MAXDUNY; j++) {
-			for (int i = 0; i < MAXDUNX; i++)
-				dPreLight[i][j] = file.nextLE<int8_t>();
-		}
-		for (int j = 0; j < DMAXY; j++) {
-			for (int i = 0; i < DMAXX; i++)
-				AutomapView[i][j] = file.nextBool8();
-		}
+		file.nextGridBE<int32_t>(dMonster);
+		file.nextGridLE<int8_t>(dObject);
+		file.nextGridLE<int8_t>(dLight);
+		file.nextGridLE<int8_t>(dPreLight);
+		file.nextGridLE<uint8_t>(AutomapView);
 		for (int j = 0; j < MAXDUNY; j++) {
 			for (int i = 0; i < MAXDUNX; i++)
 				dMissile[i][j] = 0; /// BUGFIX: supposed to load saved missiles with "file.nextLE<int8_t>()"?
@@ -2190,6 +2341,8 @@ void LoadLevel()
 		if (player.plractive && currlevel == player.plrlevel)
 			LightList[player._plid]._lunflag = true;
 	}
+
+	gbIsHellfireSaveGame = saveGameIsHellfire;
 }
 
 } // namespace devilution
@@ -26,8 +26,29 @@ void LoadHeroItems(PlayerStruct &pPlayer);
  */
 void RemoveEmptyInventory(int pnum);
 void LoadGame(bool firstflag);
+/**
+ * @brief Mark every level of a new game as being in the format of the running game
+ */
+void ResetLevelFormats();
+/**
+ * @brief The parts of a hero that SaveHotkeys and SaveHeroItems write, copied so that they can be saved from another thread
+ */
+struct HeroSaveData {
+	decltype(PlayerStruct::_pSplHotKey) _pSplHotKey;
+	decltype(PlayerStruct::_pSplTHotKey) _pSplTHotKey;
+	spell_id _pRSpell;
+	spell_type _pRSplType;
+	decltype(PlayerStruct::InvBody) InvBody;
+	decltype(PlayerStruct::InvList) InvList;
+	decltype(PlayerStruct::SpdList) SpdList;
+
+	explicit HeroSaveData(const PlayerStruct &player);
+};
+
 void SaveHotkeys();
+void SaveHotkeys(const HeroSaveData &hero);
 void SaveHeroItems(PlayerStruct &pPlayer);
+void SaveHeroItems(const HeroSaveData &hero);
 void SaveGameData();
 void SaveGame();
 void SaveLevel();
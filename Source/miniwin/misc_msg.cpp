@@ -313,6 +313,20 @@ bool FetchMessage(tagMSG *lpMsg)
 		return false;
 	}
 
+#ifndef USE_SDL1
+	// Only the latest cursor position matters, so fold a run of queued motion events into one
+	if (e.type == SDL_MOUSEMOTION) {
+		SDL_Event next;
+		while (SDL_PeepEvents(&next, 1, SDL_PEEKEVENT, SDL_FIRSTEVENT, SDL_LASTEVENT) == 1
+		    && next.type == SDL_MOUSEMOTION && next.motion.which == e.motion.which) {
+			SDL_PeepEvents(&next, 1, SDL_GETEVENT, SDL_MOUSEMOTION, SDL_MOUSEMOTION);
+			next.motion.xrel += e.motion.xrel;
+			next.motion.yrel += e.motion.yrel;
+			e = next;
+		}
+	}
+#endif
+
 	lpMsg->message = 0;
 	lpMsg->lParam = 0;
 	lpMsg->wParam = 0;
@@ -528,10 +542,14 @@ bool FetchMessage(tagMSG *lpMsg)
 	case SDL_WINDOWEVENT:
 		switch (e.window.event) {
 		case SDL_WINDOWEVENT_SHOWN:
+		case SDL_WINDOWEVENT_RESTORED:
+		case SDL_WINDOWEVENT_MAXIMIZED:
 			gbActive = true;
 			lpMsg->message = DVL_WM_PAINT;
 			break;
 		case SDL_WINDOWEVENT_HIDDEN:
+		case SDL_WINDOWEVENT_MINIMIZED:
+			// Also sent when Android and Switch put the app in the background
 			gbActive = false;
 			break;
 		case SDL_WINDOWEVENT_EXPOSED:
@@ -545,9 +563,6 @@ bool FetchMessage(tagMSG *lpMsg)
 			break;
 		case SDL_WINDOWEVENT_MOVED:
 		case SDL_WINDOWEVENT_RESIZED:
-		case SDL_WINDOWEVENT_MINIMIZED:
-		case SDL_WINDOWEVENT_MAXIMIZED:
-		case SDL_WINDOWEVENT_RESTORED:
 		case SDL_WINDOWEVENT_FOCUS_GAINED:
 		case SDL_WINDOWEVENT_FOCUS_LOST:
 #if SDL_VERSION_ATLEAST(2, 0, 5)
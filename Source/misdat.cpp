@@ -10,7 +10,7 @@
 namespace devilution {
 
 /** Data related to each missile ID. */
-MissileData missiledata[] = {
+const MissileData missiledata[] = {
 	// clang-format off
 	// mAddProc,                   mProc,              mName,             mDraw, mType, mResist,        mFileNum,        miSFX,       mlSFX;
 	{  &AddArrow,                  &MI_Arrow,          MIS_ARROW,         true,      0, MISR_NONE,      MFILE_ARROWS,    SFX_NONE,    SFX_NONE    },
@@ -113,7 +113,7 @@ typedef struct MisFileData {
 	int16_t mAnimWidth2[16];
 } MisFileData;
 
-extern MissileData missiledata[];
+extern const MissileData missiledata[];
 extern MisFileData misfiledata[];
 
 } // namespace devilution
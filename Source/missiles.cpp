@@ -6,6 +6,8 @@
 #include "missiles.h"
 
 #include <climits>
+#include <cstdlib>
+#include <optional>
 
 #include "control.h"
 #include "cursor.h"
@@ -15,6 +17,8 @@
 #include "lighting.h"
 #include "spells.h"
 #include "trigs.h"
+#include "utils/log.hpp"
+#include "utils/profiler.h"
 
 namespace devilution {
 
@@ -32,6 +36,14 @@ const int XDirAdd[8] = { 1, 0, -1, -1, -1, 0, 1, 1 };
 const int YDirAdd[8] = { 1, 1, 1, 0, -1, -1, -1, 0 };
 const int CrawlNum[19] = { 0, 3, 12, 45, 94, 159, 240, 337, 450, 579, 724, 885, 1062, 1255, 1464, 1689, 1930, 2187, 2460 };
 
+/** Element used instead of the missile type's own while a missile checks for hits with a different damage type */
+static std::optional<missile_resistance> MissileResistOverride;
+
+static missile_resistance GetMissileResistance(int mitype)
+{
+	return MissileResistOverride.value_or(missiledata[mitype].mResist);
+}
+
 void GetDamageAmt(int i, int *mind, int *maxd)
 {
 	int k, sl;
@@ -403,31 +415,31 @@ void PutMissile(int i)
 
 void GetMissilePos(int i)
 {
-	int mx, my, dx, dy, lx, ly;
+	MissileStruct &mis = missile[i];
 
-	mx = missile[i].position.traveled.x >> 16;
-	my = missile[i].position.traveled.y >> 16;
-	dx = mx + 2 * my;
-	dy = 2 * my - mx;
-	if (dx < 0) {
-		lx = -(-dx / 8);
-		dx = -(-dx / 64);
-	} else {
-		lx = dx / 8;
-		dx = dx / 64;
-	}
-	if (dy < 0) {
-		ly = -(-dy / 8);
-		dy = -(-dy / 64);
-	} else {
-		ly = dy / 8;
-		dy = dy / 64;
-	}
-	missile[i].position.tile.x = dx + missile[i].position.start.x;
-	missile[i].position.tile.y = dy + missile[i].position.start.y;
-	missile[i].position.offset.x = mx + (dy * 32) - (dx * 32);
-	missile[i].position.offset.y = my - (dx * 16) - (dy * 16);
-	ChangeLightOff(missile[i]._mlid, { lx - (dx * 8), ly - (dy * 8) });
+	const int mx = mis.position.traveled.x >> 16;
+	const int my = mis.position.traveled.y >> 16;
+	int dx = mx + 2 * my;
+	int dy = 2 * my - mx;
+	// Integer division truncates towards zero, so negative distances round the same way as positive ones
+	const int lx = dx / 8;
+	const int ly = dy / 8;
+	dx /= 64;
+	dy /= 64;
+	mis.position.tile = mis.position.start + Point { dx, dy };
+	mis.position.offset.x = mx + (dy * 32) - (dx * 32);
+	mis.position.offset.y = my - (dx * 16) - (dy * 16);
+	if (mis._mlid != NO_LIGHT)
+		ChangeLightOff(mis._mlid, { lx - (dx * 8), ly - (dy * 8) });
+}
+
+/**
+ * @brief Returns the missile's position in screen space, relative to the dungeon origin.
+ */
+static Point GetMissileScreenPosition(const MissileStruct &mis)
+{
+	const Point tile = mis.position.tile;
+	return Point { (tile.x - tile.y) * TILE_WIDTH / 2, (tile.x + tile.y) * TILE_HEIGHT / 2 } + mis.position.offset;
 }
 
 void MoveMissilePos(int i)
@@ -495,7 +507,7 @@ bool MonsterTrapHit(int m, int mindam, int maxdam, int dist, int t, bool shift)
 	if (monster[m]._mmode == MM_CHARGE)
 		return false;
 
-	missile_resistance mir = missiledata[t].mResist;
+	missile_resistance mir = GetMissileResistance(t);
 	mor = monster[m].mMagicRes;
 	if ((mor & IMMUNE_MAGIC && mir == MISR_MAGIC)
 	    || (mor & IMMUNE_FIRE && mir == MISR_FIRE)
@@ -576,7 +588,7 @@ bool MonsterMHit(int pnum, int m, int mindam, int maxdam, int dist, int t, bool
 		return false;
 
 	mor = monster[m].mMagicRes;
-	missile_resistance mir = missiledata[t].mResist;
+	missile_resistance mir = GetMissileResistance(t);
 
 	if ((mor & IMMUNE_MAGIC && mir == MISR_MAGIC)
 	    || (mor & IMMUNE_FIRE && mir == MISR_FIRE)
@@ -755,7 +767,7 @@ bool PlayerMHit(int pnum, int m, int dist, int mind, int maxd, int mtype, bool s
 	if (blkper > 100)
 		blkper = 100;
 
-	switch (missiledata[mtype].mResist) {
+	switch (GetMissileResistance(mtype)) {
 	case MISR_FIRE:
 		resper = plr[pnum]._pFireResist;
 		break;
@@ -846,7 +858,7 @@ bool Plr2PlrMHit(int pnum, int p, int mindam, int maxdam, int dist, int mtype, b
 		return false;
 	}
 
-	switch (missiledata[mtype].mResist) {
+	switch (GetMissileResistance(mtype)) {
 	case MISR_FIRE:
 		resper = plr[p]._pFireResist;
 		break;
@@ -936,18 +948,14 @@ bool Plr2PlrMHit(int pnum, int p, int mindam, int maxdam, int dist, int mtype, b
 	return false;
 }
 
-void CheckMissileCol(int i, int mindam, int maxdam, bool shift, int mx, int my, bool nodel)
+/**
+ * @brief Apply a missile to the monster and player on an occupied tile
+ */
+static void CheckMissileHits(int i, int mindam, int maxdam, bool shift, int mx, int my, bool nodel)
 {
-	int oi;
 	bool blocked;
 	int dir, mAnimFAmt;
 
-	if (i >= MAXMISSILES || i < 0)
-		return;
-	if (mx >= MAXDUNX || mx < 0)
-		return;
-	if (my >= MAXDUNY || my < 0)
-		return;
 	if (missile[i]._micaster != TARGET_BOTH && missile[i]._misource != -1) {
 		if (missile[i]._micaster == TARGET_MONSTERS) {
 			if (dMonster[mx][my] > 0) {
@@ -1087,6 +1095,21 @@ void CheckMissileCol(int i, int mindam, int maxdam, bool shift, int mx, int my,
 			}
 		}
 	}
+}
+
+void CheckMissileCol(int i, int mindam, int maxdam, bool shift, int mx, int my, bool nodel)
+{
+	int oi;
+
+	if (i >= MAXMISSILES || i < 0)
+		return;
+	if (mx >= MAXDUNX || mx < 0)
+		return;
+	if (my >= MAXDUNY || my < 0)
+		return;
+	// Most of the tiles swept by novas, waves and chains are empty
+	if (dMonster[mx][my] != 0 || dPlayer[mx][my] > 0)
+		CheckMissileHits(i, mindam, maxdam, shift, mx, my, nodel);
 	if (dObject[mx][my] != 0) {
 		oi = dObject[mx][my] > 0 ? dObject[mx][my] - 1 : -(dObject[mx][my] + 1);
 		if (!object[oi]._oMissFlag) {
@@ -1106,6 +1129,13 @@ void CheckMissileCol(int i, int mindam, int maxdam, bool shift, int mx, int my,
 		PlaySfxLoc(missiledata[missile[i]._mitype].miSFX, missile[i].position.tile.x, missile[i].position.tile.y);
 }
 
+static void CheckMissileColAs(missile_resistance resistance, int i, int mindam, int maxdam, int mx, int my, bool nodel)
+{
+	MissileResistOverride = resistance;
+	CheckMissileCol(i, mindam, maxdam, false, mx, my, nodel);
+	MissileResistOverride = std::nullopt;
+}
+
 void SetMissAnim(int mi, int animtype)
 {
 	int dir = missile[mi]._mimfnum;
@@ -1211,7 +1241,7 @@ void FreeMissiles2()
 
 void InitMissiles()
 {
-	int mi, src, i, j;
+	int mi, src, i;
 
 	AutoMapShowItems = false;
 	plr[myplr]._pSpellFlags &= ~0x1;
@@ -1252,11 +1282,7 @@ void InitMissiles()
 		chain[i]._mitype = 0;
 		chain[i]._mirange = 0;
 	}
-	for (j = 0; j < MAXDUNY; j++) {
-		for (i = 0; i < MAXDUNX; i++) {
-			dFlags[i][j] &= ~BFLAG_MISSILE;
-		}
-	}
+	ClearDungeonFlags({ { 0, 0 }, { MAXDUNX, MAXDUNY } }, BFLAG_MISSILE);
 	plr[myplr].wReflections = 0;
 }
 
@@ -1424,6 +1450,7 @@ void AddBerserk(int mi, int sx, int sy, int dx, int dy, int midir, int8_t mienem
 										j = 6;
 										auto slvl = static_cast<double>(GetSpellLevel(id, SPL_BERSERK));
 										monster[dm]._mFlags |= MFLAG_BERSERK | MFLAG_GOLEM;
+										InvalidateMonsterTargets();
 										monster[dm].mMinDamage = ((double)(GenerateRnd(10) + 20) / 100 + 1) * (double)monster[dm].mMinDamage + slvl;
 										monster[dm].mMaxDamage = ((double)(GenerateRnd(10) + 20) / 100 + 1) * (double)monster[dm].mMaxDamage + slvl;
 										monster[dm].mMinDamage2 = ((double)(GenerateRnd(10) + 20) / 100 + 1) * (double)monster[dm].mMinDamage2 + slvl;
@@ -2289,6 +2316,9 @@ void AddTown(int mi, int sx, int sy, int dx, int dy, int midir, int8_t mienemy,
 {
 	int i, j, k, mx, tx, ty, dp;
 
+	if (id == myplr)
+		PrefetchLvlGFX(0);
+
 	if (currlevel != 0) {
 		missile[mi]._miDelFlag = true;
 		for (j = 0; j < 6; j++) {
@@ -2494,6 +2524,7 @@ void AddMetlHit(int mi, int sx, int sy, int dx, int dy, int midir, int8_t mienem
 namespace {
 void InitMissileAnimationFromMonster(MissileStruct &mis, int midir, const MonsterStruct &mon, int graphic)
 {
+	LoadMonsterAnim(*mon.MType, graphic);
 	const AnimStruct &anim = mon.MType->Anims[graphic];
 	mis._mimfnum = midir;
 	mis._miAnimFlags = 0;
@@ -3153,12 +3184,14 @@ void AddDiabApoca(int mi, int sx, int sy, int dx, int dy, int midir, int8_t mien
 	missile[mi]._miDelFlag = true;
 }
 
-int AddMissile(int sx, int sy, int dx, int dy, int midir, int mitype, int8_t micaster, int id, int midam, int spllvl)
+int AddMissile(int sx, int sy, int dx, int dy, int midir, int mitype, int8_t micaster, int id, int midam, int spllvl, bool launchSound)
 {
 	int i, mi;
 
-	if (nummissiles >= MAXMISSILES - 1)
+	if (nummissiles >= MAXMISSILES - 1) {
+		LogVerbose("Missile limit reached, dropping missile type {}", mitype);
 		return -1;
+	}
 
 	if (mitype == MIS_MANASHIELD && plr[id].pManaShield) {
 		if (currlevel != plr[id].plrlevel)
@@ -3207,7 +3240,7 @@ int AddMissile(int sx, int sy, int dx, int dy, int midir, int mitype, int8_t mic
 	missile[mi]._mlid = NO_LIGHT;
 	missile[mi]._mirnd = 0;
 
-	if (missiledata[mitype].mlSFX != -1) {
+	if (launchSound && missiledata[mitype].mlSFX != -1) {
 		PlaySfxLoc(missiledata[mitype].mlSFX, missile[mi].position.start.x, missile[mi].position.start.y);
 	}
 
@@ -3279,7 +3312,6 @@ void MI_LArrow(int i)
 	p = missile[i]._misource;
 	if (missile[i]._miAnimType == MFILE_MINILTNG || missile[i]._miAnimType == MFILE_MAGBLOS) {
 		ChangeLight(missile[i]._mlid, missile[i].position.tile, missile[i]._miAnimFrame + 5);
-		missile_resistance rst = missiledata[missile[i]._mitype].mResist;
 		if (missile[i]._mitype == MIS_LARROW) {
 			if (p != -1) {
 				mind = plr[p]._pILMinDam;
@@ -3288,8 +3320,7 @@ void MI_LArrow(int i)
 				mind = GenerateRnd(10) + 1 + currlevel;
 				maxd = GenerateRnd(10) + 1 + currlevel * 2;
 			}
-			missiledata[MIS_LARROW].mResist = MISR_LIGHTNING;
-			CheckMissileCol(i, mind, maxd, false, missile[i].position.tile.x, missile[i].position.tile.y, true);
+			CheckMissileColAs(MISR_LIGHTNING, i, mind, maxd, missile[i].position.tile.x, missile[i].position.tile.y, true);
 		}
 		if (missile[i]._mitype == MIS_FARROW) {
 			if (p != -1) {
@@ -3299,10 +3330,8 @@ void MI_LArrow(int i)
 				mind = GenerateRnd(10) + 1 + currlevel;
 				maxd = GenerateRnd(10) + 1 + currlevel * 2;
 			}
-			missiledata[MIS_FARROW].mResist = MISR_FIRE;
-			CheckMissileCol(i, mind, maxd, false, missile[i].position.tile.x, missile[i].position.tile.y, true);
+			CheckMissileColAs(MISR_FIRE, i, mind, maxd, missile[i].position.tile.x, missile[i].position.tile.y, true);
 		}
-		missiledata[missile[i]._mitype].mResist = rst;
 	} else {
 		missile[i]._midist++;
 		missile[i].position.traveled += missile[i].position.velocity;
@@ -3322,10 +3351,7 @@ void MI_LArrow(int i)
 		}
 
 		if (missile[i].position.tile != missile[i].position.start) {
-			missile_resistance rst = missiledata[missile[i]._mitype].mResist;
-			missiledata[missile[i]._mitype].mResist = MISR_NONE;
-			CheckMissileCol(i, mind, maxd, false, missile[i].position.tile.x, missile[i].position.tile.y, false);
-			missiledata[missile[i]._mitype].mResist = rst;
+			CheckMissileColAs(MISR_NONE, i, mind, maxd, missile[i].position.tile.x, missile[i].position.tile.y, false);
 		}
 		if (missile[i]._mirange == 0) {
 			missile[i]._mimfnum = 0;
@@ -4447,6 +4473,7 @@ void MI_Blood(int i)
 void MI_Weapexp(int i)
 {
 	int id, mind, maxd;
+	missile_resistance resist;
 	int ExpLight[10] = { 9, 10, 11, 12, 11, 10, 8, 6, 4, 2 };
 
 	missile[i]._mirange--;
@@ -4454,13 +4481,13 @@ void MI_Weapexp(int i)
 	if (missile[i]._miVar2 == 1) {
 		mind = plr[id]._pIFMinDam;
 		maxd = plr[id]._pIFMaxDam;
-		missiledata[missile[i]._mitype].mResist = MISR_FIRE;
+		resist = MISR_FIRE;
 	} else {
 		mind = plr[id]._pILMinDam;
 		maxd = plr[id]._pILMaxDam;
-		missiledata[missile[i]._mitype].mResist = MISR_LIGHTNING;
+		resist = MISR_LIGHTNING;
 	}
-	CheckMissileCol(i, mind, maxd, false, missile[i].position.tile.x, missile[i].position.tile.y, false);
+	CheckMissileColAs(resist, i, mind, maxd, missile[i].position.tile.x, missile[i].position.tile.y, false);
 	if (missile[i]._miVar1 == 0) {
 		missile[i]._mlid = AddLight(missile[i].position.tile, 9);
 	} else {
@@ -5122,32 +5149,50 @@ void MI_Rportal(int i)
 	PutMissile(i);
 }
 
+/**
+ * @brief Remove the missiles flagged for deletion in a single pass
+ *
+ * The missile moved into a freed slot is checked next, so the missiles end up in the same order
+ * as when restarting the search from the first missile after every deletion.
+ */
+static void DeleteFlaggedMissiles()
+{
+	int i = 0;
+	while (i < nummissiles) {
+		if (missile[missileactive[i]]._miDelFlag)
+			DeleteMissile(missileactive[i], i);
+		else
+			i++;
+	}
+}
+
 void ProcessMissiles()
 {
+	ProfileScope profileScope(ProfilePhase::ProcessMissiles);
+
 	int i, mi;
 
 	for (i = 0; i < nummissiles; i++) {
-		dFlags[missile[missileactive[i]].position.tile.x][missile[missileactive[i]].position.tile.y] &= ~BFLAG_MISSILE;
-		dMissile[missile[missileactive[i]].position.tile.x][missile[missileactive[i]].position.tile.y] = 0;
-		if (missile[missileactive[i]].position.tile.x < 0 || missile[missileactive[i]].position.tile.x >= MAXDUNX - 1 || missile[missileactive[i]].position.tile.y < 0 || missile[missileactive[i]].position.tile.y >= MAXDUNY - 1)
-			missile[missileactive[i]]._miDelFlag = true;
+		MissileStruct &mis = missile[missileactive[i]];
+		dFlags[mis.position.tile.x][mis.position.tile.y] &= ~BFLAG_MISSILE;
+		dMissile[mis.position.tile.x][mis.position.tile.y] = 0;
+		if (mis.position.tile.x < 0 || mis.position.tile.x >= MAXDUNX - 1 || mis.position.tile.y < 0 || mis.position.tile.y >= MAXDUNY - 1)
+			mis._miDelFlag = true;
 	}
 
-	i = 0;
-	while (i < nummissiles) {
-		if (missile[missileactive[i]]._miDelFlag) {
-			DeleteMissile(missileactive[i], i);
-			i = 0;
-		} else {
-			i++;
-		}
-	}
+	DeleteFlaggedMissiles();
 
 	MissilePreFlag = false;
 
 	for (i = 0; i < nummissiles; i++) {
 		mi = missileactive[i];
+		const Point screenPosition = GetMissileScreenPosition(missile[mi]);
 		missiledata[missile[mi]._mitype].mProc(missileactive[i]);
+		Point &lastStep = missile[mi].position.lastStep;
+		lastStep = GetMissileScreenPosition(missile[mi]) - screenPosition;
+		// Anything further than a tile was relocated rather than moved
+		if (std::abs(lastStep.x) > TILE_WIDTH || std::abs(lastStep.y) > TILE_HEIGHT)
+			lastStep = { 0, 0 };
 		if ((missile[mi]._miAnimFlags & MFLAG_LOCK_ANIMATION) == 0) {
 			missile[mi]._miAnimCnt++;
 			if (missile[mi]._miAnimCnt >= missile[mi]._miAnimDelay) {
@@ -5161,15 +5206,7 @@ void ProcessMissiles()
 		}
 	}
 
-	i = 0;
-	while (i < nummissiles) {
-		if (missile[missileactive[i]]._miDelFlag) {
-			DeleteMissile(missileactive[i], i);
-			i = 0;
-		} else {
-			i++;
-		}
-	}
+	DeleteFlaggedMissiles();
 }
 
 void missiles_process_charge()
@@ -5193,6 +5230,7 @@ void missiles_process_charge()
 				else
 					anim = &mon->Anims[MA_WALK];
 			}
+			LoadMonsterAnim(*mon, static_cast<int>(anim - mon->Anims));
 			missile[mi]._miAnimData = anim->CelSpritesForDirections[mis->_mimfnum]->Data();
 		}
 	}
@@ -32,6 +32,8 @@ struct MissilePosition {
 	Point start;
 	/** Start position */
 	Point traveled;
+	/** Screen distance moved during the last game tick, used to place the sprite between ticks */
+	Point lastStep;
 };
 
 struct MissileStruct {
@@ -83,6 +85,10 @@ void GetDamageAmt(int i, int *mind, int *maxd);
 int GetSpellLevel(int id, spell_id sn);
 int GetDirection16(int x1, int y1, int x2, int y2);
 void DeleteMissile(int mi, int i);
+/**
+ * @brief Update the tile and offset of a missile from the distance it traveled since its start
+ */
+void GetMissilePos(int i);
 bool MonsterTrapHit(int m, int mindam, int maxdam, int dist, int t, bool shift);
 bool PlayerMHit(int pnum, int m, int dist, int mind, int maxd, int mtype, bool shift, int earflag, bool *blocked);
 void SetMissAnim(int mi, int animtype);
@@ -175,7 +181,7 @@ void AddTelekinesis(int mi, int sx, int sy, int dx, int dy, int midir, int8_t mi
 void AddBoneSpirit(int mi, int sx, int sy, int dx, int dy, int midir, int8_t mienemy, int id, int dam);
 void AddRportal(int mi, int sx, int sy, int dx, int dy, int midir, int8_t mienemy, int id, int dam);
 void AddDiabApoca(int mi, int sx, int sy, int dx, int dy, int midir, int8_t mienemy, int id, int dam);
-int AddMissile(int sx, int sy, int dx, int dy, int midir, int mitype, int8_t micaster, int id, int midam, int spllvl);
+int AddMissile(int sx, int sy, int dx, int dy, int midir, int mitype, int8_t micaster, int id, int midam, int spllvl, bool launchSound = true);
 void MI_Dummy(int i);
 void MI_Golem(int i);
 void MI_Manashield(int i);
@@ -8,6 +8,11 @@
 #include <algorithm>
 #include <array>
 #include <climits>
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
 
 #include <fmt/format.h>
 
@@ -17,6 +22,7 @@
 #include "drlg_l1.h"
 #include "drlg_l4.h"
 #include "engine/render/cl2_render.hpp"
+#include "flowfield.h"
 #include "init.h"
 #include "lighting.h"
 #include "minitext.h"
@@ -27,7 +33,11 @@
 #include "themes.h"
 #include "towners.h"
 #include "trigs.h"
+#include "utils/file_prefetch.h"
 #include "utils/language.h"
+#include "utils/log.hpp"
+#include "utils/memory_stats.h"
+#include "utils/profiler.h"
 
 #ifdef _DEBUG
 #include "debug.h"
@@ -51,11 +61,42 @@ int monstactive[MAXMONSTERS];
 int nummonsters;
 bool sgbSaveSoundOn;
 MonsterStruct monster[MAXMONSTERS];
+static_assert(offsetof(MonsterStruct, position) + sizeof(Point) <= 64, "The per tick state of a monster should fit in one cache line");
 int totalmonsters;
 CMonster Monsters[MAX_LVLMTYPES];
 int monstimgtot;
 int uniquetrans;
 int nummtypes;
+/** Number of M_Enemy target searches, read by the benchmarks */
+uint32_t gnEnemyScans;
+
+namespace {
+
+/** Monsters with MFLAG_GOLEM in the order of monstactive, see UpdateMonsterTargets */
+int MonsterTargets[MAXMONSTERS];
+int NumMonsterTargets;
+bool MonsterTargetsValid;
+
+/** Further away than any light radius, so a monster this far from every player can't be seen by them */
+constexpr int MonsterWakeDistance = 20;
+
+/** Set while the types of a level are chosen, so their graphics can be loaded all at once */
+bool DeferMonsterGFX;
+
+struct MonsterSheet {
+	std::unique_ptr<byte[]> data;
+	size_t size;
+	/** Number of monster types of the current level using the sheet */
+	int refs;
+	/** MonsterSheetClock when the sheet was last used, the oldest unused sheets are dropped first */
+	uint32_t lastUse;
+};
+
+/** CL2 sheets of the monster animations by path, recolored sheets also by their TRN file */
+std::unordered_map<std::string, MonsterSheet> MonsterSheets;
+uint32_t MonsterSheetClock;
+
+} // namespace
 
 /** Maps from monster intelligence factor to missile type. */
 const BYTE counsmiss[4] = { MIS_FIREBOLT, MIS_CBOLT, MIS_LIGHTCTRL, MIS_FIREBALL };
@@ -142,32 +183,12 @@ void (*AiProc[])(int i) = {
 	&MAI_BoneDemon
 };
 
-void InitMonsterTRN(CMonster &monst)
-{
-	std::array<uint8_t, 256> colorTranslations;
-	LoadFileInMem(monst.MData->TransFile, colorTranslations);
-
-	std::replace(colorTranslations.begin(), colorTranslations.end(), 255, 0);
-
-	int n = monst.MData->has_special ? 6 : 5;
-	for (int i = 0; i < n; i++) {
-		if (i == 1 && monst.mtype >= MT_COUNSLR && monst.mtype <= MT_ADVOCATE) {
-			continue;
-		}
-
-		for (int j = 0; j < 8; j++) {
-			Cl2ApplyTrans(
-			    CelGetFrameStart(monst.Anims[i].CMem.get(), j),
-			    colorTranslations,
-			    monst.Anims[i].Frames);
-		}
-	}
-}
-
 void InitLevelMonsters()
 {
 	int i;
 
+	// The sounds are loaded on demand, they must not outlive the type they were loaded for
+	FreeMonsterSnd();
 	nummtypes = 0;
 	monstimgtot = 0;
 	MissileFileFlag = 0;
@@ -178,6 +199,7 @@ void InitLevelMonsters()
 
 	ClrAllMonsters();
 	nummonsters = 0;
+	InvalidateMonsterTargets();
 	totalmonsters = MAXMONSTERS;
 
 	for (i = 0; i < MAXMONSTERS; i++) {
@@ -203,15 +225,15 @@ int AddMonsterType(_monster_id type, placeflag placeflag)
 		nummtypes++;
 		Monsters[i].mtype = type;
 		monstimgtot += monsterdata[type].mImage;
-		InitMonsterGFX(i);
-		InitMonsterSND(i);
+		if (!DeferMonsterGFX)
+			InitMonsterGFX(i);
 	}
 
 	Monsters[i].mPlaceFlags |= placeflag;
 	return i;
 }
 
-void GetLevelMTypes()
+static void AddLevelMonsterTypes()
 {
 	int i;
 
@@ -331,40 +353,121 @@ void GetLevelMTypes()
 	}
 }
 
-void InitMonsterGFX(int monst)
+static int GetMonsterAnimFrames(int mtype, int anim)
+{
+	if (gbIsHellfire && mtype == MT_DIABLO && anim == 3)
+		return 2;
+	return monsterdata[mtype].Frames[anim];
+}
+
+static bool HasMonsterSheet(int mtype, int anim)
+{
+	return (animletter[anim] != 's' || monsterdata[mtype].has_special) && GetMonsterAnimFrames(mtype, anim) > 0;
+}
+
+/**
+ * @brief Whether the sheet of the animation is only loaded once a monster plays it, see LoadMonsterAnim
+ *
+ * Standing and walking are needed as soon as the level is shown and the deaths for the corpses of the level.
+ */
+static bool IsDeferredMonsterAnim(int anim)
+{
+	return anim == MA_ATTACK || anim == MA_GOTHIT || anim == MA_SPECIAL;
+}
+
+static std::string GetMonsterSheetKey(int mtype, int anim)
 {
-	int mtype, anim, i;
-	char strBuff[256];
+	char path[256];
+	sprintf(path, monsterdata[mtype].GraphicType, animletter[anim]);
+	std::string key = path;
+	if (monsterdata[mtype].has_trans) {
+		key += '|';
+		key += monsterdata[mtype].TransFile;
+	}
+	return key;
+}
+
+static void LoadMonsterTRN(int mtype, std::array<uint8_t, 256> &colorTranslations)
+{
+	LoadFileInMem(monsterdata[mtype].TransFile, colorTranslations);
+	std::replace(colorTranslations.begin(), colorTranslations.end(), 255, 0);
+}
+
+/**
+ * @brief Recolor a freshly loaded sheet with the TRN of its monster type
+ */
+static void ApplyMonsterTRN(int mtype, int anim, byte *celBuf, const std::array<uint8_t, 256> &colorTranslations)
+{
+	if (anim == 1 && mtype >= MT_COUNSLR && mtype <= MT_ADVOCATE) {
+		return;
+	}
+
+	for (int j = 0; j < 8; j++) {
+		Cl2ApplyTrans(
+		    CelGetFrameStart(celBuf, j),
+		    colorTranslations,
+		    GetMonsterAnimFrames(mtype, anim));
+	}
+}
+
+/**
+ * @brief Drop the oldest sheets the current level doesn't use until the rest fits `GraphicsOptions::nMonsterSpriteCacheSize`
+ */
+static void TrimMonsterSheets()
+{
+	const size_t budget = static_cast<size_t>(sgOptions.Graphics.nMonsterSpriteCacheSize) * 1024;
+	size_t unused = 0;
+	for (const auto &entry : MonsterSheets) {
+		if (entry.second.refs == 0)
+			unused += entry.second.size;
+	}
+
+	while (unused > budget) {
+		auto oldest = MonsterSheets.end();
+		for (auto it = MonsterSheets.begin(); it != MonsterSheets.end(); ++it) {
+			if (it->second.refs == 0 && (oldest == MonsterSheets.end() || it->second.lastUse < oldest->second.lastUse))
+				oldest = it;
+		}
+		unused -= oldest->second.size;
+		MonsterSheets.erase(oldest);
+	}
+}
+
+static void InitMonsterAnimSprites(CMonster &monsterType, int anim)
+{
+	const int width = monsterdata[monsterType.mtype].width;
+	AnimStruct &animation = monsterType.Anims[anim];
+	byte *celBuf = animation.CMem;
+
+	if (monsterType.mtype != MT_GOLEM || (animletter[anim] != 's' && animletter[anim] != 'd')) {
+		for (int i = 0; i < 8; i++) {
+			byte *pCelStart = CelGetFrameStart(celBuf, i);
+			animation.CelSpritesForDirections[i].emplace(pCelStart, width);
+		}
+	} else {
+		for (int i = 0; i < 8; i++) {
+			animation.CelSpritesForDirections[i].emplace(celBuf, width);
+		}
+	}
+}
+
+/**
+ * @brief Set up a monster type once the sheets of its animations are loaded
+ */
+static void FinishMonsterGFX(int monst)
+{
+	int mtype, anim;
 
 	mtype = Monsters[monst].mtype;
-	int width = monsterdata[mtype].width;
 
 	for (anim = 0; anim < 6; anim++) {
-		int frames = monsterdata[mtype].Frames[anim];
-		if (gbIsHellfire && mtype == MT_DIABLO && anim == 3)
-			frames = 2;
-
-		if ((animletter[anim] != 's' || monsterdata[mtype].has_special) && frames > 0) {
-			sprintf(strBuff, monsterdata[mtype].GraphicType, animletter[anim]);
-
-			byte *celBuf;
-			{
-				auto celData = LoadFileInMem(strBuff);
-				celBuf = celData.get();
-				Monsters[monst].Anims[anim].CMem = std::move(celData);
-			}
-
-			if (Monsters[monst].mtype != MT_GOLEM || (animletter[anim] != 's' && animletter[anim] != 'd')) {
+		int frames = GetMonsterAnimFrames(mtype, anim);
 
-				for (i = 0; i < 8; i++) {
-					byte *pCelStart = CelGetFrameStart(celBuf, i);
-					Monsters[monst].Anims[anim].CelSpritesForDirections[i].emplace(pCelStart, width);
-				}
-			} else {
-				for (i = 0; i < 8; i++) {
-					Monsters[monst].Anims[anim].CelSpritesForDirections[i].emplace(celBuf, width);
-				}
-			}
+		if (Monsters[monst].Anims[anim].CMem != nullptr) {
+			InitMonsterAnimSprites(Monsters[monst], anim);
+		} else {
+			for (auto &celSprite : Monsters[monst].Anims[anim].CelSpritesForDirections)
+				celSprite = std::nullopt;
 		}
 
 		Monsters[monst].Anims[anim].Frames = frames;
@@ -381,10 +484,6 @@ void InitMonsterGFX(int monst)
 	Monsters[monst].mAFNum = monsterdata[mtype].mAFNum;
 	Monsters[monst].MData = &monsterdata[mtype];
 
-	if (monsterdata[mtype].has_trans) {
-		InitMonsterTRN(Monsters[monst]);
-	}
-
 	if (mtype >= MT_NMAGMA && mtype <= MT_WMAGMA && !(MissileFileFlag & 1)) {
 		MissileFileFlag |= 1;
 		LoadMissileGFX(MFILE_MAGBALL);
@@ -459,6 +558,128 @@ void InitMonsterGFX(int monst)
 	}
 }
 
+/**
+ * @brief Load the graphics of the monster types in [first, first + count)
+ *
+ * The deferred animations are only set up here if their sheets are still cached from an earlier level.
+ */
+static void InitMonstersGFX(int first, int count)
+{
+	struct SheetLoad {
+		int monst;
+		int anim;
+		MonsterSheet *sheet;
+	};
+	std::vector<SheetLoad> sheetUses;
+	std::vector<SheetLoad> sheetLoads;
+	std::vector<std::array<uint8_t, 256>> colorTranslations(count);
+
+	for (int monst = first; monst < first + count; monst++) {
+		const int mtype = Monsters[monst].mtype;
+		bool needsTranslations = false;
+		for (int anim = 0; anim < 6; anim++) {
+			if (!HasMonsterSheet(mtype, anim))
+				continue;
+			const std::string key = GetMonsterSheetKey(mtype, anim);
+			if (IsDeferredMonsterAnim(anim)) {
+				auto cached = MonsterSheets.find(key);
+				if (cached == MonsterSheets.end() || cached->second.data == nullptr)
+					continue;
+			}
+
+			MonsterSheet &sheet = MonsterSheets[key];
+			if (sheet.data == nullptr && sheet.refs == 0) {
+				sheetLoads.push_back({ monst, anim, &sheet });
+				needsTranslations = needsTranslations || monsterdata[mtype].has_trans;
+			}
+			sheet.refs++;
+			sheet.lastUse = ++MonsterSheetClock;
+			sheetUses.push_back({ monst, anim, &sheet });
+		}
+
+		if (needsTranslations)
+			LoadMonsterTRN(mtype, colorTranslations[monst - first]);
+	}
+
+	// The sheets that aren't cached don't depend on each other, read the ones of all types at once
+	ParallelLoad(sheetLoads.size(), [&](unsigned j) {
+		MemoryTagScope memoryTag(MemoryTag::MonsterSheets);
+		const SheetLoad &load = sheetLoads[j];
+		const int mtype = Monsters[load.monst].mtype;
+		char path[256];
+		sprintf(path, monsterdata[mtype].GraphicType, animletter[load.anim]);
+		load.sheet->data = LoadFileInMem(path, &load.sheet->size);
+		if (monsterdata[mtype].has_trans)
+			ApplyMonsterTRN(mtype, load.anim, load.sheet->data.get(), colorTranslations[load.monst - first]);
+	});
+
+	for (const SheetLoad &use : sheetUses)
+		Monsters[use.monst].Anims[use.anim].CMem = use.sheet->data.get();
+
+	for (int monst = first; monst < first + count; monst++)
+		FinishMonsterGFX(monst);
+}
+
+void InitMonsterGFX(int monst)
+{
+	InitMonstersGFX(monst, 1);
+}
+
+void LoadMonsterAnim(CMonster &monsterType, int anim)
+{
+	const int mtype = monsterType.mtype;
+	AnimStruct &animation = monsterType.Anims[anim];
+	if (animation.CMem != nullptr || !HasMonsterSheet(mtype, anim))
+		return;
+
+	MonsterSheet &sheet = MonsterSheets[GetMonsterSheetKey(mtype, anim)];
+	if (sheet.data == nullptr) {
+		MemoryTagScope memoryTag(MemoryTag::MonsterSheets);
+		char path[256];
+		sprintf(path, monsterdata[mtype].GraphicType, animletter[anim]);
+		sheet.data = LoadFileInMem(path, &sheet.size);
+		if (monsterdata[mtype].has_trans) {
+			std::array<uint8_t, 256> colorTranslations;
+			LoadMonsterTRN(mtype, colorTranslations);
+			ApplyMonsterTRN(mtype, anim, sheet.data.get(), colorTranslations);
+		}
+	}
+	sheet.refs++;
+	sheet.lastUse = ++MonsterSheetClock;
+
+	animation.CMem = sheet.data.get();
+	InitMonsterAnimSprites(monsterType, anim);
+}
+
+/**
+ * @brief Start reading the deferred sheets of a monster type that aren't loaded yet, so they are ready once they are played
+ */
+static void PrefetchMonsterAnims(const CMonster &monsterType)
+{
+	const int mtype = monsterType.mtype;
+	for (int anim : { MA_ATTACK, MA_GOTHIT, MA_SPECIAL }) {
+		if (monsterType.Anims[anim].CMem != nullptr || !HasMonsterSheet(mtype, anim))
+			continue;
+		auto cached = MonsterSheets.find(GetMonsterSheetKey(mtype, anim));
+		if (cached != MonsterSheets.end() && cached->second.data != nullptr)
+			continue;
+		char path[256];
+		sprintf(path, monsterdata[mtype].GraphicType, animletter[anim]);
+		PrefetchFile(path);
+	}
+}
+
+void GetLevelMTypes()
+{
+	const int first = nummtypes;
+
+	DeferMonsterGFX = true;
+	AddLevelMonsterTypes();
+	DeferMonsterGFX = false;
+
+	InitMonstersGFX(first, nummtypes - first);
+}
+
 void ClearMVars(int i)
 {
 	monster[i]._mVar1 = 0;
@@ -529,9 +750,11 @@ void InitMonster(int i, Direction rd, int mtype, Point position)
 	monster[i].leader = 0;
 	monster[i].leaderflag = 0;
 	monster[i]._mFlags = monst->MData->mFlags;
+	InvalidateMonsterTargets();
 	monster[i].mtalkmsg = TEXT_NONE;
 
 	if (monster[i]._mAi == AI_GARG) {
+		LoadMonsterAnim(*monst, MA_SPECIAL);
 		monster[i]._mAnimData = &*monst->Anims[MA_SPECIAL].CelSpritesForDirections[rd];
 		monster[i]._mAnimFrame = 1;
 		monster[i]._mFlags |= MFLAG_ALLOW_SPECIAL;
@@ -1017,6 +1240,7 @@ void PlaceGroup(int mtype, int num, int leaderf, int leader)
 	for (try1 = 0; try1 < 10; try1++) {
 		while (placed) {
 			nummonsters--;
+			InvalidateMonsterTargets();
 			placed--;
 			dMonster[monster[nummonsters].position.tile.x][monster[nummonsters].position.tile.y] = 0;
 		}
@@ -1222,6 +1446,12 @@ void DeleteMonster(int i)
 	temp = monstactive[nummonsters];
 	monstactive[nummonsters] = monstactive[i];
 	monstactive[i] = temp;
+	InvalidateMonsterTargets();
+}
+
+void InvalidateMonsterTargets()
+{
+	MonsterTargetsValid = false;
 }
 
 int AddMonster(Point position, Direction dir, int mtype, bool InMap)
@@ -1234,6 +1464,7 @@ int AddMonster(Point position, Direction dir, int mtype, bool InMap)
 		return i;
 	}
 
+	LogVerbose("Monster limit reached, dropping monster type {}", mtype);
 	return -1;
 }
 
@@ -1269,6 +1500,7 @@ void monster_43C785(int i)
 void NewMonsterAnim(int i, AnimStruct *anim, Direction md)
 {
 	MonsterStruct *Monst = &monster[i];
+	LoadMonsterAnim(*Monst->MType, static_cast<int>(anim - Monst->MType->Anims));
 	Monst->_mAnimData = &*anim->CelSpritesForDirections[md];
 	Monst->_mAnimLen = anim->Frames;
 	Monst->_mAnimCnt = 0;
@@ -1296,6 +1528,49 @@ bool M_Talker(int i)
 	    || ai == AI_LAZHELP;
 }
 
+/**
+ * @brief Collect the monsters with MFLAG_GOLEM, in the order of monstactive.
+ */
+static void UpdateMonsterTargets()
+{
+	if (MonsterTargetsValid)
+		return;
+
+	NumMonsterTargets = 0;
+	for (int j = 0; j < nummonsters; j++) {
+		const int mi = monstactive[j];
+		if ((monster[mi]._mFlags & MFLAG_GOLEM) != 0)
+			MonsterTargets[NumMonsterTargets++] = mi;
+	}
+	MonsterTargetsValid = true;
+}
+
+/**
+ * @brief Check if a monster has nothing to do this tick because it is idle and no player is close to it.
+ *
+ * Such a monster can't become aware of a player, and being at full health there is nothing to heal.
+ * It is woken as soon as it is damaged, alerted by its group or a player comes near.
+ * Only state that is the same on all clients is used, so they all skip the same monsters.
+ */
+static bool IsMonsterDormant(const MonsterStruct &monst)
+{
+	if (monst._mmode != MM_STAND || monst._msquelch != 0 || monst._mhitpoints != monst._mmaxhp)
+		return false;
+	if ((monst._mFlags & (MFLAG_GOLEM | MFLAG_TARGETS_MONSTER | MFLAG_SEARCH)) != 0 || monst.mtalkmsg != TEXT_NONE)
+		return false;
+
+	for (int pnum = 0; pnum < MAX_PLRS; pnum++) {
+		const auto &player = plr[pnum];
+		if (!player.plractive || player.plrlevel != currlevel)
+			continue;
+		const int distance = std::max(abs(player.position.tile.x - monst.position.tile.x), abs(player.position.tile.y - monst.position.tile.y));
+		if (distance < MonsterWakeDistance)
+			return false;
+	}
+
+	return true;
+}
+
 void M_Enemy(int i)
 {
 	int j;
@@ -1306,6 +1581,8 @@ void M_Enemy(int i)
 	MonsterStruct *Monst;
 	BYTE enemyx, enemyy;
 
+	gnEnemyScans++;
+
 	_menemy = -1;
 	best_dist = -1;
 	bestsameroom = false;
@@ -1329,8 +1606,14 @@ void M_Enemy(int i)
 			}
 		}
 	}
-	for (j = 0; j < nummonsters; j++) {
-		mi = monstactive[j];
+	// Other monsters are only ever interested in golems and berserk monsters, so they
+	// don't need to look at the whole level
+	const bool targetsAnyMonster = (Monst->_mFlags & (MFLAG_GOLEM | MFLAG_BERSERK)) != 0;
+	if (!targetsAnyMonster)
+		UpdateMonsterTargets();
+	const int candidates = targetsAnyMonster ? nummonsters : NumMonsterTargets;
+	for (j = 0; j < candidates; j++) {
+		mi = targetsAnyMonster ? monstactive[j] : MonsterTargets[j];
 		if (mi == i)
 			continue;
 		if (!((monster[mi]._mhitpoints >> 6) > 0))
@@ -1905,6 +2188,7 @@ void M_StartHeal(int i)
 	assurance(monster[i].MType != nullptr, i);
 
 	Monst = &monster[i];
+	LoadMonsterAnim(*Monst->MType, MA_SPECIAL);
 	Monst->_mAnimData = &*Monst->MType->Anims[MA_SPECIAL].CelSpritesForDirections[Monst->_mdir];
 	Monst->_mAnimFrame = Monst->MType->Anims[MA_SPECIAL].Frames;
 	Monst->_mFlags |= MFLAG_LOCK_ANIMATION;
@@ -2817,8 +3101,17 @@ bool M_PathWalk(int i)
 
 	commitment((DWORD)i < MAXMONSTERS, i);
 
+	const bool canOpenDoors = (monster[i]._mFlags & MFLAG_CAN_OPEN_DOOR) != 0;
+	if (sgGameInitInfo.bSharedMonsterPathing) {
+		Direction md;
+		if (!GetFlowFieldStep(monster[i].position.tile, monster[i].enemyPosition, canOpenDoors, md))
+			return false;
+		M_CallWalk(i, md);
+		return true;
+	}
+
 	Check = PosOkMonst3;
-	if (!(monster[i]._mFlags & MFLAG_CAN_OPEN_DOOR))
+	if (!canOpenDoors)
 		Check = PosOkMonst;
 
 	if (FindPath(Check, i, monster[i].position.tile.x, monster[i].position.tile.y, monster[i].enemyPosition.x, monster[i].enemyPosition.y, path)) {
@@ -4506,16 +4799,24 @@ void DeleteMonsterList()
 
 void ProcessMonsters()
 {
+	ProfileScope profileScope(ProfilePhase::ProcessMonsters);
+
 	int i, mi, mx, my, _menemy;
 	bool raflag;
 	MonsterStruct *Monst;
 
 	DeleteMonsterList();
 
+	// Monsters are processed strictly in monstactive order: M_Enemy and the AI
+	// handlers read the positions, hit points and dMonster entries that earlier
+	// monsters changed during this same tick, so targets can't be precomputed
+	// from a snapshot without changing the outcome (and the multiplayer sync).
 	assert((DWORD)nummonsters <= MAXMONSTERS);
 	for (i = 0; i < nummonsters; i++) {
 		mi = monstactive[i];
 		Monst = &monster[mi];
+		if (sgGameInitInfo.bIdleMonstersSleep && IsMonsterDormant(*Monst))
+			continue;
 		raflag = false;
 		if (gbIsMultiplayer) {
 			SetRndSeed(Monst->_mAISeed);
@@ -4532,6 +4833,7 @@ void ProcessMonsters()
 		my = Monst->position.tile.y;
 
 		if (dFlags[mx][my] & BFLAG_VISIBLE && Monst->_msquelch == 0) {
+			PrefetchMonsterAnims(*Monst->MType);
 			if (Monst->MType->mtype == MT_CLEAVER) {
 				PlaySFX(USFX_CLEAVER);
 			}
@@ -4664,9 +4966,18 @@ void FreeMonsters()
 		}
 	}
 
+	for (auto &entry : MonsterSheets)
+		entry.second.refs = 0;
+	TrimMonsterSheets();
+
 	FreeMissiles2();
 }
 
+void ClearMonsterSheetCache()
+{
+	MonsterSheets.clear();
+}
+
 bool DirOK(int i, Direction mdir)
 {
 	commitment((DWORD)i < MAXMONSTERS, i);
@@ -4724,17 +5035,12 @@ bool CheckNoSolid(int entity, Point position)
 	return !nSolidTable[dPiece[position.x][position.y]];
 }
 
-bool LineClearSolid(Point startPoint, Point endPoint)
-{
-	return LineClear(CheckNoSolid, 0, startPoint, endPoint);
-}
-
-bool LineClearMissile(Point startPoint, Point endPoint)
-{
-	return LineClear(PosOkMissile, 0, startPoint, endPoint);
-}
-
-bool LineClear(bool (*Clear)(int, Point), int entity, Point startPoint, Point endPoint)
+/**
+ * @brief Walks the line from startPoint to endPoint, the predicate is inlined so the
+ * solid and missile checks don't pay for an indirect call per tile.
+ */
+template <typename F>
+static bool LineClearWith(F clear, Point startPoint, Point endPoint)
 {
 	int d;
 	int xincD, yincD, dincD, dincH;
@@ -4769,7 +5075,7 @@ bool LineClear(bool (*Clear)(int, Point), int entity, Point startPoint, Point en
 				position.y += yincD;
 			}
 			position.x++;
-			done = position != startPoint && !Clear(entity, position);
+			done = position != startPoint && !clear(position);
 		}
 	} else {
 		if (dy < 0) {
@@ -4796,12 +5102,27 @@ bool LineClear(bool (*Clear)(int, Point), int entity, Point startPoint, Point en
 				position.x += xincD;
 			}
 			position.y++;
-			done = position != startPoint && !Clear(entity, position);
+			done = position != startPoint && !clear(position);
 		}
 	}
 	return position == endPoint;
 }
 
+bool LineClearSolid(Point startPoint, Point endPoint)
+{
+	return LineClearWith([](Point position) { return CheckNoSolid(0, position); }, startPoint, endPoint);
+}
+
+bool LineClearMissile(Point startPoint, Point endPoint)
+{
+	return LineClearWith([](Point position) { return PosOkMissile(0, position); }, startPoint, endPoint);
+}
+
+bool LineClear(bool (*Clear)(int, Point), int entity, Point startPoint, Point endPoint)
+{
+	return LineClearWith([Clear, entity](Point position) { return Clear(entity, position); }, startPoint, endPoint);
+}
+
 void SyncMonsterAnim(int i)
 {
 	int _mdir;
@@ -4856,6 +5177,7 @@ void SyncMonsterAnim(int i)
 		break;
 	}
 
+	LoadMonsterAnim(*monster[i].MType, graphic);
 	if (monster[i].MType->Anims[graphic].CelSpritesForDirections[_mdir])
 		monster[i]._mAnimData = &*monster[i].MType->Anims[graphic].CelSpritesForDirections[_mdir];
 	else
@@ -5365,6 +5687,7 @@ void SpawnGolum(int i, Point position, int mi)
 	monster[i].mMinDamage = 2 * (missile[mi]._mispllvl + 4);
 	monster[i].mMaxDamage = 2 * (missile[mi]._mispllvl + 8);
 	monster[i]._mFlags |= MFLAG_GOLEM;
+	InvalidateMonsterTargets();
 	M_StartSpStand(i, DIR_S);
 	M_Enemy(i);
 	if (i == myplr) {
@@ -111,7 +111,8 @@ enum placeflag : uint8_t {
 };
 
 struct AnimStruct {
-	std::unique_ptr<byte[]> CMem;
+	/** Owned by the monster sheet cache, which keeps it for later levels */
+	byte *CMem;
 	std::array<std::optional<CelSprite>, 8> CelSpritesForDirections;
 	int Frames;
 	int Rate;
@@ -133,22 +134,22 @@ struct CMonster {
 	const MonsterData *MData;
 };
 
+/**
+ * The fields that ProcessMonsters touches for every active monster on every tick come first,
+ * so that the common case of an idle or walking monster only pulls in the start of its entry.
+ * The order of the fields has no effect on savegames or network messages, those are written field by field.
+ */
 struct MonsterStruct { // note: missing field _mAFNum
-	int _mMTidx;
 	MON_MODE _mmode;
-	monster_goal _mgoal;
-	int _mgoalvar1;
-	int _mgoalvar2;
-	int _mgoalvar3;
-	uint8_t _pathcount;
-	ActorPosition position;
-	/** Direction faced by monster (direction enum) */
-	Direction _mdir;
+	_mai_id _mAi;
+	uint8_t _msquelch;
+	int8_t mLevel;
+	uint32_t _mFlags;
+	int _mhitpoints;
+	int _mmaxhp;
+	int _mAISeed;
 	/** The current target of the mosnter. An index in to either the plr or monster array based on the _meflag value. */
 	int _menemy;
-	/** Usually correspond's to the enemy's future position */
-	Point enemyPosition;
-	CelSprite *_mAnimData;
 	/** Tick length of each frame in the current animation */
 	int _mAnimDelay;
 	/** Increases by one each game tick, counting how close we are to _pAnimDelay */
@@ -157,25 +158,32 @@ struct MonsterStruct { // note: missing field _mAFNum
 	int _mAnimLen;
 	/** Current frame of animation. */
 	int _mAnimFrame;
-	bool _mDelFlag;
+	CMonster *MType;
+	ActorPosition position;
+	/** Usually correspond's to the enemy's future position */
+	Point enemyPosition;
 	int _mVar1;
 	int _mVar2;
 	int _mVar3;
 	/** Value used to measure progress for moving from one tile to another */
 	int actionFrame;
-	int _mmaxhp;
-	int _mhitpoints;
-	_mai_id _mAi;
+
+	int _mMTidx;
+	monster_goal _mgoal;
+	int _mgoalvar1;
+	int _mgoalvar2;
+	int _mgoalvar3;
+	uint8_t _pathcount;
+	/** Direction faced by monster (direction enum) */
+	Direction _mdir;
+	CelSprite *_mAnimData;
+	bool _mDelFlag;
 	uint8_t _mint;
-	uint32_t _mFlags;
-	uint8_t _msquelch;
 	int _mRndSeed;
-	int _mAISeed;
 	uint8_t _uniqtype;
 	uint8_t _uniqtrans;
 	int8_t _udeadval;
 	int8_t mWhoHit;
-	int8_t mLevel;
 	uint16_t mExp;
 	uint16_t mHit;
 	uint8_t mMinDamage;
@@ -191,7 +199,6 @@ struct MonsterStruct { // note: missing field _mAFNum
 	uint8_t packsize;
 	int8_t mlid; // BUGFIX -1 is used when not emitting light this should be signed (fixed)
 	const char *mName;
-	CMonster *MType;
 	const MonsterData *MData;
 
 	/**
@@ -208,10 +215,18 @@ extern bool sgbSaveSoundOn;
 extern MonsterStruct monster[MAXMONSTERS];
 extern CMonster Monsters[MAX_LVLMTYPES];
 extern int nummtypes;
+extern uint32_t gnEnemyScans;
 
 void InitLevelMonsters();
 void GetLevelMTypes();
 void InitMonsterGFX(int monst);
+/**
+ * @brief Load the sheet of an attack, hit or special animation of a monster type if it isn't loaded yet
+ *
+ * These are only loaded once a monster plays them, their sheets are read ahead when a monster of the type is first seen.
+ * @param anim MA_* index of the animation
+ */
+void LoadMonsterAnim(CMonster &monsterType, int anim);
 void InitMonster(int i, Direction rd, int mtype, Point position);
 void ClrAllMonsters();
 void monster_some_crypt();
@@ -219,6 +234,12 @@ void PlaceGroup(int mtype, int num, int leaderf, int leader);
 void InitMonsters();
 void SetMapMonsters(const uint16_t *dunData, Point startPosition);
 void DeleteMonster(int i);
+/**
+ * @brief Forget the cached list of monsters that other monsters pick as targets.
+ *
+ * Must be called whenever monsters are added or removed, or become golems or berserk.
+ */
+void InvalidateMonsterTargets();
 int AddMonster(Point position, Direction dir, int mtype, bool InMap);
 void monster_43C785(int i);
 bool M_Talker(int i);
@@ -279,6 +300,8 @@ void MAI_Warlord(int i);
 void DeleteMonsterList();
 void ProcessMonsters();
 void FreeMonsters();
+/** @brief Drop the monster sheets kept for later levels, when a game ends. */
+void ClearMonsterSheetCache();
 bool DirOK(int i, Direction mdir);
 bool PosOkMissile(int entity, Point position);
 bool LineClearSolid(Point startPoint, Point endPoint);
@@ -5,6 +5,7 @@
  */
 #include "mpqapi.h"
 
+#include <algorithm>
 #include <cerrno>
 #include <cinttypes>
 #include <cstddef>
@@ -13,6 +14,7 @@
 #include <fstream>
 #include <memory>
 #include <type_traits>
+#include <vector>
 
 #include "appfat.h"
 #include "encrypt.h"
@@ -193,6 +195,11 @@ struct Archive {
 	_HASHENTRY *sgpHashTbl;
 	_BLOCKENTRY *sgpBlockTbl;
 
+	/** Copies of the tables as they are in the file, so that Close only writes the entries that changed */
+	std::unique_ptr<_HASHENTRY[]> writtenHashTbl;
+	std::unique_ptr<_BLOCKENTRY[]> writtenBlockTbl;
+	std::uintmax_t writtenSize;
+
 	bool Open(const char *name)
 	{
 		Close();
@@ -231,7 +238,7 @@ struct Archive {
 #endif
 
 		bool result = true;
-		if (modified && !(stream.seekp(0, std::ios::beg) && WriteHeaderAndTables()))
+		if (modified && !WriteChangedHeaderAndTables())
 			result = false;
 		stream.Close();
 		if (modified && result && size != 0) {
@@ -246,6 +253,7 @@ struct Archive {
 			sgpHashTbl = nullptr;
 			delete[] sgpBlockTbl;
 			sgpBlockTbl = nullptr;
+			ForgetWrittenTables();
 		}
 		return result;
 	}
@@ -255,12 +263,74 @@ struct Archive {
 		return WriteHeader() && WriteBlockTable() && WriteHashTable();
 	}
 
+	/** @brief Call after the tables have been read from the file or written to it */
+	void RememberWrittenTables()
+	{
+		if (writtenHashTbl == nullptr)
+			writtenHashTbl.reset(new _HASHENTRY[INDEX_ENTRIES]);
+		if (writtenBlockTbl == nullptr)
+			writtenBlockTbl.reset(new _BLOCKENTRY[INDEX_ENTRIES]);
+		memcpy(writtenHashTbl.get(), sgpHashTbl, HashEntrySize);
+		memcpy(writtenBlockTbl.get(), sgpBlockTbl, BlockEntrySize);
+		writtenSize = size;
+	}
+
+	/** @brief Call when the tables in the file are unknown, so that Close writes all of them */
+	void ForgetWrittenTables()
+	{
+		writtenHashTbl = nullptr;
+		writtenBlockTbl = nullptr;
+	}
+
 	~Archive()
 	{
 		Close();
 	}
 
 private:
+	template <typename Entry>
+	static std::size_t FirstChangedEntry(const Entry *table, const Entry *written)
+	{
+		std::size_t i = 0;
+		while (i < INDEX_ENTRIES && memcmp(&table[i], &written[i], sizeof(Entry)) == 0)
+			i++;
+		return i;
+	}
+
+	/**
+	 * @brief Writes only the parts of the header and tables that differ from the file
+	 *
+	 * Every encrypted entry depends on the ones before it, so a table is written from its first changed entry to its end.
+	 */
+	bool WriteChangedHeaderAndTables()
+	{
+		if (writtenHashTbl == nullptr || writtenBlockTbl == nullptr) {
+			if (!(stream.seekp(0, std::ios::beg) && WriteHeaderAndTables())) {
+				ForgetWrittenTables();
+				return false;
+			}
+			RememberWrittenTables();
+			return true;
+		}
+
+		bool success = true;
+		if (size != writtenSize)
+			success = stream.seekp(0, std::ios::beg) && WriteHeader();
+		const std::size_t firstBlock = FirstChangedEntry(sgpBlockTbl, writtenBlockTbl.get());
+		if (success && firstBlock != INDEX_ENTRIES)
+			success = stream.seekp(MpqBlockEntryOffset + firstBlock * sizeof(_BLOCKENTRY), std::ios::beg) && WriteBlockTable(firstBlock);
+		const std::size_t firstHash = FirstChangedEntry(sgpHashTbl, writtenHashTbl.get());
+		if (success && firstHash != INDEX_ENTRIES)
+			success = stream.seekp(MpqHashEntryOffset + firstHash * sizeof(_HASHENTRY), std::ios::beg) && WriteHashTable(firstHash);
+
+		if (!success) {
+			ForgetWrittenTables();
+			return false;
+		}
+		RememberWrittenTables();
+		return true;
+	}
+
 	bool WriteHeader()
 	{
 		_FILEHEADER fhdr;
@@ -281,18 +351,18 @@ private:
 		return true;
 	}
 
-	bool WriteBlockTable()
+	bool WriteBlockTable(std::size_t firstEntry = 0)
 	{
 		Encrypt((DWORD *)sgpBlockTbl, BlockEntrySize, Hash("(block table)", 3));
-		const bool success = stream.write(reinterpret_cast<const char *>(sgpBlockTbl), BlockEntrySize);
+		const bool success = stream.write(reinterpret_cast<const char *>(&sgpBlockTbl[firstEntry]), BlockEntrySize - firstEntry * sizeof(_BLOCKENTRY));
 		Decrypt((DWORD *)sgpBlockTbl, BlockEntrySize, Hash("(block table)", 3));
 		return success;
 	}
 
-	bool WriteHashTable()
+	bool WriteHashTable(std::size_t firstEntry = 0)
 	{
 		Encrypt((DWORD *)sgpHashTbl, HashEntrySize, Hash("(hash table)", 3));
-		const bool success = stream.write(reinterpret_cast<const char *>(sgpHashTbl), HashEntrySize);
+		const bool success = stream.write(reinterpret_cast<const char *>(&sgpHashTbl[firstEntry]), HashEntrySize - firstEntry * sizeof(_HASHENTRY));
 		Decrypt((DWORD *)sgpHashTbl, HashEntrySize, Hash("(hash table)", 3));
 		return success;
 	}
@@ -533,7 +603,7 @@ static _BLOCKENTRY *mpqapi_add_file(const char *pszName, _BLOCKENTRY *pBlk, int
 	return pBlk;
 }
 
-static bool mpqapi_write_file_contents(const char *pszName, const byte *pbData, size_t dwLen, _BLOCKENTRY *pBlk)
+static bool mpqapi_write_file_contents(const char *pszName, const byte *pbCompressed, const std::vector<uint32_t> &sectorEnds, size_t dwLen, _BLOCKENTRY *pBlk)
 {
 	const char *tmp;
 	while ((tmp = strchr(pszName, ':')))
@@ -542,20 +612,23 @@ static bool mpqapi_write_file_contents(const char *pszName, const byte *pbData,
 		pszName = tmp + 1;
 	Hash(pszName, 3);
 
-	constexpr size_t sectorSize = 4096;
-	const uint32_t num_sectors = (dwLen + (sectorSize - 1)) / sectorSize;
+	const uint32_t num_sectors = sectorEnds.size();
 	const uint32_t offset_table_bytesize = sizeof(uint32_t) * (num_sectors + 1);
+	const uint32_t compressedLen = num_sectors != 0 ? sectorEnds.back() : 0;
+	const uint32_t destsize = offset_table_bytesize + compressedLen;
+	// Reserve room for the uncompressed size, the unused part is given back below
 	pBlk->offset = mpqapi_find_free_block(dwLen + offset_table_bytesize, &pBlk->sizealloc);
 	pBlk->sizefile = dwLen;
 	pBlk->flags = 0x80000100;
 
-	// We populate the table of sector offset while we write the data.
-	// We can't pre-populate it because we don't know the compressed sector sizes yet.
 	// First offset is the start of the first sector, last offset is the end of the last sector.
 	std::unique_ptr<uint32_t[]> sectoroffsettable { new uint32_t[num_sectors + 1] };
+	sectoroffsettable[0] = SDL_SwapLE32(offset_table_bytesize);
+	for (uint32_t i = 0; i < num_sectors; i++)
+		sectoroffsettable[i + 1] = SDL_SwapLE32(offset_table_bytesize + sectorEnds[i]);
 
 #ifdef CAN_SEEKP_BEYOND_EOF
-	if (!cur_archive.stream.seekp(pBlk->offset + offset_table_bytesize, std::ios::beg))
+	if (!cur_archive.stream.seekp(pBlk->offset, std::ios::beg))
 		return false;
 #else
 	// Ensure we do not seekp beyond EOF by filling the missing space.
@@ -563,44 +636,19 @@ static bool mpqapi_write_file_contents(const char *pszName, const byte *pbData,
 	if (!cur_archive.stream.seekp(0, std::ios::end) || !cur_archive.stream.tellp(&stream_end))
 		return false;
 	const std::uintmax_t cur_size = stream_end - cur_archive.stream_begin;
-	if (cur_size < pBlk->offset + offset_table_bytesize) {
-		if (cur_size < pBlk->offset) {
-			std::unique_ptr<char[]> filler { new char[pBlk->offset - cur_size] };
-			if (!cur_archive.stream.write(filler.get(), pBlk->offset - cur_size))
-				return false;
-		}
-		if (!cur_archive.stream.write(reinterpret_cast<const char *>(sectoroffsettable.get()), offset_table_bytesize))
+	if (cur_size < pBlk->offset) {
+		std::unique_ptr<char[]> filler { new char[pBlk->offset - cur_size] };
+		if (!cur_archive.stream.write(filler.get(), pBlk->offset - cur_size))
 			return false;
 	} else {
-		if (!cur_archive.stream.seekp(pBlk->offset + offset_table_bytesize, std::ios::beg))
+		if (!cur_archive.stream.seekp(pBlk->offset, std::ios::beg))
 			return false;
 	}
 #endif
 
-	uint32_t destsize = offset_table_bytesize;
-	byte mpq_buf[sectorSize];
-	std::size_t cur_sector = 0;
-	while (true) {
-		uint32_t len = std::min(dwLen, sectorSize);
-		memcpy(mpq_buf, pbData, len);
-		pbData += len;
-		len = PkwareCompress(mpq_buf, len);
-		if (!cur_archive.stream.write((char *)mpq_buf, len))
-			return false;
-		sectoroffsettable[cur_sector++] = SDL_SwapLE32(destsize);
-		destsize += len; // compressed length
-		if (dwLen > sectorSize)
-			dwLen -= sectorSize;
-		else
-			break;
-	}
-
-	sectoroffsettable[num_sectors] = SDL_SwapLE32(destsize);
-	if (!cur_archive.stream.seekp(pBlk->offset, std::ios::beg))
-		return false;
 	if (!cur_archive.stream.write(reinterpret_cast<const char *>(sectoroffsettable.get()), offset_table_bytesize))
 		return false;
-	if (!cur_archive.stream.seekp(destsize - offset_table_bytesize, std::ios::cur))
+	if (!cur_archive.stream.write(reinterpret_cast<const char *>(pbCompressed), compressedLen))
 		return false;
 
 	if (destsize < pBlk->sizealloc) {
@@ -613,20 +661,62 @@ static bool mpqapi_write_file_contents(const char *pszName, const byte *pbData,
 	return true;
 }
 
-bool mpqapi_write_file(const char *pszName, const byte *pbData, size_t dwLen)
+MpqFileWriter::MpqFileWriter(const char *pszName)
+    : name_(pszName)
 {
-	_BLOCKENTRY *blockEntry;
+}
+
+void MpqFileWriter::Write(const byte *pbData, size_t dwLen)
+{
+	while (dwLen != 0) {
+		const size_t len = std::min(dwLen, MpqSectorSize - sectorLen_);
+		memcpy(&sector_[sectorLen_], pbData, len);
+		sectorLen_ += len;
+		fileLen_ += len;
+		pbData += len;
+		dwLen -= len;
+		if (sectorLen_ == MpqSectorSize)
+			CompressSector();
+	}
+}
+
+void MpqFileWriter::CompressSector()
+{
+	const size_t offset = compressed_.size();
+	compressed_.resize(offset + PkwareCompressBound(sectorLen_));
+	uint32_t len = PkwareCompress(sector_, sectorLen_, &compressed_[offset]);
+	if (len >= sectorLen_) {
+		// Sectors that don't get smaller are stored as they are
+		memcpy(&compressed_[offset], sector_, sectorLen_);
+		len = sectorLen_;
+	}
+	compressed_.resize(offset + len);
+	sectorEnds_.push_back(compressed_.size());
+	sectorLen_ = 0;
+}
+
+bool MpqFileWriter::Finish()
+{
+	if (sectorLen_ != 0)
+		CompressSector();
 
 	cur_archive.modified = true;
-	mpqapi_remove_hash_entry(pszName);
-	blockEntry = mpqapi_add_file(pszName, nullptr, 0);
-	if (!mpqapi_write_file_contents(pszName, pbData, dwLen, blockEntry)) {
-		mpqapi_remove_hash_entry(pszName);
+	mpqapi_remove_hash_entry(name_.c_str());
+	_BLOCKENTRY *blockEntry = mpqapi_add_file(name_.c_str(), nullptr, 0);
+	if (!mpqapi_write_file_contents(name_.c_str(), compressed_.data(), sectorEnds_, fileLen_, blockEntry)) {
+		mpqapi_remove_hash_entry(name_.c_str());
 		return false;
 	}
 	return true;
 }
 
+bool mpqapi_write_file(const char *pszName, const byte *pbData, size_t dwLen)
+{
+	MpqFileWriter writer(pszName);
+	writer.Write(pbData, dwLen);
+	return writer.Finish();
+}
+
 void mpqapi_rename(char *pszOld, char *pszNew)
 {
 	int index, block;
@@ -681,6 +771,10 @@ bool OpenMPQ(const char *pszArchive)
 			key = Hash("(hash table)", 3);
 			Decrypt((DWORD *)cur_archive.sgpHashTbl, HashEntrySize, key);
 		}
+		if (fhdr.blockcount != 0 && fhdr.hashcount != 0)
+			cur_archive.RememberWrittenTables();
+		else
+			cur_archive.ForgetWrittenTables();
 
 #ifndef CAN_SEEKP_BEYOND_EOF
 		if (!cur_archive.stream.seekp(0, std::ios::beg))
@@ -702,6 +796,69 @@ on_error:
 	return false;
 }
 
+bool mpqapi_compact()
+{
+	std::vector<_BLOCKENTRY *> usedBlocks;
+	std::uintmax_t freeSpace = 0;
+	for (int i = 0; i < INDEX_ENTRIES; i++) {
+		_BLOCKENTRY &block = cur_archive.sgpBlockTbl[i];
+		if (block.offset == 0)
+			continue;
+		if (block.flags == 0 && block.sizefile == 0)
+			freeSpace += block.sizealloc;
+		else
+			usedBlocks.push_back(&block);
+	}
+	if (freeSpace < MpqCompactMinFreeSpace || freeSpace < cur_archive.size / 4)
+		return true;
+
+	// The free list is rebuilt from the gaps that are left between the files
+	for (int i = 0; i < INDEX_ENTRIES; i++) {
+		_BLOCKENTRY &block = cur_archive.sgpBlockTbl[i];
+		if (block.offset != 0 && block.flags == 0 && block.sizefile == 0)
+			memset(&block, 0, sizeof(block));
+	}
+	cur_archive.modified = true;
+
+	std::sort(usedBlocks.begin(), usedBlocks.end(), [](const _BLOCKENTRY *a, const _BLOCKENTRY *b) {
+		return a->offset < b->offset;
+	});
+
+	// A file is only moved into a gap that can hold all of it, so the copy never overwrites the original.
+	// If a read or write fails, the file keeps its old location and the remaining files stay where they are.
+	bool success = true;
+	std::unique_ptr<char[]> buffer;
+	uint32_t bufferSize = 0;
+	uint32_t end = MpqHashEntryOffset + HashEntrySize;
+	for (_BLOCKENTRY *block : usedBlocks) {
+		const uint32_t gap = block->offset - end;
+		if (gap == 0) {
+			end += block->sizealloc;
+			continue;
+		}
+		if (success && gap >= block->sizealloc) {
+			if (block->sizealloc > bufferSize) {
+				bufferSize = block->sizealloc;
+				buffer.reset(new char[bufferSize]);
+			}
+			success = cur_archive.stream.seekg(block->offset, std::ios::beg)
+			    && cur_archive.stream.read(buffer.get(), block->sizealloc)
+			    && cur_archive.stream.seekp(end, std::ios::beg)
+			    && cur_archive.stream.write(buffer.get(), block->sizealloc);
+			if (success) {
+				block->offset = end;
+				end += block->sizealloc;
+				continue;
+			}
+		}
+		mpqapi_alloc_block(end, gap);
+		end = block->offset + block->sizealloc;
+	}
+	cur_archive.size = end;
+
+	return success;
+}
+
 bool mpqapi_flush_and_close(bool bFree)
 {
 	return cur_archive.Close(/*clear_tables=*/bFree);
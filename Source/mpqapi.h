@@ -6,6 +6,8 @@
 #pragma once
 
 #include <cstdint>
+#include <string>
+#include <vector>
 
 #include "utils/stdcompat/cstddef.hpp"
 
@@ -37,12 +39,52 @@ struct _BLOCKENTRY {
 	uint32_t flags;
 };
 
+/** Size of the sectors a file is split into, matches the sectorsizeid of the archives we write */
+constexpr size_t MpqSectorSize = 4096;
+
+/**
+ * @brief Writes a file to the archive from data that is produced a piece at a time.
+ *
+ * Every sector is compressed as soon as it is full, so only the compressed file is kept in memory until Finish().
+ */
+class MpqFileWriter {
+public:
+	explicit MpqFileWriter(const char *pszName);
+
+	void Write(const byte *pbData, size_t dwLen);
+
+	/** @brief Add the file to the archive, replacing any file of the same name. */
+	bool Finish();
+
+private:
+	void CompressSector();
+
+	std::string name_;
+	byte sector_[MpqSectorSize];
+	size_t sectorLen_ = 0;
+	size_t fileLen_ = 0;
+	std::vector<byte> compressed_;
+	/** End of every compressed sector, relative to the start of the first one */
+	std::vector<uint32_t> sectorEnds_;
+};
+
 void mpqapi_remove_hash_entry(const char *pszName);
 void mpqapi_remove_hash_entries(bool (*fnGetName)(uint8_t, char *));
 bool mpqapi_write_file(const char *pszName, const byte *pbData, size_t dwLen);
 void mpqapi_rename(char *pszOld, char *pszNew);
 bool mpqapi_has_file(const char *pszName);
 bool OpenMPQ(const char *pszArchive);
+/** Compaction is skipped unless at least this much and a quarter of the archive is unused */
+constexpr size_t MpqCompactMinFreeSpace = 64 * 1024;
+/**
+ * @brief Moves the files together to give back the space left behind by removed and replaced files
+ *
+ * Does nothing unless enough of the archive is unused, see MpqCompactMinFreeSpace.
+ * Files are only moved into space that is unused, so the archive stays consistent if a move fails.
+ * Like every other write, the moves are only safe against a crash once the tables are written on close.
+ * @return false if moving a file failed, the rest of the files were then left in place
+ */
+bool mpqapi_compact();
 bool mpqapi_flush_and_close(bool bFree);
 
 } // namespace devilution
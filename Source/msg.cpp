@@ -3,7 +3,9 @@
  *
  * Implementation of function for sending and reciving network messages.
  */
+#include <algorithm>
 #include <climits>
+#include <cstring>
 #include <memory>
 
 #include <fmt/format.h>
@@ -37,7 +39,8 @@ namespace devilution {
 static DWORD sgdwOwnerWait;
 static DWORD sgdwRecvOffset;
 static int sgnCurrMegaPlayer;
-static DLevel sgLevels[NUMLEVELS];
+/** Changes to each level, allocated when a level gets its first change so unvisited levels cost no memory */
+static std::unique_ptr<DLevel> sgLevels[NUMLEVELS];
 static BYTE sbLastCmd;
 static TMegaPkt *sgpCurrPkt;
 static byte sgRecvBuf[sizeof(DLevel) + 1];
@@ -45,34 +48,65 @@ static BYTE sgbRecvCmd;
 static LocalLevel sgLocals[NUMLEVELS];
 static DJunk sgJunk;
 static TMegaPkt *sgpMegaPkt;
+/** Released megapackets kept for the next level download, chained through pNext */
+static TMegaPkt *sgpFreePkts;
+static int sgnFreePkts;
 static bool sgbDeltaChanged;
 static BYTE sgbDeltaChunks;
 bool deltaload;
 BYTE gbBufferMsgs;
 int dwRecCount;
 
-static void msg_get_next_packet()
+/**
+ * @brief Returns the changes to a level, a level without any starts out with every entry unset (0xFF)
+ */
+static DLevel &GetDeltaLevel(int level)
 {
-	TMegaPkt *result;
+	std::unique_ptr<DLevel> &delta = sgLevels[level];
+	if (delta == nullptr) {
+		delta = std::make_unique<DLevel>();
+		memset(delta.get(), 0xFF, sizeof(DLevel));
+	}
+	return *delta;
+}
 
-	sgpCurrPkt = static_cast<TMegaPkt *>(std::malloc(sizeof(TMegaPkt)));
-	sgpCurrPkt->pNext = nullptr;
-	sgpCurrPkt->dwSpaceLeft = sizeof(result->data);
+/** Most released megapackets to keep around, enough for a typical level download */
+constexpr int MaxFreePkts = 8;
 
-	result = (TMegaPkt *)&sgpMegaPkt;
-	while (result->pNext != nullptr)
-		result = result->pNext;
+static void msg_get_next_packet()
+{
+	TMegaPkt *pkt = sgpFreePkts;
+	if (pkt != nullptr) {
+		sgpFreePkts = pkt->pNext;
+		sgnFreePkts--;
+	} else {
+		pkt = static_cast<TMegaPkt *>(std::malloc(sizeof(TMegaPkt)));
+	}
+	pkt->pNext = nullptr;
+	pkt->dwSpaceLeft = sizeof(pkt->data);
 
-	result->pNext = sgpCurrPkt;
+	// sgpCurrPkt is always the tail of the chain
+	if (sgpMegaPkt == nullptr)
+		sgpMegaPkt = pkt;
+	else
+		sgpCurrPkt->pNext = pkt;
+	sgpCurrPkt = pkt;
 }
 
 static void msg_free_packets()
 {
 	while (sgpMegaPkt != nullptr) {
-		sgpCurrPkt = sgpMegaPkt->pNext;
-		std::free(sgpMegaPkt);
-		sgpMegaPkt = sgpCurrPkt;
+		TMegaPkt *next = sgpMegaPkt->pNext;
+		if (sgnFreePkts < MaxFreePkts) {
+			sgpMegaPkt->pNext = sgpFreePkts;
+			sgpFreePkts = sgpMegaPkt;
+			sgnFreePkts++;
+		} else {
+			std::free(sgpMegaPkt);
+		}
+		sgpMegaPkt = next;
 	}
+	sgpCurrPkt = nullptr;
 }
 
 static void msg_pre_packet()
@@ -100,7 +134,9 @@ static void msg_pre_packet()
 				continue;
 			}
 
-			int pktSize = ParseCmd(playerId, (TCmd *)data);
+			int pktSize = ParseCmd(playerId, (TCmd *)data, spaceLeft - pkt->dwSpaceLeft);
+			if (pktSize == 0)
+				break;
 			data += pktSize;
 			spaceLeft -= pktSize;
 		}
@@ -341,6 +377,26 @@ static void DeltaImportJunk(byte *src)
 	}
 }
 
+/**
+ * @brief Checks if a level has no delta, so the joining player already has it from delta_init.
+ */
+static bool DeltaLevelIsEmpty(const DLevel &level)
+{
+	for (const TCmdPItem &item : level.item) {
+		if (item.bCmd != 0xFF)
+			return false;
+	}
+	for (const DObjectStr &object : level.object) {
+		if (object.bCmd != 0xFF)
+			return false;
+	}
+	for (const DMonsterStr &monster : level.monster) {
+		if (monster._mx != 0xFF)
+			return false;
+	}
+	return true;
+}
+
 static DWORD msg_comp_level(byte *buffer, byte *end)
 {
 	DWORD size = end - buffer - 1;
@@ -358,10 +414,14 @@ void DeltaExportData(int pnum)
 		std::unique_ptr<byte[]> dst { new byte[sizeof(DLevel) + 1] };
 		byte *dstEnd;
 		for (int i = 0; i < NUMLEVELS; i++) {
+			// The town is always sent since the receiver only accepts a transfer that starts with it
+			if (i != 0 && (sgLevels[i] == nullptr || DeltaLevelIsEmpty(*sgLevels[i])))
+				continue;
+			DLevel &level = GetDeltaLevel(i);
 			dstEnd = &dst[1];
-			dstEnd = DeltaExportItem(dstEnd, sgLevels[i].item);
-			dstEnd = DeltaExportObject(dstEnd, sgLevels[i].object);
-			dstEnd = DeltaExportMonster(dstEnd, sgLevels[i].monster);
+			dstEnd = DeltaExportItem(dstEnd, level.item);
+			dstEnd = DeltaExportObject(dstEnd, level.object);
+			dstEnd = DeltaExportMonster(dstEnd, level.monster);
 			size = msg_comp_level(dst.get(), dstEnd);
 			dthread_send_delta(pnum, static_cast<_cmd_id>(i + CMD_DLEVEL_0), dst.get(), size);
 		}
@@ -384,9 +444,10 @@ static void DeltaImportData(BYTE cmd, DWORD recv_offset)
 		DeltaImportJunk(src);
 	} else if (cmd >= CMD_DLEVEL_0 && cmd <= CMD_DLEVEL_24) {
 		BYTE i = cmd - CMD_DLEVEL_0;
-		src = DeltaImportItem(src, sgLevels[i].item);
-		src = DeltaImportObject(src, sgLevels[i].object);
-		DeltaImportMonster(src, sgLevels[i].monster);
+		DLevel &level = GetDeltaLevel(i);
+		src = DeltaImportItem(src, level.item);
+		src = DeltaImportObject(src, level.object);
+		DeltaImportMonster(src, level.monster);
 	} else {
 		app_fatal("Unkown network message type: %i", cmd);
 	}
@@ -442,7 +503,8 @@ void delta_init()
 {
 	sgbDeltaChanged = false;
 	memset(&sgJunk, 0xFF, sizeof(sgJunk));
-	memset(sgLevels, 0xFF, sizeof(sgLevels));
+	for (std::unique_ptr<DLevel> &level : sgLevels)
+		level = nullptr;
 	memset(sgLocals, 0, sizeof(sgLocals));
 	deltaload = false;
 }
@@ -453,7 +515,7 @@ void delta_kill_monster(int mi, Point position, BYTE bLevel)
 		return;
 
 	sgbDeltaChanged = true;
-	DMonsterStr *pD = &sgLevels[bLevel].monster[mi];
+	DMonsterStr *pD = &GetDeltaLevel(bLevel).monster[mi];
 	pD->_mx = position.x;
 	pD->_my = position.y;
 	pD->_mdir = monster[mi]._mdir;
@@ -466,7 +528,7 @@ void delta_monster_hp(int mi, int hp, BYTE bLevel)
 		return;
 
 	sgbDeltaChanged = true;
-	DMonsterStr *pD = &sgLevels[bLevel].monster[mi];
+	DMonsterStr *pD = &GetDeltaLevel(bLevel).monster[mi];
 	if (pD->_mhitpoints > hp)
 		pD->_mhitpoints = hp;
 }
@@ -480,7 +542,7 @@ void delta_sync_monster(const TSyncMonster *pSync, BYTE bLevel)
 	assert(bLevel < NUMLEVELS);
 	sgbDeltaChanged = true;
 
-	DMonsterStr *pD = &sgLevels[bLevel].monster[pSync->_mndx];
+	DMonsterStr *pD = &GetDeltaLevel(bLevel).monster[pSync->_mndx];
 	if (pD->_mhitpoints == 0)
 		return;
 
@@ -496,7 +558,7 @@ void delta_sync_golem(TCmdGolem *pG, int pnum, BYTE bLevel)
 		return;
 
 	sgbDeltaChanged = true;
-	DMonsterStr *pD = &sgLevels[bLevel].monster[pnum];
+	DMonsterStr *pD = &GetDeltaLevel(bLevel).monster[pnum];
 	pD->_mx = pG->_mx;
 	pD->_my = pG->_my;
 	pD->_mactive = UINT8_MAX;
@@ -519,7 +581,7 @@ void delta_leave_sync(BYTE bLevel)
 		if (monster[ma]._mhitpoints == 0)
 			continue;
 		sgbDeltaChanged = true;
-		DMonsterStr *pD = &sgLevels[bLevel].monster[ma];
+		DMonsterStr *pD = &GetDeltaLevel(bLevel).monster[ma];
 		pD->_mx = monster[ma].position.tile.x;
 		pD->_my = monster[ma].position.tile.y;
 		pD->_mdir = monster[ma]._mdir;
@@ -536,7 +598,7 @@ static void delta_sync_object(int oi, _cmd_id bCmd, BYTE bLevel)
 		return;
 
 	sgbDeltaChanged = true;
-	sgLevels[bLevel].object[oi].bCmd = bCmd;
+	GetDeltaLevel(bLevel).object[oi].bCmd = bCmd;
 }
 
 static bool delta_get_item(TCmdGItem *pI, BYTE bLevel)
@@ -546,7 +608,7 @@ static bool delta_get_item(TCmdGItem *pI, BYTE bLevel)
 	if (!gbIsMultiplayer)
 		return true;
 
-	TCmdPItem *pD = sgLevels[bLevel].item;
+	TCmdPItem *pD = GetDeltaLevel(bLevel).item;
 	for (i = 0; i < MAXITEMS; i++, pD++) {
 		if (pD->bCmd == CMD_INVALID || pD->wIndx != pI->wIndx || pD->wCI != pI->wCI || pD->dwSeed != pI->dwSeed)
 			continue;
@@ -571,7 +633,7 @@ static bool delta_get_item(TCmdGItem *pI, BYTE bLevel)
 	if ((pI->wCI & CF_PREGEN) == 0)
 		return false;
 
-	pD = sgLevels[bLevel].item;
+	pD = GetDeltaLevel(bLevel).item;
 	for (i = 0; i < MAXITEMS; i++, pD++) {
 		if (pD->bCmd == CMD_INVALID) {
 			sgbDeltaChanged = true;
@@ -607,7 +669,7 @@ static void delta_put_item(TCmdPItem *pI, int x, int y, BYTE bLevel)
 	if (!gbIsMultiplayer)
 		return;
 
-	TCmdPItem *pD = sgLevels[bLevel].item;
+	TCmdPItem *pD = GetDeltaLevel(bLevel).item;
 	for (i = 0; i < MAXITEMS; i++, pD++) {
 		if (pD->bCmd != CMD_WALKXY
 		    && pD->bCmd != 0xFF
@@ -620,7 +682,7 @@ static void delta_put_item(TCmdPItem *pI, int x, int y, BYTE bLevel)
 		}
 	}
 
-	pD = sgLevels[bLevel].item;
+	pD = GetDeltaLevel(bLevel).item;
 	for (i = 0; i < MAXITEMS; i++, pD++) {
 		if (pD->bCmd == 0xFF) {
 			sgbDeltaChanged = true;
@@ -650,7 +712,7 @@ void DeltaAddItem(int ii)
 	if (!gbIsMultiplayer)
 		return;
 
-	TCmdPItem *pD = sgLevels[currlevel].item;
+	TCmdPItem *pD = GetDeltaLevel(currlevel).item;
 	for (i = 0; i < MAXITEMS; i++, pD++) {
 		if (pD->bCmd != 0xFF
 		    && pD->wIndx == items[ii].IDidx
@@ -661,7 +723,7 @@ void DeltaAddItem(int ii)
 		}
 	}
 
-	pD = sgLevels[currlevel].item;
+	pD = GetDeltaLevel(currlevel).item;
 	for (i = 0; i < MAXITEMS; i++, pD++) {
 		if (pD->bCmd == 0xFF) {
 			sgbDeltaChanged = true;
@@ -712,19 +774,20 @@ void DeltaLoadLevel()
 	if (!gbIsMultiplayer)
 		return;
 
+	DLevel &deltaLevel = GetDeltaLevel(currlevel);
 	deltaload = true;
 	if (currlevel != 0) {
 		for (i = 0; i < nummonsters; i++) {
-			if (sgLevels[currlevel].monster[i]._mx != 0xFF) {
+			if (deltaLevel.monster[i]._mx != 0xFF) {
 				M_ClearSquares(i);
-				x = sgLevels[currlevel].monster[i]._mx;
-				y = sgLevels[currlevel].monster[i]._my;
+				x = deltaLevel.monster[i]._mx;
+				y = deltaLevel.monster[i]._my;
 				monster[i].position.tile = { x, y };
 				monster[i].position.old = { x, y };
 				monster[i].position.future = { x, y };
-				if (sgLevels[currlevel].monster[i]._mhitpoints != -1)
-					monster[i]._mhitpoints = sgLevels[currlevel].monster[i]._mhitpoints;
-				if (sgLevels[currlevel].monster[i]._mhitpoints == 0) {
+				if (deltaLevel.monster[i]._mhitpoints != -1)
+					monster[i]._mhitpoints = deltaLevel.monster[i]._mhitpoints;
+				if (deltaLevel.monster[i]._mhitpoints == 0) {
 					M_ClearSquares(i);
 					if (monster[i]._mAi != AI_DIABLO) {
 						if (monster[i]._uniqtype == 0) {
@@ -737,16 +800,17 @@ void DeltaLoadLevel()
 					monster[i]._mDelFlag = true;
 					M_UpdateLeader(i);
 				} else {
-					decode_enemy(i, sgLevels[currlevel].monster[i]._menemy);
+					decode_enemy(i, deltaLevel.monster[i]._menemy);
 					if ((monster[i].position.tile.x && monster[i].position.tile.x != 1) || monster[i].position.tile.y)
 						dMonster[monster[i].position.tile.x][monster[i].position.tile.y] = i + 1;
 					if (i < MAX_PLRS) {
 						MAI_Golum(i);
 						monster[i]._mFlags |= (MFLAG_TARGETS_MONSTER | MFLAG_GOLEM);
+						InvalidateMonsterTargets();
 					} else {
 						M_StartStand(i, monster[i]._mdir);
 					}
-					monster[i]._msquelch = sgLevels[currlevel].monster[i]._mactive;
+					monster[i]._msquelch = deltaLevel.monster[i]._mactive;
 				}
 			}
 		}
@@ -754,57 +818,57 @@ void DeltaLoadLevel()
 	}
 
 	for (i = 0; i < MAXITEMS; i++) {
-		if (sgLevels[currlevel].item[i].bCmd != 0xFF) {
-			if (sgLevels[currlevel].item[i].bCmd == CMD_WALKXY) {
+		if (deltaLevel.item[i].bCmd != 0xFF) {
+			if (deltaLevel.item[i].bCmd == CMD_WALKXY) {
 				int ii = FindGetItem(
-				    sgLevels[currlevel].item[i].wIndx,
-				    sgLevels[currlevel].item[i].wCI,
-				    sgLevels[currlevel].item[i].dwSeed);
+				    deltaLevel.item[i].wIndx,
+				    deltaLevel.item[i].wCI,
+				    deltaLevel.item[i].dwSeed);
 				if (ii != -1) {
 					if (dItem[items[ii].position.x][items[ii].position.y] == ii + 1)
 						dItem[items[ii].position.x][items[ii].position.y] = 0;
 					DeleteItem(ii, i);
 				}
 			}
-			if (sgLevels[currlevel].item[i].bCmd == CMD_ACK_PLRINFO) {
+			if (deltaLevel.item[i].bCmd == CMD_ACK_PLRINFO) {
 				int ii = AllocateItem();
 
-				if (sgLevels[currlevel].item[i].wIndx == IDI_EAR) {
+				if (deltaLevel.item[i].wIndx == IDI_EAR) {
 					RecreateEar(
 					    ii,
-					    sgLevels[currlevel].item[i].wCI,
-					    sgLevels[currlevel].item[i].dwSeed,
-					    sgLevels[currlevel].item[i].bId,
-					    sgLevels[currlevel].item[i].bDur,
-					    sgLevels[currlevel].item[i].bMDur,
-					    sgLevels[currlevel].item[i].bCh,
-					    sgLevels[currlevel].item[i].bMCh,
-					    sgLevels[currlevel].item[i].wValue,
-					    sgLevels[currlevel].item[i].dwBuff);
+					    deltaLevel.item[i].wCI,
+					    deltaLevel.item[i].dwSeed,
+					    deltaLevel.item[i].bId,
+					    deltaLevel.item[i].bDur,
+					    deltaLevel.item[i].bMDur,
+					    deltaLevel.item[i].bCh,
+					    deltaLevel.item[i].bMCh,
+					    deltaLevel.item[i].wValue,
+					    deltaLevel.item[i].dwBuff);
 				} else {
 					RecreateItem(
 					    ii,
-					    sgLevels[currlevel].item[i].wIndx,
-					    sgLevels[currlevel].item[i].wCI,
-					    sgLevels[currlevel].item[i].dwSeed,
-					    sgLevels[currlevel].item[i].wValue,
-					    (sgLevels[currlevel].item[i].dwBuff & CF_HELLFIRE) != 0);
-					if (sgLevels[currlevel].item[i].bId)
+					    deltaLevel.item[i].wIndx,
+					    deltaLevel.item[i].wCI,
+					    deltaLevel.item[i].dwSeed,
+					    deltaLevel.item[i].wValue,
+					    (deltaLevel.item[i].dwBuff & CF_HELLFIRE) != 0);
+					if (deltaLevel.item[i].bId)
 						items[ii]._iIdentified = true;
-					items[ii]._iDurability = sgLevels[currlevel].item[i].bDur;
-					items[ii]._iMaxDur = sgLevels[currlevel].item[i].bMDur;
-					items[ii]._iCharges = sgLevels[currlevel].item[i].bCh;
-					items[ii]._iMaxCharges = sgLevels[currlevel].item[i].bMCh;
-					items[ii]._iPLToHit = sgLevels[currlevel].item[i].wToHit;
-					items[ii]._iMaxDam = sgLevels[currlevel].item[i].wMaxDam;
-					items[ii]._iMinStr = sgLevels[currlevel].item[i].bMinStr;
-					items[ii]._iMinMag = sgLevels[currlevel].item[i].bMinMag;
-					items[ii]._iMinDex = sgLevels[currlevel].item[i].bMinDex;
-					items[ii]._iAC = sgLevels[currlevel].item[i].bAC;
-					items[ii].dwBuff = sgLevels[currlevel].item[i].dwBuff;
+					items[ii]._iDurability = deltaLevel.item[i].bDur;
+					items[ii]._iMaxDur = deltaLevel.item[i].bMDur;
+					items[ii]._iCharges = deltaLevel.item[i].bCh;
+					items[ii]._iMaxCharges = deltaLevel.item[i].bMCh;
+					items[ii]._iPLToHit = deltaLevel.item[i].wToHit;
+					items[ii]._iMaxDam = deltaLevel.item[i].wMaxDam;
+					items[ii]._iMinStr = deltaLevel.item[i].bMinStr;
+					items[ii]._iMinMag = deltaLevel.item[i].bMinMag;
+					items[ii]._iMinDex = deltaLevel.item[i].bMinDex;
+					items[ii]._iAC = deltaLevel.item[i].bAC;
+					items[ii].dwBuff = deltaLevel.item[i].dwBuff;
 				}
-				x = sgLevels[currlevel].item[i].x;
-				y = sgLevels[currlevel].item[i].y;
+				x = deltaLevel.item[i].x;
+				y = deltaLevel.item[i].y;
 				if (!CanPut({ x, y })) {
 					done = false;
 					for (k = 1; k < 50 && !done; k++) {
@@ -830,12 +894,12 @@ void DeltaLoadLevel()
 
 	if (currlevel != 0) {
 		for (i = 0; i < MAXOBJECTS; i++) {
-			switch (sgLevels[currlevel].object[i].bCmd) {
+			switch (deltaLevel.object[i].bCmd) {
 			case CMD_OPENDOOR:
 			case CMD_CLOSEDOOR:
 			case CMD_OPERATEOBJ:
 			case CMD_PLROPOBJ:
-				SyncOpObject(-1, sgLevels[currlevel].object[i].bCmd, i);
+				SyncOpObject(-1, deltaLevel.object[i].bCmd, i);
 				break;
 			case CMD_BREAKOBJ:
 				SyncBreakObj(-1, i);
@@ -2509,12 +2573,10 @@ static DWORD On_OPENCRYPT(TCmd *pCmd)
 	return sizeof(*pCmd);
 }
 
-DWORD ParseCmd(int pnum, TCmd *pCmd)
-{
-	sbLastCmd = pCmd->bCmd;
-	if (sgwPackPlrOffsetTbl[pnum] != 0 && sbLastCmd != CMD_ACK_PLRINFO && sbLastCmd != CMD_SEND_PLRINFO)
-		return 0;
+static std::array<CommandStats, 256> sgCommandStats;
 
+static DWORD DispatchCmd(int pnum, TCmd *pCmd)
+{
 	switch (pCmd->bCmd) {
 	case CMD_SYNCDATA:
 		return On_SYNCDATA(pCmd, pnum);
@@ -2684,4 +2746,180 @@ DWORD ParseCmd(int pnum, TCmd *pCmd)
 	return On_DLEVEL(pnum, pCmd);
 }
 
+/**
+ * @brief Determines the size of a command before it is handled, from its type and for variable sized commands their header
+ * @param pCmd The command
+ * @param maxSize Number of bytes left in the packet, starting at the command
+ * @return The size of the command, or 0 if the command is unknown or doesn't fit into maxSize
+ */
+static size_t GetCmdSize(const TCmd *pCmd, size_t maxSize)
+{
+	size_t size;
+	switch (pCmd->bCmd) {
+	case CMD_SYNCDATA:
+		if (maxSize < sizeof(TSyncHeader))
+			return 0;
+		size = sizeof(TSyncHeader) + reinterpret_cast<const TSyncHeader *>(pCmd)->wLen;
+		break;
+	case CMD_STRING: {
+		// The string is sent up to and including its nul terminator
+		const char *str = reinterpret_cast<const TCmdString *>(pCmd)->str;
+		const void *terminator = memchr(str, '\0', std::min<size_t>(maxSize - sizeof(pCmd->bCmd), MAX_SEND_STR_LEN));
+		if (terminator == nullptr)
+			return 0;
+		size = static_cast<const char *>(terminator) - str + 2;
+	} break;
+	case CMD_SEND_PLRINFO:
+	case CMD_ACK_PLRINFO:
+		if (maxSize < sizeof(TCmdPlrInfoHdr))
+			return 0;
+		size = sizeof(TCmdPlrInfoHdr) + reinterpret_cast<const TCmdPlrInfoHdr *>(pCmd)->wBytes;
+		break;
+	case CMD_DEBUG:
+	case CMD_DEACTIVATEPORTAL:
+	case CMD_RETOWN:
+	case CMD_ENDSHIELD:
+	case CMD_CHEAT_EXPERIENCE:
+	case CMD_CHEAT_SPELL_LEVEL:
+	case CMD_SETSHIELD:
+	case CMD_REMSHIELD:
+	case CMD_REFLECT:
+	case CMD_NAKRUL:
+	case CMD_OPENCRYPT:
+		size = sizeof(TCmd);
+		break;
+	case CMD_WALKXY:
+	case CMD_ATTACKXY:
+	case CMD_SATTACKXY:
+	case CMD_RATTACKXY:
+	case CMD_NOVA:
+		size = sizeof(TCmdLoc);
+		break;
+	case CMD_ADDSTR:
+	case CMD_ADDDEX:
+	case CMD_ADDMAG:
+	case CMD_ADDVIT:
+	case CMD_SBSPELL:
+	case CMD_OPOBJT:
+	case CMD_ATTACKID:
+	case CMD_ATTACKPID:
+	case CMD_RATTACKID:
+	case CMD_RATTACKPID:
+	case CMD_KNOCKBACK:
+	case CMD_RESURRECT:
+	case CMD_HEALOTHER:
+	case CMD_WARP:
+	case CMD_PLRDEAD:
+	case CMD_OPENDOOR:
+	case CMD_CLOSEDOOR:
+	case CMD_OPERATEOBJ:
+	case CMD_PLRLEVEL:
+	case CMD_SETSTR:
+	case CMD_SETMAG:
+	case CMD_SETDEX:
+	case CMD_SETVIT:
+		size = sizeof(TCmdParam1);
+		break;
+	case CMD_NEWLVL:
+	case CMD_PLROPOBJ:
+	case CMD_BREAKOBJ:
+		size = sizeof(TCmdParam2);
+		break;
+	case CMD_SPELLID:
+	case CMD_SPELLPID:
+	case CMD_TSPELLID:
+	case CMD_TSPELLPID:
+		size = sizeof(TCmdParam3);
+		break;
+	case CMD_GOTOGETITEM:
+	case CMD_GOTOAGETITEM:
+	case CMD_OPOBJXY:
+	case CMD_DISARMXY:
+	case CMD_TALKXY:
+	case CMD_MONSTDEATH:
+	case CMD_KILLGOLEM:
+	case CMD_PLAYER_JOINLEVEL:
+		size = sizeof(TCmdLocParam1);
+		break;
+	case CMD_SPELLXY:
+	case CMD_TSPELLXY:
+	case CMD_OPENHIVE:
+		size = sizeof(TCmdLocParam2);
+		break;
+	case CMD_SPELLXYD:
+	case CMD_ACTIVATEPORTAL:
+		size = sizeof(TCmdLocParam3);
+		break;
+	case CMD_REQUESTGITEM:
+	case CMD_GETITEM:
+	case CMD_REQUESTAGITEM:
+	case CMD_AGETITEM:
+	case CMD_ITEMEXTRA:
+		size = sizeof(TCmdGItem);
+		break;
+	case CMD_PUTITEM:
+	case CMD_SYNCPUTITEM:
+	case CMD_RESPAWNITEM:
+	case CMD_DROPITEM:
+		size = sizeof(TCmdPItem);
+		break;
+	case CMD_AWAKEGOLEM:
+		size = sizeof(TCmdGolem);
+		break;
+	case CMD_MONSTDAMAGE:
+		size = sizeof(TCmdMonDamage);
+		break;
+	case CMD_PLRDAMAGE:
+		size = sizeof(TCmdDamage);
+		break;
+	case CMD_CHANGEPLRITEMS:
+		size = sizeof(TCmdChItem);
+		break;
+	case CMD_DELPLRITEMS:
+		size = sizeof(TCmdDelItem);
+		break;
+	case CMD_SYNCQUEST:
+		size = sizeof(TCmdQuest);
+		break;
+	default:
+		if (pCmd->bCmd < CMD_DLEVEL_0 || pCmd->bCmd > CMD_DLEVEL_END)
+			return 0;
+		if (maxSize < sizeof(TCmdPlrInfoHdr))
+			return 0;
+		size = sizeof(TCmdPlrInfoHdr) + reinterpret_cast<const TCmdPlrInfoHdr *>(pCmd)->wBytes;
+		break;
+	}
+
+	if (size > maxSize)
+		return 0;
+	return size;
+}
+
+DWORD ParseCmd(int pnum, TCmd *pCmd, size_t maxSize)
+{
+	if (GetCmdSize(pCmd, maxSize) == 0) {
+		// Unknown, truncated or with a length that runs past the end of the packet
+		SNetDropPlayer(pnum, LEAVE_DROP);
+		return 0;
+	}
+
+	sbLastCmd = pCmd->bCmd;
+	if (sgwPackPlrOffsetTbl[pnum] != 0 && sbLastCmd != CMD_ACK_PLRINFO && sbLastCmd != CMD_SEND_PLRINFO)
+		return 0;
+
+	const BYTE cmd = sbLastCmd;
+	const Uint64 start = SDL_GetPerformanceCounter();
+	const DWORD size = DispatchCmd(pnum, pCmd);
+	CommandStats &stats = sgCommandStats[cmd];
+	stats.count++;
+	stats.bytes += size;
+	stats.handlerTicks += SDL_GetPerformanceCounter() - start;
+	return size;
+}
+
+const std::array<CommandStats, 256> &GetCommandStats()
+{
+	return sgCommandStats;
+}
+
 } // namespace devilution
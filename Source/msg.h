@@ -5,6 +5,7 @@
  */
 #pragma once
 
+#include <array>
 #include <cstdint>
 
 #include "quests.h"
@@ -451,6 +452,24 @@ void NetSendCmdDamage(bool bHiPri, uint8_t bPlr, DWORD dwDam);
 void NetSendCmdMonDmg(bool bHiPri, uint16_t bMon, DWORD dwDam);
 void NetSendCmdString(uint32_t pmask, const char *pszStr);
 void delta_close_portal(int pnum);
-DWORD ParseCmd(int pnum, TCmd *pCmd);
+/**
+ * @brief Handles a received command, the sender is dropped if it is unknown or malformed
+ * @param maxSize Number of bytes left in the packet, starting at the command
+ * @return The size of the command, 0 if it was not handled
+ */
+DWORD ParseCmd(int pnum, TCmd *pCmd, size_t maxSize);
+
+/** Received commands of one type, see GetCommandStats */
+struct CommandStats {
+	uint32_t count;
+	uint64_t bytes;
+	/** Time spent in the handler, in SDL performance counter ticks */
+	uint64_t handlerTicks;
+};
+
+/**
+ * @brief Counters of every command handled by ParseCmd since the program started, indexed by _cmd_id
+ */
+const std::array<CommandStats, 256> &GetCommandStats();
 
 } // namespace devilution
@@ -17,10 +17,12 @@
 #include "options.h"
 #include "pfile.h"
 #include "plrmsg.h"
+#include "replay.h"
 #include "storm/storm.h"
 #include "sync.h"
 #include "tmsg.h"
 #include "utils/language.h"
+#include "utils/log.hpp"
 
 namespace devilution {
 
@@ -52,6 +54,15 @@ char szPlayerName[128];
 BYTE gbDeltaSender;
 bool sgbNetInited;
 uint32_t player_state[MAX_PLRS];
+/** Commands sent this tick that are still to be delivered, batched into a single message */
+static TPkt sgPendingPkt;
+static DWORD sgdwPendingLen;
+static int sgnPendingPlayer;
+/** Level each player was last seen on and how many of their turns arrived since they settled there */
+static int sgnSeenLevel[MAX_PLRS];
+static int sgnTurnsOnSeenLevel[MAX_PLRS];
+/** Turns a player has to send from their level before level-local commands for other levels are left out */
+constexpr int SettleTurns = 20;
 
 /**
  * Contains the set of supported event types supported by the multiplayer
@@ -89,7 +100,47 @@ static void multi_copy_packet(TBuffer *buf, byte *packet, uint8_t size)
 	p[size] = byte { 0 };
 }
 
-static byte *multi_recv_packet(TBuffer *pBuf, byte *body, DWORD *size)
+/**
+ * @brief Checks if a command only affects players on the same level as its sender
+ *
+ * Their handlers ignore them on any other level without recording anything in the deltas.
+ */
+static bool IsLevelLocalCmd(byte cmd)
+{
+	switch (static_cast<_cmd_id>(cmd)) {
+	case CMD_WALKXY:
+	case CMD_GOTOGETITEM:
+	case CMD_GOTOAGETITEM:
+	case CMD_ATTACKXY:
+	case CMD_SATTACKXY:
+	case CMD_RATTACKXY:
+	case CMD_SPELLXYD:
+	case CMD_SPELLXY:
+	case CMD_TSPELLXY:
+	case CMD_OPOBJXY:
+	case CMD_DISARMXY:
+	case CMD_OPOBJT:
+	case CMD_ATTACKID:
+	case CMD_ATTACKPID:
+	case CMD_RATTACKID:
+	case CMD_RATTACKPID:
+	case CMD_SPELLID:
+	case CMD_SPELLPID:
+	case CMD_TSPELLID:
+	case CMD_TSPELLPID:
+	case CMD_KNOCKBACK:
+	case CMD_HEALOTHER:
+	case CMD_TALKXY:
+		return true;
+	default:
+		return false;
+	}
+}
+
+/**
+ * @param otherLevelBody If set, the commands that also matter to players on other levels are copied here as well
+ */
+static byte *multi_recv_packet(TBuffer *pBuf, byte *body, DWORD *size, byte **otherLevelBody = nullptr)
 {
 	if (pBuf->dwNextWriteOffset != 0) {
 		byte *src_ptr = pBuf->bData;
@@ -102,6 +153,10 @@ static byte *multi_recv_packet(TBuffer *pBuf, byte *body, DWORD *size)
 			src_ptr++;
 			memcpy(body, src_ptr, chunk_size);
 			body += chunk_size;
+			if (otherLevelBody != nullptr && !IsLevelLocalCmd(*src_ptr)) {
+				memcpy(*otherLevelBody, src_ptr, chunk_size);
+				*otherLevelBody += chunk_size;
+			}
 			src_ptr += chunk_size;
 			*size -= chunk_size;
 		}
@@ -135,17 +190,81 @@ void multi_msg_add(byte *pbMsg, BYTE bLen)
 	}
 }
 
-static void multi_send_packet(int playerId, void *packet, BYTE dwSize)
+/**
+ * @brief Sends the commands batched by multi_send_packet
+ */
+static void multi_flush_packets()
 {
-	TPkt pkt;
+	if (sgdwPendingLen == 0)
+		return;
 
-	NetRecvPlrData(&pkt);
-	pkt.hdr.wLen = dwSize + sizeof(pkt.hdr);
-	memcpy(pkt.body, packet, dwSize);
-	if (!SNetSendMessage(playerId, &pkt.hdr, pkt.hdr.wLen))
+	NetRecvPlrData(&sgPendingPkt);
+	sgPendingPkt.hdr.wLen = sgdwPendingLen + sizeof(sgPendingPkt.hdr);
+	sgdwPendingLen = 0;
+	if (!SNetSendMessage(sgnPendingPlayer, &sgPendingPkt.hdr, sgPendingPkt.hdr.wLen))
 		nthread_terminate_game("SNetSendMessage0");
 }
 
+static void multi_send_packet(int playerId, void *packet, BYTE dwSize)
+{
+	if (sgdwPendingLen != 0 && (playerId != sgnPendingPlayer || sgdwPendingLen + dwSize > sizeof(sgPendingPkt.body)))
+		multi_flush_packets();
+
+	sgnPendingPlayer = playerId;
+	memcpy(&sgPendingPkt.body[sgdwPendingLen], packet, dwSize);
+	sgdwPendingLen += dwSize;
+}
+
+/**
+ * @brief Counts a turn received from a player towards them having settled on their level
+ *
+ * A player only sends CMD_PLAYER_JOINLEVEL once their level is loaded, and their turns arrive in order,
+ * so every turn that follows it until the next level change was sent from that level.
+ */
+static void multi_count_turn_on_level(int pnum)
+{
+	const PlayerStruct &player = plr[pnum];
+	if (player._pLvlChanging || player.plrlevel != sgnSeenLevel[pnum]) {
+		sgnSeenLevel[pnum] = player._pLvlChanging ? -1 : player.plrlevel;
+		sgnTurnsOnSeenLevel[pnum] = 0;
+		return;
+	}
+	if (sgnTurnsOnSeenLevel[pnum] < SettleTurns)
+		sgnTurnsOnSeenLevel[pnum]++;
+}
+
+/**
+ * @brief Checks if a player has acknowledged being on a different level than the local player, so level-local commands can be left out
+ *
+ * Our view of another player's level lags behind, a player that just changed level may already be
+ * loading ours and buffering the commands for it. So players in transition, and players that haven't
+ * sent SettleTurns turns from their new level yet, get the full packet.
+ */
+static bool multi_player_settled_elsewhere(int pnum)
+{
+	const PlayerStruct &player = plr[pnum];
+	return player.plractive && !player._pLvlChanging && !plr[myplr]._pLvlChanging
+	    && player.plrlevel != plr[myplr].plrlevel && player.plrlevel == sgnSeenLevel[pnum]
+	    && sgnTurnsOnSeenLevel[pnum] >= SettleTurns;
+}
+
+/**
+ * @brief Checks if any other player gets the packet without the level-local commands
+ * @param otherLevel Set for each player that does
+ */
+static bool multi_players_on_other_levels(bool (&otherLevel)[MAX_PLRS])
+{
+	if (sgGameInitInfo.bSplitPacketsByLevel == 0)
+		return false;
+
+	bool any = false;
+	for (int i = 0; i < MAX_PLRS; i++) {
+		otherLevel[i] = i != myplr && multi_player_settled_elsewhere(i);
+		any = any || otherLevel[i];
+	}
+	return any;
+}
+
 void NetSendLoPri(int playerId, byte *pbMsg, BYTE bLen)
 {
 	if (pbMsg && bLen) {
@@ -167,13 +286,38 @@ void NetSendHiPri(int playerId, byte *pbMsg, BYTE bLen)
 		gbShouldValidatePackage = true;
 		NetRecvPlrData(&pkt);
 		size = gdwNormalMsgSize - sizeof(TPktHdr);
-		byte *hipri_body = multi_recv_packet(&sgHiPriBuf, pkt.body, &size);
-		byte *lowpri_body = multi_recv_packet(&sgLoPriBuf, hipri_body, &size);
+		// Players on other levels get a copy without the commands that would only be ignored there
+		bool otherLevel[MAX_PLRS];
+		const bool splitByLevel = multi_players_on_other_levels(otherLevel);
+		TPkt otherLevelPkt;
+		byte *otherLevelBody = otherLevelPkt.body;
+		byte **otherLevelDst = splitByLevel ? &otherLevelBody : nullptr;
+		byte *hipri_body = multi_recv_packet(&sgHiPriBuf, pkt.body, &size, otherLevelDst);
+		byte *lowpri_body = multi_recv_packet(&sgLoPriBuf, hipri_body, &size, otherLevelDst);
 		size = sync_all_monsters(lowpri_body, size);
 		len = gdwNormalMsgSize - size;
 		pkt.hdr.wLen = len;
-		if (!SNetSendMessage(-2, &pkt.hdr, len))
-			nthread_terminate_game("SNetSendMessage");
+		if (!splitByLevel) {
+			if (!SNetSendMessage(-2, &pkt.hdr, len))
+				nthread_terminate_game("SNetSendMessage");
+			return;
+		}
+
+		// Monster sync data goes to everyone, the other levels keep it in their deltas
+		const size_t syncSize = pkt.body + (len - sizeof(pkt.hdr)) - lowpri_body;
+		memcpy(otherLevelBody, lowpri_body, syncSize);
+		otherLevelBody += syncSize;
+		otherLevelPkt.hdr = pkt.hdr;
+		otherLevelPkt.hdr.wLen = otherLevelBody - reinterpret_cast<byte *>(&otherLevelPkt);
+		for (int i = 0; i < MAX_PLRS; i++) {
+			if (i == myplr)
+				continue;
+			TPkt &out = otherLevel[i] ? otherLevelPkt : pkt;
+			if (!SNetSendMessage(i, &out.hdr, out.hdr.wLen) && SErrGetLastError() != STORM_ERROR_INVALID_PLAYER) {
+				nthread_terminate_game("SNetSendMessage");
+				return;
+			}
+		}
 	}
 }
 
@@ -182,6 +326,7 @@ void multi_send_msg_packet(uint32_t pmask, byte *src, BYTE len)
 	DWORD v, p, t;
 	TPkt pkt;
 
+	multi_flush_packets();
 	NetRecvPlrData(&pkt);
 	t = len + sizeof(pkt.hdr);
 	pkt.hdr.wLen = t;
@@ -196,7 +341,7 @@ void multi_send_msg_packet(uint32_t pmask, byte *src, BYTE len)
 	}
 }
 
-static void multi_mon_seeds()
+void multi_mon_seeds()
 {
 	int i;
 	DWORD l;
@@ -260,6 +405,7 @@ static void multi_player_left_msg(int pnum, bool left)
 		DeactivatePortal(pnum);
 		delta_close_portal(pnum);
 		RemovePlrMissiles(pnum);
+		sgnSeenLevel[pnum] = -1;
 		if (left) {
 			pszFmt = _("Player '{:s}' just left the game");
 			switch (sgdwPlayerLeftReasonTbl[pnum]) {
@@ -304,10 +450,42 @@ void multi_player_left(int pnum, int reason)
 	multi_clear_left_tbl();
 }
 
+static void multi_log_net_stats()
+{
+	NetStats stats;
+	if (!SNetGetNetStats(&stats))
+		return;
+
+	Log("Network: {} turns in transit, {} frames waiting to be sent, {} bytes sent", stats.turnsInTransit, stats.sendQueueDepth, stats.bytesSent);
+	for (int i = 0; i < MAX_PLRS; i++) {
+		const NetPeerStats &peer = stats.peers[i];
+		if (!peer.connected)
+			continue;
+		Log("Network: player {}: {} turns queued, last packet {} ms ago, {} ms between turns, {} ms jitter, {} bytes received",
+		    i, peer.turnsQueued, peer.msSinceLastPacket, peer.turnIntervalMs, peer.turnJitterMs, peer.bytesReceived);
+	}
+}
+
+uint32_t multi_timeout_grace()
+{
+	uint32_t jitter = 0;
+	NetStats stats;
+	if (SNetGetNetStats(&stats)) {
+		for (const NetPeerStats &peer : stats.peers) {
+			if (peer.connected)
+				jitter = std::max(jitter, peer.turnJitterMs);
+		}
+	}
+
+	// A few times the usual spread between turns covers the normal hiccups of a connection
+	return clamp<uint32_t>(2 * gnTickDelay + 4 * jitter, 100, 1000);
+}
+
 void multi_net_ping()
 {
 	sgbTimeout = true;
 	sglTimeoutStart = SDL_GetTicks();
+	multi_log_net_stats();
 }
 
 static void multi_check_drop_player()
@@ -424,12 +602,14 @@ bool multi_handle_delta()
 	return true;
 }
 
-static void multi_handle_all_packets(int pnum, byte *pData, int nSize)
+void multi_handle_all_packets(int pnum, byte *pData, int nSize)
 {
 	int nLen;
 
+	ReplayRecordPackets(pnum, pData, nSize);
+
 	while (nSize != 0) {
-		nLen = ParseCmd(pnum, (TCmd *)pData);
+		nLen = ParseCmd(pnum, (TCmd *)pData, nSize);
 		if (nLen == 0) {
 			break;
 		}
@@ -457,6 +637,7 @@ void multi_process_network_packets()
 	bool cond;
 	char *data;
 
+	multi_flush_packets();
 	multi_clear_left_tbl();
 	multi_process_tmsgs();
 	while (SNetReceiveMessage(&dwID, &data, (int *)&dwMsgSize)) {
@@ -474,6 +655,7 @@ void multi_process_network_packets()
 		plr[dwID].position.last = { pkt->px, pkt->py };
 		if (dwID != myplr) {
 			assert(gbBufferMsgs != 2);
+			multi_count_turn_on_level(dwID);
 			plr[dwID]._pHitPoints = pkt->php;
 			plr[dwID]._pMaxHP = pkt->pmhp;
 			cond = gbBufferMsgs == 1;
@@ -715,11 +897,18 @@ bool NetInit(bool bSinglePlayer)
 		sgGameInitInfo.bTheoQuest = sgOptions.Gameplay.bTheoQuest;
 		sgGameInitInfo.bCowQuest = sgOptions.Gameplay.bCowQuest;
 		sgGameInitInfo.bFriendlyFire = sgOptions.Gameplay.bFriendlyFire;
+		sgGameInitInfo.bSharedMonsterPathing = sgOptions.Gameplay.bSharedMonsterPathing;
+		sgGameInitInfo.bIdleMonstersSleep = sgOptions.Gameplay.bIdleMonstersSleep;
+		sgGameInitInfo.bBatchPackets = sgOptions.Network.bBatchPackets;
+		sgGameInitInfo.bCompressPackets = sgOptions.Network.bCompressPackets;
+		sgGameInitInfo.bSplitPacketsByLevel = sgOptions.Network.bSplitPacketsByLevel;
 		memset(sgbPlayerTurnBitTbl, 0, sizeof(sgbPlayerTurnBitTbl));
 		gbGameDestroyed = false;
 		memset(sgbPlayerLeftGameTbl, 0, sizeof(sgbPlayerLeftGameTbl));
 		memset(sgdwPlayerLeftReasonTbl, 0, sizeof(sgdwPlayerLeftReasonTbl));
 		memset(sgbSendDeltaTbl, 0, sizeof(sgbSendDeltaTbl));
+		for (int &level : sgnSeenLevel)
+			level = -1;
 		for (auto &player : plr) {
 			player.Reset();
 		}
@@ -738,6 +927,7 @@ bool NetInit(bool bSinglePlayer)
 		InitPlrMsg();
 		buffer_init(&sgHiPriBuf);
 		buffer_init(&sgLoPriBuf);
+		sgdwPendingLen = 0;
 		gbShouldValidatePackage = false;
 		sync_init();
 		nthread_start(sgbPlayerTurnBitTbl[myplr]);
@@ -881,6 +1071,9 @@ void recv_plrinfo(int pnum, TCmdPlrInfoHdr *p, bool recv)
 			dFlags[plr[pnum].position.tile.x][plr[pnum].position.tile.y] |= BFLAG_DEAD_PLAYER;
 		}
 	}
+
+	// Only the sheet shown right away was read, the others are loaded as they get used so have them in memory by then
+	PrefetchPlayerGFX(player);
 }
 
 } // namespace devilution
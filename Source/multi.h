@@ -33,6 +33,11 @@ struct GameData {
 	uint8_t bTheoQuest;
 	uint8_t bCowQuest;
 	uint8_t bFriendlyFire;
+	uint8_t bSharedMonsterPathing;
+	uint8_t bIdleMonstersSleep;
+	uint8_t bBatchPackets;
+	uint8_t bCompressPackets;
+	uint8_t bSplitPacketsByLevel;
 };
 
 extern bool gbSomebodyWonGameKludge;
@@ -46,13 +51,25 @@ extern bool gbIsMultiplayer;
 extern char szPlayerName[128];
 extern BYTE gbDeltaSender;
 extern uint32_t player_state[MAX_PLRS];
+extern DWORD sgdwGameLoops;
 
 void multi_msg_add(byte *pbMsg, BYTE bLen);
+/** @brief Advance the game loop counter and reseed the monster AI from it. */
+void multi_mon_seeds();
+void multi_handle_all_packets(int pnum, byte *pData, int nSize);
 void NetSendLoPri(int playerId, byte *pbMsg, BYTE bLen);
 void NetSendHiPri(int playerId, byte *pbMsg, BYTE bLen);
 void multi_send_msg_packet(uint32_t pmask, byte *src, BYTE len);
 void multi_msg_countdown();
 void multi_player_left(int pnum, int reason);
+/**
+ * @brief How long the game keeps running its normal screen while waiting for a turn
+ *
+ * Sized from the measured turn jitter, so connections that are just uneven don't flash the network timeout.
+ * This only delays the timeout screen: the game still waits for the turn, since the turn delay has to be the
+ * same on every peer and commands can't run ahead of their turn without desyncing the game.
+ */
+uint32_t multi_timeout_grace();
 void multi_net_ping();
 bool multi_handle_delta();
 void multi_process_network_packets();
@@ -7,6 +7,7 @@
 #include "diablo.h"
 #include "gmenu.h"
 #include "storm/storm.h"
+#include "utils/profiler.h"
 #include "utils/thread.h"
 
 namespace devilution {
@@ -121,11 +122,14 @@ static unsigned int nthread_handler(void *data)
 			sgMemCrit.Enter();
 			if (!nthread_should_run)
 				break;
-			nthread_send_and_recv_turn(0, 0);
-			if (nthread_recv_turns(&received))
-				delta = last_tick - SDL_GetTicks();
-			else
-				delta = gnTickDelay;
+			{
+				ProfileScope profileScope("NetworkTurn");
+				nthread_send_and_recv_turn(0, 0);
+				if (nthread_recv_turns(&received))
+					delta = last_tick - SDL_GetTicks();
+				else
+					delta = gnTickDelay;
+			}
 			sgMemCrit.Leave();
 			if (delta > 0)
 				SDL_Delay(delta);
@@ -161,6 +165,7 @@ void nthread_start(bool set_turn_upper_bit)
 		err = SDL_GetError();
 		app_fatal("SNetGetProviderCaps:\n%s", err);
 	}
+	// Every peer has to use the same value, the turn numbers reseed sgdwGameLoops and with it the monster AI
 	gdwTurnsInTransit = caps.defaultturnsintransit;
 	if (!caps.defaultturnsintransit)
 		gdwTurnsInTransit = 1;
@@ -253,9 +258,9 @@ void nthread_UpdateProgressToNextGameTick()
 	int ticksAdvanced = gnTickDelay - ticksElapsed;
 	float fraction = (float)ticksAdvanced / (float)gnTickDelay;
 	if (fraction > 1.0f)
-		gfProgressToNextGameTick = 1.0f;
+		fraction = 1.0f;
 	if (fraction < 0.0f)
-		gfProgressToNextGameTick = 0.0f;
+		fraction = 0.0f;
 	gfProgressToNextGameTick = fraction;
 }
 
@@ -13,6 +13,7 @@
 #include "drlg_l1.h"
 #include "drlg_l4.h"
 #include "error.h"
+#include "flowfield.h"
 #include "init.h"
 #include "lighting.h"
 #include "minitext.h"
@@ -24,7 +25,9 @@
 #include "towners.h"
 #include "track.h"
 #include "utils/language.h"
+#include "utils/level_arena.h"
 #include "utils/log.hpp"
+#include "utils/profiler.h"
 
 namespace devilution {
 
@@ -68,7 +71,8 @@ enum shrine_type : uint8_t {
 
 int trapid;
 int trapdir;
-std::unique_ptr<byte[]> pObjCels[40];
+/** Owned by the level memory, see AllocateLevelMemory */
+byte *pObjCels[40];
 object_graphic_id ObjFileList[40];
 int objectactive[MAXOBJECTS];
 /** Specifies the number of active objects. */
@@ -76,6 +80,11 @@ int nobjects;
 int leverid;
 int objectavail[MAXOBJECTS];
 ObjectStruct object[MAXOBJECTS];
+/** Objects that have to be updated every tick, in the same order as in objectactive. */
+static int objectticking[MAXOBJECTS];
+static int nobjectticking;
+/** Set when an object may be missing from objectticking. */
+static bool objectTickListDirty = true;
 bool InitObjFlag;
 bool LoadMapObjsFlag;
 int numobjfiles;
@@ -281,7 +290,7 @@ _speech_id StoryText[3][3] = {
 void InitObjectGFX()
 {
 	bool fileload[56];
-	char filestr[32];
+	char filestr[40][32];
 	int i, j;
 
 	memset(fileload, false, sizeof(fileload));
@@ -310,18 +319,23 @@ void InitObjectGFX()
 		}
 	}
 
+	const int first = numobjfiles;
 	for (int i = OFILE_L1BRAZ; i <= OFILE_LZSTAND; i++) {
 		if (fileload[i]) {
 			ObjFileList[numobjfiles] = (object_graphic_id)i;
-			sprintf(filestr, "Objects\\%s.CEL", ObjMasterLoadList[i]);
+			sprintf(filestr[numobjfiles], "Objects\\%s.CEL", ObjMasterLoadList[i]);
 			if (currlevel >= 17 && currlevel < 21)
-				sprintf(filestr, "Objects\\%s.CEL", ObjHiveLoadList[i]);
+				sprintf(filestr[numobjfiles], "Objects\\%s.CEL", ObjHiveLoadList[i]);
 			else if (currlevel >= 21)
-				sprintf(filestr, "Objects\\%s.CEL", ObjCryptLoadList[i]);
-			pObjCels[numobjfiles] = LoadFileInMem(filestr);
+				sprintf(filestr[numobjfiles], "Objects\\%s.CEL", ObjCryptLoadList[i]);
 			numobjfiles++;
 		}
 	}
+
+	// The files don't depend on each other, read them all at once
+	ParallelLoad(numobjfiles - first, [&](unsigned j) {
+		pObjCels[first + j] = LoadFileInLevelMemory(filestr[first + j]);
+	});
 }
 
 void FreeObjectGFX()
@@ -351,6 +365,69 @@ bool RndLocOk(int xp, int yp)
 	return false;
 }
 
+namespace {
+
+/**
+ * @brief Remembers the cells where RndLocOk failed during one placement routine
+ *
+ * Placing objects only ever takes cells, so a cell that failed stays unusable and the random
+ * placement loops can reject most candidate areas with a few bit tests instead of testing every
+ * cell of them again.
+ */
+class PlacementMask {
+public:
+	/**
+	 * @brief Whether RndLocOk holds for every cell of the area
+	 */
+	bool AreaOk(int x, int y, int width, int height)
+	{
+		if (x < 0 || y < 0 || x + width > MAXDUNX || y + height > MAXDUNY) {
+			for (int yy = y; yy < y + height; yy++) {
+				for (int xx = x; xx < x + width; xx++) {
+					if (!RndLocOk(xx, yy))
+						return false;
+				}
+			}
+			return true;
+		}
+
+		for (int yy = y; yy < y + height; yy++) {
+			if (BlockedBits(x, yy, width) != 0)
+				return false;
+		}
+		for (int yy = y; yy < y + height; yy++) {
+			for (int xx = x; xx < x + width; xx++) {
+				if (!RndLocOk(xx, yy)) {
+					blocked_[yy][xx / 64] |= uint64_t { 1 } << (xx % 64);
+					return false;
+				}
+			}
+		}
+		return true;
+	}
+
+private:
+	uint64_t BlockedBits(int x, int y, int width) const
+	{
+		const uint64_t *row = blocked_[y];
+		uint64_t bits;
+		if (x >= 64)
+			bits = row[1] >> (x - 64);
+		else if (x == 0)
+			bits = row[0];
+		else
+			bits = (row[0] >> x) | (row[1] << (64 - x));
+		return bits & ((uint64_t { 1 } << width) - 1);
+	}
+
+	/** Bit x % 64 of blocked_[y][x / 64] is set once RndLocOk failed at x, y */
+	uint64_t blocked_[MAXDUNY][2] = {};
+};
+
+static_assert(MAXDUNX <= 128, "PlacementMask stores a row in two words");
+
+} // namespace
+
 static bool WallTrapLocOkK(int xp, int yp)
 {
 	if ((dFlags[xp][yp] & BFLAG_POPULATED) != 0)
@@ -368,19 +445,12 @@ void InitRndLocObj(int min, int max, _object_id objtype)
 
 	numobjs = GenerateRnd(max - min) + min;
 
+	PlacementMask mask;
 	for (i = 0; i < numobjs; i++) {
 		while (true) {
 			xp = GenerateRnd(80) + 16;
 			yp = GenerateRnd(80) + 16;
-			if (RndLocOk(xp - 1, yp - 1)
-			    && RndLocOk(xp, yp - 1)
-			    && RndLocOk(xp + 1, yp - 1)
-			    && RndLocOk(xp - 1, yp)
-			    && RndLocOk(xp, yp)
-			    && RndLocOk(xp + 1, yp)
-			    && RndLocOk(xp - 1, yp + 1)
-			    && RndLocOk(xp, yp + 1)
-			    && RndLocOk(xp + 1, yp + 1)) {
+			if (mask.AreaOk(xp - 1, yp - 1, 3, 3)) {
 				AddObject(objtype, xp, yp);
 				break;
 			}
@@ -393,22 +463,12 @@ void InitRndLocBigObj(int min, int max, _object_id objtype)
 	int i, xp, yp, numobjs;
 
 	numobjs = GenerateRnd(max - min) + min;
+	PlacementMask mask;
 	for (i = 0; i < numobjs; i++) {
 		while (true) {
 			xp = GenerateRnd(80) + 16;
 			yp = GenerateRnd(80) + 16;
-			if (RndLocOk(xp - 1, yp - 2)
-			    && RndLocOk(xp, yp - 2)
-			    && RndLocOk(xp + 1, yp - 2)
-			    && RndLocOk(xp - 1, yp - 1)
-			    && RndLocOk(xp, yp - 1)
-			    && RndLocOk(xp + 1, yp - 1)
-			    && RndLocOk(xp - 1, yp)
-			    && RndLocOk(xp, yp)
-			    && RndLocOk(xp + 1, yp)
-			    && RndLocOk(xp - 1, yp + 1)
-			    && RndLocOk(xp, yp + 1)
-			    && RndLocOk(xp + 1, yp + 1)) {
+			if (mask.AreaOk(xp - 1, yp - 2, 3, 4)) {
 				AddObject(objtype, xp, yp);
 				break;
 			}
@@ -419,22 +479,17 @@ void InitRndLocBigObj(int min, int max, _object_id objtype)
 void InitRndLocObj5x5(int min, int max, _object_id objtype)
 {
 	bool exit;
-	int xp, yp, numobjs, i, cnt, m, n;
+	int xp, yp, numobjs, i, cnt;
 
 	numobjs = min + GenerateRnd(max - min);
+	PlacementMask mask;
 	for (i = 0; i < numobjs; i++) {
 		cnt = 0;
 		exit = false;
 		while (!exit) {
-			exit = true;
 			xp = GenerateRnd(80) + 16;
 			yp = GenerateRnd(80) + 16;
-			for (n = -2; n <= 2; n++) {
-				for (m = -2; m <= 2; m++) {
-					if (!RndLocOk(xp + m, yp + n))
-						exit = false;
-				}
-			}
+			exit = mask.AreaOk(xp - 2, yp - 2, 5, 5);
 			if (!exit) {
 				cnt++;
 				if (cnt > 20000)
@@ -451,6 +506,7 @@ void ClrAllObjects()
 
 	memset(object, 0, sizeof(object));
 	nobjects = 0;
+	InvalidateObjectTickList();
 	for (i = 0; i < MAXOBJECTS; i++) {
 		objectavail[i] = i;
 	}
@@ -498,20 +554,15 @@ void AddCandles()
 void AddBookLever(int x1, int y1, int x2, int y2, _speech_id msg)
 {
 	bool exit;
-	int xp, yp, ob, cnt, m, n;
+	int xp, yp, ob, cnt;
 
+	PlacementMask mask;
 	cnt = 0;
 	exit = false;
 	while (!exit) {
-		exit = true;
 		xp = GenerateRnd(80) + 16;
 		yp = GenerateRnd(80) + 16;
-		for (n = -2; n <= 2; n++) {
-			for (m = -2; m <= 2; m++) {
-				if (!RndLocOk(xp + m, yp + n))
-					exit = false;
-			}
-		}
+		exit = mask.AreaOk(xp - 2, yp - 2, 5, 5);
 		if (!exit) {
 			cnt++;
 			if (cnt > 20000)
@@ -548,11 +599,12 @@ void InitRndBarrels()
 	int i;
 
 	numobjs = GenerateRnd(5) + 3;
+	PlacementMask mask;
 	for (i = 0; i < numobjs; i++) {
 		do {
 			xp = GenerateRnd(80) + 16;
 			yp = GenerateRnd(80) + 16;
-		} while (!RndLocOk(xp, yp));
+		} while (!mask.AreaOk(xp, yp, 1, 1));
 		o = (GenerateRnd(4) != 0) ? OBJ_BARREL : OBJ_BARRELEX;
 		AddObject(o, xp, yp);
 		found = true;
@@ -567,7 +619,7 @@ void InitRndBarrels()
 				dir = GenerateRnd(8);
 				xp += bxadd[dir];
 				yp += byadd[dir];
-				found = RndLocOk(xp, yp);
+				found = mask.AreaOk(xp, yp, 1, 1);
 				t++;
 				if (found)
 					break;
@@ -840,20 +892,15 @@ void AddDiabObjs()
 void objects_add_lv22(int s)
 {
 	bool exit;
-	int xp, yp, cnt, m, n;
+	int xp, yp, cnt;
 
+	PlacementMask mask;
 	cnt = 0;
 	exit = false;
 	while (!exit) {
-		exit = true;
 		xp = GenerateRnd(80) + 16;
 		yp = GenerateRnd(80) + 16;
-		for (n = -2; n <= 2; n++) {
-			for (m = -3; m <= 3; m++) {
-				if (!RndLocOk(xp + m, yp + n))
-					exit = false;
-			}
-		}
+		exit = mask.AreaOk(xp - 3, yp - 2, 7, 5);
 		if (!exit) {
 			cnt++;
 			if (cnt > 20000)
@@ -913,22 +960,17 @@ void objects_454AF0(int a1, int a2, int a3)
 
 void AddStoryBooks()
 {
-	int xp, yp, xx, yy;
+	int xp, yp;
 	int cnt;
 	bool done;
 
+	PlacementMask mask;
 	cnt = 0;
 	done = false;
 	while (!done) {
-		done = true;
 		xp = GenerateRnd(80) + 16;
 		yp = GenerateRnd(80) + 16;
-		for (yy = -2; yy <= 2; yy++) {
-			for (xx = -3; xx <= 3; xx++) {
-				if (!RndLocOk(xx + xp, yy + yp))
-					done = false;
-			}
-		}
+		done = mask.AreaOk(xp - 3, yp - 2, 7, 5);
 		if (!done) {
 			cnt++;
 			if (cnt > 20000)
@@ -1002,22 +1044,17 @@ void AddL4Goodies()
 
 void AddLazStand()
 {
-	int xp, yp, xx, yy;
+	int xp, yp;
 	int cnt;
 	bool found;
 
+	PlacementMask mask;
 	cnt = 0;
 	found = false;
 	while (!found) {
-		found = true;
 		xp = GenerateRnd(80) + 16;
 		yp = GenerateRnd(80) + 16;
-		for (yy = -3; yy <= 3; yy++) {
-			for (xx = -2; xx <= 3; xx++) {
-				if (!RndLocOk(xp + xx, yp + yy))
-					found = false;
-			}
-		}
+		found = mask.AreaOk(xp - 2, yp - 3, 6, 7);
 		if (!found) {
 			cnt++;
 			if (cnt > 10000) {
@@ -1229,7 +1266,7 @@ void SetMapObjects(const uint16_t *dunData, int startx, int starty)
 
 		ObjFileList[numobjfiles] = (object_graphic_id)i;
 		sprintf(filestr, "Objects\\%s.CEL", ObjMasterLoadList[i]);
-		pObjCels[numobjfiles] = LoadFileInMem(filestr);
+		pObjCels[numobjfiles] = LoadFileInLevelMemory(filestr);
 		numobjfiles++;
 	}
 
@@ -1252,10 +1289,12 @@ void DeleteObject_(int oi, int i)
 	ox = object[oi].position.x;
 	oy = object[oi].position.y;
 	dObject[ox][oy] = 0;
+	InvalidateFlowFields();
 	objectavail[-nobjects + MAXOBJECTS] = oi;
 	nobjects--;
 	if (nobjects > 0 && i != nobjects)
 		objectactive[i] = objectactive[nobjects];
+	InvalidateObjectTickList();
 }
 
 void SetupObject(int i, int x, int y, _object_id ot)
@@ -1272,8 +1311,9 @@ void SetupObject(int i, int x, int y, _object_id ot)
 
 	const int j = std::distance(std::begin(ObjFileList), found);
 
-	object[i]._oAnimData = pObjCels[j].get();
+	object[i]._oAnimData = pObjCels[j];
 	object[i]._oAnimFlag = AllObjects[ot].oAnimFlag;
+	InvalidateObjectTickList();
 	if (AllObjects[ot].oAnimFlag != 0) {
 		object[i]._oAnimDelay = AllObjects[ot].oAnimDelay;
 		object[i]._oAnimCnt = GenerateRnd(AllObjects[ot].oAnimDelay);
@@ -1295,6 +1335,7 @@ void SetupObject(int i, int x, int y, _object_id ot)
 	object[i]._oPreFlag = false;
 	object[i]._oTrapFlag = false;
 	object[i]._oDoorFlag = false;
+	InvalidateFlowFields();
 }
 
 void SetObjMapRange(int i, int x1, int y1, int x2, int y2, int v)
@@ -1513,6 +1554,7 @@ void AddArmorStand(int i)
 {
 	if (!armorFlag) {
 		object[i]._oAnimFlag = 2;
+		InvalidateObjectTickList();
 		object[i]._oSelFlag = 0;
 	}
 
@@ -1602,6 +1644,7 @@ void AddWeaponRack(int i)
 {
 	if (!weaponFlag) {
 		object[i]._oAnimFlag = 2;
+		InvalidateObjectTickList();
 		object[i]._oSelFlag = 0;
 	}
 	object[i]._oRndSeed = AdvanceRndSeed();
@@ -1617,11 +1660,12 @@ void AddTorturedBody(int i)
 void GetRndObjLoc(int randarea, int *xx, int *yy)
 {
 	bool failed;
-	int i, j, tries;
+	int tries;
 
 	if (randarea == 0)
 		return;
 
+	PlacementMask mask;
 	tries = 0;
 	while (true) {
 		tries++;
@@ -1629,12 +1673,7 @@ void GetRndObjLoc(int randarea, int *xx, int *yy)
 			randarea--;
 		*xx = GenerateRnd(MAXDUNX);
 		*yy = GenerateRnd(MAXDUNY);
-		failed = false;
-		for (i = 0; i < randarea && !failed; i++) {
-			for (j = 0; j < randarea && !failed; j++) {
-				failed = !RndLocOk(i + *xx, j + *yy);
-			}
-		}
+		failed = !mask.AreaOk(*xx, *yy, randarea, randarea);
 		if (!failed)
 			break;
 	}
@@ -2016,6 +2055,7 @@ void ActivateTrapLine(int ttype, int tid)
 		if (object[oi]._otype == ttype && object[oi]._oVar1 == tid) {
 			object[oi]._oVar4 = 1;
 			object[oi]._oAnimFlag = 1;
+			InvalidateObjectTickList();
 			object[oi]._oAnimDelay = 1;
 			object[oi]._olid = AddLight(object[oi].position, 1);
 		}
@@ -2150,13 +2190,90 @@ void Obj_BCrossDamage(int i)
 	}
 }
 
+/**
+ * @brief Check if an object has to be updated every tick
+ *
+ * Idle objects have nothing to update until operating or breaking them starts their animation,
+ * which calls InvalidateObjectTickList().
+ */
+static bool ObjectTicks(const ObjectStruct &obj)
+{
+	if (obj._oAnimFlag != 0)
+		return true;
+
+	switch (obj._otype) {
+	case OBJ_L1LIGHT:
+	case OBJ_SKFIRE:
+	case OBJ_CANDLE2:
+	case OBJ_BOOKCANDLE:
+	case OBJ_STORYCANDLE:
+	case OBJ_L1LDOOR:
+	case OBJ_L1RDOOR:
+	case OBJ_L2LDOOR:
+	case OBJ_L2RDOOR:
+	case OBJ_L3LDOOR:
+	case OBJ_L3RDOOR:
+	case OBJ_TORCHL:
+	case OBJ_TORCHR:
+	case OBJ_TORCHL2:
+	case OBJ_TORCHR2:
+	case OBJ_FLAMEHOLE:
+	case OBJ_TRAPL:
+	case OBJ_TRAPR:
+	case OBJ_MCIRCLE1:
+	case OBJ_MCIRCLE2:
+	case OBJ_BCROSS:
+	case OBJ_TBCROSS:
+		return true;
+	default:
+		return false;
+	}
+}
+
+static void RebuildObjectTickList()
+{
+	nobjectticking = 0;
+	for (int i = 0; i < nobjects; i++) {
+		const int oi = objectactive[i];
+		if (ObjectTicks(object[oi])) {
+			objectticking[nobjectticking++] = oi;
+			continue;
+		}
+		// Cruxes, barrels and shrines park their last frame once, leave them in the same state
+		switch (object[oi]._otype) {
+		case OBJ_CRUX1:
+		case OBJ_CRUX2:
+		case OBJ_CRUX3:
+		case OBJ_BARREL:
+		case OBJ_BARRELEX:
+		case OBJ_SHRINEL:
+		case OBJ_SHRINER:
+			Obj_StopAnim(oi);
+			break;
+		default:
+			break;
+		}
+	}
+	objectTickListDirty = false;
+}
+
+void InvalidateObjectTickList()
+{
+	objectTickListDirty = true;
+}
+
 void ProcessObjects()
 {
+	ProfileScope profileScope(ProfilePhase::ProcessObjects);
+
 	int oi;
 	int i;
 
-	for (i = 0; i < nobjects; ++i) {
-		oi = objectactive[i];
+	if (objectTickListDirty)
+		RebuildObjectTickList();
+
+	for (i = 0; i < nobjectticking; ++i) {
+		oi = objectticking[i];
 		switch (object[oi]._otype) {
 		case OBJ_L1LIGHT:
 			Obj_Light(oi, 10);
@@ -2241,17 +2358,9 @@ void ProcessObjects()
 
 void ObjSetMicro(int dx, int dy, int pn)
 {
+	InvalidateFlowFields();
 	dPiece[dx][dy] = pn;
-	pn--;
-
-	int blocks = leveltype != DTYPE_HELL ? 10 : 16;
-
-	uint16_t *piece = &pLevelPieces[blocks * pn];
-	MICROS &micros = dpiece_defs_map_2[dx][dy];
-
-	for (int i = 0; i < blocks; i++) {
-		micros.mt[i] = SDL_SwapLE16(piece[blocks - 2 + (i & 1) - (i & 0xE)]);
-	}
+	SetTileMicros(dx, dy);
 }
 
 void objects_set_door_piece(int x, int y)
@@ -2260,8 +2369,10 @@ void objects_set_door_piece(int x, int y)
 
 	uint16_t *piece = &pLevelPieces[10 * pn + 8];
 
-	dpiece_defs_map_2[x][y].mt[0] = SDL_SwapLE16(piece[0]);
-	dpiece_defs_map_2[x][y].mt[1] = SDL_SwapLE16(piece[1]);
+	MICROS micros = LevelPieceMicros[dPieceMicros[x][y]];
+	micros.mt[0] = SDL_SwapLE16(piece[0]);
+	micros.mt[1] = SDL_SwapLE16(piece[1]);
+	dPieceMicros[x][y] = AddTileMicros(micros);
 }
 
 void ObjSetMini(int x, int y, int v)
@@ -2438,6 +2549,19 @@ void RedoPlayerVision()
 	}
 }
 
+void RedoPlayerVision(Point position)
+{
+	for (int p = 0; p < MAX_PLRS; p++) {
+		if (!plr[p].plractive || currlevel != plr[p].plrlevel)
+			continue;
+		// A change outside the player's vision radius can't change what they see, doors also touch their neighbours
+		Point distance = abs(plr[p].position.tile - position);
+		if (std::max(distance.x, distance.y) > plr[p]._pLightRad + 1)
+			continue;
+		ChangeVisionXY(plr[p]._pvid, plr[p].position.tile);
+	}
+}
+
 void OperateL1RDoor(int pnum, int oi, bool sendflag)
 {
 	int xp, yp;
@@ -2473,7 +2597,7 @@ void OperateL1RDoor(int pnum, int oi, bool sendflag)
 		DoorSet(oi, xp - 1, yp);
 		object[oi]._oVar4 = 1;
 		object[oi]._oSelFlag = 2;
-		RedoPlayerVision();
+		RedoPlayerVision(object[oi].position);
 		return;
 	}
 
@@ -2512,7 +2636,7 @@ void OperateL1RDoor(int pnum, int oi, bool sendflag)
 		dSpecial[xp][yp] = 0;
 		object[oi]._oAnimFrame -= 2;
 		object[oi]._oPreFlag = false;
-		RedoPlayerVision();
+		RedoPlayerVision(object[oi].position);
 	} else {
 		object[oi]._oVar4 = 2;
 	}
@@ -2556,7 +2680,7 @@ void OperateL1LDoor(int pnum, int oi, bool sendflag)
 		DoorSet(oi, xp, yp - 1);
 		object[oi]._oVar4 = 1;
 		object[oi]._oSelFlag = 2;
-		RedoPlayerVision();
+		RedoPlayerVision(object[oi].position);
 		return;
 	}
 
@@ -2595,7 +2719,7 @@ void OperateL1LDoor(int pnum, int oi, bool sendflag)
 		dSpecial[xp][yp] = 0;
 		object[oi]._oAnimFrame -= 2;
 		object[oi]._oPreFlag = false;
-		RedoPlayerVision();
+		RedoPlayerVision(object[oi].position);
 	} else {
 		object[oi]._oVar4 = 2;
 	}
@@ -2624,7 +2748,7 @@ void OperateL2RDoor(int pnum, int oi, bool sendflag)
 		object[oi]._oPreFlag = true;
 		object[oi]._oVar4 = 1;
 		object[oi]._oSelFlag = 2;
-		RedoPlayerVision();
+		RedoPlayerVision(object[oi].position);
 		return;
 	}
 
@@ -2642,7 +2766,7 @@ void OperateL2RDoor(int pnum, int oi, bool sendflag)
 		dSpecial[xp][yp] = 0;
 		object[oi]._oAnimFrame -= 2;
 		object[oi]._oPreFlag = false;
-		RedoPlayerVision();
+		RedoPlayerVision(object[oi].position);
 	} else {
 		object[oi]._oVar4 = 2;
 	}
@@ -2671,7 +2795,7 @@ void OperateL2LDoor(int pnum, int oi, bool sendflag)
 		object[oi]._oPreFlag = true;
 		object[oi]._oVar4 = 1;
 		object[oi]._oSelFlag = 2;
-		RedoPlayerVision();
+		RedoPlayerVision(object[oi].position);
 		return;
 	}
 
@@ -2689,7 +2813,7 @@ void OperateL2LDoor(int pnum, int oi, bool sendflag)
 		dSpecial[xp][yp] = 0;
 		object[oi]._oAnimFrame -= 2;
 		object[oi]._oPreFlag = false;
-		RedoPlayerVision();
+		RedoPlayerVision(object[oi].position);
 	} else {
 		object[oi]._oVar4 = 2;
 	}
@@ -2718,7 +2842,7 @@ void OperateL3RDoor(int pnum, int oi, bool sendflag)
 		object[oi]._oPreFlag = true;
 		object[oi]._oVar4 = 1;
 		object[oi]._oSelFlag = 2;
-		RedoPlayerVision();
+		RedoPlayerVision(object[oi].position);
 		return;
 	}
 
@@ -2735,7 +2859,7 @@ void OperateL3RDoor(int pnum, int oi, bool sendflag)
 		ObjSetMicro(xp, yp, 534);
 		object[oi]._oAnimFrame -= 2;
 		object[oi]._oPreFlag = false;
-		RedoPlayerVision();
+		RedoPlayerVision(object[oi].position);
 	} else {
 		object[oi]._oVar4 = 2;
 	}
@@ -2764,7 +2888,7 @@ void OperateL3LDoor(int pnum, int oi, bool sendflag)
 		object[oi]._oPreFlag = true;
 		object[oi]._oVar4 = 1;
 		object[oi]._oSelFlag = 2;
-		RedoPlayerVision();
+		RedoPlayerVision(object[oi].position);
 		return;
 	}
 
@@ -2781,7 +2905,7 @@ void OperateL3LDoor(int pnum, int oi, bool sendflag)
 		ObjSetMicro(xp, yp, 531);
 		object[oi]._oAnimFrame -= 2;
 		object[oi]._oPreFlag = false;
-		RedoPlayerVision();
+		RedoPlayerVision(object[oi].position);
 	} else {
 		object[oi]._oVar4 = 2;
 	}
@@ -3235,8 +3359,10 @@ void OperateTrapLvr(int i)
 		oi = objectactive[j];
 		if (object[oi]._otype == object[i]._oVar2 && object[oi]._oVar1 == object[i]._oVar1) {
 			object[oi]._oVar2 = 0;
-			if (object[oi]._oVar4 != 0)
+			if (object[oi]._oVar4 != 0) {
 				object[oi]._oAnimFlag = 1;
+				InvalidateObjectTickList();
+			}
 		}
 	}
 }
@@ -3251,6 +3377,7 @@ void OperateSarc(int pnum, int i, bool sendmsg)
 			object[i]._oAnimFrame = object[i]._oAnimLen;
 		} else {
 			object[i]._oAnimFlag = 1;
+			InvalidateObjectTickList();
 			object[i]._oAnimDelay = 3;
 			SetRndSeed(object[i]._oRndSeed);
 			if (object[i]._oVar1 <= 2)
@@ -3478,6 +3605,8 @@ bool OperateShrineGloomy(int pnum)
 		}
 	}
 
+	InvalidateItemStats(plr[pnum]);
+
 	for (int j = 0; j < plr[pnum]._pNumInv; j++) {
 		switch (plr[pnum].InvList[j]._itype) {
 		case ITYPE_SWORD:
@@ -3518,6 +3647,8 @@ bool OperateShrineWeird(int pnum)
 	if (!plr[pnum].InvBody[INVLOC_HAND_RIGHT].isEmpty() && plr[pnum].InvBody[INVLOC_HAND_RIGHT]._itype != ITYPE_SHIELD)
 		plr[pnum].InvBody[INVLOC_HAND_RIGHT]._iMaxDam++;
 
+	InvalidateItemStats(plr[pnum]);
+
 	for (int j = 0; j < plr[pnum]._pNumInv; j++) {
 		switch (plr[pnum].InvList[j]._itype) {
 		case ITYPE_SWORD:
@@ -4326,6 +4457,7 @@ void OperateShrine(int pnum, int i, _sfx_id sType)
 	if (!deltaload) {
 		PlaySfxLoc(sType, object[i].position.x, object[i].position.y);
 		object[i]._oAnimFlag = 1;
+		InvalidateObjectTickList();
 		object[i]._oAnimDelay = 1;
 	} else {
 		object[i]._oAnimFrame = object[i]._oAnimLen;
@@ -5102,12 +5234,14 @@ void BreakCrux(int i)
 	bool triggered;
 
 	object[i]._oAnimFlag = 1;
+	InvalidateObjectTickList();
 	object[i]._oAnimFrame = 1;
 	object[i]._oAnimDelay = 1;
 	object[i]._oSolidFlag = true;
 	object[i]._oMissFlag = true;
 	object[i]._oBreak = -1;
 	object[i]._oSelFlag = 0;
+	InvalidateFlowFields();
 	triggered = true;
 	for (j = 0; j < nobjects; j++) {
 		oi = objectactive[j];
@@ -5148,6 +5282,7 @@ void BreakBarrel(int pnum, int i, int dam, bool forcebreak, bool sendmsg)
 
 	object[i]._oVar1 = 0;
 	object[i]._oAnimFlag = 1;
+	InvalidateObjectTickList();
 	object[i]._oAnimFrame = 1;
 	object[i]._oAnimDelay = 1;
 	object[i]._oSolidFlag = false;
@@ -5155,6 +5290,7 @@ void BreakBarrel(int pnum, int i, int dam, bool forcebreak, bool sendmsg)
 	object[i]._oBreak = -1;
 	object[i]._oSelFlag = 0;
 	object[i]._oPreFlag = true;
+	InvalidateFlowFields();
 	if (deltaload) {
 		object[i]._oAnimFrame = object[i]._oAnimLen;
 		object[i]._oAnimCnt = 0;
@@ -5393,7 +5529,7 @@ void SyncObjectAnim(int o)
 
 	const int i = std::distance(std::begin(ObjFileList), found);
 
-	object[o]._oAnimData = pObjCels[i].get();
+	object[o]._oAnimData = pObjCels[i];
 	switch (object[o]._otype) {
 	case OBJ_L1LDOOR:
 	case OBJ_L1RDOOR:
@@ -5612,18 +5748,11 @@ void objects_rnd_454BEA()
 {
 	int xp, yp;
 
+	PlacementMask mask;
 	while (true) {
 		xp = GenerateRnd(80) + 16;
 		yp = GenerateRnd(80) + 16;
-		if (RndLocOk(xp - 1, yp - 1)
-		    && RndLocOk(xp, yp - 1)
-		    && RndLocOk(xp + 1, yp - 1)
-		    && RndLocOk(xp - 1, yp)
-		    && RndLocOk(xp, yp)
-		    && RndLocOk(xp + 1, yp)
-		    && RndLocOk(xp - 1, yp + 1)
-		    && RndLocOk(xp, yp + 1)
-		    && RndLocOk(xp + 1, yp + 1)) {
+		if (mask.AreaOk(xp - 1, yp - 1, 3, 3)) {
 			break;
 		}
 	}
@@ -69,9 +69,17 @@ void objects_44DA68(int a1, int a2);
 void objects_454AF0(int a1, int a2, int a3);
 void AddObject(_object_id ot, int ox, int oy);
 void Obj_Trap(int i);
+/**
+ * @brief Must be called when an object is added or removed or starts animating
+ */
+void InvalidateObjectTickList();
 void ProcessObjects();
 void ObjSetMicro(int dx, int dy, int pn);
 void RedoPlayerVision();
+/**
+ * @brief Update the vision of the players that can see the given tile, after it changed from blocking to transparent or back
+ */
+void RedoPlayerVision(Point position);
 void MonstCheckDoors(int m);
 void ObjChangeMap(int x1, int y1, int x2, int y2);
 void ObjChangeMapResync(int x1, int y1, int x2, int y2);
@@ -36,6 +36,10 @@ struct AudioOptions {
 	std::uint32_t nBufferSize;
 	/** @brief Quality of the resampler, from 0 (lowest) to 10 (highest) */
 	std::uint8_t nResamplingQuality;
+	/** @brief Memory budget for loaded sound effects in KiB, the least recently played are freed first (0 keeps all). */
+	std::uint32_t nSfxCacheSize;
+	/** @brief Resample sound effects to the output rate once when loading them instead of every time they play. */
+	bool bResampleOnLoad;
 };
 
 struct GraphicsOptions {
@@ -53,6 +57,10 @@ struct GraphicsOptions {
 	char szScaleQuality[2];
 	/** @brief Only scale by values divisible by the width and height. */
 	bool bIntegerScaling;
+	/** @brief Scale by whole factors without filtering and only filter the remaining fraction (SDL 2.0.12+). */
+	bool bSharpScaling;
+	/** @brief Skip sharp scaling while frames take longer than the display refresh. */
+	bool bAdaptiveScaling;
 	/** @brief Enable vsync on the output. */
 	bool bVSync;
 	/** @brief Use blended transparency rather than stippled. */
@@ -63,10 +71,24 @@ struct GraphicsOptions {
 	bool bColorCycling;
 	/** @brief Use a hardware cursor (SDL2 only). */
 	bool bHardwareCursor;
+	/** @brief Draw the menus with the renderer from textures of the UI art (SDL2 only). */
+	bool bHardwareUi;
+	/** @brief Convert the 8-bit frame straight into the renderer texture instead of through a 32-bit surface (SDL2 only). */
+	bool bPalettedPresent;
 	/** @brief Enable FPS Limit. */
 	bool bFPSLimit;
 	/** @brief Show FPS, even without the -f command line flag. */
 	bool bShowFPS;
+	/** @brief Memory budget for decoded level tiles in KiB, shared by the render threads (0 disables the cache). */
+	std::uint32_t nTileCacheSize;
+	/** @brief Memory budget for lit monster and player frames in KiB per render thread (0 disables the cache). */
+	std::uint32_t nLitSpriteCacheSize;
+	/** @brief Memory budget for monster sprite sheets the current level doesn't use in KiB, kept for later levels (0 disables the cache). */
+	std::uint32_t nMonsterSpriteCacheSize;
+	/** @brief Only redraw the parts of the dungeon view that changed since the previous frame. */
+	bool bIncrementalRedraw;
+	/** @brief Number of threads rendering the dungeon view (0 uses one per CPU core). */
+	int nRenderThreads;
 };
 
 struct GameplayOptions {
@@ -110,6 +132,12 @@ struct GameplayOptions {
 	bool bShowMonsterType;
 	/** @brief Locally disable clicking on shrines which permanently cripple character. */
 	bool bDisableCripplingShrines;
+	/** @brief Let monsters chasing the same target share one distance map instead of searching a path each. */
+	bool bSharedMonsterPathing;
+	/** @brief Skip the AI of idle monsters that are far away from all players. */
+	bool bIdleMonstersSleep;
+	/** @brief Compression of saves and of levels sent to joining players, from 1 (fastest) to 3 (smallest). */
+	int nCompressionLevel;
 };
 
 struct ControllerOptions {
@@ -134,6 +162,16 @@ struct NetworkOptions {
 	char szPreviousHost[129];
 	/** @brief What network port to use. */
 	uint16_t nPort;
+	/** @brief Send the commands and turn of a game tick as one packet, decided by the player hosting the game. */
+	bool bBatchPackets;
+	/** @brief Compress the batched packets, decided by the player hosting the game. */
+	bool bCompressPackets;
+	/** @brief Leave commands that only matter on the sender's level out of the packets for players elsewhere, decided by the player hosting the game. */
+	bool bSplitPacketsByLevel;
+	/** @brief Show the traffic and turn timing of each player in multiplayer games. */
+	bool bShowNetStats;
+	/** @brief Bring the ZeroTier node online in the background at launch, so it is ready when a game is joined. */
+	bool bStartZeroTierOnLaunch;
 };
 
 struct ChatOptions {
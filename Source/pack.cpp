@@ -236,6 +236,7 @@ void UnPackPlayer(const PkPlayerStruct *pPack, int pnum, bool netSync)
 		bool isHellfire = netSync ? ((packedItem.dwBuff & CF_HELLFIRE) != 0) : pPack->bIsHellfire;
 		UnPackItem(&packedItem, &player.InvBody[i], isHellfire);
 	}
+	InvalidateItemStats(player);
 
 	for (int i = 0; i < NUM_INV_GRID_ELEM; i++) {
 		auto packedItem = pPack->InvList[i];
@@ -4,6 +4,11 @@
  * Implementation of functions for handling the engines color palette.
  */
 
+#include <algorithm>
+#include <array>
+#include <memory>
+#include <vector>
+
 #include "dx.h"
 #include "hwcursor.hpp"
 #include "options.h"
@@ -32,17 +37,33 @@ void palette_update()
 	pal_surface_palette_version++;
 }
 
-void ApplyGamma(SDL_Color *dst, const SDL_Color *src, int n)
+namespace {
+
+/** Gamma corrected value of every color channel value, for the gamma in GammaTableCorrection */
+std::array<Uint8, 256> GammaTable;
+int GammaTableCorrection = -1;
+
+const std::array<Uint8, 256> &GetGammaTable()
 {
-	int i;
-	double g;
+	if (GammaTableCorrection != sgOptions.Graphics.nGammaCorrection) {
+		GammaTableCorrection = sgOptions.Graphics.nGammaCorrection;
+		const double g = GammaTableCorrection / 100.0;
+		for (int i = 0; i < 256; i++)
+			GammaTable[i] = static_cast<Uint8>(pow(i / 256.0, g) * 256.0);
+	}
+	return GammaTable;
+}
+
+} // namespace
 
-	g = sgOptions.Graphics.nGammaCorrection / 100.0;
+void ApplyGamma(SDL_Color *dst, const SDL_Color *src, int n)
+{
+	const std::array<Uint8, 256> &gammaTable = GetGammaTable();
 
-	for (i = 0; i < n; i++) {
-		dst[i].r = pow(src[i].r / 256.0, g) * 256.0;
-		dst[i].g = pow(src[i].g / 256.0, g) * 256.0;
-		dst[i].b = pow(src[i].b / 256.0, g) * 256.0;
+	for (int i = 0; i < n; i++) {
+		dst[i].r = gammaTable[src[i].r];
+		dst[i].g = gammaTable[src[i].g];
+		dst[i].b = gammaTable[src[i].b];
 	}
 	force_redraw = 255;
 }
@@ -66,41 +87,130 @@ void palette_init()
 	InitPalette();
 }
 
-static Uint8 FindBestMatchForColor(SDL_Color *palette, SDL_Color color, int skipFrom, int skipTo)
+namespace {
+
+/**
+ * @brief Nearest color search over a palette, sorted by the red component so most colors can be skipped
+ *
+ * Gives the same result as a linear search: the closest color with the lowest index.
+ */
+class ColorMatcher {
+public:
+	ColorMatcher(const SDL_Color *palette, int skipFrom, int skipTo)
+	{
+		for (int i = 0; i < 256; i++) {
+			if (i >= skipFrom && i <= skipTo)
+				continue;
+			entries_[count_++] = { palette[i].r, palette[i].g, palette[i].b, static_cast<Uint8>(i) };
+		}
+		std::sort(entries_.begin(), entries_.begin() + count_, [](const Entry &a, const Entry &b) {
+			return a.r < b.r || (a.r == b.r && a.index < b.index);
+		});
+	}
+
+	Uint8 FindBestMatch(SDL_Color color) const
+	{
+		const auto *begin = entries_.data();
+		const auto *end = begin + count_;
+		const auto *pos = std::lower_bound(begin, end, color.r, [](const Entry &entry, Uint8 r) { return entry.r < r; });
+
+		Uint8 best = 0;
+		Uint32 bestDiff = SDL_MAX_UINT32;
+		const auto check = [&](const Entry &entry) {
+			int diffr = entry.r - color.r;
+			Uint32 diffr2 = diffr * diffr;
+			if (diffr2 > bestDiff)
+				return false;
+			int diffg = entry.g - color.g;
+			int diffb = entry.b - color.b;
+			Uint32 diff = diffr2 + diffg * diffg + diffb * diffb;
+			if (diff < bestDiff || (diff == bestDiff && entry.index < best)) {
+				best = entry.index;
+				bestDiff = diff;
+			}
+			return true;
+		};
+		// Walk away from the closest red value in both directions until red alone is too far off.
+		for (const auto *it = pos; it != end && check(*it); ++it) {
+		}
+		for (const auto *it = pos; it != begin && check(*(it - 1)); --it) {
+		}
+		return best;
+	}
+
+private:
+	struct Entry {
+		Uint8 r;
+		Uint8 g;
+		Uint8 b;
+		Uint8 index;
+	};
+
+	std::array<Entry, 256> entries_;
+	int count_ = 0;
+};
+
+/**
+ * @brief Blended lookup tables generated earlier, so that returning to a level doesn't need to generate them again
+ */
+struct CachedBlendTable {
+	std::array<SDL_Color, 256> palette;
+	int skipFrom;
+	int skipTo;
+	std::unique_ptr<Uint8[][256]> lookup;
+};
+
+/** Least recently used entries first. */
+std::vector<CachedBlendTable> BlendTableCache;
+constexpr std::size_t MaxCachedBlendTables = 8;
+
+bool IsSamePalette(const SDL_Color *a, const SDL_Color *b)
 {
-	Uint8 best;
-	Uint32 bestDiff = SDL_MAX_UINT32;
 	for (int i = 0; i < 256; i++) {
-		if (i >= skipFrom && i <= skipTo)
-			continue;
-		int diffr = palette[i].r - color.r;
-		int diffg = palette[i].g - color.g;
-		int diffb = palette[i].b - color.b;
-		Uint32 diff = diffr * diffr + diffg * diffg + diffb * diffb;
-
-		if (bestDiff > diff) {
-			best = i;
-			bestDiff = diff;
-		}
+		if (a[i].r != b[i].r || a[i].g != b[i].g || a[i].b != b[i].b)
+			return false;
 	}
-	return best;
+	return true;
 }
 
 /**
- * @brief Generate lookup table for transparency
- *
- * This is based of the same technique found in Quake2.
- *
- * To mimic 50% transparency we figure out what colors in the existing palette are the best match for the combination of any 2 colors.
- * We save this into a lookup table for use during rendering.
- *
- * @param palette The colors to operate on
- * @param skipFrom Do not use colors between this index and skipTo
- * @param skipTo Do not use colors between skipFrom and this index
- * @param toUpdate Only update the first n colors
+ * @brief Copy a lookup table generated earlier for the same palette into paletteTransparencyLookup
+ * @return false if the table hasn't been generated yet
  */
-static void GenerateBlendedLookupTable(SDL_Color *palette, int skipFrom, int skipTo, int toUpdate = 256)
+bool LoadCachedBlendTable(const SDL_Color *palette, int skipFrom, int skipTo)
+{
+	for (auto it = BlendTableCache.begin(); it != BlendTableCache.end(); ++it) {
+		if (it->skipFrom != skipFrom || it->skipTo != skipTo || !IsSamePalette(it->palette.data(), palette))
+			continue;
+		memcpy(paletteTransparencyLookup, it->lookup.get(), sizeof(paletteTransparencyLookup));
+		std::rotate(it, it + 1, BlendTableCache.end());
+		return true;
+	}
+	return false;
+}
+
+void StoreCachedBlendTable(const SDL_Color *palette, int skipFrom, int skipTo)
+{
+	if (BlendTableCache.size() >= MaxCachedBlendTables)
+		BlendTableCache.erase(BlendTableCache.begin());
+
+	CachedBlendTable entry;
+	std::copy(palette, palette + 256, entry.palette.begin());
+	entry.skipFrom = skipFrom;
+	entry.skipTo = skipTo;
+	entry.lookup = std::make_unique<Uint8[][256]>(256);
+	memcpy(entry.lookup.get(), paletteTransparencyLookup, sizeof(paletteTransparencyLookup));
+	BlendTableCache.push_back(std::move(entry));
+}
+
+} // namespace
+
+void GenerateBlendedLookupTable(SDL_Color *palette, int skipFrom, int skipTo, int toUpdate /*= 256*/)
 {
+	if (toUpdate == 256 && LoadCachedBlendTable(palette, skipFrom, skipTo))
+		return;
+
+	const ColorMatcher matcher(palette, skipFrom, skipTo);
 	for (int i = 0; i < 256; i++) {
 		for (int j = 0; j < 256; j++) {
 			if (i == j) { // No need to calculate transparency between 2 identical colors
@@ -119,10 +229,13 @@ static void GenerateBlendedLookupTable(SDL_Color *palette, int skipFrom, int ski
 			blendedColor.r = ((int)palette[i].r + (int)palette[j].r) / 2;
 			blendedColor.g = ((int)palette[i].g + (int)palette[j].g) / 2;
 			blendedColor.b = ((int)palette[i].b + (int)palette[j].b) / 2;
-			Uint8 best = FindBestMatchForColor(palette, blendedColor, skipFrom, skipTo);
+			Uint8 best = matcher.FindBestMatch(blendedColor);
 			paletteTransparencyLookup[i][j] = best;
 		}
 	}
+
+	if (toUpdate == 256)
+		StoreCachedBlendTable(palette, skipFrom, skipTo);
 }
 
 void LoadPalette(const char *pszFileName, bool blend /*= true*/)
@@ -196,6 +309,8 @@ void IncreaseGamma()
 			sgOptions.Graphics.nGammaCorrection = 100;
 		ApplyGamma(system_palette, logical_palette, 256);
 		palette_update();
+		if (IsHardwareCursor())
+			ReinitializeHardwareCursor();
 	}
 }
 
@@ -207,6 +322,8 @@ void DecreaseGamma()
 			sgOptions.Graphics.nGammaCorrection = 30;
 		ApplyGamma(system_palette, logical_palette, 256);
 		palette_update();
+		if (IsHardwareCursor())
+			ReinitializeHardwareCursor();
 	}
 }
 
@@ -216,6 +333,8 @@ int UpdateGamma(int gamma)
 		sgOptions.Graphics.nGammaCorrection = 130 - gamma;
 		ApplyGamma(system_palette, logical_palette, 256);
 		palette_update();
+		if (IsHardwareCursor())
+			ReinitializeHardwareCursor();
 	}
 	return 130 - sgOptions.Graphics.nGammaCorrection;
 }
@@ -238,6 +357,24 @@ void BlackPalette()
 	SetFadeLevel(0);
 }
 
+/**
+ * @brief Show the screen with the given brightness
+ *
+ * The frame itself is the same during a fade, so a step that doesn't change the brightness
+ * isn't presented again.
+ */
+static void PresentFadeStep(uint32_t fadeValue, uint32_t &prevFadeValue)
+{
+	if (fadeValue == prevFadeValue) {
+		SDL_Delay(1);
+		return;
+	}
+	SetFadeLevel(fadeValue);
+	prevFadeValue = fadeValue;
+	BltFast(nullptr, nullptr);
+	RenderPresent();
+}
+
 void PaletteFadeIn(int fr)
 {
 	ApplyGamma(logical_palette, orig_palette, 256);
@@ -247,12 +384,7 @@ void PaletteFadeIn(int fr)
 
 	uint32_t prevFadeValue = 255;
 	for (uint32_t i = 0; i < 256; i = fr * (SDL_GetTicks() - tc) / 50) {
-		if (i != prevFadeValue) {
-			SetFadeLevel(i);
-			prevFadeValue = i;
-		}
-		BltFast(nullptr, nullptr);
-		RenderPresent();
+		PresentFadeStep(i, prevFadeValue);
 	}
 	SetFadeLevel(256);
 
@@ -269,14 +401,9 @@ void PaletteFadeOut(int fr)
 	const uint32_t tc = SDL_GetTicks();
 	fr *= 3;
 
-	uint32_t prevFadeValue = 0;
+	uint32_t prevFadeValue = 256;
 	for (uint32_t i = 0; i < 256; i = fr * (SDL_GetTicks() - tc) / 50) {
-		if (i != prevFadeValue) {
-			SetFadeLevel(256 - i);
-			prevFadeValue = i;
-		}
-		BltFast(nullptr, nullptr);
-		RenderPresent();
+		PresentFadeStep(256 - i, prevFadeValue);
 	}
 	SetFadeLevel(0);
 
@@ -399,6 +526,7 @@ void palette_update_quest_palette(int n)
 	palette_update();
 	if (sgOptions.Graphics.bBlendedTransparancy) {
 		// Update blended transparency, but only for the color that was updated
+		const ColorMatcher matcher(logical_palette, 1, 31);
 		for (int j = 0; j < 256; j++) {
 			if (i == j) { // No need to calculate transparency between 2 identical colors
 				paletteTransparencyLookup[i][j] = j;
@@ -408,7 +536,7 @@ void palette_update_quest_palette(int n)
 			blendedColor.r = ((int)logical_palette[i].r + (int)logical_palette[j].r) / 2;
 			blendedColor.g = ((int)logical_palette[i].g + (int)logical_palette[j].g) / 2;
 			blendedColor.b = ((int)logical_palette[i].b + (int)logical_palette[j].b) / 2;
-			Uint8 best = FindBestMatchForColor(logical_palette, blendedColor, 1, 31);
+			Uint8 best = matcher.FindBestMatch(blendedColor);
 			paletteTransparencyLookup[i][j] = paletteTransparencyLookup[j][i] = best;
 		}
 	}
@@ -37,6 +37,21 @@ extern Uint8 paletteTransparencyLookup[256][256];
 void palette_update();
 void palette_init();
 void LoadPalette(const char *pszFileName, bool blend = true);
+/**
+ * @brief Generate lookup table for transparency
+ *
+ * This is based of the same technique found in Quake2.
+ *
+ * To mimic 50% transparency we figure out what colors in the existing palette are the best match for the combination of any 2 colors.
+ * We save this into a lookup table for use during rendering.
+ * A full update of a palette that was blended before is taken from a cache.
+ *
+ * @param palette The colors to operate on
+ * @param skipFrom Do not use colors between this index and skipTo
+ * @param skipTo Do not use colors between skipFrom and this index
+ * @param toUpdate Only update the first n colors
+ */
+void GenerateBlendedLookupTable(SDL_Color *palette, int skipFrom, int skipTo, int toUpdate = 256);
 void LoadRndLvlPal(dungeon_type l);
 void ResetPal();
 void IncreaseGamma();
@@ -22,6 +22,10 @@ int gdwCurNodes;
  * possible path is actually 24 steps, even though we can fit 25
  */
 int8_t pnode_vals[MAX_PATH_LENGTH];
+/** Number of FindPath searches, read by the benchmarks */
+uint32_t gnPathSearches;
+/** Number of nodes expanded by all FindPath searches, read by the benchmarks */
+uint32_t gnPathNodesExpanded;
 /** A linked list of all visited nodes */
 PATHNODE *pnode_ptr;
 /** A stack for recursively searching nodes */
@@ -29,6 +33,65 @@ PATHNODE *pnode_tblptr[MAXPATHNODES];
 /** A linked list of the A* frontier, sorted by distance */
 PATHNODE *path_2_nodes;
 
+namespace {
+
+/** Incremented for every search, so stale entries of pathTileNode don't need to be cleared */
+uint32_t pathGeneration;
+/** The search in which pathTileNode was last written for each tile */
+uint32_t pathTileGeneration[MAXDUNX][MAXDUNY];
+/** Index into path_nodes of the node at each tile */
+uint16_t pathTileNode[MAXDUNX][MAXDUNY];
+
+bool IsIndexedTile(int x, int y)
+{
+	return x >= 0 && x < MAXDUNX && y >= 0 && y < MAXDUNY;
+}
+
+void StartNodeIndex()
+{
+	pathGeneration++;
+	if (pathGeneration == 0) {
+		memset(pathTileGeneration, 0, sizeof(pathTileGeneration));
+		pathGeneration = 1;
+	}
+}
+
+void IndexNode(PATHNODE *pPath)
+{
+	const int x = pPath->position.x;
+	const int y = pPath->position.y;
+	if (!IsIndexedTile(x, y))
+		return;
+	pathTileGeneration[x][y] = pathGeneration;
+	pathTileNode[x][y] = static_cast<uint16_t>(pPath - path_nodes);
+}
+
+/**
+ * @brief Look up the node at the given tile on the frontier or among the visited nodes.
+ *
+ * Every tile has at most one node, so this is the same as searching both lists.
+ */
+PATHNODE *FindNode(int dx, int dy, bool visited)
+{
+	if (IsIndexedTile(dx, dy)) {
+		if (pathTileGeneration[dx][dy] != pathGeneration)
+			return nullptr;
+		PATHNODE *result = &path_nodes[pathTileNode[dx][dy]];
+		return result->visited == visited ? result : nullptr;
+	}
+
+	// Tiles outside the dungeon aren't indexed, fall back to walking the list
+	PATHNODE *result = visited ? pnode_ptr->NextNode : path_2_nodes->NextNode;
+	while (result != nullptr) {
+		if (result->position.x == dx && result->position.y == dy)
+			return result;
+		result = result->NextNode;
+	}
+	return nullptr;
+}
+
+} // namespace
+
 /** For iterating over the 8 possible movement directions */
 const char pathxdir[8] = { -1, -1, 1, 1, -1, 0, 1, 0 };
 const char pathydir[8] = { -1, 1, -1, 1, 0, -1, 0, 1 };
@@ -56,8 +119,11 @@ int FindPath(bool (*PosOk)(int, Point), int PosOkArg, int sx, int sy, int dx, in
 	PATHNODE *path_start, *next_node, *current;
 	int path_length, i;
 
+	gnPathSearches++;
+
 	// clear all nodes, create root nodes for the visited/frontier linked lists
 	gdwCurNodes = 0;
+	StartNodeIndex();
 	path_2_nodes = path_new_step();
 	pnode_ptr = path_new_step();
 	gdwCurPathStep = 0;
@@ -67,6 +133,7 @@ int FindPath(bool (*PosOk)(int, Point), int PosOkArg, int sx, int sy, int dx, in
 	path_start->position.x = sx;
 	path_start->f = path_start->h + path_start->g;
 	path_start->position.y = sy;
+	IndexNode(path_start);
 	path_2_nodes->NextNode = path_start;
 	// A* search until we find (dx,dy) or fail
 	while ((next_node = GetNextPath())) {
@@ -87,6 +154,7 @@ int FindPath(bool (*PosOk)(int, Point), int PosOkArg, int sx, int sy, int dx, in
 			}
 			return 0;
 		}
+		gnPathNodesExpanded++;
 		// ran out of nodes, abort!
 		if (!path_get_path(PosOk, PosOkArg, next_node, dx, dy))
 			return 0;
@@ -139,6 +207,7 @@ PATHNODE *GetNextPath()
 
 	path_2_nodes->NextNode = result->NextNode;
 	result->NextNode = pnode_ptr->NextNode;
+	result->visited = true;
 	pnode_ptr->NextNode = result;
 	return result;
 }
@@ -254,6 +323,7 @@ bool path_parent_path(PATHNODE *pPath, int dx, int dy, int sx, int sy)
 			dxdy->h = path_get_h_cost(dx, dy, sx, sy);
 			dxdy->f = next_g + dxdy->h;
 			dxdy->position = { dx, dy };
+			IndexNode(dxdy);
 			// add it to the frontier
 			path_next_node(dxdy);
 
@@ -272,13 +342,7 @@ bool path_parent_path(PATHNODE *pPath, int dx, int dy, int sx, int sy)
  */
 PATHNODE *path_get_node1(int dx, int dy)
 {
-	PATHNODE *result = path_2_nodes->NextNode;
-	while (result != nullptr) {
-		if (result->position.x == dx && result->position.y == dy)
-			return result;
-		result = result->NextNode;
-	}
-	return nullptr;
+	return FindNode(dx, dy, false);
 }
 
 /**
@@ -286,13 +350,7 @@ PATHNODE *path_get_node1(int dx, int dy)
  */
 PATHNODE *path_get_node2(int dx, int dy)
 {
-	PATHNODE *result = pnode_ptr->NextNode;
-	while (result != nullptr) {
-		if (result->position.x == dx && result->position.y == dy)
-			return result;
-		result = result->NextNode;
-	}
-	return nullptr;
+	return FindNode(dx, dy, true);
 }
 
 /**
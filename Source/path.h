@@ -21,6 +21,8 @@ struct PATHNODE {
 	struct PATHNODE *Parent;
 	struct PATHNODE *Child[8];
 	struct PATHNODE *NextNode;
+	/** Set once the node is moved from the frontier to the visited nodes */
+	bool visited;
 };
 
 int FindPath(bool (*PosOk)(int, Point), int PosOkArg, int sx, int sy, int dx, int dy, int8_t path[MAX_PATH_LENGTH]);
@@ -37,6 +39,9 @@ void path_push_active_step(PATHNODE *pPath);
 PATHNODE *path_pop_active_step();
 PATHNODE *path_new_step();
 
+extern uint32_t gnPathSearches;
+extern uint32_t gnPathNodesExpanded;
+
 /* rdata */
 
 extern const char pathxdir[8];
@@ -5,7 +5,9 @@
  */
 #include "pfile.h"
 
+#include <memory>
 #include <string>
+#include <vector>
 
 #include "codec.h"
 #include "engine.h"
@@ -17,7 +19,9 @@
 #include "storm/storm.h"
 #include "utils/file_util.h"
 #include "utils/language.h"
+#include "utils/log.hpp"
 #include "utils/paths.h"
+#include "utils/thread.h"
 
 namespace devilution {
 
@@ -107,6 +111,55 @@ void pfile_rename_temp_to_perm()
 	assert(!GetPermSaveNames(dwIndex, szPerm));
 }
 
+/** A copy of the local hero taken on the main thread, written to its archive by the autosave thread */
+struct BackgroundSave {
+	std::string path;
+	bool clearTables;
+	PkPlayerStruct pack;
+	bool saveExtras;
+	HeroSaveData extras;
+
+	explicit BackgroundSave(const PlayerStruct &player)
+	    : extras(player)
+	{
+	}
+};
+
+std::unique_ptr<BackgroundSave> PendingSave;
+SDL_Thread *BackgroundSaveThread;
+SDL_threadID BackgroundSaveThreadId;
+
+/** A level left since the game was last saved, in place of its temp file in the archive */
+struct LevelSnapshot {
+	std::string name;
+	/** Contents of the file before encoding */
+	std::vector<byte> data;
+};
+
+std::vector<LevelSnapshot> LevelSnapshots;
+
+LevelSnapshot *FindLevelSnapshot(const char *pszName)
+{
+	for (LevelSnapshot &snapshot : LevelSnapshots) {
+		if (snapshot.name == pszName)
+			return &snapshot;
+	}
+	return nullptr;
+}
+
+/** Writes the level snapshots to the archive that is open for writing as their temp files */
+void WriteLevelSnapshots()
+{
+	for (const LevelSnapshot &snapshot : LevelSnapshots) {
+		const size_t encodedLen = codec_get_encoded_len(snapshot.data.size());
+		std::unique_ptr<byte[]> encoded { new byte[encodedLen] };
+		memcpy(encoded.get(), snapshot.data.data(), snapshot.data.size());
+		codec_encode(encoded.get(), snapshot.data.size(), encodedLen, pfile_get_password());
+		mpqapi_write_file(snapshot.name.c_str(), encoded.get(), encodedLen);
+	}
+	LevelSnapshots.clear();
+}
+
 } // namespace
 
 /** List of character names for the character selection screen. */
@@ -185,8 +238,58 @@ static void pfile_encode_hero(const PkPlayerStruct *pack)
 	mpqapi_write_file("hero", packed.get(), packedLen);
 }
 
+void pfile_finish_background_save()
+{
+	if (BackgroundSaveThread == nullptr)
+		return;
+
+	SDL_WaitThread(BackgroundSaveThread, nullptr);
+	BackgroundSaveThread = nullptr;
+	PendingSave = nullptr;
+}
+
+static unsigned int BackgroundSaveHandler(void * /*data*/)
+{
+	const BackgroundSave &save = *PendingSave;
+	if (!OpenMPQ(save.path.c_str())) {
+		LogError("{}", _("Failed to open player archive for writing."));
+		return 0;
+	}
+	pfile_encode_hero(&save.pack);
+	if (save.saveExtras) {
+		SaveHotkeys(save.extras);
+		SaveHeroItems(save.extras);
+	}
+	if (!mpqapi_compact())
+		LogError("Failed to compact the save archive, its unused space is kept until the next save");
+	mpqapi_flush_and_close(save.clearTables);
+	return 0;
+}
+
+/**
+ * @brief Writes the hero to its archive on another thread
+ *
+ * Everything that is saved is copied first, so the game can keep running while the archive is encoded and written.
+ * Opening any save archive waits for the write to finish, so only one thread ever uses the archive writer.
+ */
+static void pfile_write_hero_in_background(bool clear_tables)
+{
+	pfile_finish_background_save();
+
+	auto &myPlayer = plr[myplr];
+	PendingSave = std::make_unique<BackgroundSave>(myPlayer);
+	PendingSave->path = GetSavePath(pfile_get_save_num_from_name(myPlayer._pName));
+	PendingSave->clearTables = clear_tables;
+	PackPlayer(&PendingSave->pack, myPlayer, !gbIsMultiplayer);
+	PendingSave->saveExtras = !gbVanilla;
+
+	BackgroundSaveThread = CreateThread(BackgroundSaveHandler, &BackgroundSaveThreadId);
+}
+
 static bool pfile_open_archive(uint32_t save_num)
 {
+	pfile_finish_background_save();
+
 	if (OpenMPQ(GetSavePath(save_num).c_str()))
 		return true;
 
@@ -197,6 +300,8 @@ static HANDLE pfile_open_save_archive(uint32_t save_num)
 {
 	HANDLE archive;
 
+	pfile_finish_background_save();
+
 	if (SFileOpenArchive(GetSavePath(save_num).c_str(), 0, 0, &archive))
 		return archive;
 	return nullptr;
@@ -229,6 +334,7 @@ void pfile_write_hero(bool write_game_data, bool clear_tables)
 	PFileScopedArchiveWriter scoped_writer(clear_tables);
 	if (write_game_data) {
 		SaveGameData();
+		WriteLevelSnapshots();
 		pfile_rename_temp_to_perm();
 	}
 	PkPlayerStruct pkplr;
@@ -238,6 +344,9 @@ void pfile_write_hero(bool write_game_data, bool clear_tables)
 		SaveHotkeys();
 		SaveHeroItems(plr[myplr]);
 	}
+	// Compacting last means a failed move can't keep the hero from being written
+	if (write_game_data && !mpqapi_compact())
+		LogError("Failed to compact the save archive, its unused space is kept until the next save");
 }
 
 static void game_2_ui_player(const PlayerStruct &player, _uiheroinfo *heroinfo, bool bHasSaveFile)
@@ -256,6 +365,31 @@ static void game_2_ui_player(const PlayerStruct &player, _uiheroinfo *heroinfo,
 	heroinfo->spawned = gbIsSpawn;
 }
 
+/**
+ * @brief Check the header of the saved game without reading and verifying all of it
+ *
+ * Good enough for listing the heroes, pfile_archive_contains_game still checks the whole file before it's loaded.
+ */
+static bool pfile_archive_has_game_header(HANDLE hsArchive)
+{
+	if (gbIsMultiplayer)
+		return false;
+
+	HANDLE file;
+	if (!SFileOpenFileEx(hsArchive, "game", 0, &file))
+		return false;
+
+	byte block[CodecEncoder::BlockSize];
+	size_t length = SFileGetFileSize(file);
+	bool valid = length >= sizeof(block) && SFileReadFileThreadSafe(file, block, sizeof(block));
+	SFileCloseFileThreadSafe(file);
+
+	if (!valid || !codec_decode_first_block(block, length, pfile_get_password()))
+		return false;
+
+	return IsHeaderValid(LoadLE32(block));
+}
+
 bool pfile_ui_set_hero_infos(bool (*ui_add_hero_info)(_uiheroinfo *))
 {
 	memset(hero_names, 0, sizeof(hero_names));
@@ -267,7 +401,7 @@ bool pfile_ui_set_hero_infos(bool (*ui_add_hero_info)(_uiheroinfo *))
 			if (pfile_read_hero(archive, &pkplr)) {
 				_uiheroinfo uihero;
 				strcpy(hero_names[i], pkplr.pName);
-				bool hasSaveGame = pfile_archive_contains_game(archive);
+				bool hasSaveGame = pfile_archive_has_game_header(archive);
 				if (hasSaveGame)
 					pkplr.bIsHellfire = gbIsHellfireSaveGame;
 
@@ -410,6 +544,8 @@ bool LevelFileExists()
 	char szName[MAX_PATH];
 
 	GetPermLevelNames(szName);
+	if (FindLevelSnapshot(szName) != nullptr)
+		return true;
 
 	uint32_t save_num = pfile_get_save_num_from_name(plr[myplr]._pName);
 	if (!pfile_open_archive(save_num))
@@ -432,6 +568,8 @@ void GetPermLevelNames(char *szPerm)
 {
 	uint32_t save_num = pfile_get_save_num_from_name(plr[myplr]._pName);
 	GetTempLevelNames(szPerm);
+	if (FindLevelSnapshot(szPerm) != nullptr)
+		return;
 	if (!pfile_open_archive(save_num))
 		app_fatal("%s", _("Unable to read to save file archive"));
 
@@ -447,6 +585,8 @@ void GetPermLevelNames(char *szPerm)
 
 void pfile_remove_temp_files()
 {
+	LevelSnapshots.clear();
+
 	if (gbIsMultiplayer)
 		return;
 
@@ -457,10 +597,30 @@ void pfile_remove_temp_files()
 	mpqapi_flush_and_close(true);
 }
 
+void pfile_write_level_snapshot(const char *pszName, std::vector<byte> data)
+{
+	LevelSnapshot *snapshot = FindLevelSnapshot(pszName);
+	if (snapshot == nullptr) {
+		LevelSnapshots.emplace_back();
+		snapshot = &LevelSnapshots.back();
+		snapshot->name = pszName;
+	}
+	snapshot->data = std::move(data);
+}
+
 std::unique_ptr<byte[]> pfile_read(const char *pszName, size_t *pdwLen)
 {
 	HANDLE archive;
 
+	const LevelSnapshot *snapshot = FindLevelSnapshot(pszName);
+	if (snapshot != nullptr) {
+		std::unique_ptr<byte[]> buf { new byte[snapshot->data.size()] };
+		memcpy(buf.get(), snapshot->data.data(), snapshot->data.size());
+		if (pdwLen != nullptr)
+			*pdwLen = snapshot->data.size();
+		return buf;
+	}
+
 	uint32_t save_num = pfile_get_save_num_from_name(plr[myplr]._pName);
 	archive = pfile_open_save_archive(save_num);
 	if (archive == nullptr)
@@ -486,7 +646,10 @@ void pfile_update(bool force_save)
 		return;
 
 	save_prev_tc = tick;
-	pfile_write_hero();
+	if (force_save)
+		pfile_write_hero();
+	else
+		pfile_write_hero_in_background(!gbIsMultiplayer);
 }
 
 } // namespace devilution
@@ -5,6 +5,8 @@
  */
 #pragma once
 
+#include <vector>
+
 #include "player.h"
 #include "DiabloUI/diabloui.h"
 
@@ -40,7 +42,20 @@ bool LevelFileExists();
 void GetTempLevelNames(char *szTemp);
 void GetPermLevelNames(char *szPerm);
 void pfile_remove_temp_files();
+/**
+ * @brief Keeps a level that is left in memory instead of writing it to the save archive
+ *
+ * The temp files of the levels are only kept by saving the game, so the snapshots are written to the archive
+ * by the next pfile_write_hero that saves the game data. Until then pfile_read returns them in place of the files.
+ * @param pszName Name of the temp file of the level, see GetTempLevelNames
+ * @param data Contents of the file before encoding
+ */
+void pfile_write_level_snapshot(const char *pszName, std::vector<byte> data);
 std::unique_ptr<byte[]> pfile_read(const char *pszName, size_t *pdwLen);
 void pfile_update(bool force_save);
+/**
+ * @brief Waits for the periodic multiplayer autosave to finish writing the hero, if it is running
+ */
+void pfile_finish_background_save();
 
 } // namespace devilution
@@ -5,10 +5,14 @@
  */
 #include <algorithm>
 #include <cstdint>
+#include <string>
+#include <unordered_map>
 
 #include "control.h"
 #include "cursor.h"
 #include "dead.h"
+#include "engine/render/cl2_render.hpp"
+#include "engine/render/outline_cache.hpp"
 #include "gamemenu.h"
 #include "init.h"
 #include "lighting.h"
@@ -21,8 +25,10 @@
 #include "stores.h"
 #include "storm/storm.h"
 #include "towners.h"
+#include "utils/file_prefetch.h"
 #include "utils/language.h"
 #include "utils/log.hpp"
+#include "utils/profiler.h"
 
 namespace devilution {
 
@@ -392,21 +398,52 @@ void PlayerStruct::Reset()
 	*this = std::move(*emptyPlayer);
 }
 
-void SetPlayerGPtrs(const char *path, std::unique_ptr<byte[]> &data, std::array<std::optional<CelSprite>, 8> &anim, int width)
+namespace {
+
+/** Sheets that are in use by any player, by path */
+std::unordered_map<std::string, std::weak_ptr<byte[]>> LoadedSheets;
+
+/**
+ * @brief Get a sheet that some player already uses
+ * @return nullptr if nobody uses it
+ */
+std::shared_ptr<byte[]> FindLoadedSheet(const char *path)
+{
+	auto it = LoadedSheets.find(path);
+	if (it == LoadedSheets.end())
+		return nullptr;
+	return it->second.lock();
+}
+
+void AddLoadedSheet(const char *path, const std::shared_ptr<byte[]> &data)
 {
-	data = nullptr;
-	data = LoadFileInMem(path);
+	// Forget the sheets nobody uses anymore before the map grows
+	for (auto it = LoadedSheets.begin(); it != LoadedSheets.end();) {
+		if (it->second.expired())
+			it = LoadedSheets.erase(it);
+		else
+			++it;
+	}
+	LoadedSheets[path] = data;
+}
+
+} // namespace
 
+static void SetPlayerGPtrs(const std::shared_ptr<byte[]> &data, std::array<std::optional<CelSprite>, 8> &anim, int width)
+{
 	for (int i = 0; i < 8; i++) {
 		byte *pCelStart = CelGetFrameStart(data.get(), i);
 		anim[i].emplace(pCelStart, width);
 	}
 }
 
-void LoadPlrGFX(PlayerStruct &player, player_graphic graphic)
+/**
+ * @brief Find the sheet of an animation
+ * @return false if the player has no such animation in the current level
+ */
+static bool GetPlrGFXPath(const PlayerStruct &player, player_graphic graphic, char (&pszName)[256], int &animationWidth)
 {
 	char prefix[16];
-	char pszName[256];
 	const char *szCel;
 
 	HeroClass c = player._pClass;
@@ -417,7 +454,7 @@ void LoadPlrGFX(PlayerStruct &player, player_graphic graphic)
 	}
 
 	auto animWeaponId = static_cast<anim_weapon_id>(player._pgfxnum & 0xF);
-	int animationWidth = 96;
+	animationWidth = 96;
 
 	sprintf(prefix, "%c%c%c", CharChar[static_cast<std::size_t>(c)], ArmourChar[player._pgfxnum >> 4], WepChar[animWeaponId]);
 	const char *cs = ClassPathTbl[static_cast<std::size_t>(c)];
@@ -439,7 +476,7 @@ void LoadPlrGFX(PlayerStruct &player, player_graphic graphic)
 		break;
 	case player_graphic::Attack:
 		if (leveltype == DTYPE_TOWN)
-			return;
+			return false;
 		szCel = "AT";
 		if (c == HeroClass::Monk)
 			animationWidth = 130;
@@ -448,14 +485,14 @@ void LoadPlrGFX(PlayerStruct &player, player_graphic graphic)
 		break;
 	case player_graphic::Hit:
 		if (leveltype == DTYPE_TOWN)
-			return;
+			return false;
 		szCel = "HT";
 		if (c == HeroClass::Monk)
 			animationWidth = 98;
 		break;
 	case player_graphic::Lightning:
 		if (leveltype == DTYPE_TOWN)
-			return;
+			return false;
 		szCel = "LM";
 		if (c == HeroClass::Monk)
 			animationWidth = 114;
@@ -464,7 +501,7 @@ void LoadPlrGFX(PlayerStruct &player, player_graphic graphic)
 		break;
 	case player_graphic::Fire:
 		if (leveltype == DTYPE_TOWN)
-			return;
+			return false;
 		szCel = "FM";
 		if (c == HeroClass::Monk)
 			animationWidth = 114;
@@ -473,7 +510,7 @@ void LoadPlrGFX(PlayerStruct &player, player_graphic graphic)
 		break;
 	case player_graphic::Magic:
 		if (leveltype == DTYPE_TOWN)
-			return;
+			return false;
 		szCel = "QM";
 		if (c == HeroClass::Monk)
 			animationWidth = 114;
@@ -482,15 +519,15 @@ void LoadPlrGFX(PlayerStruct &player, player_graphic graphic)
 		break;
 	case player_graphic::Death:
 		if (animWeaponId != ANIM_ID_UNARMED)
-			return;
+			return false;
 		szCel = "DT";
 		animationWidth = (c == HeroClass::Monk) ? 160 : 128;
 		break;
 	case player_graphic::Block:
 		if (leveltype == DTYPE_TOWN)
-			return;
+			return false;
 		if (!player._pBlockFlag)
-			return;
+			return false;
 		szCel = "BL";
 		if (c == HeroClass::Monk)
 			animationWidth = 98;
@@ -500,8 +537,29 @@ void LoadPlrGFX(PlayerStruct &player, player_graphic graphic)
 	}
 
 	sprintf(pszName, "PlrGFX\\%s\\%s\\%s%s.CL2", cs, prefix, prefix, szCel);
+	return true;
+}
+
+void LoadPlrGFX(PlayerStruct &player, player_graphic graphic)
+{
+	char pszName[256];
+	int animationWidth;
+	if (!GetPlrGFXPath(player, graphic, pszName, animationWidth))
+		return;
+
 	auto &animationData = player.AnimationData[static_cast<size_t>(graphic)];
-	SetPlayerGPtrs(pszName, animationData.RawData, animationData.CelSpritesForDirections, animationWidth);
+	animationData.RawData = nullptr;
+	animationData.RawData = FindLoadedSheet(pszName);
+	if (animationData.RawData != nullptr) {
+		SetPlayerGPtrs(animationData.RawData, animationData.CelSpritesForDirections, animationWidth);
+		return;
+	}
+	animationData.RawData = LoadFileInMem(pszName);
+	AddLoadedSheet(pszName, animationData.RawData);
+	SetPlayerGPtrs(animationData.RawData, animationData.CelSpritesForDirections, animationWidth);
+	// The new frames may have been loaded where the ones they replace were
+	InvalidateLitSpriteCache();
+	InvalidateOutlineCache();
 }
 
 void InitPlayerGFX(int pnum)
@@ -515,12 +573,35 @@ void InitPlayerGFX(int pnum)
 		player._pgfxnum = 0;
 		LoadPlrGFX(player, player_graphic::Death);
 	} else {
-		for (size_t i = 0; i < enum_size<player_graphic>::value; i++) {
+		constexpr size_t NumGraphics = enum_size<player_graphic>::value;
+		char pszNames[NumGraphics][256];
+		int widths[NumGraphics];
+		bool present[NumGraphics];
+		bool load[NumGraphics];
+		for (size_t i = 0; i < NumGraphics; i++) {
 			auto graphic = static_cast<player_graphic>(i);
-			if (graphic == player_graphic::Death)
-				continue;
-			LoadPlrGFX(player, graphic);
+			present[i] = graphic != player_graphic::Death && GetPlrGFXPath(player, graphic, pszNames[i], widths[i]);
+			if (present[i]) {
+				player.AnimationData[i].RawData = nullptr;
+				player.AnimationData[i].RawData = FindLoadedSheet(pszNames[i]);
+			}
+			load[i] = present[i] && player.AnimationData[i].RawData == nullptr;
 		}
+
+		// The sheets don't depend on each other, read them all at once
+		ParallelLoad(NumGraphics, [&](unsigned i) {
+			if (load[i])
+				player.AnimationData[i].RawData = LoadFileInMem(pszNames[i]);
+		});
+
+		for (size_t i = 0; i < NumGraphics; i++) {
+			if (load[i])
+				AddLoadedSheet(pszNames[i], player.AnimationData[i].RawData);
+			if (present[i])
+				SetPlayerGPtrs(player.AnimationData[i].RawData, player.AnimationData[i].CelSpritesForDirections, widths[i]);
+		}
+		InvalidateLitSpriteCache();
+		InvalidateOutlineCache();
 	}
 }
 
@@ -534,6 +615,46 @@ void ResetPlayerGFX(PlayerStruct &player)
 	}
 }
 
+namespace {
+
+/** The graphics a player had before their last change of equipment */
+struct PreviousPlayerGFX {
+	HeroClass heroClass;
+	int gfxNum;
+	bool town;
+	std::array<PlayerAnimationData, enum_size<player_graphic>::value> animationData;
+};
+
+std::array<std::optional<PreviousPlayerGFX>, MAX_PLRS> PreviousGFX;
+
+} // namespace
+
+void ChangePlayerGFX(PlayerStruct &player, int gfxNum)
+{
+	const bool town = leveltype == DTYPE_TOWN;
+	std::optional<PreviousPlayerGFX> &previous = PreviousGFX[&player - plr];
+	PreviousPlayerGFX current { player._pClass, player._pgfxnum, town, std::move(player.AnimationData) };
+
+	ResetPlayerGFX(player);
+	player._pgfxnum = gfxNum;
+	if (previous && previous->heroClass == player._pClass && previous->gfxNum == gfxNum && previous->town == town)
+		player.AnimationData = std::move(previous->animationData);
+	previous.emplace(std::move(current));
+}
+
+void PrefetchPlayerGFX(const PlayerStruct &player)
+{
+	if (player.plrlevel != currlevel)
+		return;
+
+	for (size_t i = 0; i < enum_size<player_graphic>::value; i++) {
+		char pszName[256];
+		int animationWidth;
+		if (player.AnimationData[i].RawData == nullptr && GetPlrGFXPath(player, static_cast<player_graphic>(i), pszName, animationWidth))
+			PrefetchFile(pszName);
+	}
+}
+
 void NewPlrAnim(PlayerStruct &player, player_graphic graphic, Direction dir, int numberOfFrames, int delayLen, AnimationDistributionFlags flags /*= AnimationDistributionFlags::None*/, int numSkippedFrames /*= 0*/, int distributeFramesBeforeFrame /*= 0*/)
 {
 	if (player.AnimationData[static_cast<size_t>(graphic)].RawData == nullptr)
@@ -1652,8 +1773,6 @@ void RespawnDeadItem(ItemStruct *itm, int x, int y)
 
 static void PlrDeadItem(PlayerStruct &player, ItemStruct *itm, int xx, int yy)
 {
-	int i, j, k;
-
 	if (itm->isEmpty())
 		return;
 
@@ -1666,19 +1785,11 @@ static void PlrDeadItem(PlayerStruct &player, ItemStruct *itm, int xx, int yy)
 		return;
 	}
 
-	for (k = 1; k < 50; k++) {
-		for (j = -k; j <= k; j++) {
-			y = j + player.position.tile.y;
-			for (i = -k; i <= k; i++) {
-				x = i + player.position.tile.x;
-				if (ItemSpaceOk({ x, y })) {
-					RespawnDeadItem(itm, x, y);
-					player.HoldItem = *itm;
-					NetSendCmdPItem(false, CMD_RESPAWNITEM, { x, y });
-					return;
-				}
-			}
-		}
+	std::optional<Point> position = FindItemSpaceAround(player.position.tile, 1);
+	if (position) {
+		RespawnDeadItem(itm, position->x, position->y);
+		player.HoldItem = *itm;
+		NetSendCmdPItem(false, CMD_RESPAWNITEM, *position);
 	}
 }
 
@@ -2160,6 +2271,7 @@ static bool WeaponDurDecay(int pnum, int ii)
 
 	if (!player.InvBody[ii].isEmpty() && player.InvBody[ii]._iClass == ICLASS_WEAPON && player.InvBody[ii]._iDamAcFlags & 2) {
 		player.InvBody[ii]._iPLDam -= 5;
+		InvalidateItemStats(player, ii);
 		if (player.InvBody[ii]._iPLDam <= -100) {
 			NetSendCmdDelItem(true, ii);
 			player.InvBody[ii]._itype = ITYPE_NONE;
@@ -2965,10 +3077,71 @@ bool PM_DoDeath(int pnum)
 	return false;
 }
 
+namespace {
+
+/** How a player starts a step of their walk path */
+struct WalkParameters {
+	Direction dir;
+	_scroll_direction scrollDir;
+	PLR_MODE mode;
+	/** Which speed is used for each axis: 0 for none, 1 for xvel3, 2 for xvel, 3 for yvel, negated to walk backwards */
+	int8_t speedX;
+	int8_t speedY;
+	/** Offset the sprite starts out with */
+	Point offset;
+	/** Change of the tile */
+	Point tileAdd;
+	/** Second tile occupied during a PM_WALK3 */
+	Point map;
+};
+
+/** Indexed by the WALK_* value of the step */
+constexpr size_t NumWalkParams = WALK_W + 1;
+constexpr WalkParameters WalkParams[NumWalkParams] = {
+	// clang-format off
+	{},
+	{ DIR_NE, SDIR_NE, PM_WALK,   2, -3, {   0,   0 }, {  0, -1 }, { 0, 0 } },
+	{ DIR_NW, SDIR_NW, PM_WALK,  -2, -3, {   0,   0 }, { -1,  0 }, { 0, 0 } },
+	{ DIR_SE, SDIR_SE, PM_WALK2,  2,  3, { -32, -16 }, {  1,  0 }, { 0, 0 } },
+	{ DIR_SW, SDIR_SW, PM_WALK2, -2,  3, {  32, -16 }, {  0,  1 }, { 0, 0 } },
+	{ DIR_N,  SDIR_N,  PM_WALK,   0, -2, {   0,   0 }, { -1, -1 }, { 0, 0 } },
+	{ DIR_E,  SDIR_E,  PM_WALK3,  1,  0, { -32, -16 }, {  1, -1 }, { 1, 0 } },
+	{ DIR_S,  SDIR_S,  PM_WALK2,  0,  2, {   0, -32 }, {  1,  1 }, { 0, 0 } },
+	{ DIR_W,  SDIR_W,  PM_WALK3, -1,  0, {  32, -16 }, { -1,  1 }, { 0, 1 } },
+	// clang-format on
+};
+
+/** Velocity of every step for each class, in the dungeon [0] and in town [1] */
+using WalkVelocityTable = std::array<std::array<std::array<Point, NumWalkParams>, 2>, enum_size<HeroClass>::value>;
+
+const WalkVelocityTable &GetWalkVelocities()
+{
+	static const WalkVelocityTable Velocities = [] {
+		WalkVelocityTable table {};
+		for (size_t c = 0; c < enum_size<HeroClass>::value; c++) {
+			const int dungeonSpeeds[] = { 0, PWVel[c][0], PWVel[c][1], PWVel[c][2] };
+			const int townSpeeds[] = { 0, 2048, 1024, 512 };
+			for (size_t step = 1; step < NumWalkParams; step++) {
+				const WalkParameters &walk = WalkParams[step];
+				const auto velocity = [&](const int(&speeds)[4]) {
+					const int x = speeds[std::abs(walk.speedX)];
+					const int y = speeds[std::abs(walk.speedY)];
+					return Point { walk.speedX < 0 ? -x : x, walk.speedY < 0 ? -y : y };
+				};
+				table[c][0][step] = velocity(dungeonSpeeds);
+				table[c][1][step] = velocity(townSpeeds);
+			}
+		}
+		return table;
+	}();
+	return Velocities;
+}
+
+} // namespace
+
 void CheckNewPath(int pnum, bool pmWillBeCalled)
 {
 	int i, x, y;
-	int xvel3, xvel, yvel;
 
 	if ((DWORD)pnum >= MAX_PLRS) {
 		app_fatal("CheckNewPath: illegal player %i", pnum);
@@ -3015,41 +3188,11 @@ void CheckNewPath(int pnum, bool pmWillBeCalled)
 				}
 			}
 
-			if (currlevel != 0) {
-				xvel3 = PWVel[static_cast<std::size_t>(player._pClass)][0];
-				xvel = PWVel[static_cast<std::size_t>(player._pClass)][1];
-				yvel = PWVel[static_cast<std::size_t>(player._pClass)][2];
-			} else {
-				xvel3 = 2048;
-				xvel = 1024;
-				yvel = 512;
-			}
-
-			switch (player.walkpath[0]) {
-			case WALK_N:
-				StartWalk(pnum, 0, -xvel, 0, 0, -1, -1, 0, 0, DIR_N, SDIR_N, PM_WALK, pmWillBeCalled);
-				break;
-			case WALK_NE:
-				StartWalk(pnum, xvel, -yvel, 0, 0, 0, -1, 0, 0, DIR_NE, SDIR_NE, PM_WALK, pmWillBeCalled);
-				break;
-			case WALK_E:
-				StartWalk(pnum, xvel3, 0, -32, -16, 1, -1, 1, 0, DIR_E, SDIR_E, PM_WALK3, pmWillBeCalled);
-				break;
-			case WALK_SE:
-				StartWalk(pnum, xvel, yvel, -32, -16, 1, 0, 0, 0, DIR_SE, SDIR_SE, PM_WALK2, pmWillBeCalled);
-				break;
-			case WALK_S:
-				StartWalk(pnum, 0, xvel, 0, -32, 1, 1, 0, 0, DIR_S, SDIR_S, PM_WALK2, pmWillBeCalled);
-				break;
-			case WALK_SW:
-				StartWalk(pnum, -xvel, yvel, 32, -16, 0, 1, 0, 0, DIR_SW, SDIR_SW, PM_WALK2, pmWillBeCalled);
-				break;
-			case WALK_W:
-				StartWalk(pnum, -xvel3, 0, 32, -16, -1, 1, 0, 1, DIR_W, SDIR_W, PM_WALK3, pmWillBeCalled);
-				break;
-			case WALK_NW:
-				StartWalk(pnum, -xvel, -yvel, 0, 0, -1, 0, 0, 0, DIR_NW, SDIR_NW, PM_WALK, pmWillBeCalled);
-				break;
+			const int step = player.walkpath[0];
+			if (step >= 1 && step < static_cast<int>(NumWalkParams)) {
+				const WalkParameters &walk = WalkParams[step];
+				const Point velocity = GetWalkVelocities()[static_cast<std::size_t>(player._pClass)][currlevel == 0 ? 1 : 0][step];
+				StartWalk(pnum, velocity.x, velocity.y, walk.offset.x, walk.offset.y, walk.tileAdd.x, walk.tileAdd.y, walk.map.x, walk.map.y, walk.dir, walk.scrollDir, walk.mode, pmWillBeCalled);
 			}
 
 			for (i = 1; i < MAX_PATH_LENGTH; i++) {
@@ -3362,13 +3505,21 @@ void ValidatePlayer()
 		myPlayer._pBaseVit = myPlayer.GetMaximumAttributeValue(CharacterAttribute::Vitality);
 	}
 
-	uint64_t msk = 0;
-	for (b = SPL_FIREBOLT; b < MAX_SPELLS; b++) {
-		if (GetSpellBookLevel((spell_id)b) != -1) {
-			msk |= GetSpellBitmask(b);
-			if (myPlayer._pSplLvl[b] > MAX_SPELL_LEVEL)
-				myPlayer._pSplLvl[b] = MAX_SPELL_LEVEL;
+	// Which spells exist only depends on the game mode, find them once per mode
+	static uint64_t msk;
+	static int mskMode = -1;
+	const int mode = (gbIsSpawn ? 1 : 0) | (gbIsHellfire ? 2 : 0);
+	if (mskMode != mode) {
+		msk = 0;
+		for (b = SPL_FIREBOLT; b < MAX_SPELLS; b++) {
+			if (GetSpellBookLevel((spell_id)b) != -1)
+				msk |= GetSpellBitmask(b);
 		}
+		mskMode = mode;
+	}
+	for (b = SPL_FIREBOLT; b < MAX_SPELLS; b++) {
+		if ((msk & GetSpellBitmask(b)) != 0 && myPlayer._pSplLvl[b] > MAX_SPELL_LEVEL)
+			myPlayer._pSplLvl[b] = MAX_SPELL_LEVEL;
 	}
 
 	myPlayer._pMemSpells &= msk;
@@ -3403,6 +3554,8 @@ static void CheckCheatStats(PlayerStruct &player)
 
 void ProcessPlayers()
 {
+	ProfileScope profileScope(ProfilePhase::ProcessPlayers);
+
 	if ((DWORD)myplr >= MAX_PLRS) {
 		app_fatal("ProcessPlayers: illegal player %i", myplr);
 	}
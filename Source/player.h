@@ -157,8 +157,9 @@ struct PlayerAnimationData {
 	/**
 	 * @brief Raw Data (binary) of the CL2 file.
 	 *        Is referenced from CelSprite in CelSpritesForDirections
+	 *        Shared by every player that uses the same file
 	 */
-	std::unique_ptr<byte[]> RawData;
+	std::shared_ptr<byte[]> RawData;
 };
 
 struct PlayerStruct {
@@ -299,6 +300,8 @@ struct PlayerStruct {
 	uint8_t pDiabloKillLevel;
 	_difficulty pDifficulty;
 	uint32_t pDamAcFlags;
+	/** Stats of the equipped items as last summed up by CalcPlrItemVals */
+	ItemStatContribution InvBodyStats[NUM_INVLOC];
 
 	void CalcScrolls();
 
@@ -409,6 +412,14 @@ extern int ToBlkTbl[enum_size<HeroClass>::value];
 void LoadPlrGFX(PlayerStruct &player, player_graphic graphic);
 void InitPlayerGFX(int pnum);
 void ResetPlayerGFX(PlayerStruct &player);
+/**
+ * @brief Switch to the graphics of different equipment, the ones that are dropped are kept until the next change
+ *
+ * Changing back, like toggling weapon sets, reuses the kept graphics. Otherwise the sheets are loaded as they are used.
+ */
+void ChangePlayerGFX(PlayerStruct &player, int gfxNum);
+/** @brief Read the sheets the player doesn't have yet on the prefetch thread */
+void PrefetchPlayerGFX(const PlayerStruct &player);
 
 /**
  * @brief Sets the new Player Animation with all relevant information for rendering
@@ -46,17 +46,14 @@ void AddWarpMissile(int i, int x, int y)
 {
 	int mi;
 
-	missiledata[MIS_TOWN].mlSFX = SFX_NONE;
 	dMissile[x][y] = 0;
-	mi = AddMissile(0, 0, x, y, 0, MIS_TOWN, TARGET_MONSTERS, i, 0, 0);
+	mi = AddMissile(0, 0, x, y, 0, MIS_TOWN, TARGET_MONSTERS, i, 0, 0, false);
 
 	if (mi != -1) {
 		SetMissDir(mi, 1);
 
 		if (currlevel != 0)
 			missile[mi]._mlid = AddLight(missile[mi].position.tile, 15);
-
-		missiledata[MIS_TOWN].mlSFX = LS_SENTINEL;
 	}
 }
 
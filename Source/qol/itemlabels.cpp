@@ -1,6 +1,6 @@
+#include <algorithm>
 #include <vector>
 #include <string>
-#include <unordered_set>
 
 #include "inv.h"
 #include "gmenu.h"
@@ -18,10 +18,24 @@ namespace {
 struct itemLabel {
 	int id, width;
 	Point pos;
+	const std::string *text;
+};
+
+/** The text of an item on the ground, kept so it's only formatted and measured again when it changes */
+struct labelText {
 	std::string text;
+	int width = 0;
+	const char *goldFormat = nullptr;
+	int goldValue = 0;
 };
 
 std::vector<itemLabel> labelQueue;
+labelText labelTexts[MAXITEMS];
+/** Indices into labelQueue sorted by y, then by index */
+std::vector<unsigned> labelsByY;
+/** Reused between the labels so the layout doesn't allocate every frame */
+std::vector<unsigned> overlapCandidates;
+std::vector<int> backtrace;
 
 bool altPressed = false;
 bool isLabelHighlighted = false;
@@ -62,15 +76,26 @@ void AddItemToLabelQueue(int id, int x, int y)
 		return;
 	ItemStruct *it = &items[id];
 
-	const char *textOnGround;
+	labelText &label = labelTexts[id];
 	if (it->_itype == ITYPE_GOLD) {
-		std::sprintf(tempstr, _("%i gold"), it->_ivalue);
-		textOnGround = tempstr;
+		const char *goldFormat = _("%i gold");
+		if (label.goldFormat != goldFormat || label.goldValue != it->_ivalue) {
+			std::sprintf(tempstr, goldFormat, it->_ivalue);
+			label.text = tempstr;
+			label.width = GetLineWidth(tempstr);
+			label.goldFormat = goldFormat;
+			label.goldValue = it->_ivalue;
+		}
 	} else {
-		textOnGround = it->_iIdentified ? it->_iIName : it->_iName;
+		const char *textOnGround = it->_iIdentified ? it->_iIName : it->_iName;
+		if (label.goldFormat != nullptr || label.text != textOnGround) {
+			label.text = textOnGround;
+			label.width = GetLineWidth(textOnGround);
+			label.goldFormat = nullptr;
+		}
 	}
 
-	int nameWidth = GetLineWidth(textOnGround);
+	int nameWidth = label.width;
 	nameWidth += marginX * 2;
 	int index = ItemCAnimTbl[it->_iCurs];
 	if (!labelCenterOffsets[index]) {
@@ -85,7 +110,7 @@ void AddItemToLabelQueue(int id, int x, int y)
 		y *= 2;
 	}
 	x -= nameWidth / 2;
-	labelQueue.push_back(itemLabel { id, nameWidth, { x, y }, textOnGround });
+	labelQueue.push_back(itemLabel { id, nameWidth, { x, y }, &label.text });
 }
 
 bool IsMouseOverGameArea()
@@ -111,32 +136,51 @@ void DrawItemNameLabels(const CelOutputBuffer &out)
 {
 	isLabelHighlighted = false;
 
+	// Labels are only moved sideways, so the ones that can overlap a label are those within a band
+	// of rows around it, which is found by a binary search among the labels sorted by y.
+	labelsByY.resize(labelQueue.size());
+	for (unsigned i = 0; i < labelQueue.size(); ++i)
+		labelsByY[i] = i;
+	std::sort(labelsByY.begin(), labelsByY.end(), [](unsigned a, unsigned b) {
+		return labelQueue[a].pos.y < labelQueue[b].pos.y || (labelQueue[a].pos.y == labelQueue[b].pos.y && a < b);
+	});
+
 	for (unsigned int i = 0; i < labelQueue.size(); ++i) {
-		std::unordered_set<int> backtrace;
+		itemLabel &a = labelQueue[i];
+
+		// Only the labels placed before this one count, in the order they were placed
+		overlapCandidates.clear();
+		auto first = std::lower_bound(labelsByY.begin(), labelsByY.end(), a.pos.y - (height + borderY) + 1, [](unsigned index, int y) {
+			return labelQueue[index].pos.y < y;
+		});
+		for (auto it = first; it != labelsByY.end() && labelQueue[*it].pos.y < a.pos.y + height + borderY; ++it) {
+			if (*it < i)
+				overlapCandidates.push_back(*it);
+		}
+		std::sort(overlapCandidates.begin(), overlapCandidates.end());
 
+		backtrace.clear();
 		bool canShow;
 		do {
 			canShow = true;
-			for (unsigned int j = 0; j < i; ++j) {
-				itemLabel &a = labelQueue[i], &b = labelQueue[j];
-				if (abs(b.pos.y - a.pos.y) < height + borderY) {
-					int widthA = a.width + borderX + marginX * 2;
-					int widthB = b.width + borderX + marginX * 2;
-					int newpos = b.pos.x;
-					if (b.pos.x >= a.pos.x && b.pos.x - a.pos.x < widthA) {
-						newpos -= widthA;
-						if (backtrace.find(newpos) != backtrace.end())
-							newpos = b.pos.x + widthB;
-					} else if (b.pos.x < a.pos.x && a.pos.x - b.pos.x < widthB) {
-						newpos += widthB;
-						if (backtrace.find(newpos) != backtrace.end())
-							newpos = b.pos.x - widthA;
-					} else
-						continue;
-					canShow = false;
-					a.pos.x = newpos;
-					backtrace.insert(newpos);
-				}
+			for (unsigned int j : overlapCandidates) {
+				itemLabel &b = labelQueue[j];
+				int widthA = a.width + borderX + marginX * 2;
+				int widthB = b.width + borderX + marginX * 2;
+				int newpos = b.pos.x;
+				if (b.pos.x >= a.pos.x && b.pos.x - a.pos.x < widthA) {
+					newpos -= widthA;
+					if (std::find(backtrace.begin(), backtrace.end(), newpos) != backtrace.end())
+						newpos = b.pos.x + widthB;
+				} else if (b.pos.x < a.pos.x && a.pos.x - b.pos.x < widthB) {
+					newpos += widthB;
+					if (std::find(backtrace.begin(), backtrace.end(), newpos) != backtrace.end())
+						newpos = b.pos.x - widthA;
+				} else
+					continue;
+				canShow = false;
+				a.pos.x = newpos;
+				backtrace.push_back(newpos);
 			}
 		} while (!canShow);
 	}
@@ -156,7 +200,7 @@ void DrawItemNameLabels(const CelOutputBuffer &out)
 			FillRect(out, label.pos.x, label.pos.y - height + marginY, label.width, height, PAL8_BLUE + 6);
 		else
 			DrawHalfTransparentRectTo(out, label.pos.x, label.pos.y - height + marginY, label.width, height);
-		DrawString(out, label.text.c_str(), { label.pos.x + marginX, label.pos.y, label.width, height }, itm.getTextColor());
+		DrawString(out, label.text->c_str(), { label.pos.x + marginX, label.pos.y, label.width, height }, itm.getTextColor());
 	}
 	labelQueue.clear();
 }
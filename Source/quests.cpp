@@ -12,12 +12,14 @@
 #include "engine/render/text_render.hpp"
 #include "gendung.h"
 #include "init.h"
+#include "levelcache.h"
 #include "minitext.h"
 #include "missiles.h"
 #include "options.h"
 #include "stores.h"
 #include "towners.h"
 #include "trigs.h"
+#include "utils/file_prefetch.h"
 #include "utils/language.h"
 
 namespace devilution {
@@ -113,6 +115,9 @@ void InitQuests()
 	int i, initiatedQuests;
 	DWORD z;
 
+	// Cached layouts only restore the quest positions their generation changed, which are reset below
+	ClearGeneratedLevels();
+
 	if (!gbIsMultiplayer) {
 		for (i = 0; i < MAXQUESTS; i++) {
 			quests[i]._qactive = QUEST_NOTAVAIL;
@@ -528,6 +533,56 @@ void DRLG_CheckQuests(int x, int y)
 	}
 }
 
+/**
+ * @brief Queue the set piece maps the quests of the given level will read while it's being created
+ */
+void PrefetchQuestDungeons(int level)
+{
+	for (int i = 0; i < MAXQUESTS; i++) {
+		if (quests[i]._qlevel != level || quests[i]._qactive == QUEST_NOTAVAIL)
+			continue;
+		if (gbIsMultiplayer && questlist[i].isSinglePlayerOnly)
+			continue;
+		switch (quests[i]._qtype) {
+		case Q_BUTCHER:
+			PrefetchFile("Levels\\L1Data\\rnd6.DUN");
+			break;
+		case Q_SKELKING:
+			PrefetchFile("Levels\\L1Data\\SKngDO.DUN");
+			break;
+		case Q_LTBANNER:
+			PrefetchFile("Levels\\L1Data\\Banner2.DUN");
+			PrefetchFile("Levels\\L1Data\\Banner1.DUN");
+			break;
+		case Q_BLIND:
+			PrefetchFile("Levels\\L2Data\\Blind1.DUN");
+			PrefetchFile("Levels\\L2Data\\Blind2.DUN");
+			break;
+		case Q_BLOOD:
+			PrefetchFile("Levels\\L2Data\\Blood1.DUN");
+			PrefetchFile("Levels\\L2Data\\Blood2.DUN");
+			break;
+		case Q_SCHAMB:
+			PrefetchFile("Levels\\L2Data\\Bonestr2.DUN");
+			PrefetchFile("Levels\\L2Data\\Bonestr1.DUN");
+			break;
+		case Q_ANVIL:
+			PrefetchFile("Levels\\L3Data\\Anvil.DUN");
+			break;
+		case Q_WARLORD:
+			PrefetchFile("Levels\\L4Data\\Warlord.DUN");
+			PrefetchFile("Levels\\L4Data\\Warlord2.DUN");
+			break;
+		case Q_BETRAYER:
+			if (gbIsMultiplayer)
+				PrefetchFile("Levels\\L4Data\\Vile1.DUN");
+			break;
+		default:
+			break;
+		}
+	}
+}
+
 void SetReturnLvlPos()
 {
 	switch (setlvlnum) {
@@ -80,6 +80,7 @@ bool ForceQuests();
 bool QuestStatus(int i);
 void CheckQuestKill(int m, bool sendmsg);
 void DRLG_CheckQuests(int x, int y);
+void PrefetchQuestDungeons(int level);
 void SetReturnLvlPos();
 void GetReturnLvlPos();
 void LoadPWaterPalette();
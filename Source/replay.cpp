@@ -0,0 +1,375 @@
+/**
+ * @file replay.cpp
+ *
+ * Implementation of recording and playing back single player game sessions.
+ *
+ * A replay consists of the state needed to set up the game followed by the commands
+ * that were parsed and the game ticks that were run, in the order they happened.
+ * Since the game logic is deterministic, this is enough to reproduce the session.
+ */
+#include "replay.h"
+
+#include <memory>
+#include <vector>
+
+#include "engine.h"
+#include "items.h"
+#include "loadsave.h"
+#include "missiles.h"
+#include "monster.h"
+#include "objects.h"
+#include "player.h"
+#include "portal.h"
+#include "quests.h"
+#include "utils/log.hpp"
+
+namespace devilution {
+
+namespace {
+
+constexpr uint32_t ReplayMagic = LoadBE32("DXRP");
+constexpr uint32_t ReplayVersion = 2;
+
+enum class ReplayEvent : uint8_t {
+	Packets,
+	Tick,
+	End,
+};
+
+std::string RecordPath;
+std::unique_ptr<std::ofstream> RecordStream;
+uint32_t RecordedTicks;
+
+void Write8(std::ostream &out, uint8_t value)
+{
+	out.put(static_cast<char>(value));
+}
+
+void WriteLE16(std::ostream &out, uint16_t value)
+{
+	Write8(out, value & 0xFF);
+	Write8(out, value >> 8);
+}
+
+void WriteLE32(std::ostream &out, uint32_t value)
+{
+	WriteLE16(out, value & 0xFFFF);
+	WriteLE16(out, value >> 16);
+}
+
+uint8_t Read8(std::istream &in)
+{
+	return static_cast<uint8_t>(in.get());
+}
+
+uint16_t ReadLE16(std::istream &in)
+{
+	uint16_t low = Read8(in);
+	return low | (Read8(in) << 8);
+}
+
+uint32_t ReadLE32(std::istream &in)
+{
+	uint32_t low = ReadLE16(in);
+	return low | (ReadLE16(in) << 16);
+}
+
+void WriteHeader(std::ostream &out, const ReplayHeader &header)
+{
+	WriteLE32(out, ReplayMagic);
+	WriteLE32(out, ReplayVersion);
+	WriteLE32(out, header.gameData.dwSeed);
+	Write8(out, header.gameData.nDifficulty);
+	Write8(out, header.gameData.nTickRate);
+	Write8(out, header.gameData.bRunInTown);
+	Write8(out, header.gameData.bTheoQuest);
+	Write8(out, header.gameData.bCowQuest);
+	Write8(out, header.gameData.bFriendlyFire);
+	Write8(out, header.gameData.bSharedMonsterPathing);
+	Write8(out, header.gameData.bIdleMonstersSleep);
+	Write8(out, header.isHellfire ? 1 : 0);
+	Write8(out, header.isSpawn ? 1 : 0);
+	Write8(out, header.level);
+	Write8(out, header.levelType);
+	Write8(out, header.isSetLevel ? 1 : 0);
+	Write8(out, header.setLevelNum);
+	WriteLE32(out, header.playerX);
+	WriteLE32(out, header.playerY);
+	for (uint32_t seed : header.levelSeeds)
+		WriteLE32(out, seed);
+	for (dungeon_type levelType : header.levelTypes)
+		Write8(out, levelType);
+	out.write(reinterpret_cast<const char *>(&header.player), sizeof(header.player));
+}
+
+bool ReadHeader(std::istream &in, ReplayHeader &header)
+{
+	if (ReadLE32(in) != ReplayMagic || ReadLE32(in) != ReplayVersion)
+		return false;
+
+	header.gameData = {};
+	header.gameData.size = sizeof(header.gameData);
+	header.gameData.dwSeed = ReadLE32(in);
+	header.gameData.nDifficulty = static_cast<_difficulty>(Read8(in));
+	header.gameData.nTickRate = Read8(in);
+	header.gameData.bRunInTown = Read8(in);
+	header.gameData.bTheoQuest = Read8(in);
+	header.gameData.bCowQuest = Read8(in);
+	header.gameData.bFriendlyFire = Read8(in);
+	header.gameData.bSharedMonsterPathing = Read8(in);
+	header.gameData.bIdleMonstersSleep = Read8(in);
+	header.isHellfire = Read8(in) != 0;
+	header.isSpawn = Read8(in) != 0;
+	header.level = Read8(in);
+	header.levelType = static_cast<dungeon_type>(Read8(in));
+	header.isSetLevel = Read8(in) != 0;
+	header.setLevelNum = static_cast<_setlevels>(Read8(in));
+	header.playerX = ReadLE32(in);
+	header.playerY = ReadLE32(in);
+	for (uint32_t &seed : header.levelSeeds)
+		seed = ReadLE32(in);
+	for (dungeon_type &levelType : header.levelTypes)
+		levelType = static_cast<dungeon_type>(Read8(in));
+	in.read(reinterpret_cast<char *>(&header.player), sizeof(header.player));
+
+	return in.good() && header.gameData.nTickRate != 0;
+}
+
+/** 32-bit FNV-1a */
+class StateHasher {
+public:
+	void Add(int32_t value)
+	{
+		auto bits = static_cast<uint32_t>(value);
+		for (int i = 0; i < 4; i++) {
+			hash_ = (hash_ ^ (bits & 0xFF)) * 16777619U;
+			bits >>= 8;
+		}
+	}
+
+	void Add(Point position)
+	{
+		Add(position.x);
+		Add(position.y);
+	}
+
+	uint32_t Get() const
+	{
+		return hash_;
+	}
+
+private:
+	uint32_t hash_ = 2166136261U;
+};
+
+} // namespace
+
+void ReplaySetRecordPath(std::string path)
+{
+	RecordPath = std::move(path);
+}
+
+void ReplayRecordBegin()
+{
+	if (RecordPath.empty() || gbIsMultiplayer)
+		return;
+
+	RecordStream = std::make_unique<std::ofstream>(RecordPath, std::ios::binary | std::ios::trunc);
+	if (!RecordStream->is_open()) {
+		LogError("Failed to open {} for recording", RecordPath);
+		RecordStream = nullptr;
+		return;
+	}
+	// Only the first game after startup is recorded
+	RecordPath.clear();
+	RecordedTicks = 0;
+
+	const auto &myPlayer = plr[myplr];
+
+	ReplayHeader header;
+	header.gameData = sgGameInitInfo;
+	header.isHellfire = gbIsHellfire;
+	header.isSpawn = gbIsSpawn;
+	header.level = currlevel;
+	header.levelType = leveltype;
+	header.isSetLevel = setlevel;
+	header.setLevelNum = setlvlnum;
+	header.playerX = myPlayer.position.tile.x;
+	header.playerY = myPlayer.position.tile.y;
+	for (int i = 0; i < NUMLEVELS; i++) {
+		header.levelSeeds[i] = glSeedTbl[i];
+		header.levelTypes[i] = gnLevelTypeTbl[i];
+	}
+	PackPlayer(&header.player, myPlayer, !gbIsMultiplayer);
+
+	WriteHeader(*RecordStream, header);
+}
+
+void ReplayRecordPackets(int pnum, const byte *data, std::size_t size)
+{
+	if (RecordStream == nullptr || size == 0)
+		return;
+
+	Write8(*RecordStream, static_cast<uint8_t>(ReplayEvent::Packets));
+	Write8(*RecordStream, pnum);
+	WriteLE16(*RecordStream, size);
+	RecordStream->write(reinterpret_cast<const char *>(data), size);
+}
+
+void ReplayRecordTick()
+{
+	if (RecordStream == nullptr)
+		return;
+
+	Write8(*RecordStream, static_cast<uint8_t>(ReplayEvent::Tick));
+	WriteLE32(*RecordStream, sgdwGameLoops);
+	RecordedTicks++;
+}
+
+void ReplayRecordEnd()
+{
+	if (RecordStream == nullptr)
+		return;
+
+	Write8(*RecordStream, static_cast<uint8_t>(ReplayEvent::End));
+	WriteLE32(*RecordStream, RecordedTicks);
+	WriteLE32(*RecordStream, ReplayStateHash());
+	if (!RecordStream->good())
+		LogError("Failed to write the replay");
+	RecordStream = nullptr;
+}
+
+uint32_t ReplayStateHash()
+{
+	StateHasher hasher;
+
+	for (int i = 0; i < MAX_PLRS; i++) {
+		const auto &player = plr[i];
+		if (!player.plractive)
+			continue;
+		hasher.Add(player.position.tile);
+		hasher.Add(player._pmode);
+		hasher.Add(player._pHitPoints);
+		hasher.Add(player._pMana);
+		hasher.Add(player._pExperience);
+		hasher.Add(player._pGold);
+	}
+
+	hasher.Add(nummonsters);
+	for (int i = 0; i < nummonsters; i++) {
+		const auto &monst = monster[monstactive[i]];
+		hasher.Add(monst.position.tile);
+		hasher.Add(monst._mmode);
+		hasher.Add(monst._mhitpoints);
+	}
+
+	hasher.Add(nummissiles);
+	for (int i = 0; i < nummissiles; i++) {
+		const auto &mis = missile[missileactive[i]];
+		hasher.Add(mis._mitype);
+		hasher.Add(mis.position.tile);
+	}
+
+	hasher.Add(numitems);
+	for (int i = 0; i < numitems; i++)
+		hasher.Add(items[itemactive[i]].position);
+
+	hasher.Add(nobjects);
+
+	return hasher.Get();
+}
+
+bool ReplayPlayback::Open(const std::string &path)
+{
+	stream_.open(path, std::ios::binary);
+	if (!stream_.is_open())
+		return false;
+
+	return ReadHeader(stream_, header_);
+}
+
+bool ReplayPlayback::StartGame()
+{
+	if (header_.isHellfire != gbIsHellfire || header_.isSpawn != gbIsSpawn) {
+		LogError("The replay was recorded with different game data");
+		return false;
+	}
+
+	gbIsMultiplayer = false;
+	myplr = 0;
+	sgGameInitInfo = header_.gameData;
+	gnTickDelay = 1000 / sgGameInitInfo.nTickRate;
+	for (int i = 0; i < NUMLEVELS; i++) {
+		glSeedTbl[i] = header_.levelSeeds[i];
+		gnLevelTypeTbl[i] = header_.levelTypes[i];
+	}
+
+	for (auto &player : plr)
+		player.Reset();
+	UnPackPlayer(&header_.player, myplr, false);
+	CalcPlrInv(myplr, false);
+
+	// Mirror NetInit and SetupLocalCoords
+	currlevel = header_.level;
+	leveltype = header_.levelType;
+	setlevel = header_.isSetLevel;
+	setlvlnum = header_.setLevelNum;
+	auto &myPlayer = plr[myplr];
+	myPlayer.position.tile = { header_.playerX, header_.playerY };
+	myPlayer.position.future = myPlayer.position.tile;
+	myPlayer.plrlevel = currlevel;
+	myPlayer._pLvlChanging = true;
+	myPlayer.pLvlLoad = 0;
+	myPlayer._pmode = PM_NEWLVL;
+	myPlayer.destAction = ACTION_NONE;
+	myPlayer.plractive = true;
+	gbActivePlayers = 1;
+	sgdwGameLoops = 0;
+
+	// Mirror StartGame and ShowProgress
+	InitLevels();
+	ResetLevelFormats();
+	InitQuests();
+	InitPortals();
+	InitDungMsgs(myPlayer);
+	myPlayer.pOriginalCathedral = !gbIsHellfire;
+	LoadGameLevel(true, ENTRY_MAIN);
+	gbProcessPlayers = true;
+
+	return true;
+}
+
+bool ReplayPlayback::RunTick()
+{
+	std::vector<byte> packets;
+
+	while (stream_.good()) {
+		switch (static_cast<ReplayEvent>(Read8(stream_))) {
+		case ReplayEvent::Packets: {
+			int pnum = Read8(stream_);
+			uint16_t size = ReadLE16(stream_);
+			packets.resize(size);
+			stream_.read(reinterpret_cast<char *>(packets.data()), size);
+			if (!stream_.good() || pnum >= MAX_PLRS)
+				return false;
+			multi_handle_all_packets(pnum, packets.data(), size);
+		} break;
+		case ReplayEvent::Tick:
+			sgdwGameLoops = ReadLE32(stream_) - 1;
+			multi_mon_seeds();
+			ProcessGameLogic();
+			CheckQuests();
+			return stream_.good();
+		case ReplayEvent::End:
+			recordedTicks_ = ReadLE32(stream_);
+			recordedStateHash_ = ReadLE32(stream_);
+			return false;
+		default:
+			return false;
+		}
+	}
+
+	return false;
+}
+
+} // namespace devilution
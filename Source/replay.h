@@ -0,0 +1,92 @@
+/**
+ * @file replay.h
+ *
+ * Interface of recording and playing back single player game sessions.
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <string>
+
+#include "diablo.h"
+#include "multi.h"
+#include "pack.h"
+#include "utils/stdcompat/cstddef.hpp"
+
+namespace devilution {
+
+/**
+ * @brief State needed to start a game the same way as when it was recorded.
+ */
+struct ReplayHeader {
+	GameData gameData;
+	bool isHellfire;
+	bool isSpawn;
+	uint8_t level;
+	dungeon_type levelType;
+	bool isSetLevel;
+	_setlevels setLevelNum;
+	int32_t playerX;
+	int32_t playerY;
+	uint32_t levelSeeds[NUMLEVELS];
+	dungeon_type levelTypes[NUMLEVELS];
+	PkPlayerStruct player;
+};
+
+/**
+ * @brief Record all commands of the next new single player game to the given file.
+ *
+ * The recording covers the first level of the game and stops once the player changes levels.
+ */
+void ReplaySetRecordPath(std::string path);
+/** @brief Start recording, called right before the first level of a new game is loaded. */
+void ReplayRecordBegin();
+void ReplayRecordPackets(int pnum, const byte *data, std::size_t size);
+/** @brief Record that the game logic is about to advance by one tick. */
+void ReplayRecordTick();
+void ReplayRecordEnd();
+
+/**
+ * @brief Hash of the simulation state that a replay is expected to reproduce.
+ */
+uint32_t ReplayStateHash();
+
+/**
+ * @brief Runs a recorded game without any user interaction.
+ */
+class ReplayPlayback {
+public:
+	bool Open(const std::string &path);
+	/**
+	 * @brief Restore the state of the recorded game and load its first level.
+	 * @return false if the loaded game data doesn't match the recording
+	 */
+	bool StartGame();
+	/**
+	 * @brief Apply the recorded commands and advance the game by one tick.
+	 * @return false once the recording is exhausted
+	 */
+	bool RunTick();
+
+	/** @brief Number of ticks in the recording, known once RunTick returned false. */
+	uint32_t RecordedTicks() const
+	{
+		return recordedTicks_;
+	}
+
+	/** @brief ReplayStateHash at the end of the recording, known once RunTick returned false. */
+	uint32_t RecordedStateHash() const
+	{
+		return recordedStateHash_;
+	}
+
+private:
+	std::ifstream stream_;
+	ReplayHeader header_;
+	uint32_t recordedTicks_ = 0;
+	uint32_t recordedStateHash_ = 0;
+};
+
+} // namespace devilution
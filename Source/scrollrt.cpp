@@ -4,7 +4,12 @@
  * Implementation of functionality for rendering the dungeons, monsters and calling other render routines.
  */
 
+#include <algorithm>
+#include <memory>
+#include <vector>
+
 #include "automap.h"
+#include "capture.h"
 #include "cursor.h"
 #include "dead.h"
 #include "doom.h"
@@ -22,14 +27,21 @@
 #include "lighting.h"
 #include "minitext.h"
 #include "missiles.h"
+#include "msg.h"
 #include "nthread.h"
 #include "plrmsg.h"
 #include "qol/monhealthbar.h"
 #include "qol/xpbar.h"
 #include "qol/itemlabels.h"
 #include "stores.h"
+#include "storm/storm.h"
+#include "sync.h"
 #include "towners.h"
 #include "utils/log.hpp"
+#include "utils/memory_stats.h"
+#include "utils/profiler.h"
+#include "utils/simd.h"
+#include "utils/thread_pool.h"
 
 #ifdef _DEBUG
 #include "debug.h"
@@ -40,7 +52,7 @@ namespace devilution {
 /**
  * Specifies the current light entry.
  */
-int light_table_index;
+thread_local int light_table_index;
 uint32_t sgdwCursWdtOld;
 int sgdwCursX;
 int sgdwCursY;
@@ -55,32 +67,38 @@ uint32_t sgdwCursHgt;
  * frameNum  := block & 0x0FFF
  * frameType := block & 0x7000 >> 12
  */
-uint32_t level_cel_block;
+thread_local uint32_t level_cel_block;
 int sgdwCursXOld;
 int sgdwCursYOld;
 bool AutoMapShowItems;
 /**
  * Specifies the type of arches to render.
  */
-char arch_draw_type;
+thread_local char arch_draw_type;
 /**
  * Specifies whether transparency is active for the current CEL file being decoded.
  */
-bool cel_transparency_active;
+thread_local bool cel_transparency_active;
 /**
  * Specifies whether foliage (tile has extra content that overlaps previous tile) being rendered.
  */
-bool cel_foliage_active = false;
+thread_local bool cel_foliage_active = false;
 /**
  * Specifies the current dungeon piece ID of the level, as used during rendering of the level tiles.
  */
-int level_piece_id;
+thread_local int level_piece_id;
 uint32_t sgdwCursWdt;
 void (*DrawPlrProc)(int, int, int, int, int, BYTE *, int, int, int, int);
 BYTE sgSaveBack[8192];
 uint32_t sgdwCursHgtOld;
 
-bool dRendered[MAXDUNX][MAXDUNY];
+/**
+ * Pass of QueueDungeonCells that last queued each cell. Compared against RenderGeneration instead of
+ * being cleared for every pass, the array only needs to be reset when the counter wraps.
+ * Only the thread that builds DungeonDrawQueue uses it, the render threads just read the queue.
+ */
+static uint16_t dRendered[MAXDUNX][MAXDUNY];
+static uint16_t RenderGeneration;
 
 int frames;
 bool frameflag;
@@ -156,6 +174,32 @@ Point GetOffsetForWalking(const AnimationInfo &animationInfo, const Direction di
 	return offset;
 }
 
+/**
+ * @brief Returns the missile's sprite offset, advanced by the progress towards the next game tick
+ */
+static Point GetMissileRenderOffset(const MissileStruct &mis)
+{
+	return mis.position.offset + mis.position.lastStep * gfProgressToNextGameTick;
+}
+
+/**
+ * @brief Returns the monster's sprite offset, advanced by the progress towards the next game tick
+ */
+static Point GetMonsterRenderOffset(const MonsterStruct &monst)
+{
+	if (monst._mmode != MM_WALK && monst._mmode != MM_WALK2 && monst._mmode != MM_WALK3)
+		return monst.position.offset;
+	// The next walk tick moves the monster onto its new tile, there is nothing to extrapolate
+	if ((monst._mFlags & MFLAG_ALLOW_SPECIAL) != 0 || monst.actionFrame == monst.MType->Anims[MA_WALK].Frames)
+		return monst.position.offset;
+
+	// A walking monster only moves on the ticks where its animation advances
+	const int delay = std::max(monst._mAnimDelay, 1);
+	const float progress = ((monst._mAnimCnt + delay - 1) % delay + gfProgressToNextGameTick) / delay;
+	const Point offset2 = monst.position.offset2 + monst.position.velocity * progress;
+	return { offset2.x >> 4, offset2.y >> 4 };
+}
+
 /**
  * @brief Clear cursor state
  */
@@ -255,8 +299,9 @@ void DrawMissilePrivate(const CelOutputBuffer &out, MissileStruct *m, int sx, in
 		Log("Draw Missile 2: frame {} of {}, missile type=={}", nCel, frames, m->_mitype);
 		return;
 	}
-	int mx = sx + m->position.offset.x - m->_miAnimWidth2;
-	int my = sy + m->position.offset.y;
+	const Point offset = GetMissileRenderOffset(*m);
+	int mx = sx + offset.x - m->_miAnimWidth2;
+	int my = sy + offset.y;
 	CelSprite cel { m->_miAnimData, m->_miAnimWidth };
 	if (m->_miUniqTrans)
 		Cl2DrawLightTbl(out, mx, my, cel, m->_miAnimFrame, m->_miUniqTrans + 3);
@@ -478,12 +523,9 @@ static void DrawPlayer(const CelOutputBuffer &out, int pnum, int x, int y, int p
  */
 void DrawDeadPlayer(const CelOutputBuffer &out, int x, int y, int sx, int sy)
 {
-	dFlags[x][y] &= ~BFLAG_DEAD_PLAYER;
-
 	for (int i = 0; i < MAX_PLRS; i++) {
 		auto &player = plr[i];
 		if (player.plractive && player._pHitPoints == 0 && player.plrlevel == (BYTE)currlevel && player.position.tile.x == x && player.position.tile.y == y) {
-			dFlags[x][y] |= BFLAG_DEAD_PLAYER;
 			int px = sx + player.position.offset.x - CalculateWidth2(player.AnimInfo.pCelSprite == nullptr ? 96 : player.AnimInfo.pCelSprite->Width());
 			int py = sy + player.position.offset.y;
 			DrawPlayer(out, i, x, y, px, py);
@@ -491,6 +533,25 @@ void DrawDeadPlayer(const CelOutputBuffer &out, int x, int y, int sx, int sy)
 	}
 }
 
+/**
+ * @brief Flag the cells holding a dead player
+ *
+ * Done once before rendering, so that the render passes don't write to dFlags.
+ */
+static void UpdateDeadPlayerFlags()
+{
+	for (auto &column : dFlags) {
+		for (auto &flags : column)
+			flags &= ~BFLAG_DEAD_PLAYER;
+	}
+
+	for (int i = 0; i < MAX_PLRS; i++) {
+		auto &player = plr[i];
+		if (player.plractive && player._pHitPoints == 0 && player.plrlevel == (BYTE)currlevel)
+			dFlags[player.position.tile.x][player.position.tile.y] |= BFLAG_DEAD_PLAYER;
+	}
+}
+
 /**
  * @brief Render an object sprite
  * @param out Output buffer
@@ -551,6 +612,33 @@ static void DrawObject(const CelOutputBuffer &out, int x, int y, int ox, int oy,
 
 static void scrollrt_draw_dungeon(const CelOutputBuffer &, int, int, int, int);
 
+/**
+ * @brief How far past its tile a sprite drawn for a cell can reach horizontally
+ *
+ * Covers the widest sprites (160 px) with a full walking offset, drawn from a neighbouring cell.
+ */
+constexpr int SpriteMargin = 5 * TILE_WIDTH / 2;
+
+/** Upper limit for the number of threads rendering the dungeon view. */
+constexpr int MaxRenderThreads = 16;
+
+/** Width of the screen hidden behind the open side panels on the left and right, from the top down to SPANEL_HEIGHT */
+static int sgPanelCoverLeft;
+static int sgPanelCoverRight;
+
+/**
+ * @brief Whether the side panels hide a part of the screen, so nothing needs to be drawn in it
+ * @param left Screen coordinate of the left edge
+ * @param right Screen coordinate past the right edge
+ * @param bottom Screen coordinate past the bottom edge
+ */
+static bool IsCoveredByPanels(int left, int right, int bottom)
+{
+	if (bottom > SPANEL_HEIGHT)
+		return false;
+	return right <= sgPanelCoverLeft || left >= gnScreenWidth - sgPanelCoverRight;
+}
+
 /**
  * @brief Render a cell
  * @param out Target buffer
@@ -561,7 +649,7 @@ static void scrollrt_draw_dungeon(const CelOutputBuffer &, int, int, int, int);
  */
 static void drawCell(const CelOutputBuffer &out, int x, int y, int sx, int sy)
 {
-	MICROS *pMap = &dpiece_defs_map_2[x][y];
+	const MICROS *pMap = &LevelPieceMicros[dPieceMicros[x][y]];
 	level_piece_id = dPiece[x][y];
 	cel_transparency_active = (BYTE)(nTransTable[level_piece_id] & TransList[dTransVal[x][y]]);
 	cel_foliage_active = !nSolidTable[level_piece_id];
@@ -595,12 +683,13 @@ static void drawFloor(const CelOutputBuffer &out, int x, int y, int sx, int sy)
 	light_table_index = dLight[x][y];
 
 	arch_draw_type = 1; // Left
-	level_cel_block = dpiece_defs_map_2[x][y].mt[0];
+	const MICROS &micros = LevelPieceMicros[dPieceMicros[x][y]];
+	level_cel_block = micros.mt[0];
 	if (level_cel_block != 0) {
 		RenderTile(out, sx, sy);
 	}
 	arch_draw_type = 2; // Right
-	level_cel_block = dpiece_defs_map_2[x][y].mt[1];
+	level_cel_block = micros.mt[1];
 	if (level_cel_block != 0) {
 		RenderTile(out, sx + TILE_WIDTH / 2, sy);
 	}
@@ -697,8 +786,9 @@ static void DrawMonsterHelper(const CelOutputBuffer &out, int x, int y, int oy,
 
 	const CelSprite &cel = *pMonster->_mAnimData;
 
-	px = sx + pMonster->position.offset.x - CalculateWidth2(cel.Width());
-	py = sy + pMonster->position.offset.y;
+	const Point offset = GetMonsterRenderOffset(*pMonster);
+	px = sx + offset.x - CalculateWidth2(cel.Width());
+	py = sy + offset.y;
 	if (mi == pcursmonst) {
 		Cl2DrawOutline(out, 233, px, py, cel, pMonster->_mAnimFrame);
 	}
@@ -747,10 +837,6 @@ static void scrollrt_draw_dungeon(const CelOutputBuffer &out, int sx, int sy, in
 	assert((DWORD)sx < MAXDUNX);
 	assert((DWORD)sy < MAXDUNY);
 
-	if (dRendered[sx][sy])
-		return;
-	dRendered[sx][sy] = true;
-
 	light_table_index = dLight[sx][sy];
 
 	drawCell(out, sx, sy, dx, dy);
@@ -836,7 +922,7 @@ static void scrollrt_draw_dungeon(const CelOutputBuffer &out, int sx, int sy, in
 		// Tree leaves should always cover player when entering or leaving the tile,
 		// So delay the rendering until after the next row is being drawn.
 		// This could probably have been better solved by sprites in screen space.
-		if (sx > 0 && sy > 0 && dy > TILE_HEIGHT) {
+		if (sx > 0 && sy > 0 && out.region.y + dy > TILE_HEIGHT) {
 			char bArch = dSpecial[sx - 1][sy - 1];
 			if (bArch != 0) {
 				CelDrawTo(out, { dx, dy - TILE_HEIGHT }, *pSpecialCels, bArch);
@@ -859,7 +945,9 @@ static void scrollrt_drawFloor(const CelOutputBuffer &out, int x, int y, int sx,
 {
 	for (int i = 0; i < rows; i++) {
 		for (int j = 0; j < columns; j++) {
-			if (x >= 0 && x < MAXDUNX && y >= 0 && y < MAXDUNY) {
+			if (IsCoveredByPanels(out.region.x + sx, out.region.x + sx + TILE_WIDTH, out.region.y + sy)) {
+				// Hidden behind a side panel
+			} else if (x >= 0 && x < MAXDUNX && y >= 0 && y < MAXDUNY) {
 				level_piece_id = dPiece[x][y];
 				if (level_piece_id != 0) {
 					if (!nSolidTable[level_piece_id])
@@ -891,11 +979,51 @@ static void scrollrt_drawFloor(const CelOutputBuffer &out, int x, int y, int sx,
 	}
 }
 
+/**
+ * @brief A cell of the dungeon pass, queued in the order the cells have to be drawn in
+ */
+struct DungeonCellDraw {
+	uint8_t x;
+	uint8_t y;
+	/** Whether anything besides the dungeon piece is drawn for the cell, see CellHasSprites */
+	bool hasSprites;
+	int sx;
+	int sy;
+};
+
+/** Cells of the dungeon pass for the buffer being drawn, shared by all render threads. */
+static std::vector<DungeonCellDraw> DungeonDrawQueue;
+
+/**
+ * @brief Queue a cell for the dungeon pass unless it is already queued or can't reach the buffer
+ * @param out Buffer to render to
+ * @param x dPiece coordinate
+ * @param y dPiece coordinate
+ * @param sx Target buffer coordinate
+ * @param sy Target buffer coordinate
+ */
+static void QueueDungeonCell(const CelOutputBuffer &out, int x, int y, int sx, int sy)
+{
+	if (dRendered[x][y] == RenderGeneration)
+		return;
+	dRendered[x][y] = RenderGeneration;
+
+	// Nothing drawn for this cell can reach the buffer, happens when drawing a strip of the view
+	if (sx + TILE_WIDTH + SpriteMargin <= 0 || sx - SpriteMargin >= out.w())
+		return;
+	if (sy + SpriteMargin <= 0 || sy - MicroTileLen * TILE_HEIGHT / 2 - SpriteMargin >= out.h())
+		return;
+	if (IsCoveredByPanels(out.region.x + sx - SpriteMargin, out.region.x + sx + TILE_WIDTH + SpriteMargin, out.region.y + sy + SpriteMargin))
+		return;
+
+	DungeonDrawQueue.push_back({ static_cast<uint8_t>(x), static_cast<uint8_t>(y), false, sx, sy });
+}
+
 #define IsWall(x, y) (dPiece[x][y] == 0 || nSolidTable[dPiece[x][y]] || dSpecial[x][y] != 0)
 #define IsWalkable(x, y) (dPiece[x][y] != 0 && !nSolidTable[dPiece[x][y]])
 
 /**
- * @brief Render a row of tile
+ * @brief Queue the cells of the dungeon pass in painter's order
  * @param out Output buffer
  * @param x dPiece coordinate
  * @param y dPiece coordinate
@@ -904,28 +1032,32 @@ static void scrollrt_drawFloor(const CelOutputBuffer &out, int x, int y, int sx,
  * @param rows Number of rows
  * @param columns Tile in a row
  */
-static void scrollrt_draw(const CelOutputBuffer &out, int x, int y, int sx, int sy, int rows, int columns)
+static void QueueDungeonCells(const CelOutputBuffer &out, int x, int y, int sx, int sy, int rows, int columns)
 {
 	// Keep evaluating until MicroTiles can't affect screen
 	rows += MicroTileLen;
-	memset(dRendered, 0, sizeof(dRendered));
+	if (++RenderGeneration == 0) {
+		memset(dRendered, 0, sizeof(dRendered));
+		RenderGeneration = 1;
+	}
+	DungeonDrawQueue.clear();
 
 	for (int i = 0; i < rows; i++) {
 		for (int j = 0; j < columns; j++) {
 			if (x >= 0 && x < MAXDUNX && y >= 0 && y < MAXDUNY) {
-				if (x + 1 < MAXDUNX && y - 1 >= 0 && sx + TILE_WIDTH <= gnScreenWidth) {
+				if (x + 1 < MAXDUNX && y - 1 >= 0 && out.region.x + sx + TILE_WIDTH <= gnScreenWidth) {
 					// Render objects behind walls first to prevent sprites, that are moving
 					// between tiles, from poking through the walls as they exceed the tile bounds.
 					// A proper fix for this would probably be to layout the sceen and render by
 					// sprite screen position rather than tile position.
 					if (IsWall(x, y) && (IsWall(x + 1, y) || (x > 0 && IsWall(x - 1, y)))) { // Part of a wall aligned on the x-axis
 						if (IsWalkable(x + 1, y - 1) && IsWalkable(x, y - 1)) {              // Has walkable area behind it
-							scrollrt_draw_dungeon(out, x + 1, y - 1, sx + TILE_WIDTH, sy);
+							QueueDungeonCell(out, x + 1, y - 1, sx + TILE_WIDTH, sy);
 						}
 					}
 				}
 				if (dPiece[x][y] != 0) {
-					scrollrt_draw_dungeon(out, x, y, sx, sy);
+					QueueDungeonCell(out, x, y, sx, sy);
 				}
 			}
 			ShiftGrid(&x, &y, 1, 0);
@@ -950,9 +1082,460 @@ static void scrollrt_draw(const CelOutputBuffer &out, int x, int y, int sx, int
 }
 
 /**
- * @brief Scale up the top left part of the buffer 2x.
+ * @brief Whether scrollrt_draw_dungeon() draws anything besides the dungeon piece for a cell
  */
-static void Zoom(const CelOutputBuffer &out)
+static bool CellHasSprites(int x, int y)
+{
+	if ((dFlags[x][y] & (BFLAG_MISSILE | BFLAG_PLAYERLR | BFLAG_MONSTLR | BFLAG_DEAD_PLAYER)) != 0)
+		return true;
+	if ((dDead[x][y] | dObject[x][y] | dItem[x][y] | dPlayer[x][y] | dMonster[x][y]) != 0)
+		return true;
+	if (leveltype != DTYPE_TOWN)
+		return dSpecial[x][y] != 0;
+	return x > 0 && y > 0 && dSpecial[x - 1][y - 1] != 0;
+}
+
+/**
+ * @brief Flag the queued cells that have sprites on them
+ *
+ * The dungeon arrays are read row by row over the area covered by the queue, rather than one cell of
+ * each array at a time in drawing order, so empty cells cost a single check when they are drawn.
+ */
+static void FlagDungeonCellsWithSprites()
+{
+	if (DungeonDrawQueue.empty())
+		return;
+
+	int minX = MAXDUNX;
+	int minY = MAXDUNY;
+	int maxX = 0;
+	int maxY = 0;
+	for (const DungeonCellDraw &cell : DungeonDrawQueue) {
+		minX = std::min<int>(minX, cell.x);
+		minY = std::min<int>(minY, cell.y);
+		maxX = std::max<int>(maxX, cell.x);
+		maxY = std::max<int>(maxY, cell.y);
+	}
+
+	static bool dHasSprites[MAXDUNX][MAXDUNY];
+	for (int x = minX; x <= maxX; x++) {
+		for (int y = minY; y <= maxY; y++)
+			dHasSprites[x][y] = CellHasSprites(x, y);
+	}
+
+	for (DungeonCellDraw &cell : DungeonDrawQueue)
+		cell.hasSprites = dHasSprites[cell.x][cell.y];
+}
+
+/**
+ * @brief Render the queued cells of the dungeon pass that can reach a band of the buffer
+ * @param out Band to render to
+ * @param top Offset of the band in the buffer the cells were queued for
+ */
+static void scrollrt_draw(const CelOutputBuffer &out, int top)
+{
+	// Cells are queued row by row, so the ones reaching the band are a single run of the queue
+	const auto first = std::partition_point(DungeonDrawQueue.begin(), DungeonDrawQueue.end(), [&](const DungeonCellDraw &cell) {
+		return cell.sy - top + SpriteMargin <= 0;
+	});
+	const auto last = std::partition_point(first, DungeonDrawQueue.end(), [&](const DungeonCellDraw &cell) {
+		return cell.sy - top - MicroTileLen * TILE_HEIGHT / 2 - SpriteMargin < out.h();
+	});
+
+	for (auto cell = first; cell != last; ++cell) {
+		if (!cell->hasSprites
+#ifdef _DEBUG
+		    && !visiondebug
+#endif
+		) {
+			light_table_index = dLight[cell->x][cell->y];
+			drawCell(out, cell->x, cell->y, cell->sx, cell->sy - top);
+			continue;
+		}
+		scrollrt_draw_dungeon(out, cell->x, cell->y, cell->sx, cell->sy - top);
+	}
+}
+
+ThreadPool *GetRenderThreadPool()
+{
+	static std::unique_ptr<ThreadPool> pool;
+	static int poolThreads = 1;
+
+	int threads = sgOptions.Graphics.nRenderThreads;
+	if (threads <= 0)
+		threads = SDL_GetCPUCount();
+	threads = std::min(std::max(threads, 1), MaxRenderThreads);
+	if (threads != poolThreads) {
+		pool = nullptr;
+		if (threads > 1)
+			pool = std::make_unique<ThreadPool>(threads - 1);
+		poolThreads = threads;
+	}
+
+	return pool.get();
+}
+
+/**
+ * @brief Render the floor and dungeon passes, split into horizontal bands when there are render threads
+ *
+ * The cells of the dungeon pass are queued once, then every band draws the queued cells that can reach it,
+ * clipped to the band, so the draw order within a band is the same as when drawing the whole view at once.
+ * @param out Buffer to render to
+ * @param x dPiece coordinate
+ * @param y dPiece coordinate
+ * @param sx Target buffer coordinate
+ * @param sy Target buffer coordinate
+ * @param rows Number of rows
+ * @param columns Tile in a row
+ */
+static void DrawDungeon(const CelOutputBuffer &out, int x, int y, int sx, int sy, int rows, int columns)
+{
+	QueueDungeonCells(out, x, y, sx, sy, rows, columns);
+	FlagDungeonCellsWithSprites();
+
+	ThreadPool *pool = GetRenderThreadPool();
+	SetTileRenderThreads(pool != nullptr ? pool->Concurrency() : 1);
+	// Item labels are queued while drawing, which is not thread safe
+	if (pool == nullptr || IsHighlightingLabelsEnabled()) {
+		scrollrt_drawFloor(out, x, y, sx, sy, rows, columns);
+		scrollrt_draw(out, 0);
+		return;
+	}
+
+	const unsigned bands = pool->Concurrency();
+	pool->ParallelFor(bands, [&](unsigned band) {
+		const int top = out.h() * band / bands;
+		const int bottom = out.h() * (band + 1) / bands;
+		const CelOutputBuffer bandOut = out.subregionY(top, bottom - top);
+		scrollrt_drawFloor(bandOut, x, y, sx, sy - top, rows, columns);
+		scrollrt_draw(bandOut, top);
+	});
+}
+
+/**
+ * @brief Frame wide inputs of the dungeon view, the whole view is redrawn when any of them changes
+ */
+struct ViewportState {
+	int x;
+	int y;
+	int sx;
+	int sy;
+	int rows;
+	int columns;
+	int width;
+	int height;
+	int level;
+	bool setlevel;
+	bool infravision;
+	bool missilePreFlag;
+	bool blendedTransparency;
+	bool showItems;
+	int panelCoverLeft;
+	int panelCoverRight;
+
+	bool operator==(const ViewportState &other) const
+	{
+		return x == other.x && y == other.y && sx == other.sx && sy == other.sy
+		    && rows == other.rows && columns == other.columns
+		    && width == other.width && height == other.height
+		    && level == other.level && setlevel == other.setlevel
+		    && infravision == other.infravision && missilePreFlag == other.missilePreFlag
+		    && blendedTransparency == other.blendedTransparency && showItems == other.showItems
+		    && panelCoverLeft == other.panelCoverLeft && panelCoverRight == other.panelCoverRight;
+	}
+};
+
+/** Copy of the dungeon view without the UI, kept between frames for incremental redraws. */
+static CelOutputBuffer sgViewportCache;
+static ViewportState sgViewportState;
+static bool sgbViewportCacheValid;
+/** Signature of everything drawn for each cell during the previous frame. */
+static uint32_t dCellSignature[MAXDUNX][MAXDUNY];
+/** Signature of the missiles and players standing on each cell during the current frame. */
+static uint32_t dSpriteSignature[MAXDUNX][MAXDUNY];
+/** Cells with a non-zero dSpriteSignature, so only those need to be reset for the next frame. */
+static std::vector<Point> sgSignedCells;
+/** Width of the strips the view is split into when looking for changes. */
+constexpr int StripWidth = TILE_WIDTH / 2;
+
+static uint32_t MixSignature(uint32_t hash, uint32_t value)
+{
+	return (hash ^ value) * 16777619U;
+}
+
+static uint32_t MixSignature(uint32_t hash, const void *ptr)
+{
+	return MixSignature(hash, static_cast<uint32_t>(reinterpret_cast<uintptr_t>(ptr)));
+}
+
+static uint32_t MixSignature(uint32_t hash, Point position)
+{
+	return MixSignature(MixSignature(hash, position.x), position.y);
+}
+
+/**
+ * @brief Collect the state of missiles and players, which are not indexed by a single dungeon array
+ */
+static void CalcSpriteSignatures()
+{
+	for (Point cell : sgSignedCells)
+		dSpriteSignature[cell.x][cell.y] = 0;
+	sgSignedCells.clear();
+
+	for (int i = 0; i < nummissiles; i++) {
+		const MissileStruct &m = missile[missileactive[i]];
+		const Point tile = m.position.tile;
+		if (tile.x < 0 || tile.x >= MAXDUNX || tile.y < 0 || tile.y >= MAXDUNY)
+			continue;
+		sgSignedCells.push_back(tile);
+		uint32_t &hash = dSpriteSignature[tile.x][tile.y];
+		hash = MixSignature(hash, m._miAnimData);
+		hash = MixSignature(hash, m._miAnimFrame);
+		hash = MixSignature(hash, GetMissileRenderOffset(m));
+		hash = MixSignature(hash, m._miUniqTrans);
+		hash = MixSignature(hash, (m._miDrawFlag ? 1 : 0) | (m._miPreFlag ? 2 : 0) | (m._miLightFlag ? 4 : 0));
+	}
+
+	for (int i = 0; i < MAX_PLRS; i++) {
+		const auto &player = plr[i];
+		if (!player.plractive || player.plrlevel != currlevel)
+			continue;
+		const Point tile = player.position.tile;
+		if (tile.x < 0 || tile.x >= MAXDUNX || tile.y < 0 || tile.y >= MAXDUNY)
+			continue;
+		sgSignedCells.push_back(tile);
+		uint32_t &hash = dSpriteSignature[tile.x][tile.y];
+		hash = MixSignature(hash, player.AnimInfo.pCelSprite);
+		hash = MixSignature(hash, player.AnimInfo.GetFrameToUseForRendering());
+		hash = MixSignature(hash, player.IsWalking() ? GetOffsetForWalking(player.AnimInfo, player._pdir) : player.position.offset);
+		hash = MixSignature(hash, (player._pHitPoints == 0 ? 1 : 0) | (player.pManaShield ? 2 : 0) | (player.wReflections > 0 ? 4 : 0) | (i == pcursplr ? 8 : 0));
+	}
+}
+
+/**
+ * @brief Calculate a signature of everything scrollrt_draw_dungeon() reads for a cell
+ */
+static uint32_t CalcCellSignature(int x, int y)
+{
+	uint32_t hash = 2166136261U;
+	hash = MixSignature(hash, dPiece[x][y]);
+	hash = MixSignature(hash, dLight[x][y]);
+	hash = MixSignature(hash, dFlags[x][y]);
+	hash = MixSignature(hash, dDead[x][y]);
+	hash = MixSignature(hash, dSpecial[x][y]);
+	hash = MixSignature(hash, TransList[static_cast<uint8_t>(dTransVal[x][y])]);
+	hash = MixSignature(hash, dMissile[x][y]);
+	hash = MixSignature(hash, dPlayer[x][y]);
+	hash = MixSignature(hash, dSpriteSignature[x][y]);
+
+	if (dMonster[x][y] != 0) {
+		int mi = dMonster[x][y];
+		mi = mi > 0 ? mi - 1 : -(mi + 1);
+		hash = MixSignature(hash, mi == pcursmonst);
+		if (leveltype == DTYPE_TOWN) {
+			hash = MixSignature(hash, towners[mi]._tAnimData);
+			hash = MixSignature(hash, towners[mi]._tAnimFrame);
+		} else if (mi >= 0 && mi < MAXMONSTERS) {
+			const MonsterStruct &monst = monster[mi];
+			hash = MixSignature(hash, monst._mAnimData);
+			hash = MixSignature(hash, monst._mAnimFrame);
+			hash = MixSignature(hash, GetMonsterRenderOffset(monst));
+			hash = MixSignature(hash, monst._mFlags & MFLAG_HIDDEN);
+			hash = MixSignature(hash, monst._mmode == MM_STONE);
+			hash = MixSignature(hash, monst._uniqtrans);
+		}
+	}
+
+	if (dObject[x][y] != 0) {
+		int bv = dObject[x][y];
+		bv = bv > 0 ? bv - 1 : -(bv + 1);
+		const ObjectStruct &obj = object[bv];
+		hash = MixSignature(hash, obj._oAnimData);
+		hash = MixSignature(hash, obj._oAnimFrame);
+		hash = MixSignature(hash, (obj._oLight ? 1 : 0) | (obj._oPreFlag ? 2 : 0) | (bv == pcursobj ? 4 : 0));
+	}
+
+	if (dItem[x][y] > 0) {
+		const int ii = dItem[x][y] - 1;
+		const ItemStruct &item = items[ii];
+		hash = MixSignature(hash, item.AnimInfo.pCelSprite);
+		hash = MixSignature(hash, item.AnimInfo.GetFrameToUseForRendering());
+		hash = MixSignature(hash, item._iSeed);
+		hash = MixSignature(hash, (item._iPostDraw ? 1 : 0) | (ii == pcursitem ? 2 : 0) | (item._iIdentified ? 4 : 0));
+	}
+
+	// Town trees are drawn one cell late, see scrollrt_draw_dungeon()
+	if (leveltype == DTYPE_TOWN && x > 0 && y > 0)
+		hash = MixSignature(hash, dSpecial[x - 1][y - 1]);
+
+	return hash;
+}
+
+/**
+ * @brief Compare the cells in view with the previous frame and mark the strips of the view they can draw to
+ * @param dirty Strips of the view that need to be redrawn
+ * @param x dPiece coordinate
+ * @param y dPiece coordinate
+ * @param sx Target buffer coordinate
+ * @param rows Number of rows
+ * @param columns Tile in a row
+ */
+static void MarkChangedStrips(std::vector<bool> &dirty, int x, int y, int sx, int rows, int columns)
+{
+	const int strips = static_cast<int>(dirty.size());
+
+	// Same traversal as QueueDungeonCells()
+	rows += MicroTileLen;
+	for (int i = 0; i < rows; i++) {
+		for (int j = 0; j < columns; j++) {
+			if (x >= 0 && x < MAXDUNX && y >= 0 && y < MAXDUNY) {
+				const uint32_t signature = CalcCellSignature(x, y);
+				if (signature != dCellSignature[x][y]) {
+					dCellSignature[x][y] = signature;
+					const int first = std::max((sx - SpriteMargin) / StripWidth, 0);
+					const int last = std::min((sx + TILE_WIDTH + SpriteMargin) / StripWidth, strips - 1);
+					for (int strip = first; strip <= last; strip++)
+						dirty[strip] = true;
+				}
+			}
+			ShiftGrid(&x, &y, 1, 0);
+			sx += TILE_WIDTH;
+		}
+		ShiftGrid(&x, &y, -columns, 0);
+		sx -= columns * TILE_WIDTH;
+
+		if ((i & 1) != 0) {
+			x++;
+			columns--;
+			sx += TILE_WIDTH / 2;
+		} else {
+			y++;
+			columns++;
+			sx -= TILE_WIDTH / 2;
+		}
+	}
+}
+
+/**
+ * @brief Render the dungeon view, only redrawing the strips that changed since the previous frame
+ * @param out Buffer to render to
+ * @param x dPiece coordinate
+ * @param y dPiece coordinate
+ * @param sx Target buffer coordinate
+ * @param sy Target buffer coordinate
+ * @param rows Number of rows
+ * @param columns Tile in a row
+ */
+static void DrawGameIncremental(const CelOutputBuffer &out, int x, int y, int sx, int sy, int rows, int columns)
+{
+	if (sgViewportCache.surface == nullptr || sgViewportCache.w() != out.w() || sgViewportCache.h() != out.h()) {
+		if (sgViewportCache.surface != nullptr)
+			sgViewportCache.Free();
+		sgViewportCache = CelOutputBuffer::Alloc(out.w(), out.h());
+		sgbViewportCacheValid = false;
+	}
+
+	ViewportState state;
+	state.x = x;
+	state.y = y;
+	state.sx = sx;
+	state.sy = sy;
+	state.rows = rows;
+	state.columns = columns;
+	state.width = out.w();
+	state.height = out.h();
+	state.level = currlevel;
+	state.setlevel = setlevel;
+	state.infravision = plr[myplr]._pInfraFlag;
+	state.missilePreFlag = MissilePreFlag;
+	state.blendedTransparency = sgOptions.Graphics.bBlendedTransparancy;
+	state.showItems = AutoMapShowItems;
+	state.panelCoverLeft = sgPanelCoverLeft;
+	state.panelCoverRight = sgPanelCoverRight;
+#ifdef _DEBUG
+	// Debug overlays are not tracked per cell
+	if (visiondebug)
+		sgbViewportCacheValid = false;
+#endif
+	if (!(state == sgViewportState))
+		sgbViewportCacheValid = false;
+	sgViewportState = state;
+
+	static std::vector<bool> dirty;
+	dirty.assign((out.w() + StripWidth - 1) / StripWidth, !sgbViewportCacheValid);
+	CalcSpriteSignatures();
+	MarkChangedStrips(dirty, x, y, sx, rows, columns);
+	sgbViewportCacheValid = true;
+
+	for (int first = 0; first < static_cast<int>(dirty.size()); first++) {
+		if (!dirty[first])
+			continue;
+		int last = first;
+		while (last + 1 < static_cast<int>(dirty.size()) && dirty[last + 1])
+			last++;
+
+		const int stripX = first * StripWidth;
+		const int stripWidth = std::min((last + 1) * StripWidth, out.w()) - stripX;
+		const CelOutputBuffer strip = sgViewportCache.subregion(stripX, 0, stripWidth, out.h());
+		for (int row = 0; row < strip.h(); row++)
+			memset(strip.at(0, row), 0, stripWidth);
+		DrawDungeon(strip, x, y, sx - stripX, sy, rows, columns);
+
+		first = last;
+	}
+
+	for (int row = 0; row < out.h(); row++)
+		memcpy(out.at(0, row), sgViewportCache.at(0, row), out.w());
+}
+
+/**
+ * @brief Drop the cached dungeon view, the next frame will redraw all of it
+ */
+void InvalidateViewportCache()
+{
+	sgbViewportCacheValid = false;
+}
+
+/**
+ * @brief Writes every pixel of the source line twice, dst[2 * i] = dst[2 * i + 1] = src[i]
+ * @param dst Target line, must hold 2 * n pixels and not overlap the source
+ * @param src Source line
+ * @param n Number of source pixels
+ */
+static void DoublePixels(uint8_t *dst, const uint8_t *src, int n)
+{
+	int i = 0;
+#if defined(DVL_SIMD_AVX2)
+	for (; i + 32 <= n; i += 32, src += 32, dst += 64) {
+		const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src));
+		// unpack works per 128-bit lane, the permutes put the halves back in order
+		const __m256i lo = _mm256_unpacklo_epi8(v, v);
+		const __m256i hi = _mm256_unpackhi_epi8(v, v);
+		_mm256_storeu_si256(reinterpret_cast<__m256i *>(dst), _mm256_permute2x128_si256(lo, hi, 0x20));
+		_mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + 32), _mm256_permute2x128_si256(lo, hi, 0x31));
+	}
+#endif
+#if defined(DVL_SIMD_NEON)
+	for (; i + 16 <= n; i += 16, src += 16, dst += 32) {
+		const uint8x16_t v = vld1q_u8(src);
+		// Interleaving a vector with itself doubles every pixel
+		const uint8x16x2_t pair = { { v, v } };
+		vst2q_u8(dst, pair);
+	}
+#elif defined(DVL_SIMD_SSE2)
+	for (; i + 16 <= n; i += 16, src += 16, dst += 32) {
+		const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src));
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(dst), _mm_unpacklo_epi8(v, v));
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(dst + 16), _mm_unpackhi_epi8(v, v));
+	}
+#endif
+	for (; i < n; i++, src++, dst += 2) {
+		dst[0] = *src;
+		dst[1] = *src;
+	}
+}
+
+void Zoom(const CelOutputBuffer &out)
 {
 	int viewport_width = out.w();
 	int viewport_offset_x = 0;
@@ -966,41 +1549,24 @@ static void Zoom(const CelOutputBuffer &out)
 	}
 
 	// We round to even for the source width and height.
-	// If the width / height was odd, we copy just one extra pixel / row later on.
+	// If the width / height is odd, the first pixel / row is only copied once.
 	const int src_width = (viewport_width + 1) / 2;
-	const int doubleable_width = viewport_width / 2;
 	const int src_height = (out.h() + 1) / 2;
-	const int doubleable_height = out.h() / 2;
-
-	BYTE *src = out.at(src_width - 1, src_height - 1);
-	BYTE *dst = out.at(viewport_offset_x + viewport_width - 1, out.h() - 1);
-	const bool odd_viewport_width = (viewport_width % 2) == 1;
-
-	for (int hgt = 0; hgt < doubleable_height; hgt++) {
-		// Double the pixels in the line.
-		for (int i = 0; i < doubleable_width; i++) {
-			*dst-- = *src;
-			*dst-- = *src;
-			--src;
-		}
+	const int odd_width = viewport_width % 2;
+	const int odd_height = out.h() % 2;
 
-		// Copy a single extra pixel if the output width is odd.
-		if (odd_viewport_width) {
-			*dst-- = *src;
-			--src;
-		}
+	static std::vector<uint8_t> line;
+	line.resize(viewport_width);
 
-		// Skip the rest of the source line.
-		src -= (out.pitch() - src_width);
+	// Going bottom to top, the target rows of a source row never cover source rows that are still needed.
+	for (int y = src_height - 1; y >= 0; y--) {
+		const uint8_t *src = out.at(0, y);
+		if (odd_width != 0)
+			line[0] = src[0];
+		DoublePixels(&line[odd_width], src + odd_width, src_width - odd_width);
 
-		// Double the line.
-		memcpy(dst - out.pitch() + 1, dst + 1, viewport_width);
-
-		// Skip the rest of the destination line.
-		dst -= 2 * out.pitch() - viewport_width;
-	}
-	if ((out.h() % 2) == 1) {
-		memcpy(dst - out.pitch() + 1, dst + 1, viewport_width);
+		for (int row = std::max(2 * y - odd_height, 0); row <= 2 * y - odd_height + 1; row++)
+			memcpy(out.at(viewport_offset_x, row), line.data(), viewport_width);
 	}
 }
 
@@ -1097,6 +1663,37 @@ int tileShiftX;
 int tileShiftY;
 int tileColums;
 int tileRows;
+int cursorTileShiftX;
+int cursorTileShiftY;
+int cursorPixelShiftX;
+int cursorPixelShiftY;
+
+/**
+ * @brief Precompute the screen to tile mapping used by CheckCursMove, this only changes with the viewport
+ */
+static void CalcCursorGeometry(int xo, int yo, int columns, int lrow)
+{
+	cursorTileShiftX = 0;
+	cursorTileShiftY = 0;
+	cursorPixelShiftX = xo;
+	cursorPixelShiftY = yo;
+
+	// Center player tile on screen
+	ShiftGrid(&cursorTileShiftX, &cursorTileShiftY, -columns / 2, -lrow / 2);
+
+	// Align grid
+	if ((columns & 1) == 0 && (lrow & 1) == 0) {
+		cursorPixelShiftY += TILE_HEIGHT / 2;
+	} else if ((columns & 1) != 0 && (lrow & 1) != 0) {
+		cursorPixelShiftX -= TILE_WIDTH / 2;
+	} else if ((columns & 1) != 0 && (lrow & 1) == 0) {
+		cursorTileShiftY++;
+	}
+
+	if (!zoomflag) {
+		cursorPixelShiftY -= TILE_HEIGHT / 4;
+	}
+}
 
 void CalcViewportGeometry()
 {
@@ -1111,6 +1708,7 @@ void CalcViewportGeometry()
 
 	TilesInView(&tileColums, &tileRows);
 	int lrow = tileRows - RowsCoveredByPanel();
+	CalcCursorGeometry(xo, yo, tileColums, lrow);
 
 	// Center player tile on screen
 	ShiftGrid(&tileShiftX, &tileShiftY, -tileColums / 2, -lrow / 2);
@@ -1139,7 +1737,7 @@ void CalcViewportGeometry()
 			tileRows++;
 	}
 
-	tileRows++; // Cover lower edge saw tooth, right edge accounted for in scrollrt_draw()
+	tileRows++; // Cover lower edge saw tooth, right edge accounted for in QueueDungeonCells()
 }
 
 /**
@@ -1152,6 +1750,8 @@ static void DrawGame(const CelOutputBuffer &full_out, int x, int y)
 {
 	int sx, sy, columns, rows;
 
+	UpdateDeadPlayerFlags();
+
 	// Limit rendering to the view area
 	const CelOutputBuffer &out = zoomflag
 	    ? full_out.subregionY(0, gnViewportHeight)
@@ -1171,6 +1771,11 @@ static void DrawGame(const CelOutputBuffer &full_out, int x, int y)
 	x += tileShiftX;
 	y += tileShiftY;
 
+	// The side panels are drawn over the view, tiles and sprites entirely behind them are skipped.
+	// The zoomed view is scaled after drawing, so its buffer coordinates don't match the panels.
+	sgPanelCoverLeft = zoomflag && (chrflag || questlog) ? SPANEL_WIDTH : 0;
+	sgPanelCoverRight = zoomflag && (invflag || sbookflag) ? SPANEL_WIDTH : 0;
+
 	// Skip rendering parts covered by the panels
 	if (CanPanelsCoverView()) {
 		if (zoomflag) {
@@ -1243,8 +1848,14 @@ static void DrawGame(const CelOutputBuffer &full_out, int x, int y)
 		break;
 	}
 
-	scrollrt_drawFloor(out, x, y, sx, sy, rows, columns);
-	scrollrt_draw(out, x, y, sx, sy, rows, columns);
+	// Item labels are queued while drawing, so they need every item to be drawn each frame
+	if (sgOptions.Graphics.bIncrementalRedraw && zoomflag && !IsHighlightingLabelsEnabled()) {
+		DrawGameIncremental(out, x, y, sx, sy, rows, columns);
+		return;
+	}
+	InvalidateViewportCache();
+
+	DrawDungeon(out, x, y, sx, sy, rows, columns);
 
 	if (!zoomflag) {
 		Zoom(full_out.subregionY(0, gnViewportHeight));
@@ -1256,6 +1867,8 @@ extern void DrawControllerModifierHints(const CelOutputBuffer &out);
 
 void DrawView(const CelOutputBuffer &out, int StartX, int StartY)
 {
+	ProfileScope profileScope(ProfilePhase::DrawView);
+
 	DrawGame(out, StartX, StartY);
 	if (AutomapActive) {
 		DrawAutomap(out.subregionY(0, gnViewportHeight));
@@ -1428,7 +2041,9 @@ void EnableFrameCount()
 static void DrawFPS(const CelOutputBuffer &out)
 {
 	DWORD tc, frames;
-	char String[12];
+	char String[32];
+	static uint32_t missedDeadlinesAtStart;
+	static uint32_t missedDeadlines;
 
 	if (frameflag && gbActive) {
 		frameend++;
@@ -1438,12 +2053,167 @@ static void DrawFPS(const CelOutputBuffer &out)
 			framestart = tc;
 			framerate = 1000 * frameend / frames;
 			frameend = 0;
+			missedDeadlines = GetMissedFrameDeadlines() - missedDeadlinesAtStart;
+			missedDeadlinesAtStart += missedDeadlines;
 		}
-		snprintf(String, 12, "%i FPS", framerate);
+		if (missedDeadlines != 0)
+			snprintf(String, sizeof(String), "%i FPS, %u late", framerate, static_cast<unsigned>(missedDeadlines));
+		else
+			snprintf(String, sizeof(String), "%i FPS", framerate);
 		DrawString(out, String, { 8, 65, 0, 0 }, UIS_RED);
 	}
 }
 
+/**
+ * @brief Display the turn timing and traffic of each player
+ */
+static void DrawNetStats(const CelOutputBuffer &out)
+{
+	if (!gbIsMultiplayer || !sgOptions.Network.bShowNetStats)
+		return;
+
+	static uint32_t lastSampleTicks;
+	static uint64_t lastBytesSent;
+	static uint64_t lastBytesReceived[MAX_PLRS];
+	static uint32_t bytesSentPerSecond;
+	static uint32_t bytesReceivedPerSecond[MAX_PLRS];
+	struct BusyCommand {
+		int cmd;
+		uint32_t bytesPerSecond;
+		uint32_t countPerSecond;
+		uint32_t microsecondsEach;
+	};
+	constexpr int NumBusyCommands = 3;
+	static std::array<CommandStats, 256> lastCommandStats;
+	static BusyCommand busyCommands[NumBusyCommands];
+	static int numBusyCommands;
+
+	NetStats stats;
+	if (!SNetGetNetStats(&stats))
+		return;
+
+	const uint32_t now = SDL_GetTicks();
+	if (now - lastSampleTicks >= 1000) {
+		const uint32_t elapsed = now - lastSampleTicks;
+		bytesSentPerSecond = (stats.bytesSent - lastBytesSent) * 1000 / elapsed;
+		lastBytesSent = stats.bytesSent;
+		for (int i = 0; i < MAX_PLRS; i++) {
+			bytesReceivedPerSecond[i] = (stats.peers[i].bytesReceived - lastBytesReceived[i]) * 1000 / elapsed;
+			lastBytesReceived[i] = stats.peers[i].bytesReceived;
+		}
+
+		const std::array<CommandStats, 256> &commandStats = GetCommandStats();
+		const uint64_t ticksPerMicrosecond = std::max<uint64_t>(SDL_GetPerformanceFrequency() / 1000000, 1);
+		numBusyCommands = 0;
+		for (int cmd = 0; cmd < 256; cmd++) {
+			const CommandStats &current = commandStats[cmd];
+			const CommandStats &last = lastCommandStats[cmd];
+			const uint32_t count = current.count - last.count;
+			if (count == 0)
+				continue;
+			BusyCommand busy;
+			busy.cmd = cmd;
+			busy.bytesPerSecond = (current.bytes - last.bytes) * 1000 / elapsed;
+			busy.countPerSecond = static_cast<uint64_t>(count) * 1000 / elapsed;
+			busy.microsecondsEach = (current.handlerTicks - last.handlerTicks) / ticksPerMicrosecond / count;
+			int slot = numBusyCommands;
+			while (slot > 0 && busyCommands[slot - 1].bytesPerSecond < busy.bytesPerSecond) {
+				if (slot < NumBusyCommands)
+					busyCommands[slot] = busyCommands[slot - 1];
+				slot--;
+			}
+			if (slot < NumBusyCommands)
+				busyCommands[slot] = busy;
+			numBusyCommands = std::min(numBusyCommands + 1, NumBusyCommands);
+		}
+		lastCommandStats = commandStats;
+		lastSampleTicks = now;
+	}
+
+	char text[128];
+	int y = out.h() - 160;
+	snprintf(text, sizeof(text), "Sent %u B/s, %u turns in transit, %u queued, oldest monster sync %u packets ago", bytesSentPerSecond, stats.turnsInTransit, stats.sendQueueDepth,
+	    GetMonsterSyncStaleness());
+	DrawString(out, text, { 8, y, 0, 0 }, UIS_SILVER);
+	for (int i = 0; i < MAX_PLRS; i++) {
+		const NetPeerStats &peer = stats.peers[i];
+		if (!peer.connected)
+			continue;
+		y += 12;
+		snprintf(text, sizeof(text), "%s: %u B/s, %u turns, %u ms ago, %u +- %u ms", plr[i]._pName, bytesReceivedPerSecond[i],
+		    peer.turnsQueued, peer.msSinceLastPacket, peer.turnIntervalMs, peer.turnJitterMs);
+		DrawString(out, text, { 8, y, 0, 0 }, peer.msSinceLastPacket > 1000 ? UIS_RED : UIS_SILVER);
+	}
+	for (int i = 0; i < numBusyCommands; i++) {
+		const BusyCommand &busy = busyCommands[i];
+		y += 12;
+		snprintf(text, sizeof(text), "cmd %d: %u B/s, %u/s, %u us", busy.cmd, busy.bytesPerSecond, busy.countPerSecond, busy.microsecondsEach);
+		DrawString(out, text, { 8, y, 0, 0 }, UIS_GOLD);
+	}
+}
+
+/**
+ * @brief Display the time spent in each profiled phase during the last frame
+ */
+static void DrawFrameProfile(const CelOutputBuffer &out)
+{
+	if (!IsProfilerEnabled())
+		return;
+
+	constexpr uint8_t PhaseColors[] = { PAL16_BLUE + 4, PAL16_RED + 4, PAL16_YELLOW + 4, PAL16_ORANGE + 4, PAL16_BEIGE + 4,
+		PAL16_GRAY + 4, PAL16_BLUE + 10, PAL16_RED + 10, PAL16_YELLOW + 10 };
+	static_assert(sizeof(PhaseColors) == enum_size<ProfilePhase>::value, "One color per phase");
+	// 10 pixels per millisecond
+	constexpr int MicrosecondsPerPixel = 100;
+	constexpr int BarHeight = 8;
+
+	const int maxX = out.w() - 8;
+	const FrameProfile &profile = ProfilerLastFrame();
+	int x = 8;
+	int y = 80;
+	for (ProfilePhase phase : enum_values<ProfilePhase>()) {
+		const auto i = static_cast<std::size_t>(phase);
+		const int width = std::min(static_cast<int>(profile[i] / MicrosecondsPerPixel), maxX - x);
+		for (int line = 0; line < BarHeight; line++)
+			DrawHorizontalLine(out, { x, y + line }, width, PhaseColors[i]);
+		x += width;
+	}
+
+	y += BarHeight + 4;
+	char text[64];
+	for (ProfilePhase phase : enum_values<ProfilePhase>()) {
+		const auto i = static_cast<std::size_t>(phase);
+		for (int line = 0; line < BarHeight; line++)
+			DrawHorizontalLine(out, { 8, y + line }, BarHeight, PhaseColors[i]);
+		snprintf(text, sizeof(text), "%s %.2f ms", ProfilePhaseName(phase), profile[i] / 1000.0);
+		DrawString(out, text, { 8 + BarHeight + 4, y + BarHeight + 1, 0, 0 }, UIS_SILVER);
+		y += 12;
+	}
+
+	snprintf(text, sizeof(text), "Render kernels: %s", SimdName());
+	DrawString(out, text, { 8, y + BarHeight + 1, 0, 0 }, UIS_SILVER);
+}
+
+#ifdef MEMORY_STATS
+/**
+ * @brief Display the current and peak heap usage of each subsystem
+ */
+static void DrawMemoryStats(const CelOutputBuffer &out)
+{
+	if (!IsMemoryOverlayEnabled())
+		return;
+
+	char text[64];
+	int y = 80;
+	for (MemoryTag tag : enum_values<MemoryTag>()) {
+		const MemoryTagStats stats = GetMemoryStats(tag);
+		snprintf(text, sizeof(text), "%s %.1f MiB, peak %.1f MiB", MemoryTagName(tag), stats.current / (1024.0 * 1024.0), stats.peak / (1024.0 * 1024.0));
+		DrawString(out, text, { out.w() - 260, y, 0, 0 }, UIS_SILVER);
+		y += 12;
+	}
+}
+#endif
+
 /**
  * @brief Update part of the screen from the back buffer
  * @param dwX Back buffer coordinate
@@ -1476,6 +2246,8 @@ static void DoBlitScreen(Sint16 dwX, Sint16 dwY, Uint16 dwWdt, Uint16 dwHgt)
  */
 static void DrawMain(int dwHgt, bool draw_desc, bool draw_hp, bool draw_mana, bool draw_sbar, bool draw_btn)
 {
+	ProfileScope profileScope(ProfilePhase::DrawMain);
+
 	if (!gbActive || RenderDirectlyToOutputSurface) {
 		return;
 	}
@@ -1552,10 +2324,20 @@ void scrollrt_draw_game_screen()
  */
 void DrawAndBlit()
 {
+	ProfileScope profileScope("DrawAndBlit");
+
 	if (!gbRunGame) {
 		return;
 	}
 
+	if (!gbActive) {
+		// Nothing is shown while the window is hidden, only keep the frame pacing and draw everything once it is back
+		force_redraw = 255;
+		RenderPresent();
+		ProfilerEndFrame();
+		return;
+	}
+
 	int hgt = 0;
 	bool ddsdesc = false;
 	bool ctrlPan = false;
@@ -1574,6 +2356,8 @@ void DrawAndBlit()
 		hgt = gnViewportHeight;
 	}
 
+	if (force_redraw == 255)
+		InvalidateViewportCache();
 	force_redraw = 0;
 
 	lock_buf(0);
@@ -1611,6 +2395,12 @@ void DrawAndBlit()
 	}
 
 	DrawFPS(out);
+	DrawNetStats(out);
+	DrawFrameProfile(out);
+#ifdef MEMORY_STATS
+	DrawMemoryStats(out);
+#endif
+	CaptureFrameDump(out);
 
 	unlock_buf(0);
 
@@ -1622,6 +2412,8 @@ void DrawAndBlit()
 	drawmanaflag = false;
 	drawbtnflag = false;
 	drawsbarflag = false;
+
+	ProfilerEndFrame();
 }
 
 } // namespace devilution
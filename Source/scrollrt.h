@@ -28,12 +28,13 @@ enum _scroll_direction : uint8_t {
 extern bool sgbControllerActive;
 extern bool IsMovingMouseCursorWithController();
 
-extern int light_table_index;
-extern uint32_t level_cel_block;
-extern char arch_draw_type;
-extern bool cel_transparency_active;
-extern bool cel_foliage_active;
-extern int level_piece_id;
+// The render state is per thread, the dungeon view can be drawn by several threads at once.
+extern thread_local int light_table_index;
+extern thread_local uint32_t level_cel_block;
+extern thread_local char arch_draw_type;
+extern thread_local bool cel_transparency_active;
+extern thread_local bool cel_foliage_active;
+extern thread_local int level_piece_id;
 extern bool AutoMapShowItems;
 
 /**
@@ -51,6 +52,20 @@ void CalcTileOffset(int *offsetX, int *offsetY);
 void TilesInView(int *columns, int *rows);
 void CalcViewportGeometry();
 
+/** Tiles from the view position to the top left tile, as used for cursor picking */
+extern int cursorTileShiftX;
+extern int cursorTileShiftY;
+/** Pixels added to the cursor position before converting it to tiles */
+extern int cursorPixelShiftX;
+extern int cursorPixelShiftY;
+
+class ThreadPool;
+
+/**
+ * @brief Returns the workers that render the dungeon view, nullptr when rendering on the main thread only
+ */
+ThreadPool *GetRenderThreadPool();
+
 /**
  * @brief Start rendering of screen, town variation
  * @param out Buffer to render to
@@ -59,6 +74,18 @@ void CalcViewportGeometry();
  */
 void DrawView(const CelOutputBuffer &out, int StartX, int StartY);
 
+/**
+ * @brief Scale up the top left part of the buffer 2x.
+ */
+void Zoom(const CelOutputBuffer &out);
+
+/**
+ * @brief Makes the next frame redraw the whole dungeon view when incremental redraw is enabled
+ *
+ * Needed for changes that are not tracked per cell, like modified light tables.
+ */
+void InvalidateViewportCache();
+
 void ClearScreenBuffer();
 #ifdef _DEBUG
 void ScrollView();
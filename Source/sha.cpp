@@ -7,6 +7,7 @@
 
 #include <SDL.h>
 #include <cstdint>
+#include <cstring>
 
 #include "appfat.h"
 
@@ -19,18 +20,30 @@ namespace {
 
 /**
  * Diablo-"SHA1" circular left shift, portable version.
+ *
+ * The bits shifted in on the right are copies of the sign bit. This is computed without
+ * branches or signed shifts, so that the compiler can keep the rounds in registers.
  */
-uint32_t SHA1CircularShift(uint32_t bits, uint32_t word)
+template <uint32_t Bits>
+uint32_t SHA1CircularShift(uint32_t word)
 {
-	assert(bits < 32);
-	assert(bits > 0);
+	static_assert(Bits > 0 && Bits < 32, "Invalid shift");
+
+	const uint32_t signFill = (0U - (word >> 31)) << Bits;
+	return (word << Bits) | (word >> (32 - Bits)) | signFill;
+}
 
-	if (word >> 31) {
-		//moving this part to a separate volatile variable fixes saves in x64-release build in visual studio 2017
-		volatile uint32_t tmp = ((~word) >> (32 - bits));
-		return (word << bits) | (~tmp);
+template <uint32_t K, typename F>
+void SHA1Rounds(const uint32_t *W, uint32_t &A, uint32_t &B, uint32_t &C, uint32_t &D, uint32_t &E, F f)
+{
+	for (int i = 0; i < 20; i++) {
+		const uint32_t temp = SHA1CircularShift<5>(A) + f(B, C, D) + E + W[i] + K;
+		E = D;
+		D = C;
+		C = SHA1CircularShift<30>(B);
+		B = A;
+		A = temp;
 	}
-	return (word << bits) | (word >> (32 - bits));
 }
 
 } // namespace
@@ -48,15 +61,15 @@ static void SHA1Init(SHA1Context *context)
 	context->state[4] = 0xC3D2E1F0;
 }
 
-static void SHA1ProcessMessageBlock(SHA1Context *context)
+static void SHA1ProcessMessageBlock(SHA1Context *context, const char *block)
 {
-	std::uint32_t i, temp;
+	std::uint32_t i;
 	std::uint32_t W[80];
 	std::uint32_t A, B, C, D, E;
 
-	auto *buf = (std::uint32_t *)context->buffer;
+	memcpy(W, block, 64);
 	for (i = 0; i < 16; i++)
-		W[i] = SDL_SwapLE32(buf[i]);
+		W[i] = SDL_SwapLE32(W[i]);
 
 	for (i = 16; i < 80; i++) {
 		W[i] = W[i - 16] ^ W[i - 14] ^ W[i - 8] ^ W[i - 3];
@@ -68,41 +81,10 @@ static void SHA1ProcessMessageBlock(SHA1Context *context)
 	D = context->state[3];
 	E = context->state[4];
 
-	for (i = 0; i < 20; i++) {
-		temp = SHA1CircularShift(5, A) + ((B & C) | ((~B) & D)) + E + W[i] + 0x5A827999;
-		E = D;
-		D = C;
-		C = SHA1CircularShift(30, B);
-		B = A;
-		A = temp;
-	}
-
-	for (i = 20; i < 40; i++) {
-		temp = SHA1CircularShift(5, A) + (B ^ C ^ D) + E + W[i] + 0x6ED9EBA1;
-		E = D;
-		D = C;
-		C = SHA1CircularShift(30, B);
-		B = A;
-		A = temp;
-	}
-
-	for (i = 40; i < 60; i++) {
-		temp = SHA1CircularShift(5, A) + ((B & C) | (B & D) | (C & D)) + E + W[i] + 0x8F1BBCDC;
-		E = D;
-		D = C;
-		C = SHA1CircularShift(30, B);
-		B = A;
-		A = temp;
-	}
-
-	for (i = 60; i < 80; i++) {
-		temp = SHA1CircularShift(5, A) + (B ^ C ^ D) + E + W[i] + 0xCA62C1D6;
-		E = D;
-		D = C;
-		C = SHA1CircularShift(30, B);
-		B = A;
-		A = temp;
-	}
+	SHA1Rounds<0x5A827999>(&W[0], A, B, C, D, E, [](uint32_t b, uint32_t c, uint32_t d) { return (b & c) | ((~b) & d); });
+	SHA1Rounds<0x6ED9EBA1>(&W[20], A, B, C, D, E, [](uint32_t b, uint32_t c, uint32_t d) { return b ^ c ^ d; });
+	SHA1Rounds<0x8F1BBCDC>(&W[40], A, B, C, D, E, [](uint32_t b, uint32_t c, uint32_t d) { return (b & c) | (b & d) | (c & d); });
+	SHA1Rounds<0xCA62C1D6>(&W[60], A, B, C, D, E, [](uint32_t b, uint32_t c, uint32_t d) { return b ^ c ^ d; });
 
 	context->state[0] += A;
 	context->state[1] += B;
@@ -123,8 +105,7 @@ static void SHA1Input(SHA1Context *context, const char *message_array, std::uint
 	context->count[1] += len >> 29;
 
 	for (i = len; i >= 64; i -= 64) {
-		memcpy(context->buffer, message_array, sizeof(context->buffer));
-		SHA1ProcessMessageBlock(context);
+		SHA1ProcessMessageBlock(context, message_array);
 		message_array += 64;
 	}
 }
@@ -5,10 +5,10 @@
  */
 #include "sound.h"
 
+#include <array>
+#include <atomic>
 #include <cstdint>
-#include <list>
 #include <memory>
-#include <mutex>
 
 #include <aulib.h>
 #include <Aulib/DecoderDrwav.h>
@@ -20,9 +20,11 @@
 #include "options.h"
 #include "storm/storm_sdl_rw.h"
 #include "storm/storm.h"
+#include "utils/file_prefetch.h"
 #include "utils/log.hpp"
 #include "utils/math.h"
-#include "utils/sdl_mutex.h"
+#include "utils/memory_stats.h"
+#include "utils/read_ahead_rw.h"
 #include "utils/stdcompat/optional.hpp"
 #include "utils/stdcompat/shared_ptr_array.hpp"
 #include "utils/stubs.h"
@@ -45,6 +47,10 @@ void LoadMusic(HANDLE handle)
 {
 #ifndef DISABLE_STREAMING_MUSIC
 	SDL_RWops *musicRw = SFileRw_FromStormHandle(handle);
+	// Keep the MPQ reads out of the audio callback
+	SDL_RWops *readAheadRw = ReadAheadRw_Create(musicRw);
+	if (readAheadRw != nullptr)
+		musicRw = readAheadRw;
 #else
 	int bytestoread = SFileGetFileSize(handle);
 	musicBuffer = new char[bytestoread];
@@ -69,27 +75,89 @@ void CleanupMusic()
 #endif
 }
 
-std::list<std::unique_ptr<SoundSample>> duplicateSounds;
-std::optional<SdlMutex> duplicateSoundsMutex;
+/**
+ * @brief A voice that plays a copy of a sound that is already playing.
+ *
+ * Voices are only taken on the game thread, the audio thread gives them back when they finish playing.
+ */
+struct DuplicateVoice {
+	SoundSample sample;
+	/** The sound the voice plays a copy of, only compared while the voice is playing */
+	const SoundSample *source;
+	/** The volume the voice was started with, the quietest voice is replaced when all are playing */
+	int volume;
+	/** Counts the sounds played by the voice so that a replaced sound finishing late does not free it */
+	std::atomic<uint32_t> generation { 0 };
+	std::atomic<bool> playing { false };
+};
 
-SoundSample *DuplicateSound(const SoundSample &sound)
+constexpr size_t MaxDuplicateSounds = 32;
+/** A crowd playing the same sound at once doesn't sound different with more copies, and would take all voices */
+constexpr int MaxDuplicatesPerSound = 4;
+std::array<DuplicateVoice, MaxDuplicateSounds> duplicateVoices;
+
+/**
+ * Combined volume below which a sound is too quiet to hear next to the rest of the game, about 1/256 of full volume.
+ * In the units of SoundSample::Play, where the user volume counts four times.
+ */
+constexpr int InaudibleVolume = ATTENUATION_MIN * 4 / 5;
+
+DuplicateVoice *AcquireDuplicateVoice(const SoundSample &sound, int volume)
 {
-	auto duplicate = std::make_unique<SoundSample>();
-	if (duplicate->DuplicateFrom(sound) != 0)
+	DuplicateVoice *freeVoice = nullptr;
+	DuplicateVoice *quietest = nullptr;
+	DuplicateVoice *quietestCopy = nullptr;
+	int copies = 0;
+	for (DuplicateVoice &voice : duplicateVoices) {
+		if (!voice.playing.load(std::memory_order_acquire)) {
+			if (freeVoice == nullptr)
+				freeVoice = &voice;
+			continue;
+		}
+		if (voice.source == &sound) {
+			copies++;
+			if (quietestCopy == nullptr || voice.volume < quietestCopy->volume)
+				quietestCopy = &voice;
+		}
+		if (quietest == nullptr || voice.volume < quietest->volume)
+			quietest = &voice;
+	}
+
+	DuplicateVoice *replaced;
+	if (copies >= MaxDuplicatesPerSound)
+		replaced = quietestCopy;
+	else if (freeVoice != nullptr)
+		return freeVoice;
+	else
+		replaced = quietest;
+
+	// Sounds further away are quieter, steal the voice of the furthest one if the new sound is closer
+	if (replaced->volume >= volume)
+		return nullptr;
+	replaced->sample.Stop();
+	return replaced;
+}
+
+SoundSample *DuplicateSound(const SoundSample &sound, int volume)
+{
+	DuplicateVoice *voice = AcquireDuplicateVoice(sound, volume);
+	if (voice == nullptr)
+		return nullptr;
+
+	const uint32_t generation = voice->generation.fetch_add(1, std::memory_order_acq_rel) + 1;
+	if (voice->sample.DuplicateFrom(sound) != 0) {
+		voice->sample.Release();
+		voice->playing.store(false, std::memory_order_release);
 		return nullptr;
-	auto *result = duplicate.get();
-	decltype(duplicateSounds.begin()) it;
-	{
-		const std::lock_guard<SdlMutex> lock(*duplicateSoundsMutex);
-		duplicateSounds.push_back(std::move(duplicate));
-		it = duplicateSounds.end();
-		--it;
 	}
-	result->SetFinishCallback([it]([[maybe_unused]] Aulib::Stream &stream) {
-		const std::lock_guard<SdlMutex> lock(*duplicateSoundsMutex);
-		duplicateSounds.erase(it);
+	voice->sample.SetFinishCallback([voice, generation]([[maybe_unused]] Aulib::Stream &stream) {
+		if (voice->generation.load(std::memory_order_acquire) == generation)
+			voice->playing.store(false, std::memory_order_release);
 	});
-	return result;
+	voice->source = &sound;
+	voice->volume = volume;
+	voice->playing.store(true, std::memory_order_release);
+	return &voice->sample;
 }
 
 } // namespace
@@ -130,8 +198,12 @@ static int CapVolume(int volume)
 
 void ClearDuplicateSounds()
 {
-	const std::lock_guard<SdlMutex> lock(*duplicateSoundsMutex);
-	duplicateSounds.clear();
+	for (DuplicateVoice &voice : duplicateVoices) {
+		voice.sample.Stop();
+		voice.sample.Release();
+		voice.generation.fetch_add(1, std::memory_order_acq_rel);
+		voice.playing.store(false, std::memory_order_release);
+	}
 }
 
 void snd_play_snd(TSnd *pSnd, int lVolume, int lPan)
@@ -147,9 +219,13 @@ void snd_play_snd(TSnd *pSnd, int lVolume, int lPan)
 		return;
 	}
 
+	if (lVolume + sgOptions.Audio.nSoundVolume * (ATTENUATION_MIN / VOLUME_MIN) < InaudibleVolume) {
+		return;
+	}
+
 	SoundSample *sound = &pSnd->DSB;
 	if (sound->IsPlaying()) {
-		sound = DuplicateSound(*sound);
+		sound = DuplicateSound(*sound, lVolume);
 		if (sound == nullptr)
 			return;
 	}
@@ -162,6 +238,7 @@ std::unique_ptr<TSnd> sound_file_load(const char *path, bool stream)
 {
 	int error = 0;
 
+	MemoryTagScope memoryTag(MemoryTag::Sound);
 	auto snd = std::make_unique<TSnd>();
 	snd->start_tc = SDL_GetTicks() - 80 - 1;
 
@@ -174,15 +251,23 @@ std::unique_ptr<TSnd> sound_file_load(const char *path, bool stream)
 		}
 #ifndef STREAM_ALL_AUDIO
 	} else {
-		HANDLE file;
-		if (!SFileOpenFile(path, &file)) {
-			ErrDlg("SFileOpenFile failed", path, __FILE__, __LINE__);
+		size_t prefetchedSize;
+		std::unique_ptr<byte[]> prefetched = TakePrefetchedFile(path, &prefetchedSize);
+		if (prefetched != nullptr) {
+			auto wave_file = MakeArraySharedPtr<std::uint8_t>(prefetchedSize);
+			memcpy(wave_file.get(), prefetched.get(), prefetchedSize);
+			error = snd->DSB.SetChunk(wave_file, prefetchedSize);
+		} else {
+			HANDLE file;
+			if (!SFileOpenFile(path, &file)) {
+				ErrDlg("SFileOpenFile failed", path, __FILE__, __LINE__);
+			}
+			DWORD dwBytes = SFileGetFileSize(file);
+			auto wave_file = MakeArraySharedPtr<std::uint8_t>(dwBytes);
+			SFileReadFileThreadSafe(file, wave_file.get(), dwBytes);
+			error = snd->DSB.SetChunk(wave_file, dwBytes);
+			SFileCloseFileThreadSafe(file);
 		}
-		DWORD dwBytes = SFileGetFileSize(file);
-		auto wave_file = MakeArraySharedPtr<std::uint8_t>(dwBytes);
-		SFileReadFileThreadSafe(file, wave_file.get(), dwBytes);
-		error = snd->DSB.SetChunk(wave_file, dwBytes);
-		SFileCloseFileThreadSafe(file);
 	}
 #endif
 	if (error != 0) {
@@ -219,15 +304,16 @@ void snd_init()
 	LogVerbose(LogCategory::Audio, "Aulib sampleRate={} channels={} frameSize={} format={:#x}",
 	    Aulib::sampleRate(), Aulib::channelCount(), Aulib::frameSize(), Aulib::sampleFormat());
 
-	duplicateSoundsMutex.emplace();
+	StartSoundMixerThread();
 	gbSndInited = true;
 }
 
 void snd_deinit()
 {
 	if (gbSndInited) {
+		ClearDuplicateSounds();
+		StopSoundMixerThread();
 		Aulib::quit();
-		duplicateSoundsMutex = std::nullopt;
 	}
 
 	gbSndInited = false;
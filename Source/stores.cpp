@@ -47,6 +47,12 @@ int stextsval;
 int stextdown;
 /** Previous scoll position */
 int stextup;
+/** Set when stext must be rebuilt from the stock before the next scrolled draw */
+bool stextscrldirty = true;
+/** Store, scroll position and selection the scrolled lines were last built for */
+talk_id stextscrlflag;
+int stextscrlval;
+int stextscrlsel;
 /** Count down for the push state of the scroll up button */
 char stextscrlubtn;
 /** Count down for the push state of the scroll down button */
@@ -2289,6 +2295,7 @@ void DrawSTextHelp()
 
 void ClearSText(int s, int e)
 {
+	stextscrldirty = true;
 	for (int i = s; i < e; i++) {
 		stext[i]._sx = 0;
 		stext[i]._syoff = 0;
@@ -2409,7 +2416,7 @@ void DrawSText(const CelOutputBuffer &out)
 	else
 		DrawQTextBack(out);
 
-	if (stextscrl) {
+	if (stextscrl && (stextscrldirty || stextscrlflag != stextflag || stextscrlval != stextsval || stextscrlsel != stextsel)) {
 		switch (stextflag) {
 		case STORE_SBUY:
 			S_ScrollSBuy(stextsval);
@@ -2433,6 +2440,10 @@ void DrawSText(const CelOutputBuffer &out)
 		default:
 			break;
 		}
+		stextscrldirty = false;
+		stextscrlflag = stextflag;
+		stextscrlval = stextsval;
+		stextscrlsel = stextsel;
 	}
 
 	for (i = 0; i < STORE_LINES; i++) {
@@ -1,9 +1,14 @@
 #include <SDL.h>
 #include <SDL_endian.h>
+#include <atomic>
 #include <cstddef>
 #include <cstdint>
+#include <cstdio>
+#include <cstring>
 #include <mutex>
 #include <string>
+#include <unordered_map>
+#include <unordered_set>
 
 #define SI_SUPPORT_IOSTREAMS
 #include <SimpleIni.h>
@@ -36,6 +41,7 @@ bool directFileAccess = false;
 std::string *SBasePath = nullptr;
 
 SdlMutex Mutex;
+std::atomic<bool> LockFreeReads { false };
 
 std::string getIniPath()
 {
@@ -43,31 +49,50 @@ std::string getIniPath()
 	return path;
 }
 
+/** Set when a value differs from what was loaded, so SaveIni can leave an unchanged file alone */
+bool IniChanged = false;
+
 CSimpleIni &getIni()
 {
-	static CSimpleIni ini;
-	static bool isIniLoaded = false;
-	if (!isIniLoaded) {
+	// Initialization of a function local static is thread safe, unlike a separate "loaded" flag
+	static CSimpleIni &ini = []() -> CSimpleIni & {
+		static CSimpleIni loaded;
 		auto path = getIniPath();
 		auto stream = CreateFileStream(path.c_str(), std::fstream::in | std::fstream::binary);
-		ini.SetSpaces(false);
+		loaded.SetSpaces(false);
 		if (stream != nullptr)
-			ini.LoadData(*stream);
-		isIniLoaded = true;
-	}
+			loaded.LoadData(*stream);
+		return loaded;
+	}();
 	return ini;
 }
 
+void SetIniString(const char *sectionName, const char *keyName, const char *value)
+{
+	auto &ini = getIni();
+	const char *oldValue = ini.GetValue(sectionName, keyName);
+	if (oldValue != nullptr && strcmp(oldValue, value) == 0)
+		return;
+	ini.SetValue(sectionName, keyName, value);
+	IniChanged = true;
+}
+
 } // namespace
 
 bool SFileReadFileThreadSafe(HANDLE hFile, void *buffer, DWORD nNumberOfBytesToRead, DWORD *read, int *lpDistanceToMoveHigh)
 {
+	if (LockFreeReads)
+		return SFileReadFile(hFile, buffer, nNumberOfBytesToRead, read, lpDistanceToMoveHigh);
+
 	const std::lock_guard<SdlMutex> lock(Mutex);
 	return SFileReadFile(hFile, buffer, nNumberOfBytesToRead, read, lpDistanceToMoveHigh);
 }
 
 bool SFileCloseFileThreadSafe(HANDLE hFile)
 {
+	if (LockFreeReads)
+		return SFileCloseFile(hFile);
+
 	const std::lock_guard<SdlMutex> lock(Mutex);
 	return SFileCloseFile(hFile);
 }
@@ -101,6 +126,79 @@ unsigned char AsciiToLowerTable_Path[256] = {
 	0xF0, 0xF1, 0xF2, 0xF3, 0xF4, 0xF5, 0xF6, 0xF7, 0xF8, 0xF9, 0xFA, 0xFB, 0xFC, 0xFD, 0xFE, 0xFF
 };
 
+namespace {
+
+/**
+ * @brief Remembers which archive a file was found in, nullptr for files that none of them have
+ *
+ * Filled in as files are opened rather than from the listfiles, as the original archives don't have any.
+ * There is one index per archive search order, indexed by gbIsHellfire.
+ */
+std::unordered_map<std::string, HANDLE> ArchiveIndex[2];
+/**
+ * @brief Paths that were looked up in the game folder with direct file access and don't exist there
+ *
+ * Loose files rarely override anything, so without this nearly every open would first fail to open a file on the disk.
+ */
+std::unordered_set<std::string> MissingLocalFiles;
+SdlMutex ArchiveIndexMutex;
+
+bool IsMissingLocalFile(const std::string &path)
+{
+	const std::lock_guard<SdlMutex> lock(ArchiveIndexMutex);
+	return MissingLocalFiles.count(path) != 0;
+}
+
+std::string GetArchiveIndexKey(const char *filename)
+{
+	std::string key = filename;
+	for (char &c : key) {
+		if (c == '/')
+			c = '\\';
+		else if (c >= 'A' && c <= 'Z')
+			c = c - 'A' + 'a';
+	}
+	return key;
+}
+
+bool OpenFromArchive(HANDLE archive, const char *filename, HANDLE *phFile)
+{
+	return archive != nullptr && SFileOpenFileEx(archive, filename, SFILE_OPEN_FROM_MPQ, phFile);
+}
+
+HANDLE OpenFromArchives(const char *filename, HANDLE *phFile)
+{
+	HANDLE archives[] = {
+		devilutionx_mpq,
+		gbIsHellfire ? hfopt2_mpq : nullptr,
+		gbIsHellfire ? hfopt1_mpq : nullptr,
+		gbIsHellfire ? hfvoice_mpq : nullptr,
+		gbIsHellfire ? hfmusic_mpq : nullptr,
+		gbIsHellfire ? hfbarb_mpq : nullptr,
+		gbIsHellfire ? hfbard_mpq : nullptr,
+		gbIsHellfire ? hfmonk_mpq : nullptr,
+		gbIsHellfire ? hellfire_mpq : nullptr,
+		patch_rt_mpq,
+		spawn_mpq,
+		diabdat_mpq,
+	};
+	for (HANDLE archive : archives) {
+		if (OpenFromArchive(archive, filename, phFile))
+			return archive;
+	}
+	return nullptr;
+}
+
+} // namespace
+
+void SFileClearArchiveIndex()
+{
+	const std::lock_guard<SdlMutex> lock(ArchiveIndexMutex);
+	for (auto &index : ArchiveIndex)
+		index.clear();
+	MissingLocalFiles.clear();
+}
+
 bool SFileOpenFile(const char *filename, HANDLE *phFile)
 {
 	bool result = false;
@@ -109,47 +207,31 @@ bool SFileOpenFile(const char *filename, HANDLE *phFile)
 		std::string path = *SBasePath + filename;
 		for (std::size_t i = SBasePath->size(); i < path.size(); ++i)
 			path[i] = AsciiToLowerTable_Path[static_cast<unsigned char>(path[i])];
-		result = SFileOpenFileEx((HANDLE) nullptr, path.c_str(), SFILE_OPEN_LOCAL_FILE, phFile);
+		if (!IsMissingLocalFile(path)) {
+			result = SFileOpenFileEx((HANDLE) nullptr, path.c_str(), SFILE_OPEN_LOCAL_FILE, phFile);
+			if (!result && SErrGetLastError() == STORM_ERROR_FILE_NOT_FOUND) {
+				const std::lock_guard<SdlMutex> lock(ArchiveIndexMutex);
+				MissingLocalFiles.insert(std::move(path));
+			}
+		}
 	}
 
-	if (!result && devilutionx_mpq != nullptr) {
-		result = SFileOpenFileEx((HANDLE)devilutionx_mpq, filename, SFILE_OPEN_FROM_MPQ, phFile);
-	}
-	if (gbIsHellfire) {
-		if (!result && hfopt2_mpq != nullptr) {
-			result = SFileOpenFileEx((HANDLE)hfopt2_mpq, filename, SFILE_OPEN_FROM_MPQ, phFile);
-		}
-		if (!result && hfopt1_mpq != nullptr) {
-			result = SFileOpenFileEx((HANDLE)hfopt1_mpq, filename, SFILE_OPEN_FROM_MPQ, phFile);
-		}
-		if (!result && hfvoice_mpq != nullptr) {
-			result = SFileOpenFileEx((HANDLE)hfvoice_mpq, filename, SFILE_OPEN_FROM_MPQ, phFile);
-		}
-		if (!result && hfmusic_mpq != nullptr) {
-			result = SFileOpenFileEx((HANDLE)hfmusic_mpq, filename, SFILE_OPEN_FROM_MPQ, phFile);
-		}
-		if (!result && hfbarb_mpq != nullptr) {
-			result = SFileOpenFileEx((HANDLE)hfbarb_mpq, filename, SFILE_OPEN_FROM_MPQ, phFile);
-		}
-		if (!result && hfbard_mpq != nullptr) {
-			result = SFileOpenFileEx((HANDLE)hfbard_mpq, filename, SFILE_OPEN_FROM_MPQ, phFile);
-		}
-		if (!result && hfmonk_mpq != nullptr) {
-			result = SFileOpenFileEx((HANDLE)hfmonk_mpq, filename, SFILE_OPEN_FROM_MPQ, phFile);
-		}
-		if (!result) {
-			result = SFileOpenFileEx((HANDLE)hellfire_mpq, filename, SFILE_OPEN_FROM_MPQ, phFile);
+	if (!result) {
+		std::string key = GetArchiveIndexKey(filename);
+		const std::lock_guard<SdlMutex> lock(ArchiveIndexMutex);
+		auto &index = ArchiveIndex[gbIsHellfire ? 1 : 0];
+		auto it = index.find(key);
+		if (it == index.end()) {
+			HANDLE archive = OpenFromArchives(filename, phFile);
+			result = archive != nullptr;
+			if (result || SErrGetLastError() == STORM_ERROR_FILE_NOT_FOUND)
+				index.emplace(std::move(key), archive);
+		} else if (it->second != nullptr) {
+			result = OpenFromArchive(it->second, filename, phFile);
+		} else {
+			SErrSetLastError(STORM_ERROR_FILE_NOT_FOUND);
 		}
 	}
-	if (!result && patch_rt_mpq != nullptr) {
-		result = SFileOpenFileEx((HANDLE)patch_rt_mpq, filename, SFILE_OPEN_FROM_MPQ, phFile);
-	}
-	if (!result && spawn_mpq != nullptr) {
-		result = SFileOpenFileEx((HANDLE)spawn_mpq, filename, SFILE_OPEN_FROM_MPQ, phFile);
-	}
-	if (!result && diabdat_mpq != nullptr) {
-		result = SFileOpenFileEx((HANDLE)diabdat_mpq, filename, SFILE_OPEN_FROM_MPQ, phFile);
-	}
 
 	if (!result || (*phFile == nullptr)) {
 		const auto error = SErrGetLastError();
@@ -187,13 +269,15 @@ bool getIniValue(const char *sectionName, const char *keyName, char *string, int
 
 void setIniValue(const char *sectionName, const char *keyName, const char *value, int len)
 {
-	auto &ini = getIni();
 	std::string stringValue(value, len ? len : strlen(value));
-	ini.SetValue(sectionName, keyName, stringValue.c_str());
+	SetIniString(sectionName, keyName, stringValue.c_str());
 }
 
 void SaveIni()
 {
+	if (!IniChanged)
+		return;
+	IniChanged = false;
 	auto iniPath = getIniPath();
 	auto stream = CreateFileStream(iniPath.c_str(), std::fstream::out | std::fstream::trunc | std::fstream::binary);
 	getIni().Save(*stream, true);
@@ -207,12 +291,18 @@ int getIniInt(const char *keyname, const char *valuename, int defaultValue)
 
 void setIniInt(const char *keyname, const char *valuename, int value)
 {
-	getIni().SetLongValue(keyname, valuename, value);
+	// Same format as CSimpleIni::SetLongValue
+	char buffer[32];
+	snprintf(buffer, sizeof(buffer), "%ld", static_cast<long>(value));
+	SetIniString(keyname, valuename, buffer);
 }
 
 void setIniFloat(const char *keyname, const char *valuename, float value)
 {
-	getIni().SetDoubleValue(keyname, valuename, value);
+	// Same format as CSimpleIni::SetDoubleValue
+	char buffer[64];
+	snprintf(buffer, sizeof(buffer), "%f", static_cast<double>(value));
+	SetIniString(keyname, valuename, buffer);
 }
 
 DWORD SErrGetLastError()
@@ -239,6 +329,11 @@ bool SFileEnableDirectAccess(bool enable)
 	return true;
 }
 
+void SFileEnableLockFreeReads(bool enable)
+{
+	LockFreeReads = enable;
+}
+
 #if defined(_WIN64) || defined(_WIN32)
 bool SFileOpenArchive(const char *szMpqName, DWORD dwPriority, DWORD dwFlags, HANDLE *phMpq)
 {
@@ -55,6 +55,27 @@ struct _SNETCAPS {
 	uint32_t defaultturnsintransit;
 };
 
+struct NetPeerStats {
+	bool connected;
+	/** @brief Turns received from the player that the game hasn't consumed yet */
+	uint32_t turnsQueued;
+	/** @brief Milliseconds since the last packet from the player */
+	uint32_t msSinceLastPacket;
+	/** @brief Moving average of the milliseconds between two turns from the player */
+	uint32_t turnIntervalMs;
+	/** @brief Moving average of how much the time between two turns deviates from turnIntervalMs */
+	uint32_t turnJitterMs;
+	uint64_t bytesReceived;
+};
+
+struct NetStats {
+	NetPeerStats peers[MAX_PLRS];
+	uint32_t turnsInTransit;
+	/** @brief Frames that have been handed to the network but not written yet */
+	uint32_t sendQueueDepth;
+	uint64_t bytesSent;
+};
+
 struct _SNETEVENT {
 	uint32_t eventid;
 	uint32_t playerid;
@@ -159,6 +180,12 @@ bool SNetGetGameInfo(game_info type, void *dst, unsigned int length);
 bool SNetGetTurnsInTransit(
     DWORD *turns);
 
+/**
+ * @brief Retrieves per player traffic statistics of the current game.
+ * @return false if the network provider doesn't keep any
+ */
+bool SNetGetNetStats(NetStats *stats);
+
 // Network provider structures
 typedef struct _client_info {
 	DWORD dwSize; // 60
@@ -185,7 +212,7 @@ typedef struct _user_info {
 	DWORD dwUnknown;
 } user_info;
 
-bool SNetJoinGame(char *gameName, char *gamePassword, int *playerid);
+bool SNetJoinGame(char *gameName, char *gamePassword, char *GameTemplateData, int GameTemplateSize, int *playerid);
 
 /*  SNetLeaveGame @ 119
  *
@@ -225,6 +252,7 @@ bool SNetSendMessage(int playerID, void *data, unsigned int databytes);
 #define SNPLAYER_OTHERS -2
 
 #define MPQ_OPEN_READ_ONLY 0x00000100
+#define BASE_PROVIDER_MAP 0x00000001
 #define SFILE_OPEN_FROM_MPQ 0
 #define SFILE_OPEN_LOCAL_FILE 0xFFFFFFFF
 
@@ -243,6 +271,9 @@ bool SNetSendTurn(char *data, unsigned int databytes);
 
 bool SFileOpenFile(const char *filename, HANDLE *phFile);
 
+/** @brief Forget which archives files were found in and which loose files are missing, must be called whenever archives are opened or closed */
+void SFileClearArchiveIndex();
+
 // Functions implemented in StormLib
 #if defined(_WIN64) || defined(_WIN32)
 bool WINAPI SFileOpenArchive(const wchar_t *szMpqName, DWORD dwPriority, DWORD dwFlags, HANDLE *phMpq);
@@ -320,6 +351,13 @@ bool SNetInitializeProvider(uint32_t provider, struct GameData *gameData);
 int SNetGetProviderCaps(struct _SNETCAPS *);
 bool SFileEnableDirectAccess(bool enable);
 
+/**
+ * @brief Stop serializing reads through SFileReadFileThreadSafe
+ *
+ * Only safe while every open archive is memory mapped, as reads from a mapped archive don't share a file position.
+ */
+void SFileEnableLockFreeReads(bool enable);
+
 #if defined(__GNUC__) || defined(__cplusplus)
 }
 
@@ -173,11 +173,20 @@ bool SNetCreateGame(const char *pszGameName, const char *pszGamePassword, char *
 	return *playerID != -1;
 }
 
-bool SNetJoinGame(char *pszGameName, char *pszGamePassword, int *playerID)
+/**
+ * @brief Called by ui for multi
+ * @param gameTemplateData The game data to offer, used only if nobody is in the game yet, e.g. on a relay server
+ */
+bool SNetJoinGame(char *pszGameName, char *pszGamePassword, char *gameTemplateData, int gameTemplateSize, int *playerID)
 {
 #ifndef NONET
 	std::lock_guard<SdlMutex> lg(storm_net_mutex);
 #endif
+	if (gameTemplateSize != sizeof(GameData))
+		ABORT();
+	net::buffer_t gameInitInfo(gameTemplateData, gameTemplateData + gameTemplateSize);
+	dvlnet_inst->setup_gameinfo(std::move(gameInitInfo));
+
 	if (pszGameName != nullptr)
 		strncpy(gpszGameName, pszGameName, sizeof(gpszGameName) - 1);
 	if (pszGamePassword != nullptr)
@@ -205,6 +214,14 @@ bool SNetGetTurnsInTransit(DWORD *turns)
 	return dvlnet_inst->SNetGetTurnsInTransit(turns);
 }
 
+bool SNetGetNetStats(NetStats *stats)
+{
+#ifndef NONET
+	std::lock_guard<SdlMutex> lg(storm_net_mutex);
+#endif
+	return dvlnet_inst != nullptr && dvlnet_inst->SNetGetNetStats(stats);
+}
+
 /**
  * @brief engine calls this only once with argument 1
  */
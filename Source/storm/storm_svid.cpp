@@ -3,6 +3,9 @@
 #include <cstddef>
 #include <cstdint>
 #include <cstring>
+#include <deque>
+#include <memory>
+#include <vector>
 
 #include <SDL.h>
 #include <smacker.h>
@@ -23,6 +26,7 @@
 #include "utils/log.hpp"
 #include "utils/sdl_compat.h"
 #include "utils/stdcompat/optional.hpp"
+#include "utils/thread.h"
 
 namespace devilution {
 namespace {
@@ -46,6 +50,32 @@ SDL_Surface *SVidSurface;
 std::unique_ptr<uint8_t[]> SVidBuffer;
 #endif
 
+/**
+ * @brief A frame decoded ahead by the decode thread, the buffers are reused for later frames.
+ */
+struct SVidFrame {
+	std::vector<uint8_t> pixels;
+	bool paletteUpdated;
+	uint8_t palette[256 * 3];
+	std::vector<uint8_t> audio;
+};
+
+/** Number of frames the decode thread may get ahead of playback */
+constexpr std::size_t SVidQueueLength = 4;
+
+SDL_mutex *SVidQueueMutex;
+/** Signaled when a frame was decoded or decoding is done */
+SDL_cond *SVidFrameDecoded;
+/** Signaled when a frame was shown (or skipped) and its buffers are free again */
+SDL_cond *SVidFrameShown;
+SDL_Thread *SVidDecodeThread;
+SDL_threadID SVidDecodeThreadId;
+std::deque<std::unique_ptr<SVidFrame>> SVidDecodedFrames;
+std::vector<std::unique_ptr<SVidFrame>> SVidFreeFrames;
+bool SVidDecodeDone;
+bool SVidDecodeQuit;
+bool SVidAudioEnabled;
+
 bool IsLandscapeFit(unsigned long srcW, unsigned long srcH, unsigned long dstW, unsigned long dstH)
 {
 	return srcW * dstH > dstW * srcH;
@@ -117,21 +147,128 @@ bool HaveAudio()
 }
 #endif
 
-bool SVidLoadNextFrame()
+/**
+ * @brief Copy the frame libsmacker just decoded.
+ */
+void CopyDecodedFrame(SVidFrame &frame)
 {
-	SVidFrameEnd += SVidFrameLength;
+	const uint8_t *pixels = smk_get_video(SVidSMK);
+	if (pixels != nullptr)
+		frame.pixels.assign(pixels, pixels + SVidWidth * SVidHeight);
+
+	frame.paletteUpdated = smk_palette_updated(SVidSMK) != 0;
+	if (frame.paletteUpdated)
+		memcpy(frame.palette, smk_get_palette(SVidSMK), sizeof(frame.palette));
+
+	frame.audio.clear();
+	if (SVidAudioEnabled) {
+		const uint8_t *audio = smk_get_audio(SVidSMK, 0);
+		frame.audio.assign(audio, audio + smk_get_audio_size(SVidSMK, 0));
+	}
+}
 
-	if (smk_next(SVidSMK) == SMK_DONE) {
-		if (!SVidLoop) {
-			return false;
+/**
+ * @brief Decodes frames ahead of playback until the queue is full, the video ends or SVidPlayEnd stops it.
+ */
+unsigned int SVidDecodeHandler(void * /*data*/)
+{
+	SDL_LockMutex(SVidQueueMutex);
+	while (!SVidDecodeQuit) {
+		if (SVidDecodedFrames.size() >= SVidQueueLength) {
+			SDL_CondWait(SVidFrameShown, SVidQueueMutex);
+			continue;
+		}
+
+		std::unique_ptr<SVidFrame> frame;
+		if (!SVidFreeFrames.empty()) {
+			frame = std::move(SVidFreeFrames.back());
+			SVidFreeFrames.pop_back();
+		}
+		SDL_UnlockMutex(SVidQueueMutex);
+
+		if (frame == nullptr)
+			frame = std::make_unique<SVidFrame>();
+		// The first frame was decoded by SVidPlayBegin, every later one by smk_next
+		CopyDecodedFrame(*frame);
+		bool more = true;
+		if (smk_next(SVidSMK) == SMK_DONE) {
+			if (SVidLoop)
+				smk_first(SVidSMK);
+			else
+				more = false;
 		}
 
-		smk_first(SVidSMK);
+		SDL_LockMutex(SVidQueueMutex);
+		SVidDecodedFrames.push_back(std::move(frame));
+		if (!more)
+			SVidDecodeDone = true;
+		SDL_CondSignal(SVidFrameDecoded);
+		if (!more)
+			break;
 	}
+	SDL_UnlockMutex(SVidQueueMutex);
+
+	return 0;
+}
+
+/**
+ * @brief Wait for the next decoded frame.
+ * @return nullptr once every frame was shown
+ */
+std::unique_ptr<SVidFrame> SVidTakeFrame()
+{
+	std::unique_ptr<SVidFrame> frame;
+	SDL_LockMutex(SVidQueueMutex);
+	while (SVidDecodedFrames.empty() && !SVidDecodeDone)
+		SDL_CondWait(SVidFrameDecoded, SVidQueueMutex);
+	if (!SVidDecodedFrames.empty()) {
+		frame = std::move(SVidDecodedFrames.front());
+		SVidDecodedFrames.pop_front();
+	}
+	SDL_UnlockMutex(SVidQueueMutex);
+	return frame;
+}
+
+void SVidReleaseFrame(std::unique_ptr<SVidFrame> frame)
+{
+	SDL_LockMutex(SVidQueueMutex);
+	SVidFreeFrames.push_back(std::move(frame));
+	SDL_CondSignal(SVidFrameShown);
+	SDL_UnlockMutex(SVidQueueMutex);
+}
 
+/**
+ * @brief Let go of a frame and move on to the next one.
+ */
+bool SVidLoadNextFrame(std::unique_ptr<SVidFrame> frame)
+{
+	SVidFrameEnd += SVidFrameLength;
+	SVidReleaseFrame(std::move(frame));
 	return true;
 }
 
+void SVidStopDecoding()
+{
+	if (SVidDecodeThread == nullptr)
+		return;
+
+	SDL_LockMutex(SVidQueueMutex);
+	SVidDecodeQuit = true;
+	SDL_CondSignal(SVidFrameShown);
+	SDL_UnlockMutex(SVidQueueMutex);
+	SDL_WaitThread(SVidDecodeThread, nullptr);
+	SVidDecodeThread = nullptr;
+
+	SVidDecodedFrames.clear();
+	SVidFreeFrames.clear();
+	SDL_DestroyCond(SVidFrameShown);
+	SDL_DestroyCond(SVidFrameDecoded);
+	SDL_DestroyMutex(SVidQueueMutex);
+	SVidFrameShown = nullptr;
+	SVidFrameDecoded = nullptr;
+	SVidQueueMutex = nullptr;
+}
+
 } // namespace
 
 bool SVidPlayBegin(const char *filename, int flags, HANDLE *video)
@@ -166,6 +303,7 @@ bool SVidPlayBegin(const char *filename, int flags, HANDLE *video)
 		return false;
 	}
 
+	SVidAudioEnabled = false;
 #ifndef NOSOUND
 	const bool enableAudio = (flags & 0x1000000) == 0;
 
@@ -197,6 +335,7 @@ bool SVidPlayBegin(const char *filename, int flags, HANDLE *video)
 			SVidAudioStream = std::nullopt;
 			SVidAudioDecoder = nullptr;
 		}
+		SVidAudioEnabled = SVidAudioDecoder != nullptr;
 	}
 #endif
 
@@ -224,13 +363,12 @@ bool SVidPlayBegin(const char *filename, int flags, HANDLE *video)
 #endif
 	std::memcpy(SVidPreviousPalette, orig_palette, sizeof(SVidPreviousPalette));
 
-	// Copy frame to buffer
-	SVidSurface = SDL_CreateRGBSurfaceWithFormatFrom(
-	    (unsigned char *)smk_get_video(SVidSMK),
+	// Frames are copied here from the decode queue
+	SVidSurface = SDL_CreateRGBSurfaceWithFormat(
+	    0,
 	    SVidWidth,
 	    SVidHeight,
 	    8,
-	    SVidWidth,
 	    SDL_PIXELFORMAT_INDEX8);
 	if (SVidSurface == nullptr) {
 		ErrSdl();
@@ -244,6 +382,16 @@ bool SVidPlayBegin(const char *filename, int flags, HANDLE *video)
 		ErrSdl();
 	}
 
+	SVidDecodeDone = false;
+	SVidDecodeQuit = false;
+	SVidQueueMutex = SDL_CreateMutex();
+	SVidFrameDecoded = SDL_CreateCond();
+	SVidFrameShown = SDL_CreateCond();
+	if (SVidQueueMutex == nullptr || SVidFrameDecoded == nullptr || SVidFrameShown == nullptr) {
+		ErrSdl();
+	}
+	SVidDecodeThread = CreateThread(SVidDecodeHandler, &SVidDecodeThreadId);
+
 	SVidFrameEnd = SDL_GetTicks() * 1000 + SVidFrameLength;
 	SDL_FillRect(GetOutputSurface(), nullptr, 0x000000);
 	return true;
@@ -251,9 +399,13 @@ bool SVidPlayBegin(const char *filename, int flags, HANDLE *video)
 
 bool SVidPlayContinue()
 {
-	if (smk_palette_updated(SVidSMK)) {
+	std::unique_ptr<SVidFrame> frame = SVidTakeFrame();
+	if (frame == nullptr)
+		return false;
+
+	if (frame->paletteUpdated) {
 		SDL_Color colors[256];
-		const unsigned char *paletteData = smk_get_palette(SVidSMK);
+		const unsigned char *paletteData = frame->palette;
 
 		for (int i = 0; i < 256; i++) {
 			colors[i].r = paletteData[i * 3 + 0];
@@ -276,13 +428,13 @@ bool SVidPlayContinue()
 	}
 
 	if (SDL_GetTicks() * 1000 >= SVidFrameEnd) {
-		return SVidLoadNextFrame(); // Skip video and audio if the system is to slow
+		return SVidLoadNextFrame(std::move(frame)); // Skip video and audio if the system is to slow
 	}
 
 #ifndef NOSOUND
 	if (HaveAudio()) {
-		const auto len = smk_get_audio_size(SVidSMK, 0);
-		const unsigned char *buf = smk_get_audio(SVidSMK, 0);
+		const auto len = frame->audio.size();
+		const unsigned char *buf = frame->audio.data();
 		if (SVidAudioDepth == 16) {
 			SVidAudioDecoder->PushSamples(reinterpret_cast<const std::int16_t *>(buf), len / 2);
 		} else {
@@ -292,7 +444,13 @@ bool SVidPlayContinue()
 #endif
 
 	if (SDL_GetTicks() * 1000 >= SVidFrameEnd) {
-		return SVidLoadNextFrame(); // Skip video if the system is to slow
+		return SVidLoadNextFrame(std::move(frame)); // Skip video if the system is to slow
+	}
+
+	if (!frame->pixels.empty()) {
+		auto *dst = static_cast<uint8_t *>(SVidSurface->pixels);
+		for (unsigned long y = 0; y < SVidHeight; y++)
+			memcpy(dst + y * SVidSurface->pitch, &frame->pixels[y * SVidWidth], SVidWidth);
 	}
 
 #ifndef USE_SDL1
@@ -354,11 +512,14 @@ bool SVidPlayContinue()
 		SDL_Delay((SVidFrameEnd - now) / 1000); // wait with next frame if the system is too fast
 	}
 
-	return SVidLoadNextFrame();
+	return SVidLoadNextFrame(std::move(frame));
 }
 
 void SVidPlayEnd(HANDLE video)
 {
+	// The decode thread uses the smk handle, so it has to stop first
+	SVidStopDecoding();
+
 #ifndef NOSOUND
 	if (HaveAudio()) {
 		SVidAudioStream = std::nullopt;
@@ -387,6 +548,7 @@ void SVidPlayEnd(HANDLE video)
 		if (texture == nullptr) {
 			ErrSdl();
 		}
+		InvalidateScreenTexture();
 		if (renderer && SDL_RenderSetLogicalSize(renderer, gnScreenWidth, gnScreenHeight) <= -1) {
 			ErrSdl();
 		}
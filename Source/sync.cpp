@@ -3,7 +3,10 @@
  *
  * Implementation of functionality for syncing game state with other players.
  */
+#include <algorithm>
 #include <climits>
+#include <utility>
+#include <vector>
 
 #include "gendung.h"
 #include "monster.h"
@@ -14,8 +17,18 @@ namespace devilution {
 namespace {
 
 uint16_t sgnMonsterPriority[MAXMONSTERS];
-int sgnMonsters;
 uint16_t sgwLRU[MAXMONSTERS];
+
+/** What the other players were last told about a monster */
+struct SyncedMonsterState {
+	Point position;
+	int hitPoints;
+};
+SyncedMonsterState sgLastSynced[MAXMONSTERS];
+
+/** Sync records the monsters competing for the current packet, with their score */
+std::vector<std::pair<uint32_t, int>> sgSyncCandidates;
+
 int sgnSyncItem;
 int sgnSyncPInv;
 
@@ -42,58 +55,35 @@ static void sync_monster_pos(TSyncMonster *p, int ndx)
 
 	sgnMonsterPriority[ndx] = 0xFFFF;
 	sgwLRU[ndx] = monster[ndx]._msquelch == 0 ? 0xFFFF : 0xFFFE;
+	sgLastSynced[ndx] = { monster[ndx].position.tile, monster[ndx]._mhitpoints };
 }
 
-static bool sync_monster_active(TSyncMonster *p)
+/**
+ * @brief Number of packets since the monster was last sent, for monsters that are eligible
+ */
+static uint32_t GetSyncAge(int m)
 {
-	int i, m, ndx;
-	uint32_t lru;
-
-	ndx = -1;
-	lru = 0xFFFFFFFF;
-
-	for (i = 0; i < nummonsters; i++) {
-		m = monstactive[i];
-		if (sgnMonsterPriority[m] < lru && sgwLRU[m] < 0xFFFE) {
-			lru = sgnMonsterPriority[m];
-			ndx = monstactive[i];
-		}
-	}
-
-	if (ndx == -1) {
-		return false;
-	}
-
-	sync_monster_pos(p, ndx);
-	return true;
+	return 0xFFFE - sgwLRU[m];
 }
 
-static bool sync_monster_active2(TSyncMonster *p)
+/**
+ * @brief How urgently a monster needs to be sent, lower goes first
+ *
+ * The player closest to a monster is the one whose sync records are applied, so close monsters come
+ * first. Monsters that moved or were hit since they were last sent are worth more, and every packet
+ * a monster waits brings it forward.
+ */
+static uint32_t GetSyncScore(int m)
 {
-	int i, m, ndx;
-	uint32_t lru;
-
-	ndx = -1;
-	lru = 0xFFFE;
-
-	for (i = 0; i < nummonsters; i++) {
-		if (sgnMonsters >= nummonsters) {
-			sgnMonsters = 0;
-		}
-		m = monstactive[sgnMonsters];
-		if (sgwLRU[m] < lru) {
-			lru = sgwLRU[m];
-			ndx = monstactive[sgnMonsters];
-		}
-		sgnMonsters++;
-	}
-
-	if (ndx == -1) {
-		return false;
-	}
-
-	sync_monster_pos(p, ndx);
-	return true;
+	constexpr uint32_t UnchangedPenalty = 64;
+	constexpr uint32_t MaxAgeBonus = 255;
+
+	uint32_t score = sgnMonsterPriority[m] * 8U;
+	const MonsterStruct &mon = monster[m];
+	if (mon.position.tile == sgLastSynced[m].position && mon._mhitpoints == sgLastSynced[m].hitPoints)
+		score += UnchangedPenalty;
+	const uint32_t ageBonus = std::min(GetSyncAge(m), MaxAgeBonus);
+	return score > ageBonus ? score - ageBonus : 0;
 }
 
 static void SyncPlrInv(TSyncHeader *pHdr)
@@ -159,8 +149,6 @@ static void SyncPlrInv(TSyncHeader *pHdr)
 uint32_t sync_all_monsters(const byte *pbBuf, uint32_t dwMaxLen)
 {
 	TSyncHeader *pHdr;
-	int i;
-	bool sync;
 
 	if (nummonsters < 1) {
 		return dwMaxLen;
@@ -180,17 +168,27 @@ uint32_t sync_all_monsters(const byte *pbBuf, uint32_t dwMaxLen)
 	assert(dwMaxLen <= 0xffff);
 	sync_one_monster();
 
-	for (i = 0; i < nummonsters && dwMaxLen >= sizeof(TSyncMonster); i++) {
-		sync = false;
-		if (i < 2) {
-			sync = sync_monster_active2((TSyncMonster *)pbBuf);
-		}
-		if (!sync) {
-			sync = sync_monster_active((TSyncMonster *)pbBuf);
-		}
-		if (!sync) {
-			break;
-		}
+	// Score every monster once and keep the best ones that fit, instead of scanning all monsters per record
+	sgSyncCandidates.clear();
+	for (int i = 0; i < nummonsters; i++) {
+		const int m = monstactive[i];
+		if (sgwLRU[m] < 0xFFFE)
+			sgSyncCandidates.emplace_back(GetSyncScore(m), m);
+	}
+
+	const auto first = sgSyncCandidates.begin();
+	const size_t slots = std::min<size_t>(dwMaxLen / sizeof(TSyncMonster), sgSyncCandidates.size());
+	// The monsters that waited longest always get the first records, so far away ones are still sent now and then
+	const size_t stalest = std::min<size_t>(2, slots);
+	std::partial_sort(first, first + stalest, sgSyncCandidates.end(), [](const std::pair<uint32_t, int> &a, const std::pair<uint32_t, int> &b) {
+		return sgwLRU[a.second] < sgwLRU[b.second];
+	});
+	if (slots < sgSyncCandidates.size())
+		std::nth_element(first + stalest, first + slots, sgSyncCandidates.end());
+	std::sort(first + stalest, first + slots);
+
+	for (size_t i = 0; i < slots; i++) {
+		sync_monster_pos((TSyncMonster *)pbBuf, sgSyncCandidates[i].second);
 		pbBuf += sizeof(TSyncMonster);
 		pHdr->wLen += sizeof(TSyncMonster);
 		dwMaxLen -= sizeof(TSyncMonster);
@@ -280,8 +278,19 @@ uint32_t sync_update(int pnum, const byte *pbBuf)
 
 void sync_init()
 {
-	sgnMonsters = 16 * myplr;
 	memset(sgwLRU, 255, sizeof(sgwLRU));
+	std::fill(std::begin(sgLastSynced), std::end(sgLastSynced), SyncedMonsterState { { -1, -1 }, -1 });
+}
+
+uint32_t GetMonsterSyncStaleness()
+{
+	uint32_t staleness = 0;
+	for (int i = 0; i < nummonsters; i++) {
+		const int m = monstactive[i];
+		if (monster[m]._msquelch != 0 && sgwLRU[m] < 0xFFFE)
+			staleness = std::max(staleness, GetSyncAge(m));
+	}
+	return staleness;
 }
 
 } // namespace devilution
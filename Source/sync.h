@@ -15,4 +15,9 @@ uint32_t sync_all_monsters(const byte *pbBuf, uint32_t dwMaxLen);
 uint32_t sync_update(int pnum, const byte *pbBuf);
 void sync_init();
 
+/**
+ * @brief Most sync packets any active monster has gone without being sent
+ */
+uint32_t GetMonsterSyncStaleness();
+
 } // namespace devilution
@@ -5,64 +5,62 @@
  */
 #include "tmsg.h"
 
+#include <algorithm>
+#include <vector>
+
 #include "diablo.h"
 
 namespace devilution {
 
 namespace {
 
-TMsg *sgpTimedMsgHead;
+/** Messages waiting for their time, in order, as a ring buffer that only grows */
+std::vector<TMsg> sgTimedMsgs;
+size_t sgnTimedMsgHead;
+size_t sgnTimedMsgCount;
 
 } // namespace
 
 int tmsg_get(byte *pbMsg)
 {
-	int len;
-	TMsg *head;
-
-	if (sgpTimedMsgHead == nullptr)
+	if (sgnTimedMsgCount == 0)
 		return 0;
 
-	if ((int)(sgpTimedMsgHead->hdr.dwTime - SDL_GetTicks()) >= 0)
+	const TMsg &head = sgTimedMsgs[sgnTimedMsgHead];
+	if ((int)(head.hdr.dwTime - SDL_GetTicks()) >= 0)
 		return 0;
-	head = sgpTimedMsgHead;
-	sgpTimedMsgHead = head->hdr.pNext;
-	len = head->hdr.bLen;
+	int len = head.hdr.bLen;
 	// BUGFIX: ignores dwMaxLen
-	memcpy(pbMsg, head->body, len);
-	std::free(head);
+	memcpy(pbMsg, head.body, len);
+	sgnTimedMsgHead = (sgnTimedMsgHead + 1) % sgTimedMsgs.size();
+	sgnTimedMsgCount--;
 	return len;
 }
 
 void tmsg_add(byte *pbMsg, uint8_t bLen)
 {
-	TMsg **tail;
-
-	TMsg *msg = static_cast<TMsg *>(std::malloc(bLen + sizeof(*msg)));
-	msg->hdr.pNext = nullptr;
-	msg->hdr.dwTime = SDL_GetTicks() + gnTickDelay * 10;
-	msg->hdr.bLen = bLen;
-	memcpy(msg->body, pbMsg, bLen);
-	for (tail = &sgpTimedMsgHead; *tail != nullptr; tail = &(*tail)->hdr.pNext) {
-		;
+	if (sgnTimedMsgCount == sgTimedMsgs.size()) {
+		std::rotate(sgTimedMsgs.begin(), sgTimedMsgs.begin() + sgnTimedMsgHead, sgTimedMsgs.end());
+		sgTimedMsgs.resize(std::max<size_t>(sgTimedMsgs.size() * 2, 16));
+		sgnTimedMsgHead = 0;
 	}
-	*tail = msg;
+
+	TMsg &msg = sgTimedMsgs[(sgnTimedMsgHead + sgnTimedMsgCount) % sgTimedMsgs.size()];
+	msg.hdr.dwTime = SDL_GetTicks() + gnTickDelay * 10;
+	msg.hdr.bLen = bLen;
+	memcpy(msg.body, pbMsg, bLen);
+	sgnTimedMsgCount++;
 }
 
 void tmsg_start()
 {
-	assert(!sgpTimedMsgHead);
+	assert(sgnTimedMsgCount == 0);
 }
 
 void tmsg_cleanup()
 {
-	TMsg *next;
-
-	while (sgpTimedMsgHead != nullptr) {
-		next = sgpTimedMsgHead->hdr.pNext;
-		std::free(sgpTimedMsgHead);
-		sgpTimedMsgHead = next;
-	}
+	sgnTimedMsgHead = 0;
+	sgnTimedMsgCount = 0;
 }
 
 } // namespace devilution
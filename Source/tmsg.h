@@ -11,20 +11,15 @@
 
 namespace devilution {
 
-#pragma pack(push, 1)
 struct TMsgHdr {
-	struct TMsg *pNext;
 	int32_t dwTime;
 	uint8_t bLen;
 };
 
 struct TMsg {
 	TMsgHdr hdr;
-	// this is actually alignment padding, but the message body is appended to the struct
-	// so it's convenient to use byte-alignment and name it "body"
-	byte body[3];
+	byte body[UINT8_MAX];
 };
-#pragma pack(pop)
 
 int tmsg_get(byte *pbMsg);
 void tmsg_add(byte *pbMsg, uint8_t bLen);
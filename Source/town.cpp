@@ -5,6 +5,8 @@
  */
 #include "town.h"
 
+#include <memory>
+
 #include "drlg_l1.h"
 #include "init.h"
 #include "player.h"
@@ -15,6 +17,16 @@ namespace devilution {
 
 namespace {
 
+/**
+ * @brief dPiece of the town as built from the sector files, before the changes that depend on the progress of the game
+ */
+struct TownSectors {
+	bool isHellfire;
+	int dPiece[MAXDUNX][MAXDUNY];
+};
+
+std::unique_ptr<TownSectors> BuiltTownSectors;
+
 /**
  * @brief Load level data into dPiece
  * @param path Path of dun file
@@ -151,21 +163,23 @@ void TownCloseGrave()
  */
 void T_Pass3()
 {
-	int xx, yy, x;
+	int x;
 
-	for (yy = 0; yy < MAXDUNY; yy += 2) {
-		for (xx = 0; xx < MAXDUNX; xx += 2) {
-			dPiece[xx][yy] = 0;
-			dPiece[xx + 1][yy] = 0;
-			dPiece[xx][yy + 1] = 0;
-			dPiece[xx + 1][yy + 1] = 0;
-		}
-	}
+	if (BuiltTownSectors != nullptr && BuiltTownSectors->isHellfire == gbIsHellfire) {
+		memcpy(dPiece, BuiltTownSectors->dPiece, sizeof(dPiece));
+	} else {
+		memset(dPiece, 0, sizeof(dPiece));
 
-	T_FillSector("Levels\\TownData\\Sector1s.DUN", 46, 46);
-	T_FillSector("Levels\\TownData\\Sector2s.DUN", 46, 0);
-	T_FillSector("Levels\\TownData\\Sector3s.DUN", 0, 46);
-	T_FillSector("Levels\\TownData\\Sector4s.DUN", 0, 0);
+		T_FillSector("Levels\\TownData\\Sector1s.DUN", 46, 46);
+		T_FillSector("Levels\\TownData\\Sector2s.DUN", 46, 0);
+		T_FillSector("Levels\\TownData\\Sector3s.DUN", 0, 46);
+		T_FillSector("Levels\\TownData\\Sector4s.DUN", 0, 0);
+
+		// The sectors are the same in every game that uses the same tiles
+		BuiltTownSectors = std::make_unique<TownSectors>();
+		BuiltTownSectors->isHellfire = gbIsHellfire;
+		memcpy(BuiltTownSectors->dPiece, dPiece, sizeof(dPiece));
+	}
 
 	if (gbIsSpawn || !gbIsMultiplayer) {
 		if (gbIsSpawn || (!(plr[myplr].pTownWarps & 1) && (!gbIsHellfire || plr[myplr]._pLevel < 10))) {
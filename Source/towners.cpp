@@ -1,5 +1,8 @@
 #include "towners.h"
 
+#include <string>
+#include <vector>
+
 #include "cursor.h"
 #include "inv.h"
 #include "minitext.h"
@@ -9,7 +12,15 @@
 namespace devilution {
 namespace {
 
-std::unique_ptr<byte[]> CowCels;
+struct TownerCel {
+	std::string path;
+	std::unique_ptr<byte[]> data;
+};
+
+/** Graphics of the towners, they are kept until the end of the game so returning to town doesn't load them again */
+std::vector<TownerCel> TownerCels;
+
+byte *CowCels;
 int CowMsg;
 int CowClicks;
 
@@ -31,6 +42,16 @@ struct TownerInit {
 	void (*talk)(PlayerStruct &player, TownerStruct &towner);
 };
 
+byte *LoadTownerCel(const char *path)
+{
+	for (const auto &cel : TownerCels) {
+		if (cel.path == path)
+			return cel.data.get();
+	}
+	TownerCels.push_back({ path, LoadFileInMem(path) });
+	return TownerCels.back().data.get();
+}
+
 void NewTownerAnim(TownerStruct &towner, byte *pAnim, uint8_t numFrames, int delay)
 {
 	towner._tAnimData = pAnim;
@@ -65,9 +86,9 @@ void InitQstSnds(TownerStruct &towner, _talker_id type)
 
 void LoadTownerAnimations(TownerStruct &towner, const char *path, int frames, Direction dir, int delay)
 {
-	towner._tNData = LoadFileInMem(path);
+	towner._tNData = LoadTownerCel(path);
 	for (auto &animation : towner._tNAnim) {
-		animation = towner._tNData.get();
+		animation = towner._tNData;
 	}
 	NewTownerAnim(towner, towner._tNAnim[dir], frames, delay);
 }
@@ -236,7 +257,7 @@ void InitCows(TownerStruct &towner, const TownerInit &initData)
 	towner.animOrder = nullptr;
 	towner.animOrderSize = 0;
 	for (int i = 0; i < 8; i++) {
-		towner._tNAnim[i] = CelGetFrameStart(CowCels.get(), i);
+		towner._tNAnim[i] = CelGetFrameStart(CowCels, i);
 	}
 	NewTownerAnim(towner, towner._tNAnim[initData.dir], 12, 3);
 	towner._tAnimFrame = GenerateRnd(11) + 1;
@@ -811,7 +832,7 @@ void InitTowners()
 {
 	assert(CowCels == nullptr);
 
-	CowCels = LoadFileInMem("Towners\\Animals\\Cow.CEL");
+	CowCels = LoadTownerCel("Towners\\Animals\\Cow.CEL");
 
 	int i = 0;
 	for (const auto &townerInit : TownerInitList) {
@@ -850,6 +871,11 @@ void FreeTownerGFX()
 	CowCels = nullptr;
 }
 
+void FreeTownerCels()
+{
+	TownerCels.clear();
+}
+
 void ProcessTowners()
 {
 	for (auto &towner : towners) {
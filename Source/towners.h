@@ -43,7 +43,7 @@ struct TNQ {
 
 struct TownerStruct {
 	byte *_tNAnim[8];
-	std::unique_ptr<byte[]> _tNData;
+	byte *_tNData; // unowned
 	byte *_tAnimData;
 	int16_t _tSeed;
 	/** Tile position of NPC */
@@ -68,6 +68,10 @@ extern TownerStruct towners[NUM_TOWNERS];
 
 void InitTowners();
 void FreeTownerGFX();
+/**
+ * @brief Free the towner graphics that are kept between visits to the town, call at the end of a game
+ */
+void FreeTownerCels();
 void ProcessTowners();
 void TalkToTowner(PlayerStruct &player, int t);
 
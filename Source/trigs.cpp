@@ -816,11 +816,56 @@ void CheckTrigForce()
 	}
 }
 
+/**
+ * @brief Start reading the tileset behind a nearby staircase, so that taking it doesn't wait on the disk.
+ */
+static void PrefetchNearbyTriggers(Point position)
+{
+	constexpr int PrefetchDistance = 8;
+
+	for (int i = 0; i < numtrigs; i++) {
+		if (abs(position.x - trigs[i].position.x) > PrefetchDistance || abs(position.y - trigs[i].position.y) > PrefetchDistance)
+			continue;
+
+		switch (trigs[i]._tmsg) {
+		case WM_DIABNEXTLVL:
+			PrefetchLvlGFX(currlevel + 1);
+			break;
+		case WM_DIABPREVLVL:
+			PrefetchLvlGFX(currlevel - 1);
+			break;
+		case WM_DIABTOWNWARP:
+			PrefetchLvlGFX(trigs[i]._tlvl);
+			break;
+		case WM_DIABTWARPUP:
+			PrefetchLvlGFX(0);
+			break;
+		default:
+			break;
+		}
+	}
+}
+
 void CheckTriggers()
 {
 	auto &myPlayer = plr[myplr];
 
-	if (myPlayer._pmode != PM_STAND)
+	// Nothing changes for the triggers until the player moves to another tile or comes to a stop
+	static Point lastTile = { -1, -1 };
+	static int lastLevel = -1;
+	static bool wasStanding;
+	const int level = setlevel ? NUMLEVELS + setlvlnum : currlevel;
+	const bool moved = myPlayer.position.tile != lastTile || level != lastLevel;
+	const bool standing = myPlayer._pmode == PM_STAND;
+	const bool stopped = standing && (moved || !wasStanding);
+	lastTile = myPlayer.position.tile;
+	lastLevel = level;
+	wasStanding = standing;
+
+	if (moved && !setlevel)
+		PrefetchNearbyTriggers(myPlayer.position.tile);
+
+	if (!stopped)
 		return;
 
 	for (int i = 0; i < numtrigs; i++) {
@@ -1,5 +1,7 @@
 #include "utils/display.h"
 
+#include <algorithm>
+
 #ifdef __vita__
 #include <psp2/power.h>
 #endif
@@ -208,9 +210,10 @@ bool SpawnWindow(const char *lpWindowName)
 
 	int refreshRate = 60;
 #ifndef USE_SDL1
+	// Pace to the mode the window is actually shown in, not the display's first listed mode
 	SDL_DisplayMode mode;
-	SDL_GetDisplayMode(0, 0, &mode);
-	if (mode.refresh_rate != 0) {
+	const int displayIndex = std::max(SDL_GetWindowDisplayIndex(ghMainWnd), 0);
+	if (SDL_GetCurrentDisplayMode(displayIndex, &mode) == 0 && mode.refresh_rate != 0) {
 		refreshRate = mode.refresh_rate;
 	}
 #endif
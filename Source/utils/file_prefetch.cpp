@@ -0,0 +1,195 @@
+#include "utils/file_prefetch.h"
+
+#include <algorithm>
+#include <deque>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+
+#include <SDL.h>
+
+#include "appfat.h"
+#include "storm/storm.h"
+#include "utils/memory_stats.h"
+#include "utils/thread.h"
+
+namespace devilution {
+
+namespace {
+
+/** Upper limit for the size of the files that are read but not taken yet */
+constexpr size_t PrefetchBudget = 32 * 1024 * 1024;
+
+struct PrefetchedFile {
+	std::unique_ptr<byte[]> data;
+	size_t size;
+	bool ready;
+};
+
+/** Created together with the thread by the first PrefetchFile */
+SDL_mutex *PrefetchMutex;
+SDL_cond *WorkToDo;
+/** Signaled whenever the prefetch thread is done with a file */
+SDL_cond *FileRead;
+SDL_Thread *PrefetchThread;
+SDL_threadID PrefetchThreadId;
+bool PrefetchQuit;
+std::deque<std::string> PrefetchQueue;
+/** The file that the prefetch thread is reading right now */
+std::string PrefetchInFlight;
+std::unordered_map<std::string, PrefetchedFile> PrefetchedFiles;
+size_t PrefetchedBytes;
+/** Files that didn't fit the budget or couldn't be read, they aren't queued again until the next clear */
+std::unordered_set<std::string> PrefetchSkipped;
+
+std::unique_ptr<byte[]> ReadWholeFile(const char *path, size_t *size, size_t maxSize)
+{
+	HANDLE file;
+	if (!SFileOpenFile(path, &file))
+		return nullptr;
+
+	*size = SFileGetFileSize(file);
+	if (*size > maxSize) {
+		SFileCloseFileThreadSafe(file);
+		return nullptr;
+	}
+	std::unique_ptr<byte[]> data { new byte[*size] };
+	const bool success = *size != 0 && SFileReadFileThreadSafe(file, data.get(), *size);
+	SFileCloseFileThreadSafe(file);
+
+	if (!success)
+		return nullptr;
+	return data;
+}
+
+unsigned int PrefetchHandler(void * /*data*/)
+{
+	MemoryTagScope memoryTag(MemoryTag::Prefetch);
+	SDL_LockMutex(PrefetchMutex);
+	while (!PrefetchQuit) {
+		if (PrefetchQueue.empty()) {
+			SDL_CondWait(WorkToDo, PrefetchMutex);
+			continue;
+		}
+
+		const std::string path = std::move(PrefetchQueue.front());
+		PrefetchQueue.pop_front();
+		PrefetchInFlight = path;
+		const size_t available = PrefetchBudget - PrefetchedBytes;
+		SDL_UnlockMutex(PrefetchMutex);
+
+		size_t size = 0;
+		std::unique_ptr<byte[]> data = ReadWholeFile(path.c_str(), &size, available);
+
+		SDL_LockMutex(PrefetchMutex);
+		PrefetchInFlight.clear();
+		SDL_CondBroadcast(FileRead);
+		auto it = PrefetchedFiles.find(path);
+		// The entry is gone if ClearPrefetchedFiles ran while the file was read
+		if (it == PrefetchedFiles.end())
+			continue;
+		if (data == nullptr || PrefetchedBytes + size > PrefetchBudget) {
+			PrefetchedFiles.erase(it);
+			PrefetchSkipped.insert(path);
+			continue;
+		}
+		it->second.data = std::move(data);
+		it->second.size = size;
+		it->second.ready = true;
+		PrefetchedBytes += size;
+	}
+	SDL_UnlockMutex(PrefetchMutex);
+
+	return 0;
+}
+
+} // namespace
+
+void PrefetchFile(const char *path)
+{
+	if (PrefetchThread == nullptr) {
+		if (PrefetchQuit)
+			return;
+		PrefetchMutex = SDL_CreateMutex();
+		WorkToDo = SDL_CreateCond();
+		FileRead = SDL_CreateCond();
+		if (PrefetchMutex == nullptr || WorkToDo == nullptr || FileRead == nullptr)
+			ErrSdl();
+		PrefetchThread = CreateThread(PrefetchHandler, &PrefetchThreadId);
+	}
+
+	SDL_LockMutex(PrefetchMutex);
+	if (PrefetchedFiles.count(path) == 0 && PrefetchSkipped.count(path) == 0) {
+		PrefetchedFiles.emplace(path, PrefetchedFile { nullptr, 0, false });
+		PrefetchQueue.emplace_back(path);
+		SDL_CondSignal(WorkToDo);
+	}
+	SDL_UnlockMutex(PrefetchMutex);
+}
+
+std::unique_ptr<byte[]> TakePrefetchedFile(const char *path, size_t *size)
+{
+	if (PrefetchThread == nullptr)
+		return nullptr;
+
+	std::unique_ptr<byte[]> data;
+	SDL_LockMutex(PrefetchMutex);
+	// Reading the file again would only compete with the prefetch thread for the disk
+	while (PrefetchInFlight == path)
+		SDL_CondWait(FileRead, PrefetchMutex);
+	auto it = PrefetchedFiles.find(path);
+	if (it != PrefetchedFiles.end() && !it->second.ready) {
+		// Still queued, the caller reads it now instead
+		PrefetchQueue.erase(std::find(PrefetchQueue.begin(), PrefetchQueue.end(), it->first));
+		PrefetchedFiles.erase(it);
+	} else if (it != PrefetchedFiles.end()) {
+		data = std::move(it->second.data);
+		*size = it->second.size;
+		PrefetchedBytes -= it->second.size;
+		PrefetchedFiles.erase(it);
+	}
+	SDL_UnlockMutex(PrefetchMutex);
+
+	return data;
+}
+
+void ClearPrefetchedFiles()
+{
+	if (PrefetchThread == nullptr)
+		return;
+
+	SDL_LockMutex(PrefetchMutex);
+	PrefetchQueue.clear();
+	PrefetchedFiles.clear();
+	PrefetchSkipped.clear();
+	PrefetchedBytes = 0;
+	SDL_UnlockMutex(PrefetchMutex);
+}
+
+void ShutdownFilePrefetch()
+{
+	if (PrefetchThread == nullptr) {
+		PrefetchQuit = true;
+		return;
+	}
+
+	SDL_LockMutex(PrefetchMutex);
+	PrefetchQuit = true;
+	SDL_CondSignal(WorkToDo);
+	SDL_UnlockMutex(PrefetchMutex);
+	SDL_WaitThread(PrefetchThread, nullptr);
+	PrefetchThread = nullptr;
+
+	PrefetchQueue.clear();
+	PrefetchedFiles.clear();
+	PrefetchSkipped.clear();
+	PrefetchedBytes = 0;
+	SDL_DestroyCond(FileRead);
+	SDL_DestroyCond(WorkToDo);
+	SDL_DestroyMutex(PrefetchMutex);
+	FileRead = nullptr;
+	WorkToDo = nullptr;
+	PrefetchMutex = nullptr;
+}
+
+} // namespace devilution
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+
+#include "utils/stdcompat/cstddef.hpp"
+
+namespace devilution {
+
+/**
+ * @brief Queue a file to be read on the background prefetch thread.
+ *
+ * Files that are already queued or read are skipped, as are files that don't fit the memory budget.
+ * A file that was skipped for the budget isn't queued again until ClearPrefetchedFiles.
+ */
+void PrefetchFile(const char *path);
+
+/**
+ * @brief Take the contents of a prefetched file.
+ *
+ * Waits if the file is being read right now. A file that is still queued is dropped from the queue.
+ * @return nullptr if the file hasn't been read, the caller has to read it itself
+ */
+std::unique_ptr<byte[]> TakePrefetchedFile(const char *path, size_t *size);
+
+/** @brief Drop everything that was queued or read but hasn't been taken. */
+void ClearPrefetchedFiles();
+
+/** @brief Stop the prefetch thread, must happen before the archives are closed. */
+void ShutdownFilePrefetch();
+
+} // namespace devilution
@@ -3,6 +3,7 @@
 #include <functional>
 #include <map>
 #include <memory>
+#include <unordered_map>
 #include <vector>
 
 #include "options.h"
@@ -24,6 +25,13 @@ struct CStringCmp {
 
 std::vector<std::map<std::string, std::string, std::less<>>> translation = { {}, {} };
 std::map<const char *, const char *, CStringCmp> meta;
+/** Text of the MO header, meta points into it */
+std::vector<char> metaText;
+/**
+ * Translations looked up by the address of their key, keys are string literals or entries
+ * of static tables so the same address always holds the same text
+ */
+std::unordered_map<const char *, const std::string *> translationByAddress;
 
 struct MoHead {
 	uint32_t magic;
@@ -190,13 +198,14 @@ void ParseMetadata(char *ptr)
 	}
 }
 
-bool ReadEntry(FILE *fp, MoEntry *e, std::vector<char> &result)
+/**
+ * @brief Returns the string described by an entry, or nullptr if it lies outside of the file
+ */
+char *ReadEntry(char *data, size_t size, const MoEntry &e)
 {
-	if (fseek(fp, e->offset, SEEK_SET) != 0)
-		return false;
-	result.resize(e->length + 1);
-	result.back() = '\0';
-	return (fread(result.data(), sizeof(char), e->length, fp) == e->length);
+	if (e.offset >= size || size - e.offset <= e.length || data[e.offset + e.length] != '\0')
+		return nullptr;
+	return &data[e.offset];
 }
 
 } // namespace
@@ -217,11 +226,16 @@ const std::string &LanguagePluralTranslate(const char *singular, const char *plu
 }
 const std::string &LanguageTranslate(const char *key)
 {
+	auto cached = translationByAddress.find(key);
+	if (cached != translationByAddress.end())
+		return *cached->second;
+
 	auto it = translation[0].find(key);
 	if (it == translation[0].end()) {
 		it = translation[0].insert({ key, utf8_to_latin1(key) }).first;
 	}
 
+	translationByAddress.emplace(key, &it->second);
 	return it->second;
 }
 
@@ -247,12 +261,26 @@ void LanguageInitialize()
 			return;
 		}
 	}
-	// Read header and do sanity checks
+	// Read the whole catalogue in one go, the entries are then parsed in place
+	std::unique_ptr<char[]> data;
+	size_t size = 0;
+	if (fseek(fp, 0, SEEK_END) == 0) {
+		long length = ftell(fp);
+		if (length > 0 && fseek(fp, 0, SEEK_SET) == 0) {
+			size = static_cast<size_t>(length);
+			data.reset(new char[size]);
+			if (fread(data.get(), 1, size, fp) != size)
+				size = 0;
+		}
+	}
+	fclose(fp);
+
+	// Do sanity checks on the header
 	// FIXME: Endianness.
 	MoHead head;
-	if (fread(&head, sizeof(MoHead), 1, fp) != 1) {
+	if (size < sizeof(MoHead))
 		return;
-	}
+	memcpy(&head, data.get(), sizeof(MoHead));
 
 	if (head.magic != MO_MAGIC) {
 		return; // not a MO file
@@ -262,47 +290,45 @@ void LanguageInitialize()
 		return; // unsupported revision
 	}
 
-	// Read entries of source strings
-	std::unique_ptr<MoEntry[]> src { new MoEntry[head.nb_mappings] };
-	if (fseek(fp, head.src_offset, SEEK_SET) != 0)
+	// Entries of source and target strings
+	const size_t tableSize = sizeof(MoEntry) * head.nb_mappings;
+	if (head.nb_mappings == 0 || head.src_offset > size || size - head.src_offset < tableSize
+	    || head.dst_offset > size || size - head.dst_offset < tableSize)
 		return;
-	// FIXME: Endianness.
-	if (fread(src.get(), sizeof(MoEntry), head.nb_mappings, fp) != head.nb_mappings)
-		return;
-
-	// Read entries of target strings
+	std::unique_ptr<MoEntry[]> src { new MoEntry[head.nb_mappings] };
 	std::unique_ptr<MoEntry[]> dst { new MoEntry[head.nb_mappings] };
-	if (fseek(fp, head.dst_offset, SEEK_SET) != 0)
-		return;
 	// FIXME: Endianness.
-	if (fread(dst.get(), sizeof(MoEntry), head.nb_mappings, fp) != head.nb_mappings)
-		return;
-
-	std::vector<char> key;
-	std::vector<char> value;
+	memcpy(src.get(), &data[head.src_offset], tableSize);
+	memcpy(dst.get(), &data[head.dst_offset], tableSize);
 
 	// MO header
-	if (!ReadEntry(fp, &src[0], key) && ReadEntry(fp, &dst[0], value))
+	const char *key = ReadEntry(data.get(), size, src[0]);
+	char *value = ReadEntry(data.get(), size, dst[0]);
+	if (key == nullptr || value == nullptr)
 		return;
 
 	if (key[0] != '\0')
 		return;
 
-	ParseMetadata(value.data());
+	metaText.assign(value, value + dst[0].length + 1);
+	ParseMetadata(metaText.data());
 
 	translation.resize(PluralForms);
 	for (int i = 0; i < PluralForms; i++)
 		translation[i] = {};
+	translationByAddress.clear();
 
 	// Read strings described by entries
 	for (uint32_t i = 1; i < head.nb_mappings; i++) {
-		if (ReadEntry(fp, &src[i], key) && ReadEntry(fp, &dst[i], value)) {
+		key = ReadEntry(data.get(), size, src[i]);
+		value = ReadEntry(data.get(), size, dst[i]);
+		if (key != nullptr && value != nullptr) {
 			size_t offset = 0;
 			for (int j = 0; j < PluralForms; j++) {
-				const char *text = value.data() + offset;
-				translation[j].emplace(key.data(), IsUTF8 ? utf8_to_latin1(text) : text);
+				const char *text = value + offset;
+				translation[j].emplace(key, IsUTF8 ? utf8_to_latin1(text) : text);
 
-				if (dst[i].length <= offset + strlen(value.data()))
+				if (dst[i].length <= offset + strlen(value))
 					break;
 
 				offset += strlen(text) + 1;
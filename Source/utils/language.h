@@ -8,5 +8,6 @@
 
 void LanguageInitialize();
 const std::string &LanguagePluralTranslate(const char *singular, const char *plural, int count);
+/** @param key Must keep its text for the rest of the program, translations are cached by its address */
 const std::string &LanguageTranslate(const char *key);
 const char *LanguageMetadata(const char *key);
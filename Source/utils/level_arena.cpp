@@ -0,0 +1,74 @@
+#include "utils/level_arena.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "engine.h"
+#include "utils/memory_stats.h"
+#include "utils/sdl_mutex.h"
+
+namespace devilution {
+
+namespace {
+
+/** Size of the blocks the allocations are carved out of, larger allocations get a block of their own */
+constexpr size_t LevelBlockSize = 4 * 1024 * 1024;
+constexpr size_t LevelAlignment = 16;
+
+struct LevelBlock {
+	std::unique_ptr<byte[]> data;
+	size_t size;
+};
+
+std::vector<LevelBlock> LevelBlocks;
+/** Start of the free space in the last block */
+size_t LevelBlockUsed;
+
+SdlMutex &LevelMutex()
+{
+	static SdlMutex mutex;
+	return mutex;
+}
+
+} // namespace
+
+byte *AllocateLevelMemory(size_t size)
+{
+	size = (size + LevelAlignment - 1) & ~(LevelAlignment - 1);
+
+	std::lock_guard<SdlMutex> lock(LevelMutex());
+	if (LevelBlocks.empty() || LevelBlocks.back().size - LevelBlockUsed < size) {
+		const size_t blockSize = std::max(size, LevelBlockSize);
+		MemoryTagScope memoryTag(MemoryTag::LevelArena);
+		// new[] only guarantees the alignment of fundamental types, keep some room to align the start
+		LevelBlocks.push_back({ std::unique_ptr<byte[]> { new byte[blockSize + LevelAlignment] }, blockSize });
+		LevelBlockUsed = 0;
+	}
+
+	const LevelBlock &block = LevelBlocks.back();
+	const uintptr_t start = (reinterpret_cast<uintptr_t>(block.data.get()) + LevelAlignment - 1) & ~(LevelAlignment - 1);
+	byte *memory = reinterpret_cast<byte *>(start) + LevelBlockUsed;
+	LevelBlockUsed += size;
+	return memory;
+}
+
+byte *LoadFileInLevelMemory(const char *path)
+{
+	const size_t fileLen = GetFileSize(path);
+	byte *buf = AllocateLevelMemory(fileLen);
+	LoadFileData(path, buf, fileLen);
+	return buf;
+}
+
+void FreeLevelMemory()
+{
+	std::lock_guard<SdlMutex> lock(LevelMutex());
+	LevelBlocks.clear();
+	LevelBlocks.shrink_to_fit();
+	LevelBlockUsed = 0;
+}
+
+} // namespace devilution
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <cstddef>
+
+#include "utils/stdcompat/cstddef.hpp"
+
+namespace devilution {
+
+/**
+ * @brief Allocate memory that lives until the level is left.
+ *
+ * Allocations are carved out of a few large blocks, so the graphics of a level end up next to each
+ * other instead of scattered over the heap. Safe to call from the loader threads.
+ * @return Memory aligned to 16 bytes, owned by the arena
+ */
+byte *AllocateLevelMemory(size_t size);
+
+/**
+ * @brief Load a file into memory that lives until the level is left.
+ * @return Buffer with content of file, owned by the arena
+ */
+byte *LoadFileInLevelMemory(const char *path);
+
+/** @brief Release everything allocated for the current level at once. */
+void FreeLevelMemory();
+
+} // namespace devilution
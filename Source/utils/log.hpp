@@ -55,9 +55,19 @@ std::string format(const char *fmt, Args &&... args)
 
 } // namespace detail
 
+/**
+ * @brief Whether messages of the given priority are shown, checked before the arguments are formatted.
+ */
+inline bool IsLogLevel(LogCategory category, LogPriority priority)
+{
+	return static_cast<int>(priority) >= static_cast<int>(SDL_LogGetPriority(static_cast<int>(category)));
+}
+
 template <typename... Args>
 void Log(const char *fmt, Args &&... args)
 {
+	if (!IsLogLevel(LogCategory::Application, LogPriority::Info))
+		return;
 	auto str = detail::format(fmt, std::forward<Args>(args)...);
 	SDL_Log("%s", str.c_str());
 }
@@ -65,6 +75,8 @@ void Log(const char *fmt, Args &&... args)
 template <typename... Args>
 void LogVerbose(LogCategory category, const char *fmt, Args &&... args)
 {
+	if (!IsLogLevel(category, LogPriority::Verbose))
+		return;
 	auto str = detail::format(fmt, std::forward<Args>(args)...);
 	SDL_LogVerbose(static_cast<int>(category), "%s", str.c_str());
 }
@@ -78,6 +90,8 @@ void LogVerbose(const char *fmt, Args &&... args)
 template <typename... Args>
 void LogDebug(LogCategory category, const char *fmt, Args &&... args)
 {
+	if (!IsLogLevel(category, LogPriority::Debug))
+		return;
 	auto str = detail::format(fmt, std::forward<Args>(args)...);
 	SDL_LogDebug(static_cast<int>(category), "%s", str.c_str());
 }
@@ -91,6 +105,8 @@ void LogDebug(const char *fmt, Args &&... args)
 template <typename... Args>
 void LogInfo(LogCategory category, const char *fmt, Args &&... args)
 {
+	if (!IsLogLevel(category, LogPriority::Info))
+		return;
 	auto str = detail::format(fmt, std::forward<Args>(args)...);
 	SDL_LogInfo(static_cast<int>(category), "%s", str.c_str());
 }
@@ -104,6 +120,8 @@ void LogInfo(const char *fmt, Args &&... args)
 template <typename... Args>
 void LogWarn(LogCategory category, const char *fmt, Args &&... args)
 {
+	if (!IsLogLevel(category, LogPriority::Warn))
+		return;
 	auto str = detail::format(fmt, std::forward<Args>(args)...);
 	SDL_LogWarn(static_cast<int>(category), "%s", str.c_str());
 }
@@ -117,6 +135,8 @@ void LogWarn(const char *fmt, Args &&... args)
 template <typename... Args>
 void LogError(LogCategory category, const char *fmt, Args &&... args)
 {
+	if (!IsLogLevel(category, LogPriority::Error))
+		return;
 	auto str = detail::format(fmt, std::forward<Args>(args)...);
 	SDL_LogError(static_cast<int>(category), "%s", str.c_str());
 }
@@ -130,6 +150,8 @@ void LogError(const char *fmt, Args &&... args)
 template <typename... Args>
 void LogCritical(LogCategory category, const char *fmt, Args &&... args)
 {
+	if (!IsLogLevel(category, LogPriority::Critical))
+		return;
 	auto str = detail::format(fmt, std::forward<Args>(args)...);
 	SDL_LogCritical(static_cast<int>(category), "%s", str.c_str());
 }
@@ -143,6 +165,8 @@ void LogCritical(const char *fmt, Args &&... args)
 template <typename... Args>
 void LogMessageV(LogCategory category, LogPriority priority, const char *fmt, Args &&... args)
 {
+	if (!IsLogLevel(category, priority))
+		return;
 	auto str = detail::format(fmt, std::forward<Args>(args)...);
 	SDL_LogMessageV(static_cast<int>(category), static_cast<SDL_LogPriority>(priority), "%s", str.c_str());
 }
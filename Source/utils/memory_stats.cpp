@@ -0,0 +1,161 @@
+#include "utils/memory_stats.h"
+
+#ifdef MEMORY_STATS
+#include <array>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+#include "utils/log.hpp"
+#endif
+
+namespace devilution {
+
+const char *MemoryTagName(MemoryTag tag)
+{
+	switch (tag) {
+	case MemoryTag::Untagged:
+		return "Untagged";
+	case MemoryTag::Files:
+		return "Files";
+	case MemoryTag::Prefetch:
+		return "Prefetch";
+	case MemoryTag::Tileset:
+		return "Tileset";
+	case MemoryTag::Cels:
+		return "Cels";
+	case MemoryTag::Sound:
+		return "Sound";
+	case MemoryTag::Art:
+		return "Art";
+	case MemoryTag::LevelArena:
+		return "LevelArena";
+	case MemoryTag::MonsterSheets:
+		return "MonsterSheets";
+	case MemoryTag::DungeonGrids:
+		return "DungeonGrids";
+	case MemoryTag::MonsterArrays:
+		return "MonsterArrays";
+	}
+	return "";
+}
+
+#ifdef MEMORY_STATS
+
+namespace {
+
+/** Put in front of every allocation, keeps the alignment operator new guarantees */
+struct alignas(std::max_align_t) AllocationHeader {
+	size_t size;
+	MemoryTag tag;
+};
+
+thread_local MemoryTag CurrentTag = MemoryTag::Untagged;
+std::array<std::atomic<size_t>, enum_size<MemoryTag>::value> CurrentBytes;
+std::array<std::atomic<size_t>, enum_size<MemoryTag>::value> PeakBytes;
+bool OverlayEnabled;
+
+void AddBytes(MemoryTag tag, size_t bytes)
+{
+	const auto i = static_cast<size_t>(tag);
+	const size_t current = CurrentBytes[i].fetch_add(bytes, std::memory_order_relaxed) + bytes;
+	size_t peak = PeakBytes[i].load(std::memory_order_relaxed);
+	while (current > peak && !PeakBytes[i].compare_exchange_weak(peak, current, std::memory_order_relaxed)) {
+	}
+}
+
+void RemoveBytes(MemoryTag tag, size_t bytes)
+{
+	CurrentBytes[static_cast<size_t>(tag)].fetch_sub(bytes, std::memory_order_relaxed);
+}
+
+} // namespace
+
+MemoryTagScope::MemoryTagScope(MemoryTag tag)
+    : previous_(CurrentTag)
+{
+	if (CurrentTag == MemoryTag::Untagged)
+		CurrentTag = tag;
+}
+
+MemoryTagScope::~MemoryTagScope()
+{
+	CurrentTag = previous_;
+}
+
+MemoryTagStats GetMemoryStats(MemoryTag tag)
+{
+	const auto i = static_cast<size_t>(tag);
+	return { CurrentBytes[i].load(std::memory_order_relaxed), PeakBytes[i].load(std::memory_order_relaxed) };
+}
+
+void TrackStaticMemory(MemoryTag tag, size_t bytes)
+{
+	AddBytes(tag, bytes);
+}
+
+void AdoptAllocation(void *ptr)
+{
+	if (ptr == nullptr)
+		return;
+	auto *header = static_cast<AllocationHeader *>(ptr) - 1;
+	RemoveBytes(header->tag, header->size);
+	header->tag = CurrentTag;
+	AddBytes(header->tag, header->size);
+}
+
+void LogMemoryStats()
+{
+	size_t totalCurrent = 0;
+	for (MemoryTag tag : enum_values<MemoryTag>()) {
+		const MemoryTagStats stats = GetMemoryStats(tag);
+		totalCurrent += stats.current;
+		Log("Memory {}: {} KiB, peak {} KiB", MemoryTagName(tag), stats.current / 1024, stats.peak / 1024);
+	}
+	Log("Memory total: {} KiB", totalCurrent / 1024);
+}
+
+bool IsMemoryOverlayEnabled()
+{
+	return OverlayEnabled;
+}
+
+void SetMemoryOverlayEnabled(bool enabled)
+{
+	OverlayEnabled = enabled;
+}
+
+#endif
+
+} // namespace devilution
+
+#ifdef MEMORY_STATS
+
+void *operator new(std::size_t size)
+{
+	using namespace devilution;
+	auto *header = static_cast<AllocationHeader *>(std::malloc(sizeof(AllocationHeader) + size));
+	if (header == nullptr)
+		throw std::bad_alloc();
+	header->size = size;
+	header->tag = CurrentTag;
+	AddBytes(header->tag, size);
+	return header + 1;
+}
+
+void operator delete(void *ptr) noexcept
+{
+	using namespace devilution;
+	if (ptr == nullptr)
+		return;
+	auto *header = static_cast<AllocationHeader *>(ptr) - 1;
+	RemoveBytes(header->tag, header->size);
+	std::free(header);
+}
+
+void operator delete(void *ptr, std::size_t /*size*/) noexcept
+{
+	operator delete(ptr);
+}
+
+#endif
@@ -0,0 +1,93 @@
+/**
+ * @file memory_stats.h
+ *
+ * Heap usage by subsystem, for finding out where memory goes on constrained platforms.
+ *
+ * Only counted in builds with MEMORY_STATS, which prefixes every operator new allocation with its size and tag.
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "utils/enum_traits.h"
+
+namespace devilution {
+
+enum class MemoryTag : uint8_t {
+	Untagged,
+	/** Files read with LoadFileInMem outside of a more specific scope */
+	Files,
+	/** Files read ahead on the prefetch thread that weren't taken yet */
+	Prefetch,
+	Tileset,
+	Cels,
+	Sound,
+	Art,
+	LevelArena,
+	MonsterSheets,
+	/** Fixed size dungeon grids from gendung.h */
+	DungeonGrids,
+	/** Fixed size monster arrays from monster.h */
+	MonsterArrays,
+
+	FIRST = Untagged,
+	LAST = MonsterArrays
+};
+
+const char *MemoryTagName(MemoryTag tag);
+
+#ifdef MEMORY_STATS
+
+/**
+ * @brief Counts the allocations of the current thread under the given tag until the end of the scope.
+ *
+ * An enclosing scope takes precedence, so generic loaders can tag their allocations without hiding the subsystem that called them.
+ */
+class MemoryTagScope {
+public:
+	explicit MemoryTagScope(MemoryTag tag);
+	~MemoryTagScope();
+
+	MemoryTagScope(const MemoryTagScope &) = delete;
+	MemoryTagScope &operator=(const MemoryTagScope &) = delete;
+
+private:
+	MemoryTag previous_;
+};
+
+struct MemoryTagStats {
+	size_t current;
+	size_t peak;
+};
+
+MemoryTagStats GetMemoryStats(MemoryTag tag);
+
+/** @brief Count memory that isn't allocated with operator new, like static arrays. */
+void TrackStaticMemory(MemoryTag tag, size_t bytes);
+
+/** @brief Count an allocation made under another tag under the tag of the current scope, for buffers that are handed over. */
+void AdoptAllocation(void *ptr);
+
+/** @brief Write the current and peak bytes of every tag to the log. */
+void LogMemoryStats();
+
+bool IsMemoryOverlayEnabled();
+void SetMemoryOverlayEnabled(bool enabled);
+
+#else
+
+class MemoryTagScope {
+public:
+	explicit MemoryTagScope(MemoryTag /*tag*/)
+	{
+	}
+};
+
+inline void AdoptAllocation(void * /*ptr*/)
+{
+}
+
+#endif
+
+} // namespace devilution
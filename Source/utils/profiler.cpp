@@ -0,0 +1,320 @@
+#include "utils/profiler.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+
+#include <fmt/format.h>
+
+#include "utils/memory_stats.h"
+
+namespace devilution {
+
+namespace {
+
+/** Number of frames kept for the CSV dump. */
+constexpr std::size_t MaxFrames = 1024;
+/** Number of scopes kept for the trace dump. */
+constexpr std::size_t MaxEvents = 16384;
+/** Number of counter values kept for the trace dump. */
+constexpr std::size_t MaxSamples = 4096;
+
+/**
+ * Scopes and counters are recorded from any thread while the trace may be written, so every field is atomic.
+ * A writer claims a slot by incrementing the count, clears its sequence, fills it in and then publishes
+ * the slot by storing the index + 1 of its entry in the sequence.
+ */
+struct ProfileEvent {
+	std::atomic<std::size_t> sequence;
+	std::atomic<const char *> name;
+	std::atomic<int64_t> start;
+	std::atomic<uint32_t> duration;
+	std::atomic<uint32_t> thread;
+};
+
+struct CounterSample {
+	std::atomic<std::size_t> sequence;
+	std::atomic<ProfileCounter> counter;
+	std::atomic<int64_t> time;
+	std::atomic<int64_t> value;
+};
+
+std::atomic<bool> Enabled;
+std::atomic<std::chrono::steady_clock::rep> Epoch;
+
+FrameProfile CurrentFrame;
+FrameProfile LastFrame;
+std::array<FrameProfile, MaxFrames> Frames;
+std::size_t FrameCount;
+int64_t FrameStart;
+std::array<ProfileEvent, MaxEvents> Events;
+std::atomic<std::size_t> EventCount;
+std::array<CounterSample, MaxSamples> Samples;
+std::atomic<std::size_t> SampleCount;
+
+/** Trace thread ids, handed out in the order the threads first record a scope. */
+std::atomic<uint32_t> NextThreadId { 1 };
+thread_local uint32_t ThreadId;
+
+uint32_t CurrentThreadId()
+{
+	if (ThreadId == 0)
+		ThreadId = NextThreadId++;
+	return ThreadId;
+}
+
+int64_t Now()
+{
+	const std::chrono::steady_clock::duration sinceEpoch(std::chrono::steady_clock::now().time_since_epoch().count() - Epoch);
+	return std::chrono::duration_cast<std::chrono::microseconds>(sinceEpoch).count();
+}
+
+/**
+ * @brief Claims the next slot of a ring buffer of published entries.
+ * @return The slot, fill it in and then call PublishSlot
+ */
+template <typename T, std::size_t N>
+T &ClaimSlot(std::array<T, N> &ring, std::atomic<std::size_t> &count, std::size_t &index)
+{
+	index = count.fetch_add(1, std::memory_order_relaxed);
+	T &slot = ring[index % N];
+	slot.sequence.store(0, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+	return slot;
+}
+
+template <typename T>
+void PublishSlot(T &slot, std::size_t index)
+{
+	slot.sequence.store(index + 1, std::memory_order_release);
+}
+
+/**
+ * @brief Calls fn for every published entry of a ring buffer, oldest first.
+ *
+ * Entries that are still being written, or that were overwritten while they were read, are skipped.
+ * @param count Number of entries ever claimed
+ * @param fn Reads the entry it is given into a copy and returns that copy
+ * @param use Called with each copy that was read consistently
+ */
+template <typename T, std::size_t N, typename F, typename U>
+void ForEachInRing(const std::array<T, N> &ring, const std::atomic<std::size_t> &count, F &&fn, U &&use)
+{
+	const std::size_t end = count.load(std::memory_order_relaxed);
+	const std::size_t first = end > N ? end - N : 0;
+	for (std::size_t i = first; i < end; i++) {
+		const T &slot = ring[i % N];
+		if (slot.sequence.load(std::memory_order_acquire) != i + 1)
+			continue;
+		const auto entry = fn(slot);
+		std::atomic_thread_fence(std::memory_order_acquire);
+		if (slot.sequence.load(std::memory_order_relaxed) != i + 1)
+			continue;
+		use(entry);
+	}
+}
+
+} // namespace
+
+const char *ProfilePhaseName(ProfilePhase phase)
+{
+	switch (phase) {
+	case ProfilePhase::ProcessPlayers:
+		return "ProcessPlayers";
+	case ProfilePhase::ProcessMonsters:
+		return "ProcessMonsters";
+	case ProfilePhase::ProcessObjects:
+		return "ProcessObjects";
+	case ProfilePhase::ProcessMissiles:
+		return "ProcessMissiles";
+	case ProfilePhase::ProcessLightList:
+		return "ProcessLightList";
+	case ProfilePhase::ProcessVisionList:
+		return "ProcessVisionList";
+	case ProfilePhase::DrawView:
+		return "DrawView";
+	case ProfilePhase::DrawMain:
+		return "DrawMain";
+	case ProfilePhase::RenderPresent:
+		return "RenderPresent";
+	}
+	return "";
+}
+
+const char *ProfileCounterName(ProfileCounter counter)
+{
+	switch (counter) {
+	case ProfileCounter::FrameTime:
+		return "FrameTime";
+	case ProfileCounter::DeltaQueue:
+		return "DeltaQueue";
+	case ProfileCounter::AllocatedBytes:
+		return "AllocatedBytes";
+	}
+	return "";
+}
+
+bool IsProfilerEnabled()
+{
+	return Enabled;
+}
+
+void SetProfilerEnabled(bool enabled)
+{
+	if (enabled && !Enabled) {
+		Epoch = std::chrono::steady_clock::now().time_since_epoch().count();
+		CurrentFrame = {};
+		LastFrame = {};
+		FrameCount = 0;
+		FrameStart = 0;
+		EventCount = 0;
+		SampleCount = 0;
+		for (ProfileEvent &event : Events)
+			event.sequence = 0;
+		for (CounterSample &sample : Samples)
+			sample.sequence = 0;
+	}
+	Enabled = enabled;
+}
+
+ProfileScope::ProfileScope(ProfilePhase phase)
+    : name_(ProfilePhaseName(phase))
+    , phase_(static_cast<int>(phase))
+    , start_(Enabled ? Now() : -1)
+{
+}
+
+ProfileScope::ProfileScope(const char *zone)
+    : name_(zone)
+    , phase_(-1)
+    , start_(Enabled ? Now() : -1)
+{
+}
+
+ProfileScope::~ProfileScope()
+{
+	if (start_ < 0 || !Enabled)
+		return;
+
+	const auto duration = static_cast<uint32_t>(Now() - start_);
+	// Phases only run on the game thread, zones don't touch the frame
+	if (phase_ >= 0)
+		CurrentFrame[phase_] += duration;
+	std::size_t index;
+	ProfileEvent &event = ClaimSlot(Events, EventCount, index);
+	event.name.store(name_, std::memory_order_relaxed);
+	event.start.store(start_, std::memory_order_relaxed);
+	event.duration.store(duration, std::memory_order_relaxed);
+	event.thread.store(CurrentThreadId(), std::memory_order_relaxed);
+	PublishSlot(event, index);
+}
+
+void ProfilerSetCounter(ProfileCounter counter, int64_t value)
+{
+	if (!Enabled)
+		return;
+
+	std::size_t index;
+	CounterSample &sample = ClaimSlot(Samples, SampleCount, index);
+	sample.counter.store(counter, std::memory_order_relaxed);
+	sample.time.store(Now(), std::memory_order_relaxed);
+	sample.value.store(value, std::memory_order_relaxed);
+	PublishSlot(sample, index);
+}
+
+void ProfilerEndFrame()
+{
+	if (!Enabled)
+		return;
+
+	const int64_t now = Now();
+	ProfilerSetCounter(ProfileCounter::FrameTime, now - FrameStart);
+	FrameStart = now;
+#ifdef MEMORY_STATS
+	size_t allocated = 0;
+	for (MemoryTag tag : enum_values<MemoryTag>())
+		allocated += GetMemoryStats(tag).current;
+	ProfilerSetCounter(ProfileCounter::AllocatedBytes, allocated);
+#endif
+
+	LastFrame = CurrentFrame;
+	Frames[FrameCount % MaxFrames] = CurrentFrame;
+	FrameCount++;
+	CurrentFrame = {};
+}
+
+const FrameProfile &ProfilerLastFrame()
+{
+	return LastFrame;
+}
+
+bool ProfilerWriteCsv(const std::string &path)
+{
+	FILE *file = std::fopen(path.c_str(), "w");
+	if (file == nullptr)
+		return false;
+
+	std::fputs("frame", file);
+	for (ProfilePhase phase : enum_values<ProfilePhase>())
+		fmt::print(file, ",{}", ProfilePhaseName(phase));
+	std::fputs("\n", file);
+
+	// Frames are only recorded on the game thread, which also writes the dump
+	const std::size_t first = FrameCount > MaxFrames ? FrameCount - MaxFrames : 0;
+	for (std::size_t frame = first; frame < FrameCount; frame++) {
+		fmt::print(file, "{}", frame);
+		for (uint32_t microseconds : Frames[frame % MaxFrames])
+			fmt::print(file, ",{:.3f}", microseconds / 1000.0);
+		std::fputs("\n", file);
+	}
+
+	return std::fclose(file) == 0;
+}
+
+bool ProfilerWriteChromeTrace(const std::string &path)
+{
+	FILE *file = std::fopen(path.c_str(), "w");
+	if (file == nullptr)
+		return false;
+
+	std::fputs("{\"traceEvents\":[", file);
+	bool first = true;
+	struct EventCopy {
+		const char *name;
+		int64_t start;
+		uint32_t duration;
+		uint32_t thread;
+	};
+	ForEachInRing(
+	    Events, EventCount,
+	    [](const ProfileEvent &event) {
+		    return EventCopy { event.name.load(std::memory_order_relaxed), event.start.load(std::memory_order_relaxed),
+			    event.duration.load(std::memory_order_relaxed), event.thread.load(std::memory_order_relaxed) };
+	    },
+	    [&](const EventCopy &event) {
+		    fmt::print(file, "{}\n{{\"name\":\"{}\",\"ph\":\"X\",\"pid\":1,\"tid\":{},\"ts\":{},\"dur\":{}}}",
+		        first ? "" : ",", event.name, event.thread, event.start, event.duration);
+		    first = false;
+	    });
+	struct SampleCopy {
+		ProfileCounter counter;
+		int64_t time;
+		int64_t value;
+	};
+	ForEachInRing(
+	    Samples, SampleCount,
+	    [](const CounterSample &sample) {
+		    return SampleCopy { sample.counter.load(std::memory_order_relaxed), sample.time.load(std::memory_order_relaxed),
+			    sample.value.load(std::memory_order_relaxed) };
+	    },
+	    [&](const SampleCopy &sample) {
+		    fmt::print(file, "{}\n{{\"name\":\"{}\",\"ph\":\"C\",\"pid\":1,\"ts\":{},\"args\":{{\"value\":{}}}}}",
+		        first ? "" : ",", ProfileCounterName(sample.counter), sample.time, sample.value);
+		    first = false;
+	    });
+	std::fputs("\n]}\n", file);
+
+	return std::fclose(file) == 0;
+}
+
+} // namespace devilution
@@ -0,0 +1,97 @@
+/**
+ * @file profiler.h
+ *
+ * Lightweight frame profiler with scoped timers for the main game and render phases,
+ * plus named zones and counters from any thread for the timeline trace.
+ */
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <string>
+
+#include "utils/enum_traits.h"
+
+namespace devilution {
+
+enum class ProfilePhase : uint8_t {
+	ProcessPlayers,
+	ProcessMonsters,
+	ProcessObjects,
+	ProcessMissiles,
+	ProcessLightList,
+	ProcessVisionList,
+	DrawView,
+	DrawMain,
+	RenderPresent,
+
+	FIRST = ProcessPlayers,
+	LAST = RenderPresent
+};
+
+/** @brief Values plotted over time in the trace. */
+enum class ProfileCounter : uint8_t {
+	FrameTime,
+	DeltaQueue,
+	AllocatedBytes,
+
+	FIRST = FrameTime,
+	LAST = AllocatedBytes
+};
+
+/** @brief Time spent in each phase during a frame, in microseconds. */
+using FrameProfile = std::array<uint32_t, enum_size<ProfilePhase>::value>;
+
+const char *ProfilePhaseName(ProfilePhase phase);
+const char *ProfileCounterName(ProfileCounter counter);
+
+bool IsProfilerEnabled();
+
+/** @brief Start or stop recording, starting clears the previous recording. */
+void SetProfilerEnabled(bool enabled);
+
+/**
+ * @brief Measures the time until the end of the scope and adds it to the current frame.
+ */
+class ProfileScope {
+public:
+	explicit ProfileScope(ProfilePhase phase);
+	/**
+	 * @brief A zone that is only recorded in the trace, it may overlap the phases or run on another thread.
+	 * @param zone Name shown in the trace, must outlive the recording
+	 */
+	explicit ProfileScope(const char *zone);
+	~ProfileScope();
+
+	ProfileScope(const ProfileScope &) = delete;
+	ProfileScope &operator=(const ProfileScope &) = delete;
+
+private:
+	const char *name_;
+	/** Index into the frame profile, -1 for zones */
+	int phase_;
+	int64_t start_;
+};
+
+/** @brief Record the current value of a counter, can be called from any thread. */
+void ProfilerSetCounter(ProfileCounter counter, int64_t value);
+
+/** @brief Close the current frame and move on to the next. */
+void ProfilerEndFrame();
+
+/** @brief Timings of the last completed frame. */
+const FrameProfile &ProfilerLastFrame();
+
+/**
+ * @brief Write the recorded frames, one line per frame with the time of each phase in milliseconds.
+ * @return false if the file couldn't be written
+ */
+bool ProfilerWriteCsv(const std::string &path);
+
+/**
+ * @brief Write the recorded scopes in the Chrome trace event format (chrome://tracing, Perfetto).
+ * @return false if the file couldn't be written
+ */
+bool ProfilerWriteChromeTrace(const std::string &path);
+
+} // namespace devilution
@@ -0,0 +1,250 @@
+#include "utils/read_ahead_rw.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <memory>
+
+#include "appfat.h"
+#include "utils/log.hpp"
+#include "utils/thread.h"
+
+namespace devilution {
+
+namespace {
+
+/** About 3 seconds of 22 kHz 16-bit stereo audio */
+constexpr size_t ReadAheadBufferSize = 256 * 1024;
+/** The most that is read from the source at once */
+constexpr size_t ReadAheadChunkSize = 16 * 1024;
+
+/** Created together with the thread by ReadAheadRw_Create */
+SDL_mutex *ReadAheadMutex;
+SDL_cond *DataReady;
+SDL_cond *SpaceFree;
+SDL_Thread *ReadAheadThread;
+SDL_threadID ReadAheadThreadId;
+
+SDL_RWops *Source;
+Sint64 SourceSize;
+std::unique_ptr<std::uint8_t[]> Buffer;
+/** Offset of the next byte to hand out in Buffer */
+size_t ReadPos;
+/** The number of buffered bytes starting at ReadPos */
+size_t Filled;
+/** Position in the source of the byte at ReadPos */
+Sint64 Position;
+/** Set when the thread has read everything up to the end of the source */
+bool Eof;
+bool Quit;
+/** Changed by every seek that drops the buffer, so that reads started before it are discarded */
+uint32_t Generation;
+uint32_t Underruns;
+std::atomic<uint32_t> TotalUnderruns;
+
+unsigned int ReadAheadHandler(void * /*data*/)
+{
+	Sint64 sourcePos = 0;
+
+	SDL_LockMutex(ReadAheadMutex);
+	while (!Quit) {
+		const size_t space = ReadAheadBufferSize - Filled;
+		if (Eof || space == 0) {
+			SDL_CondWait(SpaceFree, ReadAheadMutex);
+			continue;
+		}
+
+		const uint32_t generation = Generation;
+		const Sint64 fillPos = Position + static_cast<Sint64>(Filled);
+		const size_t writePos = (ReadPos + Filled) % ReadAheadBufferSize;
+		const size_t length = std::min({ space, ReadAheadBufferSize - writePos, ReadAheadChunkSize });
+		SDL_UnlockMutex(ReadAheadMutex);
+
+		// Only this thread writes to the free part of the buffer, so it is filled without holding the lock
+		if (sourcePos != fillPos)
+			sourcePos = SDL_RWseek(Source, fillPos, RW_SEEK_SET);
+		size_t numRead = 0;
+		if (sourcePos == fillPos)
+			numRead = SDL_RWread(Source, &Buffer[writePos], 1, length);
+		sourcePos = numRead != 0 ? fillPos + static_cast<Sint64>(numRead) : -1;
+
+		SDL_LockMutex(ReadAheadMutex);
+		if (generation != Generation)
+			continue;
+		Filled += numRead;
+		if (numRead == 0)
+			Eof = true;
+		SDL_CondSignal(DataReady);
+	}
+	SDL_UnlockMutex(ReadAheadMutex);
+
+	return 0;
+}
+
+#ifndef USE_SDL1
+Sint64 ReadAheadRwSize(struct SDL_RWops * /*context*/)
+{
+	return SourceSize;
+}
+#endif
+
+#ifndef USE_SDL1
+Sint64 ReadAheadRwSeek(struct SDL_RWops * /*context*/, Sint64 offset, int whence)
+#else
+int ReadAheadRwSeek(struct SDL_RWops * /*context*/, int offset, int whence)
+#endif
+{
+	SDL_LockMutex(ReadAheadMutex);
+	Sint64 target;
+	switch (whence) {
+	case RW_SEEK_SET:
+		target = offset;
+		break;
+	case RW_SEEK_CUR:
+		target = Position + offset;
+		break;
+	case RW_SEEK_END:
+		target = SourceSize + offset;
+		break;
+	default:
+		target = -1;
+		break;
+	}
+	if (target < 0) {
+		SDL_UnlockMutex(ReadAheadMutex);
+		return -1;
+	}
+
+	if (target >= Position && target <= Position + static_cast<Sint64>(Filled)) {
+		// Skipping ahead within the buffered data
+		const auto skip = static_cast<size_t>(target - Position);
+		ReadPos = (ReadPos + skip) % ReadAheadBufferSize;
+		Filled -= skip;
+	} else {
+		ReadPos = 0;
+		Filled = 0;
+		Eof = false;
+		Generation++;
+	}
+	Position = target;
+	SDL_CondSignal(SpaceFree);
+	SDL_UnlockMutex(ReadAheadMutex);
+
+	return target;
+}
+
+#ifndef USE_SDL1
+size_t ReadAheadRwRead(struct SDL_RWops * /*context*/, void *ptr, size_t size, size_t maxnum)
+#else
+int ReadAheadRwRead(struct SDL_RWops * /*context*/, void *ptr, int size, int maxnum)
+#endif
+{
+	if (size == 0)
+		return 0;
+
+	auto *out = static_cast<std::uint8_t *>(ptr);
+	const size_t total = static_cast<size_t>(size) * maxnum;
+	size_t copied = 0;
+
+	SDL_LockMutex(ReadAheadMutex);
+	while (copied < total) {
+		if (Filled == 0) {
+			if (Eof)
+				break;
+			Underruns++;
+			TotalUnderruns++;
+			SDL_CondWait(DataReady, ReadAheadMutex);
+			continue;
+		}
+
+		const size_t length = std::min({ Filled, total - copied, ReadAheadBufferSize - ReadPos });
+		memcpy(out + copied, &Buffer[ReadPos], length);
+		copied += length;
+		ReadPos = (ReadPos + length) % ReadAheadBufferSize;
+		Filled -= length;
+		Position += length;
+		SDL_CondSignal(SpaceFree);
+	}
+	SDL_UnlockMutex(ReadAheadMutex);
+
+	return copied / size;
+}
+
+int ReadAheadRwClose(struct SDL_RWops *context)
+{
+	SDL_LockMutex(ReadAheadMutex);
+	Quit = true;
+	SDL_CondSignal(SpaceFree);
+	SDL_UnlockMutex(ReadAheadMutex);
+	SDL_WaitThread(ReadAheadThread, nullptr);
+	ReadAheadThread = nullptr;
+
+	if (Underruns != 0)
+		LogVerbose("Read-ahead buffer ran empty {} times", Underruns);
+
+	SDL_RWclose(Source);
+	Source = nullptr;
+	Buffer = nullptr;
+	SDL_DestroyCond(SpaceFree);
+	SDL_DestroyCond(DataReady);
+	SDL_DestroyMutex(ReadAheadMutex);
+	SpaceFree = nullptr;
+	DataReady = nullptr;
+	ReadAheadMutex = nullptr;
+	delete context;
+	return 0;
+}
+
+} // namespace
+
+SDL_RWops *ReadAheadRw_Create(SDL_RWops *source)
+{
+	if (ReadAheadThread != nullptr)
+		return nullptr;
+
+	Source = source;
+#ifndef USE_SDL1
+	SourceSize = SDL_RWsize(source);
+#else
+	const int start = SDL_RWseek(source, 0, RW_SEEK_CUR);
+	SourceSize = SDL_RWseek(source, 0, RW_SEEK_END);
+	SDL_RWseek(source, start, RW_SEEK_SET);
+#endif
+	Buffer = std::make_unique<std::uint8_t[]>(ReadAheadBufferSize);
+	ReadPos = 0;
+	Filled = 0;
+	Position = SDL_RWseek(source, 0, RW_SEEK_CUR);
+	Eof = false;
+	Quit = false;
+	Underruns = 0;
+
+	ReadAheadMutex = SDL_CreateMutex();
+	DataReady = SDL_CreateCond();
+	SpaceFree = SDL_CreateCond();
+	if (ReadAheadMutex == nullptr || DataReady == nullptr || SpaceFree == nullptr)
+		ErrSdl();
+	ReadAheadThread = CreateThread(ReadAheadHandler, &ReadAheadThreadId);
+
+	SDL_RWops *result = new SDL_RWops();
+	std::memset(result, 0, sizeof(*result));
+
+#ifndef USE_SDL1
+	result->size = &ReadAheadRwSize;
+	result->type = SDL_RWOPS_UNKNOWN;
+#else
+	result->type = 0;
+#endif
+
+	result->seek = &ReadAheadRwSeek;
+	result->read = &ReadAheadRwRead;
+	result->write = nullptr;
+	result->close = &ReadAheadRwClose;
+	return result;
+}
+
+std::uint32_t ReadAheadRw_GetUnderruns()
+{
+	return TotalUnderruns;
+}
+
+} // namespace devilution
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <cstdint>
+
+#include <SDL.h>
+
+namespace devilution {
+
+/**
+ * @brief Wraps a read-only SDL_RWops so that reads are served from a buffer a background thread keeps filled.
+ *
+ * Only one of these can be open at a time. Closes the source when it gets closed.
+ * @return nullptr if one is already open
+ */
+SDL_RWops *ReadAheadRw_Create(SDL_RWops *source);
+
+/**
+ * @brief The number of reads that had to wait for the background thread, since startup.
+ */
+std::uint32_t ReadAheadRw_GetUnderruns();
+
+} // namespace devilution
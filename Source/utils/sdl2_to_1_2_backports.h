@@ -307,6 +307,19 @@ int SDL_SoftStretch(SDL_Surface *src, const SDL_Rect *srcrect,
 int SDL_BlitScaled(SDL_Surface *src, SDL_Rect *srcrect,
     SDL_Surface *dst, SDL_Rect *dstrect);
 
+//== Timer
+
+// SDL1 has no high-resolution counter, fall back to the millisecond ticks
+inline Uint64 SDL_GetPerformanceCounter()
+{
+	return SDL_GetTicks();
+}
+
+inline Uint64 SDL_GetPerformanceFrequency()
+{
+	return 1000;
+}
+
 //== Filesystem
 
 char *SDL_GetBasePath();
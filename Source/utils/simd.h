@@ -0,0 +1,44 @@
+/**
+ * @file simd.h
+ *
+ * Selects the vector instructions the render kernels are built with.
+ *
+ * The choice is made from the compile target: NEON on ARM, SSE2 on x86-64 and x86 with SSE2,
+ * and AVX2 on top of SSE2 when the compiler targets it. Defining DISABLE_SIMD builds the scalar
+ * code everywhere, to compare against it or to rule out a vector kernel when chasing a bug.
+ */
+#pragma once
+
+#ifndef DISABLE_SIMD
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#define DVL_SIMD_NEON
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define DVL_SIMD_SSE2
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define DVL_SIMD_AVX2
+#endif
+#endif
+#endif
+
+namespace devilution {
+
+/**
+ * @brief Name of the widest vector instructions in use, for the log and the profiler overlay
+ */
+constexpr const char *SimdName()
+{
+#if defined(DVL_SIMD_AVX2)
+	return "AVX2";
+#elif defined(DVL_SIMD_SSE2)
+	return "SSE2";
+#elif defined(DVL_SIMD_NEON)
+	return "NEON";
+#else
+	return "scalar";
+#endif
+}
+
+} // namespace devilution
@@ -1,26 +1,52 @@
 #include "utils/soundsample.h"
 
+#include <algorithm>
+#include <atomic>
 #include <cmath>
 #include <chrono>
+#include <cstring>
+#include <vector>
 
 #include <Aulib/DecoderDrwav.h>
 #include <Aulib/ResamplerSpeex.h>
 #include <SDL.h>
+#include <aulib.h>
 #ifdef USE_SDL1
 #include "utils/sdl2_to_1_2_backports.h"
 #else
 #include "utils/sdl2_backports.h"
 #endif
 
+#include "appfat.h"
 #include "options.h"
 #include "storm/storm_sdl_rw.h"
 #include "storm/storm.h"
 #include "utils/log.hpp"
 #include "utils/math.h"
+#include "utils/profiler.h"
 #include "utils/stubs.h"
+#include "utils/thread.h"
 
 namespace devilution {
 
+struct SoundSample::StreamState {
+	StreamState(SDL_RWops *rwops, std::unique_ptr<Aulib::Decoder> decoder, std::unique_ptr<Aulib::Resampler> resampler)
+	    : stream(rwops, std::move(decoder), std::move(resampler), /*closeRw=*/true)
+	{
+	}
+
+	Aulib::Stream stream;
+	/** Set when playing is requested, cleared when the sound is stopped or finishes */
+	std::atomic<bool> playing { false };
+	/** Counts the play requests, so the end of an earlier playback can't clear playing for a newer one */
+	std::atomic<uint32_t> playGeneration { 0 };
+	/** Only touched by the mixer thread */
+	bool finishCallbackSet = false;
+	/** Play request the stream was last started for, only touched by the mixer thread */
+	uint32_t activeGeneration = 0;
+	Aulib::Stream::Callback finishCallback;
+};
+
 namespace {
 
 constexpr float LogBase = 10.0f;
@@ -56,8 +82,228 @@ float PanLogToLinear(int logPan)
 	return copysign(1.0f - factor, static_cast<float>(logPan));
 }
 
+#ifndef STREAM_ALL_AUDIO
+/**
+ * @brief Reads interleaved float samples that are already at the output sample rate.
+ */
+class DecoderPcm final : public Aulib::Decoder {
+public:
+	explicit DecoderPcm(int channels)
+	    : channels_(channels)
+	{
+	}
+
+	bool open(SDL_RWops *rwops) override
+	{
+		if (isOpen())
+			return true;
+		rwops_ = rwops;
+		frames_ = SDL_RWsize(rwops) / (sizeof(float) * channels_);
+		setIsOpen(true);
+		return true;
+	}
+
+	int getChannels() const override
+	{
+		return channels_;
+	}
+
+	int getRate() const override
+	{
+		return Aulib::sampleRate();
+	}
+
+	bool rewind() override
+	{
+		return SDL_RWseek(rwops_, 0, RW_SEEK_SET) == 0;
+	}
+
+	std::chrono::microseconds duration() const override
+	{
+		return std::chrono::microseconds(frames_ * 1000000 / Aulib::sampleRate());
+	}
+
+	bool seekToTime(std::chrono::microseconds pos) override
+	{
+		const Sint64 frame = std::min<Sint64>(pos.count() * Aulib::sampleRate() / 1000000, frames_);
+		return SDL_RWseek(rwops_, frame * sizeof(float) * channels_, RW_SEEK_SET) >= 0;
+	}
+
+protected:
+	int doDecoding(float buf[], int len, bool &callAgain) override
+	{
+		callAgain = false;
+		return static_cast<int>(SDL_RWread(rwops_, buf, sizeof(float), len));
+	}
+
+private:
+	SDL_RWops *rwops_ = nullptr;
+	int channels_;
+	Sint64 frames_ = 0;
+};
+
+/**
+ * @brief Decodes a WAV file and resamples it to the output sample rate.
+ * @param[out] channels The channel count of the samples
+ * @return Interleaved float samples, empty on failure
+ */
+std::vector<float> ResampleToOutputRate(const std::uint8_t *fileData, std::size_t dwBytes, int &channels)
+{
+	std::vector<float> samples;
+	SDL_RWops *rw = SDL_RWFromConstMem(fileData, dwBytes);
+	if (rw == nullptr)
+		return samples;
+
+	auto decoder = std::make_shared<Aulib::DecoderDrwav>();
+	if (decoder->open(rw)) {
+		channels = decoder->getChannels();
+		const int outputRate = Aulib::sampleRate();
+		samples.reserve((decoder->duration().count() * outputRate / 1000000 + 1) * channels);
+
+		Aulib::ResamplerSpeex resampler(sgOptions.Audio.nResamplingQuality);
+		resampler.setDecoder(decoder);
+		resampler.setSpec(outputRate, channels, Aulib::frameSize());
+		std::vector<float> chunk(Aulib::frameSize() * channels);
+		int count;
+		while ((count = resampler.resample(chunk.data(), static_cast<int>(chunk.size()))) > 0)
+			samples.insert(samples.end(), chunk.begin(), chunk.begin() + count);
+	}
+	SDL_RWclose(rw);
+	return samples;
+}
+#endif
+
+enum class MixerRequestType : uint8_t {
+	Play,
+	Stop,
+};
+
+struct MixerRequest {
+	std::shared_ptr<SoundSample::StreamState> state;
+	MixerRequestType type;
+	float volume;
+	float pan;
+	/** The play request this was posted after */
+	uint32_t generation;
+};
+
+SDL_mutex *MixerMutex;
+SDL_cond *MixerWorkToDo;
+SDL_Thread *MixerThread;
+SDL_threadID MixerThreadId;
+bool MixerQuit;
+std::vector<MixerRequest> MixerQueue;
+
+void ApplyMixerRequest(const MixerRequest &request)
+{
+	SoundSample::StreamState &state = *request.state;
+	switch (request.type) {
+	case MixerRequestType::Play:
+		if (!state.finishCallbackSet) {
+			state.stream.setFinishCallback([&state](Aulib::Stream &stream) {
+				// Play has been called again since, the sound is still meant to be playing
+				if (state.playGeneration.load(std::memory_order_acquire) == state.activeGeneration)
+					state.playing.store(false, std::memory_order_release);
+				if (state.finishCallback)
+					state.finishCallback(stream);
+			});
+			state.finishCallbackSet = true;
+		}
+		state.activeGeneration = request.generation;
+		state.stream.setVolume(request.volume);
+		state.stream.setStereoPosition(request.pan);
+		if (!state.stream.play()) {
+			if (state.playGeneration.load(std::memory_order_acquire) == request.generation)
+				state.playing.store(false, std::memory_order_release);
+			LogError(LogCategory::Audio, "Aulib::Stream::play (from SoundSample::Play): {}", SDL_GetError());
+		}
+		break;
+	case MixerRequestType::Stop:
+		state.stream.stop();
+		break;
+	}
+}
+
+void PostMixerRequest(MixerRequest &&request)
+{
+	if (MixerThread == nullptr) {
+		ApplyMixerRequest(request);
+		return;
+	}
+
+	SDL_LockMutex(MixerMutex);
+	MixerQueue.push_back(std::move(request));
+	if (MixerQueue.size() == 1)
+		SDL_CondSignal(MixerWorkToDo);
+	SDL_UnlockMutex(MixerMutex);
+}
+
+unsigned int MixerHandler(void * /*data*/)
+{
+	std::vector<MixerRequest> batch;
+
+	SDL_LockMutex(MixerMutex);
+	while (true) {
+		if (MixerQueue.empty()) {
+			if (MixerQuit)
+				break;
+			SDL_CondWait(MixerWorkToDo, MixerMutex);
+			continue;
+		}
+
+		batch.swap(MixerQueue);
+		SDL_UnlockMutex(MixerMutex);
+
+		// Everything requested since the last batch reaches the same audio buffer and the mixer is only locked once
+		{
+			ProfileScope profileScope("MixerBatch");
+			SDL_LockAudio();
+			for (const MixerRequest &request : batch)
+				ApplyMixerRequest(request);
+			SDL_UnlockAudio();
+		}
+		batch.clear();
+
+		SDL_LockMutex(MixerMutex);
+	}
+	SDL_UnlockMutex(MixerMutex);
+
+	return 0;
+}
+
 } // namespace
 
+void StartSoundMixerThread()
+{
+	if (MixerThread != nullptr)
+		return;
+
+	MixerMutex = SDL_CreateMutex();
+	MixerWorkToDo = SDL_CreateCond();
+	if (MixerMutex == nullptr || MixerWorkToDo == nullptr)
+		ErrSdl();
+	MixerQuit = false;
+	MixerThread = CreateThread(MixerHandler, &MixerThreadId);
+}
+
+void StopSoundMixerThread()
+{
+	if (MixerThread == nullptr)
+		return;
+
+	SDL_LockMutex(MixerMutex);
+	MixerQuit = true;
+	SDL_CondSignal(MixerWorkToDo);
+	SDL_UnlockMutex(MixerMutex);
+	SDL_WaitThread(MixerThread, nullptr);
+	MixerThread = nullptr;
+
+	SDL_DestroyCond(MixerWorkToDo);
+	SDL_DestroyMutex(MixerMutex);
+	MixerWorkToDo = nullptr;
+	MixerMutex = nullptr;
+}
+
 float VolumeLogToLinear(int logVolume, int logMin, int logMax)
 {
 	const float logScaled = math::Remap<float>(logMin, logMax, MillibelMin, MillibelMax, logVolume);
@@ -73,6 +319,7 @@ void SoundSample::Release()
 #ifndef STREAM_ALL_AUDIO
 	file_data_ = nullptr;
 	file_data_size_ = 0;
+	pcm_channels_ = 0;
 #endif
 };
 
@@ -81,7 +328,7 @@ void SoundSample::Release()
  */
 bool SoundSample::IsPlaying()
 {
-	return stream_ && stream_->isPlaying();
+	return stream_ && stream_->playing.load(std::memory_order_acquire);
 };
 
 /**
@@ -94,15 +341,11 @@ void SoundSample::Play(int logSoundVolume, int logUserVolume, int logPan, int ch
 
 	const int combinedLogVolume = logSoundVolume + logUserVolume * (ATTENUATION_MIN / VOLUME_MIN);
 	const float linearVolume = VolumeLogToLinear(combinedLogVolume, ATTENUATION_MIN, 0);
-	stream_->setVolume(linearVolume);
-
 	const float linearPan = PanLogToLinear(logPan);
-	stream_->setStereoPosition(linearPan);
 
-	if (!stream_->play()) {
-		LogError(LogCategory::Audio, "Aulib::Stream::play (from SoundSample::Play): {}", SDL_GetError());
-		return;
-	}
+	const uint32_t generation = stream_->playGeneration.fetch_add(1, std::memory_order_acq_rel) + 1;
+	stream_->playing.store(true, std::memory_order_release);
+	PostMixerRequest({ stream_, MixerRequestType::Play, linearVolume, linearPan, generation });
 };
 
 /**
@@ -110,10 +353,17 @@ void SoundSample::Play(int logSoundVolume, int logUserVolume, int logPan, int ch
  */
 void SoundSample::Stop()
 {
-	if (stream_)
-		stream_->stop();
+	if (!stream_ || !stream_->playing.exchange(false, std::memory_order_acq_rel))
+		return;
+
+	PostMixerRequest({ stream_, MixerRequestType::Stop, 0, 0, stream_->playGeneration.load(std::memory_order_acquire) });
 };
 
+void SoundSample::SetFinishCallback(Aulib::Stream::Callback &&callback)
+{
+	stream_->finishCallback = std::move(callback);
+}
+
 int SoundSample::SetChunkStream(std::string filePath)
 {
 	file_path_ = std::move(filePath);
@@ -123,9 +373,9 @@ int SoundSample::SetChunkStream(std::string filePath)
 		return -1;
 	}
 
-	stream_ = std::make_unique<Aulib::Stream>(SFileRw_FromStormHandle(handle), std::make_unique<Aulib::DecoderDrwav>(),
-	    std::make_unique<Aulib::ResamplerSpeex>(sgOptions.Audio.nResamplingQuality), /*closeRw=*/true);
-	if (!stream_->open()) {
+	stream_ = std::make_shared<StreamState>(SFileRw_FromStormHandle(handle), std::make_unique<Aulib::DecoderDrwav>(),
+	    std::make_unique<Aulib::ResamplerSpeex>(sgOptions.Audio.nResamplingQuality));
+	if (!stream_->stream.open()) {
 		stream_ = nullptr;
 		LogError(LogCategory::Audio, "Aulib::Stream::open (from SoundSample::SetChunkStream): {}", SDL_GetError());
 		return -1;
@@ -136,16 +386,29 @@ int SoundSample::SetChunkStream(std::string filePath)
 #ifndef STREAM_ALL_AUDIO
 int SoundSample::SetChunk(ArraySharedPtr<std::uint8_t> fileData, std::size_t dwBytes)
 {
+	if (sgOptions.Audio.bResampleOnLoad) {
+		int channels;
+		std::vector<float> samples = ResampleToOutputRate(fileData.get(), dwBytes, channels);
+		if (!samples.empty()) {
+			const std::size_t pcmSize = samples.size() * sizeof(float);
+			ArraySharedPtr<std::uint8_t> pcmData = MakeArraySharedPtr<std::uint8_t>(pcmSize);
+			memcpy(pcmData.get(), samples.data(), pcmSize);
+			return SetPcm(std::move(pcmData), pcmSize, channels);
+		}
+		LogVerbose(LogCategory::Audio, "Unable to resample a sound when loading it, it will be resampled while playing");
+	}
+
 	file_data_ = fileData;
 	file_data_size_ = dwBytes;
+	pcm_channels_ = 0;
 	SDL_RWops *buf = SDL_RWFromConstMem(file_data_.get(), dwBytes);
 	if (buf == nullptr) {
 		return -1;
 	}
 
-	stream_ = std::make_unique<Aulib::Stream>(buf, std::make_unique<Aulib::DecoderDrwav>(),
-	    std::make_unique<Aulib::ResamplerSpeex>(sgOptions.Audio.nResamplingQuality), /*closeRw=*/true);
-	if (!stream_->open()) {
+	stream_ = std::make_shared<StreamState>(buf, std::make_unique<Aulib::DecoderDrwav>(),
+	    std::make_unique<Aulib::ResamplerSpeex>(sgOptions.Audio.nResamplingQuality));
+	if (!stream_->stream.open()) {
 		stream_ = nullptr;
 		file_data_ = nullptr;
 		LogError(LogCategory::Audio, "Aulib::Stream::open (from SoundSample::SetChunk): {}", SDL_GetError());
@@ -154,6 +417,29 @@ int SoundSample::SetChunk(ArraySharedPtr<std::uint8_t> fileData, std::size_t dwB
 
 	return 0;
 };
+
+int SoundSample::SetPcm(ArraySharedPtr<std::uint8_t> pcmData, std::size_t dwBytes, int channels)
+{
+	file_data_ = std::move(pcmData);
+	file_data_size_ = dwBytes;
+	pcm_channels_ = channels;
+	SDL_RWops *buf = SDL_RWFromConstMem(file_data_.get(), dwBytes);
+	if (buf == nullptr) {
+		return -1;
+	}
+
+	// The samples are already at the output rate, so the stream mixes them as they are
+	stream_ = std::make_shared<StreamState>(buf, std::make_unique<DecoderPcm>(channels), nullptr);
+	if (!stream_->stream.open()) {
+		stream_ = nullptr;
+		file_data_ = nullptr;
+		pcm_channels_ = 0;
+		LogError(LogCategory::Audio, "Aulib::Stream::open (from SoundSample::SetPcm): {}", SDL_GetError());
+		return -1;
+	}
+
+	return 0;
+}
 #endif
 
 /**
@@ -163,7 +449,7 @@ int SoundSample::GetLength() const
 {
 	if (!stream_)
 		return 0;
-	return std::chrono::duration_cast<std::chrono::milliseconds>(stream_->duration()).count();
+	return std::chrono::duration_cast<std::chrono::milliseconds>(stream_->stream.duration()).count();
 };
 
 } // namespace devilution
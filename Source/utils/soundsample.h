@@ -19,8 +19,23 @@ namespace devilution {
 */
 float VolumeLogToLinear(int logVolume, int logMin, int logMax);
 
+/**
+ * @brief Starts the thread that applies play and stop requests to the mixer.
+ *
+ * Until it runs the requests are applied right away on the calling thread.
+ */
+void StartSoundMixerThread();
+
+/**
+ * @brief Applies the pending requests and stops the mixer thread.
+ */
+void StopSoundMixerThread();
+
 class SoundSample final {
 public:
+	/** @brief The stream together with the playback state the game thread reads without locking the mixer. */
+	struct StreamState;
+
 	SoundSample() = default;
 	SoundSample(SoundSample &&) noexcept = default;
 	SoundSample &operator=(SoundSample &&) noexcept = default;
@@ -31,10 +46,12 @@ public:
 	void Stop();
 	int SetChunkStream(std::string filePath);
 
-	void SetFinishCallback(Aulib::Stream::Callback &&callback)
-	{
-		stream_->setFinishCallback(std::forward<Aulib::Stream::Callback>(callback));
-	}
+	/**
+	 * @brief Sets the function the mixer thread calls when the sound stops playing.
+	 *
+	 * Must be set before the sound is played for the first time.
+	 */
+	void SetFinishCallback(Aulib::Stream::Callback &&callback);
 
 #ifndef STREAM_ALL_AUDIO
 	/**
@@ -60,23 +77,47 @@ public:
 #else
 		if (other.IsStreaming())
 			return SetChunkStream(other.file_path_);
+		if (other.pcm_channels_ != 0)
+			return SetPcm(other.file_data_, other.file_data_size_, other.pcm_channels_);
 		return SetChunk(other.file_data_, other.file_data_size_);
 #endif
 	}
 
 	int GetLength() const;
 
+	/** @return The size of the loaded file, 0 for streamed sounds */
+	[[nodiscard]] std::size_t GetDataSize() const
+	{
+#ifndef STREAM_ALL_AUDIO
+		return file_data_ != nullptr ? file_data_size_ : 0;
+#else
+		return 0;
+#endif
+	}
+
 private:
 #ifndef STREAM_ALL_AUDIO
+	/**
+	 * @brief Plays float samples that are already at the output sample rate, skipping the resampler.
+	 * @param pcmData Interleaved float samples
+	 * @param dwBytes Length of buffer
+	 * @param channels Number of interleaved channels
+	 * @return 0 on success, -1 otherwise
+	 */
+	int SetPcm(ArraySharedPtr<std::uint8_t> pcmData, std::size_t dwBytes, int channels);
+
 	// Non-streaming audio fields:
 	ArraySharedPtr<std::uint8_t> file_data_;
 	std::size_t file_data_size_;
+	/** @brief The channel count when file_data_ holds resampled float samples rather than a WAV file, 0 otherwise. */
+	int pcm_channels_ = 0;
 #endif
 
 	// Set for streaming audio to allow for duplicating it:
 	std::string file_path_;
 
-	std::unique_ptr<Aulib::Stream> stream_;
+	/** Shared with the queued mixer requests so that the stream outlives them. */
+	std::shared_ptr<StreamState> stream_;
 };
 
 } // namespace devilution
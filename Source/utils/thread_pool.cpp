@@ -0,0 +1,94 @@
+#include "utils/thread_pool.h"
+
+#include "appfat.h"
+
+namespace devilution {
+
+ThreadPool::ThreadPool(unsigned workers)
+    : mutex_(SDL_CreateMutex())
+    , workAvailable_(SDL_CreateCond())
+    , workDone_(SDL_CreateCond())
+{
+	if (mutex_ == nullptr || workAvailable_ == nullptr || workDone_ == nullptr)
+		ErrSdl();
+
+	threads_.reserve(workers);
+	for (unsigned i = 0; i < workers; i++) {
+#ifdef USE_SDL1
+		SDL_Thread *thread = SDL_CreateThread(WorkerMain, this);
+#else
+		SDL_Thread *thread = SDL_CreateThread(WorkerMain, "worker", this);
+#endif
+		if (thread == nullptr)
+			ErrSdl();
+		threads_.push_back(thread);
+	}
+}
+
+ThreadPool::~ThreadPool()
+{
+	SDL_LockMutex(mutex_);
+	quit_ = true;
+	SDL_CondBroadcast(workAvailable_);
+	SDL_UnlockMutex(mutex_);
+
+	for (SDL_Thread *thread : threads_)
+		SDL_WaitThread(thread, nullptr);
+
+	SDL_DestroyCond(workDone_);
+	SDL_DestroyCond(workAvailable_);
+	SDL_DestroyMutex(mutex_);
+}
+
+void ThreadPool::ParallelFor(unsigned count, const std::function<void(unsigned)> &job)
+{
+	if (threads_.empty() || count <= 1) {
+		for (unsigned i = 0; i < count; i++)
+			job(i);
+		return;
+	}
+
+	SDL_LockMutex(mutex_);
+	job_ = &job;
+	next_ = 0;
+	count_ = count;
+	pending_ = count;
+	SDL_CondBroadcast(workAvailable_);
+
+	RunJobs();
+	while (pending_ != 0)
+		SDL_CondWait(workDone_, mutex_);
+
+	job_ = nullptr;
+	count_ = 0;
+	SDL_UnlockMutex(mutex_);
+}
+
+void ThreadPool::RunJobs()
+{
+	while (next_ < count_) {
+		const unsigned i = next_++;
+		const std::function<void(unsigned)> &job = *job_;
+		SDL_UnlockMutex(mutex_);
+		job(i);
+		SDL_LockMutex(mutex_);
+		if (--pending_ == 0)
+			SDL_CondSignal(workDone_);
+	}
+}
+
+int SDLCALL ThreadPool::WorkerMain(void *data)
+{
+	auto &pool = *static_cast<ThreadPool *>(data);
+
+	SDL_LockMutex(pool.mutex_);
+	while (!pool.quit_) {
+		pool.RunJobs();
+		SDL_CondWait(pool.workAvailable_, pool.mutex_);
+	}
+	SDL_UnlockMutex(pool.mutex_);
+
+	return 0;
+}
+
+} // namespace devilution
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <functional>
+#include <vector>
+
+#include <SDL.h>
+
+#ifdef USE_SDL1
+#include "utils/sdl2_to_1_2_backports.h"
+#endif
+
+namespace devilution {
+
+/**
+ * @brief A fixed set of worker threads for splitting a loop across cores.
+ *
+ * The calling thread takes part in the work, so a pool with N workers runs N + 1 jobs at a time.
+ */
+class ThreadPool {
+public:
+	explicit ThreadPool(unsigned workers);
+	~ThreadPool();
+
+	ThreadPool(const ThreadPool &) = delete;
+	ThreadPool &operator=(const ThreadPool &) = delete;
+
+	/** @brief Number of jobs that run at the same time, including the calling thread. */
+	unsigned Concurrency() const
+	{
+		return static_cast<unsigned>(threads_.size()) + 1;
+	}
+
+	/**
+	 * @brief Calls job(i) for every i in [0, count) and returns once all of them finished.
+	 *
+	 * Must not be called recursively from within a job.
+	 */
+	void ParallelFor(unsigned count, const std::function<void(unsigned)> &job);
+
+private:
+	static int SDLCALL WorkerMain(void *data);
+
+	/** @brief Run jobs of the current batch until there are none left. Expects mutex_ to be locked. */
+	void RunJobs();
+
+	std::vector<SDL_Thread *> threads_;
+	SDL_mutex *mutex_;
+	SDL_cond *workAvailable_;
+	SDL_cond *workDone_;
+	const std::function<void(unsigned)> *job_ = nullptr;
+	unsigned next_ = 0;
+	unsigned count_ = 0;
+	unsigned pending_ = 0;
+	bool quit_ = false;
+};
+
+} // namespace devilution
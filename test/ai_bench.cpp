@@ -0,0 +1,312 @@
+/**
+ * Lets monsters of each AI type hunt the players on generated levels and reports what the AI cost.
+ *
+ * Usage: devilutionx_ai_bench [--data-dir <folder of diabdat.mpq>] [--seeds <count>] [--ticks <count>]
+ *                             [--monsters <count>] [--players <count>]
+ *
+ * Every scene loads a level from a fixed seed, puts `--monsters` monsters of one of the level's
+ * monster types around the players and runs ProcessMonsters and ProcessMissiles for `--ticks`
+ * ticks. The results are grouped by the AI of the monster type.
+ */
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "bench_util.h"
+#include "diablo.h"
+#include "gendung.h"
+#include "init.h"
+#include "lighting.h"
+#include "loadsave.h"
+#include "missiles.h"
+#include "monster.h"
+#include "multi.h"
+#include "path.h"
+#include "player.h"
+#include "portal.h"
+#include "quests.h"
+
+using namespace devilution;
+
+namespace {
+
+int SeedCount = 5;
+int TickCount = 500;
+int MonsterCount = 50;
+int PlayerCount = 1;
+
+struct DungeonLevel {
+	dungeon_type type;
+	int level;
+};
+
+const DungeonLevel Levels[] = {
+	{ DTYPE_CATHEDRAL, 2 },
+	{ DTYPE_CATACOMBS, 6 },
+	{ DTYPE_CAVES, 10 },
+	{ DTYPE_HELL, 14 },
+};
+
+/** Names of _mai_id */
+const char *const AiNames[] = {
+	"Zombie",
+	"Fat",
+	"SkelSd",
+	"SkelBow",
+	"Scav",
+	"Rhino",
+	"GoatMc",
+	"GoatBow",
+	"Fallen",
+	"Magma",
+	"SkelKing",
+	"Bat",
+	"Garg",
+	"Cleaver",
+	"Succ",
+	"Sneak",
+	"Storm",
+	"Fireman",
+	"Garbud",
+	"Acid",
+	"AcidUniq",
+	"Golum",
+	"Zhar",
+	"SnotSpil",
+	"Snake",
+	"Counslr",
+	"Mega",
+	"Diablo",
+	"Lazurus",
+	"LazHelp",
+	"Lachdan",
+	"Warlord",
+	"Firebat",
+	"Torchant",
+	"HorkDmn",
+	"Lich",
+	"ArchLich",
+	"Psychorb",
+	"Necromorb",
+	"BoneDemon",
+};
+
+struct AiStats {
+	int scenes;
+	uint64_t monsterTicks;
+	double microseconds;
+	uint64_t pathSearches;
+	uint64_t pathNodes;
+	uint64_t enemyScans;
+};
+
+std::array<AiStats, sizeof(AiNames) / sizeof(AiNames[0])> Stats;
+
+/** Mirror starting a single player game and entering the level from the stairs */
+void LoadLevel(const DungeonLevel &level, uint32_t seed, bool firstLevel)
+{
+	gbIsMultiplayer = false;
+	myplr = 0;
+	sgGameInitInfo = {};
+	sgGameInitInfo.nDifficulty = DIFF_NORMAL;
+	sgGameInitInfo.nTickRate = 20;
+	gnTickDelay = 1000 / sgGameInitInfo.nTickRate;
+	for (int i = 0; i < NUMLEVELS; i++)
+		glSeedTbl[i] = 0x1000 + i;
+	glSeedTbl[level.level] = seed;
+	gnLevelTypeTbl[level.level] = level.type;
+
+	for (auto &player : plr)
+		player.Reset();
+	CreatePlayer(myplr, HeroClass::Warrior);
+
+	currlevel = level.level;
+	leveltype = level.type;
+	setlevel = false;
+	auto &myPlayer = plr[myplr];
+	myPlayer.plrlevel = currlevel;
+	myPlayer._pLvlChanging = true;
+	myPlayer._pmode = PM_NEWLVL;
+	myPlayer.plractive = true;
+	gbActivePlayers = 1;
+
+	InitLevels();
+	ResetLevelFormats();
+	InitQuests();
+	InitPortals();
+	InitDungMsgs(myPlayer);
+	LoadGameLevel(firstLevel, ENTRY_MAIN);
+
+	// Normally done by ProcessPlayers once the level is entered
+	myPlayer._pLvlChanging = false;
+	myPlayer._pmode = PM_STAND;
+}
+
+bool IsFreeTile(Point position)
+{
+	if (position.x < 16 || position.y < 16 || position.x >= MAXDUNX - 16 || position.y >= MAXDUNY - 16)
+		return false;
+	return !SolidLoc(position) && dMonster[position.x][position.y] == 0 && dPlayer[position.x][position.y] == 0
+	    && dObject[position.x][position.y] == 0;
+}
+
+/**
+ * @brief Calls place for the free tiles around the given tile, nearest first, until it returns false
+ */
+template <typename F>
+void ForFreeTilesAround(Point center, int minRadius, F &&place)
+{
+	for (int radius = minRadius; radius < 20; radius++) {
+		for (int dy = -radius; dy <= radius; dy++) {
+			for (int dx = -radius; dx <= radius; dx++) {
+				if (std::max(std::abs(dx), std::abs(dy)) != radius)
+					continue;
+				const Point position { center.x + dx, center.y + dy };
+				if (IsFreeTile(position) && !place(position))
+					return;
+			}
+		}
+	}
+}
+
+void AddPlayers()
+{
+	int pnum = 1;
+	ForFreeTilesAround(plr[myplr].position.tile, 1, [&](Point position) {
+		if (pnum >= PlayerCount)
+			return false;
+		auto &player = plr[pnum];
+		CreatePlayer(pnum, HeroClass::Warrior);
+		player.plractive = true;
+		player.plrlevel = currlevel;
+		player.position.tile = position;
+		player.position.future = position;
+		player.position.old = position;
+		player._pmode = PM_STAND;
+		InitPlayerGFX(pnum);
+		dPlayer[position.x][position.y] = pnum + 1;
+		pnum++;
+		return true;
+	});
+	gbActivePlayers = pnum;
+}
+
+/** Remove the monsters and missiles of the level, keeping the golem slots InitMonsters reserves */
+void ClearScene()
+{
+	// Otherwise every scene leaks the lights of its monsters and missiles until the light list is full
+	for (int i = 0; i < nummonsters; i++)
+		AddUnLight(monster[monstactive[i]].mlid);
+	for (int i = 0; i < nummissiles; i++)
+		AddUnLight(missile[missileactive[i]]._mlid);
+	ProcessLightList();
+
+	memset(dMonster, 0, sizeof(dMonster));
+	for (int i = 0; i < MAXMONSTERS; i++)
+		monstactive[i] = i;
+	nummonsters = MAX_PLRS;
+	InvalidateMonsterTargets();
+	InitMissiles();
+}
+
+/** @return Number of monsters that found room on the level */
+int SpawnMonsters(int mtype)
+{
+	const Point target = plr[myplr].position.tile;
+	int spawned = 0;
+	ForFreeTilesAround(target, 3, [&](Point position) {
+		if (spawned >= MonsterCount)
+			return false;
+		const int mi = AddMonster(position, DIR_S, mtype, true);
+		if (mi == -1)
+			return false;
+		// Already hunting, so the whole scene is spent on the AI instead of waiting to be seen
+		monster[mi]._msquelch = UINT8_MAX;
+		monster[mi].position.last = target;
+		spawned++;
+		return true;
+	});
+	return spawned;
+}
+
+void RunScene(int mtype)
+{
+	ClearScene();
+	const int spawned = SpawnMonsters(mtype);
+
+	const uint32_t pathSearches = gnPathSearches;
+	const uint32_t pathNodes = gnPathNodesExpanded;
+	const uint32_t enemyScans = gnEnemyScans;
+	std::chrono::duration<double, std::micro> elapsed {};
+	for (int tick = 0; tick < TickCount; tick++) {
+		// Keep the players alive, ProcessPlayers isn't run to handle their death
+		for (int pnum = 0; pnum < gbActivePlayers; pnum++)
+			plr[pnum]._pHitPoints = plr[pnum]._pMaxHP;
+
+		const auto start = std::chrono::steady_clock::now();
+		ProcessMonsters();
+		ProcessMissiles();
+		elapsed += std::chrono::steady_clock::now() - start;
+	}
+
+	AiStats &stats = Stats[Monsters[mtype].MData->mAi];
+	stats.scenes++;
+	stats.monsterTicks += static_cast<uint64_t>(spawned) * TickCount;
+	stats.microseconds += elapsed.count();
+	stats.pathSearches += gnPathSearches - pathSearches;
+	stats.pathNodes += gnPathNodesExpanded - pathNodes;
+	stats.enemyScans += gnEnemyScans - enemyScans;
+}
+
+} // namespace
+
+TEST(AiBench, Scenes)
+{
+	init_archives();
+
+	bool firstLevel = true;
+	for (const DungeonLevel &level : Levels) {
+		for (int i = 0; i < SeedCount; i++) {
+			LoadLevel(level, i * 0x9E3779B9U, firstLevel);
+			firstLevel = false;
+			AddPlayers();
+			for (auto &player : plr)
+				player._pMaxHP = player._pHitPoints = 10000 << 6;
+
+			// One scene per AI, using the first of the level's monster types that has it
+			bool seen[sizeof(AiNames) / sizeof(AiNames[0])] = {};
+			for (int mtype = 0; mtype < nummtypes; mtype++) {
+				const _mai_id ai = Monsters[mtype].MData->mAi;
+				if (ai == AI_GOLUM || seen[ai])
+					continue;
+				seen[ai] = true;
+				RunScene(mtype);
+			}
+		}
+	}
+
+	printf("%-10s %6s %12s %10s %10s %12s %10s\n", "AI", "scenes", "us/monster", "us/tick", "paths/tick", "nodes/path", "scans/tick");
+	for (std::size_t ai = 0; ai < Stats.size(); ai++) {
+		const AiStats &stats = Stats[ai];
+		if (stats.scenes == 0)
+			continue;
+		const double ticks = static_cast<double>(stats.scenes) * TickCount;
+		printf("%-10s %6d %12.3f %10.1f %10.2f %12.1f %10.2f\n", AiNames[ai], stats.scenes,
+		    stats.monsterTicks != 0 ? stats.microseconds / stats.monsterTicks : 0.0,
+		    stats.microseconds / ticks, stats.pathSearches / ticks,
+		    stats.pathSearches != 0 ? static_cast<double>(stats.pathNodes) / stats.pathSearches : 0.0,
+		    stats.enemyScans / ticks);
+	}
+}
+
+int main(int argc, char **argv)
+{
+	return RunBenchmarks(argc, argv,
+	    { IntOption("--seeds", SeedCount), IntOption("--ticks", TickCount), IntOption("--monsters", MonsterCount),
+	        IntOption("--players", PlayerCount, 1, MAX_PLRS) });
+}
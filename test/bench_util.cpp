@@ -0,0 +1,86 @@
+#include "bench_util.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <map>
+
+#include <gtest/gtest.h>
+
+#include "diablo.h"
+#include "utils/paths.h"
+
+namespace devilution {
+
+namespace {
+
+std::map<std::string, double> Golden;
+std::ofstream Record;
+
+} // namespace
+
+BenchOption IntOption(const char *name, int &value, int min, int max)
+{
+	return { name, [&value, min, max](const char *arg) { value = std::clamp(std::atoi(arg), min, max); } };
+}
+
+BenchOption StringOption(const char *name, std::string &value)
+{
+	return { name, [&value](const char *arg) { value = arg; } };
+}
+
+int RunBenchmarks(int argc, char **argv, std::initializer_list<BenchOption> options)
+{
+	gbQuietMode = true;
+	testing::InitGoogleTest(&argc, argv);
+	for (int i = 1; i < argc - 1; i++) {
+		if (strcmp(argv[i], "--data-dir") == 0) {
+			paths::SetBasePath(argv[++i]);
+			continue;
+		}
+		for (const BenchOption &option : options) {
+			if (strcmp(argv[i], option.name) == 0) {
+				option.parse(argv[++i]);
+				break;
+			}
+		}
+	}
+	return RUN_ALL_TESTS();
+}
+
+double Percentile(const std::vector<double> &sorted, int percent)
+{
+	return sorted[std::min(sorted.size() - 1, sorted.size() * percent / 100)];
+}
+
+bool OpenReport(const std::string &recordPath, const std::string &checkPath)
+{
+	if (!checkPath.empty()) {
+		std::ifstream in(checkPath);
+		if (!in.is_open())
+			return false;
+		std::string name;
+		double nanoseconds;
+		while (in >> name >> nanoseconds)
+			Golden[name] = nanoseconds;
+	}
+	if (!recordPath.empty()) {
+		Record.open(recordPath, std::ios::trunc);
+		if (!Record.is_open())
+			return false;
+	}
+	return true;
+}
+
+void Report(const std::string &name, double nanoseconds)
+{
+	if (Record.is_open())
+		Record << name << ' ' << nanoseconds << '\n';
+	auto it = Golden.find(name);
+	if (it != Golden.end())
+		printf("%-48s %10.1f ns  %+6.1f%%\n", name.c_str(), nanoseconds, (nanoseconds / it->second - 1) * 100);
+	else
+		printf("%-48s %10.1f ns\n", name.c_str(), nanoseconds);
+}
+
+} // namespace devilution
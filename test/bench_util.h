@@ -0,0 +1,86 @@
+/**
+ * @file bench_util.h
+ *
+ * Command line handling, timing and reporting shared by the benchmarks.
+ */
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <cstddef>
+#include <cstdio>
+#include <functional>
+#include <initializer_list>
+#include <string>
+#include <vector>
+
+namespace devilution {
+
+/** @brief A benchmark option given as `<name> <value>` on the command line. */
+struct BenchOption {
+	const char *name;
+	std::function<void(const char *value)> parse;
+};
+
+BenchOption IntOption(const char *name, int &value, int min = 1, int max = INT_MAX);
+BenchOption StringOption(const char *name, std::string &value);
+
+/**
+ * @brief Parses the command line and runs the benchmarks.
+ *
+ * `--data-dir <folder of diabdat.mpq>` is accepted by every benchmark, the gtest options are handled as usual.
+ * @return The exit code of the program
+ */
+int RunBenchmarks(int argc, char **argv, std::initializer_list<BenchOption> options);
+
+/** @param sorted Measurements in ascending order */
+double Percentile(const std::vector<double> &sorted, int percent);
+
+/**
+ * @brief Calls fn with the numbers from 0 to calls - 1 and returns the average time of a call.
+ */
+template <typename F>
+double NanosecondsPerCall(int calls, F &&fn)
+{
+	const auto start = std::chrono::steady_clock::now();
+	for (int i = 0; i < calls; i++)
+		fn(i);
+	const std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+	return elapsed.count() / calls;
+}
+
+/**
+ * @brief Runs fn the given number of times and prints the throughput and latency of a call
+ * @param bytes Payload size of one call
+ */
+template <typename F>
+void Measure(const char *name, std::size_t bytes, int iterations, F &&fn)
+{
+	std::vector<double> times;
+	times.reserve(iterations);
+	const auto start = std::chrono::steady_clock::now();
+	for (int i = 0; i < iterations; i++) {
+		const auto callStart = std::chrono::steady_clock::now();
+		fn();
+		const std::chrono::duration<double, std::micro> callTime = std::chrono::steady_clock::now() - callStart;
+		times.push_back(callTime.count());
+	}
+	const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+	std::sort(times.begin(), times.end());
+	printf("%-28s %8zu B %9.1f MB/s, p50 %8.1f us, p99 %8.1f us, max %8.1f us\n",
+	    name, bytes, bytes * static_cast<double>(iterations) / elapsed.count() / (1024 * 1024),
+	    Percentile(times, 50), Percentile(times, 99), times.back());
+}
+
+/**
+ * @brief Loads the timings Report compares with and opens the file it records to, either path may be empty
+ * @return false if one of the files couldn't be opened
+ */
+bool OpenReport(const std::string &recordPath, const std::string &checkPath);
+
+/** @brief Prints the time of a case, relative to the loaded timings if it is in them, and records it. */
+void Report(const std::string &name, double nanoseconds);
+
+} // namespace devilution
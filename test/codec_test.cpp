@@ -13,3 +13,43 @@ TEST(Codec, codec_get_encoded_len_eq)
 {
 	EXPECT_EQ(codec_get_encoded_len(128), 136);
 }
+
+TEST(Codec, CodecEncoderMatchesCodecEncode)
+{
+	constexpr std::size_t Size = 300;
+	byte whole[Size + 64 + CodecEncoder::SignatureSize];
+	byte pieces[Size + 64 + CodecEncoder::SignatureSize];
+	for (std::size_t i = 0; i < Size; i++)
+		whole[i] = pieces[i] = static_cast<byte>(i * 7);
+
+	codec_encode(whole, Size, codec_get_encoded_len(Size), "password");
+
+	std::size_t encoded;
+	{
+		CodecEncoder encoder("password");
+		encoded = encoder.Encode(pieces, 128);
+		encoded += encoder.Encode(&pieces[encoded], Size - 128);
+		encoder.Finish(&pieces[encoded]);
+	}
+
+	ASSERT_EQ(encoded + CodecEncoder::SignatureSize, codec_get_encoded_len(Size));
+	EXPECT_EQ(memcmp(whole, pieces, codec_get_encoded_len(Size)), 0);
+	EXPECT_EQ(codec_decode(pieces, codec_get_encoded_len(Size), "password"), Size);
+}
+
+TEST(Codec, codec_encode_matches_saves)
+{
+	// Produced by the original implementation, the format of existing saves must not change
+	constexpr std::size_t Size = 130;
+	const uint8_t expectedStart[] = { 98, 106, 250, 62, 82, 199, 9, 165 };
+	const uint8_t expectedSignature[] = { 172, 164, 139, 242, 0, 2, 0, 0 };
+
+	byte data[Size + 64 + CodecEncoder::SignatureSize];
+	for (std::size_t i = 0; i < Size; i++)
+		data[i] = static_cast<byte>(i * 7);
+	const std::size_t encodedLen = codec_get_encoded_len(Size);
+	codec_encode(data, Size, encodedLen, "xrgyrkj1");
+
+	EXPECT_EQ(memcmp(data, expectedStart, sizeof(expectedStart)), 0);
+	EXPECT_EQ(memcmp(&data[encodedLen - sizeof(expectedSignature)], expectedSignature, sizeof(expectedSignature)), 0);
+}
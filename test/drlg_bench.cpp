@@ -0,0 +1,196 @@
+/**
+ * Generates the layouts of the dungeon levels for many seeds and reports how long it took.
+ *
+ * Usage: devilutionx_drlg_bench [--data-dir <folder of diabdat.mpq>] [--seeds <count>]
+ *                               [--golden <file>] [--record <file>] [--check <file>]
+ *
+ * Every level's layouts are combined into one hash and compared with the golden file, which is
+ * test/drlg_bench_layouts.txt unless `--golden` names another. This proves that changes to the
+ * level generation keep the output the same. If the golden file doesn't exist yet, it is written
+ * instead. A golden file made with a different seed count is left alone and not compared.
+ *
+ * `--record` writes a hash of every single layout to the file and `--check` compares the layouts
+ * with such a file, to find the seeds whose layout changed.
+ */
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "bench_util.h"
+#include "diablo.h"
+#include "drlg_l1.h"
+#include "drlg_l2.h"
+#include "drlg_l3.h"
+#include "drlg_l4.h"
+#include "init.h"
+#include "lighting.h"
+#include "multi.h"
+#include "quests.h"
+
+using namespace devilution;
+
+namespace {
+
+int SeedCount = 2000;
+std::string GoldenPath = DRLG_GOLDEN_PATH;
+std::string RecordPath;
+std::string CheckPath;
+
+struct DungeonTileset {
+	dungeon_type type;
+	int firstLevel;
+	const char *megaTiles;
+	void (*create)(uint32_t rseed, lvl_entry entry);
+};
+
+const DungeonTileset Tilesets[] = {
+	{ DTYPE_CATHEDRAL, 1, "Levels\\L1Data\\L1.TIL", CreateL5Dungeon },
+	{ DTYPE_CATACOMBS, 5, "Levels\\L2Data\\L2.TIL", CreateL2Dungeon },
+	{ DTYPE_CAVES, 9, "Levels\\L3Data\\L3.TIL", CreateL3Dungeon },
+	{ DTYPE_HELL, 13, "Levels\\L4Data\\L4.TIL", CreateL4Dungeon },
+};
+
+/** 32-bit FNV-1a */
+void AddToHash(uint32_t &hash, const void *data, std::size_t size)
+{
+	const auto *bytes = static_cast<const uint8_t *>(data);
+	for (std::size_t i = 0; i < size; i++)
+		hash = (hash ^ bytes[i]) * 16777619U;
+}
+
+constexpr uint32_t HashBasis = 2166136261U;
+
+uint32_t HashLayout()
+{
+	uint32_t hash = HashBasis;
+	AddToHash(hash, dungeon, sizeof(dungeon));
+	AddToHash(hash, dPiece, sizeof(dPiece));
+	AddToHash(hash, dTransVal, sizeof(dTransVal));
+	return hash;
+}
+
+/** Mirror starting a single player game, so the quests place the same set pieces every time */
+void InitGame()
+{
+	gbIsMultiplayer = false;
+	for (int i = 0; i < NUMLEVELS; i++)
+		glSeedTbl[i] = 0x1000 + i;
+	InitQuests();
+	MakeLightTable();
+}
+
+/** @return The combined hash of each level's layouts, if the file was made with the same seed count */
+std::map<int, uint32_t> LoadGolden()
+{
+	std::map<int, uint32_t> golden;
+	std::ifstream in(GoldenPath);
+	int level;
+	int seeds;
+	uint32_t hash;
+	while (in >> level >> seeds >> std::hex >> hash >> std::dec) {
+		if (seeds != SeedCount)
+			return {};
+		golden[level] = hash;
+	}
+	return golden;
+}
+
+} // namespace
+
+TEST(DrlgBench, Generate)
+{
+	init_archives();
+	InitGame();
+
+	std::map<std::pair<int, uint32_t>, uint32_t> golden;
+	if (!CheckPath.empty()) {
+		std::ifstream in(CheckPath);
+		ASSERT_TRUE(in.is_open()) << "Unable to read " << CheckPath;
+		int level;
+		uint32_t seed;
+		uint32_t hash;
+		while (in >> level >> std::hex >> seed >> hash >> std::dec)
+			golden[{ level, seed }] = hash;
+	}
+	std::ofstream record;
+	if (!RecordPath.empty()) {
+		record.open(RecordPath, std::ios::trunc);
+		ASSERT_TRUE(record.is_open()) << "Unable to write " << RecordPath;
+	}
+
+	const std::map<int, uint32_t> goldenLevels = LoadGolden();
+	std::map<int, uint32_t> levelHashes;
+
+	int mismatches = 0;
+	for (const DungeonTileset &tileset : Tilesets) {
+		leveltype = tileset.type;
+		pMegaTiles = LoadFileInMem<MegaTile>(tileset.megaTiles);
+
+		std::vector<double> times;
+		const auto start = std::chrono::steady_clock::now();
+		for (int level = tileset.firstLevel; level < tileset.firstLevel + 4; level++) {
+			currlevel = level;
+			uint32_t &levelHash = levelHashes[level];
+			levelHash = HashBasis;
+			for (int i = 0; i < SeedCount; i++) {
+				const uint32_t seed = i * 0x9E3779B9U;
+				glSeedTbl[level] = seed;
+
+				const auto levelStart = std::chrono::steady_clock::now();
+				tileset.create(seed, ENTRY_MAIN);
+				const std::chrono::duration<double, std::micro> levelTime = std::chrono::steady_clock::now() - levelStart;
+				times.push_back(levelTime.count());
+
+				const uint32_t hash = HashLayout();
+				AddToHash(levelHash, &hash, sizeof(hash));
+				if (record.is_open())
+					record << level << ' ' << std::hex << seed << ' ' << hash << std::dec << '\n';
+				auto it = golden.find({ level, seed });
+				if (it != golden.end() && it->second != hash) {
+					if (mismatches++ < 10)
+						ADD_FAILURE() << "Level " << level << " with seed " << std::hex << seed << " changed";
+				}
+			}
+			glSeedTbl[level] = 0x1000 + level;
+
+			auto it = goldenLevels.find(level);
+			if (it != goldenLevels.end() && it->second != levelHash) {
+				mismatches++;
+				ADD_FAILURE() << "The layouts of level " << level << " changed, use --check to find the seeds";
+			}
+		}
+		const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+		pMegaTiles = nullptr;
+
+		std::sort(times.begin(), times.end());
+		printf("%-10s %5zu levels in %7.3f s, p50 %8.1f us, p90 %8.1f us, p99 %8.1f us, max %8.1f us\n",
+		    tileset.megaTiles + 7, times.size(), elapsed.count(),
+		    Percentile(times, 50), Percentile(times, 90), Percentile(times, 99), times.back());
+	}
+
+	EXPECT_EQ(mismatches, 0) << "The generated layouts differ from " << (CheckPath.empty() ? GoldenPath : CheckPath);
+
+	if (goldenLevels.empty() && !std::ifstream(GoldenPath).is_open()) {
+		std::ofstream out(GoldenPath, std::ios::trunc);
+		ASSERT_TRUE(out.is_open()) << "Unable to write " << GoldenPath;
+		for (const auto &entry : levelHashes)
+			out << entry.first << ' ' << SeedCount << ' ' << std::hex << entry.second << std::dec << '\n';
+		printf("Wrote the golden layout hashes to %s\n", GoldenPath.c_str());
+	} else if (goldenLevels.empty()) {
+		printf("%s was made with another seed count, the layouts were not compared with it\n", GoldenPath.c_str());
+	}
+}
+
+int main(int argc, char **argv)
+{
+	return RunBenchmarks(argc, argv,
+	    { IntOption("--seeds", SeedCount), StringOption("--golden", GoldenPath), StringOption("--record", RecordPath),
+	        StringOption("--check", CheckPath) });
+}
@@ -0,0 +1,83 @@
+#include <gtest/gtest.h>
+
+#include "flowfield.h"
+#include "gendung.h"
+#include "path.h"
+
+using namespace devilution;
+
+namespace {
+
+void ClearMap()
+{
+	memset(dPiece, 0, sizeof(dPiece));
+	memset(dObject, 0, sizeof(dObject));
+	nSolidTable[0] = false;
+	nSolidTable[1] = true;
+	InvalidateFlowFields();
+}
+
+/** @brief Follow the field from start and return where it ends */
+Point WalkField(Point start, Point goal)
+{
+	Point position = start;
+	Direction direction;
+	for (int i = 0; i < 100 && GetFlowFieldStep(position, goal, false, direction); i++) {
+		position += direction;
+		EXPECT_EQ(dPiece[position.x][position.y], 0);
+	}
+	return position;
+}
+
+} // namespace
+
+TEST(FlowField, StraightLine)
+{
+	ClearMap();
+	Direction direction;
+	ASSERT_TRUE(GetFlowFieldStep({ 20, 20 }, { 25, 20 }, false, direction));
+	EXPECT_EQ(direction, DIR_SE);
+	ASSERT_TRUE(GetFlowFieldStep({ 20, 20 }, { 25, 25 }, false, direction));
+	EXPECT_EQ(direction, DIR_S);
+	EXPECT_FALSE(GetFlowFieldStep({ 25, 25 }, { 25, 25 }, false, direction));
+}
+
+TEST(FlowField, AroundWall)
+{
+	ClearMap();
+	for (int y = 15; y <= 25; y++)
+		dPiece[22][y] = 1;
+	InvalidateFlowFields();
+
+	Point end = WalkField({ 20, 20 }, { 24, 20 });
+	EXPECT_EQ(end.x, 24);
+	EXPECT_EQ(end.y, 20);
+}
+
+TEST(FlowField, OutOfRange)
+{
+	ClearMap();
+	Direction direction;
+	EXPECT_FALSE(GetFlowFieldStep({ 20, 20 }, { 20 + MAX_PATH_LENGTH, 20 }, false, direction));
+}
+
+TEST(FlowField, Invalidate)
+{
+	ClearMap();
+	Direction direction;
+	ASSERT_TRUE(GetFlowFieldStep({ 20, 20 }, { 25, 20 }, false, direction));
+	EXPECT_EQ(direction, DIR_SE);
+
+	// Wall off the goal
+	for (int x = 23; x <= 27; x++) {
+		dPiece[x][18] = 1;
+		dPiece[x][22] = 1;
+	}
+	for (int y = 18; y <= 22; y++) {
+		dPiece[23][y] = 1;
+		dPiece[27][y] = 1;
+	}
+	EXPECT_TRUE(GetFlowFieldStep({ 20, 20 }, { 25, 20 }, false, direction));
+	InvalidateFlowFields();
+	EXPECT_FALSE(GetFlowFieldStep({ 20, 20 }, { 25, 20 }, false, direction));
+}
@@ -1,5 +1,6 @@
 #include <gtest/gtest.h>
 
+#include "lighting.h"
 #include "missiles.h"
 
 using namespace devilution;
@@ -85,3 +86,26 @@ TEST(Missiles, GetDirection16)
 	EXPECT_EQ(14, GetDirection16(2, 2, 4, 2));
 	EXPECT_EQ(15, GetDirection16(2, 2, 4, 3));
 }
+
+TEST(Missiles, GetMissilePos)
+{
+	MissileStruct &mis = missile[0];
+	mis._mlid = NO_LIGHT;
+	mis.position.start = { 10, 10 };
+
+	mis.position.traveled = { 0x300000, -0x120000 };
+	GetMissilePos(0);
+	EXPECT_EQ(mis.position.tile, (Point { 10, 9 }));
+	EXPECT_EQ(mis.position.offset, (Point { 16, -2 }));
+
+	// Distances towards negative screen coordinates round towards zero as well
+	mis.position.traveled = { -0x4A0000, 0x80000 };
+	GetMissilePos(0);
+	EXPECT_EQ(mis.position.tile, (Point { 10, 11 }));
+	EXPECT_EQ(mis.position.offset, (Point { -42, -8 }));
+
+	mis.position.traveled = { -0x130000, -0x250000 };
+	GetMissilePos(0);
+	EXPECT_EQ(mis.position.tile, (Point { 9, 10 }));
+	EXPECT_EQ(mis.position.offset, (Point { 13, -21 }));
+}
@@ -0,0 +1,45 @@
+#include <gtest/gtest.h>
+
+#include "engine/render/outline_cache.hpp"
+
+using namespace devilution;
+
+namespace {
+
+bool HasRun(const OutlineMask &mask, int x, int y, int width)
+{
+	for (const OutlineRun &run : mask) {
+		if (run.x == x && run.y == y && run.width == width)
+			return true;
+	}
+	return false;
+}
+
+} // namespace
+
+TEST(OutlineCache, SinglePixel)
+{
+	OutlineMaskBuilder builder(3);
+	builder.AddOpaque(1, 1, /*fill=*/false);
+	const OutlineMask mask = builder.Build();
+
+	ASSERT_EQ(mask.size(), 4U);
+	EXPECT_TRUE(HasRun(mask, 1, -1, 1));
+	EXPECT_TRUE(HasRun(mask, 0, 0, 1));
+	EXPECT_TRUE(HasRun(mask, 2, 0, 1));
+	EXPECT_TRUE(HasRun(mask, 1, 1, 1));
+}
+
+TEST(OutlineCache, FilledRunAcrossLines)
+{
+	OutlineMaskBuilder builder(2);
+	// Starts at the end of the bottom line and continues on the next one
+	builder.AddOpaque(1, 2, /*fill=*/true);
+	const OutlineMask mask = builder.Build();
+
+	ASSERT_EQ(mask.size(), 4U);
+	EXPECT_TRUE(HasRun(mask, 0, -2, 1));
+	EXPECT_TRUE(HasRun(mask, -1, -1, 3));
+	EXPECT_TRUE(HasRun(mask, 0, 0, 3));
+	EXPECT_TRUE(HasRun(mask, 1, 1, 1));
+}
@@ -0,0 +1,79 @@
+#include <gtest/gtest.h>
+
+#include "gendung.h"
+#include "path.h"
+
+using namespace devilution;
+
+namespace {
+
+bool Blocked[MAXDUNX][MAXDUNY];
+
+bool TestPosOk(int /*unused*/, Point position)
+{
+	return !Blocked[position.x][position.y];
+}
+
+void ClearMap()
+{
+	memset(Blocked, 0, sizeof(Blocked));
+	memset(dPiece, 0, sizeof(dPiece));
+	nSolidTable[0] = false;
+}
+
+} // namespace
+
+TEST(Path, HeuristicCost)
+{
+	EXPECT_EQ(path_get_h_cost(10, 10, 10, 10), 0);
+	EXPECT_EQ(path_get_h_cost(10, 10, 12, 10), 4);
+	EXPECT_EQ(path_get_h_cost(10, 10, 13, 12), 10);
+}
+
+TEST(Path, FindPathDiagonal)
+{
+	ClearMap();
+	int8_t path[MAX_PATH_LENGTH];
+	ASSERT_EQ(FindPath(TestPosOk, 0, 10, 10, 13, 13, path), 3);
+	for (int i = 0; i < 3; i++)
+		EXPECT_EQ(path[i], 7);
+}
+
+TEST(Path, FindPathAroundWall)
+{
+	ClearMap();
+	for (int y = 5; y <= 15; y++)
+		Blocked[12][y] = true;
+
+	int8_t path[MAX_PATH_LENGTH];
+	int length = FindPath(TestPosOk, 0, 10, 10, 14, 10, path);
+	ASSERT_GT(length, 4);
+
+	Point position { 10, 10 };
+	for (int i = 0; i < length; i++) {
+		const int step = path[i];
+		constexpr int8_t StepX[] = { 0, 0, -1, 1, 0, -1, 1, 1, -1 };
+		constexpr int8_t StepY[] = { 0, -1, 0, 0, 1, -1, -1, 1, 1 };
+		position.x += StepX[step];
+		position.y += StepY[step];
+		EXPECT_FALSE(Blocked[position.x][position.y]);
+	}
+	EXPECT_EQ(position.x, 14);
+	EXPECT_EQ(position.y, 10);
+}
+
+TEST(Path, FindPathUnreachable)
+{
+	ClearMap();
+	for (int i = 8; i <= 12; i++) {
+		Blocked[i][8] = true;
+		Blocked[i][12] = true;
+		Blocked[8][i] = true;
+		Blocked[12][i] = true;
+	}
+
+	int8_t path[MAX_PATH_LENGTH];
+	EXPECT_EQ(FindPath(TestPosOk, 0, 20, 20, 10, 10, path), 0);
+	// Nodes from the failed search must not leak into the next one
+	EXPECT_EQ(FindPath(TestPosOk, 0, 20, 20, 22, 20, path), 2);
+}
@@ -0,0 +1,215 @@
+/**
+ * Times the render kernels against the real game assets and reports nanoseconds per call.
+ *
+ * Usage: devilutionx_render_bench [--data-dir <folder of diabdat.mpq>] [--calls <count>]
+ *                                 [--record <file>] [--check <file>]
+ *
+ * `--record` writes the timing of every case to the file and `--check` prints how each case
+ * changed relative to such a file, so renderer changes can be compared on the same machine.
+ */
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <array>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "bench_util.h"
+#include "diablo.h"
+#include "engine/render/cel_render.hpp"
+#include "engine/render/cl2_render.hpp"
+#include "engine/render/dun_render.hpp"
+#include "gendung.h"
+#include "init.h"
+#include "lighting.h"
+#include "options.h"
+#include "palette.h"
+#include "scrollrt.h"
+#include "utils/sdl_ptrs.h"
+#include "utils/simd.h"
+
+using namespace devilution;
+
+namespace {
+
+int CallCount = 20000;
+std::string RecordPath;
+std::string CheckPath;
+
+struct Tileset {
+	dungeon_type type;
+	const char *cels;
+	const char *levelPieces;
+};
+
+const Tileset Tilesets[] = {
+	{ DTYPE_CATHEDRAL, "Levels\\L1Data\\L1.CEL", "Levels\\L1Data\\L1.MIN" },
+	{ DTYPE_CATACOMBS, "Levels\\L2Data\\L2.CEL", "Levels\\L2Data\\L2.MIN" },
+	{ DTYPE_CAVES, "Levels\\L3Data\\L3.CEL", "Levels\\L3Data\\L3.MIN" },
+	{ DTYPE_HELL, "Levels\\L4Data\\L4.CEL", "Levels\\L4Data\\L4.MIN" },
+};
+
+const char *const TileTypeNames[] = {
+	"Square",
+	"TransparentSquare",
+	"LeftTriangle",
+	"RightTriangle",
+	"LeftTrapezoid",
+	"RightTrapezoid",
+};
+
+/** Target positions of the bottom left corner of a tile: fully visible, cut by the left edge and cut by the top edge */
+const Point ClipPositions[] = { { 288, 240 }, { -16, 240 }, { 288, 16 } };
+const char *const ClipNames[] = { "Unclipped", "ClipLeft", "ClipTop" };
+
+SDLSurfaceUniquePtr CreateTarget()
+{
+	SDLSurfaceUniquePtr surface { SDL_CreateRGBSurface(0, 640, 480, 8, 0, 0, 0, 0) };
+	EXPECT_NE(surface.get(), nullptr) << SDL_GetError();
+	return surface;
+}
+
+void BenchTiles(const CelOutputBuffer &out)
+{
+	for (const Tileset &tileset : Tilesets) {
+		leveltype = tileset.type;
+		pDungeonCels = LoadFileInMem(tileset.cels);
+		LoadLevelPieces(tileset.levelPieces);
+		InvalidateTileCache();
+
+		std::array<std::vector<uint16_t>, sizeof(TileTypeNames) / sizeof(TileTypeNames[0])> blocksByType;
+		for (const MICROS &micros : LevelPieceMicros) {
+			for (uint16_t block : micros.mt) {
+				const unsigned type = (block & 0x7000) >> 12;
+				if (block != 0 && type < blocksByType.size())
+					blocksByType[type].push_back(block);
+			}
+		}
+
+		for (size_t type = 0; type < blocksByType.size(); type++) {
+			const std::vector<uint16_t> &blocks = blocksByType[type];
+			if (blocks.empty())
+				continue;
+			for (size_t clip = 0; clip < sizeof(ClipNames) / sizeof(ClipNames[0]); clip++) {
+				for (int light : { 0, 8 }) {
+					for (bool transparent : { false, true }) {
+						light_table_index = light;
+						cel_transparency_active = transparent;
+						arch_draw_type = 0;
+						const double ns = NanosecondsPerCall(CallCount, [&](int i) {
+							level_cel_block = blocks[i % blocks.size()];
+							RenderTile(out, ClipPositions[clip].x, ClipPositions[clip].y);
+						});
+						Report(std::string("RenderTile/") + (tileset.cels + 7) + "/" + TileTypeNames[type] + "/" + ClipNames[clip]
+						        + (light != 0 ? "/Lit" : "") + (transparent ? "/Trans" : ""),
+						    ns);
+					}
+				}
+			}
+		}
+
+		cel_transparency_active = false;
+		light_table_index = 0;
+		LevelPieceMicros.clear();
+		pLevelPieces = nullptr;
+		pDungeonCels = nullptr;
+		InvalidateTileCache();
+	}
+}
+
+void BenchSprites(const CelOutputBuffer &out)
+{
+	auto cl2Data = LoadFileInMem("Monsters\\Zombie\\Zombiew.CL2");
+	const byte *group = CelGetFrameStart(cl2Data.get(), 0);
+	const int frames = LoadLE32(group);
+	CelSprite cl2(group, 128);
+
+	for (size_t clip = 0; clip < sizeof(ClipNames) / sizeof(ClipNames[0]); clip++) {
+		const Point position = ClipPositions[clip];
+		Report(std::string("Cl2Draw/") + ClipNames[clip], NanosecondsPerCall(CallCount, [&](int i) {
+			Cl2Draw(out, position.x, position.y, cl2, i % frames + 1);
+		}));
+		light_table_index = 8;
+		Report(std::string("Cl2DrawLight/") + ClipNames[clip], NanosecondsPerCall(CallCount, [&](int i) {
+			Cl2DrawLight(out, position.x, position.y, cl2, i % frames + 1);
+		}));
+		light_table_index = 0;
+		Report(std::string("Cl2DrawOutline/") + ClipNames[clip], NanosecondsPerCall(CallCount, [&](int i) {
+			Cl2DrawOutline(out, PAL16_RED + 5, position.x, position.y, cl2, i % frames + 1);
+		}));
+	}
+
+	CelSprite panel = LoadCel("CtrlPan\\Panel8.CEL", 640);
+	light_table_index = 8;
+	Report("CelDrawLightTo/Panel", NanosecondsPerCall(CallCount, [&](int) {
+		CelDrawLightTo(out, { 0, 479 }, panel, 1, nullptr);
+	}));
+	light_table_index = 0;
+}
+
+void BenchRects(const CelOutputBuffer &out)
+{
+	for (bool blended : { false, true }) {
+		sgOptions.Graphics.bBlendedTransparancy = blended;
+		Report(std::string("DrawHalfTransparentRectTo/") + (blended ? "Blended" : "Stippled"), NanosecondsPerCall(CallCount, [&](int) {
+			DrawHalfTransparentRectTo(out, 27, 28, 585, 297);
+		}));
+	}
+}
+
+void BenchZoom(const CelOutputBuffer &out)
+{
+	Report("Zoom", NanosecondsPerCall(CallCount, [&](int) {
+		Zoom(out);
+	}));
+}
+
+void BenchBlendTable()
+{
+	LoadPalette("Levels\\L1Data\\L1_1.PAL", /*blend=*/false);
+	std::array<SDL_Color, 256> palette;
+	std::copy(orig_palette, orig_palette + 256, palette.begin());
+
+	// A full table takes milliseconds, fewer calls are enough
+	const int calls = std::max(CallCount / 1000, 1);
+	for (int skip : { -1, 31 }) {
+		const int skipFrom = skip == -1 ? -1 : 1;
+		const std::string name = std::string("GenerateBlendedLookupTable/") + (skip == -1 ? "Full" : "SkipCycling");
+		Report(name, NanosecondsPerCall(calls, [&](int i) {
+			// A different palette every call, so the table is never taken from the cache
+			palette[255].r = static_cast<Uint8>(i);
+			GenerateBlendedLookupTable(palette.data(), skipFrom, skip);
+		}));
+		Report(name + "/Cached", NanosecondsPerCall(CallCount, [&](int) {
+			GenerateBlendedLookupTable(palette.data(), skipFrom, skip);
+		}));
+	}
+}
+
+} // namespace
+
+TEST(RenderBench, Kernels)
+{
+	init_archives();
+	MakeLightTable();
+
+	ASSERT_TRUE(OpenReport(RecordPath, CheckPath)) << "Unable to open " << CheckPath << " or " << RecordPath;
+
+	SDLSurfaceUniquePtr surface = CreateTarget();
+	ASSERT_NE(surface.get(), nullptr);
+	const CelOutputBuffer out(surface.get());
+
+	printf("Render kernels: %s\n", SimdName());
+	BenchTiles(out);
+	BenchSprites(out);
+	BenchRects(out);
+	BenchZoom(out);
+	BenchBlendTable();
+}
+
+int main(int argc, char **argv)
+{
+	return RunBenchmarks(argc, argv,
+	    { IntOption("--calls", CallCount), StringOption("--record", RecordPath), StringOption("--check", CheckPath) });
+}
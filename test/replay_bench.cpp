@@ -0,0 +1,67 @@
+/**
+ * Plays back a recorded game as fast as possible and reports how long the game logic took.
+ *
+ * Usage: devilutionx_replay_bench --replay <file> [--data-dir <folder of diabdat.mpq>]
+ *
+ * Replays are recorded by starting a new single player game with `devilutionx --record <file>`.
+ */
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cstdio>
+#include <string>
+
+#include "bench_util.h"
+#include "diablo.h"
+#include "init.h"
+#include "replay.h"
+#include "utils/profiler.h"
+
+using namespace devilution;
+
+namespace {
+
+std::string ReplayPath;
+
+} // namespace
+
+TEST(ReplayBench, Playback)
+{
+	if (ReplayPath.empty())
+		GTEST_SKIP() << "No replay given, use --replay <file>";
+
+	ReplayPlayback replay;
+	ASSERT_TRUE(replay.Open(ReplayPath)) << "Unable to read " << ReplayPath;
+	init_archives();
+	ASSERT_TRUE(replay.StartGame());
+
+	FrameProfile totals {};
+	uint32_t ticks = 0;
+	SetProfilerEnabled(true);
+	const auto start = std::chrono::steady_clock::now();
+	while (replay.RunTick()) {
+		ProfilerEndFrame();
+		const FrameProfile &frame = ProfilerLastFrame();
+		for (std::size_t i = 0; i < totals.size(); i++)
+			totals[i] += frame[i];
+		ticks++;
+	}
+	const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+	SetProfilerEnabled(false);
+
+	printf("%u ticks in %.3f s, %.1f ticks per second\n", ticks, elapsed.count(), ticks / elapsed.count());
+	for (ProfilePhase phase : enum_values<ProfilePhase>()) {
+		const uint32_t total = totals[static_cast<std::size_t>(phase)];
+		if (total == 0)
+			continue;
+		printf("  %-20s %10.3f ms %8.3f us/tick\n", ProfilePhaseName(phase), total / 1000.0, ticks != 0 ? static_cast<double>(total) / ticks : 0.0);
+	}
+
+	EXPECT_EQ(ticks, replay.RecordedTicks());
+	EXPECT_EQ(ReplayStateHash(), replay.RecordedStateHash()) << "The playback diverged from the recording";
+}
+
+int main(int argc, char **argv)
+{
+	return RunBenchmarks(argc, argv, { StringOption("--replay", ReplayPath) });
+}
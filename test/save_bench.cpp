@@ -0,0 +1,147 @@
+/**
+ * Times the save game and network message paths and reports throughput and latency percentiles.
+ *
+ * Usage: devilutionx_save_bench [--iterations <count>]
+ *
+ * The payloads are synthetic: mostly zero with small values in between, like the packed
+ * structs of a save game, so they compress about as well as the real thing.
+ */
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+#include "bench_util.h"
+#include "codec.h"
+#include "dvlnet/frame_queue.h"
+#include "dvlnet/loopback.h"
+#include "encrypt.h"
+#include "loadsave.h"
+#include "pack.h"
+#include "pfile.h"
+#include "player.h"
+#include "utils/paths.h"
+
+using namespace devilution;
+
+namespace {
+
+int Iterations = 200;
+
+/** Sizes of a packed hero and of a large level in a save game */
+const std::size_t PayloadSizes[] = { 4 * 1024, 256 * 1024 };
+
+std::vector<byte> MakePayload(std::size_t size)
+{
+	std::vector<byte> payload(size);
+	uint32_t seed = 0x12345678;
+	for (byte &value : payload) {
+		seed = seed * 1103515245 + 12345;
+		value = static_cast<byte>((seed >> 16) % 4 == 0 ? (seed >> 24) % 32 : 0);
+	}
+	return payload;
+}
+
+} // namespace
+
+TEST(SaveBench, Codec)
+{
+	for (std::size_t size : PayloadSizes) {
+		const std::vector<byte> payload = MakePayload(size);
+		const std::size_t encodedSize = codec_get_encoded_len(size);
+		std::vector<byte> buffer(encodedSize);
+		std::vector<byte> encoded(encodedSize);
+
+		Measure("codec_encode", size, Iterations, [&]() {
+			memcpy(buffer.data(), payload.data(), size);
+			codec_encode(buffer.data(), size, encodedSize, "xrgyrkj1");
+		});
+		memcpy(encoded.data(), buffer.data(), encodedSize);
+
+		Measure("codec_decode", size, Iterations, [&]() {
+			memcpy(buffer.data(), encoded.data(), encodedSize);
+			EXPECT_EQ(codec_decode(buffer.data(), encodedSize, "xrgyrkj1"), size);
+		});
+	}
+}
+
+TEST(SaveBench, Pkware)
+{
+	for (std::size_t size : PayloadSizes) {
+		const std::vector<byte> payload = MakePayload(size);
+		std::vector<byte> compressed(PkwareCompressBound(size));
+		std::vector<byte> decompressed(size);
+		uint32_t compressedSize = 0;
+
+		Measure("PkwareCompress", size, Iterations, [&]() {
+			compressedSize = PkwareCompress(payload.data(), size, compressed.data());
+		});
+		printf("%-28s %8zu B -> %zu B\n", "", size, static_cast<std::size_t>(compressedSize));
+
+		Measure("PkwareDecompress", size, Iterations, [&]() {
+			EXPECT_EQ(PkwareDecompress(compressed.data(), compressedSize, decompressed.data(), size), size);
+		});
+	}
+}
+
+TEST(SaveBench, WriteHero)
+{
+	paths::SetPrefPath(".");
+	std::remove("multi_0.sv");
+
+	gbVanilla = false;
+	gbIsHellfire = false;
+	gbIsMultiplayer = true;
+	gbIsHellfireSaveGame = false;
+	leveltype = DTYPE_TOWN;
+
+	myplr = 0;
+	_uiheroinfo info {};
+	strcpy(info.name, "BenchPlayer");
+	info.heroclass = HeroClass::Warrior;
+	ASSERT_TRUE(pfile_ui_save_create(&info));
+
+	// Covers packing, encoding and the archive writes and flush of mpqapi
+	Measure("pfile_write_hero", sizeof(PkPlayerStruct), Iterations, []() {
+		pfile_write_hero();
+	});
+
+	std::remove("multi_0.sv");
+}
+
+TEST(SaveBench, Network)
+{
+	// The size of a full TPkt and of a delta chunk
+	for (std::size_t size : { 512, 4096 }) {
+		std::vector<byte> payload = MakePayload(size);
+
+		net::loopback loopback;
+		loopback.create("", "");
+		Measure("loopback send + receive", size, Iterations, [&]() {
+			loopback.SNetSendMessage(0, payload.data(), size);
+			int sender;
+			char *data;
+			int received;
+			EXPECT_TRUE(loopback.SNetReceiveMessage(&sender, &data, &received));
+			EXPECT_EQ(static_cast<std::size_t>(received), size);
+		});
+
+		const net::buffer_t packet(reinterpret_cast<const unsigned char *>(payload.data()),
+		    reinterpret_cast<const unsigned char *>(payload.data()) + size);
+		net::buffer_t frame;
+		net::frame_queue queue;
+		Measure("frame_queue write + read", size, Iterations, [&]() {
+			net::frame_queue::make_frame(packet, frame);
+			queue.write(frame);
+			ASSERT_TRUE(queue.packet_ready());
+			EXPECT_EQ(queue.read_packet().size(), size);
+		});
+	}
+}
+
+int main(int argc, char **argv)
+{
+	return RunBenchmarks(argc, argv, { IntOption("--iterations", Iterations) });
+}
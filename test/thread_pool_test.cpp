@@ -0,0 +1,31 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <vector>
+
+#include "utils/thread_pool.h"
+
+using namespace devilution;
+
+TEST(ThreadPool, ParallelForRunsEveryJobOnce)
+{
+	ThreadPool pool(3);
+	EXPECT_EQ(pool.Concurrency(), 4U);
+
+	std::vector<std::atomic<int>> calls(100);
+	for (int batch = 0; batch < 50; batch++) {
+		pool.ParallelFor(static_cast<unsigned>(calls.size()), [&](unsigned i) { calls[i]++; });
+	}
+	for (auto &count : calls)
+		EXPECT_EQ(count, 50);
+}
+
+TEST(ThreadPool, ParallelForWithoutWorkers)
+{
+	ThreadPool pool(0);
+	EXPECT_EQ(pool.Concurrency(), 1U);
+
+	std::vector<unsigned> order;
+	pool.ParallelFor(5, [&](unsigned i) { order.push_back(i); });
+	EXPECT_EQ(order, (std::vector<unsigned> { 0, 1, 2, 3, 4 }));
+}